@@ -14,35 +14,43 @@ else ()
 endif ()
 
 
-# The following function implements support for compiling multiple
-# Metal shaders into a single library file. It achieves this using the following steps:
+# The following function compiles multiple Metal shaders into a single library file
+# through the shaderbuild tool (tools/shaderbuild), which:
 #
-# 1) First, compile all shaders specified in the input list into air object files
-# 2) Second, take all air file and bundle them using metal-ar into a single package
-# 3) Finally, generate a single uber library containing all compiled shaders
+# 1) Scans every shader for its includes and hashes the source, defines and includes
+# 2) Compiles only the translation units whose hash is not in the object cache yet
+# 3) Relinks the single default library only when one of its objects changed
+#
+# Defines and permutations per shader are read from shaders/shaders.json if present.
 function(CompileMetalShaders SHADER_FILES)
-    add_custom_target(CompileMetalShaders
-            DEPENDS "${PROJECT_BINARY_DIR}/generated/default.metallib"
-    )
+    set(GENERATED_DIR "${PROJECT_BINARY_DIR}/generated")
+    set(SHADER_LIBRARY "${GENERATED_DIR}/default.metallib")
+    set(SHADER_MANIFEST "${PROJECT_SOURCE_DIR}/shaders/shaders.json")
 
-    set(COMPILED_METAL_AIR_FILES "")
-    foreach (file ${SHADER_FILES})
-        get_filename_component(name ${file} NAME_WLE)
-        get_filename_component(directory ${file} DIRECTORY)
-        get_filename_component(dirname ${directory} NAME_WLE)
-        list(APPEND COMPILED_METAL_AIR_FILES ${PROJECT_BINARY_DIR}/generated/${dirname}/${name}.air)
-        add_custom_command(
-                OUTPUT "${PROJECT_BINARY_DIR}/generated/${dirname}/${name}.air"
-                COMMAND ${XCODE_RUN} -sdk ${XCODE_RUN_SDK} metal -c ${file} ${XCODE_METAL_EXTRA_ARGS} -o ${PROJECT_BINARY_DIR}/generated/${dirname}/${name}.air
-                COMMENT "Compiling ${name} to METAL-AIR"
-                DEPENDS ${file} ${directory})
-    endforeach ()
+    set(MANIFEST_ARGS "")
+    if (EXISTS ${SHADER_MANIFEST})
+        set(MANIFEST_ARGS --manifest ${SHADER_MANIFEST})
+    endif ()
 
     add_custom_command(
-            OUTPUT "${PROJECT_BINARY_DIR}/generated/default.metallib"
-            COMMENT "Compiling ${COMPILED_METAL_AIR_FILES}"
-            COMMAND ${XCODE_RUN} -sdk ${XCODE_RUN_SDK} metal-ar r ${PROJECT_BINARY_DIR}/generated/default.metal-ar ${COMPILED_METAL_AIR_FILES}
-            COMMAND ${XCODE_RUN} -sdk ${XCODE_RUN_SDK} metallib -o ${PROJECT_BINARY_DIR}/generated/default.metallib ${PROJECT_BINARY_DIR}/generated/default.metal-ar
-            DEPENDS ${COMPILED_METAL_AIR_FILES}
+            OUTPUT ${SHADER_LIBRARY}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${GENERATED_DIR}
+            COMMAND shaderbuild
+                --output ${SHADER_LIBRARY}
+                --cache-dir ${GENERATED_DIR}/cache
+                --depfile ${GENERATED_DIR}/default.metallib.d
+                --include-dir ${PROJECT_SOURCE_DIR}/shaders
+                --compile "${XCODE_RUN} -sdk ${XCODE_RUN_SDK} metal -c {input} {defines} ${XCODE_METAL_EXTRA_ARGS} -o {output}"
+                --link "${XCODE_RUN} -sdk ${XCODE_RUN_SDK} metallib {inputs} -o {output}"
+                ${MANIFEST_ARGS}
+                ${SHADER_FILES}
+            COMMENT "Building Metal shader library"
+            DEPFILE ${GENERATED_DIR}/default.metallib.d
+            DEPENDS shaderbuild ${SHADER_FILES}
+            VERBATIM
+    )
+
+    add_custom_target(CompileMetalShaders
+            DEPENDS ${SHADER_LIBRARY}
     )
-endfunction()
\ No newline at end of file
+endfunction()
@@ -0,0 +1,118 @@
+# Shader manifest support
+#
+# shaders/shaders.json lists the fixed defines, permutations and host struct bindings
+# of the shaders. The following function generates from it, with the shaderbuild tool:
+#
+# 1) ShaderPermutations.hpp, sharing the shaders' constants with the host and
+#    selecting variants through constexpr permutation keys
+# 2) ShaderLayouts.hpp, static_asserts checking that host structs match the layout
+#    of the shader structs they mirror
+# 3) ShaderLayouts.json, the layouts of all shader structs
+#
+# Targets link shader_headers to include the headers.
+function(GenerateShaderHeaders MANIFEST)
+    set(GENERATED_DIR "${PROJECT_BINARY_DIR}/generated")
+    set(GENERATED_INCLUDE_DIR "${GENERATED_DIR}/include")
+    set(PERMUTATION_HEADER "${GENERATED_INCLUDE_DIR}/ShaderPermutations.hpp")
+    set(LAYOUT_HEADER "${GENERATED_INCLUDE_DIR}/ShaderLayouts.hpp")
+    set(LAYOUT_MANIFEST "${GENERATED_DIR}/ShaderLayouts.json")
+
+    # Layouts depend on structs in included files too
+    get_filename_component(SHADER_DIR ${MANIFEST} DIRECTORY)
+    file(GLOB_RECURSE SHADER_SOURCES ${SHADER_DIR}/*.metal ${SHADER_DIR}/*.h)
+
+    add_custom_command(
+            OUTPUT ${PERMUTATION_HEADER} ${LAYOUT_HEADER} ${LAYOUT_MANIFEST}
+            COMMAND shaderbuild
+                --manifest ${MANIFEST}
+                --include-dir ${SHADER_DIR}
+                --header ${PERMUTATION_HEADER}
+                --layout-header ${LAYOUT_HEADER}
+                --layout-manifest ${LAYOUT_MANIFEST}
+            COMMENT "Generating shader headers"
+            DEPENDS shaderbuild ${MANIFEST} ${SHADER_SOURCES}
+            VERBATIM
+    )
+    add_custom_target(GenerateShaderHeaders
+            DEPENDS ${PERMUTATION_HEADER} ${LAYOUT_HEADER} ${LAYOUT_MANIFEST}
+    )
+
+    add_library(shader_headers INTERFACE)
+    target_include_directories(shader_headers INTERFACE ${GENERATED_INCLUDE_DIR})
+    add_dependencies(shader_headers GenerateShaderHeaders)
+endfunction()
+
+# The Xcode generator compiles each shader as a target source instead of through
+# shaderbuild. The following function reads the compile options for such a shader
+# from the manifest: its fixed defines and, since Xcode builds a single variant, the
+# first value of every permutation. The manifest lists first the values the examples
+# start with; switching to another variant at runtime needs a shaderbuild build.
+function(ShaderManifestDefines MANIFEST SOURCE OUT_VAR)
+    set(OPTIONS "")
+    file(READ ${MANIFEST} MANIFEST_JSON)
+    string(JSON SHADER_COUNT LENGTH "${MANIFEST_JSON}" shaders)
+
+    foreach (INDEX RANGE ${SHADER_COUNT})
+        if (INDEX EQUAL SHADER_COUNT)
+            break()
+        endif ()
+        string(JSON ENTRY_SOURCE GET "${MANIFEST_JSON}" shaders ${INDEX} source)
+        if (NOT ENTRY_SOURCE STREQUAL SOURCE)
+            continue()
+        endif ()
+
+        string(JSON DEFINES ERROR_VARIABLE NO_DEFINES GET "${MANIFEST_JSON}" shaders ${INDEX} defines)
+        if (NOT NO_DEFINES)
+            string(JSON DEFINE_COUNT LENGTH "${DEFINES}")
+            foreach (DEFINE_INDEX RANGE ${DEFINE_COUNT})
+                if (DEFINE_INDEX EQUAL DEFINE_COUNT)
+                    break()
+                endif ()
+                string(JSON NAME MEMBER "${DEFINES}" ${DEFINE_INDEX})
+                string(JSON VALUE GET "${DEFINES}" ${NAME})
+                string(JSON TYPE TYPE "${DEFINES}" ${NAME})
+                if (TYPE STREQUAL "BOOLEAN")
+                    if (VALUE)
+                        set(VALUE 1)
+                    else ()
+                        set(VALUE 0)
+                    endif ()
+                endif ()
+                list(APPEND OPTIONS "-D${NAME}=${VALUE}")
+            endforeach ()
+        endif ()
+
+        set(SUFFIX "")
+        string(JSON AXES ERROR_VARIABLE NO_AXES GET "${MANIFEST_JSON}" shaders ${INDEX} permutations)
+        if (NOT NO_AXES)
+            # Ordered by name like shaderbuild, so the suffix names the same variant
+            set(AXIS_NAMES "")
+            string(JSON AXIS_COUNT LENGTH "${AXES}")
+            foreach (AXIS_INDEX RANGE ${AXIS_COUNT})
+                if (AXIS_INDEX EQUAL AXIS_COUNT)
+                    break()
+                endif ()
+                string(JSON NAME MEMBER "${AXES}" ${AXIS_INDEX})
+                list(APPEND AXIS_NAMES ${NAME})
+            endforeach ()
+            list(SORT AXIS_NAMES)
+
+            foreach (NAME IN LISTS AXIS_NAMES)
+                string(JSON VALUE GET "${AXES}" ${NAME} 0)
+                string(JSON TYPE TYPE "${AXES}" ${NAME} 0)
+                if (TYPE STREQUAL "BOOLEAN")
+                    if (VALUE)
+                        set(VALUE 1)
+                    else ()
+                        set(VALUE 0)
+                    endif ()
+                endif ()
+                list(APPEND OPTIONS "-D${NAME}=${VALUE}")
+                string(APPEND SUFFIX "_${NAME}_${VALUE}")
+            endforeach ()
+            list(APPEND OPTIONS "-DPERMUTATION_SUFFIX=${SUFFIX}")
+        endif ()
+    endforeach ()
+
+    set(${OUT_VAR} ${OPTIONS} PARENT_SCOPE)
+endfunction()
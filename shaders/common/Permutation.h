@@ -0,0 +1,20 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+// Naming of the functions of permuted shaders. shaderbuild compiles a shader once
+// per combination of the permutation values in shaders/shaders.json and defines
+// PERMUTATION_SUFFIX for each, e.g. _ALPHA_BLEND_1_MSAA_4. All variants are linked
+// into one library, so their functions are declared as PERMUTED(name), and the host
+// looks them up with ShaderPermutations::<Entry>::functionName(name, key).
+
+#pragma once
+
+#ifndef PERMUTATION_SUFFIX
+#define PERMUTATION_SUFFIX
+#endif
+
+#define PERMUTED_CONCAT_(name, suffix) name##suffix
+#define PERMUTED_CONCAT(name, suffix) PERMUTED_CONCAT_(name, suffix)
+#define PERMUTED(name) PERMUTED_CONCAT(name, PERMUTATION_SUFFIX)
@@ -0,0 +1,37 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+// Decoding of the quantized vertex formats written by the mesh cooker
+// (source/base/VertexQuantization.hpp). Vertex fetch already expands the normalized
+// integer and half formats to float; these helpers undo the remaining encoding.
+
+#pragma once
+
+#include <metal_stdlib>
+
+// Position stored as UShort4Normalized fractions of the primitive bounds
+inline float3 decodePosition(float3 encoded, float3 boundsMin, float3 boundsMax)
+{
+    return boundsMin + encoded * (boundsMax - boundsMin);
+}
+
+// Unit vector stored as octahedral coordinates (Short2Normalized or the xy of
+// Char4Normalized)
+inline float3 decodeOctahedral(float2 encoded)
+{
+    float3 v = float3(encoded, 1.0 - metal::abs(encoded.x) - metal::abs(encoded.y));
+    if (v.z < 0.0)
+    {
+        float2 signs = metal::select(float2(-1.0), float2(1.0), v.xy >= 0.0);
+        v.xy = (1.0 - metal::abs(v.yx)) * signs;
+    }
+    return metal::normalize(v);
+}
+
+// Tangent stored as Char4Normalized: octahedral direction in xy, bitangent sign in w
+inline float4 decodeTangent(float4 encoded)
+{
+    return float4(decodeOctahedral(encoded.xy), encoded.w < 0.0 ? -1.0 : 1.0);
+}
@@ -1,7 +1,14 @@
 #include <metal_stdlib>
 
+#include "../common/Permutation.h"
+
 using namespace metal;
 
+// Permutations, see shaders/shaders.json:
+// INSTANCE_ENCODING  0 when each instance's transform is its full model view
+//                    projection, 1 when it is the model matrix alone and the view
+//                    projection shared by all instances is bound separately
+
 struct Vertex {
     float4 position [[position]];
     float4 color;
@@ -11,21 +18,32 @@ struct InstanceData {
     float4x4 transform;
 };
 
-vertex Vertex instancing_vertex(
+struct ViewUniforms {
+    float4x4 viewProjection;
+};
+
+vertex Vertex PERMUTED(instancing_vertex)(
     device const Vertex* vertices [[buffer(0)]],
     device const InstanceData* instanceData [[buffer(1)]],
+#if INSTANCE_ENCODING == 1
+    constant ViewUniforms& view [[buffer(2)]],
+#endif
     uint vid [[vertex_id]],
     uint iid [[instance_id]])
 {
     Vertex vertexOut;
+#if INSTANCE_ENCODING == 1
+    vertexOut.position = view.viewProjection * (instanceData[iid].transform * vertices[vid].position);
+#else
     vertexOut.position = instanceData[iid].transform * vertices[vid].position;
+#endif
     vertexOut.color = vertices[vid].color;
     vertexOut.color *= 1;
 
     return vertexOut;
 }
 
-fragment half4 instancing_fragment(Vertex vertexIn [[stage_in]])
+fragment half4 PERMUTED(instancing_fragment)(Vertex vertexIn [[stage_in]])
 {
     return half4(vertexIn.color);
 }
@@ -1,7 +1,14 @@
 #include <metal_stdlib>
 
+#include "../common/Permutation.h"
+
 using namespace metal;
 
+// Permutations, see shaders/shaders.json:
+// ALPHA_BLEND  1 to output the texture's alpha for blending, 0 to draw opaque
+// MSAA         Sample count of the render target; opaque variants with more than
+//              one sample turn alpha into coverage, the others alpha test
+
 struct VertexIn {
     float4 position;
     float2 uv;
@@ -15,11 +22,11 @@ struct VertexOut {
 
 typedef struct
 {
-    array<texture2d<half>, 5> textures;
+    array<texture2d<half>, TEXTURE_COUNT> textures;
     device float4x4* transforms;
 } ArgumentBuffer;
 
-vertex VertexOut texture_vertex(
+vertex VertexOut PERMUTED(texture_vertex)(
     device const VertexIn* vertices [[buffer(0)]],
     const device ArgumentBuffer& argBuffer[[buffer(1)]],
     uint vid [[vertex_id]],
@@ -37,14 +44,50 @@ vertex VertexOut texture_vertex(
     return vertexOut;
 }
 
-fragment half4 texture_fragment(VertexOut vertexIn [[stage_in]], const device ArgumentBuffer& argBuffer[[buffer(2)]])
+static half4 sampleColor(VertexOut vertexIn, const device ArgumentBuffer& argBuffer)
 {
     constexpr sampler colorSampler(mip_filter::linear,
                                        mag_filter::linear,
                                        min_filter::linear);
 
-    half4 colorSample   = argBuffer.textures[vertexIn.textureIndex].sample(colorSampler, vertexIn.uv.xy);
+    return argBuffer.textures[vertexIn.textureIndex].sample(colorSampler, vertexIn.uv.xy);
+}
+
+#if ALPHA_BLEND
+
+fragment half4 PERMUTED(texture_fragment)(VertexOut vertexIn [[stage_in]], const device ArgumentBuffer& argBuffer[[buffer(2)]])
+{
+    return sampleColor(vertexIn, argBuffer);
+}
+
+#elif MSAA > 1
 
-    return half4(colorSample);
+struct CoverageOut {
+    half4 color [[color(0)]];
+    uint coverage [[sample_mask]];
+};
+
+fragment CoverageOut PERMUTED(texture_fragment)(VertexOut vertexIn [[stage_in]], const device ArgumentBuffer& argBuffer[[buffer(2)]])
+{
+    const half4 colorSample = sampleColor(vertexIn, argBuffer);
+    const uint  samples = uint(rint(saturate(float(colorSample.a)) * MSAA));
+
+    CoverageOut out;
+    out.color = half4(colorSample.rgb, 1.0h);
+    out.coverage = (1u << samples) - 1u;
+    return out;
+}
+
+#else
+
+fragment half4 PERMUTED(texture_fragment)(VertexOut vertexIn [[stage_in]], const device ArgumentBuffer& argBuffer[[buffer(2)]])
+{
+    const half4 colorSample = sampleColor(vertexIn, argBuffer);
+    if (colorSample.a < 0.5h)
+    {
+        discard_fragment();
+    }
+    return half4(colorSample.rgb, 1.0h);
 }
 
+#endif
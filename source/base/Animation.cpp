@@ -0,0 +1,886 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Animation.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+#include "FrameArena.hpp"
+
+namespace Animation
+{
+    namespace
+    {
+        using Quaternion = std::array<float, 4>;
+
+        /// Keys are addressed by frame number in 16 bits.
+        constexpr uint32_t g_maxFrames = 0xFFFF;
+
+        /// Longest run of frames a single pair of keys may span; bounds the cost of
+        /// fitting long linear stretches.
+        constexpr uint32_t g_maxKeySpan = 128;
+
+        constexpr float g_rangeCodeMax = 65535.0F;
+        constexpr float g_rotationCodeMax = 32767.0F;
+        /// The three smallest components of a unit quaternion lie within +-1/sqrt(2).
+        constexpr float g_rotationRange = 0.70710678F;
+
+        /// Pose components are padded to a multiple of this many joints.
+        constexpr size_t g_poseLanes = 8;
+
+        float dot(const Quaternion& a, const Quaternion& b)
+        {
+            return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        }
+
+        Quaternion normalize(Quaternion q)
+        {
+            const float length = std::sqrt(dot(q, q));
+            if (length == 0.0F)
+            {
+                return { 0.0F, 0.0F, 0.0F, 1.0F };
+            }
+            for (float& value : q)
+            {
+                value /= length;
+            }
+            return q;
+        }
+
+        /// Normalized linear interpolation along the shorter arc.
+        Quaternion nlerp(const Quaternion& a, const Quaternion& b, const float alpha)
+        {
+            const float sign = dot(a, b) < 0.0F ? -1.0F : 1.0F;
+            Quaternion  result;
+            for (size_t i = 0; i < 4; i++)
+            {
+                result[i] = a[i] + (b[i] * sign - a[i]) * alpha;
+            }
+            return normalize(result);
+        }
+
+        Quaternion slerp(const Quaternion& a, const Quaternion& b, const float alpha)
+        {
+            float       cosine = dot(a, b);
+            const float sign = cosine < 0.0F ? -1.0F : 1.0F;
+            cosine *= sign;
+            if (cosine > 0.9995F)
+            {
+                return nlerp(a, b, alpha);
+            }
+            const float angle = std::acos(cosine);
+            const float weightA = std::sin((1.0F - alpha) * angle) / std::sin(angle);
+            const float weightB = std::sin(alpha * angle) / std::sin(angle) * sign;
+            Quaternion  result;
+            for (size_t i = 0; i < 4; i++)
+            {
+                result[i] = a[i] * weightA + b[i] * weightB;
+            }
+            return normalize(result);
+        }
+
+        /// Angle between two rotations.
+        float angleBetween(const Quaternion& a, const Quaternion& b)
+        {
+            return 2.0F * std::acos(std::min(std::abs(dot(a, b)), 1.0F));
+        }
+
+        /// Evaluates a channel of the source file at a time, with its interpolation.
+        Quaternion evaluateChannel(const Assets::AnimationChannel& channel, const float time)
+        {
+            const size_t components = channel.path == Assets::AnimationPath::Rotation ? 4 : 3;
+            const bool   cubic
+                = channel.interpolation == Assets::AnimationInterpolation::CubicSpline;
+            const size_t stride = components * (cubic ? 3 : 1);
+            const auto   value = [&](const size_t key, const size_t part) {
+                Quaternion result {};
+                std::copy_n(channel.values.data() + key * stride + part * components, components,
+                    result.begin());
+                return result;
+            };
+            // Cubic splines keep the value between the in and out tangents
+            const size_t valuePart = cubic ? 1 : 0;
+
+            const auto& times = channel.times;
+            const auto  next = std::ranges::upper_bound(times, time);
+            if (next == times.begin())
+            {
+                return value(0, valuePart);
+            }
+            if (next == times.end())
+            {
+                return value(times.size() - 1, valuePart);
+            }
+            const size_t key = static_cast<size_t>(next - times.begin()) - 1;
+            const float  delta = times[key + 1] - times[key];
+            const float  alpha = delta > 0.0F ? (time - times[key]) / delta : 0.0F;
+
+            Quaternion result {};
+            switch (channel.interpolation)
+            {
+            case Assets::AnimationInterpolation::Step:
+                return value(key, 0);
+            case Assets::AnimationInterpolation::Linear:
+            {
+                const auto from = value(key, 0);
+                const auto to = value(key + 1, 0);
+                if (components == 4)
+                {
+                    return slerp(from, to, alpha);
+                }
+                for (size_t i = 0; i < components; i++)
+                {
+                    result[i] = from[i] + (to[i] - from[i]) * alpha;
+                }
+                return result;
+            }
+            case Assets::AnimationInterpolation::CubicSpline:
+            {
+                // Hermite basis with tangents scaled by the key interval
+                const float t2 = alpha * alpha;
+                const float t3 = t2 * alpha;
+                const auto  from = value(key, 1);
+                const auto  outTangent = value(key, 2);
+                const auto  to = value(key + 1, 1);
+                const auto  inTangent = value(key + 1, 0);
+                for (size_t i = 0; i < components; i++)
+                {
+                    result[i] = (2.0F * t3 - 3.0F * t2 + 1.0F) * from[i]
+                        + (t3 - 2.0F * t2 + alpha) * delta * outTangent[i]
+                        + (-2.0F * t3 + 3.0F * t2) * to[i] + (t3 - t2) * delta * inTangent[i];
+                }
+                return components == 4 ? normalize(result) : result;
+            }
+            }
+            return result;
+        }
+
+        /// Smallest three encoding: the largest component is dropped and rebuilt from
+        /// the others, its index goes into the top bits of the first two codes.
+        std::array<uint16_t, 3> encodeRotation(Quaternion q)
+        {
+            q = normalize(q);
+            size_t largest = 0;
+            for (size_t i = 1; i < 4; i++)
+            {
+                if (std::abs(q[i]) > std::abs(q[largest]))
+                {
+                    largest = i;
+                }
+            }
+            if (q[largest] < 0.0F)
+            {
+                for (float& value : q)
+                {
+                    value = -value;
+                }
+            }
+
+            std::array<uint16_t, 3> codes {};
+            size_t                  code = 0;
+            for (size_t i = 0; i < 4; i++)
+            {
+                if (i == largest)
+                {
+                    continue;
+                }
+                const float normalized
+                    = std::clamp((q[i] / g_rotationRange + 1.0F) * 0.5F, 0.0F, 1.0F);
+                codes[code++]
+                    = static_cast<uint16_t>(std::lround(normalized * g_rotationCodeMax));
+            }
+            codes[0] = static_cast<uint16_t>(codes[0] | ((largest & 1) << 15));
+            codes[1] = static_cast<uint16_t>(codes[1] | ((largest >> 1) << 15));
+            return codes;
+        }
+
+        /// Written without branches so the batched sampler's loop vectorizes.
+        inline Quaternion decodeRotation(
+            const uint16_t code0, const uint16_t code1, const uint16_t code2)
+        {
+            constexpr float scale = 2.0F * g_rotationRange / g_rotationCodeMax;
+            const uint32_t  largest = (code0 >> 15) | ((code1 >> 15) << 1);
+            const float     a = static_cast<float>(code0 & 0x7FFF) * scale - g_rotationRange;
+            const float     b = static_cast<float>(code1 & 0x7FFF) * scale - g_rotationRange;
+            const float     c = static_cast<float>(code2) * scale - g_rotationRange;
+            const float     d = std::sqrt(std::max(1.0F - a * a - b * b - c * c, 0.0F));
+            return { largest == 0 ? d : a, largest == 0 ? a : (largest == 1 ? d : b),
+                largest <= 1 ? b : (largest == 2 ? d : c), largest == 3 ? d : c };
+        }
+
+        /// Dense samples of one track, before reduction.
+        using Samples = std::vector<Quaternion>;
+
+        /// Greedily extends each key pair while linear interpolation of the decoded
+        /// samples stays within tolerance of the source, returning the kept frames.
+        template <typename TDecode, typename TError>
+        std::vector<uint32_t> reduceKeys(const Samples& source, const TDecode& decode,
+            const TError& error, const float tolerance)
+        {
+            const auto frameCount = static_cast<uint32_t>(source.size());
+            const auto fits = [&](const uint32_t first, const uint32_t last) {
+                const Quaternion from = decode(first);
+                const Quaternion to = decode(last);
+                for (uint32_t frame = first + 1; frame < last; frame++)
+                {
+                    const float alpha
+                        = static_cast<float>(frame - first) / static_cast<float>(last - first);
+                    if (error(from, to, alpha, source[frame]) > tolerance)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            // A track within tolerance of its first sample throughout is constant
+            bool constant = true;
+            for (uint32_t frame = 1; frame < frameCount && constant; frame++)
+            {
+                constant = error(decode(0), decode(0), 0.0F, source[frame]) <= tolerance;
+            }
+            if (constant)
+            {
+                return { 0 };
+            }
+
+            std::vector<uint32_t> keys { 0 };
+            uint32_t              first = 0;
+            while (first + 1 < frameCount)
+            {
+                uint32_t last = first + 1;
+                while (last + 1 < frameCount && last + 1 - first <= g_maxKeySpan
+                    && fits(first, last + 1))
+                {
+                    last++;
+                }
+                keys.push_back(last);
+                first = last;
+            }
+            return keys;
+        }
+
+        Assets::Matrix4 composeMatrix(const Transform& transform)
+        {
+            const auto& [x, y, z, w] = transform.rotation;
+            const auto& s = transform.scale;
+            const auto& t = transform.translation;
+            // Rows are the rotated, scaled basis vectors (row vector convention)
+            return { s[0] * (1.0F - 2.0F * (y * y + z * z)), s[0] * 2.0F * (x * y + z * w),
+                s[0] * 2.0F * (x * z - y * w), 0.0F, s[1] * 2.0F * (x * y - z * w),
+                s[1] * (1.0F - 2.0F * (x * x + z * z)), s[1] * 2.0F * (y * z + x * w), 0.0F,
+                s[2] * 2.0F * (x * z + y * w), s[2] * 2.0F * (y * z - x * w),
+                s[2] * (1.0F - 2.0F * (x * x + y * y)), 0.0F, t[0], t[1], t[2], 1.0F };
+        }
+
+        void multiply(const Assets::Matrix4& a, const Assets::Matrix4& b, Assets::Matrix4& result)
+        {
+            for (size_t row = 0; row < 4; row++)
+            {
+                std::array<float, 4> sum {};
+                for (size_t k = 0; k < 4; k++)
+                {
+                    for (size_t column = 0; column < 4; column++)
+                    {
+                        sum[column] += a[row * 4 + k] * b[k * 4 + column];
+                    }
+                }
+                std::copy(sum.begin(), sum.end(), result.begin() + row * 4);
+            }
+        }
+
+        Transform nodeTransform(const Assets::Node& node)
+        {
+            const bool identityTrs = node.translation == std::array<float, 3> {}
+                && node.rotation == Quaternion { 0.0F, 0.0F, 0.0F, 1.0F }
+                && node.scale == std::array<float, 3> { 1.0F, 1.0F, 1.0F };
+            if (identityTrs)
+            {
+                // Nodes given as a matrix only carry it in the local transform
+                return decompose(node.localTransform);
+            }
+            return { node.translation, node.rotation, node.scale };
+        }
+    } // namespace
+
+    Transform decompose(const Assets::Matrix4& matrix)
+    {
+        Transform transform;
+        transform.translation = { matrix[12], matrix[13], matrix[14] };
+        std::array<std::array<float, 3>, 3> basis {};
+        for (size_t row = 0; row < 3; row++)
+        {
+            const float* values = &matrix[row * 4];
+            transform.scale[row] = std::sqrt(
+                values[0] * values[0] + values[1] * values[1] + values[2] * values[2]);
+            for (size_t column = 0; column < 3; column++)
+            {
+                basis[row][column] = transform.scale[row] > 0.0F
+                    ? values[column] / transform.scale[row]
+                    : (row == column ? 1.0F : 0.0F);
+            }
+        }
+
+        // Shepperd's method on the transposed (column vector) rotation
+        const float trace = basis[0][0] + basis[1][1] + basis[2][2];
+        Quaternion  q {};
+        if (trace > 0.0F)
+        {
+            const float s = std::sqrt(trace + 1.0F) * 2.0F;
+            q = { (basis[1][2] - basis[2][1]) / s, (basis[2][0] - basis[0][2]) / s,
+                (basis[0][1] - basis[1][0]) / s, 0.25F * s };
+        }
+        else if (basis[0][0] > basis[1][1] && basis[0][0] > basis[2][2])
+        {
+            const float s = std::sqrt(1.0F + basis[0][0] - basis[1][1] - basis[2][2]) * 2.0F;
+            q = { 0.25F * s, (basis[1][0] + basis[0][1]) / s, (basis[2][0] + basis[0][2]) / s,
+                (basis[1][2] - basis[2][1]) / s };
+        }
+        else if (basis[1][1] > basis[2][2])
+        {
+            const float s = std::sqrt(1.0F + basis[1][1] - basis[0][0] - basis[2][2]) * 2.0F;
+            q = { (basis[1][0] + basis[0][1]) / s, 0.25F * s, (basis[2][1] + basis[1][2]) / s,
+                (basis[2][0] - basis[0][2]) / s };
+        }
+        else
+        {
+            const float s = std::sqrt(1.0F + basis[2][2] - basis[0][0] - basis[1][1]) * 2.0F;
+            q = { (basis[2][0] + basis[0][2]) / s, (basis[2][1] + basis[1][2]) / s, 0.25F * s,
+                (basis[0][1] - basis[1][0]) / s };
+        }
+        transform.rotation = normalize(q);
+        return transform;
+    }
+
+    Skeleton buildSkeleton(const Assets::Scene& scene, const size_t skin)
+    {
+        if (skin >= scene.skins.size())
+        {
+            throw std::runtime_error(
+                std::format("Skin {} does not exist, the scene has {}", skin, scene.skins.size()));
+        }
+        const Assets::Skin& source = scene.skins[skin];
+
+        // Every joint and its ancestors, so animated intermediate nodes are kept
+        std::vector<uint8_t> included(scene.nodes.size(), 0);
+        for (const int32_t joint : source.joints)
+        {
+            for (int32_t node = joint; node >= 0 && included[node] == 0;
+                node = scene.nodes[node].parent)
+            {
+                included[node] = 1;
+            }
+        }
+
+        std::vector<uint32_t> depths(scene.nodes.size(), 0);
+        std::vector<int32_t>  order;
+        for (size_t node = 0; node < scene.nodes.size(); node++)
+        {
+            if (included[node] == 0)
+            {
+                continue;
+            }
+            for (int32_t parent = scene.nodes[node].parent; parent >= 0;
+                parent = scene.nodes[parent].parent)
+            {
+                depths[node]++;
+            }
+            order.push_back(static_cast<int32_t>(node));
+        }
+        std::ranges::stable_sort(
+            order, {}, [&depths](const int32_t node) { return depths[node]; });
+
+        std::vector<int32_t> jointOfNode(scene.nodes.size(), -1);
+        Skeleton             skeleton;
+        for (const int32_t node : order)
+        {
+            const int32_t parent = scene.nodes[node].parent;
+            jointOfNode[node] = static_cast<int32_t>(skeleton.parents.size());
+            skeleton.parents.push_back(parent >= 0 ? jointOfNode[parent] : -1);
+            skeleton.bindPose.push_back(nodeTransform(scene.nodes[node]));
+            skeleton.nodes.push_back(node);
+        }
+        for (const int32_t joint : source.joints)
+        {
+            skeleton.skinJoints.push_back(static_cast<uint32_t>(jointOfNode[joint]));
+        }
+        skeleton.inverseBindMatrices = source.inverseBindMatrices;
+        return skeleton;
+    }
+
+    Pose::Pose(const size_t jointCount)
+    {
+        resize(jointCount);
+    }
+
+    void Pose::resize(const size_t jointCount)
+    {
+        m_jointCount = jointCount;
+        m_stride = (jointCount + g_poseLanes - 1) / g_poseLanes * g_poseLanes;
+        m_components.assign(m_stride * g_poseComponentCount, 0.0F);
+    }
+
+    size_t Pose::jointCount() const
+    {
+        return m_jointCount;
+    }
+
+    std::span<float> Pose::component(const PoseComponent component)
+    {
+        return { m_components.data() + static_cast<size_t>(component) * m_stride, m_jointCount };
+    }
+
+    std::span<const float> Pose::component(const PoseComponent component) const
+    {
+        return { m_components.data() + static_cast<size_t>(component) * m_stride, m_jointCount };
+    }
+
+    Transform Pose::joint(const size_t joint) const
+    {
+        const auto value = [&](const size_t component) {
+            return m_components[component * m_stride + joint];
+        };
+        return { { value(0), value(1), value(2) }, { value(3), value(4), value(5), value(6) },
+            { value(7), value(8), value(9) } };
+    }
+
+    void Pose::setJoint(const size_t joint, const Transform& transform)
+    {
+        std::array<float, g_poseComponentCount> values {};
+        std::copy(transform.translation.begin(), transform.translation.end(), values.begin());
+        std::copy(transform.rotation.begin(), transform.rotation.end(), values.begin() + 3);
+        std::copy(transform.scale.begin(), transform.scale.end(), values.begin() + 7);
+        for (size_t component = 0; component < g_poseComponentCount; component++)
+        {
+            m_components[component * m_stride + joint] = values[component];
+        }
+    }
+
+    Clip Clip::compress(const Assets::Animation& animation, const Skeleton& skeleton,
+        const CompressionOptions& options)
+    {
+        Clip clip;
+        clip.m_duration = std::max(animation.duration, 0.0F);
+        clip.m_sampleRate = options.sampleRate;
+        clip.m_jointCount = skeleton.jointCount();
+        const double frames = std::ceil(double { clip.m_duration } * options.sampleRate) + 1.0;
+        if (frames > g_maxFrames)
+        {
+            throw std::runtime_error(std::format("Animation {} is {:.1f} s long, at most {} "
+                                                 "frames can be compressed",
+                animation.name, clip.m_duration, g_maxFrames));
+        }
+        clip.m_frameCount = static_cast<uint32_t>(frames);
+
+        // Channels by joint and path; channels of nodes outside the skeleton are unused
+        std::vector<std::array<const Assets::AnimationChannel*, TrackKindCount>> channels(
+            clip.m_jointCount);
+        for (const auto& channel : animation.channels)
+        {
+            const auto joint = std::ranges::find(skeleton.nodes, channel.node);
+            if (joint != skeleton.nodes.end())
+            {
+                channels[joint - skeleton.nodes.begin()][static_cast<size_t>(channel.path)]
+                    = &channel;
+            }
+        }
+
+        for (auto& ranges : { &clip.m_rangeMinimum, &clip.m_rangeStep })
+        {
+            for (auto& kind : *ranges)
+            {
+                for (auto& component : kind)
+                {
+                    component.assign(clip.m_jointCount, 0.0F);
+                }
+            }
+        }
+        clip.m_tracks.resize(TrackKindCount * clip.m_jointCount);
+
+        Samples                              samples(clip.m_frameCount);
+        std::vector<std::array<uint16_t, 3>> codes(clip.m_frameCount);
+        for (size_t kind = 0; kind < TrackKindCount; kind++)
+        {
+            for (size_t joint = 0; joint < clip.m_jointCount; joint++)
+            {
+                const Transform&                bind = skeleton.bindPose[joint];
+                const Assets::AnimationChannel* channel = channels[joint][kind];
+                for (uint32_t frame = 0; frame < clip.m_frameCount; frame++)
+                {
+                    if (channel != nullptr)
+                    {
+                        const float time
+                            = std::min(static_cast<float>(frame) / options.sampleRate,
+                                clip.m_duration);
+                        samples[frame] = evaluateChannel(*channel, time);
+                    }
+                    else if (kind == RotationTrack)
+                    {
+                        samples[frame] = bind.rotation;
+                    }
+                    else
+                    {
+                        const auto& value
+                            = kind == TranslationTrack ? bind.translation : bind.scale;
+                        samples[frame] = { value[0], value[1], value[2], 0.0F };
+                    }
+                }
+
+                std::vector<uint32_t> keys;
+                if (kind == RotationTrack)
+                {
+                    for (uint32_t frame = 0; frame < clip.m_frameCount; frame++)
+                    {
+                        codes[frame] = encodeRotation(samples[frame]);
+                    }
+                    keys = reduceKeys(
+                        samples,
+                        [&codes](const uint32_t frame) {
+                            return decodeRotation(codes[frame][0], codes[frame][1],
+                                codes[frame][2]);
+                        },
+                        [](const Quaternion& from, const Quaternion& to, const float alpha,
+                            const Quaternion& expected) {
+                            return angleBetween(nlerp(from, to, alpha), expected);
+                        },
+                        options.rotationTolerance);
+                }
+                else
+                {
+                    const size_t range = kind == TranslationTrack ? 0 : 1;
+                    std::array<float, 3> minimum
+                        = { samples[0][0], samples[0][1], samples[0][2] };
+                    std::array<float, 3> maximum = minimum;
+                    for (const auto& sample : samples)
+                    {
+                        for (size_t axis = 0; axis < 3; axis++)
+                        {
+                            minimum[axis] = std::min(minimum[axis], sample[axis]);
+                            maximum[axis] = std::max(maximum[axis], sample[axis]);
+                        }
+                    }
+                    std::array<float, 3> step {};
+                    for (size_t axis = 0; axis < 3; axis++)
+                    {
+                        step[axis] = (maximum[axis] - minimum[axis]) / g_rangeCodeMax;
+                        clip.m_rangeMinimum[range][axis][joint] = minimum[axis];
+                        clip.m_rangeStep[range][axis][joint] = step[axis];
+                    }
+                    for (uint32_t frame = 0; frame < clip.m_frameCount; frame++)
+                    {
+                        for (size_t axis = 0; axis < 3; axis++)
+                        {
+                            const float code = step[axis] > 0.0F
+                                ? (samples[frame][axis] - minimum[axis]) / step[axis]
+                                : 0.0F;
+                            codes[frame][axis] = static_cast<uint16_t>(
+                                std::lround(std::clamp(code, 0.0F, g_rangeCodeMax)));
+                        }
+                    }
+
+                    const float tolerance = kind == TranslationTrack
+                        ? options.translationTolerance
+                        : options.scaleTolerance;
+                    keys = reduceKeys(
+                        samples,
+                        [&](const uint32_t frame) {
+                            Quaternion value {};
+                            for (size_t axis = 0; axis < 3; axis++)
+                            {
+                                value[axis] = minimum[axis]
+                                    + static_cast<float>(codes[frame][axis]) * step[axis];
+                            }
+                            return value;
+                        },
+                        [](const Quaternion& from, const Quaternion& to, const float alpha,
+                            const Quaternion& expected) {
+                            float distance = 0.0F;
+                            for (size_t axis = 0; axis < 3; axis++)
+                            {
+                                const float value = from[axis] + (to[axis] - from[axis]) * alpha;
+                                distance += (value - expected[axis]) * (value - expected[axis]);
+                            }
+                            return std::sqrt(distance);
+                        },
+                        tolerance);
+                }
+
+                Track& track = clip.m_tracks[kind * clip.m_jointCount + joint];
+                track.firstKey = static_cast<uint32_t>(clip.m_keyFrames.size());
+                track.keyCount = static_cast<uint32_t>(keys.size());
+                for (const uint32_t frame : keys)
+                {
+                    clip.m_keyFrames.push_back(static_cast<uint16_t>(frame));
+                    clip.m_keyValues.push_back(codes[frame]);
+                }
+            }
+        }
+        return clip;
+    }
+
+    float Clip::duration() const
+    {
+        return m_duration;
+    }
+
+    size_t Clip::jointCount() const
+    {
+        return m_jointCount;
+    }
+
+    size_t Clip::keyCount() const
+    {
+        return m_keyFrames.size();
+    }
+
+    size_t Clip::sizeBytes() const
+    {
+        return sizeof(Clip) + m_tracks.size() * sizeof(Track)
+            + m_keyFrames.size() * sizeof(uint16_t)
+            + m_keyValues.size() * sizeof(std::array<uint16_t, 3>)
+            + 2 * 2 * 3 * m_jointCount * sizeof(float);
+    }
+
+    Transform Clip::sampleJoint(const size_t joint, const float time) const
+    {
+        assert(joint < m_jointCount);
+        const float frame = frameAt(time);
+        Transform   transform;
+
+        const KeySpan rotation = findKeys(track(RotationTrack, joint), frame, 0);
+        const auto&   a = m_keyValues[rotation.first];
+        const auto&   b = m_keyValues[rotation.second];
+        transform.rotation
+            = nlerp(decodeRotation(a[0], a[1], a[2]), decodeRotation(b[0], b[1], b[2]),
+                rotation.alpha);
+
+        for (const TrackKind kind : { TranslationTrack, ScaleTrack })
+        {
+            const size_t  range = kind == TranslationTrack ? 0 : 1;
+            const KeySpan keys = findKeys(track(kind, joint), frame, 0);
+            auto& value = kind == TranslationTrack ? transform.translation : transform.scale;
+            for (size_t axis = 0; axis < 3; axis++)
+            {
+                const float minimum = m_rangeMinimum[range][axis][joint];
+                const float step = m_rangeStep[range][axis][joint];
+                const float from
+                    = minimum + static_cast<float>(m_keyValues[keys.first][axis]) * step;
+                const float to
+                    = minimum + static_cast<float>(m_keyValues[keys.second][axis]) * step;
+                value[axis] = from + (to - from) * keys.alpha;
+            }
+        }
+        return transform;
+    }
+
+    const Clip::Track& Clip::track(const TrackKind kind, const size_t joint) const
+    {
+        return m_tracks[kind * m_jointCount + joint];
+    }
+
+    float Clip::frameAt(const float time) const
+    {
+        return std::clamp(time * m_sampleRate, 0.0F, static_cast<float>(m_frameCount - 1));
+    }
+
+    // Inline: the sampler calls this once per track and joint
+    inline Clip::KeySpan Clip::findKeys(
+        const Track& track, const float frame, uint32_t hint) const
+    {
+        if (track.keyCount < 2)
+        {
+            return { track.firstKey, track.firstKey, 0.0F };
+        }
+
+        // Playback stays on the hinted span or moves to the next one; the step is
+        // taken without branching because which of the two it is can't be predicted.
+        // Anything else searches.
+        const uint16_t* frames = m_keyFrames.data() + track.firstKey;
+        const uint32_t  last = track.keyCount - 1;
+        if (hint >= last || static_cast<float>(frames[hint]) > frame)
+        {
+            hint = searchKeys(frames, last, frame);
+        }
+        else
+        {
+            hint += static_cast<uint32_t>(
+                (hint + 1 < last) & (static_cast<float>(frames[hint + 1]) <= frame));
+            if (hint + 1 < last && static_cast<float>(frames[hint + 1]) <= frame)
+            {
+                hint = searchKeys(frames, last, frame);
+            }
+        }
+
+        const auto  from = static_cast<float>(frames[hint]);
+        const auto  to = static_cast<float>(frames[hint + 1]);
+        const float alpha = std::clamp((frame - from) / (to - from), 0.0F, 1.0F);
+        return { track.firstKey + hint, track.firstKey + hint + 1, alpha };
+    }
+
+    uint32_t Clip::searchKeys(const uint16_t* frames, const uint32_t last, const float frame)
+    {
+        const auto* next = std::upper_bound(
+            frames + 1, frames + last, frame, [](const float value, const uint16_t key) {
+                return value < static_cast<float>(key);
+            });
+        return static_cast<uint32_t>(next - frames) - 1;
+    }
+
+    void ClipSampler::sample(const Clip& clip, const float time, Pose& pose)
+    {
+        const size_t jointCount = clip.jointCount();
+        if (m_cursors.size() != clip.m_tracks.size())
+        {
+            m_cursors.assign(clip.m_tracks.size(), 0);
+        }
+        if (pose.jointCount() != jointCount)
+        {
+            pose.resize(jointCount);
+        }
+
+        const float frame = clip.frameAt(time);
+        for (const auto kind : { Clip::TranslationTrack, Clip::RotationTrack, Clip::ScaleTrack })
+        {
+            gather(clip, kind, frame);
+        }
+
+        // Translations and scales: dequantize both keys and blend
+        for (const auto kind : { Clip::TranslationTrack, Clip::ScaleTrack })
+        {
+            const Scratch& scratch = m_scratch[kind];
+            const size_t   range = kind == Clip::TranslationTrack ? 0 : 1;
+            const size_t   firstComponent = kind == Clip::TranslationTrack
+                  ? static_cast<size_t>(PoseComponent::TranslationX)
+                  : static_cast<size_t>(PoseComponent::ScaleX);
+            for (size_t axis = 0; axis < 3; axis++)
+            {
+                float* const    out
+                    = pose.component(static_cast<PoseComponent>(firstComponent + axis)).data();
+                const float*    minimum = clip.m_rangeMinimum[range][axis].data();
+                const float*    step = clip.m_rangeStep[range][axis].data();
+                const uint16_t* first = scratch.first[axis].data();
+                const uint16_t* second = scratch.second[axis].data();
+                const float*    alpha = scratch.alpha.data();
+                for (size_t joint = 0; joint < jointCount; joint++)
+                {
+                    const float from
+                        = minimum[joint] + static_cast<float>(first[joint]) * step[joint];
+                    const float to
+                        = minimum[joint] + static_cast<float>(second[joint]) * step[joint];
+                    out[joint] = from + (to - from) * alpha[joint];
+                }
+            }
+        }
+
+        // Rotations: rebuild both keys, blend along the shorter arc and normalize
+        const Scratch&  scratch = m_scratch[Clip::RotationTrack];
+        const uint16_t* a0 = scratch.first[0].data();
+        const uint16_t* a1 = scratch.first[1].data();
+        const uint16_t* a2 = scratch.first[2].data();
+        const uint16_t* b0 = scratch.second[0].data();
+        const uint16_t* b1 = scratch.second[1].data();
+        const uint16_t* b2 = scratch.second[2].data();
+        const float*    alpha = scratch.alpha.data();
+        float* const    x = pose.component(PoseComponent::RotationX).data();
+        float* const    y = pose.component(PoseComponent::RotationY).data();
+        float* const    z = pose.component(PoseComponent::RotationZ).data();
+        float* const    w = pose.component(PoseComponent::RotationW).data();
+        for (size_t joint = 0; joint < jointCount; joint++)
+        {
+            const Quaternion from = decodeRotation(a0[joint], a1[joint], a2[joint]);
+            const Quaternion to = decodeRotation(b0[joint], b1[joint], b2[joint]);
+            const float      sign = dot(from, to) < 0.0F ? -1.0F : 1.0F;
+            const float      t = alpha[joint];
+            const float      qx = from[0] + (to[0] * sign - from[0]) * t;
+            const float      qy = from[1] + (to[1] * sign - from[1]) * t;
+            const float      qz = from[2] + (to[2] * sign - from[2]) * t;
+            const float      qw = from[3] + (to[3] * sign - from[3]) * t;
+            const float      scale = 1.0F / std::sqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+            x[joint] = qx * scale;
+            y[joint] = qy * scale;
+            z[joint] = qz * scale;
+            w[joint] = qw * scale;
+        }
+    }
+
+    void ClipSampler::gather(const Clip& clip, const Clip::TrackKind kind, const float frame)
+    {
+        const size_t jointCount = clip.jointCount();
+        Scratch&     scratch = m_scratch[kind];
+        for (auto* codes : { &scratch.first, &scratch.second })
+        {
+            for (auto& component : *codes)
+            {
+                component.resize(jointCount);
+            }
+        }
+        scratch.alpha.resize(jointCount);
+
+        // Plain pointers, so the stores below are not assumed to alias the clip
+        const Clip::Track* tracks = clip.m_tracks.data() + kind * jointCount;
+        const auto*        values = clip.m_keyValues.data();
+        uint32_t*          cursors = m_cursors.data() + kind * jointCount;
+        uint16_t*          first[3] = { scratch.first[0].data(), scratch.first[1].data(),
+                     scratch.first[2].data() };
+        uint16_t*          second[3] = { scratch.second[0].data(), scratch.second[1].data(),
+                     scratch.second[2].data() };
+        float*             alpha = scratch.alpha.data();
+        for (size_t joint = 0; joint < jointCount; joint++)
+        {
+            const Clip::KeySpan keys = clip.findKeys(tracks[joint], frame, cursors[joint]);
+            cursors[joint] = keys.first - tracks[joint].firstKey;
+            for (size_t axis = 0; axis < 3; axis++)
+            {
+                first[axis][joint] = values[keys.first][axis];
+                second[axis][joint] = values[keys.second][axis];
+            }
+            alpha[joint] = keys.alpha;
+        }
+    }
+
+    void computeModelTransforms(
+        const Skeleton& skeleton, const Pose& pose, const std::span<Assets::Matrix4> model)
+    {
+        assert(model.size() >= skeleton.jointCount());
+        assert(pose.jointCount() >= skeleton.jointCount());
+        for (size_t joint = 0; joint < skeleton.jointCount(); joint++)
+        {
+            const Assets::Matrix4 local = composeMatrix(pose.joint(joint));
+            const int32_t         parent = skeleton.parents[joint];
+            if (parent < 0)
+            {
+                model[joint] = local;
+            }
+            else
+            {
+                multiply(local, model[parent], model[joint]);
+            }
+        }
+    }
+
+    void computeSkinningMatrices(const Skeleton& skeleton,
+        const std::span<const Assets::Matrix4> model, const std::span<Assets::Matrix4> skinning)
+    {
+        assert(skinning.size() >= skeleton.skinJoints.size());
+        for (size_t i = 0; i < skeleton.skinJoints.size(); i++)
+        {
+            multiply(skeleton.inverseBindMatrices[i], model[skeleton.skinJoints[i]], skinning[i]);
+        }
+    }
+
+    std::span<Assets::Matrix4> computeSkinningMatrices(const Skeleton& skeleton,
+        const std::span<const Assets::Matrix4> model, FrameArena& arena)
+    {
+        const std::span<Assets::Matrix4> skinning(
+            arena.allocateArray<Assets::Matrix4>(skeleton.skinJoints.size()),
+            skeleton.skinJoints.size());
+        computeSkinningMatrices(skeleton, model, skinning);
+        return skinning;
+    }
+} // namespace Animation
@@ -0,0 +1,231 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SceneLoader.hpp"
+
+class FrameArena;
+
+namespace Animation
+{
+    /// @brief Local transform of a joint, applied scale first, then rotation, then
+    /// translation.
+    struct Transform
+    {
+        std::array<float, 3> translation {};
+        std::array<float, 4> rotation { 0.0F, 0.0F, 0.0F, 1.0F }; ///< Quaternion xyzw.
+        std::array<float, 3> scale { 1.0F, 1.0F, 1.0F };
+    };
+
+    /// @brief Splits an affine matrix without shear into a transform.
+    [[nodiscard]] Transform decompose(const Assets::Matrix4& matrix);
+
+    /// @brief Joint hierarchy flattened so every parent comes before its children,
+    /// which lets model transforms be computed in a single pass.
+    struct Skeleton
+    {
+        std::vector<int32_t>   parents;  ///< Lower than the joint's own index; -1 for roots.
+        std::vector<Transform> bindPose; ///< Local transforms at rest.
+        std::vector<int32_t>   nodes;    ///< Scene node of each joint, or -1.
+        /// Skeleton joint of each skin joint, in the order vertices refer to them.
+        std::vector<uint32_t>        skinJoints;
+        std::vector<Assets::Matrix4> inverseBindMatrices; ///< One per skin joint.
+
+        [[nodiscard]] size_t jointCount() const
+        {
+            return parents.size();
+        }
+    };
+
+    /// @brief Builds the skeleton of a skin: its joints and every ancestor node they
+    /// have, ordered by depth.
+    /// @throws std::runtime_error if the skin does not exist.
+    [[nodiscard]] Skeleton buildSkeleton(const Assets::Scene& scene, size_t skin);
+
+    /// @brief Components of the joint transforms in a Pose.
+    enum class PoseComponent : uint32_t
+    {
+        TranslationX,
+        TranslationY,
+        TranslationZ,
+        RotationX,
+        RotationY,
+        RotationZ,
+        RotationW,
+        ScaleX,
+        ScaleY,
+        ScaleZ,
+        Count,
+    };
+
+    inline constexpr size_t g_poseComponentCount = static_cast<size_t>(PoseComponent::Count);
+
+    /// @brief Local joint transforms stored component by component, so that
+    /// consecutive joints fill the lanes of SIMD registers.
+    class Pose
+    {
+    public:
+        explicit Pose(size_t jointCount = 0);
+
+        void resize(size_t jointCount);
+
+        [[nodiscard]] size_t jointCount() const;
+
+        [[nodiscard]] std::span<float> component(PoseComponent component);
+
+        [[nodiscard]] std::span<const float> component(PoseComponent component) const;
+
+        [[nodiscard]] Transform joint(size_t joint) const;
+
+        void setJoint(size_t joint, const Transform& transform);
+
+    private:
+        size_t             m_jointCount = 0;
+        size_t             m_stride = 0; ///< Floats per component, rounded up for SIMD.
+        std::vector<float> m_components;
+    };
+
+    struct CompressionOptions
+    {
+        float sampleRate = 30.0F; ///< Keys per second before reduction.
+        /// Largest distance a translation key may be off by, in skeleton units.
+        float translationTolerance = 1.0e-4F;
+        /// Largest angle off, in radians. Below about 1e-3 the 15 bit quantization
+        /// noise alone exceeds it and nearly every key is kept.
+        float rotationTolerance = 1.0e-3F;
+        float scaleTolerance = 1.0e-4F;
+    };
+
+    /// @brief Animation clip compressed for sampling many joints at once.
+    ///
+    /// Channels are resampled at a fixed rate, then keys that linear interpolation
+    /// between their neighbors reproduces within tolerance are removed. Remaining
+    /// rotations keep their three smallest components in 15 bits each; translations
+    /// and scales keep 16 bits per component within the range of their track. Joints
+    /// the clip does not animate hold their bind pose.
+    class Clip
+    {
+    public:
+        Clip() = default;
+
+        /// @throws std::runtime_error if the clip is longer than the format allows.
+        [[nodiscard]] static Clip compress(const Assets::Animation& animation,
+            const Skeleton& skeleton, const CompressionOptions& options = {});
+
+        [[nodiscard]] float duration() const;
+
+        [[nodiscard]] size_t jointCount() const;
+
+        [[nodiscard]] size_t keyCount() const;
+
+        /// @brief Returns the memory the compressed clip takes.
+        [[nodiscard]] size_t sizeBytes() const;
+
+        /// @brief Samples one joint on its own; the reference the batched sampler is
+        /// checked against.
+        [[nodiscard]] Transform sampleJoint(size_t joint, float time) const;
+
+    private:
+        friend class ClipSampler;
+
+        enum TrackKind : size_t
+        {
+            TranslationTrack,
+            RotationTrack,
+            ScaleTrack,
+            TrackKindCount,
+        };
+
+        struct Track
+        {
+            uint32_t firstKey = 0;
+            uint32_t keyCount = 0;
+        };
+
+        /// Key pair around a frame and the blend between them.
+        struct KeySpan
+        {
+            uint32_t first = 0;
+            uint32_t second = 0;
+            float    alpha = 0.0F;
+        };
+
+        [[nodiscard]] const Track& track(TrackKind kind, size_t joint) const;
+
+        [[nodiscard]] float frameAt(float time) const;
+
+        /// Finds the keys around frame, starting the search at the hint.
+        [[nodiscard]] KeySpan findKeys(const Track& track, float frame, uint32_t hint) const;
+
+        /// Binary search for the key before frame, the rare path of findKeys.
+        [[nodiscard]] static uint32_t searchKeys(
+            const uint16_t* frames, uint32_t last, float frame);
+
+        /// Quantization ranges of the translation and scale tracks, by component and
+        /// joint: values decode to minimum + code * step.
+        using Ranges = std::array<std::array<std::vector<float>, 3>, 2>;
+
+        float                                m_duration = 0.0F;
+        float                                m_sampleRate = 0.0F;
+        uint32_t                             m_frameCount = 0;
+        size_t                               m_jointCount = 0;
+        std::vector<Track>                   m_tracks; ///< By kind, then joint.
+        std::vector<uint16_t>                m_keyFrames;
+        std::vector<std::array<uint16_t, 3>> m_keyValues;
+        Ranges                               m_rangeMinimum;
+        Ranges                               m_rangeStep;
+    };
+
+    /// @brief Samples clips into poses, with scratch memory reused from call to call.
+    ///
+    /// Key lookups are scalar and resume from the previous call's keys, so playback
+    /// moving forward in time rarely searches. Decoding and interpolation then run
+    /// over all joints at once in branch free loops the compiler vectorizes.
+    class ClipSampler
+    {
+    public:
+        /// @param [in] time Seconds, clamped to the clip.
+        void sample(const Clip& clip, float time, Pose& pose);
+
+    private:
+        /// Quantized key pairs and blend factors of one track kind, by joint.
+        struct Scratch
+        {
+            std::array<std::vector<uint16_t>, 3> first;
+            std::array<std::vector<uint16_t>, 3> second;
+            std::vector<float>                   alpha;
+        };
+
+        void gather(const Clip& clip, Clip::TrackKind kind, float frame);
+
+        /// Key of the last span of each track. Only a hint: any value gives the right
+        /// keys, so the sampler can move between clips.
+        std::vector<uint32_t>  m_cursors;
+        std::array<Scratch, 3> m_scratch;
+    };
+
+    /// @brief Composes local transforms into model space transforms.
+    /// @param [out] model One matrix per joint.
+    void computeModelTransforms(
+        const Skeleton& skeleton, const Pose& pose, std::span<Assets::Matrix4> model);
+
+    /// @brief Writes the matrices vertices of the skin are transformed by: the inverse
+    /// bind matrix followed by the joint's model transform.
+    /// @param [out] skinning One matrix per skin joint, e.g. in an upload allocation.
+    void computeSkinningMatrices(const Skeleton& skeleton,
+        std::span<const Assets::Matrix4> model, std::span<Assets::Matrix4> skinning);
+
+    /// @brief Allocates the skinning matrices from a frame arena, so they live until
+    /// the arena is reset.
+    [[nodiscard]] std::span<Assets::Matrix4> computeSkinningMatrices(
+        const Skeleton& skeleton, std::span<const Assets::Matrix4> model, FrameArena& arena);
+} // namespace Animation
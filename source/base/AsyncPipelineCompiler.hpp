@@ -0,0 +1,375 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "PipelineCache.hpp"
+
+enum class PipelineStatus : uint8_t
+{
+    Pending,   ///< Queued, compilation has not started.
+    Compiling, ///< A worker is compiling it.
+    Ready,     ///< Compiled; the pipeline can be used.
+    Failed,    ///< Compilation threw; see PipelineHandle::error.
+    Cancelled, ///< Cancelled before compilation started.
+};
+
+enum class PipelinePriority : uint8_t
+{
+    High, ///< Needed for drawing as soon as possible.
+    Low,  ///< Prewarming; compiled once no high priority work is queued.
+};
+
+template <typename TPipeline>
+class AsyncPipelineCompiler;
+
+/// @brief Shared handle to an asynchronous pipeline compilation.
+///
+/// Handles are cheap to copy. All handles returned for the same description refer to
+/// the same request. Draw code polls get() each frame and skips the draw, or draws
+/// with valueOr(fallback), until the pipeline is ready.
+template <typename TPipeline>
+class PipelineHandle
+{
+public:
+    PipelineHandle() = default;
+
+    /// @brief Whether the handle refers to a request.
+    [[nodiscard]] bool isValid() const
+    {
+        return m_request != nullptr;
+    }
+
+    [[nodiscard]] PipelineStatus status() const
+    {
+        return m_request->status.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] bool isReady() const
+    {
+        return isValid() && status() == PipelineStatus::Ready;
+    }
+
+    /// @brief Returns the pipeline, or nullptr if it is not ready. Never blocks.
+    [[nodiscard]] const TPipeline* get() const
+    {
+        return isReady() ? &m_request->pipeline : nullptr;
+    }
+
+    /// @brief Returns the pipeline if it is ready, fallback otherwise. Never blocks.
+    [[nodiscard]] const TPipeline& valueOr(const TPipeline& fallback) const
+    {
+        return isReady() ? m_request->pipeline : fallback;
+    }
+
+    /// @brief Blocks until the request is ready, failed or cancelled.
+    void wait() const
+    {
+        for (PipelineStatus current = status();
+            current == PipelineStatus::Pending || current == PipelineStatus::Compiling;
+            current = status())
+        {
+            m_request->status.wait(current, std::memory_order_acquire);
+        }
+    }
+
+    /// @brief Cancels the request if compilation has not started yet.
+    /// @note This affects every handle to the request.
+    /// @return true if the request was cancelled.
+    bool cancel()
+    {
+        auto expected = PipelineStatus::Pending;
+        if (!m_request->status.compare_exchange_strong(
+                expected, PipelineStatus::Cancelled, std::memory_order_acq_rel))
+        {
+            return false;
+        }
+        m_request->status.notify_all();
+        return true;
+    }
+
+    [[nodiscard]] const PipelineKey& key() const
+    {
+        return m_request->key;
+    }
+
+    /// @brief Message of the exception that failed the compilation.
+    [[nodiscard]] const std::string& error() const
+    {
+        return m_request->error;
+    }
+
+private:
+    friend class AsyncPipelineCompiler<TPipeline>;
+
+    struct Request
+    {
+        PipelineKey                 key;
+        PipelineDescription         description;
+        std::atomic<PipelineStatus> status = PipelineStatus::Pending;
+        PipelinePriority            priority = PipelinePriority::Low;
+        TPipeline                   pipeline {};
+        std::string                 error;
+    };
+
+    explicit PipelineHandle(std::shared_ptr<Request> request)
+        : m_request(std::move(request))
+    {
+    }
+
+    std::shared_ptr<Request> m_request;
+};
+
+/// @brief Compiles pipelines on dedicated threads so loading never stalls a frame.
+///
+/// Requests are deduplicated by the key of their description: asking again for a
+/// pipeline that is queued, compiling or compiled returns a handle to the existing
+/// request, and a high priority request promotes a queued low priority one. Within a
+/// priority, compilation starts in request order.
+///
+/// Compilation runs on threads owned by the compiler rather than on a ThreadPool,
+/// whose waiters run queued tasks inline: a parallelFor on the render thread could
+/// otherwise pick up a compilation and stall the frame. The compile function is
+/// called on those threads only, so it must be thread safe when there are several.
+/// @tparam TPipeline Result of the compile function, e.g. a reference counted
+/// pipeline state object.
+template <typename TPipeline>
+class AsyncPipelineCompiler
+{
+public:
+    using Handle = PipelineHandle<TPipeline>;
+
+    /// @brief Compiles a description, throwing on failure.
+    using CompileFunction = std::function<TPipeline(const PipelineDescription& description)>;
+
+    struct Statistics
+    {
+        uint64_t requests = 0;
+        uint64_t deduplicated = 0; ///< Requests answered with an existing request.
+        uint64_t compiled = 0;
+        uint64_t failed = 0;
+        uint64_t cancelled = 0; ///< Requests dropped by a worker after cancellation.
+    };
+
+    /// @param [in] compile Function performing the compilation.
+    /// @param [in] threadCount Compile threads to start, at least one.
+    explicit AsyncPipelineCompiler(CompileFunction compile, const uint32_t threadCount = 1)
+        : m_compile(std::move(compile))
+    {
+        for (uint32_t i = 0; i < std::max<uint32_t>(threadCount, 1); i++)
+        {
+            m_threads.emplace_back([this] { workerMain(); });
+        }
+    }
+
+    /// @brief Cancels queued requests and waits for running compilations.
+    ~AsyncPipelineCompiler()
+    {
+        cancelPending();
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_work.notify_all();
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    AsyncPipelineCompiler(const AsyncPipelineCompiler&) = delete;
+    AsyncPipelineCompiler& operator=(const AsyncPipelineCompiler&) = delete;
+
+    /// @brief Queues a description for compilation, or returns the existing request.
+    /// Never compiles on the calling thread.
+    ///
+    /// A request that was cancelled is replaced by a new one. Failed requests are
+    /// kept, so a broken pipeline is not recompiled on every request.
+    [[nodiscard]] Handle request(
+        const PipelineDescription& description, PipelinePriority priority = PipelinePriority::High)
+    {
+        const PipelineKey key = description.key();
+
+        RequestPtr request;
+        bool       queued = false;
+        {
+            std::lock_guard lock(m_mutex);
+            m_statistics.requests++;
+
+            request = m_requests[key];
+            if (request != nullptr
+                && request->status.load(std::memory_order_acquire) != PipelineStatus::Cancelled)
+            {
+                m_statistics.deduplicated++;
+                if (priority == PipelinePriority::High && request->priority == PipelinePriority::Low
+                    && request->status.load(std::memory_order_acquire) == PipelineStatus::Pending)
+                {
+                    // The entry left in the low queue is skipped once the request started
+                    request->priority = PipelinePriority::High;
+                    enqueue(request);
+                    queued = true;
+                }
+            }
+            else
+            {
+                request = std::make_shared<typename Handle::Request>();
+                request->key = key;
+                request->description = description;
+                request->priority = priority;
+                m_requests[key] = request;
+                enqueue(request);
+                queued = true;
+            }
+        }
+
+        if (queued)
+        {
+            m_work.notify_one();
+        }
+        return Handle(std::move(request));
+    }
+
+    /// @brief Cancels every request that has not started compiling.
+    void cancelPending()
+    {
+        std::lock_guard lock(m_mutex);
+        for (auto& queue : m_queues)
+        {
+            for (const auto& request : queue)
+            {
+                Handle(request).cancel();
+            }
+        }
+    }
+
+    /// @brief Blocks until no compilation is queued or running.
+    void waitIdle()
+    {
+        std::unique_lock lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_queuedTasks == 0; });
+    }
+
+    [[nodiscard]] uint32_t threadCount() const
+    {
+        return static_cast<uint32_t>(m_threads.size());
+    }
+
+    [[nodiscard]] Statistics statistics() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_statistics;
+    }
+
+private:
+    using RequestPtr = std::shared_ptr<typename Handle::Request>;
+
+    /// Must be called with m_mutex held, followed by a notification of m_work.
+    void enqueue(const RequestPtr& request)
+    {
+        m_queues[static_cast<size_t>(request->priority)].push_back(request);
+        m_queuedTasks++;
+    }
+
+    void workerMain()
+    {
+        while (true)
+        {
+            RequestPtr request;
+            {
+                std::unique_lock lock(m_mutex);
+                m_work.wait(lock, [this] { return m_stopping || m_queuedTasks > m_running; });
+                if (m_stopping)
+                {
+                    return;
+                }
+                for (auto& queue : m_queues)
+                {
+                    if (!queue.empty())
+                    {
+                        request = std::move(queue.front());
+                        queue.pop_front();
+                        break;
+                    }
+                }
+                m_running++;
+            }
+
+            compileRequest(request);
+
+            std::lock_guard lock(m_mutex);
+            m_running--;
+            if (--m_queuedTasks == 0)
+            {
+                m_idle.notify_all();
+            }
+        }
+    }
+
+    void compileRequest(const RequestPtr& request)
+    {
+        // Skip requests that were cancelled or already taken through another entry
+        auto expected = PipelineStatus::Pending;
+        if (request->status.compare_exchange_strong(
+                expected, PipelineStatus::Compiling, std::memory_order_acq_rel))
+        {
+            compile(*request);
+        }
+        else if (expected == PipelineStatus::Cancelled)
+        {
+            std::lock_guard lock(m_mutex);
+            m_statistics.cancelled++;
+        }
+    }
+
+    void compile(typename Handle::Request& request)
+    {
+        PipelineStatus status = PipelineStatus::Ready;
+        try
+        {
+            request.pipeline = m_compile(request.description);
+        }
+        catch (const std::exception& e)
+        {
+            request.error = e.what();
+            status = PipelineStatus::Failed;
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            (status == PipelineStatus::Ready ? m_statistics.compiled : m_statistics.failed)++;
+        }
+        request.status.store(status, std::memory_order_release);
+        request.status.notify_all();
+    }
+
+    CompileFunction m_compile;
+
+    mutable std::mutex                          m_mutex;
+    std::condition_variable                     m_work;
+    std::condition_variable                     m_idle;
+    std::unordered_map<PipelineKey, RequestPtr> m_requests;
+    std::array<std::deque<RequestPtr>, 2>       m_queues;
+    size_t                                      m_queuedTasks = 0; ///< Queue entries plus running.
+    size_t                                      m_running = 0;
+    bool                                        m_stopping = false;
+    Statistics                                  m_statistics;
+    std::vector<std::thread>                    m_threads;
+};
@@ -30,6 +30,11 @@ const CameraUniforms& Camera::uniforms() const
     return m_uniforms;
 }
 
+const Vector3& Camera::position() const
+{
+    return m_position;
+}
+
 void Camera::setProjection(float fov, float aspect, float zNear, float zFar)
 {
     m_fieldOfView = fov;
@@ -4,7 +4,7 @@
 // SPDX-License-Identifier: MIT
 ////////////////////////////////////////////////////////////////////////////////
 
-#import "GraphicsMath.hpp"
+#include "GraphicsMath.hpp"
 
 XM_ALIGNED_STRUCT(16) CameraUniforms
 {
@@ -30,6 +30,8 @@ public:
 
     [[nodiscard]] const CameraUniforms& uniforms() const;
 
+    [[nodiscard]] const Vector3& position() const;
+
     void setProjection(float fov, float aspect, float zNear, float zFar);
 
 private:
@@ -0,0 +1,629 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "CookedMesh.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "ThreadPool.hpp"
+
+namespace Assets
+{
+    namespace
+    {
+        static_assert(std::endian::native == std::endian::little,
+            "Cooked meshes are stored little endian and mapped without conversion");
+
+        constexpr uint32_t g_cookedMeshMagic = 0x48534D43; // "CMSH"
+        constexpr uint32_t g_cookedMeshVersion = 2;
+        constexpr uint64_t g_cookedMeshAlignment = 16;
+
+        constexpr uint64_t alignUp(const uint64_t value)
+        {
+            return (value + g_cookedMeshAlignment - 1) & ~(g_cookedMeshAlignment - 1);
+        }
+
+        uint32_t indexSize(const IndexFormat format)
+        {
+            return format == IndexFormat::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        }
+
+        /// Splits interleaved vertices into streams; primitives holding streams are
+        /// returned as they are.
+        VertexStreams primitiveStreams(const Primitive& primitive)
+        {
+            if (primitive.vertices.empty())
+            {
+                return primitive.streams;
+            }
+
+            VertexStreams streams;
+            for (const auto& vertex : primitive.vertices)
+            {
+                streams.positions.push_back(vertex.position);
+                streams.normals.push_back(vertex.normal);
+                streams.texCoords.push_back(vertex.texCoord);
+                streams.tangents.push_back(vertex.tangent);
+                streams.colors.push_back(vertex.color);
+            }
+            return streams;
+        }
+
+        /// Appends arrays to the data section of a file under construction, each at
+        /// the format's alignment.
+        class DataWriter
+        {
+        public:
+            explicit DataWriter(std::vector<std::byte>& bytes)
+                : m_bytes(bytes)
+            {
+            }
+
+            template <typename T>
+            uint64_t append(const std::span<const T> values)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                const uint64_t offset = alignUp(m_bytes.size());
+                m_bytes.resize(offset + values.size_bytes());
+                if (!values.empty())
+                {
+                    std::memcpy(m_bytes.data() + offset, values.data(), values.size_bytes());
+                }
+                return offset;
+            }
+
+            template <typename T>
+            void place(const uint64_t offset, const std::span<const T> values)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                if (!values.empty())
+                {
+                    std::memcpy(m_bytes.data() + offset, values.data(), values.size_bytes());
+                }
+            }
+
+        private:
+            std::vector<std::byte>& m_bytes;
+        };
+
+        /// Positions of a primitive in either vertex format.
+        std::vector<std::array<float, 3>> primitivePositions(const Primitive& primitive)
+        {
+            if (primitive.vertices.empty())
+            {
+                return primitive.streams.positions;
+            }
+
+            std::vector<std::array<float, 3>> positions;
+            positions.reserve(primitive.vertices.size());
+            for (const auto& vertex : primitive.vertices)
+            {
+                positions.push_back(vertex.position);
+            }
+            return positions;
+        }
+
+        /// Index buffers and meshlets of every level of detail of a primitive.
+        struct PrimitiveLods
+        {
+            std::vector<SimplifyResult> levels;   ///< Errors in object space units.
+            std::vector<MeshletData>    meshlets; ///< Per level, empty without meshlets.
+        };
+
+        PrimitiveLods buildLods(const Primitive& primitive, const CookOptions& options)
+        {
+            PrimitiveLods lods;
+            if (options.generateLods)
+            {
+                const VertexStreams streams = primitiveStreams(primitive);
+                lods.levels = generateLodChain(primitive.indices, streams, options.lods);
+
+                // The simplifier measures errors relative to the extent
+                float extent = 0.0F;
+                if (!streams.positions.empty())
+                {
+                    std::array<float, 3> boundsMin = streams.positions.front();
+                    std::array<float, 3> boundsMax = streams.positions.front();
+                    for (const auto& position : streams.positions)
+                    {
+                        for (size_t axis = 0; axis < 3; axis++)
+                        {
+                            boundsMin[axis] = std::min(boundsMin[axis], position[axis]);
+                            boundsMax[axis] = std::max(boundsMax[axis], position[axis]);
+                        }
+                    }
+                    for (size_t axis = 0; axis < 3; axis++)
+                    {
+                        extent = std::max(extent, boundsMax[axis] - boundsMin[axis]);
+                    }
+                }
+                for (auto& level : lods.levels)
+                {
+                    level.error *= extent;
+                }
+            }
+            else
+            {
+                lods.levels.push_back({ primitive.indices, 0.0F });
+            }
+
+            if (options.buildMeshlets)
+            {
+                const auto positions = primitivePositions(primitive);
+                for (const auto& level : lods.levels)
+                {
+                    lods.meshlets.push_back(buildMeshlets(level.indices, positions));
+                }
+            }
+            return lods;
+        }
+
+        template <size_t N>
+        EncodedStream floatStream(const std::vector<std::array<float, N>>& values)
+        {
+            constexpr VertexStreamFormat formats[] = { VertexStreamFormat::None,
+                VertexStreamFormat::None, VertexStreamFormat::Float2, VertexStreamFormat::Float3,
+                VertexStreamFormat::Float4 };
+            EncodedStream stream;
+            stream.format = formats[N];
+            stream.bytes.resize(values.size() * sizeof(std::array<float, N>));
+            if (!values.empty())
+            {
+                std::memcpy(stream.bytes.data(), values.data(), stream.bytes.size());
+            }
+            return stream;
+        }
+
+        /// Encodes the present attributes, indexed by VertexAttribute.
+        std::array<EncodedStream, g_vertexAttributeCount> encodeStreams(
+            const VertexStreams& streams, const CookedPrimitive& record, const bool quantize)
+        {
+            std::array<EncodedStream, g_vertexAttributeCount> encoded;
+            const auto set = [&encoded](const VertexAttribute attribute, EncodedStream stream) {
+                encoded[static_cast<size_t>(attribute)] = std::move(stream);
+            };
+            if (quantize)
+            {
+                set(VertexAttribute::Position,
+                    quantizePositions(streams.positions, record.boundsMin, record.boundsMax));
+                set(VertexAttribute::Normal, quantizeNormals(streams.normals));
+                set(VertexAttribute::TexCoord, quantizeTexCoords(streams.texCoords));
+                set(VertexAttribute::Tangent, quantizeTangents(streams.tangents));
+                set(VertexAttribute::Color, quantizeColors(streams.colors));
+            }
+            else
+            {
+                set(VertexAttribute::Position, floatStream(streams.positions));
+                set(VertexAttribute::Normal, floatStream(streams.normals));
+                set(VertexAttribute::TexCoord, floatStream(streams.texCoords));
+                set(VertexAttribute::Tangent, floatStream(streams.tangents));
+                set(VertexAttribute::Color, floatStream(streams.colors));
+            }
+            return encoded;
+        }
+
+        CookedStream appendStream(DataWriter& writer, const EncodedStream& encoded)
+        {
+            if (encoded.bytes.empty())
+            {
+                return {};
+            }
+
+            CookedStream stream;
+            stream.offset = writer.append(std::span<const std::byte>(encoded.bytes));
+            stream.size = encoded.bytes.size();
+            stream.format = encoded.format;
+            stream.stride = vertexStreamStride(encoded.format);
+            return stream;
+        }
+
+        uint64_t appendIndices(
+            DataWriter& writer, const std::vector<uint32_t>& indices, const IndexFormat format)
+        {
+            if (format == IndexFormat::UInt32)
+            {
+                return writer.append(std::span(indices));
+            }
+
+            std::vector<uint16_t> narrow(indices.begin(), indices.end());
+            return writer.append(std::span<const uint16_t>(narrow));
+        }
+    } // namespace
+
+    std::vector<std::byte> cookMeshes(
+        const std::span<const Mesh> meshes, const CookOptions& options)
+    {
+        CookedMeshHeader header;
+        header.magic = g_cookedMeshMagic;
+        header.version = g_cookedMeshVersion;
+        header.meshCount = static_cast<uint32_t>(meshes.size());
+
+        std::string strings;
+        for (const auto& mesh : meshes)
+        {
+            header.primitiveCount += static_cast<uint32_t>(mesh.primitives.size());
+            strings += mesh.name;
+        }
+
+        // Levels of detail and meshlets are built up front, in parallel, so the LOD
+        // and meshlet tables can be laid out with the others
+        std::vector<const Primitive*> primitives;
+        for (const auto& mesh : meshes)
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                primitives.push_back(&primitive);
+            }
+        }
+        std::vector<PrimitiveLods> primitiveLods(primitives.size());
+        ThreadPool::shared().parallelFor(primitives.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                primitiveLods[i] = buildLods(*primitives[i], options);
+            }
+        });
+        for (const auto& lods : primitiveLods)
+        {
+            header.lodCount += static_cast<uint32_t>(lods.levels.size());
+            for (const auto& meshlets : lods.meshlets)
+            {
+                header.meshletCount += static_cast<uint32_t>(meshlets.meshlets.size());
+            }
+        }
+
+        // The tables go first, their sizes are known up front; vertex and index data
+        // follow and are addressed with absolute offsets
+        header.meshesOffset = alignUp(sizeof(CookedMeshHeader));
+        header.primitivesOffset =
+            alignUp(header.meshesOffset + header.meshCount * sizeof(CookedMeshRecord));
+        header.lodsOffset =
+            alignUp(header.primitivesOffset + header.primitiveCount * sizeof(CookedPrimitive));
+        header.meshletsOffset = alignUp(header.lodsOffset + header.lodCount * sizeof(CookedLod));
+        header.stringsOffset =
+            alignUp(header.meshletsOffset + header.meshletCount * sizeof(CookedMeshlet));
+        header.stringsSize = strings.size();
+
+        std::vector<std::byte> bytes(header.stringsOffset + header.stringsSize);
+        DataWriter             writer(bytes);
+
+        std::vector<CookedMeshRecord> meshRecords;
+        std::vector<CookedPrimitive>  primitiveRecords;
+        std::vector<CookedLod>        lodRecords;
+        std::vector<CookedMeshlet>    meshletRecords;
+        uint32_t                      nameOffset = 0;
+        for (const auto& mesh : meshes)
+        {
+            meshRecords.push_back({ nameOffset, static_cast<uint32_t>(mesh.name.size()),
+                static_cast<uint32_t>(primitiveRecords.size()),
+                static_cast<uint32_t>(mesh.primitives.size()) });
+            nameOffset += static_cast<uint32_t>(mesh.name.size());
+
+            for (const auto& primitive : mesh.primitives)
+            {
+                const VertexStreams streams = primitiveStreams(primitive);
+
+                // Bounds are recomputed rather than trusted, quantized positions are
+                // relative to them
+                CookedPrimitive record;
+                if (!streams.positions.empty())
+                {
+                    record.boundsMin = streams.positions.front();
+                    record.boundsMax = streams.positions.front();
+                }
+                for (const auto& position : streams.positions)
+                {
+                    for (size_t axis = 0; axis < 3; axis++)
+                    {
+                        record.boundsMin[axis] = std::min(record.boundsMin[axis], position[axis]);
+                        record.boundsMax[axis] = std::max(record.boundsMax[axis], position[axis]);
+                    }
+                }
+
+                const auto encoded = encodeStreams(streams, record, options.quantize);
+                for (size_t attribute = 0; attribute < g_vertexAttributeCount; attribute++)
+                {
+                    record.streams[attribute] = appendStream(writer, encoded[attribute]);
+                }
+                record.material = primitive.material;
+                record.vertexCount = static_cast<uint32_t>(streams.positions.size());
+                record.indexFormat = record.vertexCount <= 0x10000 ? IndexFormat::UInt16
+                                                                   : IndexFormat::UInt32;
+                record.firstLod = static_cast<uint32_t>(lodRecords.size());
+                const PrimitiveLods& lods = primitiveLods[primitiveRecords.size()];
+                record.lodCount = static_cast<uint32_t>(lods.levels.size());
+
+                for (size_t level = 0; level < lods.levels.size(); level++)
+                {
+                    CookedLod lod;
+                    lod.indexOffset =
+                        appendIndices(writer, lods.levels[level].indices, record.indexFormat);
+                    lod.indexCount = static_cast<uint32_t>(lods.levels[level].indices.size());
+                    lod.error = lods.levels[level].error;
+                    if (!lods.meshlets.empty())
+                    {
+                        const MeshletData& data = lods.meshlets[level];
+                        lod.meshletVertexOffset = writer.append(std::span(data.vertices));
+                        lod.meshletTriangleOffset = writer.append(std::span(data.triangles));
+                        lod.firstMeshlet = static_cast<uint32_t>(meshletRecords.size());
+                        lod.meshletCount = static_cast<uint32_t>(data.meshlets.size());
+                        lod.meshletVertexCount = static_cast<uint32_t>(data.vertices.size());
+                        lod.meshletTriangleIndexCount =
+                            static_cast<uint32_t>(data.triangles.size());
+                        meshletRecords.insert(
+                            meshletRecords.end(), data.meshlets.begin(), data.meshlets.end());
+                    }
+                    lodRecords.push_back(lod);
+                }
+                primitiveRecords.push_back(record);
+            }
+        }
+        bytes.resize(alignUp(bytes.size()));
+        header.fileSize = bytes.size();
+
+        writer.place(0, std::span<const CookedMeshHeader>(&header, 1));
+        writer.place(header.meshesOffset, std::span<const CookedMeshRecord>(meshRecords));
+        writer.place(header.primitivesOffset, std::span<const CookedPrimitive>(primitiveRecords));
+        writer.place(header.lodsOffset, std::span<const CookedLod>(lodRecords));
+        writer.place(header.meshletsOffset, std::span<const CookedMeshlet>(meshletRecords));
+        writer.place(header.stringsOffset, std::span<const char>(strings));
+        return bytes;
+    }
+
+    void writeCookedMeshes(const std::filesystem::path& path, const std::span<const Mesh> meshes,
+        const CookOptions& options)
+    {
+        const std::vector<std::byte> bytes = cookMeshes(meshes, options);
+
+        // Write next to the destination and rename, so readers never see a partial file
+        std::filesystem::path temporaryPath = path;
+        temporaryPath += ".tmp";
+        {
+            std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+            stream.write(reinterpret_cast<const char*>(bytes.data()),
+                static_cast<std::streamsize>(bytes.size()));
+            if (!stream)
+            {
+                throw std::runtime_error(
+                    std::format("Failed to write cooked meshes {}", temporaryPath.string()));
+            }
+        }
+        std::filesystem::rename(temporaryPath, path);
+    }
+
+    void describeVertexStreams(const CookedPrimitive& primitive,
+        PipelineDescription& description, const uint32_t firstBufferIndex)
+    {
+        for (uint32_t attribute = 0; attribute < g_vertexAttributeCount; attribute++)
+        {
+            const CookedStream& stream = primitive.streams[attribute];
+            if (stream.format == VertexStreamFormat::None)
+            {
+                continue;
+            }
+            const uint32_t bufferIndex = firstBufferIndex + attribute;
+            description.vertexAttributes.push_back({ .index = attribute,
+                .format = metalVertexFormat(stream.format),
+                .offset = 0,
+                .bufferIndex = bufferIndex });
+            description.vertexLayouts.push_back(
+                { .bufferIndex = bufferIndex, .stride = stream.stride });
+        }
+    }
+
+    CookedMeshFile::CookedMeshFile(const std::filesystem::path& path)
+        : m_file(path)
+    {
+        const auto bytes = m_file.bytes();
+        if (bytes.size() < sizeof(CookedMeshHeader))
+        {
+            throw std::runtime_error(std::format("{} is not a cooked mesh file", path.string()));
+        }
+        std::memcpy(&m_header, bytes.data(), sizeof(CookedMeshHeader));
+        if (m_header.magic != g_cookedMeshMagic)
+        {
+            throw std::runtime_error(std::format("{} is not a cooked mesh file", path.string()));
+        }
+        if (m_header.version != g_cookedMeshVersion)
+        {
+            throw std::runtime_error(std::format("{} has cooked mesh version {}, expected {}",
+                path.string(), m_header.version, g_cookedMeshVersion));
+        }
+
+        try
+        {
+            validate();
+        }
+        catch (const std::exception& exception)
+        {
+            throw std::runtime_error(
+                std::format("{} is corrupt: {}", path.string(), exception.what()));
+        }
+    }
+
+    size_t CookedMeshFile::meshCount() const
+    {
+        return m_header.meshCount;
+    }
+
+    std::string_view CookedMeshFile::meshName(const size_t mesh) const
+    {
+        const CookedMeshRecord& record = array<CookedMeshRecord>(
+            m_header.meshesOffset, m_header.meshCount)[mesh];
+        const auto* strings = reinterpret_cast<const char*>(m_file.bytes().data())
+            + m_header.stringsOffset;
+        return { strings + record.nameOffset, record.nameLength };
+    }
+
+    std::span<const CookedPrimitive> CookedMeshFile::primitives(const size_t mesh) const
+    {
+        const CookedMeshRecord& record = array<CookedMeshRecord>(
+            m_header.meshesOffset, m_header.meshCount)[mesh];
+        return array<CookedPrimitive>(m_header.primitivesOffset, m_header.primitiveCount)
+            .subspan(record.firstPrimitive, record.primitiveCount);
+    }
+
+    std::span<const std::byte> CookedMeshFile::stream(
+        const CookedPrimitive& primitive, const VertexAttribute attribute) const
+    {
+        const CookedStream& stream = primitive.stream(attribute);
+        return array<std::byte>(stream.offset, stream.size);
+    }
+
+    std::span<const CookedLod> CookedMeshFile::lods(const CookedPrimitive& primitive) const
+    {
+        return array<CookedLod>(m_header.lodsOffset, m_header.lodCount)
+            .subspan(primitive.firstLod, primitive.lodCount);
+    }
+
+    std::span<const std::byte> CookedMeshFile::indices(
+        const CookedPrimitive& primitive, const CookedLod& lod) const
+    {
+        return array<std::byte>(
+            lod.indexOffset, size_t { lod.indexCount } * indexSize(primitive.indexFormat));
+    }
+
+    std::span<const CookedMeshlet> CookedMeshFile::meshlets(const CookedLod& lod) const
+    {
+        return array<CookedMeshlet>(m_header.meshletsOffset, m_header.meshletCount)
+            .subspan(lod.firstMeshlet, lod.meshletCount);
+    }
+
+    std::span<const uint32_t> CookedMeshFile::meshletVertices(const CookedLod& lod) const
+    {
+        return array<uint32_t>(lod.meshletVertexOffset, lod.meshletVertexCount);
+    }
+
+    std::span<const uint8_t> CookedMeshFile::meshletTriangles(const CookedLod& lod) const
+    {
+        return array<uint8_t>(lod.meshletTriangleOffset, lod.meshletTriangleIndexCount);
+    }
+
+    std::span<const std::byte> CookedMeshFile::bytes() const
+    {
+        return m_file.bytes();
+    }
+
+    template <typename T>
+    std::span<const T> CookedMeshFile::array(const uint64_t offset, const size_t count) const
+    {
+        // Offsets were validated when the file was opened
+        const auto* data = m_file.bytes().data() + offset;
+        return { reinterpret_cast<const T*>(data), count };
+    }
+
+    void CookedMeshFile::validate() const
+    {
+        const auto bytes = m_file.bytes();
+        if (reinterpret_cast<uintptr_t>(bytes.data()) % g_cookedMeshAlignment != 0)
+        {
+            throw std::runtime_error("the file is not mapped at an aligned address");
+        }
+        if (m_header.fileSize != bytes.size())
+        {
+            throw std::runtime_error(std::format("the header records {} bytes but the file has {}",
+                m_header.fileSize, bytes.size()));
+        }
+
+        const auto checkRange = [&bytes](const char* what, const uint64_t offset,
+                                    const uint64_t count, const uint64_t elementSize) {
+            if (offset % g_cookedMeshAlignment != 0 || offset > bytes.size()
+                || count > (bytes.size() - offset) / elementSize)
+            {
+                throw std::runtime_error(
+                    std::format("{} at offset {} is out of bounds", what, offset));
+            }
+        };
+        const auto checkSubrange = [](const char* what, const uint64_t first, const uint64_t count,
+                                       const uint64_t total) {
+            if (first > total || count > total - first)
+            {
+                throw std::runtime_error(
+                    std::format("{} {}+{} exceed {}", what, first, count, total));
+            }
+        };
+
+        checkRange(
+            "mesh table", m_header.meshesOffset, m_header.meshCount, sizeof(CookedMeshRecord));
+        checkRange("primitive table", m_header.primitivesOffset, m_header.primitiveCount,
+            sizeof(CookedPrimitive));
+        checkRange("LOD table", m_header.lodsOffset, m_header.lodCount, sizeof(CookedLod));
+        checkRange("meshlet table", m_header.meshletsOffset, m_header.meshletCount,
+            sizeof(CookedMeshlet));
+        checkRange("string table", m_header.stringsOffset, m_header.stringsSize, 1);
+
+        for (const auto& mesh : array<CookedMeshRecord>(m_header.meshesOffset, m_header.meshCount))
+        {
+            checkSubrange("mesh name", mesh.nameOffset, mesh.nameLength, m_header.stringsSize);
+            checkSubrange("mesh primitives", mesh.firstPrimitive, mesh.primitiveCount,
+                m_header.primitiveCount);
+        }
+
+        const auto primitives =
+            array<CookedPrimitive>(m_header.primitivesOffset, m_header.primitiveCount);
+        const auto lods = array<CookedLod>(m_header.lodsOffset, m_header.lodCount);
+        for (const auto& primitive : primitives)
+        {
+            for (const auto& stream : primitive.streams)
+            {
+                if (stream.format == VertexStreamFormat::None)
+                {
+                    continue;
+                }
+                const uint32_t stride = vertexStreamStride(stream.format);
+                if (stride == 0 || stream.stride != stride
+                    || stream.size != uint64_t { stride } * primitive.vertexCount)
+                {
+                    throw std::runtime_error("a vertex stream does not match its format");
+                }
+                checkRange("vertex stream", stream.offset, stream.size, 1);
+            }
+            if (primitive.stream(VertexAttribute::Position).format == VertexStreamFormat::None)
+            {
+                throw std::runtime_error("a primitive has no positions");
+            }
+            if (primitive.indexFormat != IndexFormat::UInt16
+                && primitive.indexFormat != IndexFormat::UInt32)
+            {
+                throw std::runtime_error("a primitive has an unknown index format");
+            }
+            if (primitive.lodCount == 0)
+            {
+                throw std::runtime_error("a primitive has no LODs");
+            }
+            checkSubrange("primitive LODs", primitive.firstLod, primitive.lodCount,
+                m_header.lodCount);
+
+            for (const auto& lod : lods.subspan(primitive.firstLod, primitive.lodCount))
+            {
+                checkRange("index buffer", lod.indexOffset, lod.indexCount,
+                    indexSize(primitive.indexFormat));
+                checkSubrange(
+                    "LOD meshlets", lod.firstMeshlet, lod.meshletCount, m_header.meshletCount);
+                if (lod.meshletCount == 0)
+                {
+                    continue;
+                }
+
+                checkRange("meshlet vertices", lod.meshletVertexOffset, lod.meshletVertexCount,
+                    sizeof(uint32_t));
+                checkRange("meshlet triangles", lod.meshletTriangleOffset,
+                    lod.meshletTriangleIndexCount, sizeof(uint8_t));
+                for (const auto& meshlet : meshlets(lod))
+                {
+                    checkSubrange("meshlet vertices", meshlet.vertexOffset, meshlet.vertexCount,
+                        lod.meshletVertexCount);
+                    checkSubrange("meshlet triangles", meshlet.triangleOffset,
+                        uint64_t { meshlet.triangleCount } * 3, lod.meshletTriangleIndexCount);
+                }
+            }
+        }
+    }
+} // namespace Assets
@@ -0,0 +1,204 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshletBuilder.hpp"
+#include "PipelineCache.hpp"
+#include "SceneLoader.hpp"
+#include "VertexQuantization.hpp"
+
+namespace Assets
+{
+    /// @brief Vertex attributes of a cooked primitive, each stored as its own stream.
+    enum class VertexAttribute : uint32_t
+    {
+        Position,
+        Normal,
+        TexCoord,
+        Tangent,
+        Color,
+        Count,
+    };
+
+    inline constexpr size_t g_vertexAttributeCount = static_cast<size_t>(VertexAttribute::Count);
+
+    enum class IndexFormat : uint32_t
+    {
+        UInt16,
+        UInt32,
+    };
+
+    // On-disk records of the cooked mesh format. All offsets are in bytes from the
+    // start of the file and every array they point at is 16 byte aligned, so a mapped
+    // file can be handed to the GPU as is.
+
+    struct CookedStream
+    {
+        uint64_t           offset = 0;
+        uint64_t           size = 0;
+        VertexStreamFormat format = VertexStreamFormat::None;
+        uint32_t           stride = 0;
+    };
+
+    /// @brief Level of detail of a primitive: an index buffer over the primitive's
+    /// vertices and, optionally, its meshlets.
+    struct CookedLod
+    {
+        uint64_t indexOffset = 0;
+        uint32_t indexCount = 0;
+        float    error = 0.0F; ///< Simplification error in object space units.
+        uint64_t meshletVertexOffset = 0;   ///< uint32_t primitive vertex indices.
+        uint64_t meshletTriangleOffset = 0; ///< uint8_t meshlet local index triplets.
+        uint32_t firstMeshlet = 0;          ///< Into the file's meshlet table.
+        uint32_t meshletCount = 0;
+        uint32_t meshletVertexCount = 0;
+        uint32_t meshletTriangleIndexCount = 0;
+    };
+
+    /// @brief Meshlets are stored as built, offsets relative to their LOD's arrays.
+    using CookedMeshlet = Meshlet;
+
+    struct CookedPrimitive
+    {
+        std::array<CookedStream, g_vertexAttributeCount> streams {};
+        std::array<float, 3>                              boundsMin {};
+        std::array<float, 3>                              boundsMax {};
+        int32_t                                           material = -1;
+        uint32_t                                          vertexCount = 0;
+        IndexFormat                                       indexFormat = IndexFormat::UInt32;
+        uint32_t                                          firstLod = 0; ///< Into the LOD table.
+        uint32_t                                          lodCount = 0;
+        std::array<uint32_t, 3>                           reserved {};
+
+        [[nodiscard]] const CookedStream& stream(const VertexAttribute attribute) const
+        {
+            return streams[static_cast<size_t>(attribute)];
+        }
+    };
+
+    struct CookedMeshRecord
+    {
+        uint32_t nameOffset = 0; ///< Into the string table.
+        uint32_t nameLength = 0;
+        uint32_t firstPrimitive = 0;
+        uint32_t primitiveCount = 0;
+    };
+
+    struct CookedMeshHeader
+    {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t meshCount = 0;
+        uint32_t primitiveCount = 0;
+        uint32_t lodCount = 0;
+        uint32_t meshletCount = 0;
+        uint64_t fileSize = 0;
+        uint64_t meshesOffset = 0;
+        uint64_t primitivesOffset = 0;
+        uint64_t lodsOffset = 0;
+        uint64_t meshletsOffset = 0;
+        uint64_t stringsOffset = 0;
+        uint64_t stringsSize = 0;
+    };
+
+    static_assert(sizeof(CookedStream) == 24);
+    static_assert(sizeof(CookedLod) == 48);
+    static_assert(sizeof(CookedMeshlet) == 48);
+    static_assert(sizeof(CookedPrimitive) == 176);
+    static_assert(sizeof(CookedMeshRecord) == 16);
+    static_assert(sizeof(CookedMeshHeader) == 80);
+
+    struct CookOptions
+    {
+        /// Store attributes in the compact formats of VertexQuantization.hpp instead of
+        /// 32 bit floats. Positions are then relative to the primitive bounds.
+        bool quantize = false;
+        /// Split every LOD into meshlets with culling bounds, for mesh shaders.
+        bool buildMeshlets = false;
+        /// Add simplified levels of detail after the full detail index buffer.
+        bool            generateLods = false;
+        LodChainOptions lods;
+    };
+
+    /// @brief Serializes meshes into the cooked format.
+    ///
+    /// Primitives may hold interleaved vertices or streams; either way every present
+    /// attribute becomes its own stream. Index buffers use 16 bit indices whenever the
+    /// primitive has few enough vertices.
+    [[nodiscard]] std::vector<std::byte> cookMeshes(
+        std::span<const Mesh> meshes, const CookOptions& options = {});
+
+    /// @brief Cooks meshes into a file, replacing any existing file atomically.
+    /// @throws std::runtime_error if the file cannot be written.
+    void writeCookedMeshes(const std::filesystem::path& path, std::span<const Mesh> meshes,
+        const CookOptions& options = {});
+
+    /// @brief Adds the vertex attributes and layouts reading a cooked primitive to a
+    /// pipeline description.
+    ///
+    /// Every present stream is bound as its own buffer, at firstBufferIndex plus the
+    /// attribute, with the attribute's VertexAttribute value as attribute index.
+    void describeVertexStreams(const CookedPrimitive& primitive,
+        PipelineDescription& description, uint32_t firstBufferIndex = 0);
+
+    /// @brief Memory mapped cooked mesh file.
+    ///
+    /// The whole file is validated when opened, after which the accessors return spans
+    /// straight into the mapping without any per-vertex work. The spans stay valid as
+    /// long as the file object lives.
+    class CookedMeshFile
+    {
+    public:
+        /// @throws std::runtime_error if the file cannot be mapped, was written by an
+        /// incompatible version or is corrupt.
+        explicit CookedMeshFile(const std::filesystem::path& path);
+
+        [[nodiscard]] size_t meshCount() const;
+
+        [[nodiscard]] std::string_view meshName(size_t mesh) const;
+
+        [[nodiscard]] std::span<const CookedPrimitive> primitives(size_t mesh) const;
+
+        /// @brief Returns the bytes of one vertex stream; empty if the attribute is absent.
+        [[nodiscard]] std::span<const std::byte> stream(
+            const CookedPrimitive& primitive, VertexAttribute attribute) const;
+
+        /// @brief Returns the levels of detail of a primitive, full detail first.
+        [[nodiscard]] std::span<const CookedLod> lods(const CookedPrimitive& primitive) const;
+
+        /// @brief Returns the index buffer of a LOD in the primitive's index format.
+        [[nodiscard]] std::span<const std::byte> indices(
+            const CookedPrimitive& primitive, const CookedLod& lod) const;
+
+        [[nodiscard]] std::span<const CookedMeshlet> meshlets(const CookedLod& lod) const;
+
+        [[nodiscard]] std::span<const uint32_t> meshletVertices(const CookedLod& lod) const;
+
+        [[nodiscard]] std::span<const uint8_t> meshletTriangles(const CookedLod& lod) const;
+
+        /// @brief Returns the whole mapped file.
+        [[nodiscard]] std::span<const std::byte> bytes() const;
+
+    private:
+        template <typename T>
+        [[nodiscard]] std::span<const T> array(uint64_t offset, size_t count) const;
+
+        void validate() const;
+
+        MappedFile       m_file;
+        CookedMeshHeader m_header;
+    };
+} // namespace Assets
@@ -0,0 +1,448 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Ecs.hpp"
+
+#include <bit>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+namespace Ecs
+{
+    namespace
+    {
+        /// Alignment of each component array in a chunk.
+        constexpr size_t g_arrayAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+        struct ComponentRegistry
+        {
+            std::mutex                          mutex;
+            std::array<size_t, g_maxComponents> sizes {};
+            std::atomic<uint32_t>               count = 0;
+        };
+
+        ComponentRegistry& registry()
+        {
+            static ComponentRegistry s_registry;
+            return s_registry;
+        }
+
+        size_t alignUp(const size_t value, const size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    } // namespace
+
+    ComponentId registerComponent(const size_t size)
+    {
+        ComponentRegistry& components = registry();
+        const std::lock_guard lock(components.mutex);
+        const uint32_t        id = components.count.load(std::memory_order_relaxed);
+        if (id == g_maxComponents)
+        {
+            throw std::runtime_error(
+                std::format("At most {} component types can be registered", g_maxComponents));
+        }
+        components.sizes[id] = size;
+        components.count.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    size_t componentSize(const ComponentId component)
+    {
+        const ComponentRegistry& components = registry();
+        if (component >= components.count.load(std::memory_order_acquire))
+        {
+            throw std::runtime_error(std::format("Component {} is not registered", component));
+        }
+        return components.sizes[component];
+    }
+
+    Archetype::Archetype(const ComponentMask mask)
+        : m_mask(mask)
+    {
+        size_t rowBytes = sizeof(Entity);
+        for (ComponentMask bits = mask; bits != 0; bits &= bits - 1)
+        {
+            const auto component = static_cast<ComponentId>(std::countr_zero(bits));
+            m_componentIds.push_back(component);
+            m_sizes[component] = static_cast<uint32_t>(componentSize(component));
+            rowBytes += m_sizes[component];
+        }
+
+        // Padding between the arrays can push the first estimate over the chunk size;
+        // the last call leaves the offsets of the final capacity
+        const auto chunkBytes = [&](const size_t capacity) {
+            size_t offset = capacity * sizeof(Entity);
+            for (const ComponentId component : m_componentIds)
+            {
+                offset = alignUp(offset, g_arrayAlignment);
+                m_offsets[component] = static_cast<uint32_t>(offset);
+                offset += capacity * m_sizes[component];
+            }
+            return offset;
+        };
+        size_t capacity = g_chunkBytes / rowBytes;
+        while (capacity > 0 && chunkBytes(capacity) > g_chunkBytes)
+        {
+            capacity--;
+        }
+        if (capacity == 0)
+        {
+            throw std::runtime_error(
+                std::format("Components of {} bytes do not fit in a chunk", rowBytes));
+        }
+        m_capacity = static_cast<uint32_t>(capacity);
+    }
+
+    ComponentMask Archetype::mask() const
+    {
+        return m_mask;
+    }
+
+    uint32_t Archetype::chunkCapacity() const
+    {
+        return m_capacity;
+    }
+
+    size_t Archetype::entityCount() const
+    {
+        return m_entityCount;
+    }
+
+    size_t Archetype::chunkCount() const
+    {
+        return m_chunks.size();
+    }
+
+    std::span<const Entity> Archetype::entities(const size_t chunk) const
+    {
+        const Chunk& entry = m_chunks[chunk];
+        return { std::launder(reinterpret_cast<const Entity*>(entry.memory.get())), entry.count };
+    }
+
+    std::byte* Archetype::component(const Location location, const ComponentId component) const
+    {
+        return m_chunks[location.chunk].memory.get() + m_offsets[component]
+            + location.row * m_sizes[component];
+    }
+
+    Archetype::Location Archetype::pushRow(const Entity entity)
+    {
+        if (m_chunks.empty() || m_chunks.back().count == m_capacity)
+        {
+            m_chunks.push_back(
+                { .memory = std::make_unique_for_overwrite<std::byte[]>(g_chunkBytes) });
+        }
+        Chunk&         chunk = m_chunks.back();
+        const Location location { .chunk = static_cast<uint32_t>(m_chunks.size() - 1),
+            .row = chunk.count };
+        std::memcpy(chunk.memory.get() + location.row * sizeof(Entity), &entity, sizeof(Entity));
+        for (const ComponentId id : m_componentIds)
+        {
+            std::memset(component(location, id), 0, m_sizes[id]);
+        }
+        chunk.count++;
+        m_entityCount++;
+        return location;
+    }
+
+    Entity Archetype::removeRow(const Location location)
+    {
+        Chunk&         last = m_chunks.back();
+        const Location lastLocation { .chunk = static_cast<uint32_t>(m_chunks.size() - 1),
+            .row = last.count - 1 };
+
+        Entity moved;
+        if (location.chunk != lastLocation.chunk || location.row != lastLocation.row)
+        {
+            std::byte* entities = m_chunks[location.chunk].memory.get();
+            std::memcpy(entities + location.row * sizeof(Entity),
+                last.memory.get() + lastLocation.row * sizeof(Entity), sizeof(Entity));
+            std::memcpy(&moved, entities + location.row * sizeof(Entity), sizeof(Entity));
+            for (const ComponentId id : m_componentIds)
+            {
+                std::memcpy(component(location, id), component(lastLocation, id), m_sizes[id]);
+            }
+        }
+
+        last.count--;
+        m_entityCount--;
+        if (last.count == 0)
+        {
+            m_chunks.pop_back();
+        }
+        return moved;
+    }
+
+    CommandBuffer::PendingEntity CommandBuffer::create()
+    {
+        const std::lock_guard lock(m_mutex);
+        const PendingEntity   entity { .index = m_pendingCount++ };
+        m_commands.push_back({ .operation = Operation::Create, .index = entity.index });
+        return entity;
+    }
+
+    void CommandBuffer::destroy(const Entity entity)
+    {
+        record({ .operation = Operation::Destroy,
+                   .index = entity.index,
+                   .generation = entity.generation },
+            nullptr, 0);
+    }
+
+    bool CommandBuffer::empty() const
+    {
+        const std::lock_guard lock(m_mutex);
+        return m_commands.empty();
+    }
+
+    void CommandBuffer::clear()
+    {
+        const std::lock_guard lock(m_mutex);
+        m_commands.clear();
+        m_data.clear();
+        m_pendingCount = 0;
+    }
+
+    void CommandBuffer::record(Command command, const void* data, const size_t size)
+    {
+        const std::lock_guard lock(m_mutex);
+        command.dataOffset = static_cast<uint32_t>(m_data.size());
+        if (size > 0)
+        {
+            m_data.resize(m_data.size() + size);
+            std::memcpy(m_data.data() + command.dataOffset, data, size);
+        }
+        m_commands.push_back(command);
+    }
+
+    World::World()
+    {
+        static_cast<void>(archetype(0));
+    }
+
+    void World::destroy(const Entity entity)
+    {
+        requireStructuralChange();
+        static_cast<void>(record(entity));
+        Record&      entry = m_records[entity.index];
+        const Entity moved = entry.archetype->removeRow(entry.location);
+        if (moved.index != Entity {}.index)
+        {
+            m_records[moved.index].location = entry.location;
+        }
+        entry.archetype = nullptr;
+        entry.generation++;
+        m_freeIndices.push_back(entity.index);
+        m_entityCount--;
+    }
+
+    bool World::isAlive(const Entity entity) const
+    {
+        return entity.index < m_records.size() && m_records[entity.index].archetype != nullptr
+            && m_records[entity.index].generation == entity.generation;
+    }
+
+    size_t World::entityCount() const
+    {
+        return m_entityCount;
+    }
+
+    size_t World::archetypeCount() const
+    {
+        return m_archetypes.size();
+    }
+
+    std::vector<Entity> World::apply(CommandBuffer& commands)
+    {
+        requireStructuralChange();
+        const std::lock_guard lock(commands.m_mutex);
+
+        // Pending entities are created directly in the archetype of all their
+        // recorded components, instead of moving once per component
+        std::vector<ComponentMask> masks(commands.m_pendingCount, 0);
+        for (const auto& command : commands.m_commands)
+        {
+            if (command.operation == CommandBuffer::Operation::Add && command.pending)
+            {
+                masks[command.index] |= ComponentMask { 1 } << command.component;
+            }
+        }
+
+        std::vector<Entity> created(commands.m_pendingCount);
+        for (const auto& command : commands.m_commands)
+        {
+            const Entity entity = command.pending
+                ? created[command.index]
+                : Entity { .index = command.index, .generation = command.generation };
+            switch (command.operation)
+            {
+            case CommandBuffer::Operation::Create:
+                created[command.index] = createEntity(masks[command.index]);
+                break;
+            case CommandBuffer::Operation::Destroy:
+                if (isAlive(entity))
+                {
+                    destroy(entity);
+                }
+                break;
+            case CommandBuffer::Operation::Add:
+                if (isAlive(entity))
+                {
+                    setComponent(entity, command.component,
+                        commands.m_data.data() + command.dataOffset);
+                }
+                break;
+            case CommandBuffer::Operation::Remove:
+                if (isAlive(entity))
+                {
+                    removeComponent(entity, command.component);
+                }
+                break;
+            }
+        }
+
+        commands.m_commands.clear();
+        commands.m_data.clear();
+        commands.m_pendingCount = 0;
+        return created;
+    }
+
+    Entity World::createEntity(const ComponentMask mask)
+    {
+        requireStructuralChange();
+        Archetype& target = archetype(mask);
+
+        uint32_t index = static_cast<uint32_t>(m_records.size());
+        if (!m_freeIndices.empty())
+        {
+            index = m_freeIndices.back();
+            m_freeIndices.pop_back();
+        }
+        else
+        {
+            m_records.emplace_back();
+        }
+
+        Record&      entry = m_records[index];
+        const Entity entity { .index = index, .generation = entry.generation };
+        entry.archetype = &target;
+        entry.location = target.pushRow(entity);
+        m_entityCount++;
+        return entity;
+    }
+
+    void World::copyComponent(const Entity entity, const ComponentId component, const void* data)
+    {
+        const Record& entry = m_records[entity.index];
+        std::memcpy(entry.archetype->component(entry.location, component), data,
+            entry.archetype->m_sizes[component]);
+    }
+
+    void World::setComponent(const Entity entity, const ComponentId component, const void* data)
+    {
+        requireStructuralChange();
+        const Record& entry = record(entity);
+        Archetype&    source = *entry.archetype;
+        if ((source.mask() & ComponentMask { 1 } << component) == 0)
+        {
+            Archetype*& next = source.m_addEdges[component];
+            if (next == nullptr)
+            {
+                next = &archetype(source.mask() | ComponentMask { 1 } << component);
+            }
+            moveEntity(entity, *next);
+        }
+        copyComponent(entity, component, data);
+    }
+
+    void World::removeComponent(const Entity entity, const ComponentId component)
+    {
+        requireStructuralChange();
+        Archetype& source = *record(entity).archetype;
+        if ((source.mask() & ComponentMask { 1 } << component) == 0)
+        {
+            return;
+        }
+        Archetype*& next = source.m_removeEdges[component];
+        if (next == nullptr)
+        {
+            next = &archetype(source.mask() & ~(ComponentMask { 1 } << component));
+        }
+        moveEntity(entity, *next);
+    }
+
+    std::byte* World::component(const Entity entity, const ComponentId component) const
+    {
+        const Record& entry = record(entity);
+        if ((entry.archetype->mask() & ComponentMask { 1 } << component) == 0)
+        {
+            return nullptr;
+        }
+        return entry.archetype->component(entry.location, component);
+    }
+
+    ComponentMask World::mask(const Entity entity) const
+    {
+        return record(entity).archetype->mask();
+    }
+
+    const World::Record& World::record(const Entity entity) const
+    {
+        if (!isAlive(entity))
+        {
+            throw std::runtime_error(std::format(
+                "Entity {}:{} is not alive", entity.index, entity.generation));
+        }
+        return m_records[entity.index];
+    }
+
+    void World::requireStructuralChange() const
+    {
+        if (m_iterations.load(std::memory_order_relaxed) != 0)
+        {
+            throw std::runtime_error(
+                "Entities cannot change while the world is iterated; record the changes in a "
+                "CommandBuffer");
+        }
+    }
+
+    Archetype& World::archetype(const ComponentMask mask)
+    {
+        const auto it = m_archetypesByMask.find(mask);
+        if (it != m_archetypesByMask.end())
+        {
+            return *it->second;
+        }
+        Archetype& created = *m_archetypes.emplace_back(std::make_unique<Archetype>(mask));
+        m_archetypesByMask.emplace(mask, &created);
+        return created;
+    }
+
+    void World::moveEntity(const Entity entity, Archetype& target)
+    {
+        Record&                   entry = m_records[entity.index];
+        Archetype&                source = *entry.archetype;
+        const Archetype::Location location = target.pushRow(entity);
+        for (const ComponentId component : target.m_componentIds)
+        {
+            if ((source.mask() & ComponentMask { 1 } << component) != 0)
+            {
+                std::memcpy(target.component(location, component),
+                    source.component(entry.location, component), target.m_sizes[component]);
+            }
+        }
+
+        const Entity moved = source.removeRow(entry.location);
+        if (moved.index != Entity {}.index)
+        {
+            m_records[moved.index].location = entry.location;
+        }
+        entry.archetype = &target;
+        entry.location = location;
+    }
+} // namespace Ecs
@@ -0,0 +1,414 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+namespace Ecs
+{
+    using ComponentId = uint32_t;
+
+    /// One bit per component type.
+    using ComponentMask = uint64_t;
+
+    inline constexpr size_t g_maxComponents = 64;
+
+    /// Bytes per chunk of an archetype; a chunk holds as many entities as fit.
+    inline constexpr size_t g_chunkBytes = 16 * 1024;
+
+    struct Entity
+    {
+        uint32_t index = std::numeric_limits<uint32_t>::max();
+        uint32_t generation = 0; ///< Bumped when the index is reused.
+
+        friend bool operator==(const Entity&, const Entity&) = default;
+    };
+
+    /// @brief Registers a component type; componentId calls it once per type.
+    /// @throws std::runtime_error past g_maxComponents types.
+    [[nodiscard]] ComponentId registerComponent(size_t size);
+
+    [[nodiscard]] size_t componentSize(ComponentId component);
+
+    /// @brief Returns the id of a component type, registering it on first use. A
+    /// const type has the same id as the type.
+    template <typename T>
+    [[nodiscard]] ComponentId componentId()
+    {
+        if constexpr (std::is_const_v<T> || std::is_volatile_v<T>)
+        {
+            return componentId<std::remove_cv_t<T>>();
+        }
+        else
+        {
+            static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+                "Components are moved between chunks with memcpy and never destroyed");
+            static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                "Chunks only guarantee the default new alignment");
+            static const ComponentId s_id = registerComponent(sizeof(T));
+            return s_id;
+        }
+    }
+
+    template <typename... Ts>
+    [[nodiscard]] ComponentMask componentMask()
+    {
+        return (ComponentMask { 0 } | ... | (ComponentMask { 1 } << componentId<Ts>()));
+    }
+
+    /// @brief Entities that have exactly the same components.
+    ///
+    /// Entities are stored in fixed size chunks holding one array per component, so
+    /// iterating a component reads memory in order. Removal moves the last entity
+    /// into the hole, which keeps every chunk but the last full.
+    class Archetype
+    {
+    public:
+        /// @throws std::runtime_error if one entity does not fit in a chunk.
+        explicit Archetype(ComponentMask mask);
+
+        [[nodiscard]] ComponentMask mask() const;
+
+        [[nodiscard]] uint32_t chunkCapacity() const;
+
+        [[nodiscard]] size_t entityCount() const;
+
+        [[nodiscard]] size_t chunkCount() const;
+
+        [[nodiscard]] std::span<const Entity> entities(size_t chunk) const;
+
+        /// @brief Returns the array of a component in a chunk. T may be const; the
+        /// archetype must have the component.
+        template <typename T>
+        [[nodiscard]] T* components(const size_t chunk) const
+        {
+            return std::launder(reinterpret_cast<T*>(
+                m_chunks[chunk].memory.get() + m_offsets[componentId<T>()]));
+        }
+
+    private:
+        friend class World;
+
+        struct Chunk
+        {
+            std::unique_ptr<std::byte[]> memory;
+            uint32_t                     count = 0;
+        };
+
+        struct Location
+        {
+            uint32_t chunk = 0;
+            uint32_t row = 0;
+        };
+
+        [[nodiscard]] std::byte* component(Location location, ComponentId component) const;
+
+        /// Appends an entity whose components are zeroed.
+        [[nodiscard]] Location pushRow(Entity entity);
+
+        /// Moves the last entity into the location, returning it, or a default
+        /// Entity when the location was the last one.
+        Entity removeRow(Location location);
+
+        ComponentMask                           m_mask = 0;
+        uint32_t                                m_capacity = 0;
+        size_t                                  m_entityCount = 0;
+        std::vector<ComponentId>                m_componentIds;
+        std::array<uint32_t, g_maxComponents>   m_offsets {}; ///< Of each array in a chunk.
+        std::array<uint32_t, g_maxComponents>   m_sizes {};
+        std::vector<Chunk>                      m_chunks;
+        std::array<Archetype*, g_maxComponents> m_addEdges {}; ///< Cached transitions.
+        std::array<Archetype*, g_maxComponents> m_removeEdges {};
+    };
+
+    /// @brief Structural changes recorded while the world is iterated, and applied
+    /// in order by World::apply. Recording is thread safe.
+    class CommandBuffer
+    {
+    public:
+        /// @brief An entity to be created; World::apply returns the real handles.
+        struct PendingEntity
+        {
+            uint32_t index = 0;
+        };
+
+        [[nodiscard]] PendingEntity create();
+
+        void destroy(Entity entity);
+
+        template <typename T>
+        void add(const Entity entity, const T& component)
+        {
+            record({ .operation = Operation::Add,
+                       .component = componentId<T>(),
+                       .index = entity.index,
+                       .generation = entity.generation },
+                &component, sizeof(T));
+        }
+
+        template <typename T>
+        void add(const PendingEntity entity, const T& component)
+        {
+            record({ .operation = Operation::Add,
+                       .pending = true,
+                       .component = componentId<T>(),
+                       .index = entity.index },
+                &component, sizeof(T));
+        }
+
+        template <typename T>
+        void remove(const Entity entity)
+        {
+            record({ .operation = Operation::Remove,
+                       .component = componentId<T>(),
+                       .index = entity.index,
+                       .generation = entity.generation },
+                nullptr, 0);
+        }
+
+        [[nodiscard]] bool empty() const;
+
+        void clear();
+
+    private:
+        friend class World;
+
+        enum class Operation : uint8_t
+        {
+            Create,
+            Destroy,
+            Add,
+            Remove,
+        };
+
+        struct Command
+        {
+            Operation   operation = Operation::Create;
+            bool        pending = false; ///< index is a PendingEntity.
+            ComponentId component = 0;
+            uint32_t    index = 0;
+            uint32_t    generation = 0;
+            uint32_t    dataOffset = 0;
+        };
+
+        void record(Command command, const void* data, size_t size);
+
+        mutable std::mutex     m_mutex;
+        std::vector<Command>   m_commands;
+        std::vector<std::byte> m_data;
+        uint32_t               m_pendingCount = 0;
+    };
+
+    /// @brief Entities and their components, grouped into archetypes.
+    ///
+    /// Components must be trivially copyable. Structural changes (creating and
+    /// destroying entities, adding and removing components) move entities between
+    /// archetypes and are rejected while the world is being iterated; record them
+    /// in a CommandBuffer instead.
+    class World
+    {
+    public:
+        World();
+
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        template <typename... Ts>
+        Entity create(const Ts&... components)
+        {
+            const Entity entity = createEntity(componentMask<Ts...>());
+            (copyComponent(entity, componentId<Ts>(), &components), ...);
+            return entity;
+        }
+
+        /// @throws std::runtime_error if the entity is not alive.
+        void destroy(Entity entity);
+
+        [[nodiscard]] bool isAlive(Entity entity) const;
+
+        /// @brief Adds a component, or overwrites it if the entity has one.
+        template <typename T>
+        void add(const Entity entity, const T& component)
+        {
+            setComponent(entity, componentId<T>(), &component);
+        }
+
+        /// @brief Removes a component; does nothing if the entity has none.
+        template <typename T>
+        void remove(const Entity entity)
+        {
+            removeComponent(entity, componentId<T>());
+        }
+
+        template <typename T>
+        [[nodiscard]] bool has(const Entity entity) const
+        {
+            return (mask(entity) & componentMask<T>()) != 0;
+        }
+
+        /// @brief Returns the component, or nullptr if the entity has none. The
+        /// pointer is valid until the next structural change.
+        template <typename T>
+        [[nodiscard]] T* get(const Entity entity) const
+        {
+            return std::launder(reinterpret_cast<T*>(component(entity, componentId<T>())));
+        }
+
+        [[nodiscard]] size_t entityCount() const;
+
+        [[nodiscard]] size_t archetypeCount() const;
+
+        /// @brief Calls function(entities, Ts*...) for every chunk of every archetype
+        /// with the components, passing the chunk's arrays.
+        template <typename... Ts, typename TFunction>
+        void forEachChunk(const TFunction& function) const
+        {
+            const IterationScope scope(*this);
+            const ComponentMask  required = componentMask<Ts...>();
+            for (const auto& archetype : m_archetypes)
+            {
+                if ((archetype->mask() & required) != required)
+                {
+                    continue;
+                }
+                for (size_t chunk = 0; chunk < archetype->chunkCount(); chunk++)
+                {
+                    function(archetype->entities(chunk), archetype->components<Ts>(chunk)...);
+                }
+            }
+        }
+
+        /// @brief Calls function(Ts&...) for every entity with the components.
+        template <typename... Ts, typename TFunction>
+        void forEach(const TFunction& function) const
+        {
+            forEachChunk<Ts...>([&](const std::span<const Entity> entities, Ts*... components) {
+                for (size_t i = 0; i < entities.size(); i++)
+                {
+                    function(components[i]...);
+                }
+            });
+        }
+
+        /// @brief Like forEachChunk, with the chunks spread across the pool.
+        template <typename... Ts, typename TFunction>
+        void parallelForEachChunk(ThreadPool& threadPool, const TFunction& function) const
+        {
+            const IterationScope scope(*this);
+            const ComponentMask  required = componentMask<Ts...>();
+            std::vector<std::pair<const Archetype*, size_t>> chunks;
+            for (const auto& archetype : m_archetypes)
+            {
+                if ((archetype->mask() & required) == required)
+                {
+                    for (size_t chunk = 0; chunk < archetype->chunkCount(); chunk++)
+                    {
+                        chunks.emplace_back(archetype.get(), chunk);
+                    }
+                }
+            }
+            threadPool.parallelFor(chunks.size(), 1, [&](const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; i++)
+                {
+                    const auto [archetype, chunk] = chunks[i];
+                    function(archetype->entities(chunk), archetype->components<Ts>(chunk)...);
+                }
+            });
+        }
+
+        /// @brief Like forEach, with the chunks spread across the pool.
+        template <typename... Ts, typename TFunction>
+        void parallelForEach(ThreadPool& threadPool, const TFunction& function) const
+        {
+            parallelForEachChunk<Ts...>(
+                threadPool, [&](const std::span<const Entity> entities, Ts*... components) {
+                    for (size_t i = 0; i < entities.size(); i++)
+                    {
+                        function(components[i]...);
+                    }
+                });
+        }
+
+        /// @brief Applies and clears recorded changes, in the order they were
+        /// recorded. Changes to entities that are no longer alive are skipped.
+        /// @return The created entities, indexed by CommandBuffer::PendingEntity.
+        std::vector<Entity> apply(CommandBuffer& commands);
+
+    private:
+        /// Marks the world as iterated, which rejects structural changes.
+        class IterationScope
+        {
+        public:
+            explicit IterationScope(const World& world)
+                : m_world(world)
+            {
+                m_world.m_iterations.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            ~IterationScope()
+            {
+                m_world.m_iterations.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            IterationScope(const IterationScope&) = delete;
+            IterationScope& operator=(const IterationScope&) = delete;
+
+        private:
+            const World& m_world;
+        };
+
+        struct Record
+        {
+            Archetype*          archetype = nullptr;
+            Archetype::Location location;
+            uint32_t            generation = 0;
+        };
+
+        [[nodiscard]] Entity createEntity(ComponentMask mask);
+
+        /// Copies into a component the entity is known to have.
+        void copyComponent(Entity entity, ComponentId component, const void* data);
+
+        void setComponent(Entity entity, ComponentId component, const void* data);
+
+        void removeComponent(Entity entity, ComponentId component);
+
+        [[nodiscard]] std::byte* component(Entity entity, ComponentId component) const;
+
+        [[nodiscard]] ComponentMask mask(Entity entity) const;
+
+        /// @throws std::runtime_error if the entity is not alive.
+        [[nodiscard]] const Record& record(Entity entity) const;
+
+        /// @throws std::runtime_error while the world is iterated.
+        void requireStructuralChange() const;
+
+        [[nodiscard]] Archetype& archetype(ComponentMask mask);
+
+        void moveEntity(Entity entity, Archetype& target);
+
+        std::vector<std::unique_ptr<Archetype>>       m_archetypes;
+        std::unordered_map<ComponentMask, Archetype*> m_archetypesByMask;
+        std::vector<Record>                           m_records; ///< By entity index.
+        std::vector<uint32_t>                         m_freeIndices;
+        size_t                                        m_entityCount = 0;
+        mutable std::atomic<uint32_t>                 m_iterations = 0;
+    };
+} // namespace Ecs
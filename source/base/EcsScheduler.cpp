@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "EcsScheduler.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+
+namespace Ecs
+{
+    bool Access::conflicts(const Access& other) const
+    {
+        return (writes & (other.reads | other.writes)) != 0 || (other.writes & reads) != 0;
+    }
+
+    SystemContext::SystemContext(
+        const World& world, ThreadPool& threadPool, CommandBuffer& commands, const Access access)
+        : m_world(world)
+        , m_threadPool(threadPool)
+        , m_commands(commands)
+        , m_access(access)
+    {
+    }
+
+    ThreadPool& SystemContext::threadPool() const
+    {
+        return m_threadPool;
+    }
+
+    CommandBuffer& SystemContext::commands() const
+    {
+        return m_commands;
+    }
+
+    void Scheduler::add(std::string name, const Access& access, System system)
+    {
+        size_t stage = 0;
+        for (const auto& entry : m_systems)
+        {
+            if (entry.access.conflicts(access))
+            {
+                stage = std::max(stage, entry.stage + 1);
+            }
+        }
+
+        if (stage == m_stages.size())
+        {
+            m_stages.emplace_back();
+        }
+        m_stages[stage].push_back(m_systems.size());
+        m_systems.push_back({ .name = std::move(name),
+            .access = access,
+            .system = std::move(system),
+            .commands = std::make_unique<CommandBuffer>(),
+            .stage = stage });
+    }
+
+    void Scheduler::run(World& world, ThreadPool& threadPool)
+    {
+        for (const auto& stage : m_stages)
+        {
+            std::exception_ptr error;
+            std::mutex         errorMutex;
+            threadPool.parallelFor(stage.size(), 1, [&](const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; i++)
+                {
+                    const Entry& entry = m_systems[stage[i]];
+                    try
+                    {
+                        entry.system(
+                            SystemContext(world, threadPool, *entry.commands, entry.access));
+                    }
+                    catch (...)
+                    {
+                        const std::lock_guard lock(errorMutex);
+                        if (!error)
+                        {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+            });
+            if (error)
+            {
+                for (const auto& entry : m_systems)
+                {
+                    entry.commands->clear();
+                }
+                std::rethrow_exception(error);
+            }
+        }
+
+        for (const auto& entry : m_systems)
+        {
+            static_cast<void>(world.apply(*entry.commands));
+        }
+    }
+
+    size_t Scheduler::stageCount() const
+    {
+        return m_stages.size();
+    }
+
+    std::vector<std::string_view> Scheduler::stage(const size_t index) const
+    {
+        std::vector<std::string_view> names;
+        for (const size_t system : m_stages.at(index))
+        {
+            names.emplace_back(m_systems[system].name);
+        }
+        return names;
+    }
+} // namespace Ecs
@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <format>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "Ecs.hpp"
+
+namespace Ecs
+{
+    /// @brief Components a system reads and writes.
+    struct Access
+    {
+        ComponentMask reads = 0;
+        ComponentMask writes = 0;
+
+        template <typename... Ts>
+        Access& read()
+        {
+            reads |= componentMask<Ts...>();
+            return *this;
+        }
+
+        template <typename... Ts>
+        Access& write()
+        {
+            writes |= componentMask<Ts...>();
+            return *this;
+        }
+
+        /// @brief Two systems conflict when one writes a component the other uses.
+        [[nodiscard]] bool conflicts(const Access& other) const;
+    };
+
+    /// @brief What a running system may touch: queries limited to its declared
+    /// access, the pool, and a command buffer for structural changes.
+    class SystemContext
+    {
+    public:
+        SystemContext(
+            const World& world, ThreadPool& threadPool, CommandBuffer& commands, Access access);
+
+        /// @brief Queried types declared const need read access, others write access.
+        template <typename... Ts, typename TFunction>
+        void forEach(const TFunction& function) const
+        {
+            (require<Ts>(), ...);
+            m_world.forEach<Ts...>(function);
+        }
+
+        template <typename... Ts, typename TFunction>
+        void forEachChunk(const TFunction& function) const
+        {
+            (require<Ts>(), ...);
+            m_world.forEachChunk<Ts...>(function);
+        }
+
+        template <typename... Ts, typename TFunction>
+        void parallelForEach(const TFunction& function) const
+        {
+            (require<Ts>(), ...);
+            m_world.parallelForEach<Ts...>(m_threadPool, function);
+        }
+
+        template <typename T>
+        [[nodiscard]] T* get(const Entity entity) const
+        {
+            require<T>();
+            return m_world.get<T>(entity);
+        }
+
+        [[nodiscard]] ThreadPool& threadPool() const;
+
+        [[nodiscard]] CommandBuffer& commands() const;
+
+    private:
+        /// @throws std::runtime_error if the system did not declare the access.
+        template <typename T>
+        void require() const
+        {
+            const ComponentMask component = componentMask<T>();
+            const ComponentMask allowed
+                = std::is_const_v<T> ? m_access.reads | m_access.writes : m_access.writes;
+            if ((allowed & component) == 0)
+            {
+                throw std::runtime_error(
+                    std::format("System did not declare {} access to component {}",
+                        std::is_const_v<T> ? "read" : "write", componentId<T>()));
+            }
+        }
+
+        const World&   m_world;
+        ThreadPool&    m_threadPool;
+        CommandBuffer& m_commands;
+        Access         m_access;
+    };
+
+    using System = std::function<void(const SystemContext&)>;
+
+    /// @brief Runs systems in parallel where their component access allows.
+    ///
+    /// Systems run in the order they were added unless they do not conflict: each
+    /// system is placed in the stage after the last earlier system it conflicts
+    /// with, and the systems of a stage run concurrently. Structural changes are
+    /// recorded in per system command buffers and applied after all stages, in the
+    /// order the systems were added.
+    class Scheduler
+    {
+    public:
+        void add(std::string name, const Access& access, System system);
+
+        /// @throws Rethrows the first exception a system threw, once its stage is done.
+        void run(World& world, ThreadPool& threadPool);
+
+        [[nodiscard]] size_t stageCount() const;
+
+        /// @brief Names of the systems of a stage, for diagnostics.
+        [[nodiscard]] std::vector<std::string_view> stage(size_t index) const;
+
+    private:
+        struct Entry
+        {
+            std::string                    name;
+            Access                         access;
+            System                         system;
+            std::unique_ptr<CommandBuffer> commands;
+            size_t                         stage = 0;
+        };
+
+        std::vector<Entry>               m_systems;
+        std::vector<std::vector<size_t>> m_stages; ///< Indices of m_systems.
+    };
+} // namespace Ecs
@@ -9,7 +9,10 @@
 #include <fmt/core.h>
 
 #include <filesystem>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
+#include <ranges>
 
 #include "imgui.h"
 #include "imgui_impl_metal.h"
@@ -75,17 +78,37 @@ Example::Example(const char* title, int32_t width, int32_t height)
     m_commandQueue = NS::TransferPtr(m_device->newMTL4CommandQueue());
     m_commandBuffer = NS::TransferPtr(m_device->newCommandBuffer());
 
-    for (uint32_t i = 0; i < s_bufferCount; i++)
+    for (uint32_t i = 0; i < s_maxBufferCount; i++)
     {
         m_commandAllocator[i] = NS::TransferPtr(m_device->newCommandAllocator());
     }
 
+    m_parallelEncoder = std::make_unique<CommandEncoder>(
+        CommandEncoder::Backend {
+            .createAllocator = [this] { return NS::TransferPtr(m_device->newCommandAllocator()); },
+            .resetAllocator = [](NS::SharedPtr<MTL4::CommandAllocator>& allocator) {
+                allocator->reset();
+            },
+            .createCommandBuffer = [this] { return NS::TransferPtr(m_device->newCommandBuffer()); },
+            .beginCommandBuffer =
+                [](NS::SharedPtr<MTL4::CommandBuffer>&    commandBuffer,
+                    NS::SharedPtr<MTL4::CommandAllocator>& allocator) {
+                    commandBuffer->beginCommandBuffer(allocator.get());
+                },
+            .endCommandBuffer = [](NS::SharedPtr<MTL4::CommandBuffer>& commandBuffer) {
+                commandBuffer->endCommandBuffer();
+            },
+        },
+        s_maxBufferCount);
+
+    // The event counts completed frames: frame n signals n + 1 once it is done.
     m_sharedEvent = NS::TransferPtr(m_device->newSharedEvent());
-    m_sharedEvent->setSignaledValue(m_frameNumber);
-    m_currentFrameIndex = 0;
+    m_sharedEvent->setSignaledValue(m_frameLoop.frameNumber());
 
     createFrameResources(windowWidth(), windowHeight());
 
+    createUploadRing();
+
     // Create a depth stencil state
     const NS::SharedPtr<MTL::DepthStencilDescriptor> depthStencilDescriptor
         = NS::TransferPtr(MTL::DepthStencilDescriptor::alloc()->init());
@@ -96,14 +119,15 @@ Example::Example(const char* title, int32_t width, int32_t height)
         = NS::TransferPtr(m_device->newDepthStencilState(depthStencilDescriptor.get()));
 
     // Load shader Library
-    // TODO: Showcase how to use Metal archives to erase compilation
     m_shaderLibrary = NS::TransferPtr(m_device->newDefaultLibrary());
 
+    createPipelineCache();
+
     m_keyboard = std::make_unique<Keyboard>();
     m_mouse = std::make_unique<Mouse>(m_window.get());
 
-    m_timer.setFixedTimeStep(false);
-    m_timer.resetElapsedTime();
+    m_frameLoop.setFramesInFlight(s_defaultFramesInFlight);
+    m_frameLoop.resetTimer();
 
     m_displayLink = NS::TransferPtr(CA::MetalDisplayLink::alloc()->init(layer));
     // Enable 120HZ refresh for devices that support Pro Motion
@@ -113,6 +137,10 @@ Example::Example(const char* title, int32_t width, int32_t height)
 
 Example::~Example()
 {
+    // Finish background compilations before their results are archived
+    m_pipelineCompiler.reset();
+    savePipelineCache();
+
     // Cleanup
     ImGui_ImplMetal_Shutdown();
     ImGui_ImplSDL3_Shutdown();
@@ -128,29 +156,378 @@ void Example::createFrameResources(const int32_t width, const int32_t height)
     m_msaaTexture.reset();
     m_depthStencilTexture.reset();
 
-    // Create a multisample texture
-    const NS::SharedPtr<MTL::TextureDescriptor> msaaTextureDescriptor
-        = NS::RetainPtr(MTL::TextureDescriptor::texture2DDescriptor(
-            MTL::PixelFormatBGRA8Unorm_sRGB, width, height, false));
-    msaaTextureDescriptor->setTextureType(MTL::TextureType2DMultisample);
-    msaaTextureDescriptor->setSampleCount(s_multisampleCount); // Set sample count for MSAA
-    msaaTextureDescriptor->setUsage(MTL::TextureUsageRenderTarget);
-    msaaTextureDescriptor->setStorageMode(MTL::StorageModePrivate);
+    // The frame's attachments are frame graph textures. The multisample target is
+    // placed in a heap the graph sizes, so transient targets added later, e.g.
+    // shadow maps or post-processing, alias its memory when their uses do not
+    // overlap. The memoryless depth target never takes heap memory.
+    const Render::TextureDesc attachment { .width = static_cast<uint32_t>(width),
+        .height = static_cast<uint32_t>(height),
+        .format = static_cast<uint32_t>(MTL::PixelFormatBGRA8Unorm_sRGB),
+        .sampleCount = s_multisampleCount };
+    m_frameGraph.clear();
+    const auto drawable = m_frameGraph.importTexture("Drawable",
+        { .width = attachment.width,
+            .height = attachment.height,
+            .format = static_cast<uint32_t>(s_defaultPixelFormat) },
+        Render::ResourceAccess::None, Render::ResourceAccess::Present);
+    const auto msaa = m_frameGraph.createTexture("MSAA", attachment);
+    auto       depthStencil = attachment;
+    depthStencil.format = static_cast<uint32_t>(MTL::PixelFormatDepth32Float_Stencil8);
+    depthStencil.memoryless = true;
+    const auto depth = m_frameGraph.createTexture("Depth Stencil", depthStencil);
+    m_frameGraph.addPass("Main")
+        .write(msaa)
+        .write(depth, Render::ResourceAccess::DepthStencil)
+        .write(drawable);
+    m_frameGraph.compile([this](const Render::TextureDesc& desc) {
+        const auto [size, align]
+            = m_device->heapTextureSizeAndAlign(createTextureDescriptor(desc).get());
+        return Render::MemoryRequirements { .size = size, .alignment = align };
+    });
+
+    // Metal textures have no layouts, so the transitions the graph lists need no
+    // commands: the pass's load and store actions and presenting the drawable carry
+    // them out. Aliasing would need barriers between passes, which the examples
+    // encode themselves, so it is rejected until there is more than one pass.
+    if (m_frameGraph.statistics().aliasingBarriers != 0)
+    {
+        throw std::runtime_error("Frame graph textures alias, which needs barriers between passes");
+    }
+
+    const NS::SharedPtr<MTL::HeapDescriptor> heapDescriptor
+        = NS::TransferPtr(MTL::HeapDescriptor::alloc()->init());
+    heapDescriptor->setType(MTL::HeapTypePlacement);
+    heapDescriptor->setStorageMode(MTL::StorageModePrivate);
+    heapDescriptor->setSize(m_frameGraph.heapSize());
 
-    m_msaaTexture = NS::TransferPtr(m_device->newTexture(msaaTextureDescriptor.get()));
+    if (!m_frameResidencySet)
+    {
+        NS::Error*                                       error = nullptr;
+        const NS::SharedPtr<MTL::ResidencySetDescriptor> residencySetDescriptor
+            = NS::TransferPtr(MTL::ResidencySetDescriptor::alloc()->init());
+        m_frameResidencySet
+            = NS::TransferPtr(m_device->newResidencySet(residencySetDescriptor.get(), &error));
+        if (error != nullptr)
+        {
+            throw std::runtime_error(fmt::format("Failed to create frame residency set: {}",
+                error->localizedFailureReason()->utf8String()));
+        }
+        m_commandQueue->addResidencySet(m_frameResidencySet.get());
+    }
+    if (m_transientHeap)
+    {
+        m_frameResidencySet->removeAllocation(m_transientHeap.get());
+    }
+    m_transientHeap = NS::TransferPtr(m_device->newHeap(heapDescriptor.get()));
+    m_transientHeap->setLabel(NS::String::string("Transient Targets", NS::ASCIIStringEncoding));
+    m_frameResidencySet->addAllocation(m_transientHeap.get());
+    m_frameResidencySet->commit();
+
+    m_msaaTexture = NS::TransferPtr(m_transientHeap->newTexture(
+        createTextureDescriptor(m_frameGraph.textureDesc(msaa)).get(),
+        m_frameGraph.heapOffset(msaa)));
+    m_depthStencilTexture = NS::TransferPtr(
+        m_device->newTexture(createTextureDescriptor(m_frameGraph.textureDesc(depth)).get()));
+
+    // Built once per attachment size; each frame only sets the drawable to resolve into
+    m_renderPassDescriptor = NS::TransferPtr(MTL4::RenderPassDescriptor::alloc()->init());
+    auto* colorAttachment = m_renderPassDescriptor->colorAttachments()->object(0);
+    colorAttachment->setTexture(m_msaaTexture.get());
+    colorAttachment->setLoadAction(MTL::LoadActionClear);
+    colorAttachment->setStoreAction(MTL::StoreActionMultisampleResolve);
+    colorAttachment->setClearColor(
+        MTL::ClearColor(DirectX::Colors::CornflowerBlue.f[0], DirectX::Colors::CornflowerBlue.f[1],
+            DirectX::Colors::CornflowerBlue.f[2], 1.0));
+    m_renderPassDescriptor->depthAttachment()->setTexture(m_depthStencilTexture.get());
+    m_renderPassDescriptor->depthAttachment()->setLoadAction(MTL::LoadActionClear);
+    m_renderPassDescriptor->depthAttachment()->setStoreAction(MTL::StoreActionDontCare);
+    m_renderPassDescriptor->depthAttachment()->setClearDepth(1.0);
+    m_renderPassDescriptor->stencilAttachment()->setTexture(m_depthStencilTexture.get());
+    m_renderPassDescriptor->stencilAttachment()->setLoadAction(MTL::LoadActionClear);
+    m_renderPassDescriptor->stencilAttachment()->setStoreAction(MTL::StoreActionDontCare);
+    m_renderPassDescriptor->stencilAttachment()->setClearStencil(0);
+}
 
-    // Create a depth stencil texture
-    const NS::SharedPtr<MTL::TextureDescriptor> textureDescriptor
+NS::SharedPtr<MTL::TextureDescriptor> Example::createTextureDescriptor(
+    const Render::TextureDesc& desc)
+{
+    const NS::SharedPtr<MTL::TextureDescriptor> descriptor
         = NS::RetainPtr(MTL::TextureDescriptor::texture2DDescriptor(
-            MTL::PixelFormatDepth32Float_Stencil8, width, height, false));
-    textureDescriptor->setTextureType(MTL::TextureType2DMultisample);
-    textureDescriptor->setSampleCount(s_multisampleCount);
-    textureDescriptor->setUsage(MTL::TextureUsageRenderTarget);
-    textureDescriptor->setResourceOptions(
-        MTL::ResourceCPUCacheModeDefaultCache | MTL::ResourceStorageModePrivate);
-    textureDescriptor->setStorageMode(MTL::StorageModeMemoryless);
+            static_cast<MTL::PixelFormat>(desc.format), desc.width, desc.height, false));
+    if (desc.sampleCount > 1)
+    {
+        descriptor->setTextureType(MTL::TextureType2DMultisample);
+        descriptor->setSampleCount(desc.sampleCount);
+    }
+    descriptor->setUsage(MTL::TextureUsageRenderTarget);
+    descriptor->setStorageMode(
+        desc.memoryless ? MTL::StorageModeMemoryless : MTL::StorageModePrivate);
+    return descriptor;
+}
+
+void Example::createUploadRing()
+{
+    m_uploadBuffer = NS::TransferPtr(m_device->newBuffer(s_uploadRingSize,
+        MTL::ResourceStorageModeShared | MTL::ResourceCPUCacheModeWriteCombined));
+    m_uploadBuffer->setLabel(NS::String::string("Upload Ring", NS::ASCIIStringEncoding));
+
+    m_uploadRing = std::make_unique<UploadRing>(
+        static_cast<std::byte*>(m_uploadBuffer->contents()), m_uploadBuffer->length());
+
+    NS::Error*                                 error = nullptr;
+    NS::SharedPtr<MTL::ResidencySetDescriptor> residencySetDescriptor
+        = NS::TransferPtr(MTL::ResidencySetDescriptor::alloc()->init());
+    m_uploadResidencySet
+        = NS::TransferPtr(m_device->newResidencySet(residencySetDescriptor.get(), &error));
+    if (error != nullptr)
+    {
+        throw std::runtime_error(fmt::format("Failed to create upload residency set: {}",
+            error->localizedFailureReason()->utf8String()));
+    }
+    m_uploadResidencySet->addAllocation(m_uploadBuffer.get());
+    m_uploadResidencySet->commit();
+    m_commandQueue->addResidencySet(m_uploadResidencySet.get());
+}
+
+void Example::createPipelineCache()
+{
+    NS::Error* error = nullptr;
+
+    // Capture the binaries of every pipeline compiled in this run, so they can be
+    // written out as an archive on exit
+    NS::SharedPtr<MTL4::PipelineDataSetSerializerDescriptor> serializerDescriptor
+        = NS::TransferPtr(MTL4::PipelineDataSetSerializerDescriptor::alloc()->init());
+    serializerDescriptor->setConfiguration(
+        MTL4::PipelineDataSetSerializerConfigurationCaptureBinaries);
+    m_pipelineSerializer
+        = NS::TransferPtr(m_device->newPipelineDataSetSerializer(serializerDescriptor.get()));
+
+    NS::SharedPtr<MTL4::CompilerDescriptor> compilerDescriptor
+        = NS::TransferPtr(MTL4::CompilerDescriptor::alloc()->init());
+    compilerDescriptor->setPipelineDataSetSerializer(m_pipelineSerializer.get());
+    m_compiler = NS::TransferPtr(m_device->newCompiler(compilerDescriptor.get(), &error));
+    if (error != nullptr)
+    {
+        throw std::runtime_error(fmt::format("Failed to create shader compiler: {}",
+            error->localizedFailureReason()->utf8String()));
+    }
+
+    m_pipelineCompiler = std::make_unique<RenderPipelineCompiler>(
+        [this](const PipelineDescription& description) {
+            try
+            {
+                return NS::RetainPtr(renderPipelineState(description));
+            }
+            catch (const std::exception& e)
+            {
+                // Nothing waits on background compilations, so report failures here
+                fmt::print(stderr, "{}\n", e.what());
+                throw;
+            }
+        });
+
+    // Archived binaries are only valid for the device and OS that produced them
+    m_pipelineManifest = PipelineCacheManifest(fmt::format("{} {}",
+        m_device->name()->utf8String(),
+        NS::ProcessInfo::processInfo()->operatingSystemVersionString()->utf8String()));
+
+    char* prefPath = SDL_GetPrefPath("MetalExamples", SDL_GetWindowTitle(m_window.get()));
+    if (prefPath == nullptr)
+    {
+        // Without a writable location pipelines are only cached in memory
+        return;
+    }
+    m_pipelineCacheDirectory = prefPath;
+    SDL_free(prefPath);
+
+    const auto archivePath = m_pipelineCacheDirectory / "pipelines.mtl4archive";
+    if (!m_pipelineManifest.load(m_pipelineCacheDirectory / "pipelines.manifest")
+        || !std::filesystem::exists(archivePath))
+    {
+        m_pipelineManifest = PipelineCacheManifest(m_pipelineManifest.compatibilityTag());
+        return;
+    }
+
+    const NS::SharedPtr<NS::URL> archiveUrl = NS::RetainPtr(NS::URL::fileURLWithPath(
+        NS::String::string(archivePath.c_str(), NS::UTF8StringEncoding)));
+    m_pipelineArchive = NS::TransferPtr(m_device->newArchive(archiveUrl.get(), &error));
+    if (error != nullptr)
+    {
+        fmt::print(stderr, "Ignoring pipeline archive {}: {}\n", archivePath.string(),
+            error->localizedDescription()->utf8String());
+        m_pipelineArchive.reset();
+        m_pipelineManifest = PipelineCacheManifest(m_pipelineManifest.compatibilityTag());
+    }
+}
+
+void Example::savePipelineCache()
+{
+    if (!m_pipelineCacheDirty || m_pipelineCacheDirectory.empty())
+    {
+        return;
+    }
+
+    try
+    {
+        // The serializer only holds pipelines compiled in this run. Compile the archived
+        // ones that went unused too (served from the old archive), so none are dropped.
+        const std::vector<PipelineDescription> descriptions = m_pipelineManifest.descriptions();
+        for (const auto& description : descriptions)
+        {
+            [[maybe_unused]] const auto* pipeline = renderPipelineState(description);
+        }
+
+        auto temporaryPath = m_pipelineCacheDirectory / "pipelines.mtl4archive";
+        temporaryPath += ".tmp";
+        const NS::SharedPtr<NS::URL> temporaryUrl = NS::RetainPtr(NS::URL::fileURLWithPath(
+            NS::String::string(temporaryPath.c_str(), NS::UTF8StringEncoding)));
+
+        NS::Error* error = nullptr;
+        if (!m_pipelineSerializer->serializeAsArchiveAndFlushToURL(temporaryUrl.get(), &error))
+        {
+            throw std::runtime_error(fmt::format("Failed to serialize pipeline archive: {}",
+                error->localizedFailureReason()->utf8String()));
+        }
+
+        m_pipelineArchive.reset();
+        std::filesystem::rename(temporaryPath, m_pipelineCacheDirectory / "pipelines.mtl4archive");
+        m_pipelineManifest.save(m_pipelineCacheDirectory / "pipelines.manifest");
+        m_pipelineCacheDirty = false;
+    }
+    catch (const std::exception& e)
+    {
+        // Failing to persist the cache only costs compile time on the next run
+        fmt::print(stderr, "Failed to save pipeline cache: {}\n", e.what());
+    }
+}
+
+MTL::RenderPipelineState* Example::renderPipelineState(const PipelineDescription& description)
+{
+    const PipelineKey key = description.key();
+    return m_pipelineCache
+        .getOrCreate(key, [&] { return compileRenderPipeline(key, description); })
+        .get();
+}
 
-    m_depthStencilTexture = NS::TransferPtr(m_device->newTexture(textureDescriptor.get()));
+Example::RenderPipelineHandle Example::requestRenderPipeline(
+    const PipelineDescription& description, const PipelinePriority priority)
+{
+    return m_pipelineCompiler->request(description, priority);
+}
+
+NS::SharedPtr<MTL::RenderPipelineState> Example::compileRenderPipeline(
+    const PipelineKey& key, const PipelineDescription& description)
+{
+    NS::SharedPtr<MTL::VertexDescriptor> vertexDescriptor
+        = NS::TransferPtr(MTL::VertexDescriptor::alloc()->init());
+    for (const auto& attribute : description.vertexAttributes)
+    {
+        MTL::VertexAttributeDescriptor* attributeDescriptor
+            = vertexDescriptor->attributes()->object(attribute.index);
+        attributeDescriptor->setFormat(static_cast<MTL::VertexFormat>(attribute.format));
+        attributeDescriptor->setOffset(attribute.offset);
+        attributeDescriptor->setBufferIndex(attribute.bufferIndex);
+    }
+    for (const auto& layout : description.vertexLayouts)
+    {
+        MTL::VertexBufferLayoutDescriptor* layoutDescriptor
+            = vertexDescriptor->layouts()->object(layout.bufferIndex);
+        layoutDescriptor->setStride(layout.stride);
+        layoutDescriptor->setStepFunction(
+            static_cast<MTL::VertexStepFunction>(layout.stepFunction));
+        layoutDescriptor->setStepRate(layout.stepRate);
+    }
+
+    NS::SharedPtr<MTL4::RenderPipelineDescriptor> pipelineDescriptor
+        = NS::TransferPtr(MTL4::RenderPipelineDescriptor::alloc()->init());
+
+    NS::SharedPtr<MTL4::LibraryFunctionDescriptor> vertexFunction
+        = NS::TransferPtr(MTL4::LibraryFunctionDescriptor::alloc()->init());
+    vertexFunction->setLibrary(m_shaderLibrary.get());
+    vertexFunction->setName(
+        NS::String::string(description.vertexFunction.c_str(), NS::UTF8StringEncoding));
+    pipelineDescriptor->setVertexFunctionDescriptor(vertexFunction.get());
+
+    NS::SharedPtr<MTL4::LibraryFunctionDescriptor> fragmentFunction
+        = NS::TransferPtr(MTL4::LibraryFunctionDescriptor::alloc()->init());
+    fragmentFunction->setLibrary(m_shaderLibrary.get());
+    fragmentFunction->setName(
+        NS::String::string(description.fragmentFunction.c_str(), NS::UTF8StringEncoding));
+    pipelineDescriptor->setFragmentFunctionDescriptor(fragmentFunction.get());
+
+    pipelineDescriptor->setVertexDescriptor(vertexDescriptor.get());
+    pipelineDescriptor->setRasterSampleCount(description.rasterSampleCount);
+
+    for (const auto [index, attachment] :
+        std::views::zip(std::views::iota(0u), description.colorAttachments))
+    {
+        MTL4::RenderPipelineColorAttachmentDescriptor* attachmentDescriptor
+            = pipelineDescriptor->colorAttachments()->object(index);
+        attachmentDescriptor->setPixelFormat(static_cast<MTL::PixelFormat>(attachment.pixelFormat));
+        attachmentDescriptor->setWriteMask(static_cast<MTL::ColorWriteMask>(attachment.writeMask));
+        attachmentDescriptor->setBlendingState(
+            attachment.blendingEnabled ? MTL4::BlendStateEnabled : MTL4::BlendStateDisabled);
+        attachmentDescriptor->setSourceRGBBlendFactor(
+            static_cast<MTL::BlendFactor>(attachment.sourceRGBBlendFactor));
+        attachmentDescriptor->setDestinationRGBBlendFactor(
+            static_cast<MTL::BlendFactor>(attachment.destinationRGBBlendFactor));
+        attachmentDescriptor->setRgbBlendOperation(
+            static_cast<MTL::BlendOperation>(attachment.rgbBlendOperation));
+        attachmentDescriptor->setSourceAlphaBlendFactor(
+            static_cast<MTL::BlendFactor>(attachment.sourceAlphaBlendFactor));
+        attachmentDescriptor->setDestinationAlphaBlendFactor(
+            static_cast<MTL::BlendFactor>(attachment.destinationAlphaBlendFactor));
+        attachmentDescriptor->setAlphaBlendOperation(
+            static_cast<MTL::BlendOperation>(attachment.alphaBlendOperation));
+    }
+
+    // Pipelines the archive holds are looked up there instead of being compiled
+    NS::SharedPtr<MTL4::CompilerTaskOptions> compilerTaskOptions
+        = NS::TransferPtr(MTL4::CompilerTaskOptions::alloc()->init());
+    std::unique_lock manifestLock(m_pipelineManifestMutex);
+    const bool       archived = m_pipelineArchive && m_pipelineManifest.contains(key);
+    manifestLock.unlock();
+    if (archived)
+    {
+        compilerTaskOptions->setLookupArchives(NS::Array::array(m_pipelineArchive.get()));
+    }
+
+    NS::Error*                              error = nullptr;
+    NS::SharedPtr<MTL::RenderPipelineState> pipelineState
+        = NS::TransferPtr(m_compiler->newRenderPipelineState(
+            pipelineDescriptor.get(), compilerTaskOptions.get(), &error));
+    if (error != nullptr)
+    {
+        throw std::runtime_error(fmt::format("Failed to create pipeline state {}: {}",
+            description.vertexFunction, error->localizedFailureReason()->utf8String()));
+    }
+
+    manifestLock.lock();
+    if (!archived && m_pipelineManifest.add(description))
+    {
+        m_pipelineCacheDirty = true;
+    }
+
+    return pipelineState;
+}
+
+Example::UploadAllocation Example::allocateUpload(const uint64_t size, const uint64_t alignment)
+{
+    if (const UploadRing::Allocation allocation = m_uploadRing->allocate(size, alignment))
+    {
+        return { allocation.data, m_uploadBuffer.get(), allocation.offset,
+            m_uploadBuffer->gpuAddress() + allocation.offset };
+    }
+
+    // The ring is full of frames still in flight. Rather than stall, give this
+    // allocation its own buffer and keep it alive until the frame retires.
+    NS::SharedPtr<MTL::Buffer> buffer = NS::TransferPtr(m_device->newBuffer(
+        size, MTL::ResourceStorageModeShared | MTL::ResourceCPUCacheModeWriteCombined));
+    m_uploadResidencySet->addAllocation(buffer.get());
+    m_uploadResidencySet->commit();
+    m_overflowBuffers.push_back({ m_frameLoop.frameNumber(), buffer });
+
+    return { buffer->contents(), buffer.get(), 0, buffer->gpuAddress() };
 }
 
 const Keyboard& Example::keyboard() const
@@ -190,25 +567,8 @@ CA::MetalLayer* Example::metalLayer() const
 
 MTL4::RenderPassDescriptor* Example::defaultRenderPassDescriptor(CA::MetalDrawable* drawable) const
 {
-    MTL4::RenderPassDescriptor* passDescriptor = MTL4::RenderPassDescriptor::alloc()->init();
-    passDescriptor->colorAttachments()->object(0)->setResolveTexture(drawable->texture());
-    passDescriptor->colorAttachments()->object(0)->setTexture(msaaTexture());
-    passDescriptor->colorAttachments()->object(0)->setLoadAction(MTL::LoadActionClear);
-    passDescriptor->colorAttachments()->object(0)->setStoreAction(
-        MTL::StoreActionMultisampleResolve);
-    passDescriptor->colorAttachments()->object(0)->setClearColor(
-        MTL::ClearColor(DirectX::Colors::CornflowerBlue.f[0], DirectX::Colors::CornflowerBlue.f[1],
-            DirectX::Colors::CornflowerBlue.f[2], 1.0));
-    passDescriptor->depthAttachment()->setTexture(depthStencilTexture());
-    passDescriptor->depthAttachment()->setLoadAction(MTL::LoadActionClear);
-    passDescriptor->depthAttachment()->setStoreAction(MTL::StoreActionDontCare);
-    passDescriptor->depthAttachment()->setClearDepth(1.0);
-    passDescriptor->stencilAttachment()->setTexture(depthStencilTexture());
-    passDescriptor->stencilAttachment()->setLoadAction(MTL::LoadActionClear);
-    passDescriptor->stencilAttachment()->setStoreAction(MTL::StoreActionDontCare);
-    passDescriptor->stencilAttachment()->setClearStencil(0);
-
-    return passDescriptor;
+    m_renderPassDescriptor->colorAttachments()->object(0)->setResolveTexture(drawable->texture());
+    return m_renderPassDescriptor.get();
 }
 
 MTL4::CommandBuffer* Example::commandBuffer() const
@@ -218,7 +578,7 @@ MTL4::CommandBuffer* Example::commandBuffer() const
 
 MTL4::CommandAllocator* Example::commandAllocator() const
 {
-    return m_commandAllocator[m_currentFrameIndex].get();
+    return m_commandAllocator[m_frameLoop.frameIndex()].get();
 }
 
 MTL::Texture* Example::msaaTexture() const
@@ -252,7 +612,37 @@ int32_t Example::windowHeight() const
 
 uint32_t Example::frameIndex() const
 {
-    return m_currentFrameIndex;
+    return m_frameLoop.frameIndex();
+}
+
+void Example::setFramesInFlight(const uint32_t framesInFlight)
+{
+    m_frameLoop.setFramesInFlight(framesInFlight);
+}
+
+uint32_t Example::framesInFlight() const
+{
+    return m_frameLoop.framesInFlight();
+}
+
+void Example::setLatencyMode(const LatencyMode mode)
+{
+    m_frameLoop.setLatencyMode(mode);
+}
+
+LatencyMode Example::latencyMode() const
+{
+    return m_frameLoop.latencyMode();
+}
+
+const FrameLatencyStatistics& Example::frameStatistics() const
+{
+    return m_frameLoop.statistics();
+}
+
+FrameArena& Example::frameArena()
+{
+    return m_frameLoop.frameArena();
 }
 
 #ifdef SDL_PLATFORM_MACOS
@@ -375,6 +765,15 @@ void Example::onSetupUi(const GameTimer& timer)
     ImGui::Begin("Metal Example", nullptr,
         ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoTitleBar);
     ImGui::Text("%s (%.1d fps)", SDL_GetWindowTitle(m_window.get()), timer.framesPerSecond());
+
+    const FrameLatencyStatistics& statistics = frameStatistics();
+    ImGui::Text("%u frames in flight%s", framesInFlight(),
+        latencyMode() == LatencyMode::LowLatency ? " (low latency)" : "");
+    ImGui::Text("CPU wait %.2f ms", statistics.cpuWait.mean() * 1000.0);
+    ImGui::Text("Input to submit %.2f ms", statistics.inputToSubmit.mean() * 1000.0);
+    ImGui::Text("Wait timeouts %llu", static_cast<unsigned long long>(statistics.waitTimeouts));
+    ImGui::Text("Press 1-4 to set frames in flight");
+    ImGui::Text("Press L to toggle low latency");
     ImGui::Text("Press Esc to quit");
     ImGui::End();
     ImGui::PopStyleVar();
@@ -388,63 +787,131 @@ void Example::quit()
 void Example::metalDisplayLinkNeedsUpdate(
     [[maybe_unused]] CA::MetalDisplayLink* displayLink, CA::MetalDisplayLinkUpdate* update)
 {
-    // Get the next allocator/buffer index in the rotation.
-    m_currentFrameIndex = m_frameNumber % s_bufferCount;
-
-    m_timer.tick([this] { onUpdate(m_timer); });
+    m_currentDrawable = update->drawable();
+    m_frameLoop.runFrame();
+    m_currentDrawable = nullptr;
+}
 
-    m_keyboard->update();
-    m_mouse->update();
+uint32_t Example::bufferCount() const
+{
+    return s_maxBufferCount;
+}
 
-    CA::MetalDrawable* drawable = update->drawable();
-    if (!drawable)
-        return;
+void Example::prepareFrame(const uint64_t frameNumber)
+{
+    const uint64_t completedFrames = m_sharedEvent->signaledValue();
+    m_uploadRing->retireFrames(completedFrames);
 
-    if (m_frameNumber >= s_bufferCount)
+    bool released = false;
+    while (!m_overflowBuffers.empty() && m_overflowBuffers.front().frameNumber < completedFrames)
+    {
+        m_uploadResidencySet->removeAllocation(m_overflowBuffers.front().buffer.get());
+        m_overflowBuffers.pop_front();
+        released = true;
+    }
+    if (released)
     {
-        // Wait for the GPU to finish rendering the frame that's
-        // `kMaxFramesInFlight` before this one, and then proceed to the next step.
-        uint64_t previousValueToWaitFor = m_frameNumber - s_bufferCount;
-        m_sharedEvent->waitUntilSignaledValue(previousValueToWaitFor, 10);
+        m_uploadResidencySet->commit();
     }
 
-    MTL4::CommandAllocator* frameAllocator = m_commandAllocator[m_currentFrameIndex].get();
+    m_uploadRing->beginFrame(frameNumber);
+}
+
+bool Example::acquireFrame()
+{
+    return m_currentDrawable != nullptr;
+}
+
+bool Example::waitForFrame(const uint64_t frameNumber)
+{
+    return m_sharedEvent->waitUntilSignaledValue(frameNumber + 1, m_frameWaitTimeout);
+}
+
+void Example::beginFrame(const uint32_t frameIndex)
+{
+    MTL4::CommandAllocator* frameAllocator = m_commandAllocator[frameIndex].get();
 
     // Prepare to use or reuse the allocator by resetting it.
     frameAllocator->reset();
 
     m_commandBuffer->beginCommandBuffer(frameAllocator);
+    m_parallelEncoder->beginFrame(frameIndex);
 
-    // TODO: This needs to be re-done with improved synchonization
-    // Updating the frame buffer resources in the middle of rendering is not
-    // good and should instead by done after all work as completed and before
-    // any new work is scheduled.
-    // Update depth stencil texture if necessary
-    if (drawable->texture()->width() != m_depthStencilTexture->width()
-        || drawable->texture()->height() != m_depthStencilTexture->height())
+    // Recreate the attachments when the drawable size changed. Nothing of this frame
+    // has been recorded yet, so only submitted frames can still use the old ones.
+    MTL::Texture* drawableTexture = m_currentDrawable->texture();
+    if (drawableTexture->width() != m_depthStencilTexture->width()
+        || drawableTexture->height() != m_depthStencilTexture->height())
     {
-        if (m_frameNumber > 0)
+        // Wait for every submitted frame to complete; the old attachments must not
+        // be released while the GPU may still use them. A GPU that does not drain
+        // within the timeout has hung or lost its device.
+        if (!m_sharedEvent->waitUntilSignaledValue(m_frameLoop.frameNumber(), m_drainTimeout))
         {
-            m_sharedEvent->waitUntilSignaledValue(m_frameNumber - 1, 100);
+            throw std::runtime_error(fmt::format("GPU did not complete frame {} within {} ms",
+                m_frameLoop.frameNumber(), m_drainTimeout));
         }
-        const auto width = drawable->texture()->width();
-        const auto height = drawable->texture()->height();
+        const auto width = drawableTexture->width();
+        const auto height = drawableTexture->height();
         createFrameResources(width, height);
     }
+}
 
-    onRender(drawable, m_commandBuffer.get(), m_timer);
+void Example::onFrameUpdate(const GameTimer& timer)
+{
+    processLatencyControls();
+    onUpdate(timer);
+}
 
+void Example::processLatencyControls()
+{
+    constexpr SDL_Scancode framesInFlightKeys[]
+        = { SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3, SDL_SCANCODE_4 };
+    for (uint32_t i = 0; i < std::size(framesInFlightKeys); i++)
+    {
+        if (m_keyboard->isKeyClicked(framesInFlightKeys[i]))
+        {
+            setFramesInFlight(i + 1);
+        }
+    }
+
+    if (m_keyboard->isKeyClicked(SDL_SCANCODE_L))
+    {
+        setLatencyMode(latencyMode() == LatencyMode::LowLatency ? LatencyMode::Throughput
+                                                                : LatencyMode::LowLatency);
+    }
+}
+
+void Example::onFrameInput()
+{
+    m_keyboard->update();
+    m_mouse->update();
+}
+
+void Example::onFrameRender(const GameTimer& timer)
+{
+    onRender(m_currentDrawable, m_commandBuffer.get(), timer);
+}
+
+void Example::endFrame(const uint64_t frameNumber)
+{
     m_commandBuffer->endCommandBuffer();
 
-    m_commandQueue->wait(drawable);
-    MTL4::CommandBuffer* buffers[] = { m_commandBuffer.get() };
+    m_commandQueue->wait(m_currentDrawable);
 
-    m_commandQueue->commit(buffers, 1);
-    m_commandQueue->signalDrawable(drawable);
-    static_cast<MTL::Drawable*>(drawable)->present();
+    // The main command buffer goes first, then those encoded in parallel, in order
+    const auto                             parallelBuffers = m_parallelEncoder->commandBuffers();
+    std::pmr::vector<MTL4::CommandBuffer*> commandBuffers(&frameArena());
+    commandBuffers.reserve(parallelBuffers.size() + 1);
+    commandBuffers.push_back(m_commandBuffer.get());
+    for (const auto& commandBuffer : parallelBuffers)
+    {
+        commandBuffers.push_back(commandBuffer.get());
+    }
+    m_commandQueue->commit(commandBuffers.data(), commandBuffers.size());
+    m_commandQueue->signalDrawable(m_currentDrawable);
+    static_cast<MTL::Drawable*>(m_currentDrawable)->present();
 
     // Signal when the GPU finishes rendering this frame with a shared event.
-    uint64_t futureValueToWaitFor = m_frameNumber;
-    m_commandQueue->signalEvent(m_sharedEvent.get(), futureValueToWaitFor);
-    m_frameNumber++;
+    m_commandQueue->signalEvent(m_sharedEvent.get(), frameNumber + 1);
 }
@@ -6,7 +6,14 @@
 
 #pragma once
 
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <vector>
 
 #include <SDL3/SDL.h>
 
@@ -17,10 +24,16 @@
 #include <Metal/Metal.hpp>
 #include <QuartzCore/QuartzCore.hpp>
 
+#include "AsyncPipelineCompiler.hpp"
+#include "FrameGraph.hpp"
+#include "FrameLoop.hpp"
 #include "GameTimer.hpp"
 #include "Gamepad.hpp"
 #include "Keyboard.hpp"
 #include "Mouse.hpp"
+#include "ParallelEncoder.hpp"
+#include "PipelineCache.hpp"
+#include "UploadRing.hpp"
 
 namespace SDL
 {
@@ -49,7 +62,7 @@ namespace SDL
     using MetalView = std::unique_ptr<void, MetalViewDeleter>;
 }
 
-class Example : public CA::MetalDisplayLinkDelegate
+class Example : public CA::MetalDisplayLinkDelegate, RenderBackend, FrameListener
 {
 public:
     explicit Example(const char* title, int32_t width, int32_t height);
@@ -70,9 +83,27 @@ public:
         CA::MetalDisplayLink* displayLink, CA::MetalDisplayLinkUpdate* update) override;
 
 protected:
-    static constexpr int              s_bufferCount = 3;
+    /// Per-frame resource slots. The frames actually in flight are selected at runtime.
+    static constexpr int              s_maxBufferCount = 4;
+    static constexpr int              s_defaultFramesInFlight = 3;
     static constexpr int              s_multisampleCount = 4;
     static constexpr MTL::PixelFormat s_defaultPixelFormat = MTL::PixelFormatBGRA8Unorm_sRGB;
+    static constexpr uint64_t         s_uploadRingSize = 4 * 1024 * 1024;
+
+    using RenderPipelineHandle = PipelineHandle<NS::SharedPtr<MTL::RenderPipelineState>>;
+    using RenderPipelineCompiler
+        = AsyncPipelineCompiler<NS::SharedPtr<MTL::RenderPipelineState>>;
+    using CommandEncoder = ParallelEncoder<NS::SharedPtr<MTL4::CommandBuffer>,
+        NS::SharedPtr<MTL4::CommandAllocator>>;
+
+    /// @brief Transient GPU visible memory from the upload ring.
+    struct UploadAllocation
+    {
+        void*        data;       ///< CPU address to write the data to.
+        MTL::Buffer* buffer;     ///< Buffer holding the allocation.
+        uint64_t     offset;     ///< Offset of the allocation within buffer.
+        uint64_t     gpuAddress; ///< GPU address of the allocation.
+    };
 
     virtual bool onLoad() = 0;
 
@@ -98,6 +129,39 @@ protected:
 
     [[nodiscard]] uint32_t frameIndex() const;
 
+    /// @brief Sets how many frames the CPU may record ahead of the GPU (1 to 4).
+    void setFramesInFlight(uint32_t framesInFlight);
+
+    [[nodiscard]] uint32_t framesInFlight() const;
+
+    void setLatencyMode(LatencyMode mode);
+
+    [[nodiscard]] LatencyMode latencyMode() const;
+
+    [[nodiscard]] const FrameLatencyStatistics& frameStatistics() const;
+
+    /// @brief Arena for transient CPU allocations of the current frame.
+    [[nodiscard]] FrameArena& frameArena();
+
+    /// @brief Allocates GPU visible memory that stays valid until the current frame
+    /// completes on the GPU, e.g. for uniforms, instance data or argument buffers.
+    ///
+    /// Served from a persistently mapped ring buffer. If the ring is exhausted a
+    /// dedicated buffer is created for the allocation and released once the frame
+    /// retires, so the call never blocks.
+    [[nodiscard]] UploadAllocation allocateUpload(
+        uint64_t size, uint64_t alignment = UploadRing::s_defaultAlignment);
+
+    /// @brief Allocates and fills upload memory with a copy of value.
+    template <typename T>
+    [[nodiscard]] UploadAllocation upload(const T& value)
+    {
+        static_assert(alignof(T) <= UploadRing::s_defaultAlignment);
+        const UploadAllocation allocation = allocateUpload(sizeof(T));
+        std::memcpy(allocation.data, &value, sizeof(T));
+        return allocation;
+    }
+
     [[nodiscard]] MTL::Device* device() const;
 
     [[nodiscard]] MTL4::CommandQueue* commandQueue() const;
@@ -106,8 +170,38 @@ protected:
 
     [[nodiscard]] MTL::Library* shaderLibrary() const;
 
+    /// @brief Returns the render pipeline for a description, compiling it on first use.
+    ///
+    /// Pipelines are deduplicated by the key of the description and owned by the
+    /// example. Compiled binaries are written to an archive in the user's preference
+    /// directory on exit, so later runs skip the backend compilation.
+    [[nodiscard]] MTL::RenderPipelineState* renderPipelineState(
+        const PipelineDescription& description);
+
+    /// @brief Compiles a render pipeline on a worker thread.
+    ///
+    /// Returns immediately. Draws using the pipeline should be skipped, or use a
+    /// fallback pipeline, until the handle is ready, so loading never stalls a frame.
+    [[nodiscard]] RenderPipelineHandle requestRenderPipeline(
+        const PipelineDescription& description,
+        PipelinePriority           priority = PipelinePriority::High);
+
     [[nodiscard]] MTL4::CommandBuffer* commandBuffer() const;
 
+    /// @brief Encodes partitions of the frame on the thread pool, each into its own
+    /// command buffer and allocator, calling function(commandBuffer, partition).
+    ///
+    /// The buffers are committed after commandBuffer(), in the order they were
+    /// encoded. A render pass spread over partitions suspends and resumes its
+    /// encoders as EncodePartition describes.
+    template <typename TFunction>
+    void encodeParallel(std::span<const EncodePartition> partitions, const TFunction& function)
+    {
+        m_parallelEncoder->encode(partitions,
+            [&](NS::SharedPtr<MTL4::CommandBuffer>& commandBuffer,
+                const EncodePartition& partition) { function(commandBuffer.get(), partition); });
+    }
+
     [[nodiscard]] MTL4::CommandAllocator* commandAllocator() const;
 
     [[nodiscard]] MTL::Texture* msaaTexture() const;
@@ -116,6 +210,11 @@ protected:
 
     [[nodiscard]] CA::MetalLayer* metalLayer() const;
 
+    /// @brief The pass that clears the MSAA and depth attachments and resolves into
+    /// the drawable.
+    ///
+    /// The descriptor is built once per attachment size and only its resolve target
+    /// changes per frame, so it is owned by Example and must not be released.
     [[nodiscard]] MTL4::RenderPassDescriptor* defaultRenderPassDescriptor(
         CA::MetalDrawable* drawable) const;
 
@@ -128,8 +227,10 @@ private:
     SDL::MetalView m_view;
     uint32_t       m_defaultWidth;
     uint32_t       m_defaultHeight;
-    GameTimer      m_timer;
+    FrameLoop      m_frameLoop { *this, *this };
     bool           m_running;
+    uint64_t       m_frameWaitTimeout = 10;  ///< Milliseconds to wait on a frame slot.
+    uint64_t       m_drainTimeout = 5'000;   ///< Milliseconds to wait for the GPU to go idle.
 
 #pragma region Input Handling
     std::unique_ptr<Keyboard> m_keyboard;
@@ -138,22 +239,85 @@ private:
 #pragma endregion
 
 #pragma region Metal Resources
-    NS::SharedPtr<CA::MetalDisplayLink>   m_displayLink;
-    NS::SharedPtr<MTL::Device>            m_device;
-    NS::SharedPtr<MTL4::CommandQueue>     m_commandQueue;
-    NS::SharedPtr<MTL4::CommandBuffer>    m_commandBuffer;
-    NS::SharedPtr<MTL4::CommandAllocator> m_commandAllocator[s_bufferCount];
-    NS::SharedPtr<MTL::Texture>           m_msaaTexture;
-    NS::SharedPtr<MTL::Texture>           m_depthStencilTexture;
-    NS::SharedPtr<MTL::DepthStencilState> m_depthStencilState;
-    NS::SharedPtr<MTL::Library>           m_shaderLibrary;
+    NS::SharedPtr<CA::MetalDisplayLink>       m_displayLink;
+    NS::SharedPtr<MTL::Device>                m_device;
+    NS::SharedPtr<MTL4::CommandQueue>         m_commandQueue;
+    NS::SharedPtr<MTL4::CommandBuffer>        m_commandBuffer;
+    NS::SharedPtr<MTL4::CommandAllocator>     m_commandAllocator[s_maxBufferCount];
+    std::unique_ptr<CommandEncoder>           m_parallelEncoder;
+    Render::FrameGraph                        m_frameGraph; ///< The frame's attachments.
+    NS::SharedPtr<MTL::Heap>                  m_transientHeap;
+    NS::SharedPtr<MTL::ResidencySet>          m_frameResidencySet;
+    NS::SharedPtr<MTL::Texture>               m_msaaTexture;
+    NS::SharedPtr<MTL::Texture>               m_depthStencilTexture;
+    NS::SharedPtr<MTL4::RenderPassDescriptor> m_renderPassDescriptor;
+    NS::SharedPtr<MTL::DepthStencilState>     m_depthStencilState;
+    NS::SharedPtr<MTL::Library>               m_shaderLibrary;
+#pragma endregion
+
+#pragma region Upload Ring
+    struct OverflowBuffer
+    {
+        uint64_t                   frameNumber;
+        NS::SharedPtr<MTL::Buffer> buffer;
+    };
+
+    NS::SharedPtr<MTL::Buffer>       m_uploadBuffer;
+    NS::SharedPtr<MTL::ResidencySet> m_uploadResidencySet;
+    std::unique_ptr<UploadRing>      m_uploadRing;
+    std::deque<OverflowBuffer>       m_overflowBuffers;
+#pragma endregion
+
+#pragma region Pipeline Cache
+    NS::SharedPtr<MTL4::Compiler>                          m_compiler;
+    NS::SharedPtr<MTL4::PipelineDataSetSerializer>         m_pipelineSerializer;
+    NS::SharedPtr<MTL4::Archive>                           m_pipelineArchive;
+    PipelineCache<NS::SharedPtr<MTL::RenderPipelineState>> m_pipelineCache;
+    PipelineCacheManifest                                  m_pipelineManifest;
+    std::filesystem::path                                  m_pipelineCacheDirectory;
+    bool                                                   m_pipelineCacheDirty = false;
+    std::mutex                                             m_pipelineManifestMutex;
+    std::unique_ptr<RenderPipelineCompiler>                m_pipelineCompiler;
 #pragma endregion
 
 #pragma region Sync Primitives
-    uint32_t                        m_currentFrameIndex = 0;
-    uint32_t                        m_frameNumber = 0;
+    CA::MetalDrawable*              m_currentDrawable = nullptr;
     NS::SharedPtr<MTL::SharedEvent> m_sharedEvent;
 #pragma endregion
 
     void createFrameResources(int32_t width, int32_t height);
+
+    [[nodiscard]] static NS::SharedPtr<MTL::TextureDescriptor> createTextureDescriptor(
+        const Render::TextureDesc& desc);
+
+    void createUploadRing();
+
+    void createPipelineCache();
+
+    void savePipelineCache();
+
+    [[nodiscard]] NS::SharedPtr<MTL::RenderPipelineState> compileRenderPipeline(
+        const PipelineKey& key, const PipelineDescription& description);
+
+#pragma region Frame Loop
+    [[nodiscard]] uint32_t bufferCount() const override;
+
+    void prepareFrame(uint64_t frameNumber) override;
+
+    [[nodiscard]] bool acquireFrame() override;
+
+    [[nodiscard]] bool waitForFrame(uint64_t frameNumber) override;
+
+    void beginFrame(uint32_t frameIndex) override;
+
+    void endFrame(uint64_t frameNumber) override;
+
+    void onFrameUpdate(const GameTimer& timer) override;
+
+    void processLatencyControls();
+
+    void onFrameInput() override;
+
+    void onFrameRender(const GameTimer& timer) override;
+#pragma endregion
 };
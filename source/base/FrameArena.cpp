@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <bit>
+
+FrameArena::FrameArena(const size_t initialBlockSize)
+{
+    addBlock(std::max<size_t>(initialBlockSize, 1));
+}
+
+void FrameArena::reset()
+{
+    m_statistics.peakBytes = std::max(m_statistics.peakBytes, m_statistics.bytesAllocated);
+    m_statistics.bytesAllocated = 0;
+    m_statistics.allocationCount = 0;
+
+    // Coalesce an overflowed chain so the next frame fits in a single block.
+    if (m_blocks.size() > 1)
+    {
+        const size_t capacity = m_statistics.capacity;
+        m_blocks.clear();
+        m_statistics.capacity = 0;
+        addBlock(std::bit_ceil(capacity));
+    }
+
+    m_currentBlock = 0;
+    m_offset = 0;
+}
+
+const FrameArena::Statistics& FrameArena::statistics() const
+{
+    return m_statistics;
+}
+
+void* FrameArena::do_allocate(const size_t bytes, const size_t alignment)
+{
+    while (true)
+    {
+        Block&          block = m_blocks[m_currentBlock];
+        const uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+        const uintptr_t aligned = (base + m_offset + alignment - 1) & ~(alignment - 1);
+        const size_t    offset = aligned - base;
+        if (offset + bytes <= block.size)
+        {
+            m_offset = offset + bytes;
+            m_statistics.bytesAllocated += bytes;
+            m_statistics.allocationCount++;
+            return block.memory.get() + offset;
+        }
+
+        // Move on to the next block, growing geometrically so a frame that keeps
+        // overflowing needs only a logarithmic number of heap allocations.
+        if (m_currentBlock + 1 == m_blocks.size())
+        {
+            addBlock(std::max(block.size * 2, bytes + alignment));
+        }
+        m_currentBlock++;
+        m_offset = 0;
+    }
+}
+
+void FrameArena::do_deallocate([[maybe_unused]] void* pointer,
+    [[maybe_unused]] size_t                            bytes,
+    [[maybe_unused]] size_t                            alignment)
+{
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+void FrameArena::addBlock(const size_t size)
+{
+    m_blocks.push_back({ std::make_unique_for_overwrite<std::byte[]>(size), size });
+    m_statistics.capacity += size;
+    m_statistics.blockAllocations++;
+}
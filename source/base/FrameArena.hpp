@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// @brief Linear (bump) allocator for transient per-frame CPU data.
+///
+/// Allocation advances an offset in the current block and deallocation is a no-op;
+/// all memory is released at once by reset. When a frame outgrows the current block
+/// another, larger block is chained on. On reset the chain is replaced by a single
+/// block large enough for the whole frame, so a steady workload allocates from one
+/// block without touching malloc.
+///
+/// The arena is a std::pmr::memory_resource, so pmr containers can use it directly:
+/// @code
+/// std::pmr::vector<Matrix> transforms(&arena);
+/// @endcode
+class FrameArena final : public std::pmr::memory_resource
+{
+public:
+    static constexpr size_t s_defaultBlockSize = 64 * 1024;
+
+    struct Statistics
+    {
+        size_t   bytesAllocated = 0;   ///< Bytes handed out since the last reset.
+        size_t   allocationCount = 0;  ///< Allocations since the last reset.
+        size_t   peakBytes = 0;        ///< Highest bytesAllocated seen at a reset.
+        size_t   capacity = 0;         ///< Total size of all blocks.
+        uint64_t blockAllocations = 0; ///< Blocks obtained from the heap over the lifetime.
+    };
+
+    /// @param [in] initialBlockSize Size of the first block in bytes.
+    explicit FrameArena(size_t initialBlockSize = s_defaultBlockSize);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /// @brief Releases every allocation made since the last reset.
+    void reset();
+
+    /// @brief Allocates uninitialized storage for count objects of type T.
+    template <typename T>
+    [[nodiscard]] T* allocateArray(const size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>,
+            "FrameArena never runs destructors; use a pmr container instead");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /// @brief Constructs a trivially destructible object in the arena.
+    template <typename T, typename... TArgs>
+    [[nodiscard]] T* create(TArgs&&... args)
+    {
+        return new (allocateArray<T>(1)) T(std::forward<TArgs>(args)...);
+    }
+
+    [[nodiscard]] const Statistics& statistics() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> memory;
+        size_t                       size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    void addBlock(size_t size);
+
+    std::vector<Block> m_blocks;
+    size_t             m_currentBlock = 0;
+    size_t             m_offset = 0;
+    Statistics         m_statistics {};
+};
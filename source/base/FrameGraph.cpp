@@ -0,0 +1,499 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameGraph.hpp"
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace Render
+{
+    namespace
+    {
+        /// Half-open byte range in the heap.
+        struct Range
+        {
+            uint64_t begin = 0;
+            uint64_t end = 0;
+        };
+
+        uint64_t alignUp(const uint64_t value, const uint64_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        bool overlaps(const FrameGraph::Lifetime& a, const FrameGraph::Lifetime& b)
+        {
+            return a.first <= b.last && b.first <= a.last;
+        }
+    } // namespace
+
+    bool isWriteAccess(const ResourceAccess access)
+    {
+        return access == ResourceAccess::RenderTarget || access == ResourceAccess::DepthStencil
+            || access == ResourceAccess::ShaderWrite;
+    }
+
+    FrameGraph::PassBuilder& FrameGraph::PassBuilder::read(
+        const ResourceHandle resource, const ResourceAccess access)
+    {
+        m_graph.m_passes[m_pass].reads.push_back({ .resource = resource.index, .access = access });
+        return *this;
+    }
+
+    FrameGraph::PassBuilder& FrameGraph::PassBuilder::write(
+        const ResourceHandle resource, const ResourceAccess access)
+    {
+        m_graph.m_passes[m_pass].writes.push_back(
+            { .resource = resource.index, .access = access });
+        return *this;
+    }
+
+    FrameGraph::PassBuilder& FrameGraph::PassBuilder::setSideEffects()
+    {
+        m_graph.m_passes[m_pass].sideEffects = true;
+        return *this;
+    }
+
+    void FrameGraph::clear()
+    {
+        m_passes.clear();
+        m_resources.clear();
+        m_passOrder.clear();
+        m_barriers.clear();
+        m_barrierOffsets.clear();
+        m_placed.clear();
+        m_heapSize = 0;
+        m_heapAlignment = 1;
+        m_statistics = {};
+    }
+
+    ResourceHandle FrameGraph::createTexture(std::string name, const TextureDesc& desc)
+    {
+        m_resources.push_back({ .name = std::move(name),
+            .desc = desc,
+            .imported = false,
+            .initialAccess = ResourceAccess::None,
+            .finalAccess = ResourceAccess::None,
+            .lifetime = {},
+            .memory = {},
+            .offset = g_invalidOffset });
+        return { static_cast<uint32_t>(m_resources.size() - 1) };
+    }
+
+    ResourceHandle FrameGraph::importTexture(std::string name,
+        const TextureDesc&                               desc,
+        const ResourceAccess                             initialAccess,
+        const ResourceAccess                             finalAccess)
+    {
+        m_resources.push_back({ .name = std::move(name),
+            .desc = desc,
+            .imported = true,
+            .initialAccess = initialAccess,
+            .finalAccess = finalAccess,
+            .lifetime = {},
+            .memory = {},
+            .offset = g_invalidOffset });
+        return { static_cast<uint32_t>(m_resources.size() - 1) };
+    }
+
+    FrameGraph::PassBuilder FrameGraph::addPass(std::string name)
+    {
+        m_passes.push_back({ .name = std::move(name),
+            .reads = {},
+            .writes = {},
+            .sideEffects = false,
+            .culled = false });
+        return { *this, static_cast<uint32_t>(m_passes.size() - 1) };
+    }
+
+    void FrameGraph::compile(const MemoryQuery& memoryQuery)
+    {
+        validate();
+        cull();
+        computeLifetimes();
+        placeTextures(memoryQuery);
+        insertBarriers();
+
+        m_statistics.passes = m_passes.size();
+        m_statistics.culledPasses = m_passes.size() - m_passOrder.size();
+        m_statistics.heapBytes = m_heapSize;
+    }
+
+    void FrameGraph::validate() const
+    {
+        for (const Resource& resource : m_resources)
+        {
+            if (resource.desc.width == 0 || resource.desc.height == 0)
+            {
+                throw std::runtime_error(
+                    std::format("Frame graph texture '{}' has a zero size", resource.name));
+            }
+        }
+
+        std::vector<bool> written(m_resources.size());
+        for (const Pass& pass : m_passes)
+        {
+            for (const auto* uses : { &pass.reads, &pass.writes })
+            {
+                for (const Use& use : *uses)
+                {
+                    if (use.resource >= m_resources.size())
+                    {
+                        throw std::runtime_error(std::format(
+                            "Frame graph pass '{}' uses an invalid resource", pass.name));
+                    }
+                }
+            }
+
+            for (const Use& read : pass.reads)
+            {
+                const Resource& resource = m_resources[read.resource];
+                if (!resource.imported && !written[read.resource])
+                {
+                    throw std::runtime_error(
+                        std::format("Frame graph pass '{}' reads '{}' before any pass writes it",
+                            pass.name, resource.name));
+                }
+            }
+            for (const Use& write : pass.writes)
+            {
+                written[write.resource] = true;
+            }
+        }
+    }
+
+    void FrameGraph::cull()
+    {
+        // Walking back from the outputs, a pass is needed when it writes something a
+        // later needed pass reads. Writes may load what was there, so an earlier
+        // writer of a needed resource is needed too.
+        std::vector<bool> needed(m_resources.size());
+        for (size_t i = 0; i < m_resources.size(); i++)
+        {
+            needed[i] = m_resources[i].imported;
+        }
+
+        for (size_t i = m_passes.size(); i-- > 0;)
+        {
+            Pass& pass = m_passes[i];
+            pass.culled = !pass.sideEffects
+                && std::ranges::none_of(
+                    pass.writes, [&](const Use& write) { return needed[write.resource]; });
+            if (!pass.culled)
+            {
+                for (const Use& read : pass.reads)
+                {
+                    needed[read.resource] = true;
+                }
+            }
+        }
+
+        m_passOrder.clear();
+        for (size_t i = 0; i < m_passes.size(); i++)
+        {
+            if (!m_passes[i].culled)
+            {
+                m_passOrder.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    void FrameGraph::computeLifetimes()
+    {
+        for (Resource& resource : m_resources)
+        {
+            resource.lifetime = {};
+        }
+
+        for (size_t position = 0; position < m_passOrder.size(); position++)
+        {
+            const Pass& pass = m_passes[m_passOrder[position]];
+            for (const auto* uses : { &pass.reads, &pass.writes })
+            {
+                for (const Use& use : *uses)
+                {
+                    Lifetime& lifetime = m_resources[use.resource].lifetime;
+                    lifetime.first = std::min(lifetime.first, static_cast<uint32_t>(position));
+                    lifetime.last = std::max(lifetime.last, static_cast<uint32_t>(position));
+                }
+            }
+        }
+    }
+
+    void FrameGraph::placeTextures(const MemoryQuery& memoryQuery)
+    {
+        m_placed.clear();
+        m_heapSize = 0;
+        m_heapAlignment = 1;
+        m_statistics.transientResources = 0;
+        m_statistics.transientBytes = 0;
+        for (size_t i = 0; i < m_resources.size(); i++)
+        {
+            Resource& resource = m_resources[i];
+            resource.offset = g_invalidOffset;
+            if (resource.imported || resource.lifetime.first == g_invalidIndex)
+            {
+                continue;
+            }
+
+            m_statistics.transientResources++;
+            if (!resource.desc.memoryless)
+            {
+                resource.memory = memoryQuery(resource.desc);
+                resource.memory.alignment = std::max<uint64_t>(resource.memory.alignment, 1);
+                m_statistics.transientBytes += resource.memory.size;
+                m_placed.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        // Largest first packs best; among equal sizes, earlier uses go lower
+        std::ranges::sort(m_placed, [this](const uint32_t a, const uint32_t b) {
+            const Resource& left = m_resources[a];
+            const Resource& right = m_resources[b];
+            if (left.memory.size != right.memory.size)
+            {
+                return left.memory.size > right.memory.size;
+            }
+            return std::pair(left.lifetime.first, a) < std::pair(right.lifetime.first, b);
+        });
+
+        // Each texture goes in the lowest gap left by the placed textures whose
+        // lifetimes overlap its own
+        std::vector<Range> taken;
+        for (size_t i = 0; i < m_placed.size(); i++)
+        {
+            Resource& resource = m_resources[m_placed[i]];
+            taken.clear();
+            for (size_t j = 0; j < i; j++)
+            {
+                const Resource& other = m_resources[m_placed[j]];
+                if (overlaps(resource.lifetime, other.lifetime))
+                {
+                    taken.push_back({ other.offset, other.offset + other.memory.size });
+                }
+            }
+            std::ranges::sort(taken, {}, &Range::begin);
+
+            uint64_t offset = 0;
+            for (const Range& range : taken)
+            {
+                if (alignUp(offset, resource.memory.alignment) + resource.memory.size
+                    <= range.begin)
+                {
+                    break;
+                }
+                offset = std::max(offset, range.end);
+            }
+            resource.offset = alignUp(offset, resource.memory.alignment);
+            m_heapSize = std::max(m_heapSize, resource.offset + resource.memory.size);
+            m_heapAlignment = std::max(m_heapAlignment, resource.memory.alignment);
+        }
+    }
+
+    void FrameGraph::insertBarriers()
+    {
+        m_barriers.clear();
+        m_barrierOffsets.clear();
+        m_statistics.transitionBarriers = 0;
+        m_statistics.aliasingBarriers = 0;
+
+        // Textures placed in the heap by the position of their first use
+        std::vector<uint32_t> byFirstUse = m_placed;
+        std::ranges::sort(byFirstUse, {}, [this](const uint32_t resource) {
+            return m_resources[resource].lifetime.first;
+        });
+
+        std::vector<ResourceAccess> state(m_resources.size());
+        for (size_t i = 0; i < m_resources.size(); i++)
+        {
+            state[i] = m_resources[i].initialAccess;
+        }
+
+        const auto transition = [&](const uint32_t resource, const ResourceAccess access) {
+            // Consecutive shader writes still need ordering between them
+            if (state[resource] != access || access == ResourceAccess::ShaderWrite)
+            {
+                m_barriers.push_back({ .type = Barrier::Type::Transition,
+                    .resource = resource,
+                    .before = state[resource],
+                    .after = access });
+                m_statistics.transitionBarriers++;
+                state[resource] = access;
+            }
+        };
+
+        Occupants occupants;
+        size_t    nextFirstUse = 0;
+        for (size_t position = 0; position < m_passOrder.size(); position++)
+        {
+            m_barrierOffsets.push_back(m_barriers.size());
+            for (; nextFirstUse < byFirstUse.size()
+                 && m_resources[byFirstUse[nextFirstUse]].lifetime.first == position;
+                 nextFirstUse++)
+            {
+                addAliasingBarriers(byFirstUse[nextFirstUse], occupants);
+            }
+
+            const Pass& pass = m_passes[m_passOrder[position]];
+            for (const Use& read : pass.reads)
+            {
+                transition(read.resource, read.access);
+            }
+            for (const Use& write : pass.writes)
+            {
+                transition(write.resource, write.access);
+            }
+        }
+
+        m_barrierOffsets.push_back(m_barriers.size());
+        for (size_t i = 0; i < m_resources.size(); i++)
+        {
+            const Resource& resource = m_resources[i];
+            if (resource.imported && state[i] != resource.finalAccess)
+            {
+                transition(static_cast<uint32_t>(i), resource.finalAccess);
+            }
+        }
+        m_barrierOffsets.push_back(m_barriers.size());
+    }
+
+    void FrameGraph::addAliasingBarriers(const uint32_t resource, Occupants& occupants)
+    {
+        // Textures that share memory never share a lifetime, so in order of first use
+        // each byte's occupant is the texture that used it last. Every occupant of
+        // the new texture's range needs a barrier, once.
+        const Resource& placed = m_resources[resource];
+        const uint64_t  begin = placed.offset;
+        const uint64_t  end = placed.offset + placed.memory.size;
+        const size_t    firstBarrier = m_barriers.size();
+
+        auto occupant = occupants.upper_bound(begin);
+        if (occupant != occupants.begin() && std::prev(occupant)->second.end > begin)
+        {
+            --occupant;
+        }
+        while (occupant != occupants.end() && occupant->first < end)
+        {
+            const Occupant previous = occupant->second;
+            const auto     isPrevious = [&](const Barrier& barrier) {
+                return barrier.aliasedResource == previous.resource;
+            };
+            if (std::ranges::none_of(std::span(m_barriers).subspan(firstBarrier), isPrevious))
+            {
+                m_barriers.push_back({ .type = Barrier::Type::Aliasing,
+                    .resource = resource,
+                    .aliasedResource = previous.resource });
+                m_statistics.aliasingBarriers++;
+            }
+
+            // Keep the parts of the previous occupant outside the new range
+            if (previous.end > end)
+            {
+                occupants.insert_or_assign(end, previous);
+            }
+            if (occupant->first < begin)
+            {
+                occupant->second.end = begin;
+                ++occupant;
+            }
+            else
+            {
+                occupant = occupants.erase(occupant);
+            }
+        }
+        occupants.insert_or_assign(begin, Occupant { .end = end, .resource = resource });
+    }
+
+    std::span<const uint32_t> FrameGraph::passOrder() const
+    {
+        return m_passOrder;
+    }
+
+    std::span<const Barrier> FrameGraph::barriers(const size_t position) const
+    {
+        return std::span(m_barriers)
+            .subspan(m_barrierOffsets[position],
+                m_barrierOffsets[position + 1] - m_barrierOffsets[position]);
+    }
+
+    std::span<const Barrier> FrameGraph::finalBarriers() const
+    {
+        if (m_barrierOffsets.empty())
+        {
+            return {};
+        }
+        return barriers(m_passOrder.size());
+    }
+
+    size_t FrameGraph::passCount() const
+    {
+        return m_passes.size();
+    }
+
+    const std::string& FrameGraph::passName(const uint32_t pass) const
+    {
+        return m_passes.at(pass).name;
+    }
+
+    bool FrameGraph::isCulled(const uint32_t pass) const
+    {
+        return m_passes.at(pass).culled;
+    }
+
+    size_t FrameGraph::resourceCount() const
+    {
+        return m_resources.size();
+    }
+
+    const std::string& FrameGraph::resourceName(const ResourceHandle resource) const
+    {
+        return this->resource(resource).name;
+    }
+
+    const TextureDesc& FrameGraph::textureDesc(const ResourceHandle resource) const
+    {
+        return this->resource(resource).desc;
+    }
+
+    bool FrameGraph::isImported(const ResourceHandle resource) const
+    {
+        return this->resource(resource).imported;
+    }
+
+    FrameGraph::Lifetime FrameGraph::lifetime(const ResourceHandle resource) const
+    {
+        return this->resource(resource).lifetime;
+    }
+
+    uint64_t FrameGraph::heapOffset(const ResourceHandle resource) const
+    {
+        return this->resource(resource).offset;
+    }
+
+    uint64_t FrameGraph::heapSize() const
+    {
+        return m_heapSize;
+    }
+
+    uint64_t FrameGraph::heapAlignment() const
+    {
+        return m_heapAlignment;
+    }
+
+    const FrameGraphStatistics& FrameGraph::statistics() const
+    {
+        return m_statistics;
+    }
+
+    const FrameGraph::Resource& FrameGraph::resource(const ResourceHandle handle) const
+    {
+        return m_resources.at(handle.index);
+    }
+} // namespace Render
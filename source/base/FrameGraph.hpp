@@ -0,0 +1,270 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Render
+{
+    /// @brief Texture a frame graph resource stands for. The graph never interprets
+    /// the format, it only hands the description back to the backend.
+    struct TextureDesc
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t format = 0; ///< Backend pixel format value.
+        uint32_t sampleCount = 1;
+        bool     memoryless = false; ///< Lives in tile memory only, never in the heap.
+    };
+
+    /// @brief How a pass uses a resource, and so the state it must be in.
+    enum class ResourceAccess : uint8_t
+    {
+        None,         ///< Not used yet; the contents are undefined.
+        RenderTarget, ///< Color attachment, written.
+        DepthStencil, ///< Depth and stencil attachment, written.
+        ShaderRead,   ///< Sampled or loaded by shaders.
+        ShaderWrite,  ///< Written by shaders, e.g. compute.
+        Present,      ///< Handed to the display.
+    };
+
+    [[nodiscard]] bool isWriteAccess(ResourceAccess access);
+
+    /// @brief Size and alignment of a texture placed in a heap, from the backend.
+    struct MemoryRequirements
+    {
+        uint64_t size = 0;
+        uint64_t alignment = 1;
+    };
+
+    /// @brief Synchronization a pass needs before it runs.
+    struct Barrier
+    {
+        enum class Type : uint8_t
+        {
+            Transition, ///< resource moves from before to after.
+            Aliasing,   ///< resource takes over memory aliasedResource used last.
+        };
+
+        Type           type = Type::Transition;
+        uint32_t       resource = 0;
+        uint32_t       aliasedResource = 0;
+        ResourceAccess before = ResourceAccess::None;
+        ResourceAccess after = ResourceAccess::None;
+    };
+
+    inline constexpr uint32_t g_invalidIndex = std::numeric_limits<uint32_t>::max();
+    inline constexpr uint64_t g_invalidOffset = std::numeric_limits<uint64_t>::max();
+
+    struct ResourceHandle
+    {
+        uint32_t index = g_invalidIndex;
+
+        [[nodiscard]] bool isValid() const
+        {
+            return index != g_invalidIndex;
+        }
+    };
+
+    struct FrameGraphStatistics
+    {
+        size_t   passes = 0;
+        size_t   culledPasses = 0;
+        size_t   transientResources = 0;
+        uint64_t transientBytes = 0; ///< Without aliasing.
+        uint64_t heapBytes = 0;      ///< With aliasing.
+        size_t   transitionBarriers = 0;
+        size_t   aliasingBarriers = 0;
+    };
+
+    /// @brief Passes of a frame declared with the virtual resources they read and
+    /// write, compiled into what a backend needs to run them.
+    ///
+    /// compile() culls the passes nothing depends on, finds when each transient
+    /// resource is first and last used, places transient textures whose uses do
+    /// not overlap in the same heap memory and lists the barriers each pass needs.
+    /// Passes run in declaration order. Passes that write an imported resource, or
+    /// that have side effects, are never culled.
+    ///
+    /// The graph is rebuilt each time the frame changes shape; clear() keeps the
+    /// storage for the next declaration.
+    class FrameGraph
+    {
+    public:
+        using MemoryQuery = std::function<MemoryRequirements(const TextureDesc&)>;
+
+        /// @brief Declares what one pass uses; returned by addPass.
+        class PassBuilder
+        {
+        public:
+            PassBuilder& read(ResourceHandle resource,
+                ResourceAccess               access = ResourceAccess::ShaderRead);
+
+            PassBuilder& write(ResourceHandle resource,
+                ResourceAccess                access = ResourceAccess::RenderTarget);
+
+            /// @brief Keeps the pass even if nothing reads what it writes.
+            PassBuilder& setSideEffects();
+
+            [[nodiscard]] uint32_t index() const
+            {
+                return m_pass;
+            }
+
+        private:
+            friend class FrameGraph;
+
+            PassBuilder(FrameGraph& graph, const uint32_t pass)
+                : m_graph(graph)
+                , m_pass(pass)
+            {
+            }
+
+            FrameGraph& m_graph;
+            uint32_t    m_pass;
+        };
+
+        struct Lifetime
+        {
+            uint32_t first = g_invalidIndex; ///< Position in passOrder() of the first use.
+            uint32_t last = 0;
+        };
+
+        void clear();
+
+        /// @brief Declares a transient texture, created and destroyed within the frame.
+        ResourceHandle createTexture(std::string name, const TextureDesc& desc);
+
+        /// @brief Declares a texture owned outside the graph, e.g. the drawable.
+        /// @param [in] initialAccess State the texture is in when the frame starts.
+        /// @param [in] finalAccess State to leave it in once the frame is done.
+        ResourceHandle importTexture(std::string name,
+            const TextureDesc&                   desc,
+            ResourceAccess                       initialAccess,
+            ResourceAccess                       finalAccess);
+
+        PassBuilder addPass(std::string name);
+
+        /// @brief Culls, computes lifetimes, places transient textures and inserts
+        /// barriers.
+        /// @param [in] memoryQuery Heap requirements of a transient texture.
+        /// @throws std::runtime_error if a pass reads a transient texture no earlier
+        /// pass writes, uses an invalid handle or a texture has a zero size.
+        void compile(const MemoryQuery& memoryQuery);
+
+        /// @brief Passes that survived culling, in execution order.
+        [[nodiscard]] std::span<const uint32_t> passOrder() const;
+
+        /// @brief Barriers to issue before the pass at position in passOrder().
+        [[nodiscard]] std::span<const Barrier> barriers(size_t position) const;
+
+        /// @brief Barriers to issue after the last pass, for imported textures.
+        [[nodiscard]] std::span<const Barrier> finalBarriers() const;
+
+        /// @brief Runs function(pass, barriers) for every pass in passOrder().
+        template <typename TFunction>
+        void execute(const TFunction& function) const
+        {
+            for (size_t position = 0; position < m_passOrder.size(); position++)
+            {
+                function(m_passOrder[position], barriers(position));
+            }
+        }
+
+        [[nodiscard]] size_t passCount() const;
+
+        [[nodiscard]] const std::string& passName(uint32_t pass) const;
+
+        [[nodiscard]] bool isCulled(uint32_t pass) const;
+
+        [[nodiscard]] size_t resourceCount() const;
+
+        [[nodiscard]] const std::string& resourceName(ResourceHandle resource) const;
+
+        [[nodiscard]] const TextureDesc& textureDesc(ResourceHandle resource) const;
+
+        [[nodiscard]] bool isImported(ResourceHandle resource) const;
+
+        /// @brief Uses by passes that survived culling; first is g_invalidIndex when
+        /// there are none.
+        [[nodiscard]] Lifetime lifetime(ResourceHandle resource) const;
+
+        /// @brief Offset in the heap of a placed transient texture, or g_invalidOffset
+        /// for imported, memoryless and unused ones.
+        [[nodiscard]] uint64_t heapOffset(ResourceHandle resource) const;
+
+        /// @brief Size of the heap the transient textures are placed in.
+        [[nodiscard]] uint64_t heapSize() const;
+
+        /// @brief Largest alignment of the placed textures, for creating the heap.
+        [[nodiscard]] uint64_t heapAlignment() const;
+
+        [[nodiscard]] const FrameGraphStatistics& statistics() const;
+
+    private:
+        struct Use
+        {
+            uint32_t       resource = 0;
+            ResourceAccess access = ResourceAccess::None;
+        };
+
+        struct Pass
+        {
+            std::string      name;
+            std::vector<Use> reads;
+            std::vector<Use> writes;
+            bool             sideEffects = false;
+            bool             culled = false;
+        };
+
+        struct Resource
+        {
+            std::string        name;
+            TextureDesc        desc;
+            bool               imported = false;
+            ResourceAccess     initialAccess = ResourceAccess::None;
+            ResourceAccess     finalAccess = ResourceAccess::None;
+            Lifetime           lifetime;
+            MemoryRequirements memory;
+            uint64_t           offset = g_invalidOffset;
+        };
+
+        /// Texture that last used the heap bytes from the key up to end.
+        struct Occupant
+        {
+            uint64_t end = 0;
+            uint32_t resource = 0;
+        };
+
+        using Occupants = std::map<uint64_t, Occupant>;
+
+        void validate() const;
+        void cull();
+        void computeLifetimes();
+        void placeTextures(const MemoryQuery& memoryQuery);
+        void insertBarriers();
+        void addAliasingBarriers(uint32_t resource, Occupants& occupants);
+
+        [[nodiscard]] const Resource& resource(ResourceHandle handle) const;
+
+        std::vector<Pass>     m_passes;
+        std::vector<Resource> m_resources;
+        std::vector<uint32_t> m_passOrder;
+        std::vector<Barrier>  m_barriers;
+        std::vector<size_t>   m_barrierOffsets; ///< passOrder().size() + 2 entries.
+        std::vector<uint32_t> m_placed;         ///< Placed textures, largest first.
+        uint64_t              m_heapSize = 0;
+        uint64_t              m_heapAlignment = 1;
+        FrameGraphStatistics  m_statistics;
+    };
+} // namespace Render
@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameLoop.hpp"
+
+#include <algorithm>
+
+FrameLoop::FrameLoop(RenderBackend& backend, FrameListener& listener)
+    : m_backend(backend)
+    , m_listener(listener)
+    , m_framesInFlight(backend.bufferCount())
+    , m_requestedFramesInFlight(m_framesInFlight)
+{
+    m_frameArenas.resize(m_backend.bufferCount() + 1);
+    for (auto& arena : m_frameArenas)
+    {
+        arena = std::make_unique<FrameArena>();
+    }
+    m_currentArena = m_frameArenas.front().get();
+
+    m_timer.setFixedTimeStep(false);
+    resetTimer();
+}
+
+bool FrameLoop::runFrame()
+{
+    m_backend.waitForInterval();
+
+    // A frame whose slot wait timed out keeps its update and is retried as is, so
+    // the simulation does not advance by frames that are never rendered.
+    if (!m_frameStarted)
+    {
+        if (!applyFramesInFlight())
+        {
+            m_statistics.skippedFrames++;
+            return false;
+        }
+
+        // Get the next allocator/buffer index in the rotation.
+        m_currentFrameIndex = static_cast<uint32_t>(m_frameNumber % m_framesInFlight);
+
+        m_currentArena = m_frameArenas[m_frameNumber % (m_framesInFlight + 1)].get();
+        m_currentArena->reset();
+
+        m_backend.prepareFrame(m_frameNumber);
+
+        if (m_latencyMode == LatencyMode::Throughput)
+        {
+            sampleInput();
+        }
+        m_frameStarted = true;
+    }
+
+    if (!m_backend.acquireFrame() || !waitForFrameSlot())
+    {
+        m_statistics.skippedFrames++;
+        return false;
+    }
+
+    if (m_latencyMode == LatencyMode::LowLatency)
+    {
+        sampleInput();
+    }
+
+    m_backend.beginFrame(m_currentFrameIndex);
+
+    m_listener.onFrameRender(m_timer);
+
+    m_backend.endFrame(m_frameNumber);
+    m_statistics.inputToSubmit.add(secondsSince(m_inputTime));
+    m_statistics.frames++;
+    m_frameNumber++;
+    m_frameStarted = false;
+    return true;
+}
+
+void FrameLoop::resetTimer()
+{
+    m_timer.resetElapsedTime(m_backend.currentTime());
+}
+
+GameTimer& FrameLoop::timer()
+{
+    return m_timer;
+}
+
+const GameTimer& FrameLoop::timer() const
+{
+    return m_timer;
+}
+
+uint32_t FrameLoop::frameIndex() const
+{
+    return m_currentFrameIndex;
+}
+
+uint64_t FrameLoop::frameNumber() const
+{
+    return m_frameNumber;
+}
+
+void FrameLoop::setFramesInFlight(const uint32_t framesInFlight)
+{
+    m_requestedFramesInFlight = std::clamp(framesInFlight, 1U, m_backend.bufferCount());
+}
+
+uint32_t FrameLoop::framesInFlight() const
+{
+    return m_framesInFlight;
+}
+
+void FrameLoop::setLatencyMode(const LatencyMode mode)
+{
+    m_latencyMode = mode;
+}
+
+LatencyMode FrameLoop::latencyMode() const
+{
+    return m_latencyMode;
+}
+
+const FrameLatencyStatistics& FrameLoop::statistics() const
+{
+    return m_statistics;
+}
+
+void FrameLoop::resetStatistics()
+{
+    m_statistics = {};
+}
+
+FrameArena& FrameLoop::frameArena()
+{
+    return *m_currentArena;
+}
+
+bool FrameLoop::applyFramesInFlight()
+{
+    if (m_requestedFramesInFlight == m_framesInFlight)
+    {
+        return true;
+    }
+
+    // Slot indices are derived from the frame number modulo the count, so changing
+    // it while frames are outstanding could hand out a slot that is still in use.
+    if (m_frameNumber > 0)
+    {
+        const uint64_t start = m_backend.currentTime();
+        const bool     completed = m_backend.waitForFrame(m_frameNumber - 1);
+        m_statistics.cpuWait.add(secondsSince(start));
+        if (!completed)
+        {
+            m_statistics.waitTimeouts++;
+            return false;
+        }
+    }
+
+    m_framesInFlight = m_requestedFramesInFlight;
+    return true;
+}
+
+bool FrameLoop::waitForFrameSlot()
+{
+    if (m_frameNumber < m_framesInFlight)
+    {
+        m_statistics.cpuWait.add(0.0);
+        return true;
+    }
+
+    // Wait for the GPU to finish rendering the frame that's
+    // `framesInFlight` before this one, and then proceed to the next step.
+    const uint64_t start = m_backend.currentTime();
+    const bool     completed = m_backend.waitForFrame(m_frameNumber - m_framesInFlight);
+    m_statistics.cpuWait.add(secondsSince(start));
+    if (!completed)
+    {
+        // Recording would reuse resources the GPU may still be reading, so drop the
+        // frame and try again on the next interval.
+        m_statistics.waitTimeouts++;
+        return false;
+    }
+    return true;
+}
+
+void FrameLoop::sampleInput()
+{
+    m_inputTime = m_backend.currentTime();
+
+    m_timer.tick(m_inputTime, [this] { m_listener.onFrameUpdate(m_timer); });
+
+    m_listener.onFrameInput();
+}
+
+double FrameLoop::secondsSince(const uint64_t time) const
+{
+    const uint64_t now = m_backend.currentTime();
+    return static_cast<double>(now - std::min(now, time))
+        / static_cast<double>(m_timer.performanceFrequency());
+}
@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "FrameArena.hpp"
+#include "GameTimer.hpp"
+#include "RenderBackend.hpp"
+
+enum class LatencyMode
+{
+    /// Update and sample input before waiting on the GPU, overlapping CPU work with
+    /// frames still in flight. A frame whose wait times out is retried without
+    /// updating again.
+    Throughput,
+    /// Wait on the GPU first and sample input just before recording, so the frame
+    /// reflects the most recent input at the cost of idle CPU time.
+    LowLatency,
+};
+
+/// @brief Running summary of a per-frame duration in seconds.
+struct LatencyMeasurement
+{
+    double   last = 0.0;
+    double   max = 0.0;
+    double   total = 0.0;
+    uint64_t count = 0;
+
+    void add(const double seconds)
+    {
+        last = seconds;
+        max = seconds > max ? seconds : max;
+        total += seconds;
+        count++;
+    }
+
+    [[nodiscard]] double mean() const
+    {
+        return count > 0 ? total / static_cast<double>(count) : 0.0;
+    }
+};
+
+struct FrameLatencyStatistics
+{
+    uint64_t           frames = 0;        ///< Frames submitted.
+    uint64_t           skippedFrames = 0; ///< Frames dropped before recording.
+    uint64_t           waitTimeouts = 0;  ///< GPU waits that gave up before completion.
+    LatencyMeasurement cpuWait;           ///< Time blocked waiting for a frame slot.
+    LatencyMeasurement inputToSubmit;     ///< Input sampling to submission of the frame.
+};
+
+/// @brief Backend independent frame orchestration.
+///
+/// Ticks the timer, rolls input over, rotates the frame-in-flight index and
+/// brackets the listener's render hook with the backend's synchronization.
+class FrameLoop
+{
+public:
+    FrameLoop(RenderBackend& backend, FrameListener& listener);
+
+    FrameLoop(const FrameLoop&) = delete;
+    FrameLoop& operator=(const FrameLoop&) = delete;
+
+    /// @brief Runs a single frame.
+    /// @return True if the frame was submitted, false if the backend skipped it. A
+    /// skipped frame that was already updated is resumed by the next call.
+    bool runFrame();
+
+    /// @brief Resets the timer so the next frame measures from the backend clock.
+    void resetTimer();
+
+    [[nodiscard]] GameTimer& timer();
+
+    [[nodiscard]] const GameTimer& timer() const;
+
+    /// @brief Index of the per-frame resource slot currently being recorded.
+    [[nodiscard]] uint32_t frameIndex() const;
+
+    /// @brief Number of frames submitted so far.
+    [[nodiscard]] uint64_t frameNumber() const;
+
+    /// @brief Sets how many frames the CPU may record ahead of the GPU.
+    ///
+    /// The count is clamped to [1, RenderBackend::bufferCount()]. It takes effect at
+    /// the start of the next frame, after every submitted frame has completed, so no
+    /// per-frame slot is reused while the GPU may still read it.
+    void setFramesInFlight(uint32_t framesInFlight);
+
+    [[nodiscard]] uint32_t framesInFlight() const;
+
+    void setLatencyMode(LatencyMode mode);
+
+    [[nodiscard]] LatencyMode latencyMode() const;
+
+    [[nodiscard]] const FrameLatencyStatistics& statistics() const;
+
+    /// @brief Arena for transient CPU data of the current frame.
+    ///
+    /// Valid from onFrameUpdate until the frame has completed on the GPU, so it may
+    /// also back data the GPU work of the frame refers to. The loop rotates through
+    /// framesInFlight + 1 arenas: by the time frame n starts, frame n - 1 has waited
+    /// for frame n - 1 - framesInFlight, so the arena frame n reuses is known to be
+    /// retired and is reset without blocking.
+    [[nodiscard]] FrameArena& frameArena();
+
+    void resetStatistics();
+
+private:
+    /// Applies a pending frames-in-flight change once the GPU has drained.
+    bool applyFramesInFlight();
+
+    /// Waits until the slot for the current frame is no longer used by the GPU.
+    bool waitForFrameSlot();
+
+    void sampleInput();
+
+    [[nodiscard]] double secondsSince(uint64_t time) const;
+
+    RenderBackend&         m_backend;
+    FrameListener&         m_listener;
+    GameTimer              m_timer;
+    uint32_t               m_currentFrameIndex = 0;
+    uint64_t               m_frameNumber = 0;
+    uint32_t               m_framesInFlight;
+    uint32_t               m_requestedFramesInFlight;
+    LatencyMode            m_latencyMode = LatencyMode::Throughput;
+    uint64_t               m_inputTime = 0;
+    bool                   m_frameStarted = false; ///< Updated, but not yet submitted.
+    FrameLatencyStatistics m_statistics {};
+
+    std::vector<std::unique_ptr<FrameArena>> m_frameArenas;
+    FrameArena*                              m_currentArena = nullptr;
+};
@@ -53,6 +53,11 @@ uint32_t GameTimer::framesPerSecond() const noexcept
     return m_framesPerSecond;
 }
 
+uint64_t GameTimer::performanceFrequency() const noexcept
+{
+    return m_qpcFrequency;
+}
+
 void GameTimer::setFixedTimeStep(const bool isFixedTimeStep) noexcept
 {
     m_isFixedTimeStep = isFixedTimeStep;
@@ -70,7 +75,12 @@ void GameTimer::setTargetElapsedSeconds(const double targetElapsed) noexcept
 
 void GameTimer::resetElapsedTime()
 {
-    m_qpcLastTime = SDL_GetPerformanceCounter();
+    resetElapsedTime(SDL_GetPerformanceCounter());
+}
+
+void GameTimer::resetElapsedTime(const uint64_t currentTime)
+{
+    m_qpcLastTime = currentTime;
 
     m_leftOverTicks = 0;
     m_framesPerSecond = 0;
@@ -39,11 +39,25 @@ public:
 
     void resetElapsedTime();
 
+    /// @brief Resets elapsed time relative to an explicit performance counter value.
+    /// @param [in] currentTime Performance counter value to measure the next tick from.
+    void resetElapsedTime(uint64_t currentTime);
+
+    [[nodiscard]] uint64_t performanceFrequency() const noexcept;
+
     template <typename TUpdate>
     void tick(const TUpdate& update)
     {
-        const uint64_t currentTime = SDL_GetPerformanceCounter();
+        tick(SDL_GetPerformanceCounter(), update);
+    }
 
+    /// @brief Advances the timer to an explicit performance counter value.
+    /// @note Used by headless backends to drive the timer from a simulated clock.
+    /// @param [in] currentTime Performance counter value for this tick.
+    /// @param [in] update Callback invoked once per elapsed update step.
+    template <typename TUpdate>
+    void tick(const uint64_t currentTime, const TUpdate& update)
+    {
         uint64_t delta = currentTime - m_qpcLastTime;
         m_qpcLastTime = currentTime;
         m_qpcSecondCounter += delta;
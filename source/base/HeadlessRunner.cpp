@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HeadlessRunner.hpp"
+
+#include <algorithm>
+#include <limits>
+
+HeadlessRunner::HeadlessRunner(FrameListener& listener, std::unique_ptr<NullBackend> backend)
+    : m_backend(
+          backend ? std::move(backend) : std::make_unique<NullBackend>(NullBackend::Options {}))
+    , m_frameLoop(*m_backend, listener)
+{
+}
+
+FrameStatistics HeadlessRunner::run(const uint64_t frameCount)
+{
+    uint64_t remaining = frameCount;
+    return runWhile([&remaining](uint64_t) { return remaining-- > 0; });
+}
+
+FrameStatistics HeadlessRunner::runFor(const double seconds)
+{
+    const auto limit = static_cast<uint64_t>(
+        seconds * static_cast<double>(SDL_GetPerformanceFrequency()));
+    return runWhile([limit](uint64_t elapsed) { return elapsed < limit; });
+}
+
+template <typename TContinue>
+FrameStatistics HeadlessRunner::runWhile(const TContinue& shouldContinue)
+{
+    const double   frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+    const uint64_t start = SDL_GetPerformanceCounter();
+
+    FrameStatistics statistics {};
+    statistics.minFrameSeconds = std::numeric_limits<double>::max();
+
+    uint64_t now = start;
+    while (shouldContinue(now - start))
+    {
+        const uint64_t frameStart = now;
+        if (m_frameLoop.runFrame())
+        {
+            statistics.frames++;
+        }
+        else
+        {
+            statistics.skippedFrames++;
+        }
+        now = SDL_GetPerformanceCounter();
+
+        const double frameSeconds = static_cast<double>(now - frameStart) / frequency;
+        statistics.minFrameSeconds = std::min(statistics.minFrameSeconds, frameSeconds);
+        statistics.maxFrameSeconds = std::max(statistics.maxFrameSeconds, frameSeconds);
+    }
+
+    statistics.wallSeconds = static_cast<double>(now - start) / frequency;
+    const uint64_t attempts = statistics.frames + statistics.skippedFrames;
+    if (attempts == 0)
+    {
+        statistics.minFrameSeconds = 0.0;
+        return statistics;
+    }
+    statistics.meanFrameSeconds = statistics.wallSeconds / static_cast<double>(attempts);
+    return statistics;
+}
+
+NullBackend& HeadlessRunner::backend()
+{
+    return *m_backend;
+}
+
+FrameLoop& HeadlessRunner::frameLoop()
+{
+    return m_frameLoop;
+}
@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "FrameLoop.hpp"
+#include "NullBackend.hpp"
+
+struct FrameStatistics
+{
+    uint64_t frames = 0;
+    uint64_t skippedFrames = 0;
+    double   wallSeconds = 0.0;
+    double   minFrameSeconds = 0.0;
+    double   maxFrameSeconds = 0.0;
+    double   meanFrameSeconds = 0.0;
+
+    [[nodiscard]] double framesPerSecond() const
+    {
+        return wallSeconds > 0.0 ? static_cast<double>(frames) / wallSeconds : 0.0;
+    }
+};
+
+/// @brief Drives a FrameListener through the frame loop without a window or GPU.
+///
+/// Useful for soak tests and CPU-side benchmarks of an example's update path.
+class HeadlessRunner
+{
+public:
+    /// @brief Constructor
+    /// @param [in] listener The update/render hooks to drive.
+    /// @param [in] backend Backend to run against, or nullptr for a default NullBackend.
+    explicit HeadlessRunner(FrameListener& listener, std::unique_ptr<NullBackend> backend = {});
+
+    /// @brief Runs the given number of frames.
+    /// @return Timing statistics measured with the real clock.
+    FrameStatistics run(uint64_t frameCount);
+
+    /// @brief Runs frames until the given wall-clock duration has elapsed.
+    FrameStatistics runFor(double seconds);
+
+    [[nodiscard]] NullBackend& backend();
+
+    [[nodiscard]] FrameLoop& frameLoop();
+
+private:
+    template <typename TContinue>
+    FrameStatistics runWhile(const TContinue& shouldContinue);
+
+    std::unique_ptr<NullBackend> m_backend;
+    FrameLoop                    m_frameLoop;
+};
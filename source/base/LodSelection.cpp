@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "LodSelection.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "Camera.hpp"
+
+namespace Assets
+{
+    LodSelector::LodSelector(const std::array<float, 3>& cameraPosition,
+        const float projectionScale, const float viewportHeight, const float thresholdPixels)
+        : m_cameraPosition(cameraPosition)
+        , m_pixelsPerUnit(projectionScale * viewportHeight * 0.5F)
+        , m_thresholdPixels(thresholdPixels)
+    {
+    }
+
+    LodSelector::LodSelector(
+        const Camera& camera, const float viewportHeight, const float thresholdPixels)
+        : LodSelector({ camera.position().x, camera.position().y, camera.position().z },
+              camera.uniforms().projection._22, viewportHeight, thresholdPixels)
+    {
+    }
+
+    uint32_t LodSelector::select(
+        const std::span<const CookedLod> lods, const LodInstance& instance) const
+    {
+        // Errors grow with every level, the last one within the limit is the coarsest
+        const float limit = errorLimit(instance);
+        for (size_t lod = lods.size(); lod > 1; lod--)
+        {
+            if (lods[lod - 1].error <= limit)
+            {
+                return static_cast<uint32_t>(lod - 1);
+            }
+        }
+        return 0;
+    }
+
+    void LodSelector::select(const std::span<const CookedLod> lods,
+        const std::span<const LodInstance> instances, const std::span<uint32_t> selected) const
+    {
+        assert(selected.size() >= instances.size());
+        for (size_t i = 0; i < instances.size(); i++)
+        {
+            selected[i] = select(lods, instances[i]);
+        }
+    }
+
+    float LodSelector::projectedError(const float error, const LodInstance& instance) const
+    {
+        const float limit = errorLimit(instance);
+        return limit > 0.0F ? error * m_thresholdPixels / limit
+                            : std::numeric_limits<float>::infinity();
+    }
+
+    float LodSelector::errorLimit(const LodInstance& instance) const
+    {
+        const float dx = instance.center[0] - m_cameraPosition[0];
+        const float dy = instance.center[1] - m_cameraPosition[1];
+        const float dz = instance.center[2] - m_cameraPosition[2];
+        const float distance = std::sqrt(dx * dx + dy * dy + dz * dz) - instance.radius;
+
+        // Inside the bounding sphere only full detail is safe
+        if (distance <= 0.0F || instance.scale <= 0.0F)
+        {
+            return 0.0F;
+        }
+        return m_thresholdPixels * distance / (m_pixelsPerUnit * instance.scale);
+    }
+} // namespace Assets
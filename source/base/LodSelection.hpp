@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "CookedMesh.hpp"
+
+class Camera;
+
+namespace Assets
+{
+    /// @brief Placement of one instance of a primitive, in world space.
+    struct LodInstance
+    {
+        std::array<float, 3> center {}; ///< Bounding sphere.
+        float                radius = 0.0F;
+        float                scale = 1.0F; ///< Largest scale of the instance transform.
+    };
+
+    /// @brief Picks levels of detail by the size of their simplification error on
+    /// screen.
+    ///
+    /// An error e at distance d covers e * projectionScale / d of the half viewport
+    /// height. Distances are taken to the near side of the bounding sphere, so the
+    /// estimate holds for every point of the instance.
+    class LodSelector
+    {
+    public:
+        /// @param [in] projectionScale Cotangent of half the vertical field of view,
+        /// element (1, 1) of a perspective projection.
+        /// @param [in] thresholdPixels Largest error allowed on screen.
+        LodSelector(const std::array<float, 3>& cameraPosition, float projectionScale,
+            float viewportHeight, float thresholdPixels = 1.0F);
+
+        /// @brief Selects for the camera's current position and projection.
+        LodSelector(const Camera& camera, float viewportHeight, float thresholdPixels = 1.0F);
+
+        /// @brief Returns the coarsest LOD whose error stays under the threshold.
+        [[nodiscard]] uint32_t select(
+            std::span<const CookedLod> lods, const LodInstance& instance) const;
+
+        /// @brief Selects for many instances of one primitive at once.
+        /// @param [out] selected One LOD index per instance.
+        void select(std::span<const CookedLod> lods, std::span<const LodInstance> instances,
+            std::span<uint32_t> selected) const;
+
+        /// @brief Returns the size in pixels of an object space error.
+        [[nodiscard]] float projectedError(float error, const LodInstance& instance) const;
+
+    private:
+        /// Largest object space error allowed for an instance.
+        [[nodiscard]] float errorLimit(const LodInstance& instance) const;
+
+        std::array<float, 3> m_cameraPosition;
+        float                m_pixelsPerUnit; ///< At distance 1.
+        float                m_thresholdPixels;
+    };
+} // namespace Assets
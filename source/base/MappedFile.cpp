@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.hpp"
+
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_USE_MMAP 1
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+#ifdef MAPPED_FILE_USE_MMAP
+    const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+    {
+        throw std::runtime_error(std::format("Failed to open {} for read", path.string()));
+    }
+
+    struct stat status {};
+    if (::fstat(descriptor, &status) != 0)
+    {
+        ::close(descriptor);
+        throw std::runtime_error(std::format("Failed to query the size of {}", path.string()));
+    }
+
+    m_size = static_cast<size_t>(status.st_size);
+    if (m_size > 0)
+    {
+        void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data == MAP_FAILED)
+        {
+            ::close(descriptor);
+            throw std::runtime_error(std::format("Failed to map {}", path.string()));
+        }
+        m_data = static_cast<const std::byte*>(data);
+        m_mapped = true;
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(descriptor);
+#else
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+    {
+        throw std::runtime_error(std::format("Failed to open {} for read", path.string()));
+    }
+    m_contents.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    stream.read(reinterpret_cast<char*>(m_contents.data()),
+        static_cast<std::streamsize>(m_contents.size()));
+    if (!stream)
+    {
+        throw std::runtime_error(std::format("Failed to read {}", path.string()));
+    }
+    m_data = m_contents.data();
+    m_size = m_contents.size();
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_mapped(std::exchange(other.m_mapped, false))
+    , m_contents(std::move(other.m_contents))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_mapped = std::exchange(other.m_mapped, false);
+        m_contents = std::move(other.m_contents);
+    }
+    return *this;
+}
+
+std::span<const std::byte> MappedFile::bytes() const
+{
+    return { m_data, m_size };
+}
+
+size_t MappedFile::size() const
+{
+    return m_size;
+}
+
+void MappedFile::unmap()
+{
+#ifdef MAPPED_FILE_USE_MMAP
+    if (m_mapped)
+    {
+        ::munmap(const_cast<std::byte*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_contents.clear();
+}
@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+/// @brief Read-only view of a whole file, memory mapped where the platform allows.
+///
+/// Mapping lets loaders parse large assets in place: pages are faulted in on demand
+/// and shared with the OS file cache, instead of being copied into a heap buffer.
+/// Platforms without mmap read the file into memory instead.
+class MappedFile
+{
+public:
+    /// @brief Maps the file at path.
+    /// @throws std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile(const std::filesystem::path& path);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] std::span<const std::byte> bytes() const;
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    void unmap();
+
+    const std::byte*       m_data = nullptr;
+    size_t                 m_size = 0;
+    bool                   m_mapped = false; ///< Whether m_data is an mmap region.
+    std::vector<std::byte> m_contents;       ///< Storage when the file is read instead.
+};
@@ -0,0 +1,504 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace Assets
+{
+    namespace
+    {
+        constexpr uint32_t g_unusedVertex = ~0U;
+
+        /// FIFO post-transform cache simulated with insertion timestamps: a vertex is
+        /// cached while fewer than cacheSize vertices were inserted after it.
+        class CacheSimulator
+        {
+        public:
+            CacheSimulator(const size_t vertexCount, const uint32_t cacheSize)
+                : m_stamps(vertexCount, 0)
+                , m_cacheSize(cacheSize)
+                , m_time(cacheSize + 1)
+            {
+            }
+
+            /// Returns true on a miss.
+            bool access(const uint32_t vertex)
+            {
+                if (m_time - m_stamps[vertex] > m_cacheSize)
+                {
+                    m_stamps[vertex] = m_time++;
+                    return true;
+                }
+                return false;
+            }
+
+            uint32_t accessTriangle(const uint32_t* triangle)
+            {
+                return static_cast<uint32_t>(access(triangle[0])) + access(triangle[1])
+                    + access(triangle[2]);
+            }
+
+            void flush()
+            {
+                m_time += m_cacheSize + 1;
+            }
+
+        private:
+            std::vector<size_t> m_stamps;
+            size_t              m_cacheSize;
+            size_t              m_time;
+        };
+
+        template <typename T>
+        void remapArray(
+            std::vector<T>& values, const std::span<const uint32_t> remap, const size_t count)
+        {
+            if (values.empty())
+            {
+                return;
+            }
+
+            std::vector<T> remapped(count);
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                if (remap[i] != g_unusedVertex)
+                {
+                    remapped[remap[i]] = values[i];
+                }
+            }
+            values = std::move(remapped);
+        }
+
+        /// Moves every vertex to remap[vertex] in a primitive holding count vertices
+        /// afterwards. Vertices mapped to g_unusedVertex are dropped.
+        void remapVertices(
+            Primitive& primitive, const std::span<const uint32_t> remap, const size_t count)
+        {
+            remapArray(primitive.vertices, remap, count);
+            remapArray(primitive.streams.positions, remap, count);
+            remapArray(primitive.streams.normals, remap, count);
+            remapArray(primitive.streams.texCoords, remap, count);
+            remapArray(primitive.streams.tangents, remap, count);
+            remapArray(primitive.streams.colors, remap, count);
+            remapArray(primitive.streams.joints, remap, count);
+            remapArray(primitive.streams.weights, remap, count);
+            for (auto& index : primitive.indices)
+            {
+                index = remap[index];
+            }
+        }
+
+        template <size_t N>
+        void appendRow(
+            std::vector<float>& rows, const std::vector<std::array<float, N>>& values, size_t i)
+        {
+            if (!values.empty())
+            {
+                rows.insert(rows.end(), values[i].begin(), values[i].end());
+            }
+        }
+
+        uint64_t hashRow(const std::span<const float> row)
+        {
+            // FNV-1a over the bit patterns, so only bitwise identical vertices collide.
+            // Float coordinates often have zero low mantissa bits, so the result is
+            // finalized to spread them into the low bits the table is indexed with
+            uint64_t hash = 0xCBF29CE484222325ULL;
+            for (const float value : row)
+            {
+                hash = (hash ^ std::bit_cast<uint32_t>(value)) * 0x100000001B3ULL;
+            }
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        std::array<float, 3> subtract(const std::array<float, 3>& a, const std::array<float, 3>& b)
+        {
+            return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+        }
+
+        std::array<float, 3> cross(const std::array<float, 3>& a, const std::array<float, 3>& b)
+        {
+            return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+                a[0] * b[1] - a[1] * b[0] };
+        }
+
+        float dot(const std::array<float, 3>& a, const std::array<float, 3>& b)
+        {
+            return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+        }
+    } // namespace
+
+    VertexCacheStatistics analyzeVertexCache(const std::span<const uint32_t> indices,
+        const size_t vertexCount, const uint32_t cacheSize)
+    {
+        CacheSimulator        cache(vertexCount, cacheSize);
+        VertexCacheStatistics statistics;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            statistics.transforms += cache.accessTriangle(indices.data() + i);
+        }
+
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount > 0)
+        {
+            statistics.acmr = static_cast<float>(statistics.transforms) / triangleCount;
+        }
+        if (vertexCount > 0)
+        {
+            statistics.atvr = static_cast<float>(statistics.transforms) / vertexCount;
+        }
+        return statistics;
+    }
+
+    size_t weldVertices(Primitive& primitive)
+    {
+        const size_t vertexCount = primitive.vertexCount();
+        if (vertexCount == 0)
+        {
+            return 0;
+        }
+
+        // Flatten every vertex into a row of floats to hash and compare
+        std::vector<float> rows;
+        if (!primitive.vertices.empty())
+        {
+            rows.resize(vertexCount * sizeof(MeshVertex) / sizeof(float));
+            std::memcpy(rows.data(), primitive.vertices.data(), vertexCount * sizeof(MeshVertex));
+        }
+        else
+        {
+            const VertexStreams& streams = primitive.streams;
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                appendRow(rows, streams.positions, i);
+                appendRow(rows, streams.normals, i);
+                appendRow(rows, streams.texCoords, i);
+                appendRow(rows, streams.tangents, i);
+                appendRow(rows, streams.colors, i);
+                appendRow(rows, streams.weights, i);
+                if (!streams.joints.empty())
+                {
+                    rows.insert(rows.end(), streams.joints[i].begin(), streams.joints[i].end());
+                }
+            }
+        }
+        const size_t stride = rows.size() / vertexCount;
+        const auto   row = [&rows, stride](const size_t i) {
+            return std::span<const float>(rows).subspan(i * stride, stride);
+        };
+
+        // Open addressing table of representative vertices, at most half full
+        const size_t          tableSize = std::bit_ceil(vertexCount * 2);
+        std::vector<uint32_t> table(tableSize, g_unusedVertex);
+        std::vector<uint32_t> remap(vertexCount);
+        uint32_t              uniqueCount = 0;
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            const auto current = row(i);
+            size_t     slot = hashRow(current) & (tableSize - 1);
+            while (table[slot] != g_unusedVertex
+                && !std::ranges::equal(row(table[slot]), current, [](float a, float b) {
+                       return std::bit_cast<uint32_t>(a) == std::bit_cast<uint32_t>(b);
+                   }))
+            {
+                slot = (slot + 1) & (tableSize - 1);
+            }
+
+            if (table[slot] == g_unusedVertex)
+            {
+                table[slot] = static_cast<uint32_t>(i);
+                remap[i] = uniqueCount++;
+            }
+            else
+            {
+                remap[i] = remap[table[slot]];
+            }
+        }
+
+        if (uniqueCount == vertexCount)
+        {
+            return 0;
+        }
+        remapVertices(primitive, remap, uniqueCount);
+        return vertexCount - uniqueCount;
+    }
+
+    void optimizeVertexCache(
+        const std::span<uint32_t> indices, const size_t vertexCount, const uint32_t cacheSize)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        // Triangles adjacent to each vertex, in compressed rows
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            offsets[indices[i] + 1]++;
+        }
+        std::vector<uint32_t> liveTriangles(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            liveTriangles[v] = offsets[v + 1];
+            offsets[v + 1] += offsets[v];
+        }
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<size_t>   timestamps(vertexCount, 0);
+        std::vector<bool>     emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> output;
+        output.reserve(triangleCount * 3);
+        size_t time = cacheSize + 1;
+        size_t scan = 0;
+
+        // Falls back to recently used vertices with live triangles, then to the next
+        // vertex in input order that has any
+        const auto skipDeadEnd = [&]() -> int64_t {
+            while (!deadEnds.empty())
+            {
+                const uint32_t vertex = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveTriangles[vertex] > 0)
+                {
+                    return vertex;
+                }
+            }
+            for (; scan < vertexCount; scan++)
+            {
+                if (liveTriangles[scan] > 0)
+                {
+                    return static_cast<int64_t>(scan);
+                }
+            }
+            return -1;
+        };
+
+        for (int64_t fan = skipDeadEnd(); fan >= 0;)
+        {
+            // Emit every remaining triangle around the fanning vertex
+            candidates.clear();
+            for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; a++)
+            {
+                const uint32_t triangle = adjacency[a];
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+                emitted[triangle] = true;
+                for (size_t k = 0; k < 3; k++)
+                {
+                    const uint32_t vertex = indices[triangle * 3 + k];
+                    output.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveTriangles[vertex]--;
+                    if (time - timestamps[vertex] > cacheSize)
+                    {
+                        timestamps[vertex] = time++;
+                    }
+                }
+            }
+
+            // Prefer the oldest candidate that will still be cached once its remaining
+            // triangles are emitted
+            int64_t next = -1;
+            int64_t bestPriority = -1;
+            for (const uint32_t vertex : candidates)
+            {
+                if (liveTriangles[vertex] == 0)
+                {
+                    continue;
+                }
+                int64_t priority = 0;
+                if (time - timestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+                {
+                    priority = static_cast<int64_t>(time - timestamps[vertex]);
+                }
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    next = vertex;
+                }
+            }
+            fan = next >= 0 ? next : skipDeadEnd();
+        }
+
+        std::ranges::copy(output, indices.begin());
+    }
+
+    void optimizeOverdraw(const std::span<uint32_t> indices,
+        const std::span<const std::array<float, 3>> positions, const float threshold,
+        const uint32_t cacheSize)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2)
+        {
+            return;
+        }
+
+        // Hard boundaries where the cache order restarts: all three vertices miss
+        CacheSimulator        cache(positions.size(), cacheSize);
+        std::vector<uint32_t> misses(triangleCount);
+        std::vector<size_t>   hardBoundaries;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            misses[t] = cache.accessTriangle(indices.data() + t * 3);
+            if (t == 0 || misses[t] == 3)
+            {
+                hardBoundaries.push_back(t);
+            }
+        }
+        hardBoundaries.push_back(triangleCount);
+
+        // Soft boundaries split clusters once their own ACMR, starting from a cold
+        // cache, comes within threshold of the cluster's
+        std::vector<size_t> boundaries;
+        for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+        {
+            const size_t begin = hardBoundaries[c];
+            const size_t end = hardBoundaries[c + 1];
+            size_t       clusterMisses = 0;
+            for (size_t t = begin; t < end; t++)
+            {
+                clusterMisses += misses[t];
+            }
+            const float limit = threshold * static_cast<float>(clusterMisses) / (end - begin);
+
+            boundaries.push_back(begin);
+            cache.flush();
+            size_t start = begin;
+            size_t runningMisses = 0;
+            for (size_t t = begin; t + 1 < end; t++)
+            {
+                runningMisses += cache.accessTriangle(indices.data() + t * 3);
+                if (static_cast<float>(runningMisses) / (t - start + 1) <= limit)
+                {
+                    boundaries.push_back(t + 1);
+                    cache.flush();
+                    start = t + 1;
+                    runningMisses = 0;
+                }
+            }
+        }
+        boundaries.push_back(triangleCount);
+
+        // Area weighted centroid and normal of every cluster, and of the whole mesh
+        const size_t                      clusterCount = boundaries.size() - 1;
+        std::vector<std::array<float, 3>> centroids(clusterCount);
+        std::vector<std::array<float, 3>> normals(clusterCount);
+        std::array<float, 3>              meshCentroid {};
+        float                             meshArea = 0.0F;
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            float clusterArea = 0.0F;
+            for (size_t t = boundaries[c]; t < boundaries[c + 1]; t++)
+            {
+                const auto& p0 = positions[indices[t * 3]];
+                const auto& p1 = positions[indices[t * 3 + 1]];
+                const auto& p2 = positions[indices[t * 3 + 2]];
+                const auto  normal = cross(subtract(p1, p0), subtract(p2, p0));
+                const float area = std::sqrt(dot(normal, normal));
+                for (size_t axis = 0; axis < 3; axis++)
+                {
+                    const float center = (p0[axis] + p1[axis] + p2[axis]) / 3.0F;
+                    centroids[c][axis] += center * area;
+                    meshCentroid[axis] += center * area;
+                    normals[c][axis] += normal[axis];
+                }
+                clusterArea += area;
+            }
+            meshArea += clusterArea;
+            for (float& value : centroids[c])
+            {
+                value = clusterArea > 0.0F ? value / clusterArea : 0.0F;
+            }
+        }
+        for (float& value : meshCentroid)
+        {
+            value = meshArea > 0.0F ? value / meshArea : 0.0F;
+        }
+
+        // Clusters facing away from the center are drawn first (Sander et al. 2007)
+        std::vector<float> sortKeys(clusterCount);
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            const float length = std::sqrt(dot(normals[c], normals[c]));
+            sortKeys[c] = length > 0.0F
+                ? dot(subtract(centroids[c], meshCentroid), normals[c]) / length
+                : 0.0F;
+        }
+        std::vector<uint32_t> order(clusterCount);
+        for (uint32_t c = 0; c < clusterCount; c++)
+        {
+            order[c] = c;
+        }
+        std::ranges::stable_sort(
+            order, [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> output;
+        output.reserve(triangleCount * 3);
+        for (const uint32_t c : order)
+        {
+            output.insert(output.end(), indices.begin() + boundaries[c] * 3,
+                indices.begin() + boundaries[c + 1] * 3);
+        }
+        std::ranges::copy(output, indices.begin());
+    }
+
+    size_t optimizeVertexFetch(Primitive& primitive)
+    {
+        const size_t          vertexCount = primitive.vertexCount();
+        std::vector<uint32_t> remap(vertexCount, g_unusedVertex);
+        uint32_t              next = 0;
+        for (const uint32_t index : primitive.indices)
+        {
+            if (remap[index] == g_unusedVertex)
+            {
+                remap[index] = next++;
+            }
+        }
+        remapVertices(primitive, remap, next);
+        return vertexCount - next;
+    }
+
+    void optimizeMesh(Primitive& primitive, const MeshOptimizeOptions& options)
+    {
+        if (options.weldVertices)
+        {
+            weldVertices(primitive);
+        }
+        optimizeVertexCache(primitive.indices, primitive.vertexCount(), options.cacheSize);
+
+        std::vector<std::array<float, 3>> interleavedPositions;
+        for (const auto& vertex : primitive.vertices)
+        {
+            interleavedPositions.push_back(vertex.position);
+        }
+        const auto& positions =
+            primitive.vertices.empty() ? primitive.streams.positions : interleavedPositions;
+        optimizeOverdraw(
+            primitive.indices, positions, options.overdrawThreshold, options.cacheSize);
+
+        optimizeVertexFetch(primitive);
+    }
+} // namespace Assets
@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "SceneLoader.hpp"
+
+namespace Assets
+{
+    /// @brief Post-transform cache size the optimizer targets. Small enough to hold on
+    /// any GPU, so orders tuned for it do not thrash larger caches.
+    inline constexpr uint32_t g_vertexCacheSize = 16;
+
+    /// @brief Efficiency of an index order under a simulated FIFO post-transform cache.
+    struct VertexCacheStatistics
+    {
+        size_t transforms = 0; ///< Vertex shader invocations (cache misses).
+        float  acmr = 0.0F;    ///< Average transforms per triangle; 0.5 is the ideal.
+        float  atvr = 0.0F;    ///< Average transforms per vertex; 1.0 is the ideal.
+    };
+
+    struct MeshOptimizeOptions
+    {
+        uint32_t cacheSize = g_vertexCacheSize;
+        /// Allowed ACMR increase, as a factor, to gain more clusters for overdraw sorting.
+        float overdrawThreshold = 1.05F;
+        bool  weldVertices = true;
+    };
+
+    /// @brief Simulates a FIFO cache of cacheSize vertices over the index buffer.
+    [[nodiscard]] VertexCacheStatistics analyzeVertexCache(std::span<const uint32_t> indices,
+        size_t vertexCount, uint32_t cacheSize = g_vertexCacheSize);
+
+    /// @brief Merges bitwise identical vertices and remaps the indices accordingly.
+    /// @return Number of vertices removed.
+    size_t weldVertices(Primitive& primitive);
+
+    /// @brief Reorders triangles for post-transform cache locality with Tipsify
+    /// (Sander et al. 2007), in linear time.
+    void optimizeVertexCache(
+        std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize = g_vertexCacheSize);
+
+    /// @brief Reorders clusters of a cache optimized index buffer so triangles facing
+    /// away from the mesh center, which tend to occlude the rest, are drawn first.
+    ///
+    /// Clusters start where the simulated cache restarts and are split further as long
+    /// as the ACMR stays within threshold of the original, so locality is mostly kept.
+    void optimizeOverdraw(std::span<uint32_t> indices,
+        std::span<const std::array<float, 3>> positions, float threshold = 1.05F,
+        uint32_t cacheSize = g_vertexCacheSize);
+
+    /// @brief Reorders vertices by first use in the index buffer, so vertex fetch reads
+    /// memory sequentially, and drops unreferenced vertices.
+    /// @return Number of vertices dropped.
+    size_t optimizeVertexFetch(Primitive& primitive);
+
+    /// @brief Runs the whole pipeline: welding, vertex cache, overdraw and vertex
+    /// fetch optimization.
+    void optimizeMesh(Primitive& primitive, const MeshOptimizeOptions& options = {});
+} // namespace Assets
@@ -0,0 +1,663 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "MeshOptimizer.hpp"
+
+namespace Assets
+{
+    namespace
+    {
+        constexpr uint32_t g_invalidIndex = ~0U;
+
+        /// Position, weighted normal and weighted texture coordinates.
+        constexpr size_t g_quadricDimension = 8;
+        constexpr size_t g_quadricMatrixSize = g_quadricDimension * (g_quadricDimension + 1) / 2;
+
+        /// Open edges are held in place by planes through them, weighted this much
+        /// more than the triangles.
+        constexpr float g_borderWeight = 10.0F;
+
+        /// A collapse may turn a triangle's normal by at most acos of this.
+        constexpr float g_flipThreshold = 0.25F;
+
+        using Point = std::array<float, g_quadricDimension>;
+
+        enum class VertexKind : uint8_t
+        {
+            Manifold, ///< Collapses along any edge.
+            Border,   ///< Collapses along open edges, onto other border vertices.
+            Locked,   ///< Never moves: seams, complex borders, non-manifold fans.
+        };
+
+        float dot(const Point& a, const Point& b)
+        {
+            float result = 0.0F;
+            for (size_t i = 0; i < g_quadricDimension; i++)
+            {
+                result += a[i] * b[i];
+            }
+            return result;
+        }
+
+        std::array<float, 3> cross(const std::array<float, 3>& a, const std::array<float, 3>& b)
+        {
+            return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+                a[0] * b[1] - a[1] * b[0] };
+        }
+
+        float dot3(const std::array<float, 3>& a, const std::array<float, 3>& b)
+        {
+            return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+        }
+
+        std::array<float, 3> position(const Point& point)
+        {
+            return { point[0], point[1], point[2] };
+        }
+
+        std::array<float, 3> subtract(const std::array<float, 3>& a, const std::array<float, 3>& b)
+        {
+            return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+        }
+
+        /// Quadric error of Garland and Heckbert (1998) over points with attributes,
+        /// x'Ax + 2b'x + c, summed over triangles weighted by their area.
+        struct Quadric
+        {
+            std::array<float, g_quadricMatrixSize> a {}; ///< Upper triangle, row by row.
+            Point                                  b {};
+            float                                  c = 0.0F;
+            float                                  weight = 0.0F;
+
+            Quadric& operator+=(const Quadric& other)
+            {
+                for (size_t i = 0; i < a.size(); i++)
+                {
+                    a[i] += other.a[i];
+                }
+                for (size_t i = 0; i < b.size(); i++)
+                {
+                    b[i] += other.b[i];
+                }
+                c += other.c;
+                weight += other.weight;
+                return *this;
+            }
+
+            [[nodiscard]] float evaluate(const Point& x) const
+            {
+                float  result = c;
+                size_t k = 0;
+                for (size_t i = 0; i < g_quadricDimension; i++)
+                {
+                    float row = a[k++] * x[i];
+                    for (size_t j = i + 1; j < g_quadricDimension; j++)
+                    {
+                        row += 2.0F * a[k++] * x[j];
+                    }
+                    result += x[i] * row + 2.0F * b[i] * x[i];
+                }
+                return result;
+            }
+        };
+
+        /// Squared distance to the plane through the triangle in the extended space.
+        Quadric triangleQuadric(const Point& p, const Point& q, const Point& r)
+        {
+            const auto normal
+                = cross(subtract(position(q), position(p)), subtract(position(r), position(p)));
+            const float area = 0.5F * std::sqrt(dot3(normal, normal));
+
+            // Orthonormal basis of the triangle
+            Point e1 {};
+            Point e2 {};
+            for (size_t i = 0; i < g_quadricDimension; i++)
+            {
+                e1[i] = q[i] - p[i];
+                e2[i] = r[i] - p[i];
+            }
+            const float length1 = std::sqrt(dot(e1, e1));
+            if (area == 0.0F || length1 == 0.0F)
+            {
+                return {};
+            }
+            for (float& value : e1)
+            {
+                value /= length1;
+            }
+            const float along = dot(e2, e1);
+            for (size_t i = 0; i < g_quadricDimension; i++)
+            {
+                e2[i] -= along * e1[i];
+            }
+            const float length2 = std::sqrt(dot(e2, e2));
+            if (length2 == 0.0F)
+            {
+                return {};
+            }
+            for (float& value : e2)
+            {
+                value /= length2;
+            }
+
+            const float pe1 = dot(p, e1);
+            const float pe2 = dot(p, e2);
+            Quadric     quadric;
+            size_t      k = 0;
+            for (size_t i = 0; i < g_quadricDimension; i++)
+            {
+                for (size_t j = i; j < g_quadricDimension; j++)
+                {
+                    const float identity = i == j ? 1.0F : 0.0F;
+                    quadric.a[k++] = area * (identity - e1[i] * e1[j] - e2[i] * e2[j]);
+                }
+                quadric.b[i] = area * (pe1 * e1[i] + pe2 * e2[i] - p[i]);
+            }
+            quadric.c = area * (dot(p, p) - pe1 * pe1 - pe2 * pe2);
+            quadric.weight = area;
+            return quadric;
+        }
+
+        /// Squared distance to a plane in position space.
+        Quadric planeQuadric(
+            const std::array<float, 3>& normal, const float distance, const float weight)
+        {
+            Quadric quadric;
+            size_t  k = 0;
+            for (size_t i = 0; i < g_quadricDimension; i++)
+            {
+                for (size_t j = i; j < g_quadricDimension; j++)
+                {
+                    quadric.a[k++] = i < 3 && j < 3 ? weight * normal[i] * normal[j] : 0.0F;
+                }
+            }
+            for (size_t i = 0; i < 3; i++)
+            {
+                quadric.b[i] = weight * distance * normal[i];
+            }
+            quadric.c = weight * distance * distance;
+            quadric.weight = weight;
+            return quadric;
+        }
+
+        /// Maps every vertex to the first vertex with a bitwise identical position, so
+        /// topology is seen through attribute seams.
+        std::vector<uint32_t> canonicalVertices(
+            const std::span<const std::array<float, 3>> positions)
+        {
+            const auto hash = [](const std::array<float, 3>& position) {
+                uint64_t value = std::bit_cast<uint32_t>(position[0]) * 73856093ULL
+                    ^ std::bit_cast<uint32_t>(position[1]) * 19349663ULL
+                    ^ std::bit_cast<uint32_t>(position[2]) * 83492791ULL;
+                value ^= value >> 33;
+                value *= 0xFF51AFD7ED558CCDULL;
+                value ^= value >> 33;
+                return value;
+            };
+            const auto equal = [](const std::array<float, 3>& a, const std::array<float, 3>& b) {
+                return std::bit_cast<std::array<uint32_t, 3>>(a)
+                    == std::bit_cast<std::array<uint32_t, 3>>(b);
+            };
+
+            const size_t          tableSize = std::bit_ceil(positions.size() * 2);
+            std::vector<uint32_t> table(tableSize, g_invalidIndex);
+            std::vector<uint32_t> canonical(positions.size());
+            for (size_t i = 0; i < positions.size(); i++)
+            {
+                size_t slot = hash(positions[i]) & (tableSize - 1);
+                while (
+                    table[slot] != g_invalidIndex && !equal(positions[table[slot]], positions[i]))
+                {
+                    slot = (slot + 1) & (tableSize - 1);
+                }
+                if (table[slot] == g_invalidIndex)
+                {
+                    table[slot] = static_cast<uint32_t>(i);
+                }
+                canonical[i] = table[slot];
+            }
+            return canonical;
+        }
+
+        uint64_t edgeKey(const uint32_t from, const uint32_t to)
+        {
+            return (uint64_t { from } << 32) | to;
+        }
+
+        /// Directed edges between canonical vertices, sorted for lookups.
+        class EdgeSet
+        {
+        public:
+            EdgeSet(
+                const std::span<const uint32_t> indices, const std::span<const uint32_t> canonical)
+            {
+                m_edges.reserve(indices.size());
+                for (size_t i = 0; i < indices.size(); i += 3)
+                {
+                    for (size_t k = 0; k < 3; k++)
+                    {
+                        const uint32_t from = canonical[indices[i + k]];
+                        const uint32_t to = canonical[indices[i + (k + 1) % 3]];
+                        if (from != to)
+                        {
+                            m_edges.push_back(edgeKey(from, to));
+                        }
+                    }
+                }
+                std::ranges::sort(m_edges);
+            }
+
+            [[nodiscard]] std::span<const uint64_t> edges() const
+            {
+                return m_edges;
+            }
+
+            [[nodiscard]] bool contains(const uint32_t from, const uint32_t to) const
+            {
+                return std::ranges::binary_search(m_edges, edgeKey(from, to));
+            }
+
+            /// An edge is open when only one of its triangles exists.
+            [[nodiscard]] bool isOpen(const uint32_t a, const uint32_t b) const
+            {
+                return !contains(a, b) || !contains(b, a);
+            }
+
+        private:
+            std::vector<uint64_t> m_edges;
+        };
+
+        std::vector<VertexKind> classifyVertices(const std::span<const uint32_t> indices,
+            const std::span<const uint32_t> canonical, const EdgeSet& edges, const bool lockBorder)
+        {
+            const size_t         vertexCount = canonical.size();
+            std::vector<uint8_t> referenced(vertexCount, 0);
+            for (const uint32_t index : indices)
+            {
+                referenced[index] = 1;
+            }
+            std::vector<uint32_t> wedges(vertexCount, 0);
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                wedges[canonical[v]] += referenced[v];
+            }
+
+            std::vector<uint32_t> openEdges(vertexCount, 0);
+            std::vector<uint8_t>  complex(vertexCount, 0);
+            const auto            all = edges.edges();
+            for (size_t e = 0; e < all.size(); e++)
+            {
+                const auto from = static_cast<uint32_t>(all[e] >> 32);
+                const auto to = static_cast<uint32_t>(all[e]);
+                if (e > 0 && all[e - 1] == all[e])
+                {
+                    // Shared by more than two triangles or inconsistently wound
+                    complex[from] = 1;
+                    complex[to] = 1;
+                }
+                if (!edges.contains(to, from))
+                {
+                    openEdges[from]++;
+                    openEdges[to]++;
+                }
+            }
+
+            std::vector<VertexKind> kinds(vertexCount, VertexKind::Manifold);
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                const uint32_t c = canonical[v];
+                if (wedges[c] > 1 || complex[c] != 0 || openEdges[c] > 2)
+                {
+                    kinds[v] = VertexKind::Locked;
+                }
+                else if (openEdges[c] > 0)
+                {
+                    kinds[v] = lockBorder ? VertexKind::Locked : VertexKind::Border;
+                }
+            }
+            return kinds;
+        }
+
+        /// Triangles adjacent to each vertex, in compressed rows.
+        void buildAdjacency(const std::span<const uint32_t> indices, const size_t vertexCount,
+            std::vector<uint32_t>& offsets, std::vector<uint32_t>& adjacency)
+        {
+            offsets.assign(vertexCount + 1, 0);
+            for (const uint32_t index : indices)
+            {
+                offsets[index + 1]++;
+            }
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                offsets[v + 1] += offsets[v];
+            }
+            adjacency.resize(indices.size());
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        struct Collapse
+        {
+            float    cost;
+            uint32_t from;
+            uint32_t to;
+        };
+    } // namespace
+
+    SimplifyResult simplifyMesh(const std::span<const uint32_t> indices,
+        const VertexStreams& vertices, const size_t targetIndexCount,
+        const SimplifyOptions& options)
+    {
+        SimplifyResult result;
+        result.indices.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+        const auto&  positions = vertices.positions;
+        const size_t vertexCount = positions.size();
+        if (result.indices.size() <= targetIndexCount || vertexCount == 0)
+        {
+            return result;
+        }
+
+        // Positions scaled to a unit extent, so errors come out relative to it
+        std::array<float, 3> boundsMin = positions.front();
+        std::array<float, 3> boundsMax = positions.front();
+        for (const auto& p : positions)
+        {
+            for (size_t axis = 0; axis < 3; axis++)
+            {
+                boundsMin[axis] = std::min(boundsMin[axis], p[axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], p[axis]);
+            }
+        }
+        const float extent = std::max({ boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1],
+            boundsMax[2] - boundsMin[2] });
+        const float scale = extent > 0.0F ? 1.0F / extent : 0.0F;
+
+        const bool         hasNormals = vertices.normals.size() == vertexCount;
+        const bool         hasTexCoords = vertices.texCoords.size() == vertexCount;
+        std::vector<Point> points(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            Point& point = points[v];
+            for (size_t axis = 0; axis < 3; axis++)
+            {
+                point[axis] = (positions[v][axis] - boundsMin[axis]) * scale;
+                point[3 + axis]
+                    = hasNormals ? vertices.normals[v][axis] * options.normalWeight : 0.0F;
+            }
+            for (size_t axis = 0; axis < 2; axis++)
+            {
+                point[6 + axis]
+                    = hasTexCoords ? vertices.texCoords[v][axis] * options.texCoordWeight : 0.0F;
+            }
+        }
+
+        const std::vector<uint32_t>   canonical = canonicalVertices(positions);
+        const EdgeSet                 edges(result.indices, canonical);
+        const std::vector<VertexKind> kinds
+            = classifyVertices(result.indices, canonical, edges, options.lockBorder);
+
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i < result.indices.size(); i += 3)
+        {
+            const uint32_t* triangle = &result.indices[i];
+            const Quadric   quadric
+                = triangleQuadric(points[triangle[0]], points[triangle[1]], points[triangle[2]]);
+            for (size_t k = 0; k < 3; k++)
+            {
+                quadrics[triangle[k]] += quadric;
+            }
+            if (options.lockBorder)
+            {
+                continue;
+            }
+
+            // Planes perpendicular to the triangle keep open edges from wandering
+            const auto p0 = position(points[triangle[0]]);
+            const auto normal = cross(subtract(position(points[triangle[1]]), p0),
+                subtract(position(points[triangle[2]]), p0));
+            for (size_t k = 0; k < 3; k++)
+            {
+                const uint32_t from = triangle[k];
+                const uint32_t to = triangle[(k + 1) % 3];
+                if (edges.contains(canonical[to], canonical[from]))
+                {
+                    continue;
+                }
+                const auto  edge = subtract(position(points[to]), position(points[from]));
+                auto        planeNormal = cross(edge, normal);
+                const float length = std::sqrt(dot3(planeNormal, planeNormal));
+                if (length == 0.0F)
+                {
+                    continue;
+                }
+                for (float& value : planeNormal)
+                {
+                    value /= length;
+                }
+                const Quadric border = planeQuadric(planeNormal,
+                    -dot3(planeNormal, position(points[from])), dot3(edge, edge) * g_borderWeight);
+                quadrics[from] += border;
+                quadrics[to] += border;
+            }
+        }
+
+        const auto canCollapse = [&](const uint32_t from, const uint32_t to) {
+            switch (kinds[from])
+            {
+            case VertexKind::Manifold:
+                return true;
+            case VertexKind::Border:
+                return kinds[to] != VertexKind::Manifold
+                    && edges.isOpen(canonical[from], canonical[to]);
+            default:
+                return false;
+            }
+        };
+
+        const auto collapseCost = [&](const uint32_t from, const uint32_t to) {
+            const float error
+                = quadrics[from].evaluate(points[to]) + quadrics[to].evaluate(points[to]);
+            const float weight = quadrics[from].weight + quadrics[to].weight;
+            return weight > 0.0F ? std::max(error, 0.0F) / weight : 0.0F;
+        };
+
+        std::vector<uint32_t> remap(vertexCount);
+        std::iota(remap.begin(), remap.end(), 0U);
+        std::vector<uint8_t>  collapseLocked(vertexCount);
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+
+        // Moving from onto to must not turn any surviving triangle around too far;
+        // counts the triangles the collapse removes
+        const auto checkCollapse = [&](const uint32_t from, const uint32_t to, size_t& removed) {
+            const auto target = position(points[to]);
+            for (uint32_t i = offsets[from]; i < offsets[from + 1]; i++)
+            {
+                const uint32_t*               triangle = &result.indices[adjacency[i] * 3];
+                const std::array<uint32_t, 3> corners
+                    = { remap[triangle[0]], remap[triangle[1]], remap[triangle[2]] };
+                if (std::ranges::find(corners, to) != corners.end())
+                {
+                    removed++;
+                    continue;
+                }
+
+                const auto p0 = position(points[corners[0]]);
+                const auto p1 = position(points[corners[1]]);
+                const auto p2 = position(points[corners[2]]);
+                const auto before = cross(subtract(p1, p0), subtract(p2, p0));
+                const auto corner = std::ranges::find(corners, from) - corners.begin();
+                std::array<std::array<float, 3>, 3> moved = { p0, p1, p2 };
+                moved[corner] = target;
+                const auto after
+                    = cross(subtract(moved[1], moved[0]), subtract(moved[2], moved[0]));
+                if (dot3(before, after)
+                    <= g_flipThreshold * std::sqrt(dot3(before, before) * dot3(after, after)))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        const float  errorLimit = options.targetError * options.targetError;
+        const size_t targetTriangles = targetIndexCount / 3;
+        size_t       triangleCount = result.indices.size() / 3;
+        float        maxCost = 0.0F;
+        // Queues the cheaper direction of an edge, if it is within the error limit
+        const auto addCollapse = [&](const uint32_t a, const uint32_t b) {
+            Collapse collapse { std::numeric_limits<float>::max(), a, b };
+            if (canCollapse(a, b))
+            {
+                collapse.cost = collapseCost(a, b);
+            }
+            if (canCollapse(b, a))
+            {
+                const float cost = collapseCost(b, a);
+                if (cost < collapse.cost)
+                {
+                    collapse = { cost, b, a };
+                }
+            }
+            if (collapse.cost <= errorLimit)
+            {
+                collapses.push_back(collapse);
+            }
+        };
+
+        while (triangleCount > targetTriangles)
+        {
+            collapses.clear();
+            for (size_t i = 0; i < result.indices.size(); i += 3)
+            {
+                for (size_t k = 0; k < 3; k++)
+                {
+                    const uint32_t a = result.indices[i + k];
+                    const uint32_t b = result.indices[i + (k + 1) % 3];
+                    // Interior edges come up once from each side
+                    if (a > b
+                        && (kinds[a] == VertexKind::Manifold || kinds[b] == VertexKind::Manifold))
+                    {
+                        continue;
+                    }
+                    addCollapse(a, b);
+                }
+            }
+            if (collapses.empty())
+            {
+                break;
+            }
+            std::ranges::sort(collapses, {}, &Collapse::cost);
+
+            // Collapses touching a vertex moved in this pass wait for the next one, as
+            // their cost is stale
+            buildAdjacency(result.indices, vertexCount, offsets, adjacency);
+            std::ranges::fill(collapseLocked, 0);
+            const size_t goal = triangleCount - targetTriangles;
+            size_t       removed = 0;
+            size_t       performed = 0;
+            for (const Collapse& collapse : collapses)
+            {
+                if (collapseLocked[collapse.from] != 0 || collapseLocked[collapse.to] != 0)
+                {
+                    continue;
+                }
+                size_t collapseRemoved = 0;
+                if (!checkCollapse(collapse.from, collapse.to, collapseRemoved))
+                {
+                    continue;
+                }
+
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                collapseLocked[collapse.from] = 1;
+                collapseLocked[collapse.to] = 1;
+                maxCost = std::max(maxCost, collapse.cost);
+                removed += collapseRemoved;
+                performed++;
+                if (removed >= goal)
+                {
+                    break;
+                }
+            }
+            if (performed == 0)
+            {
+                break;
+            }
+
+            size_t written = 0;
+            for (size_t i = 0; i < result.indices.size(); i += 3)
+            {
+                const uint32_t a = remap[result.indices[i]];
+                const uint32_t b = remap[result.indices[i + 1]];
+                const uint32_t c = remap[result.indices[i + 2]];
+                if (a != b && b != c && c != a)
+                {
+                    result.indices[written++] = a;
+                    result.indices[written++] = b;
+                    result.indices[written++] = c;
+                }
+            }
+            result.indices.resize(written);
+            triangleCount = written / 3;
+        }
+
+        result.error = std::sqrt(maxCost);
+        return result;
+    }
+
+    std::vector<SimplifyResult> generateLodChain(const std::span<const uint32_t> indices,
+        const VertexStreams& vertices, const LodChainOptions& options)
+    {
+        std::vector<SimplifyResult> lods;
+        lods.push_back({ { indices.begin(), indices.end() }, 0.0F });
+
+        while (lods.size() < options.maxLods)
+        {
+            const SimplifyResult& previous = lods.back();
+            const size_t          previousTriangles = previous.indices.size() / 3;
+            const auto            targetTriangles
+                = static_cast<size_t>(static_cast<float>(previousTriangles) * options.ratio);
+            const float budget = options.maxError - previous.error;
+            if (targetTriangles < options.minTriangles || budget <= 0.0F)
+            {
+                break;
+            }
+
+            SimplifyOptions simplify = options.simplify;
+            simplify.targetError = budget;
+            SimplifyResult level
+                = simplifyMesh(previous.indices, vertices, targetTriangles * 3, simplify);
+
+            // Stop once locked vertices or the budget keep a level from getting
+            // halfway to its target
+            const float reduction = (1.0F + options.ratio) * 0.5F;
+            if (static_cast<float>(level.indices.size())
+                > static_cast<float>(previous.indices.size()) * reduction)
+            {
+                break;
+            }
+
+            // Errors are measured against the previous level, so they add up
+            level.error += previous.error;
+            optimizeVertexCache(level.indices, vertices.positions.size());
+            lods.push_back(std::move(level));
+        }
+        return lods;
+    }
+} // namespace Assets
@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SceneLoader.hpp"
+
+namespace Assets
+{
+    struct SimplifyOptions
+    {
+        /// Largest error allowed, relative to the mesh extent.
+        float targetError = 1.0e-2F;
+        /// Keep vertices on open borders in place, so meshes made of several pieces do
+        /// not crack apart.
+        bool lockBorder = true;
+        /// Weight of normal and texture coordinate deviation against position error;
+        /// 0 ignores the attribute.
+        float normalWeight = 0.5F;
+        float texCoordWeight = 0.5F;
+    };
+
+    struct SimplifyResult
+    {
+        std::vector<uint32_t> indices;
+        float                 error = 0.0F; ///< Relative to the mesh extent.
+    };
+
+    /// @brief Reduces a triangle list towards targetIndexCount indices without
+    /// exceeding the target error.
+    ///
+    /// Edges collapse onto one of their vertices, cheapest first by the quadric error
+    /// of Garland and Heckbert extended with normals and texture coordinates, so the
+    /// result indexes the original vertices and LODs can share one vertex buffer.
+    /// Vertices on attribute seams, and on borders when locked, stay in place;
+    /// collapses that would flip a triangle are skipped.
+    [[nodiscard]] SimplifyResult simplifyMesh(std::span<const uint32_t> indices,
+        const VertexStreams& vertices, size_t targetIndexCount,
+        const SimplifyOptions& options = {});
+
+    struct LodChainOptions
+    {
+        uint32_t        maxLods = 5;     ///< Including the full detail level.
+        float           ratio = 0.5F;    ///< Triangles kept from one level to the next.
+        float           maxError = 0.1F; ///< Largest accumulated error, relative to extent.
+        size_t          minTriangles = 32;
+        SimplifyOptions simplify;        ///< Its targetError is replaced by the budget.
+    };
+
+    /// @brief Builds progressively coarser index buffers over the same vertices, full
+    /// detail first.
+    ///
+    /// Each level simplifies the previous one and records the accumulated error. The
+    /// chain ends early once a level cannot shrink by a useful amount within the error
+    /// budget. Every level is reordered for the post-transform cache.
+    [[nodiscard]] std::vector<SimplifyResult> generateLodChain(std::span<const uint32_t> indices,
+        const VertexStreams& vertices, const LodChainOptions& options = {});
+} // namespace Assets
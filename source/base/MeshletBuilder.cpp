@@ -0,0 +1,384 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "MeshletBuilder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Assets
+{
+    namespace
+    {
+        constexpr uint32_t g_invalidIndex = ~0U;
+        constexpr uint32_t g_vertexLimit = 256;
+        constexpr uint32_t g_triangleLimit = 512;
+
+        std::array<float, 3> subtract(const std::array<float, 3>& a, const std::array<float, 3>& b)
+        {
+            return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+        }
+
+        std::array<float, 3> cross(const std::array<float, 3>& a, const std::array<float, 3>& b)
+        {
+            return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+                a[0] * b[1] - a[1] * b[0] };
+        }
+
+        float dot(const std::array<float, 3>& a, const std::array<float, 3>& b)
+        {
+            return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+        }
+
+        float length(const std::array<float, 3>& a)
+        {
+            return std::sqrt(dot(a, a));
+        }
+
+        /// Fills in the bounding sphere and normal cone of a finished meshlet.
+        void computeBounds(Meshlet& meshlet, const std::span<const uint32_t> vertices,
+            const std::span<const uint8_t> triangles,
+            const std::span<const std::array<float, 3>> positions)
+        {
+            const auto position = [&](const uint32_t local) -> const std::array<float, 3>& {
+                return positions[vertices[meshlet.vertexOffset + local]];
+            };
+
+            // Sphere around the box center: not minimal, but close for compact meshlets
+            std::array<float, 3> boundsMin = position(0);
+            std::array<float, 3> boundsMax = position(0);
+            for (uint32_t i = 1; i < meshlet.vertexCount; i++)
+            {
+                for (size_t axis = 0; axis < 3; axis++)
+                {
+                    boundsMin[axis] = std::min(boundsMin[axis], position(i)[axis]);
+                    boundsMax[axis] = std::max(boundsMax[axis], position(i)[axis]);
+                }
+            }
+            for (size_t axis = 0; axis < 3; axis++)
+            {
+                meshlet.center[axis] = (boundsMin[axis] + boundsMax[axis]) * 0.5F;
+            }
+            meshlet.radius = 0.0F;
+            for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+            {
+                meshlet.radius
+                    = std::max(meshlet.radius, length(subtract(position(i), meshlet.center)));
+            }
+
+            std::array<std::array<float, 3>, g_triangleLimit> normals {};
+            size_t                                          normalCount = 0;
+            std::array<float, 3>                            normalSum {};
+            for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+            {
+                const uint8_t* triangle = &triangles[meshlet.triangleOffset + t * 3];
+                const auto&    a = position(triangle[0]);
+                const auto     normal = cross(
+                    subtract(position(triangle[1]), a), subtract(position(triangle[2]), a));
+                const float normalLength = length(normal);
+                if (normalLength == 0.0F)
+                {
+                    continue;
+                }
+                auto& unit = normals[normalCount++];
+                for (size_t axis = 0; axis < 3; axis++)
+                {
+                    unit[axis] = normal[axis] / normalLength;
+                    normalSum[axis] += unit[axis];
+                }
+            }
+
+            meshlet.coneAxis = {};
+            meshlet.coneCutoff = 1.0F;
+            const float sumLength = length(normalSum);
+            if (normalCount == 0 || sumLength == 0.0F)
+            {
+                return;
+            }
+            for (size_t axis = 0; axis < 3; axis++)
+            {
+                meshlet.coneAxis[axis] = normalSum[axis] / sumLength;
+            }
+
+            // Normals spread by up to acos(minimumDot) around the axis, so every
+            // triangle faces away from views within 90 degrees minus that of the axis
+            float minimumDot = 1.0F;
+            for (size_t i = 0; i < normalCount; i++)
+            {
+                minimumDot = std::min(minimumDot, dot(normals[i], meshlet.coneAxis));
+            }
+            if (minimumDot > 0.0F)
+            {
+                meshlet.coneCutoff = std::sqrt(1.0F - minimumDot * minimumDot);
+            }
+        }
+    } // namespace
+
+    MeshletData buildMeshlets(const std::span<const uint32_t> indices,
+        const std::span<const std::array<float, 3>> positions, const MeshletBuildOptions& options)
+    {
+        const uint32_t maxVertices = std::clamp(options.maxVertices, 3U, g_vertexLimit);
+        const uint32_t maxTriangles = std::clamp(options.maxTriangles, 1U, g_triangleLimit);
+        const size_t   triangleCount = indices.size() / 3;
+        const size_t   vertexCount = positions.size();
+
+        MeshletData data;
+        if (triangleCount == 0)
+        {
+            return data;
+        }
+        data.meshlets.reserve(triangleCount / maxTriangles + 1);
+        data.vertices.reserve(triangleCount);
+        data.triangles.reserve(triangleCount * 3);
+
+        // Triangles adjacent to each vertex, in compressed rows
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            offsets[indices[i] + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            offsets[v + 1] += offsets[v];
+        }
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<std::array<float, 3>> centroids(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const auto& a = positions[indices[t * 3]];
+            const auto& b = positions[indices[t * 3 + 1]];
+            const auto& c = positions[indices[t * 3 + 2]];
+            for (size_t axis = 0; axis < 3; axis++)
+            {
+                centroids[t][axis] = (a[axis] + b[axis] + c[axis]) / 3.0F;
+            }
+        }
+
+        struct Candidate
+        {
+            uint32_t triangle;
+            float    distance; ///< Squared, between centroids.
+        };
+
+        // Index slots of each triangle whose vertex is not in the meshlet yet, kept up
+        // to date as vertices are added so candidates are scored without lookups
+        std::vector<uint8_t>   missing(triangleCount, 3);
+        std::vector<uint8_t>   used(triangleCount, 0);
+        std::vector<uint32_t>  candidateStamps(triangleCount, 0);
+        std::vector<uint32_t>  localIndices(vertexCount, g_invalidIndex);
+        std::vector<Candidate> candidates;
+        std::vector<uint32_t>  ready; ///< Candidates adding no vertices.
+        Meshlet                meshlet;
+        std::array<float, 3>   seed {};
+        size_t                 scan = 0;
+
+        const auto finishMeshlet = [&] {
+            for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+            {
+                const uint32_t vertex = data.vertices[meshlet.vertexOffset + i];
+                localIndices[vertex] = g_invalidIndex;
+                for (uint32_t j = offsets[vertex]; j < offsets[vertex + 1]; j++)
+                {
+                    missing[adjacency[j]] = 3;
+                }
+            }
+            computeBounds(meshlet, data.vertices, data.triangles, positions);
+            data.meshlets.push_back(meshlet);
+
+            meshlet = {};
+            meshlet.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+            meshlet.triangleOffset = static_cast<uint32_t>(data.triangles.size());
+            candidates.clear();
+            ready.clear();
+        };
+
+        const auto addVertex = [&](const uint32_t vertex) {
+            localIndices[vertex] = meshlet.vertexCount++;
+            data.vertices.push_back(vertex);
+
+            // Stamps are one past the meshlet index, so each neighbor is queued once
+            const auto stamp = static_cast<uint32_t>(data.meshlets.size() + 1);
+            for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; i++)
+            {
+                const uint32_t neighbor = adjacency[i];
+                if (used[neighbor] != 0)
+                {
+                    continue;
+                }
+                if (--missing[neighbor] == 0)
+                {
+                    ready.push_back(neighbor);
+                }
+                if (candidateStamps[neighbor] != stamp)
+                {
+                    candidateStamps[neighbor] = stamp;
+                    const auto offset = subtract(centroids[neighbor], seed);
+                    candidates.push_back({ neighbor, dot(offset, offset) });
+                }
+            }
+        };
+
+        const auto addTriangle = [&](const uint32_t triangle) {
+            if (meshlet.triangleCount == 0)
+            {
+                seed = centroids[triangle];
+            }
+            used[triangle] = 1;
+            for (size_t k = 0; k < 3; k++)
+            {
+                const uint32_t vertex = indices[triangle * 3 + k];
+                if (localIndices[vertex] == g_invalidIndex)
+                {
+                    addVertex(vertex);
+                }
+                data.triangles.push_back(static_cast<uint8_t>(localIndices[vertex]));
+            }
+            meshlet.triangleCount++;
+        };
+
+        for (size_t emitted = 0; emitted < triangleCount; emitted++)
+        {
+            // Triangles adding no vertices end up in the meshlet whatever their order,
+            // so they are taken as soon as they appear
+            uint32_t best = g_invalidIndex;
+            while (best == g_invalidIndex && !ready.empty())
+            {
+                const uint32_t triangle = ready.back();
+                ready.pop_back();
+                if (used[triangle] == 0)
+                {
+                    best = triangle;
+                }
+            }
+
+            if (best == g_invalidIndex)
+            {
+                uint32_t bestMissing = 4;
+                float    bestDistance = std::numeric_limits<float>::max();
+                for (size_t i = candidates.size(); i-- > 0;)
+                {
+                    const Candidate candidate = candidates[i];
+                    if (used[candidate.triangle] != 0)
+                    {
+                        candidates[i] = candidates.back();
+                        candidates.pop_back();
+                        continue;
+                    }
+                    const uint32_t count = missing[candidate.triangle];
+                    if (count < bestMissing
+                        || (count == bestMissing && candidate.distance < bestDistance))
+                    {
+                        best = candidate.triangle;
+                        bestMissing = count;
+                        bestDistance = candidate.distance;
+                    }
+                }
+            }
+
+            if (best == g_invalidIndex)
+            {
+                // Disconnected from the meshlet: continue with the next triangle in
+                // index order, which a cache optimized index buffer keeps nearby
+                while (used[scan] != 0)
+                {
+                    scan++;
+                }
+                best = static_cast<uint32_t>(scan);
+            }
+
+            // Repeated vertices count twice, which only errs on the safe side
+            if (meshlet.vertexCount + missing[best] > maxVertices
+                || meshlet.triangleCount + 1 > maxTriangles)
+            {
+                finishMeshlet();
+            }
+            addTriangle(best);
+        }
+        finishMeshlet();
+        return data;
+    }
+
+    Frustum extractFrustum(const Matrix4& transform)
+    {
+        // Row-vector convention: clip = position * transform, so clip component i is
+        // the dot product with column i
+        const auto column = [&transform](const size_t i) {
+            return std::array<float, 4> { transform[i], transform[4 + i], transform[8 + i],
+                transform[12 + i] };
+        };
+        const auto x = column(0);
+        const auto y = column(1);
+        const auto z = column(2);
+        const auto w = column(3);
+
+        Frustum frustum;
+        for (size_t i = 0; i < 4; i++)
+        {
+            frustum.planes[0][i] = w[i] + x[i];
+            frustum.planes[1][i] = w[i] - x[i];
+            frustum.planes[2][i] = w[i] + y[i];
+            frustum.planes[3][i] = w[i] - y[i];
+            frustum.planes[4][i] = z[i];
+            frustum.planes[5][i] = w[i] - z[i];
+        }
+        for (auto& plane : frustum.planes)
+        {
+            const float planeLength = length({ plane[0], plane[1], plane[2] });
+            if (planeLength > 0.0F)
+            {
+                for (float& value : plane)
+                {
+                    value /= planeLength;
+                }
+            }
+        }
+        return frustum;
+    }
+
+    bool isMeshletVisible(const Meshlet& meshlet, const Frustum& frustum,
+        const std::array<float, 3>& cameraPosition, MeshletCullStatistics& statistics)
+    {
+        statistics.tested++;
+        for (const auto& plane : frustum.planes)
+        {
+            if (dot({ plane[0], plane[1], plane[2] }, meshlet.center) + plane[3] < -meshlet.radius)
+            {
+                statistics.frustumRejected++;
+                return false;
+            }
+        }
+
+        // The view direction to the sphere center lies within the cone, widened by
+        // the angle the sphere subtends
+        const auto  direction = subtract(meshlet.center, cameraPosition);
+        const float distance = length(direction);
+        if (dot(direction, meshlet.coneAxis) >= meshlet.coneCutoff * distance + meshlet.radius)
+        {
+            statistics.coneRejected++;
+            return false;
+        }
+        return true;
+    }
+
+    void cullMeshlets(const std::span<const Meshlet> meshlets, const Frustum& frustum,
+        const std::array<float, 3>& cameraPosition, std::vector<uint32_t>& visible,
+        MeshletCullStatistics& statistics)
+    {
+        for (size_t i = 0; i < meshlets.size(); i++)
+        {
+            if (isMeshletVisible(meshlets[i], frustum, cameraPosition, statistics))
+            {
+                visible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+} // namespace Assets
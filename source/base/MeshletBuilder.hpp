@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SceneLoader.hpp"
+
+namespace Assets
+{
+    /// @brief Meshlet limits. 64 vertices keep the local indices in a byte and fit the
+    /// threadgroup of a mesh shader; 124 triangles leave the triangle array a multiple
+    /// of 4 bytes.
+    inline constexpr uint32_t g_meshletMaxVertices = 64;
+    inline constexpr uint32_t g_meshletMaxTriangles = 124;
+
+    /// @brief Small cluster of triangles with culling bounds, in the space of the
+    /// primitive's positions.
+    struct Meshlet
+    {
+        uint32_t             vertexOffset = 0;   ///< Into the meshlet vertices.
+        uint32_t             triangleOffset = 0; ///< Into the meshlet triangles.
+        uint32_t             vertexCount = 0;
+        uint32_t             triangleCount = 0;
+        std::array<float, 3> center {}; ///< Bounding sphere.
+        float                radius = 0.0F;
+        std::array<float, 3> coneAxis {}; ///< Average triangle normal.
+        /// Cosine of the half angle of the cone of view directions, around coneAxis,
+        /// from which every triangle is back facing; 1 disables the test.
+        float coneCutoff = 1.0F;
+    };
+
+    struct MeshletData
+    {
+        std::vector<Meshlet>  meshlets;
+        std::vector<uint32_t> vertices;  ///< Primitive vertex indices.
+        std::vector<uint8_t>  triangles; ///< Meshlet local index triplets.
+    };
+
+    struct MeshletBuildOptions
+    {
+        uint32_t maxVertices = g_meshletMaxVertices;   ///< At most 256.
+        uint32_t maxTriangles = g_meshletMaxTriangles; ///< At most 512.
+    };
+
+    /// @brief Splits an indexed triangle list into meshlets.
+    ///
+    /// Meshlets grow greedily: the next triangle is the neighbor adding the fewest new
+    /// vertices, closest to the meshlet's first triangle on ties. When no neighbor is
+    /// left the next unused triangle in index order continues it, so a cache optimized
+    /// index buffer keeps the meshlets compact.
+    [[nodiscard]] MeshletData buildMeshlets(std::span<const uint32_t> indices,
+        std::span<const std::array<float, 3>> positions, const MeshletBuildOptions& options = {});
+
+    /// @brief Six normalized planes (xyz normal, w distance) facing into the frustum:
+    /// left, right, bottom, top, near and far.
+    struct Frustum
+    {
+        std::array<std::array<float, 4>, 6> planes {};
+    };
+
+    /// @brief Extracts the planes of a row-vector transform into Metal clip space
+    /// (z in [0, w]), after Gribb and Hartmann.
+    ///
+    /// Passing model * viewProjection gives planes in object space, where the meshlet
+    /// bounds can be tested without transforming them.
+    [[nodiscard]] Frustum extractFrustum(const Matrix4& transform);
+
+    struct MeshletCullStatistics
+    {
+        size_t tested = 0;
+        size_t frustumRejected = 0;
+        size_t coneRejected = 0;
+
+        [[nodiscard]] size_t visible() const
+        {
+            return tested - frustumRejected - coneRejected;
+        }
+    };
+
+    /// @brief Reference version of the per-meshlet culling a task shader performs:
+    /// a bounding sphere against frustum test, then the back facing cone test.
+    [[nodiscard]] bool isMeshletVisible(const Meshlet& meshlet, const Frustum& frustum,
+        const std::array<float, 3>& cameraPosition, MeshletCullStatistics& statistics);
+
+    /// @brief Appends the indices of the visible meshlets to visible.
+    /// @param [in] cameraPosition In the same space as the frustum.
+    void cullMeshlets(std::span<const Meshlet> meshlets, const Frustum& frustum,
+        const std::array<float, 3>& cameraPosition, std::vector<uint32_t>& visible,
+        MeshletCullStatistics& statistics);
+} // namespace Assets
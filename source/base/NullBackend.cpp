@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NullBackend.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+NullBackend::NullBackend(const Options& options)
+    : m_options(options)
+{
+    if (m_options.bufferCount == 0)
+    {
+        throw std::invalid_argument("NullBackend requires at least one frame in flight");
+    }
+
+    m_frequency = SDL_GetPerformanceFrequency();
+    m_intervalTicks = secondsToTicks(m_options.frameInterval);
+    m_gpuFrameTicks = secondsToTicks(m_options.gpuFrameTime);
+    m_cpuFrameTicks = secondsToTicks(m_options.cpuFrameTime);
+    m_waitTimeoutTicks = secondsToTicks(m_options.waitTimeout);
+    m_clock = SDL_GetPerformanceCounter();
+    m_nextDeadline = m_clock;
+}
+
+uint32_t NullBackend::bufferCount() const
+{
+    return m_options.bufferCount;
+}
+
+uint64_t NullBackend::currentTime() const
+{
+    if (m_options.pacing == Pacing::Simulated)
+    {
+        return m_clock;
+    }
+    return SDL_GetPerformanceCounter();
+}
+
+void NullBackend::waitForInterval()
+{
+    switch (m_options.pacing)
+    {
+    case Pacing::Unlocked:
+        break;
+    case Pacing::Fixed:
+    {
+        const uint64_t now = SDL_GetPerformanceCounter();
+        if (now < m_nextDeadline)
+        {
+            const uint64_t remaining = m_nextDeadline - now;
+            SDL_DelayPrecise(remaining * SDL_NS_PER_SECOND / m_frequency);
+            m_nextDeadline += m_intervalTicks;
+        }
+        else
+        {
+            // Running behind; re-anchor instead of bursting to catch up.
+            m_nextDeadline = now + m_intervalTicks;
+        }
+        break;
+    }
+    case Pacing::Simulated:
+        // Start on the next interval, or immediately if waits pushed the clock past it.
+        m_nextDeadline += m_intervalTicks;
+        if (m_clock < m_nextDeadline)
+        {
+            m_clock = m_nextDeadline;
+        }
+        else
+        {
+            m_nextDeadline = m_clock;
+        }
+        break;
+    }
+}
+
+bool NullBackend::acquireFrame()
+{
+    return true;
+}
+
+bool NullBackend::waitForFrame(const uint64_t frameNumber)
+{
+    const uint64_t now = currentTime();
+    retireFrames(now);
+    if (frameNumber < m_completedFrames)
+    {
+        return true;
+    }
+
+    // Frames complete in order, so the requested one is at a known queue position.
+    const uint64_t position = frameNumber - m_completedFrames;
+    if (position >= m_pendingCompletionTimes.size())
+    {
+        return false; // Never submitted
+    }
+
+    const uint64_t completionTime = m_pendingCompletionTimes[position];
+    if (m_waitTimeoutTicks > 0 && completionTime - now > m_waitTimeoutTicks)
+    {
+        advanceTo(now + m_waitTimeoutTicks);
+        return false;
+    }
+
+    advanceTo(completionTime);
+    retireFrames(completionTime);
+    return true;
+}
+
+void NullBackend::beginFrame([[maybe_unused]] uint32_t frameIndex)
+{
+}
+
+void NullBackend::endFrame([[maybe_unused]] uint64_t frameNumber)
+{
+    if (m_options.pacing == Pacing::Simulated)
+    {
+        m_clock += m_cpuFrameTicks;
+    }
+
+    // The simulated GPU executes submissions back to back.
+    const uint64_t now = currentTime();
+    m_gpuIdleTime = std::max(m_gpuIdleTime, now) + m_gpuFrameTicks;
+    m_pendingCompletionTimes.push_back(m_gpuIdleTime);
+    m_submittedFrames++;
+    retireFrames(now);
+}
+
+uint64_t NullBackend::completedFrames()
+{
+    retireFrames(currentTime());
+    return m_completedFrames;
+}
+
+const NullBackend::Options& NullBackend::options() const
+{
+    return m_options;
+}
+
+void NullBackend::retireFrames(const uint64_t now)
+{
+    while (!m_pendingCompletionTimes.empty() && m_pendingCompletionTimes.front() <= now)
+    {
+        m_pendingCompletionTimes.pop_front();
+        m_completedFrames++;
+    }
+}
+
+void NullBackend::advanceTo(const uint64_t time)
+{
+    if (m_options.pacing == Pacing::Simulated)
+    {
+        m_clock = std::max(m_clock, time);
+        return;
+    }
+
+    const uint64_t now = SDL_GetPerformanceCounter();
+    if (now < time)
+    {
+        SDL_DelayPrecise((time - now) * SDL_NS_PER_SECOND / m_frequency);
+    }
+}
+
+uint64_t NullBackend::secondsToTicks(const double seconds) const
+{
+    return static_cast<uint64_t>(std::max(seconds, 0.0) * static_cast<double>(m_frequency));
+}
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "RenderBackend.hpp"
+
+/// @brief CPU-only backend that drives the frame loop without a window or GPU.
+///
+/// Submitted frames are executed by a simulated serial GPU that takes gpuFrameTime
+/// per frame, so frame pacing and latency can be studied without hardware. With the
+/// default of zero, frames complete on submission and waitForFrame never blocks.
+class NullBackend : public RenderBackend
+{
+public:
+    enum class Pacing
+    {
+        Unlocked,  ///< Run frames as fast as possible against the real clock.
+        Fixed,     ///< Sleep so frames start at a fixed cadence of the real clock.
+        Simulated, ///< Advance a virtual clock by one interval per frame (deterministic).
+    };
+
+    struct Options
+    {
+        uint32_t bufferCount = 3;
+        Pacing   pacing = Pacing::Unlocked;
+        double   frameInterval = 1.0 / 60.0; ///< Cadence in seconds for Fixed/Simulated.
+        double   gpuFrameTime = 0.0; ///< Simulated GPU execution time per frame in seconds.
+        double   cpuFrameTime = 0.0; ///< Recording time added per frame (Simulated only).
+        double   waitTimeout = 0.0;  ///< Seconds before waitForFrame gives up, 0 waits forever.
+    };
+
+    explicit NullBackend(const Options& options);
+
+    [[nodiscard]] uint32_t bufferCount() const override;
+
+    [[nodiscard]] uint64_t currentTime() const override;
+
+    void waitForInterval() override;
+
+    [[nodiscard]] bool acquireFrame() override;
+
+    [[nodiscard]] bool waitForFrame(uint64_t frameNumber) override;
+
+    void beginFrame(uint32_t frameIndex) override;
+
+    void endFrame(uint64_t frameNumber) override;
+
+    /// @brief Number of frames that have been submitted and completed.
+    [[nodiscard]] uint64_t completedFrames();
+
+    [[nodiscard]] const Options& options() const;
+
+protected:
+    /// Retires frames whose simulated completion time has passed.
+    void retireFrames(uint64_t now);
+
+    /// Advances the clock to the given time, sleeping unless the clock is simulated.
+    void advanceTo(uint64_t time);
+
+    [[nodiscard]] uint64_t secondsToTicks(double seconds) const;
+
+    Options  m_options;
+    uint64_t m_frequency;
+    uint64_t m_intervalTicks;
+    uint64_t m_gpuFrameTicks;
+    uint64_t m_cpuFrameTicks;
+    uint64_t m_waitTimeoutTicks;
+    uint64_t m_clock;
+    uint64_t m_nextDeadline;
+    uint64_t m_gpuIdleTime = 0;
+    uint64_t m_submittedFrames = 0;
+    uint64_t m_completedFrames = 0;
+
+    std::deque<uint64_t> m_pendingCompletionTimes; ///< One per frame still on the GPU.
+};
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ParallelEncoder.hpp"
+
+#include <algorithm>
+
+std::vector<EncodePartition> partitionItems(
+    const size_t itemCount, const uint32_t maxPartitions, const size_t minItems)
+{
+    if (itemCount == 0)
+    {
+        return {};
+    }
+
+    const size_t partitionCount = std::clamp<size_t>(
+        itemCount / std::max<size_t>(minItems, 1), 1, std::max<uint32_t>(maxPartitions, 1));
+    std::vector<EncodePartition> partitions(partitionCount);
+    for (size_t i = 0; i < partitionCount; i++)
+    {
+        partitions[i] = { .index = static_cast<uint32_t>(i),
+            .count = static_cast<uint32_t>(partitionCount),
+            .begin = itemCount * i / partitionCount,
+            .end = itemCount * (i + 1) / partitionCount };
+    }
+    return partitions;
+}
+
+std::vector<EncodePartition> partitionByCost(
+    const std::span<const uint32_t> costs, const uint32_t maxPartitions, const uint64_t minCost)
+{
+    uint64_t totalCost = 0;
+    for (const uint32_t cost : costs)
+    {
+        totalCost += cost;
+    }
+    if (costs.empty())
+    {
+        return {};
+    }
+
+    // Cut once the running cost reaches the next multiple of the target, but never
+    // leave a later partition without items
+    const uint64_t partitionLimit
+        = std::clamp<uint64_t>(maxPartitions, 1, static_cast<uint64_t>(costs.size()));
+    const uint64_t partitionCount
+        = std::clamp<uint64_t>(totalCost / std::max<uint64_t>(minCost, 1), 1, partitionLimit);
+    std::vector<EncodePartition> partitions;
+    uint64_t                     runningCost = 0;
+    size_t                       begin = 0;
+    for (size_t i = 0; i < costs.size(); i++)
+    {
+        runningCost += costs[i];
+        const uint64_t cut = partitions.size() + 1;
+        const bool     reached = runningCost * partitionCount >= totalCost * cut;
+        const bool     mustCut = costs.size() - (i + 1) == partitionCount - cut;
+        if (cut < partitionCount && (reached || mustCut))
+        {
+            partitions.push_back({ .begin = begin, .end = i + 1 });
+            begin = i + 1;
+        }
+    }
+    partitions.push_back({ .begin = begin, .end = costs.size() });
+
+    for (size_t i = 0; i < partitions.size(); i++)
+    {
+        partitions[i].index = static_cast<uint32_t>(i);
+        partitions[i].count = static_cast<uint32_t>(partitions.size());
+    }
+    return partitions;
+}
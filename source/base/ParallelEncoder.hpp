@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+/// @brief Contiguous range of work items encoded into one command buffer.
+///
+/// A render pass split into partitions is suspended at the end of every partition
+/// but the last and resumed at the start of every one but the first, e.g. with the
+/// Metal 4 suspending and resuming render encoder options.
+struct EncodePartition
+{
+    uint32_t index = 0; ///< Position in submission order.
+    uint32_t count = 0; ///< Partitions the work was split into.
+    size_t   begin = 0;
+    size_t   end = 0;
+
+    [[nodiscard]] bool isFirst() const
+    {
+        return index == 0;
+    }
+
+    [[nodiscard]] bool isLast() const
+    {
+        return index + 1 == count;
+    }
+};
+
+/// @brief Splits items into at most maxPartitions ranges of equal size, each with at
+/// least minItems items unless there are fewer in total.
+[[nodiscard]] std::vector<EncodePartition> partitionItems(
+    size_t itemCount, uint32_t maxPartitions, size_t minItems = 1);
+
+/// @brief Splits items into at most maxPartitions ranges of similar total cost, each
+/// costing at least minCost unless the total is lower.
+[[nodiscard]] std::vector<EncodePartition> partitionByCost(
+    std::span<const uint32_t> costs, uint32_t maxPartitions, uint64_t minCost = 1);
+
+/// @brief Encodes a frame into several command buffers in parallel.
+///
+/// Each partition of the work gets its own command buffer and its own allocator,
+/// so workers never share encoder state. Allocators come from a pool per frame
+/// slot and are reset by beginFrame once the slot comes around again, when the GPU
+/// is done with their commands. commandBuffers() lists the frame's buffers in the
+/// order of the encode() calls and of the partitions within each call, which is
+/// the order to commit them in, together.
+/// @tparam TCommandBuffer Backend command buffer, reused across frames.
+/// @tparam TAllocator Backend memory the commands are encoded into.
+/// @note Both are moved when the pools grow, so they should be handles, as Metal's
+/// reference counted objects are.
+template <typename TCommandBuffer, typename TAllocator>
+class ParallelEncoder
+{
+public:
+    /// @brief Backend operations; called on the thread calling encode() except for
+    /// begin and end, which workers call on their own buffer.
+    struct Backend
+    {
+        std::function<TAllocator()>                       createAllocator;
+        std::function<void(TAllocator&)>                  resetAllocator;
+        std::function<TCommandBuffer()>                   createCommandBuffer;
+        std::function<void(TCommandBuffer&, TAllocator&)> beginCommandBuffer;
+        std::function<void(TCommandBuffer&)>              endCommandBuffer;
+    };
+
+    /// @param [in] frameSlotCount Frames that may be in flight, like
+    /// RenderBackend::bufferCount.
+    ParallelEncoder(Backend backend, const uint32_t frameSlotCount,
+        ThreadPool& threadPool = ThreadPool::shared())
+        : m_backend(std::move(backend))
+        , m_threadPool(threadPool)
+        , m_slots(frameSlotCount)
+    {
+    }
+
+    ParallelEncoder(const ParallelEncoder&) = delete;
+    ParallelEncoder& operator=(const ParallelEncoder&) = delete;
+
+    /// @brief Starts a frame in a slot whose previous frame the GPU has completed,
+    /// resetting the allocators that frame used.
+    /// @throws std::runtime_error if the slot is out of range.
+    void beginFrame(const uint32_t frameSlot)
+    {
+        if (frameSlot >= m_slots.size())
+        {
+            throw std::runtime_error(std::format(
+                "Frame slot {} is out of range, there are {}", frameSlot, m_slots.size()));
+        }
+
+        m_frameSlot = frameSlot;
+        Slot& slot = m_slots[frameSlot];
+        for (size_t i = 0; i < slot.usedAllocators; i++)
+        {
+            m_backend.resetAllocator(slot.allocators[i]);
+        }
+        slot.usedAllocators = 0;
+        m_usedCommandBuffers = 0;
+    }
+
+    /// @brief Encodes the partitions on the pool and returns once all are encoded.
+    ///
+    /// function(commandBuffer, partition) runs on a worker for each partition, between
+    /// the backend's begin and end of that partition's command buffer. It must not
+    /// throw.
+    template <typename TFunction>
+    void encode(const std::span<const EncodePartition> partitions, const TFunction& function)
+    {
+        // The pools grow here, so workers only touch their own buffer and allocator
+        Slot&        slot = m_slots[m_frameSlot];
+        const size_t firstAllocator = slot.usedAllocators;
+        const size_t firstCommandBuffer = m_usedCommandBuffers;
+        while (slot.allocators.size() < firstAllocator + partitions.size())
+        {
+            slot.allocators.push_back(m_backend.createAllocator());
+        }
+        while (m_commandBuffers.size() < firstCommandBuffer + partitions.size())
+        {
+            m_commandBuffers.push_back(m_backend.createCommandBuffer());
+        }
+        slot.usedAllocators += partitions.size();
+        m_usedCommandBuffers += partitions.size();
+
+        m_threadPool.parallelFor(
+            partitions.size(), 1, [&](const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; i++)
+                {
+                    TCommandBuffer& commandBuffer = m_commandBuffers[firstCommandBuffer + i];
+                    m_backend.beginCommandBuffer(
+                        commandBuffer, slot.allocators[firstAllocator + i]);
+                    function(commandBuffer, partitions[i]);
+                    m_backend.endCommandBuffer(commandBuffer);
+                }
+            });
+    }
+
+    /// @brief The command buffers encoded since beginFrame, in commit order.
+    [[nodiscard]] std::span<TCommandBuffer> commandBuffers()
+    {
+        return std::span(m_commandBuffers).first(m_usedCommandBuffers);
+    }
+
+    /// @brief Allocators created over all slots, for diagnostics.
+    [[nodiscard]] size_t allocatorCount() const
+    {
+        size_t count = 0;
+        for (const Slot& slot : m_slots)
+        {
+            count += slot.allocators.size();
+        }
+        return count;
+    }
+
+private:
+    struct Slot
+    {
+        std::vector<TAllocator> allocators;
+        size_t                  usedAllocators = 0;
+    };
+
+    Backend                     m_backend;
+    ThreadPool&                 m_threadPool;
+    std::vector<Slot>           m_slots;
+    std::vector<TCommandBuffer> m_commandBuffers;
+    size_t                      m_usedCommandBuffers = 0;
+    uint32_t                    m_frameSlot = 0;
+};
@@ -0,0 +1,494 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "PipelineCache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+    static_assert(std::endian::native == std::endian::little,
+        "Serialized pipeline data assumes a little endian host");
+
+    constexpr uint32_t g_descriptionVersion = 1;
+    constexpr uint32_t g_manifestMagic = 0x4D434C50; // "PLCM"
+    constexpr uint32_t g_manifestVersion = 1;
+
+    // Upper bounds used to reject corrupt data before allocating for it
+    constexpr uint32_t g_maxVertexAttributes = 31;
+    constexpr uint32_t g_maxVertexLayouts = 31;
+    constexpr uint32_t g_maxColorAttachments = 8;
+    constexpr uint32_t g_maxStringLength = 1024;
+
+    class ByteWriter
+    {
+    public:
+        template <typename T>
+        void write(const T value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+            m_bytes.insert(m_bytes.end(), bytes, bytes + sizeof(T));
+        }
+
+        void write(const std::string& value)
+        {
+            write(static_cast<uint32_t>(value.size()));
+            const auto* bytes = reinterpret_cast<const std::byte*>(value.data());
+            m_bytes.insert(m_bytes.end(), bytes, bytes + value.size());
+        }
+
+        void writeBytes(const std::span<const std::byte> value)
+        {
+            m_bytes.insert(m_bytes.end(), value.begin(), value.end());
+        }
+
+        [[nodiscard]] std::vector<std::byte>& bytes()
+        {
+            return m_bytes;
+        }
+
+    private:
+        std::vector<std::byte> m_bytes;
+    };
+
+    /// Reads values written by ByteWriter; any out of bounds read fails the reader.
+    class ByteReader
+    {
+    public:
+        explicit ByteReader(const std::span<const std::byte> bytes)
+            : m_bytes(bytes)
+        {
+        }
+
+        template <typename T>
+        bool read(T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            if (!take(sizeof(T)))
+            {
+                return false;
+            }
+            std::memcpy(&value, m_bytes.data() + m_offset - sizeof(T), sizeof(T));
+            return true;
+        }
+
+        bool read(std::string& value)
+        {
+            uint32_t length = 0;
+            if (!read(length) || length > g_maxStringLength || !take(length))
+            {
+                return false;
+            }
+            value.assign(reinterpret_cast<const char*>(m_bytes.data() + m_offset - length), length);
+            return true;
+        }
+
+        bool read(std::span<const std::byte>& value, const size_t size)
+        {
+            if (!take(size))
+            {
+                return false;
+            }
+            value = m_bytes.subspan(m_offset - size, size);
+            return true;
+        }
+
+        [[nodiscard]] size_t offset() const
+        {
+            return m_offset;
+        }
+
+        [[nodiscard]] bool atEnd() const
+        {
+            return m_offset == m_bytes.size();
+        }
+
+    private:
+        bool take(const size_t size)
+        {
+            if (size > m_bytes.size() - m_offset)
+            {
+                return false;
+            }
+            m_offset += size;
+            return true;
+        }
+
+        std::span<const std::byte> m_bytes;
+        size_t                     m_offset = 0;
+    };
+
+    uint64_t load64(const std::byte* data)
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint64_t finalMix(uint64_t k)
+    {
+        k ^= k >> 33;
+        k *= 0xFF51AFD7ED558CCDULL;
+        k ^= k >> 33;
+        k *= 0xC4CEB9FE1A85EC53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+} // namespace
+
+std::string PipelineKey::toString() const
+{
+    return std::format("{:016x}{:016x}", high, low);
+}
+
+PipelineKey hashBytes(const std::span<const std::byte> bytes, const uint64_t seed)
+{
+    constexpr uint64_t c1 = 0x87C37B91114253D5ULL;
+    constexpr uint64_t c2 = 0x4CF5AD432745937FULL;
+
+    const size_t blockCount = bytes.size() / 16;
+    uint64_t     h1 = seed;
+    uint64_t     h2 = seed;
+
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        uint64_t k1 = load64(bytes.data() + i * 16);
+        uint64_t k2 = load64(bytes.data() + i * 16 + 8);
+
+        k1 *= c1;
+        k1 = std::rotl(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = std::rotl(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52DCE729;
+
+        k2 *= c2;
+        k2 = std::rotl(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = std::rotl(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495AB5;
+    }
+
+    // Tail: up to 15 remaining bytes, little endian
+    const std::byte* tail = bytes.data() + blockCount * 16;
+    const size_t     tailSize = bytes.size() & 15;
+    uint64_t         k1 = 0;
+    uint64_t         k2 = 0;
+    for (size_t i = tailSize; i > 8; i--)
+    {
+        k2 ^= static_cast<uint64_t>(tail[i - 1]) << ((i - 9) * 8);
+    }
+    for (size_t i = std::min<size_t>(tailSize, 8); i > 0; i--)
+    {
+        k1 ^= static_cast<uint64_t>(tail[i - 1]) << ((i - 1) * 8);
+    }
+    if (tailSize > 8)
+    {
+        k2 *= c2;
+        k2 = std::rotl(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+    }
+    if (tailSize > 0)
+    {
+        k1 *= c1;
+        k1 = std::rotl(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+
+    h1 ^= bytes.size();
+    h2 ^= bytes.size();
+    h1 += h2;
+    h2 += h1;
+    h1 = finalMix(h1);
+    h2 = finalMix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    return { .high = h1, .low = h2 };
+}
+
+std::vector<std::byte> PipelineDescription::serialize() const
+{
+    std::vector<VertexAttribute> attributes = vertexAttributes;
+    std::ranges::sort(attributes, {}, &VertexAttribute::index);
+
+    std::vector<VertexLayout> layouts;
+    std::ranges::copy_if(vertexLayouts, std::back_inserter(layouts), [&](const auto& layout) {
+        return std::ranges::find(attributes, layout.bufferIndex, &VertexAttribute::bufferIndex)
+            != attributes.end();
+    });
+    std::ranges::sort(layouts, {}, &VertexLayout::bufferIndex);
+
+    size_t colorAttachmentCount = colorAttachments.size();
+    while (colorAttachmentCount > 0 && colorAttachments[colorAttachmentCount - 1].pixelFormat == 0)
+    {
+        colorAttachmentCount--;
+    }
+
+    ByteWriter writer;
+    writer.write(g_descriptionVersion);
+    writer.write(vertexFunction);
+    writer.write(fragmentFunction);
+    writer.write(rasterSampleCount);
+
+    writer.write(static_cast<uint32_t>(attributes.size()));
+    for (const auto& attribute : attributes)
+    {
+        writer.write(attribute.index);
+        writer.write(attribute.format);
+        writer.write(attribute.offset);
+        writer.write(attribute.bufferIndex);
+    }
+
+    writer.write(static_cast<uint32_t>(layouts.size()));
+    for (const auto& layout : layouts)
+    {
+        writer.write(layout.bufferIndex);
+        writer.write(layout.stride);
+        writer.write(layout.stepFunction);
+        writer.write(layout.stepRate);
+    }
+
+    writer.write(static_cast<uint32_t>(colorAttachmentCount));
+    for (size_t i = 0; i < colorAttachmentCount; i++)
+    {
+        // Blend state is irrelevant when blending is off, so it is written as defaults
+        const ColorAttachment& attachment = colorAttachments[i];
+        const ColorAttachment& blend
+            = attachment.blendingEnabled ? attachment : ColorAttachment {};
+        writer.write(attachment.pixelFormat);
+        writer.write(static_cast<uint8_t>(attachment.blendingEnabled));
+        writer.write(blend.sourceRGBBlendFactor);
+        writer.write(blend.destinationRGBBlendFactor);
+        writer.write(blend.rgbBlendOperation);
+        writer.write(blend.sourceAlphaBlendFactor);
+        writer.write(blend.destinationAlphaBlendFactor);
+        writer.write(blend.alphaBlendOperation);
+        writer.write(attachment.writeMask);
+    }
+
+    return std::move(writer.bytes());
+}
+
+std::optional<PipelineDescription> PipelineDescription::deserialize(
+    const std::span<const std::byte> bytes)
+{
+    ByteReader          reader(bytes);
+    PipelineDescription description;
+
+    uint32_t version = 0;
+    uint32_t count = 0;
+    if (!reader.read(version) || version != g_descriptionVersion
+        || !reader.read(description.vertexFunction) || !reader.read(description.fragmentFunction)
+        || !reader.read(description.rasterSampleCount))
+    {
+        return std::nullopt;
+    }
+
+    if (!reader.read(count) || count > g_maxVertexAttributes)
+    {
+        return std::nullopt;
+    }
+    description.vertexAttributes.resize(count);
+    for (auto& attribute : description.vertexAttributes)
+    {
+        if (!reader.read(attribute.index) || !reader.read(attribute.format)
+            || !reader.read(attribute.offset) || !reader.read(attribute.bufferIndex))
+        {
+            return std::nullopt;
+        }
+    }
+
+    if (!reader.read(count) || count > g_maxVertexLayouts)
+    {
+        return std::nullopt;
+    }
+    description.vertexLayouts.resize(count);
+    for (auto& layout : description.vertexLayouts)
+    {
+        if (!reader.read(layout.bufferIndex) || !reader.read(layout.stride)
+            || !reader.read(layout.stepFunction) || !reader.read(layout.stepRate))
+        {
+            return std::nullopt;
+        }
+    }
+
+    if (!reader.read(count) || count > g_maxColorAttachments)
+    {
+        return std::nullopt;
+    }
+    description.colorAttachments.resize(count);
+    for (auto& attachment : description.colorAttachments)
+    {
+        uint8_t blendingEnabled = 0;
+        if (!reader.read(attachment.pixelFormat) || !reader.read(blendingEnabled)
+            || !reader.read(attachment.sourceRGBBlendFactor)
+            || !reader.read(attachment.destinationRGBBlendFactor)
+            || !reader.read(attachment.rgbBlendOperation)
+            || !reader.read(attachment.sourceAlphaBlendFactor)
+            || !reader.read(attachment.destinationAlphaBlendFactor)
+            || !reader.read(attachment.alphaBlendOperation) || !reader.read(attachment.writeMask))
+        {
+            return std::nullopt;
+        }
+        attachment.blendingEnabled = blendingEnabled != 0;
+    }
+
+    if (!reader.atEnd())
+    {
+        return std::nullopt;
+    }
+    return description;
+}
+
+PipelineKey PipelineDescription::key() const
+{
+    return hashBytes(serialize());
+}
+
+PipelineCacheManifest::PipelineCacheManifest(std::string compatibilityTag)
+    : m_compatibilityTag(std::move(compatibilityTag))
+{
+}
+
+bool PipelineCacheManifest::load(const std::filesystem::path& path)
+{
+    m_descriptions.clear();
+    m_indices.clear();
+
+    std::error_code error;
+    const auto      fileSize = std::filesystem::file_size(path, error);
+    std::ifstream   stream(path, std::ios::binary);
+    if (error || !stream)
+    {
+        return false;
+    }
+    std::vector<std::byte> bytes(fileSize);
+    if (!stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(fileSize)))
+    {
+        return false;
+    }
+    const std::span<const std::byte> data(bytes);
+
+    // The trailing checksum covers everything before it
+    if (data.size() < sizeof(uint64_t)
+        || hashBytes(data.first(data.size() - sizeof(uint64_t))).low
+            != load64(data.data() + data.size() - sizeof(uint64_t)))
+    {
+        return false;
+    }
+
+    ByteReader  reader(data.first(data.size() - sizeof(uint64_t)));
+    uint32_t    magic = 0;
+    uint32_t    version = 0;
+    std::string compatibilityTag;
+    uint32_t    count = 0;
+    if (!reader.read(magic) || magic != g_manifestMagic || !reader.read(version)
+        || version != g_manifestVersion || !reader.read(compatibilityTag)
+        || compatibilityTag != m_compatibilityTag || !reader.read(count))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        PipelineKey                key;
+        uint32_t                   size = 0;
+        std::span<const std::byte> serialized;
+        if (!reader.read(key.high) || !reader.read(key.low) || !reader.read(size)
+            || !reader.read(serialized, size))
+        {
+            m_descriptions.clear();
+            m_indices.clear();
+            return false;
+        }
+
+        // Skip entries that no longer parse or hash to their key, e.g. after a change
+        // to the canonical form
+        auto description = PipelineDescription::deserialize(serialized);
+        if (description.has_value() && hashBytes(serialized) == key)
+        {
+            add(*description);
+        }
+    }
+
+    return reader.atEnd();
+}
+
+void PipelineCacheManifest::save(const std::filesystem::path& path) const
+{
+    ByteWriter writer;
+    writer.write(g_manifestMagic);
+    writer.write(g_manifestVersion);
+    writer.write(m_compatibilityTag);
+    writer.write(static_cast<uint32_t>(m_descriptions.size()));
+    for (const auto& description : m_descriptions)
+    {
+        const std::vector<std::byte> serialized = description.serialize();
+        const PipelineKey            key = hashBytes(serialized);
+        writer.write(key.high);
+        writer.write(key.low);
+        writer.write(static_cast<uint32_t>(serialized.size()));
+        writer.writeBytes(serialized);
+    }
+    writer.write(hashBytes(writer.bytes()).low);
+
+    // Write next to the destination and rename, so readers never see a partial file
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(writer.bytes().data()),
+            static_cast<std::streamsize>(writer.bytes().size()));
+        if (!stream)
+        {
+            throw std::runtime_error(
+                std::format("Failed to write pipeline cache manifest {}", temporaryPath.string()));
+        }
+    }
+    std::filesystem::rename(temporaryPath, path);
+}
+
+bool PipelineCacheManifest::add(const PipelineDescription& description)
+{
+    const auto [it, inserted] = m_indices.try_emplace(description.key(), m_descriptions.size());
+    if (inserted)
+    {
+        m_descriptions.push_back(description);
+    }
+    return inserted;
+}
+
+bool PipelineCacheManifest::contains(const PipelineKey& key) const
+{
+    return m_indices.contains(key);
+}
+
+size_t PipelineCacheManifest::size() const
+{
+    return m_descriptions.size();
+}
+
+const std::string& PipelineCacheManifest::compatibilityTag() const
+{
+    return m_compatibilityTag;
+}
+
+const std::vector<PipelineDescription>& PipelineCacheManifest::descriptions() const
+{
+    return m_descriptions;
+}
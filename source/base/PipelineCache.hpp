@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// @brief Stable 128-bit identifier of a pipeline description.
+struct PipelineKey
+{
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    auto operator<=>(const PipelineKey&) const = default;
+
+    /// @brief Formats the key as 32 lowercase hex digits.
+    [[nodiscard]] std::string toString() const;
+};
+
+template <>
+struct std::hash<PipelineKey>
+{
+    size_t operator()(const PipelineKey& key) const noexcept
+    {
+        // The key already is a well mixed hash
+        return static_cast<size_t>(key.low);
+    }
+};
+
+/// @brief 128-bit MurmurHash3 (x64 variant) of a byte range.
+///
+/// The result only depends on the bytes and the seed, so keys are stable across runs
+/// and platforms and can be persisted.
+[[nodiscard]] PipelineKey hashBytes(std::span<const std::byte> bytes, uint64_t seed = 0);
+
+/// @brief Platform independent description of a render pipeline.
+///
+/// Enumerations hold the raw values of the corresponding Metal enums (e.g.
+/// MTL::VertexFormat, MTL::BlendFactor) so the description, its key and its
+/// serialized form do not depend on Metal headers.
+struct PipelineDescription
+{
+    struct VertexAttribute
+    {
+        uint32_t index = 0;
+        uint32_t format = 0;
+        uint32_t offset = 0;
+        uint32_t bufferIndex = 0;
+    };
+
+    struct VertexLayout
+    {
+        uint32_t bufferIndex = 0;
+        uint32_t stride = 0;
+        uint32_t stepFunction = 1; ///< MTL::VertexStepFunctionPerVertex
+        uint32_t stepRate = 1;
+    };
+
+    struct ColorAttachment
+    {
+        uint32_t pixelFormat = 0;
+        bool     blendingEnabled = false;
+        uint32_t sourceRGBBlendFactor = 1;        ///< MTL::BlendFactorOne
+        uint32_t destinationRGBBlendFactor = 0;   ///< MTL::BlendFactorZero
+        uint32_t rgbBlendOperation = 0;           ///< MTL::BlendOperationAdd
+        uint32_t sourceAlphaBlendFactor = 1;      ///< MTL::BlendFactorOne
+        uint32_t destinationAlphaBlendFactor = 0; ///< MTL::BlendFactorZero
+        uint32_t alphaBlendOperation = 0;         ///< MTL::BlendOperationAdd
+        uint32_t writeMask = 0xF;                 ///< MTL::ColorWriteMaskAll
+    };
+
+    std::string                  vertexFunction;
+    std::string                  fragmentFunction;
+    std::vector<VertexAttribute> vertexAttributes;
+    std::vector<VertexLayout>    vertexLayouts;
+    std::vector<ColorAttachment> colorAttachments;
+    uint32_t                     rasterSampleCount = 1;
+
+    /// @brief Serializes the description in canonical form.
+    ///
+    /// Descriptions that produce the same pipeline serialize identically: attributes
+    /// and layouts are ordered by index, layouts no attribute reads are dropped, as
+    /// are trailing unused color attachments and blend state of attachments that do
+    /// not blend.
+    [[nodiscard]] std::vector<std::byte> serialize() const;
+
+    /// @brief Parses the output of serialize.
+    /// @return The description, or std::nullopt if the data is malformed.
+    [[nodiscard]] static std::optional<PipelineDescription> deserialize(
+        std::span<const std::byte> bytes);
+
+    /// @brief Hash of the canonical serialization.
+    [[nodiscard]] PipelineKey key() const;
+};
+
+/// @brief Thread safe, deduplicating in-memory map from pipeline keys to pipelines.
+///
+/// Concurrent requests for the same missing key run the factory once; the other
+/// callers block until it is done and share the result. Lookups of existing entries
+/// only take a shared lock.
+template <typename TPipeline>
+class PipelineCache
+{
+public:
+    struct Statistics
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0; ///< Factory invocations.
+    };
+
+    /// @brief Returns the pipeline for key, creating it with factory() if needed.
+    /// @note If the factory throws, the exception propagates and a later call retries.
+    template <typename TFactory>
+    const TPipeline& getOrCreate(const PipelineKey& key, TFactory&& factory)
+    {
+        Entry* entry = nullptr;
+        {
+            std::shared_lock lock(m_mutex);
+            if (const auto it = m_entries.find(key); it != m_entries.end())
+            {
+                entry = &it->second;
+            }
+        }
+
+        if (entry == nullptr)
+        {
+            std::unique_lock lock(m_mutex);
+            entry = &m_entries.try_emplace(key).first->second;
+        }
+
+        // Map nodes are stable, so the entry stays valid without holding the lock
+        bool created = false;
+        std::call_once(entry->once, [&] {
+            entry->pipeline = std::forward<TFactory>(factory)();
+            entry->ready.store(true, std::memory_order_release);
+            created = true;
+        });
+
+        (created ? m_misses : m_hits).fetch_add(1, std::memory_order_relaxed);
+        return entry->pipeline;
+    }
+
+    /// @brief Returns the pipeline for key, or nullptr if it has not been created.
+    [[nodiscard]] const TPipeline* find(const PipelineKey& key) const
+    {
+        std::shared_lock lock(m_mutex);
+        const auto       it = m_entries.find(key);
+        if (it == m_entries.end() || !it->second.ready.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &it->second.pipeline;
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_entries.size();
+    }
+
+    [[nodiscard]] Statistics statistics() const
+    {
+        return { m_hits.load(std::memory_order_relaxed),
+            m_misses.load(std::memory_order_relaxed) };
+    }
+
+    /// @brief Drops every pipeline. Must not race with getOrCreate.
+    void clear()
+    {
+        std::unique_lock lock(m_mutex);
+        m_entries.clear();
+    }
+
+private:
+    struct Entry
+    {
+        std::once_flag    once;
+        std::atomic<bool> ready = false;
+        TPipeline         pipeline {};
+    };
+
+    mutable std::shared_mutex              m_mutex;
+    std::unordered_map<PipelineKey, Entry> m_entries;
+    std::atomic<uint64_t>                  m_hits = 0;
+    std::atomic<uint64_t>                  m_misses = 0;
+};
+
+/// @brief On-disk record of the pipelines a compiled pipeline archive holds.
+///
+/// Compiled binaries are owned by the platform archive (e.g. an MTL4::Archive); the
+/// manifest stores the description of every pipeline in it, so a later run can tell
+/// which keys the archive can serve and can recreate all of them when the archive is
+/// rewritten. The compatibility tag (e.g. device and OS version) invalidates the
+/// archive when it was built for a different configuration.
+class PipelineCacheManifest
+{
+public:
+    explicit PipelineCacheManifest(std::string compatibilityTag = {});
+
+    /// @brief Replaces the contents with the manifest stored at path.
+    /// @return false, leaving the manifest empty, if the file is missing, corrupt or
+    /// was written with a different compatibility tag.
+    bool load(const std::filesystem::path& path);
+
+    /// @brief Writes the manifest to path, replacing any existing file atomically.
+    void save(const std::filesystem::path& path) const;
+
+    /// @brief Records a description.
+    /// @return true if its key was not in the manifest yet.
+    bool add(const PipelineDescription& description);
+
+    [[nodiscard]] bool contains(const PipelineKey& key) const;
+
+    [[nodiscard]] size_t size() const;
+
+    [[nodiscard]] const std::string& compatibilityTag() const;
+
+    [[nodiscard]] const std::vector<PipelineDescription>& descriptions() const;
+
+private:
+    std::string                             m_compatibilityTag;
+    std::vector<PipelineDescription>        m_descriptions;
+    std::unordered_map<PipelineKey, size_t> m_indices;
+};
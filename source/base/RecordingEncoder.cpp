@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "RecordingEncoder.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+void RecordingAllocator::reset()
+{
+    m_commands.clear();
+}
+
+size_t RecordingAllocator::commandCount() const
+{
+    return m_commands.size();
+}
+
+void RecordingCommandBuffer::begin(RecordingAllocator& allocator)
+{
+    if (m_encoding)
+    {
+        throw std::runtime_error("Command buffer began while it is being encoded");
+    }
+    m_allocator = &allocator;
+    m_encoding = true;
+    m_first = allocator.m_commands.size();
+    m_end = m_first;
+}
+
+void RecordingCommandBuffer::end()
+{
+    m_encoding = false;
+    m_end = m_allocator->m_commands.size();
+}
+
+void RecordingCommandBuffer::setPipeline(const uint32_t pipeline)
+{
+    record(RecordedCommand::Type::SetPipeline, { pipeline, 0, 0 });
+}
+
+void RecordingCommandBuffer::setMaterial(const uint32_t material)
+{
+    record(RecordedCommand::Type::SetMaterial, { material, 0, 0 });
+}
+
+void RecordingCommandBuffer::draw(
+    const uint32_t mesh, const uint32_t firstInstance, const uint32_t instanceCount)
+{
+    record(RecordedCommand::Type::Draw, { mesh, firstInstance, instanceCount });
+}
+
+std::span<const RecordedCommand> RecordingCommandBuffer::commands() const
+{
+    if (m_allocator == nullptr)
+    {
+        return {};
+    }
+    return std::span(m_allocator->m_commands).subspan(m_first, m_end - m_first);
+}
+
+void RecordingCommandBuffer::record(
+    const RecordedCommand::Type type, const std::array<uint32_t, 3>& arguments)
+{
+    if (!m_encoding)
+    {
+        throw std::runtime_error("Command recorded outside of begin and end");
+    }
+    m_allocator->m_commands.push_back({ .type = type, .arguments = arguments });
+}
+
+void encodeBatches(RecordingCommandBuffer& commandBuffer, std::span<const Render::Batch> batches)
+{
+    constexpr uint32_t s_unbound = std::numeric_limits<uint32_t>::max();
+
+    uint32_t pipeline = s_unbound;
+    uint32_t material = s_unbound;
+    for (const Render::Batch& batch : batches)
+    {
+        const Render::DrawState state = Render::decodeSortKey(batch.key);
+        if (state.pipeline != pipeline)
+        {
+            pipeline = state.pipeline;
+            commandBuffer.setPipeline(pipeline);
+        }
+        if (state.material != material)
+        {
+            material = state.material;
+            commandBuffer.setMaterial(material);
+        }
+        commandBuffer.draw(state.mesh, batch.firstInstance, batch.instanceCount);
+    }
+}
@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "RenderQueue.hpp"
+
+/// @brief One command of a RecordingCommandBuffer.
+struct RecordedCommand
+{
+    enum class Type : uint8_t
+    {
+        SetPipeline, ///< arguments[0] is the pipeline.
+        SetMaterial, ///< arguments[0] is the material.
+        Draw,        ///< Mesh, first instance and instance count.
+    };
+
+    Type                    type = Type::Draw;
+    std::array<uint32_t, 3> arguments {};
+};
+
+/// @brief Memory a RecordingCommandBuffer encodes into, standing in for a GPU
+/// command allocator: the commands stay valid until reset.
+class RecordingAllocator
+{
+public:
+    void reset();
+
+    /// @brief Commands encoded since the last reset, over all command buffers.
+    [[nodiscard]] size_t commandCount() const;
+
+private:
+    friend class RecordingCommandBuffer;
+
+    std::vector<RecordedCommand> m_commands;
+};
+
+/// @brief CPU command buffer that records what a GPU encoder would encode, so
+/// encoding can be run and checked without a GPU.
+class RecordingCommandBuffer
+{
+public:
+    /// @throws std::runtime_error if the buffer is already being encoded.
+    void begin(RecordingAllocator& allocator);
+
+    void end();
+
+    void setPipeline(uint32_t pipeline);
+
+    void setMaterial(uint32_t material);
+
+    void draw(uint32_t mesh, uint32_t firstInstance, uint32_t instanceCount);
+
+    /// @brief Commands encoded between the last begin and end.
+    [[nodiscard]] std::span<const RecordedCommand> commands() const;
+
+private:
+    void record(RecordedCommand::Type type, const std::array<uint32_t, 3>& arguments);
+
+    RecordingAllocator* m_allocator = nullptr;
+    bool                m_encoding = false;
+    size_t              m_first = 0;
+    size_t              m_end = 0;
+};
+
+/// @brief Encodes render queue batches, binding the pipeline and material only when
+/// they change. Each call starts with nothing bound.
+void encodeBatches(RecordingCommandBuffer& commandBuffer, std::span<const Render::Batch> batches);
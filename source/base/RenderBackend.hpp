@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+#include <SDL3/SDL_timer.h>
+
+class GameTimer;
+
+/// @brief Platform side of the frame loop.
+///
+/// A backend owns presentation and GPU synchronization. FrameLoop calls into it in
+/// the order waitForInterval, prepareFrame, acquireFrame, waitForFrame, beginFrame,
+/// then endFrame once the frame has been recorded.
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() = default;
+
+    /// @brief Number of per-frame resource slots, the most frames the CPU may record
+    /// ahead of the GPU. FrameLoop may be configured to use fewer.
+    [[nodiscard]] virtual uint32_t bufferCount() const = 0;
+
+    /// @brief Performance counter value used to tick the frame timer.
+    /// @note Backends with a simulated clock override this for deterministic timing.
+    [[nodiscard]] virtual uint64_t currentTime() const
+    {
+        return SDL_GetPerformanceCounter();
+    }
+
+    /// @brief Blocks until the next presentation interval begins.
+    /// @note Backends driven by a display link are already called on the interval.
+    virtual void waitForInterval()
+    {
+    }
+
+    /// @brief Called at the start of every frame attempt, before the update.
+    ///
+    /// Must not block. Backends use it to reclaim resources of frames that have
+    /// already completed so the update can allocate from them.
+    /// @param [in] frameNumber Number the frame will be submitted with.
+    virtual void prepareFrame([[maybe_unused]] uint64_t frameNumber)
+    {
+    }
+
+    /// @brief Acquires the presentation target for the next frame.
+    /// @return False to skip rendering this frame (e.g. no drawable available).
+    [[nodiscard]] virtual bool acquireFrame() = 0;
+
+    /// @brief Blocks until the GPU has completed the given frame number.
+    /// @return False if the wait timed out before the frame completed.
+    [[nodiscard]] virtual bool waitForFrame(uint64_t frameNumber) = 0;
+
+    /// @brief Prepares the per-frame resources of the given slot for recording.
+    virtual void beginFrame(uint32_t frameIndex) = 0;
+
+    /// @brief Submits and presents the recorded frame.
+    /// @param [in] frameNumber Monotonic number signaled once the GPU completes the frame.
+    virtual void endFrame(uint64_t frameNumber) = 0;
+};
+
+/// @brief Application side of the frame loop.
+class FrameListener
+{
+public:
+    virtual ~FrameListener() = default;
+
+    /// @brief Called once per timer update step before the frame is recorded.
+    virtual void onFrameUpdate(const GameTimer& timer) = 0;
+
+    /// @brief Called after the update so input state can roll over to the next frame.
+    virtual void onFrameInput()
+    {
+    }
+
+    /// @brief Records the frame between RenderBackend::beginFrame and endFrame.
+    virtual void onFrameRender(const GameTimer& timer) = 0;
+};
@@ -0,0 +1,329 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#include "ThreadPool.hpp"
+
+namespace Render
+{
+    namespace
+    {
+        constexpr uint32_t g_passShift = 60;
+        constexpr uint32_t g_blendedShift = 59;
+        constexpr uint64_t g_depthMask = 0xFFFF;
+
+        // Opaque layout
+        constexpr uint32_t g_pipelineShift = 48;
+        constexpr uint32_t g_materialShift = 32;
+        constexpr uint32_t g_meshShift = 16;
+
+        // Blended layout
+        constexpr uint32_t g_blendedDepthShift = 43;
+        constexpr uint32_t g_blendedPipelineShift = 32;
+        constexpr uint32_t g_blendedMaterialShift = 16;
+
+        /// Fewer items per block than this are not worth a task.
+        constexpr size_t g_minBlockSize = 16 * 1024;
+
+        constexpr size_t g_radixBuckets = 256;
+
+        size_t blockCountFor(const size_t count, const ThreadPool* threadPool)
+        {
+            if (threadPool == nullptr)
+            {
+                return 1;
+            }
+            return std::clamp<size_t>(
+                count / g_minBlockSize, 1, static_cast<size_t>(threadPool->threadCount()) * 4);
+        }
+
+        /// Calls function(block, begin, end) for blockCount even ranges of [0, count).
+        template <typename TFunction>
+        void forEachBlock(const size_t count, const size_t blockCount, ThreadPool* threadPool,
+            const TFunction& function)
+        {
+            const size_t blockSize = (count + blockCount - 1) / blockCount;
+            const auto   run = [&](const size_t block) {
+                const size_t begin = std::min(block * blockSize, count);
+                function(block, begin, std::min(begin + blockSize, count));
+            };
+            if (threadPool == nullptr || blockCount == 1)
+            {
+                for (size_t block = 0; block < blockCount; block++)
+                {
+                    run(block);
+                }
+                return;
+            }
+            threadPool->parallelFor(blockCount, 1, [&](const size_t begin, const size_t end) {
+                for (size_t block = begin; block < end; block++)
+                {
+                    run(block);
+                }
+            });
+        }
+
+        uint64_t checkedField(const uint32_t value, const uint32_t limit, const char* name)
+        {
+            if (value >= limit)
+            {
+                throw std::runtime_error(
+                    std::format("Draw {} {} is out of range, the limit is {}", name, value, limit));
+            }
+            return value;
+        }
+    } // namespace
+
+    SortKey makeSortKey(const DrawState& state, const float depth, const bool blended)
+    {
+        const uint64_t pass = checkedField(state.pass, g_maxPasses, "pass");
+        const uint64_t pipeline = checkedField(state.pipeline, g_maxPipelines, "pipeline");
+        const uint64_t material = checkedField(state.material, g_maxMaterials, "material");
+        const uint64_t mesh = checkedField(state.mesh, g_maxMeshes, "mesh");
+        const auto     quantized = static_cast<uint64_t>(
+            std::lround(std::clamp(depth, 0.0F, 1.0F) * static_cast<float>(g_depthMask)));
+
+        if (blended)
+        {
+            return pass << g_passShift | uint64_t { 1 } << g_blendedShift
+                | (g_depthMask - quantized) << g_blendedDepthShift
+                | pipeline << g_blendedPipelineShift | material << g_blendedMaterialShift | mesh;
+        }
+        return pass << g_passShift | pipeline << g_pipelineShift | material << g_materialShift
+            | mesh << g_meshShift | quantized;
+    }
+
+    DrawState decodeSortKey(const SortKey key)
+    {
+        const auto field = [key](const uint32_t shift, const uint32_t limit) {
+            return static_cast<uint32_t>(key >> shift) & (limit - 1);
+        };
+        if ((key >> g_blendedShift & 1) != 0)
+        {
+            return { .pass = field(g_passShift, g_maxPasses),
+                .pipeline = field(g_blendedPipelineShift, g_maxPipelines),
+                .material = field(g_blendedMaterialShift, g_maxMaterials),
+                .mesh = field(0, g_maxMeshes) };
+        }
+        return { .pass = field(g_passShift, g_maxPasses),
+            .pipeline = field(g_pipelineShift, g_maxPipelines),
+            .material = field(g_materialShift, g_maxMaterials),
+            .mesh = field(g_meshShift, g_maxMeshes) };
+    }
+
+    SortKey stateBits(const SortKey key)
+    {
+        const uint64_t depthBits
+            = (key >> g_blendedShift & 1) != 0 ? g_depthMask << g_blendedDepthShift : g_depthMask;
+        return key & ~depthBits;
+    }
+
+    void radixSort(std::span<uint64_t> keys, std::span<uint32_t> values,
+        std::span<uint64_t> scratchKeys, std::span<uint32_t> scratchValues, ThreadPool* threadPool)
+    {
+        const size_t count = keys.size();
+        if (values.size() != count || scratchKeys.size() != count || scratchValues.size() != count)
+        {
+            throw std::runtime_error(
+                std::format("Radix sort of {} keys needs as many values and scratch slots", count));
+        }
+        if (count < 2)
+        {
+            return;
+        }
+
+        const size_t blockCount = blockCountFor(count, threadPool);
+
+        // Bits that differ from the first key; bytes with none need no pass
+        std::vector<uint64_t> blockVarying(blockCount, 0);
+        forEachBlock(count, blockCount, threadPool,
+            [&](const size_t block, const size_t begin, const size_t end) {
+                uint64_t varying = 0;
+                for (size_t i = begin; i < end; i++)
+                {
+                    varying |= keys[i] ^ keys[0];
+                }
+                blockVarying[block] = varying;
+            });
+        uint64_t varying = 0;
+        for (const uint64_t bits : blockVarying)
+        {
+            varying |= bits;
+        }
+
+        std::vector<std::array<uint32_t, g_radixBuckets>> offsets(blockCount);
+        std::span<uint64_t>                               sourceKeys = keys;
+        std::span<uint32_t>                               sourceValues = values;
+        std::span<uint64_t>                               targetKeys = scratchKeys;
+        std::span<uint32_t>                               targetValues = scratchValues;
+        for (uint32_t shift = 0; shift < 64; shift += 8)
+        {
+            if ((varying >> shift & 0xFF) == 0)
+            {
+                continue;
+            }
+
+            forEachBlock(count, blockCount, threadPool,
+                [&](const size_t block, const size_t begin, const size_t end) {
+                    auto& histogram = offsets[block];
+                    histogram.fill(0);
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        histogram[sourceKeys[i] >> shift & 0xFF]++;
+                    }
+                });
+
+            // Each block scatters after the same digits of all earlier blocks, which
+            // keeps the sort stable
+            uint32_t offset = 0;
+            for (size_t digit = 0; digit < g_radixBuckets; digit++)
+            {
+                for (auto& histogram : offsets)
+                {
+                    offset += std::exchange(histogram[digit], offset);
+                }
+            }
+
+            forEachBlock(count, blockCount, threadPool,
+                [&](const size_t block, const size_t begin, const size_t end) {
+                    auto& next = offsets[block];
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        const uint32_t position = next[sourceKeys[i] >> shift & 0xFF]++;
+                        targetKeys[position] = sourceKeys[i];
+                        targetValues[position] = sourceValues[i];
+                    }
+                });
+            std::swap(sourceKeys, targetKeys);
+            std::swap(sourceValues, targetValues);
+        }
+
+        if (sourceKeys.data() != keys.data())
+        {
+            std::ranges::copy(sourceKeys, keys.begin());
+            std::ranges::copy(sourceValues, values.begin());
+        }
+    }
+
+    void RenderQueue::clear()
+    {
+        m_keys.clear();
+        m_instances.clear();
+        m_batches.clear();
+    }
+
+    void RenderQueue::reserve(const size_t drawCount)
+    {
+        m_keys.reserve(drawCount);
+        m_instances.reserve(drawCount);
+    }
+
+    void RenderQueue::submit(const SortKey key, const uint32_t instance)
+    {
+        m_keys.push_back(key);
+        m_instances.push_back(instance);
+    }
+
+    void RenderQueue::submit(
+        const std::span<const SortKey> keys, const std::span<const uint32_t> instances)
+    {
+        if (keys.size() != instances.size())
+        {
+            throw std::runtime_error(std::format(
+                "Submitted {} sort keys with {} instances", keys.size(), instances.size()));
+        }
+        m_keys.insert(m_keys.end(), keys.begin(), keys.end());
+        m_instances.insert(m_instances.end(), instances.begin(), instances.end());
+    }
+
+    void RenderQueue::append(
+        const size_t count, std::span<SortKey>& keys, std::span<uint32_t>& instances)
+    {
+        const size_t first = m_keys.size();
+        m_keys.resize(first + count);
+        m_instances.resize(first + count);
+        keys = std::span(m_keys).subspan(first);
+        instances = std::span(m_instances).subspan(first);
+    }
+
+    size_t RenderQueue::drawCount() const
+    {
+        return m_keys.size();
+    }
+
+    std::span<const Batch> RenderQueue::build(ThreadPool* threadPool)
+    {
+        const size_t count = m_keys.size();
+        m_scratchKeys.resize(count);
+        m_scratchInstances.resize(count);
+        radixSort(m_keys, m_instances, m_scratchKeys, m_scratchInstances, threadPool);
+
+        // A draw starts a batch when its state differs from the previous draw's.
+        // Blocks count their batches, then write them at their prefix offsets
+        const size_t blockCount = blockCountFor(count, threadPool);
+        const auto   startsBatch = [this](const size_t i) {
+            return i == 0 || stateBits(m_keys[i]) != stateBits(m_keys[i - 1]);
+        };
+        m_blockBatchCounts.assign(blockCount + 1, 0);
+        forEachBlock(count, blockCount, threadPool,
+            [&](const size_t block, const size_t begin, const size_t end) {
+                uint32_t batchCount = 0;
+                for (size_t i = begin; i < end; i++)
+                {
+                    batchCount += startsBatch(i) ? 1 : 0;
+                }
+                m_blockBatchCounts[block + 1] = batchCount;
+            });
+        for (size_t block = 0; block < blockCount; block++)
+        {
+            m_blockBatchCounts[block + 1] += m_blockBatchCounts[block];
+        }
+
+        m_batches.resize(m_blockBatchCounts.back());
+        forEachBlock(count, blockCount, threadPool,
+            [&](const size_t block, const size_t begin, const size_t end) {
+                uint32_t batch = m_blockBatchCounts[block];
+                for (size_t i = begin; i < end; i++)
+                {
+                    if (startsBatch(i))
+                    {
+                        m_batches[batch++] = { .key = m_keys[i],
+                            .firstInstance = static_cast<uint32_t>(i) };
+                    }
+                }
+            });
+        for (size_t batch = 0; batch < m_batches.size(); batch++)
+        {
+            const size_t end
+                = batch + 1 < m_batches.size() ? m_batches[batch + 1].firstInstance : count;
+            m_batches[batch].instanceCount
+                = static_cast<uint32_t>(end - m_batches[batch].firstInstance);
+        }
+        return m_batches;
+    }
+
+    std::span<const Batch> RenderQueue::batches() const
+    {
+        return m_batches;
+    }
+
+    std::span<const uint32_t> RenderQueue::instances() const
+    {
+        return m_instances;
+    }
+
+    std::span<const SortKey> RenderQueue::keys() const
+    {
+        return m_keys;
+    }
+} // namespace Render
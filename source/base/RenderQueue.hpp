@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+namespace Render
+{
+    /// @brief Orders the draws of a frame. Draws with equal keys apart from depth
+    /// share all state and may be instanced together.
+    ///
+    /// Opaque keys hold, from the most significant bit: pass (4 bits), a zero
+    /// blended bit, pipeline (11), material (16), mesh (16), then depth (16)
+    /// front to back. Blended keys move depth, back to front, ahead of the state.
+    using SortKey = uint64_t;
+
+    struct DrawState
+    {
+        uint32_t pass = 0;
+        uint32_t pipeline = 0;
+        uint32_t material = 0;
+        uint32_t mesh = 0;
+    };
+
+    inline constexpr uint32_t g_maxPasses = 1U << 4;
+    inline constexpr uint32_t g_maxPipelines = 1U << 11;
+    inline constexpr uint32_t g_maxMaterials = 1U << 16;
+    inline constexpr uint32_t g_maxMeshes = 1U << 16;
+
+    /// @brief Builds the key of a draw.
+    /// @param [in] depth View depth normalized to [0, 1]; values outside are clamped.
+    /// @param [in] blended Sort back to front ahead of the state, for transparency.
+    /// @throws std::runtime_error if a state field is out of range.
+    [[nodiscard]] SortKey makeSortKey(const DrawState& state, float depth, bool blended = false);
+
+    [[nodiscard]] DrawState decodeSortKey(SortKey key);
+
+    /// @brief Clears the depth bits, leaving what decides whether draws batch.
+    [[nodiscard]] SortKey stateBits(SortKey key);
+
+    /// @brief Stable LSD radix sort of keys with a value carried along, one byte per
+    /// pass. Bytes equal in every key are skipped.
+    /// @param [in] scratchKeys, scratchValues Same size as keys; contents are lost.
+    /// @param [in] threadPool Splits each pass into blocks when set.
+    void radixSort(std::span<uint64_t> keys, std::span<uint32_t> values,
+        std::span<uint64_t> scratchKeys, std::span<uint32_t> scratchValues,
+        ThreadPool* threadPool = nullptr);
+
+    /// @brief Consecutive sorted draws that share state, drawn as one instanced call.
+    struct Batch
+    {
+        SortKey  key = 0; ///< Of the first draw.
+        uint32_t firstInstance = 0; ///< Into RenderQueue::instances().
+        uint32_t instanceCount = 0;
+    };
+
+    /// @brief Draws submitted during a frame, sorted and merged into instanced
+    /// batches.
+    ///
+    /// A draw is a sort key and a caller value identifying the instance, for example
+    /// an index into a transform buffer. build() sorts the draws by key and returns
+    /// one batch per run of draws whose keys differ only in depth; the instance
+    /// values of a batch are contiguous in instances(), in sorted order.
+    class RenderQueue
+    {
+    public:
+        /// @brief Drops the draws and batches of the previous frame.
+        void clear();
+
+        void reserve(size_t drawCount);
+
+        void submit(SortKey key, uint32_t instance);
+
+        /// @brief Appends keys.size() draws at once.
+        void submit(std::span<const SortKey> keys, std::span<const uint32_t> instances);
+
+        /// @brief Appends count draws for the caller to fill, e.g. from several
+        /// threads; the spans stay valid until the next submit or clear.
+        void append(size_t count, std::span<SortKey>& keys, std::span<uint32_t>& instances);
+
+        [[nodiscard]] size_t drawCount() const;
+
+        /// @brief Sorts the submitted draws and merges them into batches.
+        /// @param [in] threadPool Sorts and batches in parallel when set.
+        std::span<const Batch> build(ThreadPool* threadPool = nullptr);
+
+        [[nodiscard]] std::span<const Batch> batches() const;
+
+        /// @brief Instance values in sorted order, as of the last build.
+        [[nodiscard]] std::span<const uint32_t> instances() const;
+
+        /// @brief Sorted keys, as of the last build.
+        [[nodiscard]] std::span<const SortKey> keys() const;
+
+    private:
+        std::vector<SortKey>  m_keys;
+        std::vector<uint32_t> m_instances;
+        std::vector<SortKey>  m_scratchKeys;
+        std::vector<uint32_t> m_scratchInstances;
+        std::vector<Batch>    m_batches;
+        std::vector<uint32_t> m_blockBatchCounts;
+    };
+} // namespace Render
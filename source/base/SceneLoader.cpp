@@ -0,0 +1,705 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#define CGLTF_IMPLEMENTATION
+
+#include "SceneLoader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <format>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+
+#include <cgltf.h>
+
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+
+namespace Assets
+{
+    namespace
+    {
+        struct DataDeleter
+        {
+            void operator()(cgltf_data* data) const
+            {
+                cgltf_free(data);
+            }
+        };
+
+        using DataPointer = std::unique_ptr<cgltf_data, DataDeleter>;
+
+        /// One primitive to decode on the pool.
+        struct PrimitiveJob
+        {
+            const cgltf_primitive* source = nullptr;
+            Primitive*             target = nullptr;
+            size_t                 mesh = 0;
+            std::string            error;
+        };
+
+        const char* resultName(const cgltf_result result)
+        {
+            switch (result)
+            {
+            case cgltf_result_data_too_short:
+                return "data too short";
+            case cgltf_result_unknown_format:
+                return "unknown format";
+            case cgltf_result_invalid_json:
+                return "invalid JSON";
+            case cgltf_result_invalid_gltf:
+                return "invalid glTF";
+            case cgltf_result_invalid_options:
+                return "invalid options";
+            case cgltf_result_file_not_found:
+                return "file not found";
+            case cgltf_result_io_error:
+                return "I/O error";
+            case cgltf_result_out_of_memory:
+                return "out of memory";
+            case cgltf_result_legacy_gltf:
+                return "legacy glTF 1.0";
+            default:
+                return "unknown error";
+            }
+        }
+
+        std::string toString(const char* text)
+        {
+            return text != nullptr ? text : "";
+        }
+
+        template <typename T>
+        int32_t indexOf(const T* element, const T* first)
+        {
+            return element != nullptr ? static_cast<int32_t>(element - first) : -1;
+        }
+
+        bool isTriangles(const cgltf_primitive& primitive)
+        {
+            return primitive.type == cgltf_primitive_type_triangles
+                || primitive.type == cgltf_primitive_type_triangle_strip
+                || primitive.type == cgltf_primitive_type_triangle_fan;
+        }
+
+        /// Unpacks an accessor into N component vectors, dequantizing normalized
+        /// integers. Accessors with fewer components keep the trailing defaults.
+        template <size_t N>
+        void unpackAttribute(const cgltf_accessor& accessor, std::vector<std::array<float, N>>& out,
+            const std::array<float, N>& defaults)
+        {
+            const size_t components = cgltf_num_components(accessor.type);
+            if (components > N)
+            {
+                throw std::runtime_error(std::format(
+                    "attribute has {} components, expected at most {}", components, N));
+            }
+
+            out.assign(accessor.count, defaults);
+            if (components == N)
+            {
+                cgltf_accessor_unpack_floats(&accessor, out.front().data(), accessor.count * N);
+                return;
+            }
+
+            std::vector<float> values(accessor.count * components);
+            cgltf_accessor_unpack_floats(&accessor, values.data(), values.size());
+            for (size_t i = 0; i < accessor.count; i++)
+            {
+                std::copy_n(values.data() + i * components, components, out[i].data());
+            }
+        }
+
+        /// Unpacks joint indices, which glTF stores as unsigned bytes or shorts.
+        void unpackJoints(
+            const cgltf_accessor& accessor, std::vector<std::array<uint16_t, 4>>& out)
+        {
+            // Floats hold every 16 bit index exactly
+            std::vector<std::array<float, 4>> joints;
+            unpackAttribute<4>(accessor, joints, {});
+            out.resize(joints.size());
+            for (size_t i = 0; i < joints.size(); i++)
+            {
+                for (size_t k = 0; k < 4; k++)
+                {
+                    out[i][k] = static_cast<uint16_t>(joints[i][k]);
+                }
+            }
+        }
+
+        std::vector<uint32_t> unpackIndices(const cgltf_accessor& accessor)
+        {
+            std::vector<uint32_t> indices(accessor.count);
+
+            // Tightly packed index buffers, by far the common case, are copied without
+            // going through the per element accessor path.
+            const cgltf_buffer_view* view = accessor.buffer_view;
+            const uint8_t*           data = nullptr;
+            if (view != nullptr && !accessor.is_sparse)
+            {
+                data = cgltf_buffer_view_data(view);
+            }
+            if (data != nullptr)
+            {
+                data += accessor.offset;
+                switch (accessor.component_type)
+                {
+                case cgltf_component_type_r_8u:
+                    for (size_t i = 0; i < accessor.count; i++)
+                    {
+                        indices[i] = data[i * accessor.stride];
+                    }
+                    return indices;
+                case cgltf_component_type_r_16u:
+                    for (size_t i = 0; i < accessor.count; i++)
+                    {
+                        uint16_t index = 0;
+                        std::memcpy(&index, data + i * accessor.stride, sizeof(index));
+                        indices[i] = index;
+                    }
+                    return indices;
+                case cgltf_component_type_r_32u:
+                    if (accessor.stride == sizeof(uint32_t))
+                    {
+                        std::memcpy(indices.data(), data, indices.size() * sizeof(uint32_t));
+                        return indices;
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            for (size_t i = 0; i < accessor.count; i++)
+            {
+                indices[i] = static_cast<uint32_t>(cgltf_accessor_read_index(&accessor, i));
+            }
+            return indices;
+        }
+
+        /// Rewrites strip and fan indices as a triangle list.
+        std::vector<uint32_t> toTriangleList(
+            const cgltf_primitive_type type, const std::vector<uint32_t>& indices)
+        {
+            if (type == cgltf_primitive_type_triangles || indices.size() < 3)
+            {
+                return type == cgltf_primitive_type_triangles ? indices : std::vector<uint32_t> {};
+            }
+
+            std::vector<uint32_t> list;
+            list.reserve((indices.size() - 2) * 3);
+            for (size_t i = 2; i < indices.size(); i++)
+            {
+                if (type == cgltf_primitive_type_triangle_fan)
+                {
+                    list.insert(list.end(), { indices[0], indices[i - 1], indices[i] });
+                }
+                else if (i % 2 == 0)
+                {
+                    list.insert(list.end(), { indices[i - 2], indices[i - 1], indices[i] });
+                }
+                else
+                {
+                    // Odd strip triangles swap their first two vertices to keep the winding
+                    list.insert(list.end(), { indices[i - 1], indices[i - 2], indices[i] });
+                }
+            }
+            return list;
+        }
+
+        void decodePrimitive(
+            const cgltf_primitive& source, Primitive& target, const VertexFormat format)
+        {
+            if (source.has_draco_mesh_compression)
+            {
+                throw std::runtime_error("Draco compressed primitives are not supported");
+            }
+
+            VertexStreams& streams = target.streams;
+            for (size_t i = 0; i < source.attributes_count; i++)
+            {
+                const cgltf_attribute& attribute = source.attributes[i];
+                if (attribute.index != 0 || attribute.data == nullptr)
+                {
+                    continue;
+                }
+
+                const cgltf_accessor& accessor = *attribute.data;
+                switch (attribute.type)
+                {
+                case cgltf_attribute_type_position:
+                    unpackAttribute<3>(accessor, streams.positions, {});
+                    break;
+                case cgltf_attribute_type_normal:
+                    unpackAttribute<3>(accessor, streams.normals, {});
+                    break;
+                case cgltf_attribute_type_texcoord:
+                    unpackAttribute<2>(accessor, streams.texCoords, {});
+                    break;
+                case cgltf_attribute_type_tangent:
+                    unpackAttribute<4>(accessor, streams.tangents, {});
+                    break;
+                case cgltf_attribute_type_color:
+                    // RGB colors are widened to RGBA with opaque alpha
+                    unpackAttribute<4>(accessor, streams.colors, { 0.0F, 0.0F, 0.0F, 1.0F });
+                    break;
+                case cgltf_attribute_type_joints:
+                    unpackJoints(accessor, streams.joints);
+                    break;
+                case cgltf_attribute_type_weights:
+                    unpackAttribute<4>(accessor, streams.weights, {});
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            const size_t vertexCount = streams.positions.size();
+            if (vertexCount == 0)
+            {
+                throw std::runtime_error("primitive has no positions");
+            }
+
+            std::vector<uint32_t> indices;
+            if (source.indices != nullptr)
+            {
+                indices = unpackIndices(*source.indices);
+            }
+            else
+            {
+                indices.resize(vertexCount);
+                std::iota(indices.begin(), indices.end(), 0U);
+            }
+            target.indices = toTriangleList(source.type, indices);
+
+            target.boundsMin = streams.positions.front();
+            target.boundsMax = streams.positions.front();
+            for (const auto& position : streams.positions)
+            {
+                for (size_t axis = 0; axis < 3; axis++)
+                {
+                    target.boundsMin[axis] = std::min(target.boundsMin[axis], position[axis]);
+                    target.boundsMax[axis] = std::max(target.boundsMax[axis], position[axis]);
+                }
+            }
+
+            if (format == VertexFormat::Streams)
+            {
+                return;
+            }
+
+            target.vertices.resize(vertexCount);
+            for (size_t i = 0; i < vertexCount; i++)
+            {
+                MeshVertex& vertex = target.vertices[i];
+                vertex.position = streams.positions[i];
+                if (!streams.normals.empty())
+                {
+                    vertex.normal = streams.normals[i];
+                }
+                if (!streams.texCoords.empty())
+                {
+                    vertex.texCoord = streams.texCoords[i];
+                }
+                if (!streams.tangents.empty())
+                {
+                    vertex.tangent = streams.tangents[i];
+                }
+                if (!streams.colors.empty())
+                {
+                    vertex.color = streams.colors[i];
+                }
+            }
+            target.streams = {};
+        }
+
+        std::vector<std::byte> decodeBase64(const std::string_view text)
+        {
+            constexpr std::string_view alphabet =
+                "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+            std::vector<std::byte> bytes;
+            bytes.reserve(text.size() / 4 * 3);
+            uint32_t buffer = 0;
+            int      bits = 0;
+            for (const char c : text)
+            {
+                if (c == '=')
+                {
+                    break;
+                }
+                const size_t value = alphabet.find(c);
+                if (value == std::string_view::npos)
+                {
+                    throw std::runtime_error("invalid base64 data URI");
+                }
+                buffer = (buffer << 6) | static_cast<uint32_t>(value);
+                bits += 6;
+                if (bits >= 8)
+                {
+                    bits -= 8;
+                    bytes.push_back(static_cast<std::byte>((buffer >> bits) & 0xFF));
+                }
+            }
+            return bytes;
+        }
+
+        Image convertImage(const cgltf_image& source, const std::filesystem::path& baseDirectory)
+        {
+            Image image;
+            image.name = toString(source.name);
+            image.mimeType = toString(source.mime_type);
+
+            if (source.buffer_view != nullptr)
+            {
+                const auto* data = reinterpret_cast<const std::byte*>(
+                    cgltf_buffer_view_data(source.buffer_view));
+                if (data != nullptr)
+                {
+                    image.data.assign(data, data + source.buffer_view->size);
+                }
+                return image;
+            }
+
+            const std::string uri = toString(source.uri);
+            if (uri.starts_with("data:"))
+            {
+                const size_t comma = uri.find(',');
+                const size_t base64 = uri.find(";base64");
+                if (comma == std::string::npos || base64 == std::string::npos || base64 > comma)
+                {
+                    throw std::runtime_error("only base64 data URIs are supported for images");
+                }
+                if (image.mimeType.empty())
+                {
+                    image.mimeType = uri.substr(5, base64 - 5);
+                }
+                image.data = decodeBase64(std::string_view(uri).substr(comma + 1));
+            }
+            else if (!uri.empty())
+            {
+                std::string decoded = uri;
+                cgltf_decode_uri(decoded.data());
+                decoded.resize(std::strlen(decoded.c_str()));
+                image.path = baseDirectory / decoded;
+            }
+            return image;
+        }
+
+        int32_t textureImage(const cgltf_texture_view& view, const cgltf_data& data)
+        {
+            return view.texture != nullptr ? indexOf(view.texture->image, data.images) : -1;
+        }
+
+        Material convertMaterial(const cgltf_material& source, const cgltf_data& data)
+        {
+            Material material;
+            material.name = toString(source.name);
+            if (source.has_pbr_metallic_roughness)
+            {
+                const cgltf_pbr_metallic_roughness& pbr = source.pbr_metallic_roughness;
+                std::copy_n(pbr.base_color_factor, 4, material.baseColorFactor.begin());
+                material.metallicFactor = pbr.metallic_factor;
+                material.roughnessFactor = pbr.roughness_factor;
+                material.baseColorTexture = textureImage(pbr.base_color_texture, data);
+                material.metallicRoughnessTexture =
+                    textureImage(pbr.metallic_roughness_texture, data);
+            }
+            std::copy_n(source.emissive_factor, 3, material.emissiveFactor.begin());
+            material.normalTexture = textureImage(source.normal_texture, data);
+            material.occlusionTexture = textureImage(source.occlusion_texture, data);
+            material.emissiveTexture = textureImage(source.emissive_texture, data);
+            material.alphaCutoff = source.alpha_cutoff;
+            material.doubleSided = source.double_sided != 0;
+            switch (source.alpha_mode)
+            {
+            case cgltf_alpha_mode_mask:
+                material.alphaMode = AlphaMode::Mask;
+                break;
+            case cgltf_alpha_mode_blend:
+                material.alphaMode = AlphaMode::Blend;
+                break;
+            default:
+                material.alphaMode = AlphaMode::Opaque;
+                break;
+            }
+            return material;
+        }
+
+        Node convertNode(const cgltf_node& source, const cgltf_data& data)
+        {
+            Node node;
+            node.name = toString(source.name);
+            node.parent = indexOf(source.parent, data.nodes);
+            node.mesh = indexOf(source.mesh, data.meshes);
+            node.skin = indexOf(source.skin, data.skins);
+            for (size_t i = 0; i < source.children_count; i++)
+            {
+                node.children.push_back(indexOf(source.children[i], data.nodes));
+            }
+            if (source.has_translation)
+            {
+                std::copy_n(source.translation, 3, node.translation.begin());
+            }
+            if (source.has_rotation)
+            {
+                std::copy_n(source.rotation, 4, node.rotation.begin());
+            }
+            if (source.has_scale)
+            {
+                std::copy_n(source.scale, 3, node.scale.begin());
+            }
+            cgltf_node_transform_local(&source, node.localTransform.data());
+            return node;
+        }
+
+        Skin convertSkin(const cgltf_skin& source, const cgltf_data& data)
+        {
+            Skin skin;
+            skin.name = toString(source.name);
+            skin.skeleton = indexOf(source.skeleton, data.nodes);
+            for (size_t i = 0; i < source.joints_count; i++)
+            {
+                skin.joints.push_back(indexOf(source.joints[i], data.nodes));
+            }
+
+            Matrix4 identity {};
+            for (size_t i = 0; i < 4; i++)
+            {
+                identity[i * 5] = 1.0F;
+            }
+            skin.inverseBindMatrices.assign(skin.joints.size(), identity);
+            if (source.inverse_bind_matrices != nullptr)
+            {
+                const cgltf_accessor& accessor = *source.inverse_bind_matrices;
+                if (accessor.type != cgltf_type_mat4 || accessor.count < skin.joints.size())
+                {
+                    throw std::runtime_error(std::format(
+                        "skin {} has invalid inverse bind matrices", skin.name));
+                }
+                cgltf_accessor_unpack_floats(&accessor, skin.inverseBindMatrices.front().data(),
+                    skin.joints.size() * 16);
+            }
+            return skin;
+        }
+
+        Animation convertAnimation(const cgltf_animation& source, const cgltf_data& data)
+        {
+            Animation animation;
+            animation.name = toString(source.name);
+            for (size_t i = 0; i < source.channels_count; i++)
+            {
+                const cgltf_animation_channel& channel = source.channels[i];
+                AnimationChannel               target;
+                switch (channel.target_path)
+                {
+                case cgltf_animation_path_type_translation:
+                    target.path = AnimationPath::Translation;
+                    break;
+                case cgltf_animation_path_type_rotation:
+                    target.path = AnimationPath::Rotation;
+                    break;
+                case cgltf_animation_path_type_scale:
+                    target.path = AnimationPath::Scale;
+                    break;
+                default:
+                    continue;
+                }
+                if (channel.target_node == nullptr || channel.sampler == nullptr)
+                {
+                    continue;
+                }
+                target.node = indexOf(channel.target_node, data.nodes);
+
+                const cgltf_animation_sampler& sampler = *channel.sampler;
+                switch (sampler.interpolation)
+                {
+                case cgltf_interpolation_type_step:
+                    target.interpolation = AnimationInterpolation::Step;
+                    break;
+                case cgltf_interpolation_type_cubic_spline:
+                    target.interpolation = AnimationInterpolation::CubicSpline;
+                    break;
+                default:
+                    target.interpolation = AnimationInterpolation::Linear;
+                    break;
+                }
+
+                const cgltf_accessor& input = *sampler.input;
+                const cgltf_accessor& output = *sampler.output;
+                const size_t components = target.path == AnimationPath::Rotation ? 4 : 3;
+                const size_t valuesPerKey =
+                    target.interpolation == AnimationInterpolation::CubicSpline ? 3 : 1;
+                if (input.count == 0 || cgltf_num_components(output.type) != components
+                    || output.count != input.count * valuesPerKey)
+                {
+                    throw std::runtime_error(std::format(
+                        "animation {} channel {} has mismatched keys", animation.name, i));
+                }
+                target.times.resize(input.count);
+                cgltf_accessor_unpack_floats(&input, target.times.data(), target.times.size());
+                target.values.resize(output.count * components);
+                cgltf_accessor_unpack_floats(&output, target.values.data(), target.values.size());
+
+                animation.duration = std::max(animation.duration, target.times.back());
+                animation.channels.push_back(std::move(target));
+            }
+            return animation;
+        }
+
+        Scene loadScene(const std::span<const std::byte> bytes,
+            const std::filesystem::path& baseDirectory, const std::string& name,
+            const SceneLoadOptions& options)
+        {
+            cgltf_options parseOptions {};
+            cgltf_data*   parsed = nullptr;
+            cgltf_result  result = cgltf_parse(&parseOptions, bytes.data(), bytes.size(), &parsed);
+            DataPointer   data(parsed);
+            if (result != cgltf_result_success)
+            {
+                throw std::runtime_error(
+                    std::format("Failed to parse glTF {}: {}", name, resultName(result)));
+            }
+
+            // cgltf resolves buffer URIs against the directory part of this path
+            const std::string basePath = (baseDirectory / "").generic_string();
+            result = cgltf_load_buffers(&parseOptions, data.get(), basePath.c_str());
+            if (result != cgltf_result_success)
+            {
+                throw std::runtime_error(std::format(
+                    "Failed to load the buffers of glTF {}: {}", name, resultName(result)));
+            }
+
+            result = cgltf_validate(data.get());
+            if (result != cgltf_result_success)
+            {
+                throw std::runtime_error(
+                    std::format("Invalid glTF {}: {}", name, resultName(result)));
+            }
+
+            Scene scene;
+            for (size_t i = 0; i < data->images_count; i++)
+            {
+                scene.images.push_back(convertImage(data->images[i], baseDirectory));
+            }
+            for (size_t i = 0; i < data->materials_count; i++)
+            {
+                scene.materials.push_back(convertMaterial(data->materials[i], *data));
+            }
+            for (size_t i = 0; i < data->nodes_count; i++)
+            {
+                scene.nodes.push_back(convertNode(data->nodes[i], *data));
+            }
+            for (size_t i = 0; i < data->skins_count; i++)
+            {
+                scene.skins.push_back(convertSkin(data->skins[i], *data));
+            }
+            for (size_t i = 0; i < data->animations_count; i++)
+            {
+                scene.animations.push_back(convertAnimation(data->animations[i], *data));
+            }
+
+            const cgltf_scene* defaultScene = data->scene;
+            if (defaultScene == nullptr && data->scenes_count > 0)
+            {
+                defaultScene = data->scenes;
+            }
+            if (defaultScene != nullptr)
+            {
+                for (size_t i = 0; i < defaultScene->nodes_count; i++)
+                {
+                    scene.rootNodes.push_back(indexOf(defaultScene->nodes[i], data->nodes));
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < scene.nodes.size(); i++)
+                {
+                    if (scene.nodes[i].parent < 0)
+                    {
+                        scene.rootNodes.push_back(static_cast<int32_t>(i));
+                    }
+                }
+            }
+
+            // Primitive storage is allocated up front so the jobs only write into their
+            // own primitive and never reallocate shared vectors
+            std::vector<PrimitiveJob> jobs;
+            scene.meshes.resize(data->meshes_count);
+            for (size_t i = 0; i < data->meshes_count; i++)
+            {
+                const cgltf_mesh& source = data->meshes[i];
+                Mesh&             mesh = scene.meshes[i];
+                mesh.name = toString(source.name);
+                mesh.primitives.reserve(source.primitives_count);
+                for (size_t j = 0; j < source.primitives_count; j++)
+                {
+                    const cgltf_primitive& primitive = source.primitives[j];
+                    if (isTriangles(primitive))
+                    {
+                        Primitive& target = mesh.primitives.emplace_back();
+                        target.material = indexOf(primitive.material, data->materials);
+                        jobs.push_back({ &primitive, &target, i, {} });
+                    }
+                }
+            }
+
+            // The pool does not propagate exceptions, so failures are collected per job
+            ThreadPool& pool = options.threadPool != nullptr ? *options.threadPool
+                                                             : ThreadPool::shared();
+            pool.parallelFor(jobs.size(), 1, [&](const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; i++)
+                {
+                    try
+                    {
+                        decodePrimitive(*jobs[i].source, *jobs[i].target, options.vertexFormat);
+                    }
+                    catch (const std::exception& exception)
+                    {
+                        jobs[i].error = exception.what();
+                    }
+                }
+            });
+
+            for (const auto& job : jobs)
+            {
+                if (!job.error.empty())
+                {
+                    throw std::runtime_error(std::format("Failed to decode mesh {} of glTF {}: {}",
+                        job.mesh, name, job.error));
+                }
+            }
+            return scene;
+        }
+    } // namespace
+
+    size_t Primitive::vertexCount() const
+    {
+        return vertices.empty() ? streams.positions.size() : vertices.size();
+    }
+
+    SceneLoader::SceneLoader(const SceneLoadOptions options)
+        : m_options(options)
+    {
+    }
+
+    Scene SceneLoader::load(const std::filesystem::path& path) const
+    {
+        // The mapping only needs to outlive parsing: everything the scene keeps is copied
+        const MappedFile file(path);
+        return loadScene(file.bytes(), path.parent_path(), path.string(), m_options);
+    }
+
+    Scene SceneLoader::load(
+        const std::span<const std::byte> data, const std::filesystem::path& baseDirectory) const
+    {
+        return loadScene(data, baseDirectory, "from memory", m_options);
+    }
+} // namespace Assets
@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+namespace Assets
+{
+    /// @brief Row-major 4x4 matrix using the row-vector convention of DirectXMath.
+    /// glTF's column-major matrices have the same memory layout and copy in directly.
+    using Matrix4 = std::array<float, 16>;
+
+    /// @brief Interleaved vertex with every attribute the loader decodes. Attributes
+    /// a primitive lacks keep their defaults.
+    struct MeshVertex
+    {
+        std::array<float, 3> position {};
+        std::array<float, 3> normal { 0.0F, 0.0F, 1.0F };
+        std::array<float, 2> texCoord {};
+        std::array<float, 4> tangent { 1.0F, 0.0F, 0.0F, 1.0F };
+        std::array<float, 4> color { 1.0F, 1.0F, 1.0F, 1.0F };
+    };
+
+    /// @brief Vertex attributes as separate tightly packed streams. Streams of
+    /// attributes the primitive lacks are empty.
+    struct VertexStreams
+    {
+        std::vector<std::array<float, 3>> positions;
+        std::vector<std::array<float, 3>> normals;
+        std::vector<std::array<float, 2>> texCoords;
+        std::vector<std::array<float, 4>> tangents;
+        std::vector<std::array<float, 4>> colors;
+        /// Skin joints (JOINTS_0) of each vertex, as indices into Skin::joints.
+        std::vector<std::array<uint16_t, 4>> joints;
+        std::vector<std::array<float, 4>>    weights; ///< Of the joints (WEIGHTS_0).
+    };
+
+    enum class VertexFormat
+    {
+        Interleaved, ///< Fill Primitive::vertices. Skin joints and weights are dropped.
+        Streams,     ///< Fill Primitive::streams.
+    };
+
+    /// @brief Indexed triangle list with one material.
+    struct Primitive
+    {
+        std::vector<MeshVertex> vertices; ///< With VertexFormat::Interleaved.
+        VertexStreams           streams;  ///< With VertexFormat::Streams.
+        std::vector<uint32_t>   indices;  ///< Generated for non-indexed primitives.
+        int32_t                 material = -1;
+        std::array<float, 3>    boundsMin {};
+        std::array<float, 3>    boundsMax {};
+
+        [[nodiscard]] size_t vertexCount() const;
+    };
+
+    struct Mesh
+    {
+        std::string            name;
+        std::vector<Primitive> primitives;
+    };
+
+    /// @brief Encoded image referenced by materials, either embedded or external.
+    struct Image
+    {
+        std::string            name;
+        std::string            mimeType;
+        std::filesystem::path  path; ///< External file, resolved against the scene.
+        std::vector<std::byte> data; ///< Embedded (GLB buffer view or data URI) bytes.
+    };
+
+    enum class AlphaMode
+    {
+        Opaque,
+        Mask,
+        Blend,
+    };
+
+    /// @brief Metallic-roughness material. Texture members index Scene::images, or
+    /// are -1 when absent.
+    struct Material
+    {
+        std::string          name;
+        std::array<float, 4> baseColorFactor { 1.0F, 1.0F, 1.0F, 1.0F };
+        std::array<float, 3> emissiveFactor {};
+        float                metallicFactor = 1.0F;
+        float                roughnessFactor = 1.0F;
+        float                alphaCutoff = 0.5F;
+        AlphaMode            alphaMode = AlphaMode::Opaque;
+        bool                 doubleSided = false;
+        int32_t              baseColorTexture = -1;
+        int32_t              metallicRoughnessTexture = -1;
+        int32_t              normalTexture = -1;
+        int32_t              occlusionTexture = -1;
+        int32_t              emissiveTexture = -1;
+    };
+
+    /// @brief Scene graph node. Nodes given as a matrix keep the identity TRS; the
+    /// local transform is always valid.
+    struct Node
+    {
+        std::string          name;
+        int32_t              parent = -1;
+        std::vector<int32_t> children;
+        int32_t              mesh = -1;
+        int32_t              skin = -1;
+        std::array<float, 3> translation {};
+        std::array<float, 4> rotation { 0.0F, 0.0F, 0.0F, 1.0F }; ///< Quaternion xyzw.
+        std::array<float, 3> scale { 1.0F, 1.0F, 1.0F };
+        Matrix4              localTransform {}; ///< Composed from TRS or the node matrix.
+    };
+
+    /// @brief Joints deforming the meshes of the nodes that reference the skin.
+    struct Skin
+    {
+        std::string          name;
+        std::vector<int32_t> joints; ///< Node indices, in the order vertices refer to them.
+        /// Model to joint space at rest, one per joint; identity when the file has none.
+        std::vector<Matrix4> inverseBindMatrices;
+        int32_t              skeleton = -1; ///< Common root node, if the file names one.
+    };
+
+    enum class AnimationPath
+    {
+        Translation,
+        Rotation,
+        Scale,
+    };
+
+    enum class AnimationInterpolation
+    {
+        Step,
+        Linear,
+        CubicSpline,
+    };
+
+    /// @brief Keyframes animating one property of a node, as stored in the file.
+    struct AnimationChannel
+    {
+        int32_t                node = -1;
+        AnimationPath          path = AnimationPath::Translation;
+        AnimationInterpolation interpolation = AnimationInterpolation::Linear;
+        std::vector<float>     times; ///< Seconds, increasing.
+        /// Three components per key, four for rotations (quaternion xyzw). Cubic
+        /// splines store an in tangent, the value and an out tangent per key.
+        std::vector<float> values;
+    };
+
+    /// @brief Animation clip. Morph target weight channels are not loaded.
+    struct Animation
+    {
+        std::string                   name;
+        std::vector<AnimationChannel> channels;
+        float                         duration = 0.0F; ///< Time of the last key.
+    };
+
+    struct Scene
+    {
+        std::vector<Mesh>      meshes;
+        std::vector<Material>  materials;
+        std::vector<Image>     images;
+        std::vector<Node>      nodes;
+        std::vector<int32_t>   rootNodes; ///< Roots of the default scene.
+        std::vector<Skin>      skins;
+        std::vector<Animation> animations;
+    };
+
+    struct SceneLoadOptions
+    {
+        VertexFormat vertexFormat = VertexFormat::Interleaved;
+        ThreadPool*  threadPool = nullptr; ///< Pool decoding meshes; nullptr for shared.
+    };
+
+    /// @brief Loads glTF 2.0 scenes (.gltf with external or embedded buffers, and .glb)
+    /// through cgltf.
+    ///
+    /// The JSON is parsed on the calling thread, then the accessors of all primitives
+    /// are decoded in parallel, each primitive being independent. Triangle strips and
+    /// fans are converted to lists; point and line primitives are skipped.
+    class SceneLoader
+    {
+    public:
+        explicit SceneLoader(SceneLoadOptions options = {});
+
+        /// @brief Loads a scene from a file, which is memory mapped for parsing.
+        /// @throws std::runtime_error if the file cannot be read or is not valid glTF.
+        [[nodiscard]] Scene load(const std::filesystem::path& path) const;
+
+        /// @brief Loads a scene from memory.
+        /// @param [in] data Contents of a .gltf or .glb file.
+        /// @param [in] baseDirectory Directory external buffers and images are
+        /// resolved against.
+        /// @throws std::runtime_error if data is not valid glTF.
+        [[nodiscard]] Scene load(
+            std::span<const std::byte> data, const std::filesystem::path& baseDirectory) const;
+
+    private:
+        SceneLoadOptions m_options;
+    };
+} // namespace Assets
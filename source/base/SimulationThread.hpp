@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#include <SDL3/SDL_timer.h>
+
+#include "GameTimer.hpp"
+#include "TripleBuffer.hpp"
+
+/// @brief Runs a fixed timestep simulation on its own thread.
+///
+/// Each step advances a private copy of the state. After a step the thread publishes
+/// an immutable snapshot with the states before and after that step through a
+/// TripleBuffer, so a slow render thread never blocks the simulation and vice versa.
+/// The render side blends the two states by how far the current time is past the
+/// step, trailing the simulation by at most one step.
+/// @tparam TState Copyable simulation state.
+template <typename TState>
+class SimulationThread
+{
+public:
+    struct Snapshot
+    {
+        TState   previous {};
+        TState   current {};
+        uint64_t stepNumber = 0; ///< Steps taken to produce current.
+        uint64_t time = 0;       ///< Performance counter value when current was produced.
+    };
+
+    /// @brief Advances the state by one step of timer.elapsedSeconds().
+    using StepFunction = std::function<void(const GameTimer& timer, TState& state)>;
+
+    /// @brief Constructor
+    /// @param [in] initialState State before the first step.
+    /// @param [in] stepSeconds Fixed timestep in seconds.
+    /// @param [in] step Step function, invoked on the simulation thread only.
+    SimulationThread(const TState& initialState, const double stepSeconds, StepFunction step)
+        : m_mailbox(Snapshot { initialState, initialState, 0, SDL_GetPerformanceCounter() })
+        , m_state(initialState)
+        , m_stepSeconds(stepSeconds)
+        , m_stepTicks(std::max<uint64_t>(1,
+              static_cast<uint64_t>(
+                  stepSeconds * static_cast<double>(SDL_GetPerformanceFrequency()))))
+        , m_step(std::move(step))
+    {
+    }
+
+    ~SimulationThread()
+    {
+        stop();
+    }
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start()
+    {
+        if (m_running.exchange(true))
+        {
+            return;
+        }
+        m_thread = std::thread([this] { run(); });
+    }
+
+    /// @brief Stops the thread after its current step. The state is kept, so the
+    /// simulation resumes where it left off on the next start.
+    void stop()
+    {
+        m_running = false;
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    [[nodiscard]] bool isRunning() const
+    {
+        return m_running;
+    }
+
+    [[nodiscard]] double stepSeconds() const
+    {
+        return m_stepSeconds;
+    }
+
+    /// @brief Render side: returns the latest published snapshot.
+    /// @note The reference stays valid until the next call. Single consumer only.
+    [[nodiscard]] const Snapshot& latestSnapshot()
+    {
+        m_mailbox.update();
+        return m_mailbox.readBuffer();
+    }
+
+    /// @brief Blend factor from snapshot.previous (0) to snapshot.current (1).
+    /// @param [in] currentTime Performance counter value being rendered.
+    [[nodiscard]] double interpolationFactor(
+        const Snapshot& snapshot, const uint64_t currentTime) const
+    {
+        if (currentTime <= snapshot.time)
+        {
+            return 0.0;
+        }
+        return std::min(1.0,
+            static_cast<double>(currentTime - snapshot.time) / static_cast<double>(m_stepTicks));
+    }
+
+private:
+    void run()
+    {
+        GameTimer timer;
+        timer.setFixedTimeStep(true);
+        timer.setTargetElapsedSeconds(m_stepSeconds);
+        timer.resetElapsedTime();
+
+        uint64_t nextStepTime = SDL_GetPerformanceCounter() + m_stepTicks;
+        while (m_running.load(std::memory_order_acquire))
+        {
+            // The timer runs as many fixed steps as have accumulated, catching up after
+            // a stall up to its maximum delta.
+            TState previous = m_state;
+            bool   stepped = false;
+            timer.tick([&] {
+                previous = m_state;
+                m_step(timer, m_state);
+                m_stepNumber++;
+                stepped = true;
+            });
+
+            const uint64_t now = SDL_GetPerformanceCounter();
+            if (stepped)
+            {
+                Snapshot& snapshot = m_mailbox.writeBuffer();
+                snapshot.previous = previous;
+                snapshot.current = m_state;
+                snapshot.stepNumber = m_stepNumber;
+                snapshot.time = now;
+                m_mailbox.publish();
+            }
+
+            if (now < nextStepTime)
+            {
+                SDL_DelayPrecise((nextStepTime - now) * SDL_NS_PER_SECOND
+                    / SDL_GetPerformanceFrequency());
+                nextStepTime += m_stepTicks;
+            }
+            else
+            {
+                nextStepTime = now + m_stepTicks;
+            }
+        }
+    }
+
+    TripleBuffer<Snapshot> m_mailbox;
+    TState                 m_state;
+    uint64_t               m_stepNumber = 0;
+    double                 m_stepSeconds;
+    uint64_t               m_stepTicks;
+    StepFunction           m_step;
+    std::atomic<bool>      m_running = false;
+    std::thread            m_thread;
+};
@@ -0,0 +1,395 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Skinning.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+#include "Animation.hpp"
+#include "ThreadPool.hpp"
+
+namespace Animation
+{
+    namespace
+    {
+        /// Vertices per task of the parallel skinning loop.
+        constexpr size_t g_chunkVertices = 4096;
+
+        /// Rigid transform as a unit dual quaternion: the rotation in real and half
+        /// the translation, rotated, in dual. Both xyzw.
+        struct DualQuaternion
+        {
+            std::array<float, 4> real;
+            std::array<float, 4> dual;
+        };
+
+        DualQuaternion toDualQuaternion(const Assets::Matrix4& matrix)
+        {
+            const Transform transform = decompose(matrix);
+            const auto& [x, y, z, w] = transform.rotation;
+            const auto& t = transform.translation;
+
+            // dual = 0.5 * (t, 0) * real
+            return { transform.rotation,
+                { 0.5F * (t[0] * w + t[1] * z - t[2] * y),
+                    0.5F * (-t[0] * z + t[1] * w + t[2] * x),
+                    0.5F * (t[0] * y - t[1] * x + t[2] * w),
+                    -0.5F * (t[0] * x + t[1] * y + t[2] * z) } };
+        }
+
+        std::array<float, 3> cross(const std::array<float, 3>& a, const std::array<float, 3>& b)
+        {
+            return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+                a[0] * b[1] - a[1] * b[0] };
+        }
+
+        void writeNormal(std::array<float, 3>& out, const float x, const float y, const float z)
+        {
+            const float length = std::sqrt(x * x + y * y + z * z);
+            const float scale = length > 0.0F ? 1.0F / length : 0.0F;
+            out = { x * scale, y * scale, z * scale };
+        }
+
+        /// Streams of one skinned mesh as plain pointers, with the influence count fixed
+        /// at compile time so the blends unroll into straight SIMD code.
+        template <uint32_t TInfluences>
+        struct MeshStreams
+        {
+            explicit MeshStreams(const SkinnedMesh& mesh)
+            {
+                for (size_t axis = 0; axis < 3; axis++)
+                {
+                    positions[axis] = mesh.position(axis).data();
+                    normals[axis] = mesh.normal(axis).data();
+                }
+                for (uint32_t influence = 0; influence < TInfluences; influence++)
+                {
+                    joints[influence] = mesh.joints(influence).data();
+                    weights[influence] = mesh.weights(influence).data();
+                }
+            }
+
+            std::array<const float*, 3>              positions {};
+            std::array<const float*, 3>              normals {};
+            std::array<const uint16_t*, TInfluences> joints {};
+            std::array<const float*, TInfluences>    weights {};
+        };
+
+        template <uint32_t TInfluences>
+        void skinLinearBlend(const SkinnedMesh&     mesh,
+            const std::span<const Assets::Matrix4> skinning,
+            const std::span<std::array<float, 3>>  positions,
+            const std::span<std::array<float, 3>>  normals,
+            const size_t                           first,
+            const size_t                           count)
+        {
+            const MeshStreams<TInfluences> streams(mesh);
+            const bool                     writeNormals = !normals.empty() && mesh.hasNormals();
+            for (size_t vertex = first; vertex < first + count; vertex++)
+            {
+                // Rows of the blended matrix, all four columns so the blend fills
+                // SIMD registers
+                Assets::Matrix4 blended {};
+                for (uint32_t influence = 0; influence < TInfluences; influence++)
+                {
+                    const float  weight = streams.weights[influence][vertex];
+                    const float* matrix = skinning[streams.joints[influence][vertex]].data();
+                    for (size_t i = 0; i < 16; i++)
+                    {
+                        blended[i] += weight * matrix[i];
+                    }
+                }
+
+                const float x = streams.positions[0][vertex];
+                const float y = streams.positions[1][vertex];
+                const float z = streams.positions[2][vertex];
+                for (size_t column = 0; column < 3; column++)
+                {
+                    positions[vertex][column] = x * blended[column] + y * blended[4 + column]
+                        + z * blended[8 + column] + blended[12 + column];
+                }
+
+                if (writeNormals)
+                {
+                    // Normals take the blended matrix as is, exact for uniform scale
+                    const float          nx = streams.normals[0][vertex];
+                    const float          ny = streams.normals[1][vertex];
+                    const float          nz = streams.normals[2][vertex];
+                    std::array<float, 3> normal {};
+                    for (size_t column = 0; column < 3; column++)
+                    {
+                        normal[column] = nx * blended[column] + ny * blended[4 + column]
+                            + nz * blended[8 + column];
+                    }
+                    writeNormal(normals[vertex], normal[0], normal[1], normal[2]);
+                }
+            }
+        }
+
+        template <uint32_t TInfluences>
+        void skinDualQuaternion(const SkinnedMesh& mesh,
+            const std::span<const DualQuaternion>   transforms,
+            const std::span<std::array<float, 3>>   positions,
+            const std::span<std::array<float, 3>>   normals,
+            const size_t                            first,
+            const size_t                            count)
+        {
+            const MeshStreams<TInfluences> streams(mesh);
+            const bool                     writeNormals = !normals.empty() && mesh.hasNormals();
+            for (size_t vertex = first; vertex < first + count; vertex++)
+            {
+                // Real and dual parts side by side, blended eight floats at a time. Each
+                // rotation is flipped into the hemisphere of the first one, so blends
+                // take the shorter arc.
+                const DualQuaternion& pivot = transforms[streams.joints[0][vertex]];
+                std::array<float, 8>  blended {};
+                for (uint32_t influence = 0; influence < TInfluences; influence++)
+                {
+                    const DualQuaternion& transform = transforms[streams.joints[influence][vertex]];
+                    const float           alignment = transform.real[0] * pivot.real[0]
+                        + transform.real[1] * pivot.real[1] + transform.real[2] * pivot.real[2]
+                        + transform.real[3] * pivot.real[3];
+                    const float weight
+                        = std::copysign(streams.weights[influence][vertex], alignment);
+                    for (size_t i = 0; i < 4; i++)
+                    {
+                        blended[i] += weight * transform.real[i];
+                        blended[4 + i] += weight * transform.dual[i];
+                    }
+                }
+
+                const float length = std::sqrt(blended[0] * blended[0] + blended[1] * blended[1]
+                    + blended[2] * blended[2] + blended[3] * blended[3]);
+                const float scale = length > 0.0F ? 1.0F / length : 0.0F;
+                for (float& value : blended)
+                {
+                    value *= scale;
+                }
+                const std::array<float, 3> real { blended[0], blended[1], blended[2] };
+                const std::array<float, 3> dual { blended[4], blended[5], blended[6] };
+                const float                realW = blended[3];
+                const float                dualW = blended[7];
+
+                // Rotate by the real part: v + 2 r x (r x v + w v)
+                const auto rotate = [&](const std::array<float, 3>& v) {
+                    const std::array<float, 3> inner = cross(real, v);
+                    const std::array<float, 3> outer = cross(real,
+                        { inner[0] + realW * v[0], inner[1] + realW * v[1],
+                            inner[2] + realW * v[2] });
+                    return std::array { v[0] + 2.0F * outer[0], v[1] + 2.0F * outer[1],
+                        v[2] + 2.0F * outer[2] };
+                };
+
+                // Translation: 2 (w_r d - w_d r + r x d)
+                const std::array<float, 3> offset = cross(real, dual);
+                const std::array<float, 3> rotated = rotate({ streams.positions[0][vertex],
+                    streams.positions[1][vertex], streams.positions[2][vertex] });
+                for (size_t axis = 0; axis < 3; axis++)
+                {
+                    positions[vertex][axis] = rotated[axis]
+                        + 2.0F * (realW * dual[axis] - dualW * real[axis] + offset[axis]);
+                }
+
+                if (writeNormals)
+                {
+                    const std::array<float, 3> normal = rotate({ streams.normals[0][vertex],
+                        streams.normals[1][vertex], streams.normals[2][vertex] });
+                    writeNormal(normals[vertex], normal[0], normal[1], normal[2]);
+                }
+            }
+        }
+
+        /// Skins a range with the kernel matching the mesh's influence count.
+        void skinRange(const SkinnedMesh& mesh, const SkinningMethod method,
+            const std::span<const Assets::Matrix4> skinning,
+            const std::span<const DualQuaternion>  transforms,
+            const std::span<std::array<float, 3>>  positions,
+            const std::span<std::array<float, 3>>  normals,
+            const size_t                           first,
+            const size_t                           count)
+        {
+            const bool eight = mesh.influencesPerVertex() == 8;
+            if (method == SkinningMethod::LinearBlend && eight)
+            {
+                skinLinearBlend<8>(mesh, skinning, positions, normals, first, count);
+            }
+            else if (method == SkinningMethod::LinearBlend)
+            {
+                skinLinearBlend<4>(mesh, skinning, positions, normals, first, count);
+            }
+            else if (eight)
+            {
+                skinDualQuaternion<8>(mesh, transforms, positions, normals, first, count);
+            }
+            else
+            {
+                skinDualQuaternion<4>(mesh, transforms, positions, normals, first, count);
+            }
+        }
+
+        std::vector<DualQuaternion> toDualQuaternions(
+            const std::span<const Assets::Matrix4> skinning)
+        {
+            std::vector<DualQuaternion> transforms(skinning.size());
+            std::ranges::transform(skinning, transforms.begin(), toDualQuaternion);
+            return transforms;
+        }
+    } // namespace
+
+    SkinnedMesh::SkinnedMesh(const Assets::VertexStreams& streams)
+        : SkinnedMesh(streams.positions, streams.normals,
+              { streams.joints.empty() ? nullptr : streams.joints.front().data(),
+                  streams.joints.size() * 4 },
+              { streams.weights.empty() ? nullptr : streams.weights.front().data(),
+                  streams.weights.size() * 4 },
+              4)
+    {
+    }
+
+    SkinnedMesh::SkinnedMesh(const std::span<const std::array<float, 3>> positions,
+        const std::span<const std::array<float, 3>> normals, const std::span<const uint16_t> joints,
+        const std::span<const float> weights, const uint32_t influencesPerVertex)
+        : m_vertexCount(positions.size())
+        , m_influencesPerVertex(influencesPerVertex)
+    {
+        if (influencesPerVertex != 4 && influencesPerVertex != 8)
+        {
+            throw std::runtime_error(std::format(
+                "Skinning supports 4 or 8 influences per vertex, not {}", influencesPerVertex));
+        }
+        const size_t influenceCount = m_vertexCount * influencesPerVertex;
+        if (joints.size() != influenceCount || weights.size() != influenceCount)
+        {
+            throw std::runtime_error(std::format(
+                "Skinned mesh of {} vertices needs {} joints and weights, got {} and {}",
+                m_vertexCount, influenceCount, joints.size(), weights.size()));
+        }
+        if (!normals.empty() && normals.size() != m_vertexCount)
+        {
+            throw std::runtime_error(std::format(
+                "Skinned mesh has {} positions but {} normals", m_vertexCount, normals.size()));
+        }
+
+        for (size_t axis = 0; axis < 3; axis++)
+        {
+            m_positions[axis].resize(m_vertexCount);
+            m_normals[axis].resize(normals.size());
+            for (size_t vertex = 0; vertex < m_vertexCount; vertex++)
+            {
+                m_positions[axis][vertex] = positions[vertex][axis];
+            }
+            for (size_t vertex = 0; vertex < normals.size(); vertex++)
+            {
+                m_normals[axis][vertex] = normals[vertex][axis];
+            }
+        }
+
+        // Transpose to influence major, normalizing the weights
+        m_joints.resize(influenceCount);
+        m_weights.resize(influenceCount);
+        for (size_t vertex = 0; vertex < m_vertexCount; vertex++)
+        {
+            const size_t offset = vertex * influencesPerVertex;
+            const auto   vertexJoints = joints.subspan(offset, influencesPerVertex);
+            const auto   vertexWeights = weights.subspan(offset, influencesPerVertex);
+            float        sum = 0.0F;
+            for (const float weight : vertexWeights)
+            {
+                sum += weight;
+            }
+            for (uint32_t influence = 0; influence < influencesPerVertex; influence++)
+            {
+                // Without weights the vertex follows its first joint
+                const size_t index = influence * m_vertexCount + vertex;
+                m_joints[index] = vertexJoints[influence];
+                m_weights[index] = sum > 0.0F ? vertexWeights[influence] / sum
+                                              : (influence == 0 ? 1.0F : 0.0F);
+                m_jointCount = std::max<size_t>(m_jointCount, vertexJoints[influence] + 1U);
+            }
+        }
+    }
+
+    size_t SkinnedMesh::vertexCount() const
+    {
+        return m_vertexCount;
+    }
+
+    uint32_t SkinnedMesh::influencesPerVertex() const
+    {
+        return m_influencesPerVertex;
+    }
+
+    size_t SkinnedMesh::jointCount() const
+    {
+        return m_jointCount;
+    }
+
+    bool SkinnedMesh::hasNormals() const
+    {
+        return !m_normals[0].empty();
+    }
+
+    std::span<const float> SkinnedMesh::position(const size_t axis) const
+    {
+        return m_positions[axis];
+    }
+
+    std::span<const float> SkinnedMesh::normal(const size_t axis) const
+    {
+        return m_normals[axis];
+    }
+
+    std::span<const uint16_t> SkinnedMesh::joints(const uint32_t influence) const
+    {
+        return std::span<const uint16_t>(m_joints).subspan(
+            influence * m_vertexCount, m_vertexCount);
+    }
+
+    std::span<const float> SkinnedMesh::weights(const uint32_t influence) const
+    {
+        return std::span<const float>(m_weights).subspan(influence * m_vertexCount, m_vertexCount);
+    }
+
+    void skinVertices(const SkinnedMesh& mesh, const SkinningMethod method,
+        const std::span<const Assets::Matrix4> skinning,
+        const std::span<std::array<float, 3>> positions,
+        const std::span<std::array<float, 3>> normals, const size_t first, const size_t count)
+    {
+        assert(skinning.size() >= mesh.jointCount());
+        assert(positions.size() >= mesh.vertexCount());
+        assert(first + count <= mesh.vertexCount());
+        std::vector<DualQuaternion> transforms;
+        if (method == SkinningMethod::DualQuaternion)
+        {
+            transforms = toDualQuaternions(skinning);
+        }
+        skinRange(mesh, method, skinning, transforms, positions, normals, first, count);
+    }
+
+    void skinVertices(const SkinnedMesh& mesh, const SkinningMethod method,
+        const std::span<const Assets::Matrix4> skinning,
+        const std::span<std::array<float, 3>> positions,
+        const std::span<std::array<float, 3>> normals, ThreadPool& threadPool)
+    {
+        assert(skinning.size() >= mesh.jointCount());
+        assert(positions.size() >= mesh.vertexCount());
+
+        // Dual quaternions are converted once for all chunks
+        std::vector<DualQuaternion> transforms;
+        if (method == SkinningMethod::DualQuaternion)
+        {
+            transforms = toDualQuaternions(skinning);
+        }
+        threadPool.parallelFor(
+            mesh.vertexCount(), g_chunkVertices, [&](const size_t begin, const size_t end) {
+                skinRange(
+                    mesh, method, skinning, transforms, positions, normals, begin, end - begin);
+            });
+    }
+} // namespace Animation
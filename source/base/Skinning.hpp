@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SceneLoader.hpp"
+
+class ThreadPool;
+
+namespace Animation
+{
+    enum class SkinningMethod
+    {
+        LinearBlend,    ///< Blends the skinning matrices; joints may scale.
+        DualQuaternion, ///< Blends rigid transforms without volume loss; scale is ignored.
+    };
+
+    /// @brief Bind pose geometry of a skinned primitive and its joint influences.
+    ///
+    /// Positions and normals are stored component by component. Influences are
+    /// stored influence by influence, so a vertex's k-th joint and weight sit at
+    /// k * vertexCount + vertex and every pass over them reads memory in order.
+    class SkinnedMesh
+    {
+    public:
+        SkinnedMesh() = default;
+
+        /// @brief Takes the geometry and the JOINTS_0 and WEIGHTS_0 influences of
+        /// streams loaded with VertexFormat::Streams.
+        /// @throws std::runtime_error if the streams have no influences.
+        explicit SkinnedMesh(const Assets::VertexStreams& streams);
+
+        /// @param [in] normals Empty, or one per position.
+        /// @param [in] joints Per vertex influencesPerVertex skin joints, vertex by vertex.
+        /// @param [in] weights Weights of the joints, normalized on the way in.
+        /// @throws std::runtime_error if influencesPerVertex is not 4 or 8, or the
+        /// sizes disagree.
+        SkinnedMesh(std::span<const std::array<float, 3>> positions,
+            std::span<const std::array<float, 3>> normals, std::span<const uint16_t> joints,
+            std::span<const float> weights, uint32_t influencesPerVertex);
+
+        [[nodiscard]] size_t vertexCount() const;
+
+        [[nodiscard]] uint32_t influencesPerVertex() const;
+
+        /// @brief Returns the highest joint index referenced plus one.
+        [[nodiscard]] size_t jointCount() const;
+
+        [[nodiscard]] bool hasNormals() const;
+
+        [[nodiscard]] std::span<const float> position(size_t axis) const;
+
+        /// @brief Returns a component of the normals, empty without normals.
+        [[nodiscard]] std::span<const float> normal(size_t axis) const;
+
+        /// @brief Returns the k-th joint of every vertex.
+        [[nodiscard]] std::span<const uint16_t> joints(uint32_t influence) const;
+
+        [[nodiscard]] std::span<const float> weights(uint32_t influence) const;
+
+    private:
+        size_t                            m_vertexCount = 0;
+        uint32_t                          m_influencesPerVertex = 0;
+        size_t                            m_jointCount = 0;
+        std::array<std::vector<float>, 3> m_positions;
+        std::array<std::vector<float>, 3> m_normals;
+        std::vector<uint16_t>             m_joints;
+        std::vector<float>                m_weights;
+    };
+
+    /// @brief Skins a range of vertices on the calling thread.
+    ///
+    /// Each vertex blends its joints' transforms and applies the result to its
+    /// position and normal. The blends are unrolled for the influence count and run
+    /// along matrix rows, so they map to SIMD registers where the compiler finds it
+    /// profitable. Outputs are plain spans so they can point straight into an upload
+    /// buffer.
+    /// @param [in] skinning Skinning matrices, see computeSkinningMatrices.
+    /// @param [out] positions One per vertex of the mesh, written in [first, first + count).
+    /// @param [out] normals Like positions; may be empty to skip normals.
+    void skinVertices(const SkinnedMesh& mesh, SkinningMethod method,
+        std::span<const Assets::Matrix4> skinning, std::span<std::array<float, 3>> positions,
+        std::span<std::array<float, 3>> normals, size_t first, size_t count);
+
+    /// @brief Skins every vertex, split into chunks across the thread pool.
+    void skinVertices(const SkinnedMesh& mesh, SkinningMethod method,
+        std::span<const Assets::Matrix4> skinning, std::span<std::array<float, 3>> positions,
+        std::span<std::array<float, 3>> normals, ThreadPool& threadPool);
+} // namespace Animation
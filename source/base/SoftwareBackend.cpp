@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareBackend.hpp"
+
+#include "ThreadPool.hpp"
+
+SoftwareBackend::SoftwareBackend(
+    const Options& options, uint32_t width, uint32_t height, ThreadPool& threadPool)
+    : NullBackend(options)
+    , m_rasterizer(threadPool)
+{
+    m_rasterizer.resize(width, height);
+}
+
+void SoftwareBackend::beginFrame(const uint32_t frameIndex)
+{
+    NullBackend::beginFrame(frameIndex);
+    m_frameIndex = frameIndex;
+
+    // DirectX::Colors::CornflowerBlue, as used by Example::defaultRenderPassDescriptor
+    m_rasterizer.clear({ 0.392156899F, 0.584313750F, 0.929411829F, 1.0F }, 1.0F);
+}
+
+void SoftwareBackend::endFrame(const uint64_t frameNumber)
+{
+    const uint64_t start = SDL_GetPerformanceCounter();
+    m_rasterizer.resolve(m_image);
+    const uint64_t end = SDL_GetPerformanceCounter();
+
+    m_rasterSeconds
+        += static_cast<double>(end - start) / static_cast<double>(SDL_GetPerformanceFrequency());
+    m_trianglesRasterized += m_rasterizer.statistics().trianglesRasterized;
+
+    NullBackend::endFrame(frameNumber);
+}
+
+Raster::Rasterizer& SoftwareBackend::rasterizer()
+{
+    return m_rasterizer;
+}
+
+uint32_t SoftwareBackend::frameIndex() const
+{
+    return m_frameIndex;
+}
+
+const Raster::Image& SoftwareBackend::image() const
+{
+    return m_image;
+}
+
+double SoftwareBackend::rasterSeconds() const
+{
+    return m_rasterSeconds;
+}
+
+uint64_t SoftwareBackend::trianglesRasterized() const
+{
+    return m_trianglesRasterized;
+}
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+#include "NullBackend.hpp"
+#include "SoftwareRasterizer.hpp"
+
+class ThreadPool;
+
+/// @brief Headless backend that renders frames with the software rasterizer.
+///
+/// Mirrors Example's default render pass: the multisampled target is cleared to
+/// cornflower blue with depth 1.0 when a frame begins and resolved into an sRGB
+/// image when it ends.
+class SoftwareBackend final : public NullBackend
+{
+public:
+    SoftwareBackend(
+        const Options& options, uint32_t width, uint32_t height, ThreadPool& threadPool);
+
+    void beginFrame(uint32_t frameIndex) override;
+
+    void endFrame(uint64_t frameNumber) override;
+
+    /// @brief Rasterizer that listeners record draws into during onFrameRender.
+    [[nodiscard]] Raster::Rasterizer& rasterizer();
+
+    /// @brief Resource slot of the frame being recorded, as passed to beginFrame.
+    [[nodiscard]] uint32_t frameIndex() const;
+
+    /// @brief The most recently resolved frame.
+    [[nodiscard]] const Raster::Image& image() const;
+
+    /// @brief Wall time spent executing and resolving draws across all frames.
+    [[nodiscard]] double rasterSeconds() const;
+
+    /// @brief Triangles rasterized across all frames.
+    [[nodiscard]] uint64_t trianglesRasterized() const;
+
+private:
+    Raster::Rasterizer m_rasterizer;
+    Raster::Image      m_image;
+    uint32_t           m_frameIndex = 0;
+    double             m_rasterSeconds = 0.0;
+    uint64_t           m_trianglesRasterized = 0;
+};
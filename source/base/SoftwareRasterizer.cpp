@@ -0,0 +1,782 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "ThreadPool.hpp"
+
+namespace Raster
+{
+    namespace
+    {
+        // Standard 4x sample positions (matches Metal's default MSAA pattern)
+        constexpr std::array<std::array<float, 2>, Rasterizer::s_sampleCount> g_samplePositions
+            = { { { 0.375F, 0.125F }, { 0.875F, 0.375F }, { 0.125F, 0.625F },
+                { 0.625F, 0.875F } } };
+
+        constexpr size_t g_minTrianglesPerChunk = 256;
+        constexpr float  g_clipEpsilon = 1.0e-6F;
+
+        float srgbToLinear(float value)
+        {
+            return value <= 0.04045F ? value / 12.92F
+                                     : std::pow((value + 0.055F) / 1.055F, 2.4F);
+        }
+
+        float linearToSrgb(float value)
+        {
+            return value <= 0.0031308F ? value * 12.92F
+                                       : 1.055F * std::pow(value, 1.0F / 2.4F) - 0.055F;
+        }
+
+        const std::array<float, 256>& srgbDecodeTable()
+        {
+            static const std::array<float, 256> table = [] {
+                std::array<float, 256> result {};
+                for (size_t i = 0; i < result.size(); i++)
+                {
+                    result[i] = srgbToLinear(static_cast<float>(i) / 255.0F);
+                }
+                return result;
+            }();
+            return table;
+        }
+
+        constexpr size_t g_encodeTableSize = 4096;
+
+        const std::array<uint8_t, g_encodeTableSize>& srgbEncodeTable()
+        {
+            static const std::array<uint8_t, g_encodeTableSize> table = [] {
+                std::array<uint8_t, g_encodeTableSize> result {};
+                for (size_t i = 0; i < result.size(); i++)
+                {
+                    const float linear
+                        = static_cast<float>(i) / static_cast<float>(g_encodeTableSize - 1);
+                    result[i] = static_cast<uint8_t>(
+                        std::lround(std::clamp(linearToSrgb(linear), 0.0F, 1.0F) * 255.0F));
+                }
+                return result;
+            }();
+            return table;
+        }
+
+        uint8_t encodeSrgb(float linear)
+        {
+            const float clamped = std::clamp(linear, 0.0F, 1.0F);
+            return srgbEncodeTable()[static_cast<size_t>(
+                clamped * static_cast<float>(g_encodeTableSize - 1) + 0.5F)];
+        }
+
+        uint8_t encodeUnorm(float value)
+        {
+            return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0F, 1.0F) * 255.0F));
+        }
+
+        std::array<float, 4> transform(const std::array<float, 4>& p, const Matrix4& m)
+        {
+            // Row vector times row-major matrix, as XMVector4Transform
+            std::array<float, 4> result {};
+            for (size_t column = 0; column < 4; column++)
+            {
+                result[column] = p[0] * m[column] + p[1] * m[4 + column] + p[2] * m[8 + column]
+                    + p[3] * m[12 + column];
+            }
+            return result;
+        }
+
+        template <size_t N>
+        std::array<float, N> lerp(
+            const std::array<float, N>& a, const std::array<float, N>& b, float t)
+        {
+            std::array<float, N> result {};
+            for (size_t i = 0; i < N; i++)
+            {
+                result[i] = a[i] + (b[i] - a[i]) * t;
+            }
+            return result;
+        }
+
+        bool isTopLeft(float dx, float dy)
+        {
+            return dy < 0.0F || (dy == 0.0F && dx > 0.0F);
+        }
+    } // namespace
+
+    Texture::Texture(std::span<const uint8_t> rgba, uint32_t width, uint32_t height, bool srgb)
+        : m_width(width)
+        , m_height(height)
+    {
+        const size_t texelCount = static_cast<size_t>(width) * height;
+        if (rgba.size() < texelCount * 4)
+        {
+            throw std::invalid_argument("Texture data is smaller than width * height * 4");
+        }
+
+        const auto& decode = srgbDecodeTable();
+        m_texels.resize(texelCount * 4);
+        for (size_t i = 0; i < texelCount * 4; i++)
+        {
+            const bool isAlpha = (i % 4) == 3;
+            m_texels[i]
+                = srgb && !isAlpha ? decode[rgba[i]] : static_cast<float>(rgba[i]) / 255.0F;
+        }
+    }
+
+    uint32_t Texture::width() const
+    {
+        return m_width;
+    }
+
+    uint32_t Texture::height() const
+    {
+        return m_height;
+    }
+
+    std::array<float, 4> Texture::sample(float u, float v) const
+    {
+        if (m_texels.empty())
+        {
+            return { 0.0F, 0.0F, 0.0F, 1.0F };
+        }
+
+        const float x = u * static_cast<float>(m_width) - 0.5F;
+        const float y = v * static_cast<float>(m_height) - 0.5F;
+        const float floorX = std::floor(x);
+        const float floorY = std::floor(y);
+        const float fractionX = x - floorX;
+        const float fractionY = y - floorY;
+
+        const auto maxX = static_cast<int64_t>(m_width) - 1;
+        const auto maxY = static_cast<int64_t>(m_height) - 1;
+        const auto x0 = std::clamp(static_cast<int64_t>(floorX), int64_t { 0 }, maxX);
+        const auto y0 = std::clamp(static_cast<int64_t>(floorY), int64_t { 0 }, maxY);
+        const auto x1 = std::clamp(static_cast<int64_t>(floorX) + 1, int64_t { 0 }, maxX);
+        const auto y1 = std::clamp(static_cast<int64_t>(floorY) + 1, int64_t { 0 }, maxY);
+
+        const auto texel = [this](int64_t tx, int64_t ty) {
+            return &m_texels[(static_cast<size_t>(ty) * m_width + static_cast<size_t>(tx)) * 4];
+        };
+
+        const float* t00 = texel(x0, y0);
+        const float* t10 = texel(x1, y0);
+        const float* t01 = texel(x0, y1);
+        const float* t11 = texel(x1, y1);
+
+        std::array<float, 4> result {};
+        for (size_t i = 0; i < 4; i++)
+        {
+            const float top = t00[i] + (t10[i] - t00[i]) * fractionX;
+            const float bottom = t01[i] + (t11[i] - t01[i]) * fractionX;
+            result[i] = top + (bottom - top) * fractionY;
+        }
+        return result;
+    }
+
+    void Image::writePpm(const std::filesystem::path& path) const
+    {
+        std::ofstream stream(path, std::ios::binary);
+        if (!stream)
+        {
+            throw std::runtime_error(std::format("Failed to open {} for write", path.string()));
+        }
+
+        stream << std::format("P6\n{} {}\n255\n", width, height);
+        std::vector<uint8_t> rgb;
+        rgb.reserve(static_cast<size_t>(width) * height * 3);
+        for (size_t i = 0; i + 3 < pixels.size(); i += 4)
+        {
+            rgb.insert(rgb.end(), { pixels[i], pixels[i + 1], pixels[i + 2] });
+        }
+        stream.write(reinterpret_cast<const char*>(rgb.data()),
+            static_cast<std::streamsize>(rgb.size()));
+    }
+
+    ImageDifference compareImages(const Image& a, const Image& b)
+    {
+        if (a.width != b.width || a.height != b.height || a.pixels.size() != b.pixels.size())
+        {
+            throw std::invalid_argument("Images must have identical dimensions to be compared");
+        }
+
+        ImageDifference difference {};
+        double          sumSquares = 0.0;
+        for (size_t i = 0; i < a.pixels.size(); i += 4)
+        {
+            bool differs = false;
+            for (size_t channel = 0; channel < 4; channel++)
+            {
+                const int error = std::abs(static_cast<int>(a.pixels[i + channel])
+                    - static_cast<int>(b.pixels[i + channel]));
+                difference.maxChannelError
+                    = std::max(difference.maxChannelError, static_cast<uint32_t>(error));
+                sumSquares += static_cast<double>(error) * error;
+                differs |= error != 0;
+            }
+            difference.differingPixels += differs ? 1 : 0;
+        }
+
+        if (!a.pixels.empty())
+        {
+            difference.rootMeanSquareError
+                = std::sqrt(sumSquares / static_cast<double>(a.pixels.size()));
+        }
+        return difference;
+    }
+
+    Rasterizer::Rasterizer(ThreadPool& threadPool)
+        : m_threadPool(threadPool)
+    {
+    }
+
+    void Rasterizer::resize(uint32_t width, uint32_t height)
+    {
+        m_width = width;
+        m_height = height;
+        m_tilesX = (width + s_tileSize - 1) / s_tileSize;
+        m_tilesY = (height + s_tileSize - 1) / s_tileSize;
+
+        const size_t sampleCount = static_cast<size_t>(width) * height * s_sampleCount;
+        m_colorSamples.assign(sampleCount, m_clearColor);
+        m_depthSamples.assign(sampleCount, m_clearDepth);
+        m_chunkBins.clear();
+    }
+
+    uint32_t Rasterizer::width() const
+    {
+        return m_width;
+    }
+
+    uint32_t Rasterizer::height() const
+    {
+        return m_height;
+    }
+
+    void Rasterizer::clear(const std::array<float, 4>& color, float depth)
+    {
+        m_clearColor = color;
+        m_clearDepth = depth;
+        m_draws.clear();
+        m_statistics = {};
+        m_trianglesRasterized = 0;
+        m_fragmentsShaded = 0;
+    }
+
+    void Rasterizer::draw(const DrawCommand& command)
+    {
+        const size_t indexCount
+            = command.indices16.empty() ? command.indices32.size() : command.indices16.size();
+        if (indexCount < 3 || command.instanceTransforms.empty())
+        {
+            return;
+        }
+
+        m_draws.push_back(command);
+        m_statistics.drawCalls++;
+        m_statistics.trianglesSubmitted += (indexCount / 3) * command.instanceTransforms.size();
+    }
+
+    const Statistics& Rasterizer::statistics() const
+    {
+        return m_statistics;
+    }
+
+    void Rasterizer::resolve(Image& output)
+    {
+        output.width = m_width;
+        output.height = m_height;
+        output.pixels.resize(static_cast<size_t>(m_width) * m_height * 4);
+        m_output = &output;
+
+        executeDraws();
+
+        m_statistics.trianglesRasterized = m_trianglesRasterized.load();
+        m_statistics.fragmentsShaded = m_fragmentsShaded.load();
+        m_output = nullptr;
+    }
+
+    void Rasterizer::executeDraws()
+    {
+        // Prefix sum of triangles per draw so any triangle can be located from a flat index
+        m_drawTriangleOffsets.resize(m_draws.size() + 1);
+        m_drawTriangleOffsets[0] = 0;
+        for (size_t i = 0; i < m_draws.size(); i++)
+        {
+            const auto& draw = m_draws[i];
+            const size_t indexCount
+                = draw.indices16.empty() ? draw.indices32.size() : draw.indices16.size();
+            m_drawTriangleOffsets[i + 1] = m_drawTriangleOffsets[i]
+                + (indexCount / 3) * static_cast<uint64_t>(draw.instanceTransforms.size());
+        }
+
+        const uint64_t triangleCount = m_drawTriangleOffsets.back();
+        const size_t   tileCount = static_cast<size_t>(m_tilesX) * m_tilesY;
+        const size_t   targetChunks = static_cast<size_t>(m_threadPool.threadCount()) * 4;
+        m_chunkSize = std::max<size_t>(
+            g_minTrianglesPerChunk, (triangleCount + targetChunks - 1) / targetChunks);
+        const size_t chunkCount = (triangleCount + m_chunkSize - 1) / m_chunkSize;
+
+        // Bins are kept between frames so their capacity is reused.
+        if (m_chunkBins.size() < chunkCount)
+        {
+            m_chunkBins.resize(chunkCount);
+            m_chunkTriangles.resize(chunkCount);
+        }
+        for (size_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            m_chunkTriangles[chunk].clear();
+            m_chunkBins[chunk].resize(tileCount);
+            for (auto& bin : m_chunkBins[chunk])
+            {
+                bin.triangles.clear();
+            }
+        }
+        m_activeChunks = chunkCount;
+
+        m_threadPool.parallelFor(triangleCount, m_chunkSize,
+            [this](size_t begin, size_t end) { setupTriangles(begin, end, begin / m_chunkSize); });
+
+        m_threadPool.parallelFor(tileCount, 1, [this](size_t begin, size_t end) {
+            for (size_t tile = begin; tile < end; tile++)
+            {
+                rasterizeTile(static_cast<uint32_t>(tile % m_tilesX),
+                    static_cast<uint32_t>(tile / m_tilesX));
+            }
+        });
+    }
+
+    void Rasterizer::setupTriangles(size_t begin, size_t end, size_t chunk)
+    {
+        auto drawIterator
+            = std::upper_bound(m_drawTriangleOffsets.begin(), m_drawTriangleOffsets.end(), begin);
+        auto drawIndex = static_cast<uint32_t>(
+            std::distance(m_drawTriangleOffsets.begin(), drawIterator) - 1);
+
+        for (size_t triangle = begin; triangle < end; triangle++)
+        {
+            while (triangle >= m_drawTriangleOffsets[drawIndex + 1])
+            {
+                drawIndex++;
+            }
+
+            const DrawCommand& command = m_draws[drawIndex];
+            const size_t       indexCount = command.indices16.empty() ? command.indices32.size()
+                                                                      : command.indices16.size();
+            const size_t       primitiveCount = indexCount / 3;
+            const size_t       local = triangle - m_drawTriangleOffsets[drawIndex];
+            const size_t       instance = local / primitiveCount;
+            const size_t       primitive = local % primitiveCount;
+
+            const Matrix4&            matrix = command.instanceTransforms[instance];
+            std::array<ClipVertex, 3> clipVertices {};
+            bool                      validIndices = true;
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                const size_t index = command.indices16.empty()
+                    ? command.indices32[primitive * 3 + corner]
+                    : command.indices16[primitive * 3 + corner];
+                if (index >= command.vertices.size())
+                {
+                    validIndices = false;
+                    break;
+                }
+
+                const Vertex& vertex = command.vertices[index];
+                clipVertices[corner].position = transform(vertex.position, matrix);
+                clipVertices[corner].color = vertex.color;
+                clipVertices[corner].texCoord = vertex.texCoord;
+            }
+            if (!validIndices)
+            {
+                continue;
+            }
+
+            const Texture* texture = command.textures.empty()
+                ? nullptr
+                : command.textures[instance % command.textures.size()];
+
+            // Clip against the near (z >= 0) and far (z <= w) planes of Metal's clip
+            // space. X and Y are handled by the screen space bounding box.
+            std::array<ClipVertex, 9> polygon {};
+            std::array<ClipVertex, 9> scratch {};
+            size_t                    count = 3;
+            std::copy(clipVertices.begin(), clipVertices.end(), polygon.begin());
+
+            for (int plane = 0; plane < 2 && count >= 3; plane++)
+            {
+                const auto distance = [plane](const ClipVertex& v) {
+                    return plane == 0 ? v.position[2] : v.position[3] - v.position[2];
+                };
+
+                size_t outCount = 0;
+                for (size_t i = 0; i < count; i++)
+                {
+                    const ClipVertex& current = polygon[i];
+                    const ClipVertex& next = polygon[(i + 1) % count];
+                    const float       currentDistance = distance(current);
+                    const float       nextDistance = distance(next);
+
+                    if (currentDistance >= 0.0F)
+                    {
+                        scratch[outCount++] = current;
+                    }
+                    if ((currentDistance >= 0.0F) != (nextDistance >= 0.0F))
+                    {
+                        const float t = currentDistance / (currentDistance - nextDistance);
+                        scratch[outCount++] = { lerp(current.position, next.position, t),
+                            lerp(current.color, next.color, t),
+                            lerp(current.texCoord, next.texCoord, t) };
+                    }
+                }
+                count = outCount;
+                std::swap(polygon, scratch);
+            }
+
+            for (size_t i = 1; i + 1 < count; i++)
+            {
+                emitTriangle({ polygon[0], polygon[i], polygon[i + 1] }, command, texture,
+                    drawIndex, chunk);
+            }
+        }
+    }
+
+    void Rasterizer::emitTriangle(std::array<ClipVertex, 3> vertices,
+        const DrawCommand&                                  command,
+        const Texture*                                      texture,
+        uint32_t                                            drawIndex,
+        size_t                                              chunk)
+    {
+        Triangle triangle {};
+        triangle.texture = texture;
+        triangle.drawIndex = drawIndex;
+
+        for (size_t i = 0; i < 3; i++)
+        {
+            const auto& position = vertices[i].position;
+            if (position[3] <= g_clipEpsilon)
+            {
+                return;
+            }
+
+            const float invW = 1.0F / position[3];
+            triangle.x[i] = (position[0] * invW * 0.5F + 0.5F) * static_cast<float>(m_width);
+            triangle.y[i] = (0.5F - position[1] * invW * 0.5F) * static_cast<float>(m_height);
+            triangle.z[i] = position[2] * invW;
+            triangle.invW[i] = invW;
+            for (size_t c = 0; c < 4; c++)
+            {
+                triangle.color[i][c] = vertices[i].color[c] * invW;
+            }
+            triangle.texCoord[i]
+                = { vertices[i].texCoord[0] * invW, vertices[i].texCoord[1] * invW };
+        }
+
+        const float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0])
+            - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+        if (area == 0.0F || !std::isfinite(area))
+        {
+            return;
+        }
+
+        // Screen space has y pointing down, so counter-clockwise triangles in clip space
+        // have negative area here.
+        const bool counterClockwise = area < 0.0F;
+        const bool frontFacing = counterClockwise == command.counterClockwiseFrontFace;
+        if ((command.cullMode == CullMode::Back && !frontFacing)
+            || (command.cullMode == CullMode::Front && frontFacing))
+        {
+            return;
+        }
+
+        if (area < 0.0F)
+        {
+            // Normalize winding so edge functions are positive inside
+            std::swap(triangle.x[1], triangle.x[2]);
+            std::swap(triangle.y[1], triangle.y[2]);
+            std::swap(triangle.z[1], triangle.z[2]);
+            std::swap(triangle.invW[1], triangle.invW[2]);
+            std::swap(triangle.color[1], triangle.color[2]);
+            std::swap(triangle.texCoord[1], triangle.texCoord[2]);
+        }
+
+        const float minX = std::min({ triangle.x[0], triangle.x[1], triangle.x[2] });
+        const float maxX = std::max({ triangle.x[0], triangle.x[1], triangle.x[2] });
+        const float minY = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] });
+        const float maxY = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] });
+        if (maxX < 0.0F || maxY < 0.0F || minX >= static_cast<float>(m_width)
+            || minY >= static_cast<float>(m_height))
+        {
+            return;
+        }
+
+        const auto clampTile = [](float value, uint32_t tiles) {
+            const auto tile = static_cast<int64_t>(value) / static_cast<int64_t>(s_tileSize);
+            return static_cast<uint32_t>(std::clamp<int64_t>(tile, 0, tiles - 1));
+        };
+        const uint32_t tileMinX = clampTile(std::max(minX, 0.0F), m_tilesX);
+        const uint32_t tileMaxX = clampTile(maxX, m_tilesX);
+        const uint32_t tileMinY = clampTile(std::max(minY, 0.0F), m_tilesY);
+        const uint32_t tileMaxY = clampTile(maxY, m_tilesY);
+
+        auto&      triangles = m_chunkTriangles[chunk];
+        const auto triangleIndex = static_cast<uint32_t>(triangles.size());
+        triangles.push_back(triangle);
+        m_trianglesRasterized.fetch_add(1, std::memory_order_relaxed);
+
+        auto& bins = m_chunkBins[chunk];
+        for (uint32_t tileY = tileMinY; tileY <= tileMaxY; tileY++)
+        {
+            for (uint32_t tileX = tileMinX; tileX <= tileMaxX; tileX++)
+            {
+                bins[static_cast<size_t>(tileY) * m_tilesX + tileX].triangles.push_back(
+                    triangleIndex);
+            }
+        }
+    }
+
+    void Rasterizer::rasterizeTile(uint32_t tileX, uint32_t tileY)
+    {
+        const uint32_t minX = tileX * s_tileSize;
+        const uint32_t minY = tileY * s_tileSize;
+        const uint32_t maxX = std::min(minX + s_tileSize, m_width);
+        const uint32_t maxY = std::min(minY + s_tileSize, m_height);
+
+        // Clear the tile's samples; the tile stays hot in cache for raster and resolve.
+        for (uint32_t y = minY; y < maxY; y++)
+        {
+            const size_t rowStart = (static_cast<size_t>(y) * m_width + minX) * s_sampleCount;
+            const size_t rowEnd = (static_cast<size_t>(y) * m_width + maxX) * s_sampleCount;
+            std::fill(m_colorSamples.begin() + static_cast<ptrdiff_t>(rowStart),
+                m_colorSamples.begin() + static_cast<ptrdiff_t>(rowEnd), m_clearColor);
+            std::fill(m_depthSamples.begin() + static_cast<ptrdiff_t>(rowStart),
+                m_depthSamples.begin() + static_cast<ptrdiff_t>(rowEnd), m_clearDepth);
+        }
+
+        uint64_t     fragments = 0;
+        const size_t tileIndex = static_cast<size_t>(tileY) * m_tilesX + tileX;
+        for (size_t chunk = 0; chunk < m_activeChunks; chunk++)
+        {
+            const auto& triangles = m_chunkTriangles[chunk];
+            for (const uint32_t triangleIndex : m_chunkBins[chunk][tileIndex].triangles)
+            {
+                const Triangle& triangle = triangles[triangleIndex];
+                rasterizeTriangle(
+                    triangle, m_draws[triangle.drawIndex], minX, minY, maxX, maxY, fragments);
+            }
+        }
+        m_fragmentsShaded.fetch_add(fragments, std::memory_order_relaxed);
+
+        // Resolve: box filter the samples in linear space then encode to sRGB
+        for (uint32_t y = minY; y < maxY; y++)
+        {
+            for (uint32_t x = minX; x < maxX; x++)
+            {
+                const size_t pixel = static_cast<size_t>(y) * m_width + x;
+                const auto*  samples = &m_colorSamples[pixel * s_sampleCount];
+
+                std::array<float, 4> sum {};
+                for (uint32_t s = 0; s < s_sampleCount; s++)
+                {
+                    for (size_t c = 0; c < 4; c++)
+                    {
+                        sum[c] += samples[s][c];
+                    }
+                }
+
+                constexpr float scale = 1.0F / static_cast<float>(s_sampleCount);
+                uint8_t*        out = &m_output->pixels[pixel * 4];
+                out[0] = encodeSrgb(sum[0] * scale);
+                out[1] = encodeSrgb(sum[1] * scale);
+                out[2] = encodeSrgb(sum[2] * scale);
+                out[3] = encodeUnorm(sum[3] * scale);
+            }
+        }
+    }
+
+    void Rasterizer::rasterizeTriangle(const Triangle& triangle,
+        const DrawCommand&                             command,
+        uint32_t                                       minX,
+        uint32_t                                       minY,
+        uint32_t                                       maxX,
+        uint32_t                                       maxY,
+        uint64_t&                                      fragments)
+    {
+        const auto& x = triangle.x;
+        const auto& y = triangle.y;
+
+        // Clip the triangle bounds to the tile
+        const auto toPixel = [](float value) {
+            return static_cast<uint32_t>(std::max(value, 0.0F));
+        };
+        const uint32_t startX = std::max(minX, toPixel(std::floor(std::min({ x[0], x[1], x[2] }))));
+        const uint32_t startY = std::max(minY, toPixel(std::floor(std::min({ y[0], y[1], y[2] }))));
+        const uint32_t endX
+            = std::min(maxX, toPixel(std::ceil(std::max({ x[0], x[1], x[2] }))) + 1);
+        const uint32_t endY
+            = std::min(maxY, toPixel(std::ceil(std::max({ y[0], y[1], y[2] }))) + 1);
+        if (startX >= endX || startY >= endY)
+        {
+            return;
+        }
+
+        // Edge i is opposite vertex i: e(p) = a * px + b * py + c
+        struct Edge
+        {
+            float a;
+            float b;
+            float c;
+            bool  topLeft;
+        };
+        std::array<Edge, 3> edges {};
+        for (size_t i = 0; i < 3; i++)
+        {
+            const size_t from = (i + 1) % 3;
+            const size_t to = (i + 2) % 3;
+            const float  dx = x[to] - x[from];
+            const float  dy = y[to] - y[from];
+            edges[i] = { -dy, dx, dy * x[from] - dx * y[from], isTopLeft(dx, dy) };
+        }
+
+        const float area = edges[0].a * x[0] + edges[0].b * y[0] + edges[0].c;
+        const float invArea = 1.0F / area;
+
+        const auto inside = [](const Edge& edge, float value) {
+            return value > 0.0F || (value == 0.0F && edge.topLeft);
+        };
+
+        // Edge values at each sample relative to the pixel origin, plus the largest of
+        // them so pixels outside an edge can be rejected before per-sample tests.
+        std::array<std::array<float, s_sampleCount>, 3> sampleOffsets {};
+        std::array<float, 3>                            maxOffsets {};
+        for (size_t i = 0; i < 3; i++)
+        {
+            maxOffsets[i] = -std::numeric_limits<float>::max();
+            for (uint32_t s = 0; s < s_sampleCount; s++)
+            {
+                sampleOffsets[i][s]
+                    = edges[i].a * g_samplePositions[s][0] + edges[i].b * g_samplePositions[s][1];
+                maxOffsets[i] = std::max(maxOffsets[i], sampleOffsets[i][s]);
+            }
+        }
+
+        for (uint32_t py = startY; py < endY; py++)
+        {
+            const float          fy = static_cast<float>(py);
+            std::array<float, 3> edgeValues {};
+            for (size_t i = 0; i < 3; i++)
+            {
+                edgeValues[i]
+                    = edges[i].a * static_cast<float>(startX) + edges[i].b * fy + edges[i].c;
+            }
+
+            for (uint32_t px = startX; px < endX; px++, edgeValues[0] += edges[0].a,
+                          edgeValues[1] += edges[1].a, edgeValues[2] += edges[2].a)
+            {
+                if (edgeValues[0] + maxOffsets[0] < 0.0F || edgeValues[1] + maxOffsets[1] < 0.0F
+                    || edgeValues[2] + maxOffsets[2] < 0.0F)
+                {
+                    continue;
+                }
+
+                const float  fx = static_cast<float>(px);
+                const size_t pixel = static_cast<size_t>(py) * m_width + px;
+
+                uint32_t coverage = 0;
+                for (uint32_t s = 0; s < s_sampleCount; s++)
+                {
+                    const float e0 = edgeValues[0] + sampleOffsets[0][s];
+                    const float e1 = edgeValues[1] + sampleOffsets[1][s];
+                    const float e2 = edgeValues[2] + sampleOffsets[2][s];
+                    if (!inside(edges[0], e0) || !inside(edges[1], e1) || !inside(edges[2], e2))
+                    {
+                        continue;
+                    }
+
+                    if (command.depthTestEnabled)
+                    {
+                        const float depth = (e0 * triangle.z[0] + e1 * triangle.z[1]
+                                                + e2 * triangle.z[2])
+                            * invArea;
+                        float& stored = m_depthSamples[pixel * s_sampleCount + s];
+                        if (!(depth < stored))
+                        {
+                            continue;
+                        }
+                        if (command.depthWriteEnabled)
+                        {
+                            stored = depth;
+                        }
+                    }
+                    coverage |= 1U << s;
+                }
+
+                if (coverage == 0)
+                {
+                    continue;
+                }
+
+                // Shade once per pixel at its center, as multisampling does
+                const float cx = fx + 0.5F;
+                const float cy = fy + 0.5F;
+                const float b0 = (edges[0].a * cx + edges[0].b * cy + edges[0].c) * invArea;
+                const float b1 = (edges[1].a * cx + edges[1].b * cy + edges[1].c) * invArea;
+                const float b2 = 1.0F - b0 - b1;
+                const float w = 1.0F / (b0 * triangle.invW[0] + b1 * triangle.invW[1]
+                                    + b2 * triangle.invW[2]);
+
+                std::array<float, 4> color {};
+                if (triangle.texture != nullptr)
+                {
+                    const float u = (b0 * triangle.texCoord[0][0] + b1 * triangle.texCoord[1][0]
+                                        + b2 * triangle.texCoord[2][0])
+                        * w;
+                    const float v = (b0 * triangle.texCoord[0][1] + b1 * triangle.texCoord[1][1]
+                                        + b2 * triangle.texCoord[2][1])
+                        * w;
+                    color = triangle.texture->sample(u, v);
+                }
+                else
+                {
+                    for (size_t c = 0; c < 4; c++)
+                    {
+                        color[c] = (b0 * triangle.color[0][c] + b1 * triangle.color[1][c]
+                                       + b2 * triangle.color[2][c])
+                            * w;
+                    }
+                }
+                fragments++;
+
+                for (uint32_t s = 0; s < s_sampleCount; s++)
+                {
+                    if ((coverage & (1U << s)) == 0)
+                    {
+                        continue;
+                    }
+
+                    auto& destination = m_colorSamples[pixel * s_sampleCount + s];
+                    if (command.blendEnabled)
+                    {
+                        // SourceAlpha / OneMinusSourceAlpha for both color and alpha
+                        const float alpha = color[3];
+                        for (size_t c = 0; c < 4; c++)
+                        {
+                            destination[c] = color[c] * alpha + destination[c] * (1.0F - alpha);
+                        }
+                    }
+                    else
+                    {
+                        destination = color;
+                    }
+                }
+            }
+        }
+    }
+} // namespace Raster
@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+namespace Raster
+{
+    /// @brief Row-major 4x4 matrix using the row-vector convention of DirectXMath,
+    /// so a SimpleMath::Matrix can be copied in directly.
+    using Matrix4 = std::array<float, 16>;
+
+    /// @brief Superset of the vertex layouts used by the examples.
+    struct Vertex
+    {
+        std::array<float, 4> position {};
+        std::array<float, 4> color { 1.0F, 1.0F, 1.0F, 1.0F };
+        std::array<float, 2> texCoord {};
+    };
+
+    /// @brief Texture holding linear RGBA float texels.
+    class Texture
+    {
+    public:
+        Texture() = default;
+
+        /// @brief Creates a texture from tightly packed RGBA8 texels.
+        /// @param [in] rgba Texel data, width * height * 4 bytes.
+        /// @param [in] srgb Whether the data is sRGB encoded (e.g. RGBA8Unorm_sRGB).
+        Texture(std::span<const uint8_t> rgba, uint32_t width, uint32_t height, bool srgb);
+
+        [[nodiscard]] uint32_t width() const;
+
+        [[nodiscard]] uint32_t height() const;
+
+        /// @brief Bilinear sample with clamp-to-edge addressing, matching the
+        /// linear sampler used by shaders/textures/shader.metal.
+        [[nodiscard]] std::array<float, 4> sample(float u, float v) const;
+
+    private:
+        uint32_t           m_width = 0;
+        uint32_t           m_height = 0;
+        std::vector<float> m_texels;
+    };
+
+    enum class CullMode
+    {
+        None,
+        Front,
+        Back,
+    };
+
+    /// @brief An instanced, indexed triangle list draw.
+    ///
+    /// Each instance transforms positions by its matrix (object to clip space). When
+    /// textures are bound, instance i samples textures[i % size] like the textures
+    /// example; otherwise the interpolated vertex color is output.
+    struct DrawCommand
+    {
+        std::span<const Vertex>         vertices {};
+        std::span<const uint16_t>       indices16 {};
+        std::span<const uint32_t>       indices32 {};
+        std::span<const Matrix4>        instanceTransforms {};
+        std::span<const Texture* const> textures {};
+        CullMode                        cullMode = CullMode::None;
+        bool                            counterClockwiseFrontFace = true;
+        bool                            blendEnabled = false;
+        bool                            depthTestEnabled = true;
+        bool                            depthWriteEnabled = true;
+    };
+
+    /// @brief RGBA8 image with sRGB encoded color.
+    struct Image
+    {
+        uint32_t             width = 0;
+        uint32_t             height = 0;
+        std::vector<uint8_t> pixels;
+
+        /// @brief Writes the image as a binary PPM (alpha is dropped).
+        void writePpm(const std::filesystem::path& path) const;
+    };
+
+    struct ImageDifference
+    {
+        uint32_t maxChannelError = 0;
+        double   rootMeanSquareError = 0.0;
+        uint64_t differingPixels = 0;
+    };
+
+    /// @brief Compares two equally sized images for golden-image checks.
+    [[nodiscard]] ImageDifference compareImages(const Image& a, const Image& b);
+
+    struct Statistics
+    {
+        uint64_t drawCalls = 0;
+        uint64_t trianglesSubmitted = 0;
+        uint64_t trianglesRasterized = 0; ///< Surviving clipping and culling.
+        uint64_t fragmentsShaded = 0;
+    };
+
+    /// @brief Multithreaded, tile based rasterizer with 4x MSAA and depth testing.
+    ///
+    /// Draws are recorded between clear and resolve. Execution happens in resolve:
+    /// vertex transform and triangle setup are parallel over triangle ranges that bin
+    /// into screen tiles, then tiles are rasterized and resolved in parallel. Each
+    /// tile replays its triangles in submission order, so blending is deterministic.
+    class Rasterizer
+    {
+    public:
+        static constexpr uint32_t s_sampleCount = 4;
+        static constexpr uint32_t s_tileSize = 64;
+
+        /// @param [in] threadPool Pool used for binning and tile work.
+        explicit Rasterizer(ThreadPool& threadPool);
+
+        /// @brief Resizes the multisampled color and depth targets.
+        void resize(uint32_t width, uint32_t height);
+
+        [[nodiscard]] uint32_t width() const;
+
+        [[nodiscard]] uint32_t height() const;
+
+        /// @brief Begins a frame, clearing color and depth.
+        void clear(const std::array<float, 4>& color, float depth = 1.0F);
+
+        /// @brief Records a draw. Referenced data must stay valid until resolve.
+        void draw(const DrawCommand& command);
+
+        /// @brief Executes recorded draws and resolves the samples into an sRGB image.
+        void resolve(Image& output);
+
+        [[nodiscard]] const Statistics& statistics() const;
+
+    private:
+        struct ClipVertex
+        {
+            std::array<float, 4> position;
+            std::array<float, 4> color;
+            std::array<float, 2> texCoord;
+        };
+
+        struct Triangle
+        {
+            // Screen space positions and 1/w
+            std::array<float, 3> x;
+            std::array<float, 3> y;
+            std::array<float, 3> z;
+            std::array<float, 3> invW;
+            // Attributes pre-divided by w for perspective correct interpolation
+            std::array<std::array<float, 4>, 3> color;
+            std::array<std::array<float, 2>, 3> texCoord;
+            const Texture*                      texture;
+            uint32_t                            drawIndex;
+        };
+
+        struct Bin
+        {
+            std::vector<uint32_t> triangles;
+        };
+
+        void executeDraws();
+
+        void setupTriangles(size_t begin, size_t end, size_t chunk);
+
+        void emitTriangle(std::array<ClipVertex, 3> vertices,
+            const DrawCommand&                      command,
+            const Texture*                          texture,
+            uint32_t                                drawIndex,
+            size_t                                  chunk);
+
+        void rasterizeTile(uint32_t tileX, uint32_t tileY);
+
+        void rasterizeTriangle(const Triangle& triangle,
+            const DrawCommand&                 command,
+            uint32_t                           minX,
+            uint32_t                           minY,
+            uint32_t                           maxX,
+            uint32_t                           maxY,
+            uint64_t&                          fragments);
+
+        ThreadPool&                       m_threadPool;
+        uint32_t                          m_width = 0;
+        uint32_t                          m_height = 0;
+        uint32_t                          m_tilesX = 0;
+        uint32_t                          m_tilesY = 0;
+        std::array<float, 4>              m_clearColor {};
+        float                             m_clearDepth = 1.0F;
+        std::vector<std::array<float, 4>> m_colorSamples;
+        std::vector<float>                m_depthSamples;
+
+        // Recorded work. Triangles are addressed as (draw, instance, primitive) through
+        // a flat prefix sum so binning can be split into even ranges.
+        std::vector<DrawCommand>           m_draws;
+        std::vector<uint64_t>              m_drawTriangleOffsets;
+        std::vector<std::vector<Triangle>> m_chunkTriangles;
+        std::vector<std::vector<Bin>>      m_chunkBins;
+        size_t                             m_chunkSize = 0;
+        size_t                             m_activeChunks = 0;
+        Image*                             m_output = nullptr;
+
+        Statistics            m_statistics {};
+        std::atomic<uint64_t> m_trianglesRasterized = 0;
+        std::atomic<uint64_t> m_fragmentsShaded = 0;
+    };
+} // namespace Raster
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    // The calling thread takes part in parallel loops, so spawn one fewer worker.
+    m_workers.reserve(threadCount - 1);
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        m_workers.emplace_back([this] { workerMain(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+uint32_t ThreadPool::threadCount() const
+{
+    return static_cast<uint32_t>(m_workers.size()) + 1;
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+    m_waiterCondition.notify_all();
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+bool ThreadPool::runPendingTask()
+{
+    std::function<void()> task;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_tasks.empty())
+        {
+            return false;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::waitUntil(const std::function<bool()>& predicate)
+{
+    while (!predicate())
+    {
+        if (runPendingTask())
+        {
+            continue;
+        }
+
+        std::unique_lock lock(m_mutex);
+        m_waiterCondition.wait(lock, [&] { return predicate() || !m_tasks.empty(); });
+    }
+}
+
+void ThreadPool::notifyWaiters()
+{
+    // Taking the lock orders the notification after a waiter's predicate check, so
+    // a change made just before it cannot be missed.
+    {
+        std::lock_guard lock(m_mutex);
+    }
+    m_waiterCondition.notify_all();
+}
+
+void ThreadPool::workerMain()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+            if (m_stopping && m_tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief Fixed size pool of worker threads with a shared FIFO task queue.
+class ThreadPool
+{
+public:
+    /// @brief Constructor
+    /// @param [in] threadCount Total threads taking part in parallel loops, including
+    /// the calling thread. Zero selects the hardware concurrency.
+    explicit ThreadPool(uint32_t threadCount = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// @brief Number of threads that execute parallel loops (workers plus caller).
+    [[nodiscard]] uint32_t threadCount() const;
+
+    /// @brief Queues a task for execution on a worker thread.
+    void submit(std::function<void()> task);
+
+    /// @brief Splits [0, count) into chunks of grainSize and runs them in parallel.
+    ///
+    /// The calling thread participates and the call returns once every chunk is done.
+    /// Chunks are contiguous so callers may derive a stable chunk index from begin.
+    /// If a chunk throws, no further chunks are started and the first exception is
+    /// rethrown on the calling thread once the chunks already running have returned.
+    /// @param [in] count Number of items.
+    /// @param [in] grainSize Items per chunk.
+    /// @param [in] function Callable invoked as function(begin, end).
+    template <typename TFunction>
+    void parallelFor(size_t count, size_t grainSize, const TFunction& function)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        grainSize = std::max<size_t>(grainSize, 1);
+        const size_t chunkCount = (count + grainSize - 1) / grainSize;
+        if (chunkCount == 1 || m_workers.empty())
+        {
+            for (size_t begin = 0; begin < count; begin += grainSize)
+            {
+                function(begin, std::min(begin + grainSize, count));
+            }
+            return;
+        }
+
+        std::atomic<size_t> nextChunk = 0;
+        std::atomic_flag    failed;
+        std::exception_ptr  exception;
+        const auto          runChunks = [&] {
+            for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+            {
+                const size_t begin = chunk * grainSize;
+                try
+                {
+                    function(begin, std::min(begin + grainSize, count));
+                }
+                catch (...)
+                {
+                    if (!failed.test_and_set())
+                    {
+                        exception = std::current_exception();
+                    }
+                    nextChunk = chunkCount;
+                }
+            }
+        };
+
+        const size_t        helperCount = std::min(chunkCount - 1, m_workers.size());
+        std::atomic<size_t> pendingHelpers = helperCount;
+        for (size_t i = 0; i < helperCount; i++)
+        {
+            submit([&] {
+                runChunks();
+                // The caller may return as soon as the count drops, so nothing on its
+                // stack may be touched afterwards.
+                pendingHelpers.fetch_sub(1, std::memory_order_release);
+                notifyWaiters();
+            });
+        }
+
+        runChunks();
+        waitUntil([&] { return pendingHelpers.load(std::memory_order_acquire) == 0; });
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    /// @brief Returns a process wide pool sized to the hardware concurrency.
+    [[nodiscard]] static ThreadPool& shared();
+
+private:
+    /// Runs queued tasks on the calling thread until the predicate holds, so nested
+    /// parallel loops issued from workers cannot starve the pool. Sleeps while there
+    /// is nothing to run.
+    void waitUntil(const std::function<bool()>& predicate);
+
+    /// Wakes threads in waitUntil to recheck their predicate.
+    void notifyWaiters();
+
+    bool runPendingTask();
+
+    void workerMain();
+
+    std::vector<std::thread>          m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex                        m_mutex;
+    std::condition_variable           m_condition;
+    std::condition_variable           m_waiterCondition; ///< Task queued or helper done.
+    bool                              m_stopping = false;
+};
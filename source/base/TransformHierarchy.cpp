@@ -0,0 +1,487 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "TransformHierarchy.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <stdexcept>
+
+#include "ThreadPool.hpp"
+
+namespace
+{
+    /// Nodes composed together; the gathered local transforms stay in L1.
+    constexpr size_t g_batchSize = 64;
+
+    /// Fewer changed nodes than this at one depth are not worth splitting across
+    /// threads.
+    constexpr size_t g_parallelGrain = 8192;
+
+    constexpr Assets::Matrix4 g_identity { 1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F, 0.0F, 0.0F,
+        0.0F, 1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F };
+
+    float& component(std::array<std::vector<float>, Animation::g_poseComponentCount>& locals,
+        Animation::PoseComponent component, uint32_t slot)
+    {
+        return locals[static_cast<size_t>(component)][slot];
+    }
+
+    /// Sets the bits [begin, end), a word at a time.
+    void setBits(std::vector<uint64_t>& bits, const uint32_t begin, const uint32_t end)
+    {
+        if (begin >= end)
+        {
+            return;
+        }
+        const uint32_t first = begin / 64;
+        const uint32_t last = (end - 1) / 64;
+        const uint64_t firstMask = ~0ULL << (begin % 64);
+        const uint64_t lastMask = ~0ULL >> (63 - (end - 1) % 64);
+        if (first == last)
+        {
+            bits[first] |= firstMask & lastMask;
+            return;
+        }
+        bits[first] |= firstMask;
+        std::fill(bits.begin() + first + 1, bits.begin() + last, ~0ULL);
+        bits[last] |= lastMask;
+    }
+
+    /// Appends the set bits in [begin, end) to slots in increasing order and clears
+    /// them.
+    void takeBits(std::vector<uint64_t>& bits, const uint32_t begin, const uint32_t end,
+        std::vector<uint32_t>& slots)
+    {
+        for (uint32_t word = begin / 64; word * 64 < end; word++)
+        {
+            uint64_t mask = ~0ULL;
+            if (word == begin / 64)
+            {
+                mask &= ~0ULL << (begin % 64);
+            }
+            if ((word + 1) * 64 > end)
+            {
+                mask &= ~0ULL >> (64 - end % 64);
+            }
+
+            uint64_t value = bits[word] & mask;
+            bits[word] &= ~mask;
+            while (value != 0)
+            {
+                slots.push_back(word * 64 + static_cast<uint32_t>(std::countr_zero(value)));
+                value &= value - 1;
+            }
+        }
+    }
+
+    /// Moves the values of live slots to their new slots, dropping the others.
+    template <typename T>
+    void permute(std::vector<T>& values, const std::vector<uint32_t>& newSlots, size_t liveCount)
+    {
+        std::vector<T> result(liveCount);
+        for (size_t slot = 0; slot < newSlots.size(); slot++)
+        {
+            if (newSlots[slot] < liveCount)
+            {
+                result[newSlots[slot]] = values[slot];
+            }
+        }
+        values = std::move(result);
+    }
+} // namespace
+
+TransformHierarchy::NodeId TransformHierarchy::create(
+    const NodeId parent, const Animation::Transform& local)
+{
+    const uint32_t parentSlot = parent == s_invalidNode ? s_noSlot : liveSlot(parent);
+
+    NodeId node = 0;
+    if (m_freeIds.empty())
+    {
+        node = static_cast<NodeId>(m_slots.size());
+        m_slots.push_back(s_noSlot);
+        m_parentIds.push_back(s_invalidNode);
+    }
+    else
+    {
+        node = m_freeIds.back();
+        m_freeIds.pop_back();
+    }
+
+    const auto slot = static_cast<uint32_t>(m_nodes.size());
+    m_slots[node] = slot;
+    m_parentIds[node] = parent;
+    m_nodes.push_back(node);
+    m_parents.push_back(parentSlot);
+    for (auto& values : m_locals)
+    {
+        values.push_back(0.0F);
+    }
+    m_dirty.resize(m_nodes.size() / 64 + 1);
+    m_world.push_back(g_identity);
+    m_structureChanged = true;
+    setLocal(node, local);
+    return node;
+}
+
+void TransformHierarchy::destroy(const NodeId node)
+{
+    requireAlive(node);
+    m_slots[node] = s_noSlot;
+    m_destroyedIds.push_back(node);
+    m_structureChanged = true;
+}
+
+void TransformHierarchy::setParent(const NodeId node, const NodeId parent)
+{
+    const uint32_t slot = liveSlot(node);
+    if (parent != s_invalidNode)
+    {
+        requireAlive(parent);
+        for (NodeId ancestor = parent; ancestor != s_invalidNode;
+            ancestor = m_parentIds[ancestor])
+        {
+            if (ancestor == node)
+            {
+                throw std::runtime_error(std::format(
+                    "Transform node {} cannot be parented under itself or a descendant", node));
+            }
+        }
+    }
+    m_parentIds[node] = parent;
+    m_structureChanged = true;
+    markDirty(slot);
+}
+
+void TransformHierarchy::setLocal(const NodeId node, const Animation::Transform& local)
+{
+    using enum Animation::PoseComponent;
+    const uint32_t slot = liveSlot(node);
+    component(m_locals, TranslationX, slot) = local.translation[0];
+    component(m_locals, TranslationY, slot) = local.translation[1];
+    component(m_locals, TranslationZ, slot) = local.translation[2];
+    component(m_locals, RotationX, slot) = local.rotation[0];
+    component(m_locals, RotationY, slot) = local.rotation[1];
+    component(m_locals, RotationZ, slot) = local.rotation[2];
+    component(m_locals, RotationW, slot) = local.rotation[3];
+    component(m_locals, ScaleX, slot) = local.scale[0];
+    component(m_locals, ScaleY, slot) = local.scale[1];
+    component(m_locals, ScaleZ, slot) = local.scale[2];
+    markDirty(slot);
+}
+
+Animation::Transform TransformHierarchy::local(const NodeId node) const
+{
+    const uint32_t slot = liveSlot(node);
+    const auto     value = [&](const Animation::PoseComponent component) {
+        return m_locals[static_cast<size_t>(component)][slot];
+    };
+
+    using enum Animation::PoseComponent;
+    return { .translation = { value(TranslationX), value(TranslationY), value(TranslationZ) },
+        .rotation = { value(RotationX), value(RotationY), value(RotationZ), value(RotationW) },
+        .scale = { value(ScaleX), value(ScaleY), value(ScaleZ) } };
+}
+
+TransformHierarchy::NodeId TransformHierarchy::parent(const NodeId node) const
+{
+    requireAlive(node);
+    return m_parentIds[node];
+}
+
+bool TransformHierarchy::isAlive(const NodeId node) const
+{
+    return node < m_slots.size() && m_slots[node] != s_noSlot;
+}
+
+size_t TransformHierarchy::nodeCount() const
+{
+    return m_slots.size() - m_freeIds.size() - m_destroyedIds.size();
+}
+
+size_t TransformHierarchy::update()
+{
+    return updateDepths(nullptr);
+}
+
+size_t TransformHierarchy::update(ThreadPool& threadPool)
+{
+    return updateDepths(&threadPool);
+}
+
+const Assets::Matrix4& TransformHierarchy::world(const NodeId node) const
+{
+    return m_world[liveSlot(node)];
+}
+
+uint32_t TransformHierarchy::slot(const NodeId node) const
+{
+    return liveSlot(node);
+}
+
+std::span<const Assets::Matrix4> TransformHierarchy::worldMatrices() const
+{
+    return m_world;
+}
+
+std::span<const uint32_t> TransformHierarchy::updatedSlots() const
+{
+    return m_updatedSlots;
+}
+
+void TransformHierarchy::requireAlive(const NodeId node) const
+{
+    if (!isAlive(node))
+    {
+        throw std::runtime_error(std::format("Transform node {} does not exist", node));
+    }
+}
+
+uint32_t TransformHierarchy::liveSlot(const NodeId node) const
+{
+    requireAlive(node);
+    return m_slots[node];
+}
+
+void TransformHierarchy::markDirty(const uint32_t slot)
+{
+    m_dirty[slot / 64] |= 1ULL << (slot % 64);
+}
+
+void TransformHierarchy::rebuild()
+{
+    const size_t slotCount = m_nodes.size();
+    const size_t idCount = m_slots.size();
+    const auto   isLive = [this](const uint32_t slot) { return m_slots[m_nodes[slot]] == slot; };
+
+    // Children of every node in their previous slot order, so a breadth first walk
+    // from the roots keeps siblings in order. Descendants of destroyed nodes are
+    // never reached
+    std::vector<uint32_t> childOffsets(idCount + 1, 0);
+    for (uint32_t slot = 0; slot < slotCount; slot++)
+    {
+        const NodeId parent = m_parentIds[m_nodes[slot]];
+        if (isLive(slot) && parent != s_invalidNode)
+        {
+            childOffsets[parent + 1]++;
+        }
+    }
+    for (size_t id = 0; id < idCount; id++)
+    {
+        childOffsets[id + 1] += childOffsets[id];
+    }
+
+    std::vector<NodeId>   children(childOffsets.back());
+    std::vector<uint32_t> nextChild(childOffsets.begin(), childOffsets.end() - 1);
+    std::vector<NodeId>   order;
+    order.reserve(slotCount);
+    for (uint32_t slot = 0; slot < slotCount; slot++)
+    {
+        const NodeId node = m_nodes[slot];
+        const NodeId parent = m_parentIds[node];
+        if (!isLive(slot))
+        {
+            continue;
+        }
+        if (parent == s_invalidNode)
+        {
+            order.push_back(node);
+        }
+        else
+        {
+            children[nextChild[parent]++] = node;
+        }
+    }
+
+    std::vector<uint32_t> depthStarts { 0 };
+    std::vector<uint32_t> childStarts;
+    childStarts.reserve(slotCount + 1);
+    while (depthStarts.back() < order.size())
+    {
+        const auto depthEnd = static_cast<uint32_t>(order.size());
+        for (uint32_t i = depthStarts.back(); i < depthEnd; i++)
+        {
+            const NodeId node = order[i];
+            childStarts.push_back(static_cast<uint32_t>(order.size()));
+            order.insert(order.end(), children.begin() + childOffsets[node],
+                children.begin() + childOffsets[node + 1]);
+        }
+        depthStarts.push_back(depthEnd);
+    }
+    childStarts.push_back(static_cast<uint32_t>(order.size()));
+
+    std::vector<uint32_t> newSlots(slotCount, s_noSlot);
+    for (uint32_t slot = 0; slot < order.size(); slot++)
+    {
+        newSlots[m_slots[order[slot]]] = slot;
+    }
+    for (uint32_t slot = 0; slot < slotCount; slot++)
+    {
+        if (isLive(slot) && newSlots[slot] == s_noSlot)
+        {
+            m_slots[m_nodes[slot]] = s_noSlot;
+            m_freeIds.push_back(m_nodes[slot]);
+        }
+    }
+    m_freeIds.insert(m_freeIds.end(), m_destroyedIds.begin(), m_destroyedIds.end());
+    m_destroyedIds.clear();
+
+    const size_t          liveCount = order.size();
+    std::vector<uint64_t> dirty(liveCount / 64 + 1, 0);
+    for (uint32_t slot = 0; slot < slotCount; slot++)
+    {
+        if (newSlots[slot] != s_noSlot && (m_dirty[slot / 64] >> (slot % 64) & 1) != 0)
+        {
+            dirty[newSlots[slot] / 64] |= 1ULL << (newSlots[slot] % 64);
+        }
+    }
+    m_dirty = std::move(dirty);
+    for (auto& values : m_locals)
+    {
+        permute(values, newSlots, liveCount);
+    }
+    permute(m_world, newSlots, liveCount);
+
+    m_nodes = std::move(order);
+    m_parents.resize(liveCount);
+    for (uint32_t slot = 0; slot < liveCount; slot++)
+    {
+        m_slots[m_nodes[slot]] = slot;
+    }
+    for (uint32_t slot = 0; slot < liveCount; slot++)
+    {
+        const NodeId parent = m_parentIds[m_nodes[slot]];
+        m_parents[slot] = parent == s_invalidNode ? s_noSlot : m_slots[parent];
+    }
+    m_childStarts = std::move(childStarts);
+    m_depthStarts = std::move(depthStarts);
+}
+
+template <bool TRoots>
+void TransformHierarchy::composeBatch(const uint32_t* slots, const size_t count)
+{
+    using enum Animation::PoseComponent;
+    using Lanes = std::array<float, g_batchSize>;
+
+    std::array<Lanes, Animation::g_poseComponentCount> trs;
+    for (size_t component = 0; component < trs.size(); component++)
+    {
+        const float* values = m_locals[component].data();
+        for (size_t i = 0; i < count; i++)
+        {
+            trs[component][i] = values[slots[i]];
+        }
+    }
+
+    // Rotated and scaled basis vectors of every node, one lane each, as in a row
+    // vector matrix. The loop has no dependencies between lanes and vectorizes
+    std::array<std::array<Lanes, 3>, 3> basis;
+    const Lanes& x = trs[static_cast<size_t>(RotationX)];
+    const Lanes& y = trs[static_cast<size_t>(RotationY)];
+    const Lanes& z = trs[static_cast<size_t>(RotationZ)];
+    const Lanes& w = trs[static_cast<size_t>(RotationW)];
+    const Lanes& sx = trs[static_cast<size_t>(ScaleX)];
+    const Lanes& sy = trs[static_cast<size_t>(ScaleY)];
+    const Lanes& sz = trs[static_cast<size_t>(ScaleZ)];
+    for (size_t i = 0; i < count; i++)
+    {
+        basis[0][0][i] = sx[i] * (1.0F - 2.0F * (y[i] * y[i] + z[i] * z[i]));
+        basis[0][1][i] = sx[i] * 2.0F * (x[i] * y[i] + z[i] * w[i]);
+        basis[0][2][i] = sx[i] * 2.0F * (x[i] * z[i] - y[i] * w[i]);
+        basis[1][0][i] = sy[i] * 2.0F * (x[i] * y[i] - z[i] * w[i]);
+        basis[1][1][i] = sy[i] * (1.0F - 2.0F * (x[i] * x[i] + z[i] * z[i]));
+        basis[1][2][i] = sy[i] * 2.0F * (y[i] * z[i] + x[i] * w[i]);
+        basis[2][0][i] = sz[i] * 2.0F * (x[i] * z[i] + y[i] * w[i]);
+        basis[2][1][i] = sz[i] * 2.0F * (y[i] * z[i] - x[i] * w[i]);
+        basis[2][2][i] = sz[i] * (1.0F - 2.0F * (x[i] * x[i] + y[i] * y[i]));
+    }
+
+    const Lanes& tx = trs[static_cast<size_t>(TranslationX)];
+    const Lanes& ty = trs[static_cast<size_t>(TranslationY)];
+    const Lanes& tz = trs[static_cast<size_t>(TranslationZ)];
+    for (size_t i = 0; i < count; i++)
+    {
+        Assets::Matrix4& world = m_world[slots[i]];
+        if constexpr (TRoots)
+        {
+            world = { basis[0][0][i], basis[0][1][i], basis[0][2][i], 0.0F, basis[1][0][i],
+                basis[1][1][i], basis[1][2][i], 0.0F, basis[2][0][i], basis[2][1][i],
+                basis[2][2][i], 0.0F, tx[i], ty[i], tz[i], 1.0F };
+        }
+        else
+        {
+            // Every result row is a blend of the parent's rows, four columns wide
+            const Assets::Matrix4& parent = m_world[m_parents[slots[i]]];
+            Assets::Matrix4        result;
+            for (size_t row = 0; row < 3; row++)
+            {
+                for (size_t column = 0; column < 4; column++)
+                {
+                    result[row * 4 + column] = basis[row][0][i] * parent[column]
+                        + basis[row][1][i] * parent[4 + column]
+                        + basis[row][2][i] * parent[8 + column];
+                }
+            }
+            for (size_t column = 0; column < 4; column++)
+            {
+                result[12 + column] = tx[i] * parent[column] + ty[i] * parent[4 + column]
+                    + tz[i] * parent[8 + column] + parent[12 + column];
+            }
+            world = result;
+        }
+    }
+}
+
+size_t TransformHierarchy::updateDepths(ThreadPool* threadPool)
+{
+    if (m_structureChanged)
+    {
+        rebuild();
+        m_structureChanged = false;
+    }
+
+    // The changed nodes of a depth are its dirty nodes plus the children of the
+    // nodes changed at the depth above, which are contiguous ranges marked dirty
+    // in turn
+    m_updatedSlots.clear();
+    for (size_t depth = 0; depth + 1 < m_depthStarts.size(); depth++)
+    {
+        const size_t first = m_updatedSlots.size();
+        takeBits(m_dirty, m_depthStarts[depth], m_depthStarts[depth + 1], m_updatedSlots);
+        const std::span<const uint32_t> changed
+            = std::span<const uint32_t>(m_updatedSlots).subspan(first);
+
+        const auto compose = [this, depth, changed](const size_t begin, const size_t end) {
+            for (size_t i = begin; i < end; i += g_batchSize)
+            {
+                const size_t count = std::min(g_batchSize, end - i);
+                if (depth == 0)
+                {
+                    composeBatch<true>(changed.data() + i, count);
+                }
+                else
+                {
+                    composeBatch<false>(changed.data() + i, count);
+                }
+            }
+        };
+        if (threadPool != nullptr)
+        {
+            threadPool->parallelFor(changed.size(), g_parallelGrain, compose);
+        }
+        else
+        {
+            compose(0, changed.size());
+        }
+
+        for (const uint32_t slot : changed)
+        {
+            setBits(m_dirty, m_childStarts[slot], m_childStarts[slot + 1]);
+        }
+    }
+    return m_updatedSlots.size();
+}
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "Animation.hpp"
+
+class ThreadPool;
+
+/// @brief Parent-child transforms of scene objects, flattened for batch updates.
+///
+/// Nodes live in slots in breadth first order: every parent is updated before its
+/// children, the nodes of one depth can be updated together and the children of a
+/// node occupy a contiguous range. Local transforms are stored component by
+/// component. Setting one marks the node dirty, and update() recomputes the world
+/// matrices of dirty nodes and their descendants only, at a cost proportional to
+/// those nodes plus one bit per slot. Structural changes (creating, destroying and
+/// reparenting nodes) take effect at the next update, which re-sorts the slots.
+class TransformHierarchy
+{
+public:
+    using NodeId = uint32_t;
+
+    static constexpr NodeId s_invalidNode = std::numeric_limits<NodeId>::max();
+
+    /// @brief Creates a node, dirty, under parent or as a root.
+    /// @throws std::runtime_error if the parent is not a live node.
+    NodeId create(NodeId parent = s_invalidNode, const Animation::Transform& local = {});
+
+    /// @brief Destroys a node. Its descendants are destroyed at the next update, and
+    /// the ids are reused only after it.
+    /// @throws std::runtime_error if the node is not live.
+    void destroy(NodeId node);
+
+    /// @throws std::runtime_error if either node is not live or parent is the node
+    /// or one of its descendants.
+    void setParent(NodeId node, NodeId parent);
+
+    void setLocal(NodeId node, const Animation::Transform& local);
+
+    [[nodiscard]] Animation::Transform local(NodeId node) const;
+
+    [[nodiscard]] NodeId parent(NodeId node) const;
+
+    [[nodiscard]] bool isAlive(NodeId node) const;
+
+    [[nodiscard]] size_t nodeCount() const;
+
+    /// @brief Recomputes world matrices on the calling thread.
+    /// @return The number of nodes whose world matrix was recomputed.
+    size_t update();
+
+    /// @brief Like update(), splitting the changed nodes of each depth across the
+    /// pool.
+    size_t update(ThreadPool& threadPool);
+
+    /// @brief Returns the world matrix as of the last update.
+    [[nodiscard]] const Assets::Matrix4& world(NodeId node) const;
+
+    /// @brief Returns the slot a node occupies until the next structural change.
+    [[nodiscard]] uint32_t slot(NodeId node) const;
+
+    /// @brief World matrices by slot, ready to copy into an upload buffer.
+    [[nodiscard]] std::span<const Assets::Matrix4> worldMatrices() const;
+
+    /// @brief Slots whose world matrix the last update recomputed, in increasing
+    /// order; only these need to be uploaded again.
+    [[nodiscard]] std::span<const uint32_t> updatedSlots() const;
+
+private:
+    static constexpr uint32_t s_noSlot = std::numeric_limits<uint32_t>::max();
+
+    using LocalComponents = std::array<std::vector<float>, Animation::g_poseComponentCount>;
+
+    /// @throws std::runtime_error if the node is not live.
+    void requireAlive(NodeId node) const;
+
+    [[nodiscard]] uint32_t liveSlot(NodeId node) const;
+
+    void markDirty(uint32_t slot);
+
+    /// Sorts the slots breadth first after structural changes.
+    void rebuild();
+
+    template <bool TRoots>
+    void composeBatch(const uint32_t* slots, size_t count);
+
+    size_t updateDepths(ThreadPool* threadPool);
+
+    // By node id
+    std::vector<uint32_t> m_slots; ///< s_noSlot once destroyed, and while free.
+    std::vector<NodeId>   m_parentIds;
+    std::vector<NodeId>   m_freeIds;
+    std::vector<NodeId>   m_destroyedIds; ///< Freed at the next rebuild.
+
+    // By slot
+    std::vector<NodeId>   m_nodes;
+    std::vector<uint32_t> m_parents; ///< Parent slot, or s_noSlot.
+    /// The children of slot s occupy slots [m_childStarts[s], m_childStarts[s + 1]).
+    std::vector<uint32_t>        m_childStarts;
+    LocalComponents              m_locals;
+    std::vector<uint64_t>        m_dirty; ///< One bit per slot.
+    std::vector<Assets::Matrix4> m_world;
+
+    std::vector<uint32_t> m_depthStarts; ///< First slot of each depth, then the slot count.
+    std::vector<uint32_t> m_updatedSlots;
+
+    bool m_structureChanged = false;
+};
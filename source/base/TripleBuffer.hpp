@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/// @brief Lock-free single producer, single consumer mailbox holding the latest value.
+///
+/// The producer fills its private back slot and publishes it by swapping it with the
+/// shared middle slot. The consumer swaps the middle slot with its private front slot
+/// when a newer value is available. Neither side ever waits on the other, and the
+/// value the consumer reads is never written while it holds it.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    explicit TripleBuffer(const T& initialValue)
+    {
+        for (auto& slot : m_slots)
+        {
+            slot.value = initialValue;
+        }
+    }
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /// @brief Producer side: the slot to fill before calling publish.
+    [[nodiscard]] T& writeBuffer()
+    {
+        return m_slots[m_writeIndex].value;
+    }
+
+    /// @brief Producer side: makes the write buffer the latest value.
+    void publish()
+    {
+        const uint32_t previous
+            = m_middle.exchange(m_writeIndex | s_freshBit, std::memory_order_acq_rel);
+        m_writeIndex = previous & s_indexMask;
+    }
+
+    /// @brief Consumer side: takes the latest published value if there is a newer one.
+    /// @return True if the read buffer changed.
+    bool update()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & s_freshBit) == 0)
+        {
+            return false;
+        }
+        const uint32_t previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & s_indexMask;
+        return true;
+    }
+
+    /// @brief Consumer side: the value taken by the last update.
+    [[nodiscard]] const T& readBuffer() const
+    {
+        return m_slots[m_readIndex].value;
+    }
+
+private:
+    static constexpr uint32_t s_indexMask = 0x3;
+    static constexpr uint32_t s_freshBit = 0x4;
+    static constexpr size_t   s_cacheLineSize = 64;
+
+    struct alignas(s_cacheLineSize) Slot
+    {
+        T value {};
+    };
+
+    std::array<Slot, 3>                            m_slots {};
+    alignas(s_cacheLineSize) uint32_t              m_writeIndex = 0;
+    alignas(s_cacheLineSize) std::atomic<uint32_t> m_middle = 1;
+    alignas(s_cacheLineSize) uint32_t              m_readIndex = 2;
+};
@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "UploadRing.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+UploadRing::UploadRing(std::byte* memory, const uint64_t capacity)
+    : m_memory(memory)
+    , m_capacity(capacity)
+{
+    if (m_memory == nullptr || m_capacity == 0)
+    {
+        throw std::invalid_argument("UploadRing requires a non-empty buffer");
+    }
+}
+
+void UploadRing::beginFrame(const uint64_t frameNumber)
+{
+    if (frameNumber == m_frameNumber)
+    {
+        return;
+    }
+
+    if (m_frameBytes > 0)
+    {
+        m_frames.push_back({ m_frameNumber, m_head, m_frameBytes });
+    }
+    m_frameNumber = frameNumber;
+    m_frameBytes = 0;
+}
+
+void UploadRing::retireFrames(const uint64_t completedFrames)
+{
+    while (!m_frames.empty() && m_frames.front().frameNumber < completedFrames)
+    {
+        m_tail = m_frames.front().end;
+        m_statistics.bytesInFlight -= m_frames.front().bytes;
+        m_frames.pop_front();
+    }
+
+    if (m_statistics.bytesInFlight == 0)
+    {
+        // Nothing is live, so restart at the beginning for the largest contiguous span.
+        m_head = 0;
+        m_tail = 0;
+    }
+}
+
+UploadRing::Allocation UploadRing::allocate(const uint64_t size, const uint64_t alignment)
+{
+    const uint64_t aligned = (m_head + alignment - 1) & ~(alignment - 1);
+    const bool     empty = m_statistics.bytesInFlight == 0;
+
+    // The free space is [head, tail) when the head is behind the tail, and
+    // [head, capacity) plus [0, tail) otherwise.
+    uint64_t offset = 0;
+    uint64_t consumed = 0;
+    if (!empty && m_head == m_tail)
+    {
+        m_statistics.failures++; // Completely full
+        return {};
+    }
+    if (!empty && m_head < m_tail)
+    {
+        if (aligned + size > m_tail)
+        {
+            m_statistics.failures++;
+            return {};
+        }
+        offset = aligned;
+        consumed = aligned + size - m_head;
+    }
+    else if (aligned + size <= m_capacity)
+    {
+        offset = aligned;
+        consumed = aligned + size - m_head;
+    }
+    else if (size <= m_tail || (empty && size <= m_capacity))
+    {
+        // Wrap around; the unused end of the buffer is charged to this frame so it
+        // is reclaimed together with the allocation.
+        offset = 0;
+        consumed = m_capacity - m_head + size;
+        m_statistics.wraps++;
+    }
+    else
+    {
+        m_statistics.failures++;
+        return {};
+    }
+
+    m_head = offset + size;
+    m_frameBytes += consumed;
+    m_statistics.bytesInFlight += consumed;
+    m_statistics.peakBytesInFlight
+        = std::max(m_statistics.peakBytesInFlight, m_statistics.bytesInFlight);
+    m_statistics.allocations++;
+    return { m_memory + offset, offset, size };
+}
+
+uint64_t UploadRing::capacity() const
+{
+    return m_capacity;
+}
+
+const UploadRing::Statistics& UploadRing::statistics() const
+{
+    return m_statistics;
+}
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/// @brief Sub-allocator for a persistently mapped upload buffer used as a ring.
+///
+/// Allocations are tagged with the frame that is being recorded and are released
+/// all at once when that frame retires on the GPU. The ring never blocks: when the
+/// request does not fit between the write head and the oldest live frame, allocate
+/// returns an empty allocation and the caller falls back to a dedicated buffer.
+///
+/// The ring only deals with offsets into memory owned by the caller, so the same
+/// logic serves a Metal buffer or plain host memory.
+class UploadRing
+{
+public:
+    static constexpr uint64_t s_defaultAlignment = 256;
+
+    struct Allocation
+    {
+        std::byte* data = nullptr; ///< CPU address, or nullptr when the ring is full.
+        uint64_t   offset = 0;     ///< Offset from the start of the ring.
+        uint64_t   size = 0;
+
+        explicit operator bool() const
+        {
+            return data != nullptr;
+        }
+    };
+
+    struct Statistics
+    {
+        uint64_t allocations = 0;   ///< Successful allocations over the lifetime.
+        uint64_t failures = 0;      ///< Requests that did not fit.
+        uint64_t wraps = 0;         ///< Times the head wrapped to the start.
+        uint64_t bytesInFlight = 0; ///< Bytes held by unretired frames, incl. padding.
+        uint64_t peakBytesInFlight = 0;
+    };
+
+    /// @param [in] memory Start of the mapped buffer.
+    /// @param [in] capacity Size of the buffer in bytes.
+    UploadRing(std::byte* memory, uint64_t capacity);
+
+    /// @brief Starts tagging allocations with the given frame number.
+    /// @note Calling it again with the current frame number is a no-op, so a frame
+    /// that is retried after being skipped keeps its allocations.
+    void beginFrame(uint64_t frameNumber);
+
+    /// @brief Releases the allocations of every frame numbered below completedFrames.
+    /// @param [in] completedFrames Count of frames known to have completed on the GPU.
+    void retireFrames(uint64_t completedFrames);
+
+    /// @brief Allocates size bytes at the given power of two alignment.
+    [[nodiscard]] Allocation allocate(uint64_t size, uint64_t alignment = s_defaultAlignment);
+
+    [[nodiscard]] uint64_t capacity() const;
+
+    [[nodiscard]] const Statistics& statistics() const;
+
+private:
+    struct FrameRegion
+    {
+        uint64_t frameNumber;
+        uint64_t end;   ///< Head offset after the frame's last allocation.
+        uint64_t bytes; ///< Bytes consumed, including alignment and wrap padding.
+    };
+
+    std::byte*              m_memory;
+    uint64_t                m_capacity;
+    uint64_t                m_head = 0;
+    uint64_t                m_tail = 0;
+    uint64_t                m_frameNumber = 0;
+    uint64_t                m_frameBytes = 0;
+    std::deque<FrameRegion> m_frames;
+    Statistics              m_statistics {};
+};
@@ -0,0 +1,277 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "VertexQuantization.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace Assets
+{
+    namespace
+    {
+        // Raw MTL::VertexFormat values, kept here so the asset code does not depend on
+        // the Metal headers
+        constexpr uint32_t g_metalUChar4Normalized = 9;
+        constexpr uint32_t g_metalChar4Normalized = 12;
+        constexpr uint32_t g_metalUShort4Normalized = 21;
+        constexpr uint32_t g_metalShort2Normalized = 22;
+        constexpr uint32_t g_metalHalf2 = 25;
+        constexpr uint32_t g_metalFloat2 = 29;
+        constexpr uint32_t g_metalFloat3 = 30;
+        constexpr uint32_t g_metalFloat4 = 31;
+
+        float signNotZero(const float value)
+        {
+            return value >= 0.0F ? 1.0F : -1.0F;
+        }
+
+        template <typename TElement, size_t N, typename TEncode>
+        EncodedStream encodeStream(const std::span<const std::array<float, N>> values,
+            const VertexStreamFormat format, const TEncode& encode)
+        {
+            EncodedStream stream;
+            stream.format = format;
+            stream.bytes.resize(values.size() * sizeof(TElement));
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                const TElement element = encode(values[i]);
+                std::memcpy(stream.bytes.data() + i * sizeof(TElement), &element, sizeof(TElement));
+            }
+            return stream;
+        }
+    } // namespace
+
+    uint32_t vertexStreamStride(const VertexStreamFormat format)
+    {
+        switch (format)
+        {
+        case VertexStreamFormat::Float2:
+            return sizeof(float) * 2;
+        case VertexStreamFormat::Float3:
+            return sizeof(float) * 3;
+        case VertexStreamFormat::Float4:
+            return sizeof(float) * 4;
+        case VertexStreamFormat::UShort4Normalized:
+            return sizeof(uint16_t) * 4;
+        case VertexStreamFormat::Short2Normalized:
+        case VertexStreamFormat::Half2:
+            return sizeof(uint16_t) * 2;
+        case VertexStreamFormat::Char4Normalized:
+        case VertexStreamFormat::UChar4Normalized:
+            return sizeof(uint8_t) * 4;
+        default:
+            return 0;
+        }
+    }
+
+    uint32_t metalVertexFormat(const VertexStreamFormat format)
+    {
+        switch (format)
+        {
+        case VertexStreamFormat::Float2:
+            return g_metalFloat2;
+        case VertexStreamFormat::Float3:
+            return g_metalFloat3;
+        case VertexStreamFormat::Float4:
+            return g_metalFloat4;
+        case VertexStreamFormat::UShort4Normalized:
+            return g_metalUShort4Normalized;
+        case VertexStreamFormat::Short2Normalized:
+            return g_metalShort2Normalized;
+        case VertexStreamFormat::Char4Normalized:
+            return g_metalChar4Normalized;
+        case VertexStreamFormat::Half2:
+            return g_metalHalf2;
+        case VertexStreamFormat::UChar4Normalized:
+            return g_metalUChar4Normalized;
+        default:
+            return 0; // MTL::VertexFormatInvalid
+        }
+    }
+
+    uint16_t encodeHalf(const float value)
+    {
+        const uint32_t bits = std::bit_cast<uint32_t>(value);
+        const auto     sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        const uint32_t magnitude = bits & 0x7FFFFFFF;
+
+        if (magnitude >= 0x7F800000)
+        {
+            // Infinity stays infinity, NaN stays a quiet NaN
+            return sign | (magnitude > 0x7F800000 ? 0x7E00 : 0x7C00);
+        }
+        if (magnitude >= 0x477FF000)
+        {
+            // At least 65520, which rounds past the largest half
+            return sign | 0x7C00;
+        }
+        if (magnitude < 0x38800000)
+        {
+            // Below the smallest normal half: subnormals count in units of 2^-24
+            const float scaled = std::bit_cast<float>(magnitude) * 16777216.0F;
+            return sign | static_cast<uint16_t>(std::nearbyint(scaled));
+        }
+
+        // Rebias the exponent from 127 to 15 and round the mantissa to nearest even
+        uint32_t half = magnitude - (112U << 23);
+        half += 0x0FFF + ((half >> 13) & 1);
+        return sign | static_cast<uint16_t>(half >> 13);
+    }
+
+    float decodeHalf(const uint16_t value)
+    {
+        const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+        const uint32_t exponent = (value >> 10) & 0x1F;
+        const uint32_t mantissa = value & 0x03FF;
+
+        if (exponent == 0)
+        {
+            const float magnitude = static_cast<float>(mantissa) / 16777216.0F;
+            return sign != 0 ? -magnitude : magnitude;
+        }
+        if (exponent == 0x1F)
+        {
+            return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+        }
+        return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+    }
+
+    std::array<float, 2> encodeOctahedral(const std::array<float, 3>& normal)
+    {
+        const float length = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+        if (length == 0.0F)
+        {
+            return { 0.0F, 0.0F };
+        }
+
+        const float x = normal[0] / length;
+        const float y = normal[1] / length;
+        if (normal[2] >= 0.0F)
+        {
+            return { x, y };
+        }
+        // Fold the lower hemisphere over the diagonals
+        return { (1.0F - std::abs(y)) * signNotZero(x), (1.0F - std::abs(x)) * signNotZero(y) };
+    }
+
+    std::array<float, 3> decodeOctahedral(const std::array<float, 2>& encoded)
+    {
+        float       x = encoded[0];
+        float       y = encoded[1];
+        const float z = 1.0F - std::abs(x) - std::abs(y);
+        if (z < 0.0F)
+        {
+            const float foldedX = (1.0F - std::abs(y)) * signNotZero(x);
+            y = (1.0F - std::abs(x)) * signNotZero(y);
+            x = foldedX;
+        }
+
+        const float length = std::sqrt(x * x + y * y + z * z);
+        return { x / length, y / length, z / length };
+    }
+
+    uint16_t quantizeUnorm16(const float value)
+    {
+        return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0F, 1.0F) * 65535.0F));
+    }
+
+    uint8_t quantizeUnorm8(const float value)
+    {
+        return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0F, 1.0F) * 255.0F));
+    }
+
+    int16_t quantizeSnorm16(const float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0F, 1.0F) * 32767.0F));
+    }
+
+    int8_t quantizeSnorm8(const float value)
+    {
+        return static_cast<int8_t>(std::lround(std::clamp(value, -1.0F, 1.0F) * 127.0F));
+    }
+
+    EncodedStream quantizePositions(const std::span<const std::array<float, 3>> positions,
+        const std::array<float, 3>& boundsMin, const std::array<float, 3>& boundsMax)
+    {
+        std::array<float, 3> scale {};
+        for (size_t axis = 0; axis < 3; axis++)
+        {
+            const float extent = boundsMax[axis] - boundsMin[axis];
+            scale[axis] = extent > 0.0F ? 1.0F / extent : 0.0F;
+        }
+
+        return encodeStream<std::array<uint16_t, 4>>(positions,
+            VertexStreamFormat::UShort4Normalized, [&](const std::array<float, 3>& position) {
+                return std::array<uint16_t, 4> {
+                    quantizeUnorm16((position[0] - boundsMin[0]) * scale[0]),
+                    quantizeUnorm16((position[1] - boundsMin[1]) * scale[1]),
+                    quantizeUnorm16((position[2] - boundsMin[2]) * scale[2]),
+                    0xFFFF,
+                };
+            });
+    }
+
+    EncodedStream quantizeNormals(const std::span<const std::array<float, 3>> normals)
+    {
+        return encodeStream<std::array<int16_t, 2>>(
+            normals, VertexStreamFormat::Short2Normalized, [](const std::array<float, 3>& normal) {
+                const auto encoded = encodeOctahedral(normal);
+                return std::array<int16_t, 2> {
+                    quantizeSnorm16(encoded[0]),
+                    quantizeSnorm16(encoded[1]),
+                };
+            });
+    }
+
+    EncodedStream quantizeTangents(const std::span<const std::array<float, 4>> tangents)
+    {
+        return encodeStream<std::array<int8_t, 4>>(tangents, VertexStreamFormat::Char4Normalized,
+            [](const std::array<float, 4>& tangent) {
+                const auto encoded = encodeOctahedral({ tangent[0], tangent[1], tangent[2] });
+                return std::array<int8_t, 4> {
+                    quantizeSnorm8(encoded[0]),
+                    quantizeSnorm8(encoded[1]),
+                    0,
+                    static_cast<int8_t>(tangent[3] < 0.0F ? -127 : 127),
+                };
+            });
+    }
+
+    EncodedStream quantizeTexCoords(const std::span<const std::array<float, 2>> texCoords)
+    {
+        return encodeStream<std::array<uint16_t, 2>>(
+            texCoords, VertexStreamFormat::Half2, [](const std::array<float, 2>& texCoord) {
+                return std::array<uint16_t, 2> { encodeHalf(texCoord[0]), encodeHalf(texCoord[1]) };
+            });
+    }
+
+    EncodedStream quantizeColors(const std::span<const std::array<float, 4>> colors)
+    {
+        return encodeStream<std::array<uint8_t, 4>>(
+            colors, VertexStreamFormat::UChar4Normalized, [](const std::array<float, 4>& color) {
+                return std::array<uint8_t, 4> {
+                    quantizeUnorm8(color[0]),
+                    quantizeUnorm8(color[1]),
+                    quantizeUnorm8(color[2]),
+                    quantizeUnorm8(color[3]),
+                };
+            });
+    }
+
+    std::array<float, 3> dequantizePosition(const std::array<uint16_t, 4>& encoded,
+        const std::array<float, 3>& boundsMin, const std::array<float, 3>& boundsMax)
+    {
+        std::array<float, 3> position {};
+        for (size_t axis = 0; axis < 3; axis++)
+        {
+            const float fraction = static_cast<float>(encoded[axis]) / 65535.0F;
+            position[axis] = boundsMin[axis] + fraction * (boundsMax[axis] - boundsMin[axis]);
+        }
+        return position;
+    }
+} // namespace Assets
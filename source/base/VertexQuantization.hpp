@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Assets
+{
+    /// @brief Element format of a vertex stream.
+    ///
+    /// Quantized formats map onto normalized Metal vertex formats, so the vertex fetch
+    /// hardware expands them and shaders only apply the decode steps in
+    /// shaders/common/VertexDecode.h.
+    enum class VertexStreamFormat : uint32_t
+    {
+        None, ///< The primitive has no such attribute.
+        Float2,
+        Float3,
+        Float4,
+        UShort4Normalized, ///< Positions within the primitive bounds; w is 1.
+        Short2Normalized,  ///< Octahedral unit vectors.
+        Char4Normalized,   ///< Octahedral tangent in xy, handedness in w.
+        Half2,             ///< Texture coordinates.
+        UChar4Normalized,  ///< Colors.
+    };
+
+    /// @brief Size in bytes of one element.
+    [[nodiscard]] uint32_t vertexStreamStride(VertexStreamFormat format);
+
+    /// @brief Raw MTL::VertexFormat value matching the format, as stored in
+    /// PipelineDescription.
+    [[nodiscard]] uint32_t metalVertexFormat(VertexStreamFormat format);
+
+    /// @brief IEEE 754 binary16 conversions, rounding to nearest even.
+    [[nodiscard]] uint16_t encodeHalf(float value);
+
+    [[nodiscard]] float decodeHalf(uint16_t value);
+
+    /// @brief Maps a unit vector onto the [-1, 1] square of an octahedral projection.
+    [[nodiscard]] std::array<float, 2> encodeOctahedral(const std::array<float, 3>& normal);
+
+    /// @brief Inverse of encodeOctahedral, returning a unit vector.
+    [[nodiscard]] std::array<float, 3> decodeOctahedral(const std::array<float, 2>& encoded);
+
+    /// @brief Normalized integer conversions as the GPU defines them: unsigned values
+    /// map onto [0, 1], signed values onto [-1, 1]. Inputs are clamped.
+    [[nodiscard]] uint16_t quantizeUnorm16(float value);
+
+    [[nodiscard]] uint8_t quantizeUnorm8(float value);
+
+    [[nodiscard]] int16_t quantizeSnorm16(float value);
+
+    [[nodiscard]] int8_t quantizeSnorm8(float value);
+
+    /// @brief Encoded elements of one vertex stream.
+    struct EncodedStream
+    {
+        VertexStreamFormat     format = VertexStreamFormat::None;
+        std::vector<std::byte> bytes;
+    };
+
+    /// @brief Positions as 16 bit fractions of the bounds, so the error per axis is
+    /// about half the extent / 65535.
+    [[nodiscard]] EncodedStream quantizePositions(std::span<const std::array<float, 3>> positions,
+        const std::array<float, 3>& boundsMin, const std::array<float, 3>& boundsMax);
+
+    /// @brief Unit normals as 2x16 bit octahedral coordinates.
+    [[nodiscard]] EncodedStream quantizeNormals(std::span<const std::array<float, 3>> normals);
+
+    /// @brief Tangents as 2x8 bit octahedral coordinates, with the bitangent sign in w.
+    [[nodiscard]] EncodedStream quantizeTangents(std::span<const std::array<float, 4>> tangents);
+
+    /// @brief Texture coordinates as half floats.
+    [[nodiscard]] EncodedStream quantizeTexCoords(std::span<const std::array<float, 2>> texCoords);
+
+    /// @brief Colors as 8 bit normalized RGBA.
+    [[nodiscard]] EncodedStream quantizeColors(std::span<const std::array<float, 4>> colors);
+
+    /// @brief Decodes one quantized position, as the vertex shader does.
+    [[nodiscard]] std::array<float, 3> dequantizePosition(const std::array<uint16_t, 4>& encoded,
+        const std::array<float, 3>& boundsMin, const std::array<float, 3>& boundsMax);
+} // namespace Assets
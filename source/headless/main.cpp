@@ -0,0 +1,1490 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <span>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "Animation.hpp"
+#include "Camera.hpp"
+#include "CookedMesh.hpp"
+#include "Ecs.hpp"
+#include "EcsScheduler.hpp"
+#include "FrameArena.hpp"
+#include "HeadlessRunner.hpp"
+#include "LodSelection.hpp"
+#include "MeshletBuilder.hpp"
+#include "ParallelEncoder.hpp"
+#include "RecordingEncoder.hpp"
+#include "RenderQueue.hpp"
+#include "SimulationThread.hpp"
+#include "Skinning.hpp"
+#include "SoftwareBackend.hpp"
+#include "ThreadPool.hpp"
+
+// Renders the example scenes with the software rasterizer, without Metal or a
+// window. The scene setup mirrors source/<example>/main.cpp so the output can
+// serve as a reference image for the Metal renderer.
+
+namespace
+{
+    struct Options
+    {
+        std::string           scene = "all";
+        uint64_t              frames = 60;
+        uint32_t              width = 1280;
+        uint32_t              height = 720;
+        uint32_t              threads = 0;
+        uint32_t              framesInFlight = 3;
+        LatencyMode           latencyMode = LatencyMode::Throughput;
+        double                gpuFrameTime = 0.0;
+        double                cpuFrameTime = 0.0;
+        bool                  simulationThread = false;
+        std::filesystem::path outputDirectory = ".";
+        std::filesystem::path assetDirectory = ASSET_DIRECTORY;
+        std::filesystem::path meshPath;
+    };
+
+    constexpr auto g_cubeVertices = std::to_array<Raster::Vertex>({
+        { .position = { -1, 1, 1, 1 }, .color = { 0, 1, 1, 1 } },
+        { .position = { -1, -1, 1, 1 }, .color = { 0, 0, 1, 1 } },
+        { .position = { 1, -1, 1, 1 }, .color = { 1, 0, 1, 1 } },
+        { .position = { 1, 1, 1, 1 }, .color = { 1, 1, 1, 1 } },
+        { .position = { -1, 1, -1, 1 }, .color = { 0, 1, 0, 1 } },
+        { .position = { -1, -1, -1, 1 }, .color = { 0, 0, 0, 1 } },
+        { .position = { 1, -1, -1, 1 }, .color = { 1, 0, 0, 1 } },
+        { .position = { 1, 1, -1, 1 }, .color = { 1, 1, 0, 1 } },
+    });
+
+    constexpr auto g_cubeIndices = std::to_array<uint16_t>({ 3, 2, 6, 6, 7, 3, 4, 5, 1, 1, 0,
+        4, 4, 0, 3, 3, 7, 4, 1, 5, 6, 6, 2, 1, 0, 1, 2, 2, 3, 0, 7, 6, 5, 5, 4, 7 });
+
+    Raster::Matrix4 toRaster(const Matrix& matrix)
+    {
+        Raster::Matrix4 result {};
+        std::memcpy(result.data(), &matrix, sizeof(result));
+        return result;
+    }
+
+    Matrix modelMatrix(const Vector3& position, float rotationX, float rotationY, float scale)
+    {
+        const Matrix xRot = Matrix::CreateFromAxisAngle(Vector3::Right, rotationX);
+        const Matrix yRot = Matrix::CreateFromAxisAngle(Vector3::Up, rotationY);
+        return Matrix::CreateScale(scale) * (xRot * yRot) * Matrix::CreateTranslation(position);
+    }
+
+    /// @brief Base class for scenes rendered through a SoftwareBackend.
+    class Scene : public FrameListener
+    {
+    public:
+        Scene(SoftwareBackend& backend, uint32_t width, uint32_t height)
+            : m_backend(backend)
+            , m_camera(Vector3::Zero, Vector3::Forward, Vector3::Up, XMConvertToRadians(75.0F),
+                  static_cast<float>(width) / static_cast<float>(height), 0.01F, 1000.0F)
+        {
+        }
+
+        /// @brief Prints scene specific statistics after the run.
+        virtual void printStatistics() const
+        {
+        }
+
+    protected:
+        SoftwareBackend& m_backend;
+        Camera           m_camera;
+    };
+
+    class HelloWorldScene final : public Scene
+    {
+    public:
+        using Scene::Scene;
+
+        void onFrameUpdate(const GameTimer& timer) override
+        {
+            m_rotationY += static_cast<float>(timer.elapsedSeconds());
+
+            const Matrix model = modelMatrix(Vector3(0.0F, 0.0F, -10.0F), 0.0F, m_rotationY, 3.0F);
+            m_transform = toRaster(model * m_camera.uniforms().viewProjection);
+        }
+
+        void onFrameRender([[maybe_unused]] const GameTimer& timer) override
+        {
+            static constexpr auto s_vertices = std::to_array<Raster::Vertex>({
+                { .position = { 0, 1, 0, 1 }, .color = { 1, 0, 0, 1 } },
+                { .position = { -1, -1, 0, 1 }, .color = { 0, 1, 0, 1 } },
+                { .position = { 1, -1, 0, 1 }, .color = { 0, 0, 1, 1 } },
+            });
+            static constexpr auto s_indices = std::to_array<uint16_t>({ 0, 1, 2 });
+
+            m_backend.rasterizer().draw({
+                .vertices = s_vertices,
+                .indices16 = s_indices,
+                .instanceTransforms = { &m_transform, 1 },
+            });
+        }
+
+    private:
+        float           m_rotationY = 0.0F;
+        Raster::Matrix4 m_transform {};
+    };
+
+    // Components of the instancing scene's entities
+    struct Position
+    {
+        Vector3 value;
+    };
+
+    struct Rotation
+    {
+        float x = 0.0F;
+        float y = 0.0F;
+    };
+
+    struct Spin
+    {
+        float speed = 1.0F; ///< Multiplier of the elapsed time.
+    };
+
+    struct CameraView
+    {
+        Matrix viewProjection;
+    };
+
+    /// @brief Cubes and their camera stored as ECS entities. The instance transform
+    /// component is the Raster::Matrix4 itself, so a chunk's array is drawn as is.
+    class InstancingScene final : public Scene
+    {
+    public:
+        struct RotationState
+        {
+            float rotationX = 0.0F;
+            float rotationY = 0.0F;
+        };
+
+        InstancingScene(SoftwareBackend& backend,
+            uint32_t                     width,
+            uint32_t                     height,
+            ThreadPool&                  threadPool,
+            bool                         useSimulationThread)
+            : Scene(backend, width, height)
+            , m_threadPool(threadPool)
+        {
+            m_cameraEntity = m_world.create(CameraView { m_camera.uniforms().viewProjection });
+            for (size_t i = 0; i < 3; i++)
+            {
+                const auto position = Vector3(-5.0F + 5.0F * static_cast<float>(i), 0.0F, -10.0F);
+                static_cast<void>(m_world.create(
+                    Position { position }, Rotation {}, Spin {}, Raster::Matrix4 {}));
+            }
+
+            if (useSimulationThread)
+            {
+                m_simulation = std::make_unique<SimulationThread<RotationState>>(
+                    RotationState {}, 1.0 / 60.0, [](const GameTimer& timer, RotationState& state) {
+                        const auto elapsed = static_cast<float>(timer.elapsedSeconds());
+                        state.rotationX += elapsed;
+                        state.rotationY += elapsed;
+                    });
+                m_simulation->start();
+            }
+
+            m_systems.add("spin", Ecs::Access {}.read<Spin>().write<Rotation>(),
+                [this](const Ecs::SystemContext& context) { spin(context); });
+            m_systems.add("transform",
+                Ecs::Access {}.read<Position, Rotation, CameraView>().write<Raster::Matrix4>(),
+                [this](const Ecs::SystemContext& context) {
+                    const Matrix viewProjection
+                        = context.get<const CameraView>(m_cameraEntity)->viewProjection;
+                    context.forEach<const Position, const Rotation, Raster::Matrix4>(
+                        [&](const Position& position, const Rotation& rotation,
+                            Raster::Matrix4& transform) {
+                            const Matrix model
+                                = modelMatrix(position.value, rotation.x, rotation.y, 1.0F);
+                            transform = toRaster(model * viewProjection);
+                        });
+                });
+        }
+
+        void onFrameUpdate(const GameTimer& timer) override
+        {
+            m_elapsed = static_cast<float>(timer.elapsedSeconds());
+            m_systems.run(m_world, m_threadPool);
+        }
+
+        void onFrameRender([[maybe_unused]] const GameTimer& timer) override
+        {
+            m_world.forEachChunk<const Raster::Matrix4>(
+                [&](std::span<const Ecs::Entity> entities, const Raster::Matrix4* transforms) {
+                    m_backend.rasterizer().draw({
+                        .vertices = g_cubeVertices,
+                        .indices16 = g_cubeIndices,
+                        .instanceTransforms = { transforms, entities.size() },
+                    });
+                });
+        }
+
+    private:
+        void spin(const Ecs::SystemContext& context) const
+        {
+            if (m_simulation == nullptr)
+            {
+                context.forEach<const Spin, Rotation>([&](const Spin& spin, Rotation& rotation) {
+                    rotation.x += spin.speed * m_elapsed;
+                    rotation.y += spin.speed * m_elapsed;
+                });
+                return;
+            }
+
+            // The simulation thread runs on the real clock, independent of pacing.
+            const auto& snapshot = m_simulation->latestSnapshot();
+            const auto  alpha = static_cast<float>(
+                m_simulation->interpolationFactor(snapshot, SDL_GetPerformanceCounter()));
+            const float rotationX
+                = std::lerp(snapshot.previous.rotationX, snapshot.current.rotationX, alpha);
+            const float rotationY
+                = std::lerp(snapshot.previous.rotationY, snapshot.current.rotationY, alpha);
+            context.forEach<const Spin, Rotation>([&](const Spin& spin, Rotation& rotation) {
+                rotation.x = spin.speed * rotationX;
+                rotation.y = spin.speed * rotationY;
+            });
+        }
+
+        ThreadPool&                                      m_threadPool;
+        Ecs::World                                       m_world;
+        Ecs::Scheduler                                   m_systems;
+        Ecs::Entity                                      m_cameraEntity;
+        float                                            m_elapsed = 0.0F;
+        std::unique_ptr<SimulationThread<RotationState>> m_simulation;
+    };
+
+    class TexturesScene final : public Scene
+    {
+    public:
+        TexturesScene(SoftwareBackend&   backend,
+            uint32_t                     width,
+            uint32_t                     height,
+            const std::filesystem::path& assetDirectory)
+            : Scene(backend, width, height)
+        {
+            for (auto& texture : m_textures)
+            {
+                const size_t index = &texture - m_textures.data();
+                const auto   path
+                    = assetDirectory / "textures" / std::format("00{}_basecolor.png", index + 1);
+                texture = loadTexture(path);
+                m_texturePointers[index] = &texture;
+            }
+        }
+
+        void onFrameUpdate([[maybe_unused]] const GameTimer& timer) override
+        {
+            // The Metal example only rotates while dragging with the mouse.
+            for (size_t i = 0; i < m_transforms.size(); i++)
+            {
+                const auto   position = Vector3(-5.0F + 5.0F * static_cast<float>(i), 0.0F, -8.0F);
+                const Matrix model = modelMatrix(position, 0.0F, 0.0F, 1.0F);
+                m_transforms[i] = toRaster(model * m_camera.uniforms().viewProjection);
+            }
+        }
+
+        void onFrameRender([[maybe_unused]] const GameTimer& timer) override
+        {
+            // The texture shader flips v, which is folded into the texture coordinates.
+            static constexpr auto s_vertices = std::to_array<Raster::Vertex>({
+                { .position = { -1, -1, 0, 1 }, .texCoord = { 0, 1 } },
+                { .position = { -1, 1, 0, 1 }, .texCoord = { 0, 0 } },
+                { .position = { 1, -1, 0, 1 }, .texCoord = { 1, 1 } },
+                { .position = { 1, 1, 0, 1 }, .texCoord = { 1, 0 } },
+            });
+            static constexpr auto s_indices = std::to_array<uint16_t>({ 0, 1, 2, 2, 1, 3 });
+
+            m_backend.rasterizer().draw({
+                .vertices = s_vertices,
+                .indices16 = s_indices,
+                .instanceTransforms = m_transforms,
+                .textures = m_texturePointers,
+                .blendEnabled = true,
+            });
+        }
+
+    private:
+        static Raster::Texture loadTexture(const std::filesystem::path& path)
+        {
+            int      width = 0;
+            int      height = 0;
+            int      channels = 0;
+            stbi_uc* imageData = stbi_load(path.string().c_str(), &width, &height, &channels, 4);
+            if (imageData == nullptr)
+            {
+                throw std::runtime_error(std::format(
+                    "Failed to load image {}: {}", path.string(), stbi_failure_reason()));
+            }
+
+            const size_t    size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+            Raster::Texture texture({ imageData, size }, static_cast<uint32_t>(width),
+                static_cast<uint32_t>(height), true);
+            stbi_image_free(imageData);
+            return texture;
+        }
+
+        std::array<Raster::Texture, 5>        m_textures;
+        std::array<const Raster::Texture*, 5> m_texturePointers {};
+        std::array<Raster::Matrix4, 3>        m_transforms {};
+    };
+
+    /// @brief Draws the meshlets of a cooked mesh that survive CPU culling, each in its
+    /// own color, as a reference for the culling a task shader performs.
+    class MeshletScene final : public Scene
+    {
+    public:
+        MeshletScene(SoftwareBackend&    backend,
+            uint32_t                     width,
+            uint32_t                     height,
+            const std::filesystem::path& path)
+            : Scene(backend, width, height)
+            , m_file(path)
+            , m_viewportHeight(static_cast<float>(height))
+        {
+            std::array<float, 3> boundsMin;
+            std::array<float, 3> boundsMax;
+            boundsMin.fill(std::numeric_limits<float>::max());
+            boundsMax.fill(std::numeric_limits<float>::lowest());
+            for (size_t mesh = 0; mesh < m_file.meshCount(); mesh++)
+            {
+                for (const auto& primitive : m_file.primitives(mesh))
+                {
+                    const auto lods = m_file.lods(primitive);
+                    if (lods.front().meshletCount == 0)
+                    {
+                        continue;
+                    }
+                    m_primitives.push_back(
+                        { decodePositions(primitive), lods, bounds(primitive) });
+                    m_lodUsage.resize(std::max(m_lodUsage.size(), lods.size()));
+                    for (size_t axis = 0; axis < 3; axis++)
+                    {
+                        boundsMin[axis] = std::min(boundsMin[axis], primitive.boundsMin[axis]);
+                        boundsMax[axis] = std::max(boundsMax[axis], primitive.boundsMax[axis]);
+                    }
+                }
+            }
+            if (m_primitives.empty())
+            {
+                throw std::runtime_error(std::format(
+                    "{} has no meshlets, cook it with meshcook --meshlets", path.string()));
+            }
+
+            const Vector3 extent(boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1],
+                boundsMax[2] - boundsMin[2]);
+            m_center = Vector3(boundsMin[0], boundsMin[1], boundsMin[2]) + extent * 0.5F;
+            m_radius = std::max(extent.Length() * 0.5F, 1.0e-6F);
+        }
+
+        void onFrameUpdate(const GameTimer& timer) override
+        {
+            const auto elapsed = static_cast<float>(timer.elapsedSeconds());
+            m_rotationX += elapsed * 0.5F;
+            m_rotationY += elapsed;
+
+            // Close enough that the top and bottom leave the frustum
+            const Matrix placement = modelMatrix(
+                Vector3(0.0F, 0.0F, -1.6F), m_rotationX, m_rotationY, 1.0F / m_radius);
+            const Matrix model = Matrix::CreateTranslation(-m_center) * placement;
+            m_transform = toRaster(model * m_camera.uniforms().viewProjection);
+
+            // Bounds are in object space, so the camera goes there instead
+            const Assets::Frustum     frustum = Assets::extractFrustum(m_transform);
+            const Vector3             camera = Vector3::Transform(Vector3::Zero, model.Invert());
+            const Assets::LodSelector selector({ camera.x, camera.y, camera.z },
+                m_camera.uniforms().projection._22, m_viewportHeight);
+
+            m_vertices.clear();
+            m_indices.clear();
+            uint32_t colorIndex = 0;
+            for (const auto& primitive : m_primitives)
+            {
+                const uint32_t           level = selector.select(primitive.lods, primitive.bounds);
+                const Assets::CookedLod& lod = primitive.lods[level];
+                const auto               meshlets = m_file.meshlets(lod);
+                const auto               vertices = m_file.meshletVertices(lod);
+                const auto               triangles = m_file.meshletTriangles(lod);
+                m_lodUsage[level]++;
+
+                m_visible.clear();
+                Assets::cullMeshlets(
+                    meshlets, frustum, { camera.x, camera.y, camera.z }, m_visible, m_statistics);
+                for (const uint32_t index : m_visible)
+                {
+                    const Assets::Meshlet& meshlet = meshlets[index];
+                    const auto             color = meshletColor(colorIndex + index);
+                    const auto             base = static_cast<uint32_t>(m_vertices.size());
+                    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+                    {
+                        const auto& position
+                            = primitive.positions[vertices[meshlet.vertexOffset + i]];
+                        m_vertices.push_back({ .position = { position[0], position[1],
+                                                   position[2], 1.0F },
+                            .color = color });
+                    }
+                    for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++)
+                    {
+                        m_indices.push_back(base + triangles[meshlet.triangleOffset + i]);
+                    }
+                }
+                colorIndex += static_cast<uint32_t>(meshlets.size());
+            }
+        }
+
+        void onFrameRender([[maybe_unused]] const GameTimer& timer) override
+        {
+            if (m_indices.empty())
+            {
+                return;
+            }
+            m_backend.rasterizer().draw({
+                .vertices = m_vertices,
+                .indices32 = m_indices,
+                .instanceTransforms = { &m_transform, 1 },
+            });
+        }
+
+        void printStatistics() const override
+        {
+            const auto percent = [this](const size_t count) {
+                return 100.0 * static_cast<double>(count)
+                    / static_cast<double>(std::max<size_t>(m_statistics.tested, 1));
+            };
+            std::println("{:<12} meshlets tested {}  frustum culled {:.1f}%  cone culled {:.1f}%  "
+                         "visible {:.1f}%",
+                "", m_statistics.tested, percent(m_statistics.frustumRejected),
+                percent(m_statistics.coneRejected), percent(m_statistics.visible()));
+
+            std::string usage;
+            for (size_t level = 0; level < m_lodUsage.size(); level++)
+            {
+                usage += std::format("  LOD {} {}", level, m_lodUsage[level]);
+            }
+            std::println("{:<12} primitive frames by level of detail:{}", "", usage);
+        }
+
+    private:
+        struct MeshletPrimitive
+        {
+            std::vector<std::array<float, 3>>  positions;
+            std::span<const Assets::CookedLod> lods;
+            Assets::LodInstance                bounds; ///< In object space.
+        };
+
+        static Assets::LodInstance bounds(const Assets::CookedPrimitive& primitive)
+        {
+            Assets::LodInstance instance;
+            float               radius = 0.0F;
+            for (size_t axis = 0; axis < 3; axis++)
+            {
+                instance.center[axis]
+                    = (primitive.boundsMin[axis] + primitive.boundsMax[axis]) * 0.5F;
+                const float half = (primitive.boundsMax[axis] - primitive.boundsMin[axis]) * 0.5F;
+                radius += half * half;
+            }
+            instance.radius = std::sqrt(radius);
+            return instance;
+        }
+
+        std::vector<std::array<float, 3>> decodePositions(
+            const Assets::CookedPrimitive& primitive) const
+        {
+            const auto bytes = m_file.stream(primitive, Assets::VertexAttribute::Position);
+            const auto& stream = primitive.stream(Assets::VertexAttribute::Position);
+
+            std::vector<std::array<float, 3>> positions(primitive.vertexCount);
+            for (size_t i = 0; i < positions.size(); i++)
+            {
+                const std::byte* element = bytes.data() + i * stream.stride;
+                if (stream.format == Assets::VertexStreamFormat::UShort4Normalized)
+                {
+                    std::array<uint16_t, 4> encoded {};
+                    std::memcpy(encoded.data(), element, sizeof(encoded));
+                    positions[i] = Assets::dequantizePosition(
+                        encoded, primitive.boundsMin, primitive.boundsMax);
+                }
+                else
+                {
+                    std::memcpy(positions[i].data(), element, sizeof(positions[i]));
+                }
+            }
+            return positions;
+        }
+
+        static std::array<float, 4> meshletColor(const uint32_t index)
+        {
+            const uint32_t hash = index * 2654435761U;
+            const auto     channel = [hash](const uint32_t shift) {
+                return 0.25F + 0.75F * static_cast<float>((hash >> shift) & 0xFF) / 255.0F;
+            };
+            return { channel(0), channel(8), channel(16), 1.0F };
+        }
+
+        Assets::CookedMeshFile        m_file;
+        std::vector<MeshletPrimitive> m_primitives;
+        Vector3                       m_center;
+        float                         m_radius = 1.0F;
+        float                         m_viewportHeight;
+        float                         m_rotationX = 0.0F;
+        float                         m_rotationY = 0.0F;
+        Raster::Matrix4               m_transform {};
+        std::vector<uint32_t>         m_visible;
+        std::vector<Raster::Vertex>   m_vertices;
+        std::vector<uint32_t>         m_indices;
+        Assets::MeshletCullStatistics m_statistics;
+        std::vector<size_t>           m_lodUsage;
+    };
+
+    /// @brief Plays a procedural clip on a crowd of characters: poses are sampled in
+    /// parallel, model and skinning matrices go to a frame arena and the limbs are
+    /// skinned on the CPU with every kernel, drawing the dual quaternion result.
+    class AnimationScene final : public Scene
+    {
+    public:
+        AnimationScene(
+            SoftwareBackend& backend, uint32_t width, uint32_t height, ThreadPool& threadPool)
+            : Scene(backend, width, height)
+            , m_threadPool(threadPool)
+            , m_samplers(s_characterCount)
+            , m_poses(s_characterCount)
+        {
+            const Assets::Scene character = createCharacter();
+            m_skeleton = Animation::buildSkeleton(character, 0);
+            m_clip = Animation::Clip::compress(character.animations.front(), m_skeleton);
+            for (const auto& channel : character.animations.front().channels)
+            {
+                m_rawBytes += (channel.times.size() + channel.values.size()) * sizeof(float);
+            }
+            m_referenceDifference = compareWithReference();
+
+            const CharacterMesh geometry = createCharacterMesh();
+            m_meshes[0] = Animation::SkinnedMesh(
+                geometry.positions, geometry.normals, geometry.joints, geometry.weights, 4);
+            m_meshes[1] = eightInfluences(geometry);
+            for (size_t character = 0; character < s_characterCount; character++)
+            {
+                const auto base = static_cast<uint32_t>(character * geometry.positions.size());
+                for (const uint32_t index : geometry.indices)
+                {
+                    m_indices.push_back(base + index);
+                }
+            }
+            compareSkinning(geometry);
+        }
+
+        void onFrameUpdate(const GameTimer& timer) override
+        {
+            m_time += static_cast<float>(timer.elapsedSeconds());
+            m_arena.reset();
+
+            const size_t jointCount = m_skeleton.jointCount();
+            const size_t skinJointCount = m_skeleton.skinJoints.size();
+            const std::span<Assets::Matrix4> model(
+                m_arena.allocateArray<Assets::Matrix4>(s_characterCount * jointCount),
+                s_characterCount * jointCount);
+            const std::span<Assets::Matrix4> skinning(
+                m_arena.allocateArray<Assets::Matrix4>(s_characterCount * skinJointCount),
+                s_characterCount * skinJointCount);
+
+            const uint64_t start = SDL_GetPerformanceCounter();
+            m_threadPool.parallelFor(
+                s_characterCount, s_characterGrain, [&](const size_t begin, const size_t end) {
+                    for (size_t character = begin; character < end; character++)
+                    {
+                        const float time = std::fmod(m_time + static_cast<float>(character) * 0.37F,
+                            m_clip.duration());
+                        m_samplers[character].sample(m_clip, time, m_poses[character]);
+                    }
+                });
+            const uint64_t sampled = SDL_GetPerformanceCounter();
+            m_threadPool.parallelFor(
+                s_characterCount, s_characterGrain, [&](const size_t begin, const size_t end) {
+                    for (size_t character = begin; character < end; character++)
+                    {
+                        const auto characterModel
+                            = model.subspan(character * jointCount, jointCount);
+                        Animation::computeModelTransforms(
+                            m_skeleton, m_poses[character], characterModel);
+                        Animation::computeSkinningMatrices(m_skeleton, characterModel,
+                            skinning.subspan(character * skinJointCount, skinJointCount));
+                    }
+                });
+            const uint64_t finished = SDL_GetPerformanceCounter();
+
+            const auto frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+            m_sampleSeconds += static_cast<double>(sampled - start) / frequency;
+            m_hierarchySeconds += static_cast<double>(finished - sampled) / frequency;
+            m_frames++;
+
+            // Every kernel writes the same buffers, which an upload allocation would
+            // replace; the dual quaternion pass over four influences runs last and is
+            // the one drawn
+            const size_t vertexCount = m_meshes[0].vertexCount();
+            const size_t totalVertices = s_characterCount * vertexCount;
+            const std::span<std::array<float, 3>> positions(
+                m_arena.allocateArray<std::array<float, 3>>(totalVertices), totalVertices);
+            const std::span<std::array<float, 3>> normals(
+                m_arena.allocateArray<std::array<float, 3>>(totalVertices), totalVertices);
+            for (size_t layout = m_meshes.size(); layout-- > 0;)
+            {
+                for (const auto method : { Animation::SkinningMethod::LinearBlend,
+                         Animation::SkinningMethod::DualQuaternion })
+                {
+                    const uint64_t skinStart = SDL_GetPerformanceCounter();
+                    m_threadPool.parallelFor(s_characterCount, s_characterGrain,
+                        [&](const size_t begin, const size_t end) {
+                            for (size_t character = begin; character < end; character++)
+                            {
+                                Animation::skinVertices(m_meshes[layout], method,
+                                    skinning.subspan(character * skinJointCount, skinJointCount),
+                                    positions.subspan(character * vertexCount, vertexCount),
+                                    normals.subspan(character * vertexCount, vertexCount), 0,
+                                    vertexCount);
+                            }
+                        });
+                    m_skinningSeconds[layout][static_cast<size_t>(method)]
+                        += static_cast<double>(SDL_GetPerformanceCounter() - skinStart) / frequency;
+                }
+            }
+
+            buildVertices(positions, normals);
+            m_transform = toRaster(m_camera.uniforms().viewProjection);
+        }
+
+        void onFrameRender([[maybe_unused]] const GameTimer& timer) override
+        {
+            m_backend.rasterizer().draw({
+                .vertices = m_vertices,
+                .indices32 = m_indices,
+                .instanceTransforms = { &m_transform, 1 },
+            });
+        }
+
+        void printStatistics() const override
+        {
+            const double joints = static_cast<double>(m_frames * s_characterCount)
+                * static_cast<double>(m_skeleton.jointCount());
+            const auto perMillisecond = [joints](const double seconds) {
+                return seconds > 0.0 ? joints / (seconds * 1000.0) : 0.0;
+            };
+            std::println("{:<12} {} characters x {} joints  sampling {:.0f} joints/ms  "
+                         "hierarchy and skinning {:.0f} joints/ms",
+                "", s_characterCount, m_skeleton.jointCount(), perMillisecond(m_sampleSeconds),
+                perMillisecond(m_hierarchySeconds));
+            std::println("{:<12} clip {} keys  {} bytes ({} uncompressed)  batched vs scalar "
+                         "sampling max difference {:.2g}",
+                "", m_clip.keyCount(), m_clip.sizeBytes(), m_rawBytes, m_referenceDifference);
+
+            const double vertices = static_cast<double>(m_frames * s_characterCount)
+                * static_cast<double>(m_meshes[0].vertexCount());
+            const auto millionsPerSecond = [vertices](const double seconds) {
+                return seconds > 0.0 ? vertices / (seconds * 1.0e6) : 0.0;
+            };
+            for (size_t layout = 0; layout < m_meshes.size(); layout++)
+            {
+                std::println("{:<12} skinning {} influences  linear blend {:.1f} M vertices/s  "
+                             "dual quaternion {:.1f} M vertices/s",
+                    "", m_meshes[layout].influencesPerVertex(),
+                    millionsPerSecond(m_skinningSeconds[layout][0]),
+                    millionsPerSecond(m_skinningSeconds[layout][1]));
+            }
+            std::println("{:<12} skinning max difference: rigid linear blend vs dual quaternion "
+                         "{:.2g}  4 vs 8 influences {:.2g}  blended linear vs dual quaternion "
+                         "{:.2g}",
+                "", m_rigidDifference, m_influenceDifference, m_methodDifference);
+        }
+
+    private:
+        static constexpr size_t s_characterCount = 256;
+        static constexpr size_t s_characterGrain = 16;
+        static constexpr size_t s_gridColumns = 16;
+        static constexpr size_t s_limbCount = 7;
+        static constexpr size_t s_limbJoints = 9;
+        static constexpr float  s_boneLength = 0.08F;
+        static constexpr float  s_depth = -20.0F;
+
+        static constexpr std::array<std::array<float, 2>, s_limbCount> s_limbDirections {
+            { { 0.0F, 1.0F }, { -0.8F, 0.6F }, { 0.8F, 0.6F }, { -1.0F, -0.2F }, { 1.0F, -0.2F },
+                { -0.3F, -1.0F }, { 0.3F, -1.0F } }
+        };
+
+        /// Bind pose geometry of one character, with four influences per vertex as in
+        /// glTF.
+        struct CharacterMesh
+        {
+            std::vector<std::array<float, 3>> positions;
+            std::vector<std::array<float, 3>> normals;
+            std::vector<uint16_t>             joints;
+            std::vector<float>                weights;
+            std::vector<uint32_t>             indices;
+        };
+
+        /// Builds a root with seven limbs of nine joints, 64 in all, that wave for two
+        /// seconds while the root bobs.
+        static Assets::Scene createCharacter()
+        {
+            constexpr float duration = 2.0F;
+            constexpr int   keyCount = 61;
+
+            Assets::Scene     scene;
+            Assets::Skin      skin;
+            Assets::Animation animation { .name = "wave", .duration = duration };
+            const auto addJoint = [&](const int32_t parent, const std::array<float, 3>& offset,
+                                      const std::array<float, 3>& bindPosition) {
+                const auto index = static_cast<int32_t>(scene.nodes.size());
+                Assets::Node node { .parent = parent, .translation = offset };
+                node.localTransform = translation(offset);
+                if (parent >= 0)
+                {
+                    scene.nodes[parent].children.push_back(index);
+                }
+                scene.nodes.push_back(std::move(node));
+
+                const Assets::Matrix4 inverseBind = translation(
+                    { -bindPosition[0], -bindPosition[1], -bindPosition[2] });
+                skin.joints.push_back(index);
+                skin.inverseBindMatrices.push_back(inverseBind);
+                return index;
+            };
+
+            addJoint(-1, {}, {});
+            scene.rootNodes.push_back(0);
+            Assets::AnimationChannel bob { .node = 0, .path = Assets::AnimationPath::Translation };
+            for (int key = 0; key < keyCount; key++)
+            {
+                const float time = duration * static_cast<float>(key) / (keyCount - 1);
+                bob.times.push_back(time);
+                bob.values.insert(bob.values.end(),
+                    { 0.0F, 0.05F * std::sin(time * std::numbers::pi_v<float>), 0.0F });
+            }
+            animation.channels.push_back(std::move(bob));
+
+            for (size_t limb = 0; limb < s_limbCount; limb++)
+            {
+                const auto& direction = s_limbDirections[limb];
+                int32_t     parent = 0;
+                for (size_t segment = 0; segment < s_limbJoints; segment++)
+                {
+                    const float reach = s_boneLength * static_cast<float>(segment + 1);
+                    parent = addJoint(parent,
+                        { direction[0] * s_boneLength, direction[1] * s_boneLength, 0.0F },
+                        { direction[0] * reach, direction[1] * reach, 0.0F });
+
+                    // Swing about the view axis, each joint a little behind its parent
+                    Assets::AnimationChannel swing { .node = parent,
+                        .path = Assets::AnimationPath::Rotation };
+                    const float phase = static_cast<float>(segment) * 0.4F
+                        + static_cast<float>(limb) * 0.9F;
+                    for (int key = 0; key < keyCount; key++)
+                    {
+                        const float time = duration * static_cast<float>(key) / (keyCount - 1);
+                        const float angle = 0.25F
+                            * std::sin(time * std::numbers::pi_v<float> * 2.0F / duration + phase);
+                        swing.times.push_back(time);
+                        swing.values.insert(swing.values.end(),
+                            { 0.0F, 0.0F, std::sin(angle * 0.5F), std::cos(angle * 0.5F) });
+                    }
+                    animation.channels.push_back(std::move(swing));
+                }
+            }
+
+            scene.skins.push_back(std::move(skin));
+            scene.animations.push_back(std::move(animation));
+            return scene;
+        }
+
+        static Assets::Matrix4 translation(const std::array<float, 3>& offset)
+        {
+            Assets::Matrix4 matrix {};
+            matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0F;
+            std::copy(offset.begin(), offset.end(), matrix.begin() + 12);
+            return matrix;
+        }
+
+        /// Largest difference between the batched sampler and the scalar reference.
+        [[nodiscard]] float compareWithReference() const
+        {
+            Animation::ClipSampler sampler;
+            Animation::Pose        pose;
+            float                  difference = 0.0F;
+            for (int step = 0; step <= 120; step++)
+            {
+                const float time = m_clip.duration() * static_cast<float>(step) / 120.0F;
+                sampler.sample(m_clip, time, pose);
+                for (size_t joint = 0; joint < m_clip.jointCount(); joint++)
+                {
+                    const Animation::Transform expected = m_clip.sampleJoint(joint, time);
+                    const Animation::Transform actual = pose.joint(joint);
+                    for (size_t i = 0; i < 3; i++)
+                    {
+                        difference = std::max({ difference,
+                            std::abs(actual.translation[i] - expected.translation[i]),
+                            std::abs(actual.scale[i] - expected.scale[i]) });
+                    }
+                    for (size_t i = 0; i < 4; i++)
+                    {
+                        difference = std::max(
+                            difference, std::abs(actual.rotation[i] - expected.rotation[i]));
+                    }
+                }
+            }
+            return difference;
+        }
+
+        /// Wraps every limb in a tube. Each ring sits on a joint and blends it with its
+        /// parent evenly, so bends stay smooth.
+        static CharacterMesh createCharacterMesh()
+        {
+            constexpr uint32_t ringVertices = 6;
+            constexpr float    radius = 0.03F;
+
+            CharacterMesh mesh;
+            for (size_t limb = 0; limb < s_limbCount; limb++)
+            {
+                const auto& direction = s_limbDirections[limb];
+                const float length = std::hypot(direction[0], direction[1]);
+                const auto  base = static_cast<uint32_t>(mesh.positions.size());
+                for (size_t ring = 0; ring <= s_limbJoints; ring++)
+                {
+                    // Ring 0 is on the root, ring r on the limb's r-th joint
+                    const auto  joint = static_cast<uint16_t>(
+                        ring == 0 ? 0 : 1 + limb * s_limbJoints + ring - 1);
+                    const auto  parent = static_cast<uint16_t>(ring <= 1 ? 0 : joint - 1);
+                    const float reach = s_boneLength * static_cast<float>(ring);
+                    for (uint32_t i = 0; i < ringVertices; i++)
+                    {
+                        const float angle = 2.0F * std::numbers::pi_v<float>
+                            * static_cast<float>(i) / static_cast<float>(ringVertices);
+                        const std::array normal { -direction[1] / length * std::cos(angle),
+                            direction[0] / length * std::cos(angle), std::sin(angle) };
+                        mesh.positions.push_back({ direction[0] * reach + normal[0] * radius,
+                            direction[1] * reach + normal[1] * radius, normal[2] * radius });
+                        mesh.normals.push_back(normal);
+                        mesh.joints.insert(mesh.joints.end(), { joint, parent, 0, 0 });
+                        mesh.weights.insert(mesh.weights.end(),
+                            { ring == 0 ? 1.0F : 0.5F, ring == 0 ? 0.0F : 0.5F, 0.0F, 0.0F });
+                    }
+                }
+                for (uint32_t ring = 0; ring < s_limbJoints; ring++)
+                {
+                    for (uint32_t i = 0; i < ringVertices; i++)
+                    {
+                        const uint32_t a = base + ring * ringVertices + i;
+                        const uint32_t b = base + ring * ringVertices + (i + 1) % ringVertices;
+                        mesh.indices.insert(mesh.indices.end(),
+                            { a, b, a + ringVertices, b, b + ringVertices, a + ringVertices });
+                    }
+                }
+            }
+            return mesh;
+        }
+
+        /// Spreads every influence over two joints of half the weight, which must skin
+        /// to the same result.
+        static Animation::SkinnedMesh eightInfluences(const CharacterMesh& geometry)
+        {
+            std::vector<uint16_t> joints;
+            std::vector<float>    weights;
+            for (size_t i = 0; i < geometry.joints.size(); i++)
+            {
+                const float half = geometry.weights[i] * 0.5F;
+                joints.insert(joints.end(), { geometry.joints[i], geometry.joints[i] });
+                weights.insert(weights.end(), { half, half });
+            }
+            return { geometry.positions, geometry.normals, joints, weights, 8 };
+        }
+
+        /// Skins one posed character with every kernel. Rigidly attached vertices must
+        /// match between methods, and the eight influence layout must match four.
+        void compareSkinning(const CharacterMesh& geometry)
+        {
+            Animation::ClipSampler sampler;
+            Animation::Pose        pose;
+            sampler.sample(m_clip, m_clip.duration() * 0.35F, pose);
+            std::vector<Assets::Matrix4> model(m_skeleton.jointCount());
+            std::vector<Assets::Matrix4> skinning(m_skeleton.skinJoints.size());
+            Animation::computeModelTransforms(m_skeleton, pose, model);
+            Animation::computeSkinningMatrices(m_skeleton, model, skinning);
+
+            const size_t vertexCount = geometry.positions.size();
+            const auto   skin = [&](const Animation::SkinnedMesh& mesh,
+                                  const Animation::SkinningMethod method) {
+                std::vector<std::array<float, 3>> positions(vertexCount);
+                std::vector<std::array<float, 3>> normals(vertexCount);
+                Animation::skinVertices(mesh, method, skinning, positions, normals, 0, vertexCount);
+                return positions;
+            };
+            const auto difference = [](const std::vector<std::array<float, 3>>& a,
+                                        const std::vector<std::array<float, 3>>& b) {
+                float result = 0.0F;
+                for (size_t i = 0; i < a.size(); i++)
+                {
+                    for (size_t axis = 0; axis < 3; axis++)
+                    {
+                        result = std::max(result, std::abs(a[i][axis] - b[i][axis]));
+                    }
+                }
+                return result;
+            };
+
+            std::vector<float> rigidWeights(geometry.weights.size(), 0.0F);
+            for (size_t i = 0; i < rigidWeights.size(); i += 4)
+            {
+                rigidWeights[i] = 1.0F;
+            }
+            const Animation::SkinnedMesh rigid(
+                geometry.positions, geometry.normals, geometry.joints, rigidWeights, 4);
+            constexpr auto linear = Animation::SkinningMethod::LinearBlend;
+            constexpr auto dual = Animation::SkinningMethod::DualQuaternion;
+            m_rigidDifference = difference(skin(rigid, linear), skin(rigid, dual));
+            m_influenceDifference = std::max(
+                difference(skin(m_meshes[0], linear), skin(m_meshes[1], linear)),
+                difference(skin(m_meshes[0], dual), skin(m_meshes[1], dual)));
+            m_methodDifference = difference(skin(m_meshes[0], linear), skin(m_meshes[0], dual));
+        }
+
+        /// Places every character on the grid, shading by normal.
+        void buildVertices(const std::span<const std::array<float, 3>> positions,
+            const std::span<const std::array<float, 3>> normals)
+        {
+            constexpr float spacing = 1.6F;
+
+            const size_t vertexCount = m_meshes[0].vertexCount();
+            const size_t rowCount = s_characterCount / s_gridColumns;
+            m_vertices.resize(positions.size());
+            for (size_t character = 0; character < s_characterCount; character++)
+            {
+                const auto  column = static_cast<float>(character % s_gridColumns);
+                const auto  row = static_cast<float>(character / s_gridColumns);
+                const float originX
+                    = (column - static_cast<float>(s_gridColumns - 1) * 0.5F) * spacing;
+                const float originY = (row - static_cast<float>(rowCount - 1) * 0.5F) * spacing;
+                for (size_t i = character * vertexCount; i < (character + 1) * vertexCount; i++)
+                {
+                    const auto& position = positions[i];
+                    const float light = 0.35F + 0.65F * std::max(normals[i][2], 0.0F);
+                    m_vertices[i] = { .position = { originX + position[0], originY + position[1],
+                                          s_depth + position[2], 1.0F },
+                        .color = { light * (0.4F + 0.6F * column / s_gridColumns), light * 0.8F,
+                            light * (0.4F + 0.6F * row / static_cast<float>(rowCount)), 1.0F } };
+                }
+            }
+        }
+
+        ThreadPool&                           m_threadPool;
+        Animation::Skeleton                   m_skeleton;
+        Animation::Clip                       m_clip;
+        std::vector<Animation::ClipSampler>   m_samplers; ///< One per character.
+        std::vector<Animation::Pose>          m_poses;
+        FrameArena                            m_arena;
+        float                                 m_time = 0.0F;
+        size_t                                m_rawBytes = 0;
+        float                                 m_referenceDifference = 0.0F;
+        std::array<Animation::SkinnedMesh, 2> m_meshes; ///< Four and eight influences.
+        float                                 m_rigidDifference = 0.0F;
+        float                                 m_influenceDifference = 0.0F;
+        float                                 m_methodDifference = 0.0F;
+        uint64_t                              m_frames = 0;
+        double                                m_sampleSeconds = 0.0;
+        double                                m_hierarchySeconds = 0.0;
+        /// By influence layout, then method.
+        std::array<std::array<double, 2>, 2> m_skinningSeconds {};
+        Raster::Matrix4                      m_transform {};
+        std::vector<Raster::Vertex>          m_vertices;
+        std::vector<uint32_t>                m_indices;
+    };
+
+    /// @brief A wall of cubes drawn through the render queue, with the batches encoded
+    /// into one recording command buffer per thread and replayed in commit order, the
+    /// way the Metal examples commit a frame's parallel encoded buffers together.
+    class EncodingScene final : public Scene
+    {
+    public:
+        EncodingScene(
+            SoftwareBackend& backend, uint32_t width, uint32_t height, ThreadPool& threadPool)
+            : Scene(backend, width, height)
+            , m_threadPool(threadPool)
+            , m_encoder(createBackend(), backend.bufferCount(), threadPool)
+            , m_transforms(s_columns * s_rows)
+        {
+            for (uint32_t material = 0; material < s_materialCount; material++)
+            {
+                // A spread of tints, so neighbouring materials are easy to tell apart
+                const std::array<float, 3> tint {
+                    0.3F + 0.7F * static_cast<float>((material * 5) % 8) / 7.0F,
+                    0.3F + 0.7F * static_cast<float>((material * 3) % 8) / 7.0F,
+                    0.3F + 0.7F * static_cast<float>(material / 8) / 3.0F,
+                };
+                auto& vertices = m_materialVertices[material];
+                for (size_t i = 0; i < vertices.size(); i++)
+                {
+                    vertices[i] = g_cubeVertices[i];
+                    for (size_t channel = 0; channel < tint.size(); channel++)
+                    {
+                        vertices[i].color[channel]
+                            = tint[channel] * (0.4F + 0.6F * vertices[i].color[channel]);
+                    }
+                }
+            }
+        }
+
+        void onFrameUpdate(const GameTimer& timer) override
+        {
+            m_time += static_cast<float>(timer.elapsedSeconds());
+
+            const Matrix viewProjection = m_camera.uniforms().viewProjection;
+            m_queue.clear();
+            std::span<Render::SortKey> keys;
+            std::span<uint32_t>        instances;
+            m_queue.append(m_transforms.size(), keys, instances);
+            m_threadPool.parallelFor(
+                m_transforms.size(), s_cubeGrain, [&](const size_t begin, const size_t end) {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        const auto column = static_cast<uint32_t>(i % s_columns);
+                        const auto row = static_cast<uint32_t>(i / s_columns);
+                        const float x = (static_cast<float>(column) - s_columns / 2.0F) * 3.0F;
+                        const float y = (static_cast<float>(row) - s_rows / 2.0F) * 3.0F;
+                        const float z = -70.0F + 8.0F * std::sin(0.15F * (x + y) + m_time);
+                        const Matrix model = modelMatrix(
+                            Vector3(x, y, z), m_time + 0.1F * x, m_time + 0.1F * y, 1.0F);
+                        m_transforms[i] = toRaster(model * viewProjection);
+
+                        // Blocks of 6x6 cubes share a material
+                        const Render::DrawState state {
+                            .material = (column / 6 + row / 6 * 8) % s_materialCount,
+                        };
+                        keys[i] = Render::makeSortKey(state, -z / 100.0F);
+                        instances[i] = static_cast<uint32_t>(i);
+                    }
+                });
+
+            const std::span<const Render::Batch> batches = m_queue.build(&m_threadPool);
+            const std::span<const uint32_t>      sorted = m_queue.instances();
+            m_sortedTransforms.resize(sorted.size());
+            for (size_t i = 0; i < sorted.size(); i++)
+            {
+                m_sortedTransforms[i] = m_transforms[sorted[i]];
+            }
+
+            const uint64_t start = SDL_GetPerformanceCounter();
+            m_encoder.beginFrame(m_backend.frameIndex());
+            const auto partitions = partitionItems(batches.size(), m_threadPool.threadCount());
+            m_encoder.encode(partitions,
+                [&](RecordingCommandBuffer& commandBuffer, const EncodePartition& partition) {
+                    encodeBatches(commandBuffer,
+                        batches.subspan(partition.begin, partition.end - partition.begin));
+                });
+            const uint64_t finished = SDL_GetPerformanceCounter();
+            m_encodeSeconds += static_cast<double>(finished - start)
+                / static_cast<double>(SDL_GetPerformanceFrequency());
+            m_commandBufferCount += m_encoder.commandBuffers().size();
+            m_frames++;
+
+            if (m_frames == 1)
+            {
+                m_matchesSerial = compareWithSerial(batches);
+            }
+        }
+
+        void onFrameRender([[maybe_unused]] const GameTimer& timer) override
+        {
+            // Bindings carry over from one buffer to the next, as they would in one
+            // pass suspended and resumed across the buffers
+            uint32_t material = 0;
+            for (const RecordingCommandBuffer& commandBuffer : m_encoder.commandBuffers())
+            {
+                for (const RecordedCommand& command : commandBuffer.commands())
+                {
+                    switch (command.type)
+                    {
+                    case RecordedCommand::Type::SetPipeline:
+                        break;
+                    case RecordedCommand::Type::SetMaterial:
+                        m_redundantBinds += command.arguments[0] == material ? 1 : 0;
+                        material = command.arguments[0];
+                        break;
+                    case RecordedCommand::Type::Draw:
+                        m_backend.rasterizer().draw({
+                            .vertices = m_materialVertices[material],
+                            .indices16 = g_cubeIndices,
+                            .instanceTransforms = std::span<const Raster::Matrix4>(
+                                m_sortedTransforms)
+                                .subspan(command.arguments[1], command.arguments[2]),
+                        });
+                        break;
+                    }
+                }
+            }
+        }
+
+        void printStatistics() const override
+        {
+            const auto frames = static_cast<double>(std::max<uint64_t>(m_frames, 1));
+            std::println("{:<12} {} cubes in {} batches  {:.1f} command buffers/frame  encode "
+                         "{:.3f} ms/frame  redundant binds {}",
+                "", m_transforms.size(), m_queue.batches().size(),
+                static_cast<double>(m_commandBufferCount) / frames,
+                m_encodeSeconds * 1000.0 / frames, m_redundantBinds);
+            std::println("{:<12} parallel encode {} the serial encode", "",
+                m_matchesSerial ? "matches" : "DIFFERS FROM");
+        }
+
+    private:
+        using Encoder
+            = ParallelEncoder<RecordingCommandBuffer, std::unique_ptr<RecordingAllocator>>;
+
+        static constexpr uint32_t s_columns = 48;
+        static constexpr uint32_t s_rows = 27;
+        static constexpr uint32_t s_materialCount = 32;
+        static constexpr size_t   s_cubeGrain = 256;
+
+        static Encoder::Backend createBackend()
+        {
+            return {
+                .createAllocator = [] { return std::make_unique<RecordingAllocator>(); },
+                .resetAllocator = [](std::unique_ptr<RecordingAllocator>& allocator) {
+                    allocator->reset();
+                },
+                .createCommandBuffer = [] { return RecordingCommandBuffer {}; },
+                .beginCommandBuffer =
+                    [](RecordingCommandBuffer&            commandBuffer,
+                        std::unique_ptr<RecordingAllocator>& allocator) {
+                        commandBuffer.begin(*allocator);
+                    },
+                .endCommandBuffer = [](RecordingCommandBuffer& commandBuffer) {
+                    commandBuffer.end();
+                },
+            };
+        }
+
+        /// The draws the commands amount to, with the state bound at each one.
+        static void resolveDraws(std::span<const RecordedCommand> commands,
+            RecordedCommand&                                      bound,
+            std::vector<std::array<uint32_t, 5>>&                 draws)
+        {
+            for (const RecordedCommand& command : commands)
+            {
+                switch (command.type)
+                {
+                case RecordedCommand::Type::SetPipeline:
+                    bound.arguments[0] = command.arguments[0];
+                    break;
+                case RecordedCommand::Type::SetMaterial:
+                    bound.arguments[1] = command.arguments[0];
+                    break;
+                case RecordedCommand::Type::Draw:
+                    draws.push_back({ bound.arguments[0], bound.arguments[1], command.arguments[0],
+                        command.arguments[1], command.arguments[2] });
+                    break;
+                }
+            }
+        }
+
+        /// Encodes the batches into a single buffer and checks that the parallel
+        /// buffers, replayed in order, draw the same.
+        [[nodiscard]] bool compareWithSerial(std::span<const Render::Batch> batches)
+        {
+            RecordingAllocator     allocator;
+            RecordingCommandBuffer serial;
+            serial.begin(allocator);
+            encodeBatches(serial, batches);
+            serial.end();
+
+            RecordedCommand                      bound;
+            std::vector<std::array<uint32_t, 5>> expected;
+            resolveDraws(serial.commands(), bound, expected);
+
+            bound = {};
+            std::vector<std::array<uint32_t, 5>> parallel;
+            for (const RecordingCommandBuffer& commandBuffer : m_encoder.commandBuffers())
+            {
+                resolveDraws(commandBuffer.commands(), bound, parallel);
+            }
+            return parallel == expected;
+        }
+
+        ThreadPool&                  m_threadPool;
+        Encoder                      m_encoder;
+        Render::RenderQueue          m_queue;
+        std::vector<Raster::Matrix4> m_transforms;
+        std::vector<Raster::Matrix4> m_sortedTransforms;
+        std::array<std::array<Raster::Vertex, g_cubeVertices.size()>, s_materialCount>
+                 m_materialVertices {};
+        float    m_time = 0.0F;
+        uint64_t m_frames = 0;
+        double   m_encodeSeconds = 0.0;
+        size_t   m_commandBufferCount = 0;
+        size_t   m_redundantBinds = 0;
+        bool     m_matchesSerial = false;
+    };
+
+    void printUsage()
+    {
+        std::println("usage: headless [options]");
+        std::println("");
+        std::println("Renders the example scenes with the software rasterizer and writes the");
+        std::println("last frame of each scene as <scene>.ppm.");
+        std::println("");
+        std::println("options:");
+        std::println("  --scene <name>          helloworld, instancing, textures, meshlets,");
+        std::println("                          animation, encoding or all (default all, which");
+        std::println("                          skips meshlets, animation and encoding)");
+        std::println("  --frames <n>            Frames to simulate at 60 Hz (default 60)");
+        std::println("  --width <pixels>        Render target width (default 1280)");
+        std::println("  --height <pixels>       Render target height (default 720)");
+        std::println("  --threads <n>           Rasterizer threads, 0 for all cores (default 0)");
+        std::println("  --frames-in-flight <n>  Frames recorded ahead of the GPU, 1-4 (default 3)");
+        std::println("  --low-latency           Sample input after waiting on the GPU");
+        std::println("  --gpu-time <ms>         Simulated GPU time per frame (default 0)");
+        std::println("  --cpu-time <ms>         Simulated recording time per frame (default 0)");
+        std::println("  --simulation-thread     Simulate instancing on a fixed rate thread");
+        std::println("  --output <dir>          Directory for the images (default .)");
+        std::println("  --assets <dir>          Asset directory (default {})", ASSET_DIRECTORY);
+        std::println("  --mesh <file>           Cooked mesh with meshlets for the meshlets scene");
+    }
+
+    uint64_t parseIntegerArgument(std::string_view option, std::string_view value)
+    {
+        uint64_t    result = 0;
+        const char* last = value.data() + value.size();
+        const auto [end, error] = std::from_chars(value.data(), last, result);
+        if (error != std::errc() || end != last)
+        {
+            throw std::runtime_error(std::format("Invalid value '{}' for {}", value, option));
+        }
+        return result;
+    }
+
+    double parseMillisecondsArgument(std::string_view option, std::string_view value)
+    {
+        double      result = 0.0;
+        const char* last = value.data() + value.size();
+        const auto [end, error] = std::from_chars(value.data(), last, result);
+        if (error != std::errc() || end != last || result < 0.0)
+        {
+            throw std::runtime_error(std::format("Invalid value '{}' for {}", value, option));
+        }
+        return result / 1000.0;
+    }
+
+    Options parseOptions(int argc, char** argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view argument = argv[i];
+            const auto             next = [&]() -> const char* {
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(std::format("Missing value for {}", argument));
+                }
+                return argv[++i];
+            };
+
+            if (argument == "--help" || argument == "-h")
+            {
+                printUsage();
+                std::exit(EXIT_SUCCESS);
+            }
+            else if (argument == "--scene")
+            {
+                options.scene = next();
+            }
+            else if (argument == "--frames")
+            {
+                options.frames = std::max<uint64_t>(1, parseIntegerArgument(argument, next()));
+            }
+            else if (argument == "--width")
+            {
+                options.width = static_cast<uint32_t>(parseIntegerArgument(argument, next()));
+            }
+            else if (argument == "--height")
+            {
+                options.height = static_cast<uint32_t>(parseIntegerArgument(argument, next()));
+            }
+            else if (argument == "--threads")
+            {
+                options.threads = static_cast<uint32_t>(parseIntegerArgument(argument, next()));
+            }
+            else if (argument == "--frames-in-flight")
+            {
+                options.framesInFlight
+                    = static_cast<uint32_t>(parseIntegerArgument(argument, next()));
+            }
+            else if (argument == "--low-latency")
+            {
+                options.latencyMode = LatencyMode::LowLatency;
+            }
+            else if (argument == "--gpu-time")
+            {
+                options.gpuFrameTime = parseMillisecondsArgument(argument, next());
+            }
+            else if (argument == "--cpu-time")
+            {
+                options.cpuFrameTime = parseMillisecondsArgument(argument, next());
+            }
+            else if (argument == "--simulation-thread")
+            {
+                options.simulationThread = true;
+            }
+            else if (argument == "--output")
+            {
+                options.outputDirectory = next();
+            }
+            else if (argument == "--assets")
+            {
+                options.assetDirectory = next();
+            }
+            else if (argument == "--mesh")
+            {
+                options.meshPath = next();
+            }
+            else
+            {
+                throw std::runtime_error(std::format("Unknown option {}", argument));
+            }
+        }
+
+        if (options.width == 0 || options.height == 0)
+        {
+            throw std::runtime_error("Width and height must be non-zero");
+        }
+        return options;
+    }
+
+    std::unique_ptr<Scene> createScene(std::string_view name,
+        SoftwareBackend&                                 backend,
+        ThreadPool&                                      threadPool,
+        const Options&                                   options)
+    {
+        if (name == "helloworld")
+        {
+            return std::make_unique<HelloWorldScene>(backend, options.width, options.height);
+        }
+        if (name == "instancing")
+        {
+            return std::make_unique<InstancingScene>(
+                backend, options.width, options.height, threadPool, options.simulationThread);
+        }
+        if (name == "textures")
+        {
+            return std::make_unique<TexturesScene>(
+                backend, options.width, options.height, options.assetDirectory);
+        }
+        if (name == "meshlets")
+        {
+            if (options.meshPath.empty())
+            {
+                throw std::runtime_error("The meshlets scene needs a cooked mesh, see --mesh");
+            }
+            return std::make_unique<MeshletScene>(
+                backend, options.width, options.height, options.meshPath);
+        }
+        if (name == "animation")
+        {
+            return std::make_unique<AnimationScene>(
+                backend, options.width, options.height, threadPool);
+        }
+        if (name == "encoding")
+        {
+            return std::make_unique<EncodingScene>(
+                backend, options.width, options.height, threadPool);
+        }
+        throw std::runtime_error(std::format("Unknown scene '{}'", name));
+    }
+
+    void renderScene(std::string_view name, ThreadPool& threadPool, const Options& options)
+    {
+        // Frame pacing runs on a simulated clock, so the latency figures reflect the
+        // configured GPU and CPU costs rather than the speed of the rasterizer.
+        const NullBackend::Options backendOptions {
+            .bufferCount = 4,
+            .pacing = NullBackend::Pacing::Simulated,
+            .gpuFrameTime = options.gpuFrameTime,
+            .cpuFrameTime = options.cpuFrameTime,
+        };
+        auto backend = std::make_unique<SoftwareBackend>(
+            backendOptions, options.width, options.height, threadPool);
+        SoftwareBackend& softwareBackend = *backend;
+
+        const auto     scene = createScene(name, softwareBackend, threadPool, options);
+        HeadlessRunner runner(*scene, std::move(backend));
+        runner.frameLoop().setFramesInFlight(options.framesInFlight);
+        runner.frameLoop().setLatencyMode(options.latencyMode);
+        const auto statistics = runner.run(options.frames);
+
+        const auto path = options.outputDirectory / std::format("{}.ppm", name);
+        softwareBackend.image().writePpm(path);
+
+        const double rasterSeconds = softwareBackend.rasterSeconds();
+        const double trianglesPerSecond = rasterSeconds > 0.0
+            ? static_cast<double>(softwareBackend.trianglesRasterized()) / rasterSeconds
+            : 0.0;
+        std::println("{:<12} {} frames  {:8.3f} ms/frame  {:10.0f} triangles/s  -> {}", name,
+            statistics.frames, statistics.meanFrameSeconds * 1000.0, trianglesPerSecond,
+            path.string());
+
+        const FrameLatencyStatistics& latency = runner.frameLoop().statistics();
+        std::println("{:<12} cpu wait {:.2f} ms (max {:.2f})  input to submit {:.2f} ms (max "
+                     "{:.2f})  wait timeouts {}",
+            "", latency.cpuWait.mean() * 1000.0, latency.cpuWait.max * 1000.0,
+            latency.inputToSubmit.mean() * 1000.0, latency.inputToSubmit.max * 1000.0,
+            latency.waitTimeouts);
+        scene->printStatistics();
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const Options options = parseOptions(argc, argv);
+        std::filesystem::create_directories(options.outputDirectory);
+
+        ThreadPool threadPool(options.threads);
+        std::println("Rendering {}x{} with {} threads", options.width, options.height,
+            threadPool.threadCount());
+
+        if (options.scene == "all")
+        {
+            for (const auto* name : { "helloworld", "instancing", "textures" })
+            {
+                renderScene(name, threadPool, options);
+            }
+        }
+        else
+        {
+            renderScene(options.scene, threadPool, options);
+        }
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::println("Error: {}", e.what());
+        return EXIT_FAILURE;
+    }
+}
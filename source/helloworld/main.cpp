@@ -6,13 +6,13 @@
 #include <format>
 #include <memory>
 #include <print>
-#include <ranges>
 #include <utility>
 
 #include <Metal/Metal.hpp>
 
 #include "Camera.hpp"
 #include "Example.hpp"
+#include "ShaderLayouts.hpp"
 
 #define SDL_MAIN_USE_CALLBACKS 1
 #include <SDL3/SDL_main.h>
@@ -29,7 +29,8 @@ XM_ALIGNED_STRUCT(16) Uniforms
 {
     [[maybe_unused]] Matrix modelViewProjection;
 };
-constexpr size_t g_alignedUniformSize = sizeof(Uniforms) + 0xFF & -0x100;
+
+SHADER_LAYOUT_CHECKS(Triangle);
 
 class HelloWorld final : public Example
 {
@@ -57,16 +58,15 @@ private:
 
     void createPipelineState();
 
-    void updateUniforms() const;
+    void updateUniforms();
 
-    NS::SharedPtr<MTL::RenderPipelineState>               m_pipelineState;
-    NS::SharedPtr<MTL::Buffer>                            m_vertexBuffer;
-    NS::SharedPtr<MTL::Buffer>                            m_indexBuffer;
-    NS::SharedPtr<MTL4::ArgumentTable>                    m_argumentTable;
-    NS::SharedPtr<MTL::ResidencySet>                      m_residencySet;
-    std::array<NS::SharedPtr<MTL::Buffer>, s_bufferCount> m_uniformBuffer;
-    std::unique_ptr<Camera>                               m_mainCamera;
-    float                                                 m_rotationY = 0.0F;
+    RenderPipelineHandle               m_pipeline;
+    NS::SharedPtr<MTL::Buffer>         m_vertexBuffer;
+    NS::SharedPtr<MTL::Buffer>         m_indexBuffer;
+    NS::SharedPtr<MTL4::ArgumentTable> m_argumentTable;
+    NS::SharedPtr<MTL::ResidencySet>   m_residencySet;
+    std::unique_ptr<Camera>            m_mainCamera;
+    float                              m_rotationY = 0.0F;
 };
 
 HelloWorld::HelloWorld()
@@ -113,15 +113,22 @@ void HelloWorld::onRender(CA::MetalDrawable* drawable,
     [[maybe_unused]] const GameTimer&        timer)
 {
 
-    NS::SharedPtr<MTL4::RenderPassDescriptor> passDescriptor
-        = NS::TransferPtr(defaultRenderPassDescriptor(drawable));
+    MTL4::RenderPassDescriptor* passDescriptor = defaultRenderPassDescriptor(drawable);
 
     MTL4::RenderCommandEncoder* commandEncoder
-        = commandBuffer->renderCommandEncoder(passDescriptor.get());
+        = commandBuffer->renderCommandEncoder(passDescriptor);
+
+    const auto* pipelineState = m_pipeline.get();
+    if (pipelineState == nullptr)
+    {
+        // Still compiling in the background; the pass only clears until it is ready
+        commandEncoder->endEncoding();
+        return;
+    }
 
     commandEncoder->pushDebugGroup(MTLSTR("Triangle Rendering"));
 
-    commandEncoder->setRenderPipelineState(m_pipelineState.get());
+    commandEncoder->setRenderPipelineState(pipelineState->get());
     commandEncoder->setDepthStencilState(depthStencilState());
     commandEncoder->setFrontFacingWinding(MTL::WindingCounterClockwise);
     commandEncoder->setCullMode(MTL::CullModeNone);
@@ -163,10 +170,6 @@ void HelloWorld::createResidencySet()
     }
     m_residencySet->addAllocation(m_vertexBuffer.get());
     m_residencySet->addAllocation(m_indexBuffer.get());
-    for (const auto& buffer : m_uniformBuffer)
-    {
-        m_residencySet->addAllocation(buffer.get());
-    }
 
     commandQueue()->addResidencySet(m_residencySet.get());
     commandQueue()->addResidencySet(metalLayer()->residencySet());
@@ -191,62 +194,24 @@ void HelloWorld::createArgumentTable()
 
 void HelloWorld::createPipelineState()
 {
-    NS::SharedPtr<MTL::VertexDescriptor> vertexDescriptor
-        = NS::TransferPtr(MTL::VertexDescriptor::alloc()->init());
-
-    // Position
-    vertexDescriptor->attributes()->object(0)->setFormat(MTL::VertexFormatFloat4);
-    vertexDescriptor->attributes()->object(0)->setOffset(0);
-    vertexDescriptor->attributes()->object(0)->setBufferIndex(0);
-
-    // Color
-    vertexDescriptor->attributes()->object(1)->setFormat(MTL::VertexFormatFloat4);
-    vertexDescriptor->attributes()->object(1)->setOffset(offsetof(Vertex, color));
-    vertexDescriptor->attributes()->object(1)->setBufferIndex(0);
-
-    vertexDescriptor->layouts()->object(0)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-    vertexDescriptor->layouts()->object(0)->setStride(sizeof(Vertex));
-
-    NS::SharedPtr<MTL4::RenderPipelineDescriptor> pipelineDescriptor
-        = NS::TransferPtr(MTL4::RenderPipelineDescriptor::alloc()->init());
-
-    NS::SharedPtr<MTL4::LibraryFunctionDescriptor> vertexFunction
-        = NS::TransferPtr(MTL4::LibraryFunctionDescriptor::alloc()->init());
-    vertexFunction->setLibrary(shaderLibrary());
-    vertexFunction->setName(MTLSTR("triangle_vertex"));
-    pipelineDescriptor->setVertexFunctionDescriptor(vertexFunction.get());
-
-    NS::SharedPtr<MTL4::LibraryFunctionDescriptor> fragmentFunction
-        = NS::TransferPtr(MTL4::LibraryFunctionDescriptor::alloc()->init());
-    fragmentFunction->setLibrary(shaderLibrary());
-    fragmentFunction->setName(MTLSTR("triangle_fragment"));
-    pipelineDescriptor->setFragmentFunctionDescriptor(fragmentFunction.get());
-
-    pipelineDescriptor->setVertexDescriptor(vertexDescriptor.get());
-    pipelineDescriptor->setRasterSampleCount(4);
-    pipelineDescriptor->colorAttachments()->object(0)->setPixelFormat(s_defaultPixelFormat);
-
-    NS::SharedPtr<MTL4::CompilerTaskOptions> compilerTaskOptions
-        = NS::TransferPtr(MTL4::CompilerTaskOptions::alloc()->init());
-
-    NS::Error*                              error = nullptr;
-    NS::SharedPtr<MTL4::CompilerDescriptor> compilerDescriptor
-        = NS::TransferPtr(MTL4::CompilerDescriptor::alloc()->init());
-    NS::SharedPtr<MTL4::Compiler> compiler
-        = NS::TransferPtr(device()->newCompiler(compilerDescriptor.get(), &error));
-    if (error != nullptr)
-    {
-        throw std::runtime_error(std::format(
-            "Failed to create shader compiler: {}", error->localizedFailureReason()->utf8String()));
-    }
-
-    m_pipelineState = NS::TransferPtr(compiler->newRenderPipelineState(
-        pipelineDescriptor.get(), compilerTaskOptions.get(), &error));
-    if (error != nullptr)
-    {
-        throw std::runtime_error(std::format(
-            "Failed to create pipeline state: {}", error->localizedFailureReason()->utf8String()));
-    }
+    const PipelineDescription description {
+        .vertexFunction = "triangle_vertex",
+        .fragmentFunction = "triangle_fragment",
+        .vertexAttributes = {
+            // Position
+            { .index = 0, .format = MTL::VertexFormatFloat4, .offset = 0, .bufferIndex = 0 },
+            // Color
+            { .index = 1,
+                .format = MTL::VertexFormatFloat4,
+                .offset = offsetof(Vertex, color),
+                .bufferIndex = 0 },
+        },
+        .vertexLayouts = { { .bufferIndex = 0, .stride = sizeof(Vertex) } },
+        .colorAttachments = { { .pixelFormat = s_defaultPixelFormat } },
+        .rasterSampleCount = s_multisampleCount,
+    };
+
+    m_pipeline = requestRenderPipeline(description);
 }
 
 void HelloWorld::createBuffers()
@@ -267,22 +232,10 @@ void HelloWorld::createBuffers()
     m_indexBuffer = NS::TransferPtr(device()->newBuffer(
         indices.data(), indexBufferLength, MTL::ResourceCPUCacheModeDefaultCache));
     m_indexBuffer->setLabel(NS::String::string("Indices", NS::ASCIIStringEncoding));
-
-    for (const auto [index, buffer] : std::views::zip(std::views::iota(0u), m_uniformBuffer))
-    {
-        const auto                      label = std::format("Uniform: {}", index);
-        const NS::SharedPtr<NS::String> nsLabel
-            = NS::TransferPtr(NS::String::string(label.c_str(), NS::ASCIIStringEncoding));
-        buffer = NS::TransferPtr(device()->newBuffer(
-            g_alignedUniformSize * s_bufferCount, MTL::ResourceCPUCacheModeDefaultCache));
-        buffer->setLabel(nsLabel.get());
-    }
 }
 
-void HelloWorld::updateUniforms() const
+void HelloWorld::updateUniforms()
 {
-    const auto currentFrameIndex = frameIndex();
-
     auto position = Vector3(0.0F, 0.0, -10.0F);
     auto rotationX = 0.0F;
     auto rotationY = m_rotationY;
@@ -302,10 +255,8 @@ void HelloWorld::updateUniforms() const
     Uniforms uniforms {};
     uniforms.modelViewProjection = model * cameraUniforms.viewProjection;
 
-    auto* buffer = static_cast<char*>(this->m_uniformBuffer[currentFrameIndex]->contents());
-    memcpy(buffer, &uniforms, sizeof(uniforms));
-
-    m_argumentTable->setAddress(m_uniformBuffer[currentFrameIndex]->gpuAddress(), 1);
+    const UploadAllocation allocation = upload(uniforms);
+    m_argumentTable->setAddress(allocation.gpuAddress, 1);
 }
 
 extern "C" {
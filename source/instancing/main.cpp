@@ -4,7 +4,9 @@
 // SPDX-License-Identifier: MIT
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <format>
 #include <memory>
 #include <print>
@@ -16,6 +18,9 @@
 
 #include "Camera.hpp"
 #include "Example.hpp"
+#include "ShaderLayouts.hpp"
+#include "ShaderPermutations.hpp"
+#include "SimulationThread.hpp"
 
 #define SDL_MAIN_USE_CALLBACKS 1
 #include <SDL3/SDL_main.h>
@@ -36,12 +41,36 @@ XM_ALIGNED_STRUCT(16) InstanceData
     Matrix transform;
 };
 
+XM_ALIGNED_STRUCT(16) ViewUniforms
+{
+    Matrix viewProjection;
+};
+
+SHADER_LAYOUT_CHECKS(Instancing);
+
+/// @brief What InstanceData::transform holds, the INSTANCE_ENCODING permutation.
+enum class InstanceEncoding : uint8_t
+{
+    ModelViewProjection, ///< Each instance's full transform, computed on the CPU.
+    Model,               ///< The model matrix; the view projection is bound once.
+};
+
+struct RotationState
+{
+    float rotationX = 0.0F;
+    float rotationY = 0.0F;
+};
+
 class Instancing final : public Example
 {
-    static constexpr int s_instanceCount = 3;
+    static constexpr int    s_instanceCount = 3;
+    static constexpr double s_simulationStep = 1.0 / 60.0;
 
 public:
-    Instancing();
+    /// @param [in] useSimulationThread Advance the rotation on a fixed rate simulation
+    /// thread and interpolate its snapshots, instead of updating on the render thread.
+    /// @param [in] instanceEncoding Instance data layout, selecting the shader variant.
+    Instancing(bool useSimulationThread, InstanceEncoding instanceEncoding);
 
     ~Instancing() override;
 
@@ -64,21 +93,25 @@ private:
 
     void createPipelineState();
 
-    void updateUniforms() const;
-
-    NS::SharedPtr<MTL::RenderPipelineState>                 m_pipelineState;
-    NS::SharedPtr<MTL::Buffer>                              m_vertexBuffer;
-    NS::SharedPtr<MTL::Buffer>                              m_indexBuffer;
-    NS::SharedPtr<MTL4::ArgumentTable>                      m_argumentTable;
-    NS::SharedPtr<MTL::ResidencySet>                        m_residencySet;
-    std::array<NS::SharedPtr<MTL::Buffer>, s_instanceCount> m_instanceBuffer;
-    std::unique_ptr<Camera>                                 m_mainCamera;
-    float                                                   m_rotationX = 0.0F;
-    float                                                   m_rotationY = 0.0F;
+    void updateUniforms();
+
+    RenderPipelineHandle                             m_pipeline;
+    NS::SharedPtr<MTL::Buffer>                       m_vertexBuffer;
+    NS::SharedPtr<MTL::Buffer>                       m_indexBuffer;
+    NS::SharedPtr<MTL4::ArgumentTable>               m_argumentTable;
+    NS::SharedPtr<MTL::ResidencySet>                 m_residencySet;
+    std::unique_ptr<Camera>                          m_mainCamera;
+    float                                            m_rotationX = 0.0F;
+    float                                            m_rotationY = 0.0F;
+    bool                                             m_useSimulationThread;
+    InstanceEncoding                                 m_instanceEncoding;
+    std::unique_ptr<SimulationThread<RotationState>> m_simulation;
 };
 
-Instancing::Instancing()
+Instancing::Instancing(const bool useSimulationThread, const InstanceEncoding instanceEncoding)
     : Example("Instancing", 800, 600)
+    , m_useSimulationThread(useSimulationThread)
+    , m_instanceEncoding(instanceEncoding)
 {
 }
 
@@ -105,6 +138,17 @@ bool Instancing::onLoad()
 
     createPipelineState();
 
+    if (m_useSimulationThread)
+    {
+        m_simulation = std::make_unique<SimulationThread<RotationState>>(RotationState {},
+            s_simulationStep, [](const GameTimer& timer, RotationState& state) {
+                const auto elapsed = static_cast<float>(timer.elapsedSeconds());
+                state.rotationX += elapsed;
+                state.rotationY += elapsed;
+            });
+        m_simulation->start();
+    }
+
     return true;
 }
 
@@ -119,10 +163,21 @@ void Instancing::onResize(uint32_t width, uint32_t height)
 
 void Instancing::onUpdate(const GameTimer& timer)
 {
-    const auto elapsed = static_cast<float>(timer.elapsedSeconds());
+    if (m_simulation != nullptr)
+    {
+        const auto& snapshot = m_simulation->latestSnapshot();
+        const auto  alpha = static_cast<float>(
+            m_simulation->interpolationFactor(snapshot, SDL_GetPerformanceCounter()));
+        m_rotationX = std::lerp(snapshot.previous.rotationX, snapshot.current.rotationX, alpha);
+        m_rotationY = std::lerp(snapshot.previous.rotationY, snapshot.current.rotationY, alpha);
+    }
+    else
+    {
+        const auto elapsed = static_cast<float>(timer.elapsedSeconds());
 
-    m_rotationX += elapsed;
-    m_rotationY += elapsed;
+        m_rotationX += elapsed;
+        m_rotationY += elapsed;
+    }
 
     updateUniforms();
 }
@@ -131,15 +186,22 @@ void Instancing::onRender(CA::MetalDrawable* drawable,
     MTL4::CommandBuffer*                     commandBuffer,
     [[maybe_unused]] const GameTimer&        timer)
 {
-    NS::SharedPtr<MTL4::RenderPassDescriptor> passDescriptor
-        = NS::TransferPtr(defaultRenderPassDescriptor(drawable));
+    MTL4::RenderPassDescriptor* passDescriptor = defaultRenderPassDescriptor(drawable);
 
     MTL4::RenderCommandEncoder* commandEncoder
-        = commandBuffer->renderCommandEncoder(passDescriptor.get());
+        = commandBuffer->renderCommandEncoder(passDescriptor);
+
+    const auto* pipelineState = m_pipeline.get();
+    if (pipelineState == nullptr)
+    {
+        // Still compiling in the background; the pass only clears until it is ready
+        commandEncoder->endEncoding();
+        return;
+    }
 
     commandEncoder->pushDebugGroup(MTLSTR("Instanced Rendering"));
 
-    commandEncoder->setRenderPipelineState(m_pipelineState.get());
+    commandEncoder->setRenderPipelineState(pipelineState->get());
     commandEncoder->setDepthStencilState(depthStencilState());
     commandEncoder->setFrontFacingWinding(MTL::WindingCounterClockwise);
     commandEncoder->setCullMode(MTL::CullModeNone);
@@ -172,10 +234,6 @@ void Instancing::createResidencySet()
 
     m_residencySet->addAllocation(m_vertexBuffer.get());
     m_residencySet->addAllocation(m_indexBuffer.get());
-    for (const auto& buffer : m_instanceBuffer)
-    {
-        m_residencySet->addAllocation(buffer.get());
-    }
 
     commandQueue()->addResidencySet(m_residencySet.get());
     commandQueue()->addResidencySet(metalLayer()->residencySet());
@@ -188,7 +246,7 @@ void Instancing::createArgumentTable()
 
     NS::SharedPtr<MTL4::ArgumentTableDescriptor> argTableDescriptor
         = NS::TransferPtr(MTL4::ArgumentTableDescriptor::alloc()->init());
-    argTableDescriptor->setMaxBufferBindCount(2);
+    argTableDescriptor->setMaxBufferBindCount(3);
 
     m_argumentTable = NS::TransferPtr(device()->newArgumentTable(argTableDescriptor.get(), &error));
     if (error != nullptr)
@@ -200,62 +258,33 @@ void Instancing::createArgumentTable()
 
 void Instancing::createPipelineState()
 {
-    NS::SharedPtr<MTL::VertexDescriptor> vertexDescriptor
-        = NS::TransferPtr(MTL::VertexDescriptor::alloc()->init());
-
-    // Position
-    vertexDescriptor->attributes()->object(0)->setFormat(MTL::VertexFormatFloat4);
-    vertexDescriptor->attributes()->object(0)->setOffset(0);
-    vertexDescriptor->attributes()->object(0)->setBufferIndex(0);
-
-    // Color
-    vertexDescriptor->attributes()->object(1)->setFormat(MTL::VertexFormatFloat4);
-    vertexDescriptor->attributes()->object(1)->setOffset(offsetof(Vertex, color));
-    vertexDescriptor->attributes()->object(1)->setBufferIndex(0);
-
-    vertexDescriptor->layouts()->object(0)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-    vertexDescriptor->layouts()->object(0)->setStride(sizeof(Vertex));
-
-    NS::SharedPtr<MTL4::RenderPipelineDescriptor> pipelineDescriptor
-        = NS::TransferPtr(MTL4::RenderPipelineDescriptor::alloc()->init());
-
-    NS::SharedPtr<MTL4::LibraryFunctionDescriptor> vertexFunction
-        = NS::TransferPtr(MTL4::LibraryFunctionDescriptor::alloc()->init());
-    vertexFunction->setLibrary(shaderLibrary());
-    vertexFunction->setName(MTLSTR("instancing_vertex"));
-    pipelineDescriptor->setVertexFunctionDescriptor(vertexFunction.get());
-
-    NS::SharedPtr<MTL4::LibraryFunctionDescriptor> fragmentFunction
-        = NS::TransferPtr(MTL4::LibraryFunctionDescriptor::alloc()->init());
-    fragmentFunction->setLibrary(shaderLibrary());
-    fragmentFunction->setName(MTLSTR("instancing_fragment"));
-    pipelineDescriptor->setFragmentFunctionDescriptor(fragmentFunction.get());
-
-    pipelineDescriptor->setVertexDescriptor(vertexDescriptor.get());
-    pipelineDescriptor->setRasterSampleCount(4);
-    pipelineDescriptor->colorAttachments()->object(0)->setPixelFormat(s_defaultPixelFormat);
-
-    NS::SharedPtr<MTL4::CompilerTaskOptions> compilerTaskOptions
-        = NS::TransferPtr(MTL4::CompilerTaskOptions::alloc()->init());
-
-    NS::Error*                              error = nullptr;
-    NS::SharedPtr<MTL4::CompilerDescriptor> compilerDescriptor
-        = NS::TransferPtr(MTL4::CompilerDescriptor::alloc()->init());
-    NS::SharedPtr<MTL4::Compiler> compiler
-        = NS::TransferPtr(device()->newCompiler(compilerDescriptor.get(), &error));
-    if (error != nullptr)
-    {
-        throw std::runtime_error(std::format(
-            "Failed to create shader compiler: {}", error->localizedFailureReason()->utf8String()));
-    }
+    using namespace ShaderPermutations::Instancing;
 
-    m_pipelineState = NS::TransferPtr(compiler->newRenderPipelineState(
-        pipelineDescriptor.get(), compilerTaskOptions.get(), &error));
-    if (error != nullptr)
+    const uint32_t key = permutationKey({ .INSTANCE_ENCODING
+        = m_instanceEncoding == InstanceEncoding::Model ? 1 : 0 });
+    if (key == g_permutationCount)
     {
-        throw std::runtime_error(std::format(
-            "Failed to create pipeline state: {}", error->localizedFailureReason()->utf8String()));
+        throw std::runtime_error("No instancing shader variant for the instance encoding");
     }
+
+    const PipelineDescription description {
+        .vertexFunction = functionName("instancing_vertex", key),
+        .fragmentFunction = functionName("instancing_fragment", key),
+        .vertexAttributes = {
+            // Position
+            { .index = 0, .format = MTL::VertexFormatFloat4, .offset = 0, .bufferIndex = 0 },
+            // Color
+            { .index = 1,
+                .format = MTL::VertexFormatFloat4,
+                .offset = offsetof(Vertex, color),
+                .bufferIndex = 0 },
+        },
+        .vertexLayouts = { { .bufferIndex = 0, .stride = sizeof(Vertex) } },
+        .colorAttachments = { { .pixelFormat = s_defaultPixelFormat } },
+        .rasterSampleCount = s_multisampleCount,
+    };
+
+    m_pipeline = requestRenderPipeline(description);
 }
 
 void Instancing::createBuffers()
@@ -282,27 +311,14 @@ void Instancing::createBuffers()
     m_indexBuffer = NS::TransferPtr(device()->newBuffer(
         indices.data(), indexBufferLength, MTL::ResourceCPUCacheModeDefaultCache));
     m_indexBuffer->setLabel(NS::String::string("Indices", NS::ASCIIStringEncoding));
-
-    constexpr size_t instanceDataSize
-        = static_cast<unsigned long>(s_bufferCount * s_instanceCount) * sizeof(InstanceData);
-    for (const auto [index, buffer] : std::views::zip(std::views::iota(0u), m_instanceBuffer))
-    {
-        const auto                      label = std::format("Instance Buffer: {}", index);
-        const NS::SharedPtr<NS::String> nsLabel
-            = NS::TransferPtr(NS::String::string(label.c_str(), NS::ASCIIStringEncoding));
-        buffer = NS::TransferPtr(
-            device()->newBuffer(instanceDataSize, MTL::ResourceCPUCacheModeDefaultCache));
-        buffer->setLabel(nsLabel.get());
-    }
 }
 
-void Instancing::updateUniforms() const
+void Instancing::updateUniforms()
 {
-    const auto currentFrameIndex = frameIndex();
-
-    MTL::Buffer* instanceBuffer = m_instanceBuffer[currentFrameIndex].get();
+    const UploadAllocation allocation = allocateUpload(sizeof(InstanceData) * s_instanceCount);
+    const CameraUniforms   cameraUniforms = m_mainCamera->uniforms();
 
-    auto*                   instanceData = static_cast<InstanceData*>(instanceBuffer->contents());
+    auto*                   instanceData = static_cast<InstanceData*>(allocation.data);
     std::span<InstanceData> instanceSpan(instanceData, s_instanceCount);
     for (auto [index, data] : std::views::zip(std::views::iota(0u), instanceSpan))
     {
@@ -314,18 +330,26 @@ void Instancing::updateUniforms() const
         const Vector3 xAxis = Vector3::Right;
         const Vector3 yAxis = Vector3::Up;
 
-        const Matrix         xRot = Matrix::CreateFromAxisAngle(xAxis, rotationX);
-        const Matrix         yRot = Matrix::CreateFromAxisAngle(yAxis, rotationY);
-        const Matrix         rotation = xRot * yRot;
-        const Matrix         translation = Matrix::CreateTranslation(position);
-        const Matrix         scale = Matrix::CreateScale(scaleFactor);
-        const Matrix         model = scale * rotation * translation;
-        const CameraUniforms cameraUniforms = m_mainCamera->uniforms();
+        const Matrix xRot = Matrix::CreateFromAxisAngle(xAxis, rotationX);
+        const Matrix yRot = Matrix::CreateFromAxisAngle(yAxis, rotationY);
+        const Matrix rotation = xRot * yRot;
+        const Matrix translation = Matrix::CreateTranslation(position);
+        const Matrix scale = Matrix::CreateScale(scaleFactor);
+        const Matrix model = scale * rotation * translation;
 
-        data.transform = model * cameraUniforms.viewProjection;
+        data.transform = m_instanceEncoding == InstanceEncoding::Model
+            ? model
+            : model * cameraUniforms.viewProjection;
     }
 
-    m_argumentTable->setAddress(m_instanceBuffer[currentFrameIndex]->gpuAddress(), 1);
+    m_argumentTable->setAddress(allocation.gpuAddress, 1);
+
+    if (m_instanceEncoding == InstanceEncoding::Model)
+    {
+        const UploadAllocation view = allocateUpload(sizeof(ViewUniforms));
+        static_cast<ViewUniforms*>(view.data)->viewProjection = cameraUniforms.viewProjection;
+        m_argumentTable->setAddress(view.gpuAddress, 2);
+    }
 }
 
 extern "C" {
@@ -334,7 +358,18 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv)
 {
     try
     {
-        auto* example = new Instancing();
+        bool             useSimulationThread = false;
+        InstanceEncoding instanceEncoding = InstanceEncoding::ModelViewProjection;
+        for (int i = 1; i < argc; i++)
+        {
+            useSimulationThread |= std::strcmp(argv[i], "--simulation-thread") == 0;
+            if (std::strcmp(argv[i], "--model-instances") == 0)
+            {
+                instanceEncoding = InstanceEncoding::Model;
+            }
+        }
+
+        auto* example = new Instancing(useSimulationThread, instanceEncoding);
         if (!example->startup())
         {
             delete example;
@@ -24,6 +24,8 @@
 #include "Camera.hpp"
 #include "Example.hpp"
 #include "File.hpp"
+#include "ShaderLayouts.hpp"
+#include "ShaderPermutations.hpp"
 
 #define SDL_MAIN_USE_CALLBACKS 1
 #include <SDL3/SDL_main.h>
@@ -39,7 +41,7 @@ XM_ALIGNED_STRUCT(16) Uniforms
     [[maybe_unused]] Matrix modelViewProjection;
 };
 
-static constexpr size_t g_textureCount = 5;
+static constexpr size_t g_textureCount = ShaderPermutations::Textures::TEXTURE_COUNT;
 
 XM_ALIGNED_STRUCT(16) FragmentArgumentBuffer
 {
@@ -47,6 +49,8 @@ XM_ALIGNED_STRUCT(16) FragmentArgumentBuffer
     [[maybe_unused]] Matrix*                                     transforms;
 };
 
+SHADER_LAYOUT_CHECKS(Textures);
+
 static constexpr std::array g_comboItems
     = { "Texture 0", "Texture 1", "Texture 2", "Texture 3", "Texture 4" };
 
@@ -82,25 +86,23 @@ private:
 
     void createTextureHeap();
 
-    void createArgumentBuffers();
-
-    void updateUniforms() const;
+    void updateUniforms();
 
     [[nodiscard]] MTL::Texture* newTextureFromFile(const std::string& fileName) const;
 
-    NS::SharedPtr<MTL::RenderPipelineState>               m_pipelineState;
-    NS::SharedPtr<MTL::Buffer>                            m_vertexBuffer;
-    NS::SharedPtr<MTL::Buffer>                            m_indexBuffer;
-    std::array<NS::SharedPtr<MTL::Buffer>, s_bufferCount> m_instanceBuffer;
-    NS::SharedPtr<MTL4::ArgumentTable>                    m_argumentTable;
-    NS::SharedPtr<MTL::ResidencySet>                      m_residencySet;
-    NS::SharedPtr<MTL::SharedEvent>                       m_computeEvent;
-    std::unique_ptr<Camera>                               m_mainCamera;
-    NS::SharedPtr<MTL::Heap>                              m_textureHeap;
-    std::array<NS::SharedPtr<MTL::Buffer>, s_bufferCount> m_argumentBuffer;
-    std::vector<NS::SharedPtr<MTL::Texture>>              m_heapTextures;
-    float                                                 m_rotationX = 0.0F;
-    float                                                 m_rotationY = 0.0F;
+    RenderPipelineHandle                     m_pipeline;
+    NS::SharedPtr<MTL::Buffer>               m_vertexBuffer;
+    NS::SharedPtr<MTL::Buffer>               m_indexBuffer;
+    NS::SharedPtr<MTL4::ArgumentTable>       m_argumentTable;
+    NS::SharedPtr<MTL::ResidencySet>         m_residencySet;
+    NS::SharedPtr<MTL::SharedEvent>          m_computeEvent;
+    std::unique_ptr<Camera>                  m_mainCamera;
+    NS::SharedPtr<MTL::Heap>                 m_textureHeap;
+    std::vector<NS::SharedPtr<MTL::Texture>> m_heapTextures;
+    float                                    m_rotationX = 0.0F;
+    float                                    m_rotationY = 0.0F;
+    uint64_t                                 m_argumentBufferAddress = 0;
+    bool                                     m_alphaBlend = true;
 };
 
 Textures::Textures()
@@ -135,15 +137,9 @@ bool Textures::onLoad()
 
     createTextureHeap();
 
-    createArgumentBuffers();
-
     // populate residency set and bind to command queue
     m_residencySet->addAllocation(m_vertexBuffer.get());
     m_residencySet->addAllocation(m_indexBuffer.get());
-    for (const auto& buffer : m_instanceBuffer)
-    {
-        m_residencySet->addAllocation(buffer.get());
-    }
 
     commandQueue()->addResidencySet(m_residencySet.get());
     commandQueue()->addResidencySet(metalLayer()->residencySet());
@@ -187,6 +183,13 @@ void Textures::onUpdate(const GameTimer& timer)
         m_rotationY += static_cast<float>(mouse().relativeX()) * elapsed;
     }
 
+    // B switches between alpha blending and opaque drawing, a different shader variant
+    if (keyboard().isKeyClicked(SDL_SCANCODE_B))
+    {
+        m_alphaBlend = !m_alphaBlend;
+        createPipelineState();
+    }
+
     updateUniforms();
 }
 
@@ -259,29 +262,33 @@ void Textures::onRender(CA::MetalDrawable* drawable,
     MTL4::CommandBuffer*                   commandBuffer,
     [[maybe_unused]] const GameTimer&      timer)
 {
-
-    const auto currentFrameIndex = frameIndex();
-
-    NS::SharedPtr<MTL4::RenderPassDescriptor> renderPassDescriptor
-        = NS::TransferPtr(defaultRenderPassDescriptor(drawable));
+    MTL4::RenderPassDescriptor* renderPassDescriptor = defaultRenderPassDescriptor(drawable);
 
     MTL4::RenderCommandEncoder* commandEncoder
-        = commandBuffer->renderCommandEncoder(renderPassDescriptor.get());
+        = commandBuffer->renderCommandEncoder(renderPassDescriptor);
+
+    const auto* pipelineState = m_pipeline.get();
+    if (pipelineState == nullptr)
+    {
+        // Still compiling in the background; the pass only clears until it is ready
+        commandEncoder->endEncoding();
+        return;
+    }
 
     commandEncoder->pushDebugGroup(MTLSTR("Texture Rendering"));
 
-    commandEncoder->setRenderPipelineState(m_pipelineState.get());
+    commandEncoder->setRenderPipelineState(pipelineState->get());
     commandEncoder->setDepthStencilState(depthStencilState());
     commandEncoder->setFrontFacingWinding(MTL::WindingCounterClockwise);
     commandEncoder->setCullMode(MTL::CullModeNone);
     commandEncoder->setArgumentTable(m_argumentTable.get(), MTL::RenderStageVertex);
 
     m_argumentTable->setAddress(m_vertexBuffer->gpuAddress(), 0);
-    m_argumentTable->setAddress(m_argumentBuffer[currentFrameIndex]->gpuAddress(), 1);
+    m_argumentTable->setAddress(m_argumentBufferAddress, 1);
 
     commandEncoder->setArgumentTable(m_argumentTable.get(), MTL::RenderStageFragment);
 
-    m_argumentTable->setAddress(m_argumentBuffer[currentFrameIndex]->gpuAddress(), 2);
+    m_argumentTable->setAddress(m_argumentBufferAddress, 2);
 
     commandEncoder->drawIndexedPrimitives(MTL::PrimitiveTypeTriangle,
         m_indexBuffer->length() / sizeof(uint16_t), MTL::IndexTypeUInt16,
@@ -324,54 +331,44 @@ void Textures::createArgumentTable()
 
 void Textures::createPipelineState()
 {
-    NS::SharedPtr<MTL::VertexDescriptor> vertexDescriptor
-        = NS::TransferPtr(MTL::VertexDescriptor::alloc()->init());
-
-    // Position
-    vertexDescriptor->attributes()->object(0)->setFormat(MTL::VertexFormatFloat4);
-    vertexDescriptor->attributes()->object(0)->setOffset(0);
-    vertexDescriptor->attributes()->object(0)->setBufferIndex(0);
-
-    // Color
-    vertexDescriptor->attributes()->object(1)->setFormat(MTL::VertexFormatFloat2);
-    vertexDescriptor->attributes()->object(1)->setOffset(offsetof(Vertex, texCoord));
-    vertexDescriptor->attributes()->object(1)->setBufferIndex(0);
-
-    vertexDescriptor->layouts()->object(0)->setStepFunction(MTL::VertexStepFunctionPerVertex);
-    vertexDescriptor->layouts()->object(0)->setStride(sizeof(Vertex));
-
-    NS::SharedPtr<MTL::RenderPipelineDescriptor> pipelineDescriptor
-        = NS::TransferPtr(MTL::RenderPipelineDescriptor::alloc()->init());
-    pipelineDescriptor->colorAttachments()->object(0)->setPixelFormat(s_defaultPixelFormat);
-    pipelineDescriptor->colorAttachments()->object(0)->setBlendingEnabled(true);
-    pipelineDescriptor->colorAttachments()->object(0)->setSourceRGBBlendFactor(
-        MTL::BlendFactorSourceAlpha);
-    pipelineDescriptor->colorAttachments()->object(0)->setDestinationRGBBlendFactor(
-        MTL::BlendFactorOneMinusSourceAlpha);
-    pipelineDescriptor->colorAttachments()->object(0)->setRgbBlendOperation(MTL::BlendOperationAdd);
-    pipelineDescriptor->colorAttachments()->object(0)->setSourceAlphaBlendFactor(
-        MTL::BlendFactorSourceAlpha);
-    pipelineDescriptor->colorAttachments()->object(0)->setDestinationAlphaBlendFactor(
-        MTL::BlendFactorOneMinusSourceAlpha);
-    pipelineDescriptor->colorAttachments()->object(0)->setAlphaBlendOperation(
-        MTL::BlendOperationAdd);
-    pipelineDescriptor->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float_Stencil8);
-    pipelineDescriptor->setStencilAttachmentPixelFormat(MTL::PixelFormatDepth32Float_Stencil8);
-    pipelineDescriptor->setVertexFunction(shaderLibrary()->newFunction(
-        NS::String::string("texture_vertex", NS::ASCIIStringEncoding)));
-    pipelineDescriptor->setFragmentFunction(shaderLibrary()->newFunction(
-        NS::String::string("texture_fragment", NS::ASCIIStringEncoding)));
-    pipelineDescriptor->setVertexDescriptor(vertexDescriptor.get());
-    pipelineDescriptor->setSampleCount(s_multisampleCount);
+    using namespace ShaderPermutations::Textures;
 
-    NS::Error* error = nullptr;
-    m_pipelineState
-        = NS::TransferPtr(device()->newRenderPipelineState(pipelineDescriptor.get(), &error));
-    if (error != nullptr)
+    const uint32_t key
+        = permutationKey({ .ALPHA_BLEND = m_alphaBlend ? 1 : 0, .MSAA = s_multisampleCount });
+    if (key == g_permutationCount)
     {
         throw std::runtime_error(std::format(
-            "Failed to create pipeline state: {}", error->localizedFailureReason()->utf8String()));
+            "No textures shader variant for alpha blend {} at {}x MSAA", m_alphaBlend,
+            s_multisampleCount));
     }
+
+    const PipelineDescription description {
+        .vertexFunction = functionName("texture_vertex", key),
+        .fragmentFunction = functionName("texture_fragment", key),
+        .vertexAttributes = {
+            // Position
+            { .index = 0, .format = MTL::VertexFormatFloat4, .offset = 0, .bufferIndex = 0 },
+            // Texture coordinate
+            { .index = 1,
+                .format = MTL::VertexFormatFloat2,
+                .offset = offsetof(Vertex, texCoord),
+                .bufferIndex = 0 },
+        },
+        .vertexLayouts = { { .bufferIndex = 0, .stride = sizeof(Vertex) } },
+        .colorAttachments = { {
+            .pixelFormat = s_defaultPixelFormat,
+            .blendingEnabled = m_alphaBlend,
+            .sourceRGBBlendFactor = MTL::BlendFactorSourceAlpha,
+            .destinationRGBBlendFactor = MTL::BlendFactorOneMinusSourceAlpha,
+            .rgbBlendOperation = MTL::BlendOperationAdd,
+            .sourceAlphaBlendFactor = MTL::BlendFactorSourceAlpha,
+            .destinationAlphaBlendFactor = MTL::BlendFactorOneMinusSourceAlpha,
+            .alphaBlendOperation = MTL::BlendOperationAdd,
+        } },
+        .rasterSampleCount = s_multisampleCount,
+    };
+
+    m_pipeline = requestRenderPipeline(description);
 }
 
 void Textures::createBuffers()
@@ -393,29 +390,14 @@ void Textures::createBuffers()
     m_indexBuffer = NS::TransferPtr(device()->newBuffer(
         indices.data(), indexBufferLength, MTL::ResourceCPUCacheModeDefaultCache));
     m_indexBuffer->setLabel(NS::String::string("Indices", NS::ASCIIStringEncoding));
-
-    constexpr size_t instanceDataSize
-        = static_cast<unsigned long>(s_bufferCount * s_instanceCount) * sizeof(Matrix);
-    for (const auto [index, buffer] : std::views::zip(std::views::iota(0u), m_instanceBuffer))
-    {
-        const auto                      label = std::format("Instance Buffer: {}", index);
-        const NS::SharedPtr<NS::String> nsLabel
-            = NS::TransferPtr(NS::String::string(label.c_str(), NS::ASCIIStringEncoding));
-
-        buffer = NS::TransferPtr(
-            device()->newBuffer(instanceDataSize, MTL::ResourceCPUCacheModeDefaultCache));
-        buffer->setLabel(nsLabel.get());
-    }
 }
 
-void Textures::updateUniforms() const
+void Textures::updateUniforms()
 {
-    const auto currentFrameIndex = frameIndex();
+    const UploadAllocation instances = allocateUpload(sizeof(Matrix) * s_instanceCount);
 
-    MTL::Buffer* instanceBuffer = m_instanceBuffer[currentFrameIndex].get();
-
-    auto*             instanceData = static_cast<Matrix*>(instanceBuffer->contents());
-    std::span<Matrix> instanceSpan(instanceData, s_bufferCount);
+    auto*             instanceData = static_cast<Matrix*>(instances.data);
+    std::span<Matrix> instanceSpan(instanceData, s_instanceCount);
     for (auto [index, data] : std::views::zip(std::views::iota(0u), instanceSpan))
     {
         auto position = Vector3(-5.0F + 5.0F * static_cast<float>(index), 0.0F, -8.0F);
@@ -436,6 +418,16 @@ void Textures::updateUniforms() const
 
         data = model * cameraUniforms.viewProjection;
     }
+
+    // The argument buffer references this frame's transforms, so it is written per frame.
+    // Bind each texture's GPU id into argument buffer for access in fragment shader
+    FragmentArgumentBuffer arguments {};
+    arguments.transforms = reinterpret_cast<Matrix*>(instances.gpuAddress);
+    for (auto [i, texture] : std::views::zip(std::views::iota(0u), m_heapTextures))
+    {
+        arguments.textures[i] = texture->gpuResourceID();
+    }
+    m_argumentBufferAddress = upload(arguments).gpuAddress;
 }
 
 void Textures::createTextureHeap()
@@ -540,36 +532,6 @@ void Textures::createTextureHeap()
     m_residencySet->addAllocation(m_textureHeap.get());
 }
 
-void Textures::createArgumentBuffers()
-{
-    // Tier 2 argument buffers
-    if (device()->argumentBuffersSupport() == MTL::ArgumentBuffersTier2)
-    {
-        for (auto [i, argumentBuffer] : std::views::zip(std::views::iota(0u), m_argumentBuffer))
-        {
-            constexpr auto size = sizeof(FragmentArgumentBuffer);
-            argumentBuffer
-                = NS::TransferPtr(device()->newBuffer(size, MTL::ResourceCPUCacheModeDefaultCache));
-
-            NS::String* label = NS::String::string(
-                std::format("Argument Buffer {}", i).c_str(), NS::UTF8StringEncoding);
-            argumentBuffer->setLabel(label);
-            label->release();
-
-            auto* buffer = static_cast<FragmentArgumentBuffer*>(argumentBuffer->contents());
-            // Bind each texture's GPU id into argument buffer for access in fragment shader
-            buffer->transforms = reinterpret_cast<Matrix*>(m_instanceBuffer[i]->gpuAddress());
-            for (auto [j, texture] : std::views::zip(std::views::iota(0u), m_heapTextures))
-            {
-                buffer->textures[j] = texture->gpuResourceID();
-            }
-
-            m_residencySet->addAllocation(argumentBuffer.get());
-            m_argumentTable->setAddress(argumentBuffer->gpuAddress(), 0);
-        }
-    }
-}
-
 extern "C" {
 
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv)
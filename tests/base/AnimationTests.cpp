@@ -0,0 +1,446 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "Animation.hpp"
+#include "FrameArena.hpp"
+#include "TestCharacters.hpp"
+
+namespace
+{
+    using Float3 = std::array<float, 3>;
+    using Quaternion = std::array<float, 4>;
+
+    /// Row vector matrix of a transform, by rotating the scaled basis vectors in
+    /// double precision.
+    Assets::Matrix4 referenceMatrix(const Animation::Transform& transform)
+    {
+        const auto& [x, y, z, w] = transform.rotation;
+        const auto rotate = [&](const std::array<double, 3>& v) {
+            // v + 2w (q x v) + 2 q x (q x v)
+            const std::array<double, 3> q { x, y, z };
+            const std::array<double, 3> t { 2.0 * (q[1] * v[2] - q[2] * v[1]),
+                2.0 * (q[2] * v[0] - q[0] * v[2]), 2.0 * (q[0] * v[1] - q[1] * v[0]) };
+            return std::array<double, 3> { v[0] + w * t[0] + (q[1] * t[2] - q[2] * t[1]),
+                v[1] + w * t[1] + (q[2] * t[0] - q[0] * t[2]),
+                v[2] + w * t[2] + (q[0] * t[1] - q[1] * t[0]) };
+        };
+
+        Assets::Matrix4 matrix {};
+        for (size_t row = 0; row < 3; row++)
+        {
+            std::array<double, 3> axis {};
+            axis[row] = transform.scale[row];
+            const auto rotated = rotate(axis);
+            for (size_t column = 0; column < 3; column++)
+            {
+                matrix[row * 4 + column] = static_cast<float>(rotated[column]);
+            }
+        }
+        std::copy(transform.translation.begin(), transform.translation.end(), matrix.begin() + 12);
+        matrix[15] = 1.0F;
+        return matrix;
+    }
+
+    Assets::Matrix4 multiply(const Assets::Matrix4& a, const Assets::Matrix4& b)
+    {
+        Assets::Matrix4 result {};
+        for (size_t row = 0; row < 4; row++)
+        {
+            for (size_t column = 0; column < 4; column++)
+            {
+                double sum = 0.0;
+                for (size_t k = 0; k < 4; k++)
+                {
+                    sum += static_cast<double>(a[row * 4 + k]) * b[k * 4 + column];
+                }
+                result[row * 4 + column] = static_cast<float>(sum);
+            }
+        }
+        return result;
+    }
+
+    /// Model transform of a joint by walking up to its root, local transform first.
+    Assets::Matrix4 referenceModel(
+        const Animation::Skeleton& skeleton, const Animation::Pose& pose, const size_t joint)
+    {
+        Assets::Matrix4 model = referenceMatrix(pose.joint(joint));
+        for (int32_t parent = skeleton.parents[joint]; parent >= 0;
+            parent = skeleton.parents[parent])
+        {
+            model = multiply(model, referenceMatrix(pose.joint(parent)));
+        }
+        return model;
+    }
+
+    float largestDifference(const Assets::Matrix4& a, const Assets::Matrix4& b)
+    {
+        float difference = 0.0F;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            difference = std::max(difference, std::abs(a[i] - b[i]));
+        }
+        return difference;
+    }
+
+    /// Angle between two rotations, either sign of the quaternions.
+    double angleBetween(const Quaternion& a, const Quaternion& b)
+    {
+        double dot = 0.0;
+        for (size_t i = 0; i < 4; i++)
+        {
+            dot += static_cast<double>(a[i]) * b[i];
+        }
+        return 2.0 * std::acos(std::min(std::abs(dot), 1.0));
+    }
+
+    /// Value of a linear glTF channel at a time: lerp, or slerp for rotations.
+    std::array<double, 4> sourceValue(const Assets::AnimationChannel& channel, const float time)
+    {
+        const size_t width = channel.path == Assets::AnimationPath::Rotation ? 4 : 3;
+        const auto   next = std::ranges::upper_bound(channel.times, time);
+        const size_t second = std::clamp<size_t>(next - channel.times.begin(), 1,
+            channel.times.size() - 1);
+        const size_t first = second - 1;
+        const double alpha = std::clamp(static_cast<double>(time - channel.times[first])
+                / (channel.times[second] - channel.times[first]),
+            0.0, 1.0);
+
+        std::array<double, 4> a {};
+        std::array<double, 4> b {};
+        for (size_t i = 0; i < width; i++)
+        {
+            a[i] = channel.values[first * width + i];
+            b[i] = channel.values[second * width + i];
+        }
+        double wa = 1.0 - alpha;
+        double wb = alpha;
+        if (width == 4)
+        {
+            double dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+            const double sign = dot < 0.0 ? -1.0 : 1.0;
+            dot = std::min(std::abs(dot), 1.0);
+            const double angle = std::acos(dot);
+            if (angle > 1.0e-9)
+            {
+                wa = std::sin((1.0 - alpha) * angle) / std::sin(angle);
+                wb = std::sin(alpha * angle) / std::sin(angle);
+            }
+            wb *= sign;
+        }
+        std::array<double, 4> value {};
+        for (size_t i = 0; i < width; i++)
+        {
+            value[i] = a[i] * wa + b[i] * wb;
+        }
+        return value;
+    }
+
+    class AnimationTest : public testing::Test
+    {
+    protected:
+        AnimationTest()
+            : m_scene(Tests::createCharacter(5, 6))
+            , m_skeleton(Animation::buildSkeleton(m_scene, 0))
+            , m_clip(Animation::Clip::compress(m_scene.animations.front(), m_skeleton))
+        {
+        }
+
+        Assets::Scene       m_scene;
+        Animation::Skeleton m_skeleton;
+        Animation::Clip     m_clip;
+    };
+} // namespace
+
+TEST(Animation, BuildsSkeletonsParentsFirst)
+{
+    // Nodes listed children first, with an unskinned ancestor and an unrelated node
+    Assets::Scene scene;
+    scene.nodes.resize(5);
+    scene.nodes[0].parent = 1;
+    scene.nodes[1].parent = 3;
+    scene.nodes[2].parent = 3;
+    scene.nodes[3].parent = -1;
+    scene.nodes[4].parent = -1;
+    scene.nodes[3].translation = { 1.0F, 2.0F, 3.0F };
+    for (auto& node : scene.nodes)
+    {
+        node.localTransform = Tests::translationMatrix(node.translation);
+    }
+    scene.skins.push_back({ .name = "skin",
+        .joints = { 0, 2, 1 },
+        .inverseBindMatrices = std::vector<Assets::Matrix4>(3, Tests::translationMatrix({})),
+        .skeleton = -1 });
+
+    const auto skeleton = Animation::buildSkeleton(scene, 0);
+    ASSERT_EQ(skeleton.jointCount(), 4U);
+    EXPECT_EQ(skeleton.nodes, (std::vector<int32_t> { 3, 1, 2, 0 }));
+    EXPECT_EQ(skeleton.parents, (std::vector<int32_t> { -1, 0, 0, 1 }));
+    EXPECT_EQ(skeleton.skinJoints, (std::vector<uint32_t> { 3, 2, 1 }));
+    EXPECT_EQ(skeleton.inverseBindMatrices.size(), 3U);
+    EXPECT_EQ(skeleton.bindPose[0].translation, (Float3 { 1.0F, 2.0F, 3.0F }));
+    for (size_t joint = 0; joint < skeleton.jointCount(); joint++)
+    {
+        EXPECT_LT(skeleton.parents[joint], static_cast<int32_t>(joint));
+    }
+
+    EXPECT_THROW((void)Animation::buildSkeleton(scene, 1), std::runtime_error);
+}
+
+TEST(Animation, DecomposesComposedTransforms)
+{
+    const float                half = 0.6F;
+    const Animation::Transform expected { .translation = { 1.0F, -2.0F, 0.5F },
+        .rotation = { 0.48F * std::sin(half), 0.6F * std::sin(half), 0.64F * std::sin(half),
+            std::cos(half) },
+        .scale = { 2.0F, 0.5F, 1.5F } };
+
+    const Animation::Transform actual = Animation::decompose(referenceMatrix(expected));
+    for (size_t i = 0; i < 3; i++)
+    {
+        EXPECT_NEAR(actual.translation[i], expected.translation[i], 1.0e-6F);
+        EXPECT_NEAR(actual.scale[i], expected.scale[i], 1.0e-5F);
+    }
+    EXPECT_LT(angleBetween(actual.rotation, expected.rotation), 1.0e-3);
+}
+
+TEST(Animation, PosesStoreJointsByComponent)
+{
+    Animation::Pose pose(11);
+    EXPECT_EQ(pose.jointCount(), 11U);
+    EXPECT_EQ(pose.component(Animation::PoseComponent::ScaleZ).size(), 11U);
+
+    for (size_t joint = 0; joint < pose.jointCount(); joint++)
+    {
+        const auto value = static_cast<float>(joint);
+        pose.setJoint(joint, { .translation = { value, value + 0.1F, value + 0.2F },
+                                 .rotation = { 0.0F, 0.0F, 0.6F, 0.8F },
+                                 .scale = { value + 1.0F, 1.0F, 1.0F } });
+    }
+    EXPECT_EQ(pose.component(Animation::PoseComponent::TranslationX)[7], 7.0F);
+    EXPECT_EQ(pose.component(Animation::PoseComponent::RotationW)[3], 0.8F);
+    EXPECT_EQ(pose.component(Animation::PoseComponent::ScaleX)[10], 11.0F);
+
+    const Animation::Transform joint = pose.joint(5);
+    EXPECT_EQ(joint.translation, (Float3 { 5.0F, 5.1F, 5.2F }));
+    EXPECT_EQ(joint.rotation, (Quaternion { 0.0F, 0.0F, 0.6F, 0.8F }));
+    EXPECT_EQ(joint.scale, (Float3 { 6.0F, 1.0F, 1.0F }));
+}
+
+TEST_F(AnimationTest, CompressedClipsFollowTheSource)
+{
+    const Animation::CompressionOptions options;
+    EXPECT_EQ(m_clip.jointCount(), m_skeleton.jointCount());
+    EXPECT_FLOAT_EQ(m_clip.duration(), 1.0F);
+
+    // Key reduction tolerance plus the quantization step of the track ranges, which
+    // are at most a unit wide here
+    const double translationBound = options.translationTolerance + 1.0 / 65'535.0;
+    const double rotationBound = options.rotationTolerance + 2.0e-4;
+    const double scaleBound = options.scaleTolerance + 1.0 / 65'535.0;
+
+    double translationError = 0.0;
+    double rotationError = 0.0;
+    double scaleError = 0.0;
+    for (const auto& channel : m_scene.animations.front().channels)
+    {
+        const auto   node = std::ranges::find(m_skeleton.nodes, channel.node);
+        const size_t joint = node - m_skeleton.nodes.begin();
+        for (int step = 0; step <= 90; step++)
+        {
+            const float                time = static_cast<float>(step) / 90.0F;
+            const auto                 expected = sourceValue(channel, time);
+            const Animation::Transform actual = m_clip.sampleJoint(joint, time);
+            switch (channel.path)
+            {
+            case Assets::AnimationPath::Translation:
+            case Assets::AnimationPath::Scale:
+            {
+                const bool   isTranslation = channel.path == Assets::AnimationPath::Translation;
+                const auto&  value = isTranslation ? actual.translation : actual.scale;
+                const double distance = std::hypot(value[0] - expected[0],
+                    value[1] - expected[1], value[2] - expected[2]);
+                (isTranslation ? translationError : scaleError)
+                    = std::max(isTranslation ? translationError : scaleError, distance);
+                break;
+            }
+            case Assets::AnimationPath::Rotation:
+                rotationError = std::max(rotationError,
+                    angleBetween(actual.rotation,
+                        { static_cast<float>(expected[0]), static_cast<float>(expected[1]),
+                            static_cast<float>(expected[2]), static_cast<float>(expected[3]) }));
+                break;
+            }
+        }
+    }
+    EXPECT_LE(translationError, translationBound);
+    EXPECT_LE(rotationError, rotationBound);
+    EXPECT_LE(scaleError, scaleBound);
+}
+
+TEST_F(AnimationTest, CompressionDropsKeysInterpolationReproduces)
+{
+    // Three tracks per joint, each at most a key per resampled frame
+    const size_t frames = 31;
+    EXPECT_LT(m_clip.keyCount(), m_skeleton.jointCount() * 3 * frames);
+
+    // Unanimated tracks and the linear sideways motion of the root need two keys
+    Assets::Animation linear = m_scene.animations.front();
+    linear.channels.resize(1);
+    for (size_t key = 0; key < linear.channels[0].times.size(); key++)
+    {
+        linear.channels[0].values[key * 3 + 1] = 0.0F;
+    }
+    const auto still = Animation::Clip::compress(linear, m_skeleton);
+    EXPECT_LE(still.keyCount(), m_skeleton.jointCount() * 3 * 2);
+    EXPECT_LT(still.sizeBytes(), m_clip.sizeBytes());
+
+    const size_t uncompressed
+        = m_skeleton.jointCount() * frames * Animation::g_poseComponentCount * sizeof(float);
+    EXPECT_LT(m_clip.sizeBytes(), uncompressed / 2);
+}
+
+TEST_F(AnimationTest, CompressionRejectsClipsTooLongToAddress)
+{
+    Assets::Animation endless = m_scene.animations.front();
+    endless.duration = 1.0e4F;
+    EXPECT_THROW((void)Animation::Clip::compress(endless, m_skeleton), std::runtime_error);
+}
+
+TEST_F(AnimationTest, BatchedSamplingMatchesTheScalarReference)
+{
+    // Forward playback, backwards, out of order and past either end, so both the
+    // cursor fast path and the search run
+    std::vector<float> times;
+    for (int step = 0; step <= 120; step++)
+    {
+        times.push_back(static_cast<float>(step) / 120.0F);
+    }
+    for (int step = 120; step >= 0; step -= 7)
+    {
+        times.push_back(static_cast<float>(step) / 120.0F);
+    }
+    times.insert(times.end(), { 0.9F, 0.1F, 0.55F, -1.0F, 2.0F, 0.3F });
+
+    Animation::ClipSampler sampler;
+    Animation::Pose        pose;
+    for (const float time : times)
+    {
+        SCOPED_TRACE(time);
+        sampler.sample(m_clip, time, pose);
+        ASSERT_EQ(pose.jointCount(), m_clip.jointCount());
+        for (size_t joint = 0; joint < m_clip.jointCount(); joint++)
+        {
+            const Animation::Transform expected = m_clip.sampleJoint(joint, time);
+            const Animation::Transform actual = pose.joint(joint);
+            for (size_t i = 0; i < 3; i++)
+            {
+                ASSERT_NEAR(actual.translation[i], expected.translation[i], 1.0e-6F);
+                ASSERT_NEAR(actual.scale[i], expected.scale[i], 1.0e-6F);
+            }
+            for (size_t i = 0; i < 4; i++)
+            {
+                ASSERT_NEAR(actual.rotation[i], expected.rotation[i], 1.0e-6F);
+            }
+        }
+    }
+}
+
+TEST_F(AnimationTest, SamplersMoveBetweenClips)
+{
+    const auto other = Animation::Clip::compress(
+        Tests::createCharacter(5, 6, 61).animations.front(), m_skeleton);
+
+    Animation::ClipSampler shared;
+    Animation::ClipSampler fresh;
+    Animation::Pose        sharedPose;
+    Animation::Pose        freshPose;
+    shared.sample(m_clip, 0.8F, sharedPose);
+    shared.sample(other, 0.4F, sharedPose);
+    fresh.sample(other, 0.4F, freshPose);
+    for (size_t component = 0; component < Animation::g_poseComponentCount; component++)
+    {
+        const auto kind = static_cast<Animation::PoseComponent>(component);
+        EXPECT_TRUE(std::ranges::equal(sharedPose.component(kind), freshPose.component(kind)));
+    }
+}
+
+TEST_F(AnimationTest, UnanimatedJointsHoldTheBindPose)
+{
+    Assets::Animation rootOnly = m_scene.animations.front();
+    rootOnly.channels.resize(1);
+    const auto clip = Animation::Clip::compress(rootOnly, m_skeleton);
+
+    Animation::ClipSampler sampler;
+    Animation::Pose        pose;
+    sampler.sample(clip, 0.37F, pose);
+    for (size_t joint = 1; joint < m_skeleton.jointCount(); joint++)
+    {
+        const Animation::Transform& bind = m_skeleton.bindPose[joint];
+        const Animation::Transform  actual = pose.joint(joint);
+        for (size_t i = 0; i < 3; i++)
+        {
+            EXPECT_NEAR(actual.translation[i], bind.translation[i], 1.0e-6F);
+            EXPECT_NEAR(actual.scale[i], bind.scale[i], 1.0e-6F);
+        }
+        EXPECT_LT(angleBetween(actual.rotation, bind.rotation), 1.0e-4);
+    }
+}
+
+TEST_F(AnimationTest, ModelTransformsMatchAScalarReference)
+{
+    Animation::ClipSampler sampler;
+    Animation::Pose        pose;
+    sampler.sample(m_clip, 0.63F, pose);
+
+    std::vector<Assets::Matrix4> model(m_skeleton.jointCount());
+    Animation::computeModelTransforms(m_skeleton, pose, model);
+    for (size_t joint = 0; joint < m_skeleton.jointCount(); joint++)
+    {
+        SCOPED_TRACE(joint);
+        EXPECT_LT(largestDifference(model[joint], referenceModel(m_skeleton, pose, joint)),
+            1.0e-5F);
+    }
+}
+
+TEST_F(AnimationTest, SkinningMatricesUndoTheBindPose)
+{
+    // In the bind pose every joint sits where its inverse bind matrix expects it
+    Animation::Pose pose(m_skeleton.jointCount());
+    for (size_t joint = 0; joint < m_skeleton.jointCount(); joint++)
+    {
+        pose.setJoint(joint, m_skeleton.bindPose[joint]);
+    }
+    std::vector<Assets::Matrix4> model(m_skeleton.jointCount());
+    std::vector<Assets::Matrix4> skinning(m_skeleton.skinJoints.size());
+    Animation::computeModelTransforms(m_skeleton, pose, model);
+    Animation::computeSkinningMatrices(m_skeleton, model, skinning);
+    for (const auto& matrix : skinning)
+    {
+        EXPECT_LT(largestDifference(matrix, Tests::translationMatrix({})), 1.0e-6F);
+    }
+
+    // Posed, each is the inverse bind matrix followed by the joint's model transform
+    Animation::ClipSampler sampler;
+    sampler.sample(m_clip, 0.25F, pose);
+    Animation::computeModelTransforms(m_skeleton, pose, model);
+    Animation::computeSkinningMatrices(m_skeleton, model, skinning);
+
+    FrameArena arena;
+    const auto allocated = Animation::computeSkinningMatrices(m_skeleton, model, arena);
+    ASSERT_EQ(allocated.size(), skinning.size());
+    for (size_t i = 0; i < skinning.size(); i++)
+    {
+        const auto expected = multiply(
+            m_skeleton.inverseBindMatrices[i], model[m_skeleton.skinJoints[i]]);
+        EXPECT_LT(largestDifference(skinning[i], expected), 1.0e-6F);
+        EXPECT_EQ(allocated[i], skinning[i]);
+    }
+}
@@ -0,0 +1,262 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "AsyncPipelineCompiler.hpp"
+#include "ThreadPool.hpp"
+
+namespace
+{
+    using Compiler = AsyncPipelineCompiler<std::string>;
+
+    PipelineDescription describe(const std::string& fragmentFunction)
+    {
+        PipelineDescription description;
+        description.vertexFunction = "vertexFunction";
+        description.fragmentFunction = fragmentFunction;
+        description.colorAttachments = { { .pixelFormat = 81 } };
+        return description;
+    }
+
+    /// Stands in for the Metal compiler: records what it compiled and on which
+    /// thread, and holds every compilation until released.
+    class MockCompiler
+    {
+    public:
+        Compiler::CompileFunction function()
+        {
+            return [this](const PipelineDescription& description) {
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_started.push_back(description.fragmentFunction);
+                    m_threads.push_back(std::this_thread::get_id());
+                    m_changed.notify_all();
+                    m_changed.wait(lock, [this] { return m_released; });
+                }
+                if (description.fragmentFunction == "broken")
+                {
+                    throw std::runtime_error("undefined symbol");
+                }
+                return "compiled " + description.fragmentFunction;
+            };
+        }
+
+        void release()
+        {
+            std::lock_guard lock(m_mutex);
+            m_released = true;
+            m_changed.notify_all();
+        }
+
+        /// Blocks until count compilations have started.
+        void waitForStarted(const size_t count)
+        {
+            std::unique_lock lock(m_mutex);
+            m_changed.wait(lock, [&] { return m_started.size() >= count; });
+        }
+
+        std::vector<std::string> started()
+        {
+            std::lock_guard lock(m_mutex);
+            return m_started;
+        }
+
+        std::vector<std::thread::id> threads()
+        {
+            std::lock_guard lock(m_mutex);
+            return m_threads;
+        }
+
+    private:
+        std::mutex                   m_mutex;
+        std::condition_variable      m_changed;
+        bool                         m_released = false;
+        std::vector<std::string>     m_started;
+        std::vector<std::thread::id> m_threads;
+    };
+} // namespace
+
+TEST(AsyncPipelineCompiler, RequestReturnsBeforeCompilationFinishes)
+{
+    MockCompiler mock;
+    Compiler     compiler(mock.function());
+
+    auto handle = compiler.request(describe("fragment"));
+    ASSERT_TRUE(handle.isValid());
+    EXPECT_FALSE(handle.isReady());
+    EXPECT_EQ(handle.get(), nullptr);
+    const std::string fallback = "fallback";
+    EXPECT_EQ(handle.valueOr(fallback), "fallback");
+
+    mock.waitForStarted(1);
+    EXPECT_EQ(handle.status(), PipelineStatus::Compiling);
+    mock.release();
+    handle.wait();
+
+    ASSERT_TRUE(handle.isReady());
+    EXPECT_EQ(*handle.get(), "compiled fragment");
+    EXPECT_NE(mock.threads().front(), std::this_thread::get_id());
+}
+
+TEST(AsyncPipelineCompiler, DuplicateRequestsCoalesce)
+{
+    MockCompiler mock;
+    Compiler     compiler(mock.function());
+
+    auto first = compiler.request(describe("fragment"));
+    mock.waitForStarted(1);
+    auto second = compiler.request(describe("fragment"));
+    auto queued = compiler.request(describe("other"), PipelinePriority::Low);
+    auto queuedAgain = compiler.request(describe("other"));
+    EXPECT_EQ(first.key(), second.key());
+    EXPECT_EQ(queued.key(), queuedAgain.key());
+
+    mock.release();
+    compiler.waitIdle();
+    EXPECT_EQ(mock.started(), (std::vector<std::string> { "fragment", "other" }));
+    EXPECT_EQ(second.get(), first.get());
+    EXPECT_EQ(*queued.get(), "compiled other");
+
+    // Compiled pipelines are served without compiling again
+    auto later = compiler.request(describe("fragment"));
+    EXPECT_TRUE(later.isReady());
+
+    const auto statistics = compiler.statistics();
+    EXPECT_EQ(statistics.requests, 5U);
+    EXPECT_EQ(statistics.deduplicated, 3U);
+    EXPECT_EQ(statistics.compiled, 2U);
+}
+
+TEST(AsyncPipelineCompiler, HighPriorityRequestsCompileFirst)
+{
+    MockCompiler mock;
+    Compiler     compiler(mock.function());
+
+    auto blocking = compiler.request(describe("blocking"));
+    mock.waitForStarted(1);
+    auto lowA = compiler.request(describe("lowA"), PipelinePriority::Low);
+    auto lowB = compiler.request(describe("lowB"), PipelinePriority::Low);
+    auto high = compiler.request(describe("high"));
+    auto promoted = compiler.request(describe("lowB"));
+
+    mock.release();
+    compiler.waitIdle();
+    EXPECT_EQ(mock.started(),
+        (std::vector<std::string> { "blocking", "high", "lowB", "lowA" }));
+}
+
+TEST(AsyncPipelineCompiler, CancelledRequestsAreNotCompiled)
+{
+    MockCompiler mock;
+    Compiler     compiler(mock.function());
+
+    auto blocking = compiler.request(describe("blocking"));
+    mock.waitForStarted(1);
+    auto cancelled = compiler.request(describe("cancelled"));
+    EXPECT_FALSE(blocking.cancel());
+    EXPECT_TRUE(cancelled.cancel());
+    EXPECT_EQ(cancelled.status(), PipelineStatus::Cancelled);
+    cancelled.wait();
+
+    mock.release();
+    compiler.waitIdle();
+    EXPECT_EQ(mock.started(), (std::vector<std::string> { "blocking" }));
+    EXPECT_EQ(compiler.statistics().cancelled, 1U);
+
+    // Asking again replaces the cancelled request
+    auto retried = compiler.request(describe("cancelled"));
+    retried.wait();
+    EXPECT_TRUE(retried.isReady());
+    EXPECT_EQ(cancelled.status(), PipelineStatus::Cancelled);
+}
+
+TEST(AsyncPipelineCompiler, FailuresAreReportedOnce)
+{
+    MockCompiler mock;
+    mock.release();
+    Compiler compiler(mock.function());
+
+    auto handle = compiler.request(describe("broken"));
+    handle.wait();
+    EXPECT_EQ(handle.status(), PipelineStatus::Failed);
+    EXPECT_EQ(handle.error(), "undefined symbol");
+
+    auto again = compiler.request(describe("broken"));
+    EXPECT_EQ(again.status(), PipelineStatus::Failed);
+    EXPECT_EQ(mock.started().size(), 1U);
+    EXPECT_EQ(compiler.statistics().failed, 1U);
+}
+
+TEST(AsyncPipelineCompiler, ShutdownWithCompilationsInFlight)
+{
+    MockCompiler                  mock;
+    Compiler::Handle              running;
+    std::vector<Compiler::Handle> queued;
+    std::thread                   releaser;
+    {
+        Compiler compiler(mock.function(), 2);
+        running = compiler.request(describe("running"));
+        auto other = compiler.request(describe("other"));
+        mock.waitForStarted(2);
+        for (int i = 0; i < 8; i++)
+        {
+            queued.push_back(compiler.request(describe(std::to_string(i))));
+        }
+
+        releaser = std::thread([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            mock.release();
+        });
+        // The destructor cancels the queue and waits for the two running compiles
+    }
+    releaser.join();
+
+    EXPECT_EQ(running.status(), PipelineStatus::Ready);
+    for (const auto& handle : queued)
+    {
+        EXPECT_EQ(handle.status(), PipelineStatus::Cancelled);
+    }
+    EXPECT_EQ(mock.started().size(), 2U);
+}
+
+TEST(AsyncPipelineCompiler, ParallelLoopsNeverRunCompilations)
+{
+    MockCompiler mock;
+    Compiler     compiler(mock.function());
+    ThreadPool   threadPool(2);
+
+    std::vector<Compiler::Handle> handles;
+    for (int i = 0; i < 16; i++)
+    {
+        handles.push_back(compiler.request(describe(std::to_string(i))));
+    }
+
+    // Waiters of a parallel loop help with queued pool tasks; compilations must not
+    // be among them
+    std::atomic<size_t> iterations = 0;
+    threadPool.parallelFor(1000, 10, [&](size_t begin, size_t end) {
+        iterations += end - begin;
+    });
+    EXPECT_EQ(iterations, 1000U);
+
+    mock.release();
+    compiler.waitIdle();
+    for (const auto& id : mock.threads())
+    {
+        EXPECT_NE(id, std::this_thread::get_id());
+    }
+    EXPECT_EQ(compiler.statistics().compiled, 16U);
+}
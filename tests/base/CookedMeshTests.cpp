@@ -0,0 +1,311 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "CookedMesh.hpp"
+#include "TemporaryDirectory.hpp"
+#include "TestMeshes.hpp"
+
+namespace
+{
+    using Float2 = std::array<float, 2>;
+    using Float3 = std::array<float, 3>;
+    using Float4 = std::array<float, 4>;
+
+    Assets::Mesh mesh(std::string name, std::vector<Assets::Primitive> primitives)
+    {
+        Assets::Mesh result;
+        result.name = std::move(name);
+        result.primitives = std::move(primitives);
+        return result;
+    }
+
+    template <typename T>
+    std::vector<T> values(const std::span<const std::byte> bytes)
+    {
+        std::vector<T> result(bytes.size() / sizeof(T));
+        std::memcpy(result.data(), bytes.data(), result.size() * sizeof(T));
+        return result;
+    }
+
+    std::vector<uint32_t> indices(const Assets::CookedMeshFile& file,
+        const Assets::CookedPrimitive& primitive, const Assets::CookedLod& lod)
+    {
+        const auto bytes = file.indices(primitive, lod);
+        if (primitive.indexFormat == Assets::IndexFormat::UInt32)
+        {
+            return values<uint32_t>(bytes);
+        }
+        const auto narrow = values<uint16_t>(bytes);
+        return { narrow.begin(), narrow.end() };
+    }
+
+    /// Cooks meshes into a file of the test's temporary directory and overwrites the
+    /// bytes at offset with patch, if given.
+    std::filesystem::path writeCooked(const TemporaryDirectory& directory,
+        const std::vector<Assets::Mesh>& meshes, const size_t offset = 0,
+        const std::span<const std::byte> patch = {})
+    {
+        std::vector<std::byte> bytes = Assets::cookMeshes(meshes);
+        std::ranges::copy(patch, bytes.begin() + static_cast<ptrdiff_t>(offset));
+        return directory.write("meshes.cmsh",
+            { reinterpret_cast<const char*>(bytes.data()), bytes.size() });
+    }
+
+    template <typename T>
+    std::span<const std::byte> asBytes(const T& value)
+    {
+        return std::as_bytes(std::span(&value, 1));
+    }
+} // namespace
+
+TEST(CookedMesh, RoundTripsFloatStreams)
+{
+    const TemporaryDirectory directory;
+    Assets::Primitive        grid = Tests::createGrid(8, 0.25F);
+    grid.material = 3;
+    const auto path = directory.path() / "grid.cmsh";
+    Assets::writeCookedMeshes(path, std::vector { mesh("Grid", { grid }) });
+
+    const Assets::CookedMeshFile file(path);
+    ASSERT_EQ(file.meshCount(), 1U);
+    EXPECT_EQ(file.meshName(0), "Grid");
+    ASSERT_EQ(file.primitives(0).size(), 1U);
+
+    const Assets::CookedPrimitive& primitive = file.primitives(0)[0];
+    EXPECT_EQ(primitive.material, 3);
+    EXPECT_EQ(primitive.vertexCount, grid.streams.positions.size());
+    EXPECT_EQ(primitive.indexFormat, Assets::IndexFormat::UInt16);
+    EXPECT_EQ(primitive.boundsMin, (std::array { 0.0F, -0.25F, 0.0F }));
+    EXPECT_EQ(primitive.boundsMax, (std::array { 1.0F, 0.25F, 1.0F }));
+
+    using Assets::VertexAttribute;
+    EXPECT_EQ(primitive.stream(VertexAttribute::Position).format,
+        Assets::VertexStreamFormat::Float3);
+    EXPECT_EQ(values<Float3>(file.stream(primitive, VertexAttribute::Position)),
+        grid.streams.positions);
+    EXPECT_EQ(values<Float3>(file.stream(primitive, VertexAttribute::Normal)),
+        grid.streams.normals);
+    EXPECT_EQ(values<Float2>(file.stream(primitive, VertexAttribute::TexCoord)),
+        grid.streams.texCoords);
+    EXPECT_EQ(values<Float4>(file.stream(primitive, VertexAttribute::Tangent)),
+        grid.streams.tangents);
+    EXPECT_EQ(values<Float4>(file.stream(primitive, VertexAttribute::Color)),
+        grid.streams.colors);
+
+    ASSERT_EQ(file.lods(primitive).size(), 1U);
+    const Assets::CookedLod& lod = file.lods(primitive)[0];
+    EXPECT_EQ(indices(file, primitive, lod), grid.indices);
+    EXPECT_EQ(lod.error, 0.0F);
+    EXPECT_TRUE(file.meshlets(lod).empty());
+    EXPECT_FALSE(std::filesystem::exists(directory.path() / "grid.cmsh.tmp"));
+}
+
+TEST(CookedMesh, CooksInterleavedVerticesLikeStreams)
+{
+    const Assets::Primitive streams = Tests::createGrid(4, 0.5F);
+    Assets::Primitive       interleaved;
+    interleaved.indices = streams.indices;
+    for (size_t vertex = 0; vertex < streams.streams.positions.size(); vertex++)
+    {
+        interleaved.vertices.push_back({ streams.streams.positions[vertex],
+            streams.streams.normals[vertex], streams.streams.texCoords[vertex],
+            streams.streams.tangents[vertex], streams.streams.colors[vertex] });
+    }
+
+    EXPECT_EQ(Assets::cookMeshes(std::vector { mesh("A", { streams }) }),
+        Assets::cookMeshes(std::vector { mesh("A", { interleaved }) }));
+}
+
+TEST(CookedMesh, AlignsEveryArray)
+{
+    const TemporaryDirectory directory;
+    const std::vector        meshes { mesh("Sphere", { Tests::createSphere(9, 13) }),
+        mesh("Grid", { Tests::createGrid(7, 0.1F), Tests::createGrid(3) }) };
+    const auto               path = directory.path() / "meshes.cmsh";
+    Assets::writeCookedMeshes(path, meshes,
+        { .quantize = true, .buildMeshlets = true, .generateLods = true, .lods = {} });
+
+    const Assets::CookedMeshFile file(path);
+    const auto                   offset = [&file](const auto span) {
+        return static_cast<size_t>(reinterpret_cast<const std::byte*>(span.data())
+            - file.bytes().data());
+    };
+    EXPECT_EQ(file.bytes().size() % 16, 0U);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(file.bytes().data()) % 16, 0U);
+    for (size_t meshIndex = 0; meshIndex < file.meshCount(); meshIndex++)
+    {
+        EXPECT_EQ(file.meshName(meshIndex), meshes[meshIndex].name);
+        EXPECT_EQ(offset(file.primitives(meshIndex)) % 16, 0U);
+        for (const auto& primitive : file.primitives(meshIndex))
+        {
+            for (size_t attribute = 0; attribute < Assets::g_vertexAttributeCount; attribute++)
+            {
+                const auto stream =
+                    file.stream(primitive, static_cast<Assets::VertexAttribute>(attribute));
+                if (!stream.empty())
+                {
+                    EXPECT_EQ(offset(stream) % 16, 0U);
+                }
+            }
+            for (const auto& lod : file.lods(primitive))
+            {
+                EXPECT_EQ(offset(file.indices(primitive, lod)) % 16, 0U);
+                EXPECT_EQ(offset(file.meshletVertices(lod)) % 16, 0U);
+                EXPECT_EQ(offset(file.meshletTriangles(lod)) % 16, 0U);
+            }
+        }
+    }
+}
+
+TEST(CookedMesh, UsesWideIndicesOnlyWhenNeeded)
+{
+    // 255 x 255 quads have exactly the 65536 vertices 16 bit indices address
+    const std::vector meshes { mesh("Small", { Tests::createGrid(255) }),
+        mesh("Large", { Tests::createGrid(256) }) };
+    const TemporaryDirectory directory;
+    const auto               path = directory.path() / "meshes.cmsh";
+    Assets::writeCookedMeshes(path, meshes);
+
+    const Assets::CookedMeshFile file(path);
+    const auto&                  small = file.primitives(0)[0];
+    const auto&                  large = file.primitives(1)[0];
+    EXPECT_EQ(small.indexFormat, Assets::IndexFormat::UInt16);
+    EXPECT_EQ(large.indexFormat, Assets::IndexFormat::UInt32);
+    EXPECT_EQ(indices(file, small, file.lods(small)[0]), meshes[0].primitives[0].indices);
+    EXPECT_EQ(indices(file, large, file.lods(large)[0]), meshes[1].primitives[0].indices);
+}
+
+TEST(CookedMesh, QuantizesWithinTheBounds)
+{
+    const Assets::Primitive  sphere = Tests::createSphere(16, 24);
+    const TemporaryDirectory directory;
+    const auto               path = directory.path() / "sphere.cmsh";
+    Assets::writeCookedMeshes(path, std::vector { mesh("Sphere", { sphere }) },
+        { .quantize = true, .buildMeshlets = false, .generateLods = false, .lods = {} });
+
+    const Assets::CookedMeshFile   file(path);
+    const Assets::CookedPrimitive& primitive = file.primitives(0)[0];
+    using Assets::VertexAttribute;
+    using Assets::VertexStreamFormat;
+    EXPECT_EQ(primitive.stream(VertexAttribute::Position).format,
+        VertexStreamFormat::UShort4Normalized);
+    EXPECT_EQ(primitive.stream(VertexAttribute::Normal).format,
+        VertexStreamFormat::Short2Normalized);
+    EXPECT_EQ(primitive.stream(VertexAttribute::TexCoord).format, VertexStreamFormat::Half2);
+    EXPECT_EQ(primitive.stream(VertexAttribute::Tangent).format, VertexStreamFormat::None);
+    EXPECT_TRUE(file.stream(primitive, VertexAttribute::Tangent).empty());
+
+    const auto positions =
+        values<std::array<uint16_t, 4>>(file.stream(primitive, VertexAttribute::Position));
+    ASSERT_EQ(positions.size(), sphere.streams.positions.size());
+    for (size_t vertex = 0; vertex < positions.size(); vertex++)
+    {
+        const auto decoded = Assets::dequantizePosition(
+            positions[vertex], primitive.boundsMin, primitive.boundsMax);
+        for (size_t axis = 0; axis < 3; axis++)
+        {
+            EXPECT_NEAR(decoded[axis], sphere.streams.positions[vertex][axis], 2.0F / 65535.0F);
+        }
+    }
+}
+
+TEST(CookedMesh, StoresLodChainsAndMeshlets)
+{
+    const Assets::Primitive  sphere = Tests::createSphere(32, 48);
+    const TemporaryDirectory directory;
+    const auto               path = directory.path() / "sphere.cmsh";
+    Assets::writeCookedMeshes(path, std::vector { mesh("Sphere", { sphere }) },
+        { .quantize = false,
+            .buildMeshlets = true,
+            .generateLods = true,
+            .lods = { .maxLods = 4,
+                .ratio = 0.5F,
+                .maxError = 0.2F,
+                .minTriangles = 32,
+                .simplify = {} } });
+
+    const Assets::CookedMeshFile   file(path);
+    const Assets::CookedPrimitive& primitive = file.primitives(0)[0];
+    const auto                     lods = file.lods(primitive);
+    ASSERT_GT(lods.size(), 1U);
+    ASSERT_LE(lods.size(), 4U);
+    EXPECT_EQ(lods[0].indexCount, sphere.indices.size());
+    EXPECT_EQ(lods[0].error, 0.0F);
+    for (size_t level = 1; level < lods.size(); level++)
+    {
+        EXPECT_LT(lods[level].indexCount, lods[level - 1].indexCount);
+        EXPECT_GE(lods[level].error, lods[level - 1].error);
+    }
+
+    for (const auto& lod : lods)
+    {
+        // Meshlets together hold exactly the triangles of their LOD
+        const auto lodIndices = indices(file, primitive, lod);
+        const auto vertices = file.meshletVertices(lod);
+        const auto triangles = file.meshletTriangles(lod);
+        size_t     triangleCount = 0;
+        ASSERT_FALSE(file.meshlets(lod).empty());
+        for (const auto& meshlet : file.meshlets(lod))
+        {
+            for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+            {
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    const uint8_t local = triangles[meshlet.triangleOffset + triangle * 3 + corner];
+                    ASSERT_LT(local, meshlet.vertexCount);
+                    EXPECT_LT(vertices[meshlet.vertexOffset + local], primitive.vertexCount);
+                }
+            }
+            triangleCount += meshlet.triangleCount;
+        }
+        EXPECT_EQ(triangleCount * 3, lodIndices.size());
+    }
+}
+
+TEST(CookedMesh, RejectsInvalidFiles)
+{
+    const TemporaryDirectory directory;
+    const std::vector        meshes { mesh("Grid", { Tests::createGrid(4) }) };
+    const auto               open = [](const std::filesystem::path& path) {
+        return Assets::CookedMeshFile(path);
+    };
+
+    EXPECT_THROW(open(directory.write("empty.cmsh", "")), std::runtime_error);
+    EXPECT_THROW(open(directory.write("text.cmsh", std::string(128, 'x'))), std::runtime_error);
+
+    const uint32_t version = 1;
+    EXPECT_THROW(open(writeCooked(directory, meshes, offsetof(Assets::CookedMeshHeader, version),
+                     asBytes(version))),
+        std::runtime_error);
+
+    const uint64_t fileSize = 16;
+    EXPECT_THROW(open(writeCooked(directory, meshes,
+                     offsetof(Assets::CookedMeshHeader, fileSize), asBytes(fileSize))),
+        std::runtime_error);
+
+    const uint32_t primitiveCount = 1000;
+    EXPECT_THROW(open(writeCooked(directory, meshes,
+                     offsetof(Assets::CookedMeshHeader, primitiveCount), asBytes(primitiveCount))),
+        std::runtime_error);
+
+    // A stream pointing past the end of the file
+    const std::vector<std::byte> bytes = Assets::cookMeshes(meshes);
+    Assets::CookedMeshHeader     header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    const uint64_t streamOffset = bytes.size();
+    EXPECT_THROW(open(writeCooked(directory, meshes,
+                     header.primitivesOffset + offsetof(Assets::CookedPrimitive, streams)
+                         + offsetof(Assets::CookedStream, offset),
+                     asBytes(streamOffset))),
+        std::runtime_error);
+
+    EXPECT_NO_THROW(open(writeCooked(directory, meshes)));
+}
@@ -0,0 +1,385 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Ecs.hpp"
+#include "EcsScheduler.hpp"
+#include "ThreadPool.hpp"
+
+namespace
+{
+    struct Position
+    {
+        float x = 0.0F;
+        float y = 0.0F;
+    };
+
+    struct Velocity
+    {
+        float x = 0.0F;
+        float y = 0.0F;
+    };
+
+    struct Health
+    {
+        int value = 0;
+    };
+
+    /// Large enough that an archetype holds only a few entities per chunk.
+    struct Payload
+    {
+        std::array<uint32_t, 250> values {};
+    };
+
+    Payload payload(const uint32_t seed)
+    {
+        Payload result;
+        for (size_t i = 0; i < result.values.size(); i++)
+        {
+            result.values[i] = seed * 1'000 + static_cast<uint32_t>(i);
+        }
+        return result;
+    }
+
+    /// Tracks the access of the systems that are running, to catch conflicting ones
+    /// that overlap.
+    class AccessMonitor
+    {
+    public:
+        void enter(const Ecs::Access& access)
+        {
+            const std::lock_guard lock(m_mutex);
+            for (const auto& running : m_running)
+            {
+                const bool writesUsed = (access.writes & (running.reads | running.writes)) != 0;
+                const bool usesWritten = (running.writes & (access.reads | access.writes)) != 0;
+                if (writesUsed || usesWritten)
+                {
+                    m_conflicts++;
+                }
+            }
+            m_running.push_back(access);
+            m_maxRunning = std::max(m_maxRunning, m_running.size());
+        }
+
+        void leave(const Ecs::Access& access)
+        {
+            const std::lock_guard lock(m_mutex);
+            for (auto it = m_running.begin(); it != m_running.end(); ++it)
+            {
+                if (it->reads == access.reads && it->writes == access.writes)
+                {
+                    m_running.erase(it);
+                    return;
+                }
+            }
+        }
+
+        [[nodiscard]] size_t conflicts() const
+        {
+            const std::lock_guard lock(m_mutex);
+            return m_conflicts;
+        }
+
+        [[nodiscard]] size_t maxRunning() const
+        {
+            const std::lock_guard lock(m_mutex);
+            return m_maxRunning;
+        }
+
+    private:
+        mutable std::mutex       m_mutex;
+        std::vector<Ecs::Access> m_running;
+        size_t                   m_conflicts = 0;
+        size_t                   m_maxRunning = 0;
+    };
+} // namespace
+
+TEST(Ecs, ComponentsSurviveArchetypeMovesAcrossChunks)
+{
+    Ecs::World               world;
+    std::vector<Ecs::Entity> entities;
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        entities.push_back(world.create(Position { static_cast<float>(i), 1.0F }, payload(i)));
+    }
+
+    size_t chunks = 0;
+    world.forEachChunk<Payload>([&](std::span<const Ecs::Entity>, Payload*) { chunks++; });
+    ASSERT_GT(chunks, 4U);
+
+    // Moves entities out of the middle of full chunks into new archetypes and back,
+    // which also moves the last entity of each source archetype into the hole
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        if (i % 2 == 1)
+        {
+            world.add(entities[i], Velocity { static_cast<float>(i), 2.0F });
+        }
+        if (i % 3 == 0)
+        {
+            world.remove<Position>(entities[i]);
+        }
+    }
+    for (uint32_t i = 0; i < 200; i += 5)
+    {
+        world.destroy(entities[i]);
+    }
+    for (uint32_t i = 1; i < 200; i += 10)
+    {
+        world.remove<Velocity>(entities[i]);
+    }
+
+    EXPECT_EQ(world.entityCount(), 160U);
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        const Ecs::Entity entity = entities[i];
+        if (i % 5 == 0)
+        {
+            EXPECT_FALSE(world.isAlive(entity)) << "entity " << i;
+            continue;
+        }
+        ASSERT_TRUE(world.isAlive(entity)) << "entity " << i;
+        ASSERT_TRUE(world.has<Payload>(entity));
+        EXPECT_EQ(world.get<Payload>(entity)->values, payload(i).values) << "entity " << i;
+
+        EXPECT_EQ(world.has<Position>(entity), i % 3 != 0) << "entity " << i;
+        if (const auto* position = world.get<Position>(entity))
+        {
+            EXPECT_EQ(position->x, static_cast<float>(i));
+            EXPECT_EQ(position->y, 1.0F);
+        }
+
+        EXPECT_EQ(world.has<Velocity>(entity), i % 2 == 1 && i % 10 != 1) << "entity " << i;
+        if (const auto* velocity = world.get<Velocity>(entity))
+        {
+            EXPECT_EQ(velocity->x, static_cast<float>(i));
+            EXPECT_EQ(velocity->y, 2.0F);
+        }
+    }
+
+    // Chunk arrays line up with the entities they list
+    size_t visited = 0;
+    world.forEachChunk<const Payload>(
+        [&](const std::span<const Ecs::Entity> chunkEntities, const Payload* payloads) {
+            for (size_t row = 0; row < chunkEntities.size(); row++)
+            {
+                const uint32_t seed = payloads[row].values[0] / 1'000;
+                ASSERT_LT(seed, entities.size());
+                EXPECT_EQ(chunkEntities[row], entities[seed]);
+                visited++;
+            }
+        });
+    EXPECT_EQ(visited, 160U);
+}
+
+TEST(Ecs, AddOverwritesAndRemoveOfAMissingComponentDoesNothing)
+{
+    Ecs::World        world;
+    const Ecs::Entity entity = world.create(Health { 3 });
+    world.add(entity, Health { 7 });
+    world.remove<Velocity>(entity);
+    EXPECT_EQ(world.get<Health>(entity)->value, 7);
+    EXPECT_EQ(world.get<Velocity>(entity), nullptr);
+}
+
+TEST(Ecs, CommandBufferChangesApplyOnlyAtTheFlush)
+{
+    Ecs::World        world;
+    const Ecs::Entity first = world.create(Health { 1 });
+    const Ecs::Entity second = world.create(Health { 2 });
+
+    Ecs::CommandBuffer commands;
+    world.forEach<Health>([&](Health& health) {
+        if (health.value == 1)
+        {
+            commands.destroy(first);
+            commands.add(second, Velocity { 4.0F, 5.0F });
+            const auto pending = commands.create();
+            commands.add(pending, Health { 10 });
+            commands.add(pending, Position { 6.0F, 7.0F });
+            static_cast<void>(commands.create());
+        }
+    });
+
+    // Nothing changed while recording
+    EXPECT_FALSE(commands.empty());
+    EXPECT_TRUE(world.isAlive(first));
+    EXPECT_FALSE(world.has<Velocity>(second));
+    EXPECT_EQ(world.entityCount(), 2U);
+
+    const std::vector<Ecs::Entity> created = world.apply(commands);
+    EXPECT_TRUE(commands.empty());
+    EXPECT_FALSE(world.isAlive(first));
+    ASSERT_TRUE(world.has<Velocity>(second));
+    EXPECT_EQ(world.get<Velocity>(second)->y, 5.0F);
+    EXPECT_EQ(world.get<Health>(second)->value, 2);
+
+    ASSERT_EQ(created.size(), 2U);
+    EXPECT_EQ(world.get<Health>(created[0])->value, 10);
+    EXPECT_EQ(world.get<Position>(created[0])->x, 6.0F);
+    EXPECT_TRUE(world.isAlive(created[1]));
+    EXPECT_FALSE(world.has<Health>(created[1]));
+    EXPECT_EQ(world.entityCount(), 3U);
+
+    // Applying again does nothing
+    EXPECT_TRUE(world.apply(commands).empty());
+    EXPECT_EQ(world.entityCount(), 3U);
+}
+
+TEST(Ecs, StructuralChangesAreRejectedWhileIterating)
+{
+    Ecs::World        world;
+    const Ecs::Entity entity = world.create(Health { 1 });
+    world.forEach<Health>([&](Health&) {
+        EXPECT_THROW(world.create(Health { 2 }), std::runtime_error);
+        EXPECT_THROW(world.destroy(entity), std::runtime_error);
+        EXPECT_THROW(world.add(entity, Velocity {}), std::runtime_error);
+        EXPECT_THROW(world.remove<Health>(entity), std::runtime_error);
+    });
+    EXPECT_TRUE(world.isAlive(entity));
+    EXPECT_EQ(world.entityCount(), 1U);
+}
+
+TEST(Ecs, StaleHandlesAreRejectedAfterReuse)
+{
+    Ecs::World        world;
+    const Ecs::Entity stale = world.create(Health { 1 });
+    world.destroy(stale);
+    const Ecs::Entity reused = world.create(Health { 2 });
+
+    ASSERT_EQ(reused.index, stale.index);
+    EXPECT_NE(reused.generation, stale.generation);
+    EXPECT_FALSE(world.isAlive(stale));
+    EXPECT_TRUE(world.isAlive(reused));
+
+    EXPECT_THROW(static_cast<void>(world.get<Health>(stale)), std::runtime_error);
+    EXPECT_THROW(static_cast<void>(world.has<Health>(stale)), std::runtime_error);
+    EXPECT_THROW(world.destroy(stale), std::runtime_error);
+    EXPECT_THROW(world.add(stale, Velocity {}), std::runtime_error);
+    EXPECT_THROW(world.remove<Health>(stale), std::runtime_error);
+
+    // Recorded changes to the stale handle are skipped rather than applied to the
+    // entity that reuses its index
+    Ecs::CommandBuffer commands;
+    commands.add(stale, Health { 3 });
+    commands.add(stale, Velocity {});
+    commands.destroy(stale);
+    static_cast<void>(world.apply(commands));
+    EXPECT_TRUE(world.isAlive(reused));
+    EXPECT_EQ(world.get<Health>(reused)->value, 2);
+    EXPECT_FALSE(world.has<Velocity>(reused));
+}
+
+TEST(EcsScheduler, ConflictingSystemsNeverRunConcurrently)
+{
+    Ecs::World world;
+    for (int i = 0; i < 1'000; i++)
+    {
+        static_cast<void>(world.create(Position {}, Velocity { 1.0F, 1.0F }, Health { i }));
+    }
+
+    AccessMonitor  monitor;
+    Ecs::Scheduler scheduler;
+    const auto     addSystem = [&](const std::string& name, const Ecs::Access& access) {
+        scheduler.add(name, access, [&monitor, access](const Ecs::SystemContext&) {
+            monitor.enter(access);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            monitor.leave(access);
+        });
+    };
+    addSystem("move", Ecs::Access().read<Velocity>().write<Position>());
+    addSystem("damage", Ecs::Access().write<Health>());
+    addSystem("steer", Ecs::Access().read<Position>().write<Velocity>());
+    addSystem("report", Ecs::Access().read<Health>());
+    addSystem("audit", Ecs::Access().read<Health, Position>());
+    addSystem("render", Ecs::Access().read<Position>());
+    addSystem("heal", Ecs::Access().write<Health>());
+
+    ThreadPool pool(4);
+    for (int run = 0; run < 10; run++)
+    {
+        scheduler.run(world, pool);
+    }
+    EXPECT_EQ(monitor.conflicts(), 0U);
+
+    // Systems that do not conflict share a stage
+    EXPECT_GT(monitor.maxRunning(), 1U);
+    EXPECT_LT(scheduler.stageCount(), 7U);
+}
+
+TEST(EcsScheduler, ConflictingSystemsRunInTheOrderTheyWereAdded)
+{
+    Ecs::World world;
+    static_cast<void>(world.create(Health {}));
+
+    std::mutex               mutex;
+    std::vector<std::string> order;
+    Ecs::Scheduler           scheduler;
+    const auto               log = [&](std::string name) {
+        return [&, name](const Ecs::SystemContext&) {
+            const std::lock_guard lock(mutex);
+            order.push_back(name);
+        };
+    };
+    scheduler.add("write", Ecs::Access().write<Health>(), log("write"));
+    scheduler.add("read", Ecs::Access().read<Health>(), log("read"));
+    scheduler.add("rewrite", Ecs::Access().write<Health>(), log("rewrite"));
+
+    ThreadPool pool(4);
+    scheduler.run(world, pool);
+    EXPECT_EQ(order, (std::vector<std::string> { "write", "read", "rewrite" }));
+    EXPECT_EQ(scheduler.stageCount(), 3U);
+}
+
+TEST(EcsScheduler, CommandsApplyAfterAllStages)
+{
+    Ecs::World        world;
+    const Ecs::Entity entity = world.create(Health { 5 });
+
+    bool           sawVelocity = true;
+    Ecs::Scheduler scheduler;
+    scheduler.add("add", Ecs::Access().write<Health>(), [&](const Ecs::SystemContext& context) {
+        context.commands().add(entity, Velocity { 1.0F, 0.0F });
+    });
+    scheduler.add("check", Ecs::Access().read<Health>(),
+        [&](const Ecs::SystemContext&) { sawVelocity = world.has<Velocity>(entity); });
+    scheduler.add("destroy", Ecs::Access().write<Health>(), [&](const Ecs::SystemContext& context) {
+        context.commands().destroy(entity);
+    });
+
+    ThreadPool pool(2);
+    scheduler.run(world, pool);
+    EXPECT_FALSE(sawVelocity);
+    EXPECT_FALSE(world.isAlive(entity));
+}
+
+TEST(EcsScheduler, UndeclaredAccessThrows)
+{
+    Ecs::World world;
+    static_cast<void>(world.create(Health {}, Position {}));
+
+    Ecs::Scheduler scheduler;
+    scheduler.add("reader", Ecs::Access().read<Health>(), [](const Ecs::SystemContext& context) {
+        context.forEach<const Health>([](const Health&) {});
+        context.forEach<Health>([](Health&) {});
+    });
+
+    ThreadPool pool(2);
+    EXPECT_THROW(scheduler.run(world, pool), std::runtime_error);
+}
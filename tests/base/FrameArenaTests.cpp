@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "FrameArena.hpp"
+#include "FrameLoop.hpp"
+#include "NullBackend.hpp"
+
+namespace
+{
+    /// Writes the frame number into an arena allocation each frame and checks the
+    /// allocations of the frames that may still be in flight are intact.
+    class ArenaListener final : public FrameListener
+    {
+    public:
+        explicit ArenaListener(FrameLoop*& loop)
+            : m_loop(loop)
+        {
+        }
+
+        void onFrameUpdate([[maybe_unused]] const GameTimer& timer) override
+        {
+        }
+
+        void onFrameRender([[maybe_unused]] const GameTimer& timer) override
+        {
+            // A change of frames in flight drains the GPU first, so every earlier
+            // arena is free again
+            const uint32_t framesInFlight = m_loop->framesInFlight();
+            if (framesInFlight != m_framesInFlight)
+            {
+                m_framesInFlight = framesInFlight;
+                m_frames.clear();
+            }
+
+            const uint64_t frameNumber = m_loop->frameNumber();
+            FrameArena&    arena = m_loop->frameArena();
+            EXPECT_EQ(arena.statistics().allocationCount, 0U);
+
+            for (size_t back = 1; back <= framesInFlight && back <= m_frames.size(); back++)
+            {
+                const Frame& earlier = m_frames[m_frames.size() - back];
+                EXPECT_NE(earlier.arena, &arena);
+                EXPECT_EQ(*earlier.value, frameNumber - back);
+            }
+            m_frames.push_back({ &arena, arena.create<uint64_t>(frameNumber) });
+        }
+
+    private:
+        struct Frame
+        {
+            FrameArena* arena = nullptr;
+            uint64_t*   value = nullptr;
+        };
+
+        FrameLoop*&        m_loop;
+        uint32_t           m_framesInFlight = 0;
+        std::vector<Frame> m_frames;
+    };
+} // namespace
+
+TEST(FrameArena, AllocationsAreAlignedAndDisjoint)
+{
+    FrameArena arena(256);
+    auto*      a = arena.allocateArray<uint8_t>(3);
+    auto*      b = arena.allocateArray<double>(4);
+    auto*      c = static_cast<std::byte*>(arena.allocate(16, 64));
+
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(double), 0U);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 64, 0U);
+    EXPECT_GE(reinterpret_cast<std::byte*>(b), reinterpret_cast<std::byte*>(a + 3));
+    EXPECT_GE(c, reinterpret_cast<std::byte*>(b + 4));
+    EXPECT_EQ(arena.statistics().allocationCount, 3U);
+    EXPECT_EQ(arena.statistics().bytesAllocated, 3U + 32U + 16U);
+}
+
+TEST(FrameArena, OverflowChainsLargerBlocks)
+{
+    FrameArena arena(1024);
+    for (size_t i = 0; i < 16; i++)
+    {
+        static_cast<void>(arena.allocateArray<uint8_t>(512));
+    }
+    const auto& statistics = arena.statistics();
+    EXPECT_EQ(statistics.bytesAllocated, 16U * 512U);
+    EXPECT_GT(statistics.blockAllocations, 1U);
+    EXPECT_LE(statistics.blockAllocations, 5U); // Geometric growth
+    EXPECT_GE(statistics.capacity, 16U * 512U);
+
+    // An allocation larger than twice the current block gets a block of its own
+    auto* large = arena.allocateArray<uint8_t>(1 << 20);
+    large[(1 << 20) - 1] = 1;
+    EXPECT_GE(arena.statistics().capacity, size_t { 1 } << 20);
+}
+
+TEST(FrameArena, ResetCoalescesSoSteadyFramesDoNotAllocate)
+{
+    FrameArena arena(1024);
+    for (size_t frame = 0; frame < 8; frame++)
+    {
+        arena.reset();
+        for (size_t i = 0; i < 64; i++)
+        {
+            static_cast<void>(arena.allocateArray<uint64_t>(16));
+        }
+    }
+    const uint64_t warmBlocks = arena.statistics().blockAllocations;
+    for (size_t frame = 0; frame < 8; frame++)
+    {
+        arena.reset();
+        for (size_t i = 0; i < 64; i++)
+        {
+            static_cast<void>(arena.allocateArray<uint64_t>(16));
+        }
+    }
+    EXPECT_EQ(arena.statistics().blockAllocations, warmBlocks);
+    EXPECT_EQ(arena.statistics().peakBytes, 64U * 16U * sizeof(uint64_t));
+
+    arena.reset();
+    EXPECT_EQ(arena.statistics().bytesAllocated, 0U);
+    EXPECT_EQ(arena.statistics().allocationCount, 0U);
+}
+
+TEST(FrameArena, BacksPmrContainers)
+{
+    FrameArena                 arena(64);
+    std::pmr::vector<uint32_t> values(&arena);
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        values.push_back(i);
+    }
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        ASSERT_EQ(values[i], i);
+    }
+    EXPECT_GT(arena.statistics().allocationCount, 1U);
+    EXPECT_TRUE(arena.is_equal(arena));
+    EXPECT_FALSE(arena.is_equal(*std::pmr::new_delete_resource()));
+}
+
+TEST(FrameArena, FrameLoopReusesArenasOnlyAfterTheirFrameRetires)
+{
+    NullBackend::Options options;
+    options.pacing = NullBackend::Pacing::Simulated;
+    options.gpuFrameTime = 1.0 / 30.0;
+    NullBackend backend(options);
+
+    FrameLoop*    loopPointer = nullptr;
+    ArenaListener listener(loopPointer);
+    FrameLoop     loop(backend, listener);
+    loopPointer = &loop;
+
+    for (const uint32_t framesInFlight : { 3U, 1U, 2U })
+    {
+        loop.setFramesInFlight(framesInFlight);
+        for (size_t frame = 0; frame < 20; frame++)
+        {
+            loop.runFrame();
+        }
+    }
+    EXPECT_EQ(loop.frameNumber(), 60U);
+}
@@ -0,0 +1,359 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "FrameGraph.hpp"
+
+namespace
+{
+    using Render::Barrier;
+    using Render::FrameGraph;
+    using Render::ResourceAccess;
+    using Render::ResourceHandle;
+    using Render::TextureDesc;
+
+    /// Four bytes per sample, aligned to 256 bytes.
+    Render::MemoryRequirements memoryRequirements(const TextureDesc& desc)
+    {
+        return { .size = uint64_t { desc.width } * desc.height * desc.sampleCount * 4,
+            .alignment = 256 };
+    }
+
+    TextureDesc texture(const uint32_t size = 64)
+    {
+        return { .width = size, .height = size };
+    }
+
+    std::vector<uint32_t> passOrder(const FrameGraph& graph)
+    {
+        return { graph.passOrder().begin(), graph.passOrder().end() };
+    }
+
+    void expectTransition(const Barrier& barrier, const ResourceHandle resource,
+        const ResourceAccess before, const ResourceAccess after)
+    {
+        EXPECT_EQ(barrier.type, Barrier::Type::Transition);
+        EXPECT_EQ(barrier.resource, resource.index);
+        EXPECT_EQ(barrier.before, before);
+        EXPECT_EQ(barrier.after, after);
+    }
+} // namespace
+
+TEST(FrameGraph, CullsPassesNothingDependsOn)
+{
+    FrameGraph graph;
+    const auto backbuffer = graph.importTexture(
+        "Backbuffer", texture(), ResourceAccess::None, ResourceAccess::Present);
+    const auto unused = graph.createTexture("Unused", texture());
+    const auto feedsUnused = graph.createTexture("Feeds Unused", texture());
+    const auto scene = graph.createTexture("Scene", texture());
+    const auto readback = graph.createTexture("Readback", texture());
+
+    const uint32_t culledProducer = graph.addPass("Culled Producer").write(feedsUnused).index();
+    const uint32_t culledConsumer
+        = graph.addPass("Culled Consumer").read(feedsUnused).write(unused).index();
+    const uint32_t sceneClear = graph.addPass("Scene Clear").write(scene).index();
+    const uint32_t sceneDraw = graph.addPass("Scene Draw").write(scene).index();
+    const uint32_t sideEffect
+        = graph.addPass("Readback").write(readback).setSideEffects().index();
+    const uint32_t composite = graph.addPass("Composite").read(scene).write(backbuffer).index();
+    graph.compile(memoryRequirements);
+
+    // A culled reader does not keep its producer alive; earlier writers of a needed
+    // texture are kept because later writes may load their results
+    EXPECT_TRUE(graph.isCulled(culledProducer));
+    EXPECT_TRUE(graph.isCulled(culledConsumer));
+    EXPECT_FALSE(graph.isCulled(sceneClear));
+    EXPECT_FALSE(graph.isCulled(sceneDraw));
+    EXPECT_FALSE(graph.isCulled(sideEffect));
+    EXPECT_FALSE(graph.isCulled(composite));
+    EXPECT_EQ(passOrder(graph),
+        (std::vector<uint32_t> { sceneClear, sceneDraw, sideEffect, composite }));
+    EXPECT_EQ(graph.statistics().passes, 6U);
+    EXPECT_EQ(graph.statistics().culledPasses, 2U);
+
+    // Textures only culled passes use get no memory
+    EXPECT_EQ(graph.heapOffset(unused), Render::g_invalidOffset);
+    EXPECT_EQ(graph.heapOffset(feedsUnused), Render::g_invalidOffset);
+    EXPECT_EQ(graph.statistics().transientResources, 2U);
+}
+
+TEST(FrameGraph, PassesWritingImportedTexturesAreKept)
+{
+    FrameGraph graph;
+    const auto history = graph.importTexture(
+        "History", texture(), ResourceAccess::ShaderRead, ResourceAccess::ShaderRead);
+    const auto temporary = graph.createTexture("Temporary", texture());
+    graph.addPass("Reproject").write(temporary);
+    graph.addPass("Accumulate").read(temporary).write(history, ResourceAccess::ShaderWrite);
+    graph.addPass("Debug").read(history);
+    graph.compile(memoryRequirements);
+
+    // Nothing reads the history this frame, but it outlives the frame
+    EXPECT_EQ(passOrder(graph), (std::vector<uint32_t> { 0, 1 }));
+    EXPECT_TRUE(graph.isCulled(2));
+}
+
+TEST(FrameGraph, LifetimesSpanFirstToLastUse)
+{
+    FrameGraph graph;
+    const auto backbuffer = graph.importTexture(
+        "Backbuffer", texture(), ResourceAccess::None, ResourceAccess::Present);
+    const auto a = graph.createTexture("A", texture());
+    const auto b = graph.createTexture("B", texture());
+    const auto never = graph.createTexture("Never", texture());
+    graph.addPass("Culled").write(never);
+    graph.addPass("Write A").write(a);
+    graph.addPass("Write B").read(a).write(b);
+    graph.addPass("Unrelated").setSideEffects();
+    graph.addPass("Resolve").read(b).write(backbuffer);
+    graph.compile(memoryRequirements);
+
+    // Positions count the surviving passes only
+    ASSERT_EQ(passOrder(graph), (std::vector<uint32_t> { 1, 2, 3, 4 }));
+    EXPECT_EQ(graph.lifetime(a).first, 0U);
+    EXPECT_EQ(graph.lifetime(a).last, 1U);
+    EXPECT_EQ(graph.lifetime(b).first, 1U);
+    EXPECT_EQ(graph.lifetime(b).last, 3U);
+    EXPECT_EQ(graph.lifetime(backbuffer).first, 3U);
+    EXPECT_EQ(graph.lifetime(backbuffer).last, 3U);
+    EXPECT_EQ(graph.lifetime(never).first, Render::g_invalidIndex);
+}
+
+TEST(FrameGraph, DisjointLifetimesShareMemory)
+{
+    FrameGraph graph;
+    const auto backbuffer = graph.importTexture(
+        "Backbuffer", texture(), ResourceAccess::None, ResourceAccess::Present);
+    const auto first = graph.createTexture("First", texture());
+    const auto second = graph.createTexture("Second", texture());
+    const auto third = graph.createTexture("Third", texture());
+    graph.addPass("Write First").write(first);
+    graph.addPass("First To Second").read(first).write(second);
+    graph.addPass("Second To Third").read(second).write(third);
+    graph.addPass("Present").read(third).write(backbuffer);
+    graph.compile(memoryRequirements);
+
+    // First and second overlap at pass 1, second and third at pass 2, so first and
+    // third alias while second sits beside them
+    const uint64_t size = memoryRequirements(texture()).size;
+    EXPECT_EQ(graph.heapOffset(first), graph.heapOffset(third));
+    EXPECT_NE(graph.heapOffset(first), graph.heapOffset(second));
+    EXPECT_EQ(graph.heapSize(), 2 * size);
+    EXPECT_EQ(graph.heapAlignment(), 256U);
+    EXPECT_EQ(graph.statistics().transientBytes, 3 * size);
+    EXPECT_EQ(graph.statistics().heapBytes, 2 * size);
+    EXPECT_EQ(graph.heapOffset(backbuffer), Render::g_invalidOffset);
+}
+
+TEST(FrameGraph, MemorylessTexturesAreNotPlaced)
+{
+    FrameGraph graph;
+    const auto backbuffer = graph.importTexture(
+        "Backbuffer", texture(), ResourceAccess::None, ResourceAccess::Present);
+    auto depthDesc = texture();
+    depthDesc.memoryless = true;
+    const auto depth = graph.createTexture("Depth", depthDesc);
+    graph.addPass("Main").write(depth, ResourceAccess::DepthStencil).write(backbuffer);
+    graph.compile(memoryRequirements);
+
+    EXPECT_EQ(graph.heapOffset(depth), Render::g_invalidOffset);
+    EXPECT_EQ(graph.heapSize(), 0U);
+    EXPECT_EQ(graph.statistics().transientResources, 1U);
+}
+
+TEST(FrameGraph, PlacementNeverOverlapsLiveTextures)
+{
+    std::mt19937 random(21);
+    for (int round = 0; round < 50; round++)
+    {
+        FrameGraph graph;
+        const auto backbuffer = graph.importTexture(
+            "Backbuffer", texture(), ResourceAccess::None, ResourceAccess::Present);
+        std::uniform_int_distribution<uint32_t> sizes(1, 128);
+        std::vector<ResourceHandle>             textures;
+        for (int i = 0; i < 12; i++)
+        {
+            textures.push_back(
+                graph.createTexture("T" + std::to_string(i), texture(sizes(random))));
+        }
+
+        // Each pass reads one earlier texture and writes the next, and is kept, so
+        // lifetimes end at random points and many textures can alias
+        graph.addPass("Start").write(textures[0]);
+        for (size_t i = 1; i < textures.size(); i++)
+        {
+            std::uniform_int_distribution<size_t> earlier(0, i - 1);
+            graph.addPass("Pass")
+                .read(textures[earlier(random)])
+                .write(textures[i])
+                .setSideEffects();
+        }
+        graph.addPass("End").read(textures.back()).write(backbuffer);
+        graph.compile(memoryRequirements);
+        ASSERT_EQ(graph.passOrder().size(), textures.size() + 1);
+        EXPECT_LT(graph.heapSize(), graph.statistics().transientBytes);
+
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            const uint64_t offset = graph.heapOffset(textures[i]);
+            const uint64_t size = memoryRequirements(graph.textureDesc(textures[i])).size;
+            ASSERT_NE(offset, Render::g_invalidOffset);
+            EXPECT_EQ(offset % 256, 0U);
+            EXPECT_LE(offset + size, graph.heapSize());
+            for (size_t j = 0; j < i; j++)
+            {
+                const auto     a = graph.lifetime(textures[i]);
+                const auto     b = graph.lifetime(textures[j]);
+                const uint64_t otherOffset = graph.heapOffset(textures[j]);
+                const uint64_t otherSize
+                    = memoryRequirements(graph.textureDesc(textures[j])).size;
+                const bool liveTogether = a.first <= b.last && b.first <= a.last;
+                const bool shareMemory
+                    = offset < otherOffset + otherSize && otherOffset < offset + size;
+                EXPECT_FALSE(liveTogether && shareMemory)
+                    << "round " << round << " textures " << i << ", " << j;
+            }
+        }
+    }
+}
+
+TEST(FrameGraph, BarriersTransitionAndAlias)
+{
+    FrameGraph graph;
+    const auto backbuffer = graph.importTexture(
+        "Backbuffer", texture(), ResourceAccess::None, ResourceAccess::Present);
+    const auto first = graph.createTexture("First", texture());
+    const auto second = graph.createTexture("Second", texture());
+    const auto third = graph.createTexture("Third", texture());
+    graph.addPass("Write First").write(first);
+    graph.addPass("First To Second").read(first).write(second, ResourceAccess::ShaderWrite);
+    graph.addPass("Second Again").write(second, ResourceAccess::ShaderWrite);
+    graph.addPass("Second To Third").read(second).write(third);
+    graph.addPass("Present").read(third).write(backbuffer);
+    graph.compile(memoryRequirements);
+    ASSERT_EQ(graph.passOrder().size(), 5U);
+    ASSERT_EQ(graph.heapOffset(first), graph.heapOffset(third));
+
+    auto barriers = graph.barriers(0);
+    ASSERT_EQ(barriers.size(), 1U);
+    expectTransition(barriers[0], first, ResourceAccess::None, ResourceAccess::RenderTarget);
+
+    barriers = graph.barriers(1);
+    ASSERT_EQ(barriers.size(), 2U);
+    expectTransition(barriers[0], first, ResourceAccess::RenderTarget, ResourceAccess::ShaderRead);
+    expectTransition(barriers[1], second, ResourceAccess::None, ResourceAccess::ShaderWrite);
+
+    // Consecutive shader writes are still ordered
+    barriers = graph.barriers(2);
+    ASSERT_EQ(barriers.size(), 1U);
+    expectTransition(barriers[0], second, ResourceAccess::ShaderWrite, ResourceAccess::ShaderWrite);
+
+    // Third takes over the memory of first, which needs an aliasing barrier before
+    // its first use
+    barriers = graph.barriers(3);
+    ASSERT_EQ(barriers.size(), 3U);
+    EXPECT_EQ(barriers[0].type, Barrier::Type::Aliasing);
+    EXPECT_EQ(barriers[0].resource, third.index);
+    EXPECT_EQ(barriers[0].aliasedResource, first.index);
+    expectTransition(barriers[1], second, ResourceAccess::ShaderWrite, ResourceAccess::ShaderRead);
+    expectTransition(barriers[2], third, ResourceAccess::None, ResourceAccess::RenderTarget);
+
+    barriers = graph.barriers(4);
+    ASSERT_EQ(barriers.size(), 2U);
+    expectTransition(barriers[0], third, ResourceAccess::RenderTarget, ResourceAccess::ShaderRead);
+    expectTransition(
+        barriers[1], backbuffer, ResourceAccess::None, ResourceAccess::RenderTarget);
+
+    // Imported textures are left in their final state
+    const auto final = graph.finalBarriers();
+    ASSERT_EQ(final.size(), 1U);
+    expectTransition(final[0], backbuffer, ResourceAccess::RenderTarget, ResourceAccess::Present);
+
+    EXPECT_EQ(graph.statistics().aliasingBarriers, 1U);
+    EXPECT_EQ(graph.statistics().transitionBarriers, 9U);
+
+    // execute() hands each surviving pass its barriers
+    std::vector<uint32_t> executed;
+    size_t                barrierCount = 0;
+    graph.execute([&](const uint32_t pass, const std::span<const Barrier> passBarriers) {
+        executed.push_back(pass);
+        barrierCount += passBarriers.size();
+    });
+    EXPECT_EQ(executed, passOrder(graph));
+    EXPECT_EQ(barrierCount, 10U - final.size());
+}
+
+TEST(FrameGraph, ImportedTexturesAlreadyInTheirFinalStateNeedNoBarrier)
+{
+    FrameGraph graph;
+    const auto target = graph.importTexture(
+        "Target", texture(), ResourceAccess::RenderTarget, ResourceAccess::RenderTarget);
+    graph.addPass("Draw").write(target);
+    graph.compile(memoryRequirements);
+
+    EXPECT_TRUE(graph.barriers(0).empty());
+    EXPECT_TRUE(graph.finalBarriers().empty());
+}
+
+TEST(FrameGraph, ReadBeforeWriteThrows)
+{
+    FrameGraph graph;
+    const auto backbuffer = graph.importTexture(
+        "Backbuffer", texture(), ResourceAccess::None, ResourceAccess::Present);
+    const auto late = graph.createTexture("Late", texture());
+    graph.addPass("Reads Early").read(late).write(backbuffer);
+    graph.addPass("Writes Late").write(late);
+    EXPECT_THROW(graph.compile(memoryRequirements), std::runtime_error);
+}
+
+TEST(FrameGraph, ReadingAnImportedTextureNeedsNoWriter)
+{
+    FrameGraph graph;
+    const auto input = graph.importTexture(
+        "Input", texture(), ResourceAccess::ShaderRead, ResourceAccess::ShaderRead);
+    const auto output = graph.importTexture(
+        "Output", texture(), ResourceAccess::None, ResourceAccess::Present);
+    graph.addPass("Copy").read(input).write(output);
+    EXPECT_NO_THROW(graph.compile(memoryRequirements));
+}
+
+TEST(FrameGraph, InvalidHandlesThrow)
+{
+    FrameGraph graph;
+    const auto backbuffer = graph.importTexture(
+        "Backbuffer", texture(), ResourceAccess::None, ResourceAccess::Present);
+    graph.addPass("Default Handle").write(ResourceHandle {}).write(backbuffer);
+    EXPECT_THROW(graph.compile(memoryRequirements), std::runtime_error);
+
+    graph.clear();
+    const auto other = graph.importTexture(
+        "Backbuffer", texture(), ResourceAccess::None, ResourceAccess::Present);
+    graph.addPass("Out Of Range").read(ResourceHandle { 7 }).write(other);
+    EXPECT_THROW(graph.compile(memoryRequirements), std::runtime_error);
+}
+
+TEST(FrameGraph, ZeroSizedTexturesThrow)
+{
+    for (const TextureDesc desc : { TextureDesc { .width = 0, .height = 64 },
+             TextureDesc { .width = 64, .height = 0 } })
+    {
+        FrameGraph graph;
+        const auto backbuffer = graph.importTexture(
+            "Backbuffer", texture(), ResourceAccess::None, ResourceAccess::Present);
+        const auto empty = graph.createTexture("Empty", desc);
+        graph.addPass("Main").write(empty).write(backbuffer);
+        EXPECT_THROW(graph.compile(memoryRequirements), std::runtime_error);
+    }
+}
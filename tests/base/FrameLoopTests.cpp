@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include "FrameLoop.hpp"
+#include "GameTimer.hpp"
+#include "NullBackend.hpp"
+
+namespace
+{
+    /// Records how many frames are still on the simulated GPU whenever one is recorded.
+    class SchedulingListener : public FrameListener
+    {
+    public:
+        explicit SchedulingListener(NullBackend& backend)
+            : m_backend(backend)
+        {
+        }
+
+        void onFrameUpdate([[maybe_unused]] const GameTimer& timer) override
+        {
+            updates++;
+        }
+
+        void onFrameRender([[maybe_unused]] const GameTimer& timer) override
+        {
+            const uint64_t outstanding = loop->frameNumber() - m_backend.completedFrames();
+            maxOutstanding = std::max(maxOutstanding, outstanding);
+            renders++;
+        }
+
+        FrameLoop* loop = nullptr;
+        uint64_t   updates = 0;
+        uint64_t   renders = 0;
+        uint64_t   maxOutstanding = 0;
+
+    private:
+        NullBackend& m_backend;
+    };
+
+    /// A GPU-bound configuration: each frame takes longer on the GPU than its interval.
+    NullBackend::Options gpuBoundOptions()
+    {
+        return {
+            .bufferCount = 4,
+            .pacing = NullBackend::Pacing::Simulated,
+            .frameInterval = 0.010,
+            .gpuFrameTime = 0.025,
+            .cpuFrameTime = 0.002,
+        };
+    }
+
+    struct Fixture
+    {
+        explicit Fixture(const NullBackend::Options& options)
+            : backend(options)
+            , listener(backend)
+            , loop(backend, listener)
+        {
+            listener.loop = &loop;
+        }
+
+        void run(const uint64_t attempts)
+        {
+            for (uint64_t i = 0; i < attempts; i++)
+            {
+                loop.runFrame();
+            }
+        }
+
+        NullBackend        backend;
+        SchedulingListener listener;
+        FrameLoop          loop;
+    };
+} // namespace
+
+TEST(FrameLoop, FramesInFlightDefaultsToTheBufferCount)
+{
+    Fixture fixture(gpuBoundOptions());
+    EXPECT_EQ(fixture.loop.framesInFlight(), 4U);
+}
+
+TEST(FrameLoop, FramesInFlightIsClampedToTheBuffers)
+{
+    Fixture fixture(gpuBoundOptions());
+
+    fixture.loop.setFramesInFlight(0);
+    fixture.run(1);
+    EXPECT_EQ(fixture.loop.framesInFlight(), 1U);
+
+    fixture.loop.setFramesInFlight(9);
+    fixture.run(1);
+    EXPECT_EQ(fixture.loop.framesInFlight(), 4U);
+}
+
+TEST(FrameLoop, ChangingFramesInFlightDrainsTheGpu)
+{
+    Fixture fixture(gpuBoundOptions());
+    fixture.run(20);
+    ASSERT_LT(fixture.backend.completedFrames(), fixture.loop.frameNumber());
+
+    // The change only applies once every submitted frame has completed
+    fixture.loop.setFramesInFlight(2);
+    EXPECT_EQ(fixture.loop.framesInFlight(), 4U);
+    const uint64_t submitted = fixture.loop.frameNumber();
+    fixture.listener.maxOutstanding = 0;
+    fixture.run(1);
+    EXPECT_EQ(fixture.loop.framesInFlight(), 2U);
+    EXPECT_EQ(fixture.loop.frameNumber(), submitted + 1);
+    EXPECT_EQ(fixture.listener.maxOutstanding, 0U);
+}
+
+class FrameLoopFramesInFlight : public testing::TestWithParam<uint32_t>
+{
+};
+
+TEST_P(FrameLoopFramesInFlight, NeverRecordsAheadOfTheLimit)
+{
+    const uint32_t framesInFlight = GetParam();
+    Fixture        fixture(gpuBoundOptions());
+    fixture.loop.setFramesInFlight(framesInFlight);
+    fixture.run(200);
+
+    // While frame n is recorded, frame n - N has completed, so at most N - 1 of the
+    // frames before it can still be on the GPU
+    EXPECT_EQ(fixture.listener.renders, 200U);
+    EXPECT_EQ(fixture.listener.maxOutstanding, framesInFlight - 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(FrameLoop, FrameLoopFramesInFlight, testing::Values(1U, 2U, 3U, 4U));
+
+TEST(FrameLoop, WaitTimeoutSkipsTheFrame)
+{
+    auto options = gpuBoundOptions();
+    options.gpuFrameTime = 0.050;
+    options.waitTimeout = 0.005;
+    Fixture fixture(options);
+    fixture.loop.setFramesInFlight(1);
+    fixture.run(100);
+
+    const auto& statistics = fixture.loop.statistics();
+    EXPECT_GT(statistics.waitTimeouts, 0U);
+    EXPECT_EQ(statistics.skippedFrames, statistics.waitTimeouts);
+    EXPECT_EQ(statistics.frames + statistics.skippedFrames, 100U);
+    EXPECT_EQ(statistics.frames, fixture.listener.renders);
+}
+
+TEST(FrameLoop, SkippedFramesDoNotUpdateTwice)
+{
+    auto options = gpuBoundOptions();
+    options.gpuFrameTime = 0.050;
+    options.waitTimeout = 0.005;
+    Fixture fixture(options);
+    fixture.loop.setFramesInFlight(1);
+    fixture.run(100);
+
+    // A retried frame keeps the update it had, so only the frame still waiting for
+    // its slot may have updated without being recorded
+    ASSERT_GT(fixture.loop.statistics().skippedFrames, 0U);
+    EXPECT_GE(fixture.listener.updates, fixture.listener.renders);
+    EXPECT_LE(fixture.listener.updates, fixture.listener.renders + 1);
+}
+
+TEST(FrameLoop, LowLatencySamplesInputAfterTheWait)
+{
+    double inputToSubmit[2] {};
+    for (const auto mode : { LatencyMode::Throughput, LatencyMode::LowLatency })
+    {
+        Fixture fixture(gpuBoundOptions());
+        fixture.loop.setFramesInFlight(2);
+        fixture.loop.setLatencyMode(mode);
+        fixture.run(200);
+        EXPECT_EQ(fixture.loop.statistics().skippedFrames, 0U);
+        inputToSubmit[static_cast<int>(mode)] = fixture.loop.statistics().inputToSubmit.mean();
+    }
+
+    // Throughput mode waits for the GPU between input and submission; low latency
+    // mode only spends the recording time there
+    const double throughput = inputToSubmit[static_cast<int>(LatencyMode::Throughput)];
+    const double lowLatency = inputToSubmit[static_cast<int>(LatencyMode::LowLatency)];
+    EXPECT_LT(lowLatency, throughput);
+    EXPECT_NEAR(lowLatency, gpuBoundOptions().cpuFrameTime, 1e-4);
+    EXPECT_GT(throughput, gpuBoundOptions().cpuFrameTime * 2);
+}
@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "FrameLoop.hpp"
+#include "GameTimer.hpp"
+#include "HeadlessRunner.hpp"
+#include "NullBackend.hpp"
+
+namespace
+{
+    /// Records the hooks in the order the frame loop calls them.
+    class RecordingListener : public FrameListener
+    {
+    public:
+        void onFrameUpdate(const GameTimer& timer) override
+        {
+            events.emplace_back("update");
+            elapsedSeconds.push_back(timer.elapsedSeconds());
+        }
+
+        void onFrameInput() override
+        {
+            events.emplace_back("input");
+        }
+
+        void onFrameRender([[maybe_unused]] const GameTimer& timer) override
+        {
+            events.emplace_back("render");
+            frameIndices.push_back(loop->frameIndex());
+        }
+
+        FrameLoop*               loop = nullptr;
+        std::vector<std::string> events;
+        std::vector<double>      elapsedSeconds;
+        std::vector<uint32_t>    frameIndices;
+    };
+
+    std::unique_ptr<NullBackend> createBackend(const NullBackend::Options& options)
+    {
+        return std::make_unique<NullBackend>(options);
+    }
+
+    NullBackend::Options simulatedOptions()
+    {
+        return { .pacing = NullBackend::Pacing::Simulated, .frameInterval = 1.0 / 60.0 };
+    }
+} // namespace
+
+TEST(HeadlessRunner, FrameIndexRotatesThroughTheBuffers)
+{
+    RecordingListener listener;
+    HeadlessRunner    runner(listener, createBackend(simulatedOptions()));
+    listener.loop = &runner.frameLoop();
+
+    const auto statistics = runner.run(9);
+    EXPECT_EQ(statistics.frames, 9U);
+    EXPECT_EQ(statistics.skippedFrames, 0U);
+    EXPECT_EQ(listener.frameIndices, (std::vector<uint32_t> { 0, 1, 2, 0, 1, 2, 0, 1, 2 }));
+    EXPECT_EQ(runner.frameLoop().frameNumber(), 9U);
+}
+
+TEST(HeadlessRunner, FrameIndexFollowsFramesInFlight)
+{
+    RecordingListener listener;
+    HeadlessRunner    runner(listener, createBackend(simulatedOptions()));
+    listener.loop = &runner.frameLoop();
+    runner.frameLoop().setFramesInFlight(2);
+
+    runner.run(5);
+    EXPECT_EQ(listener.frameIndices, (std::vector<uint32_t> { 0, 1, 0, 1, 0 }));
+}
+
+TEST(HeadlessRunner, HooksRunInFrameOrder)
+{
+    RecordingListener listener;
+    HeadlessRunner    runner(listener, createBackend(simulatedOptions()));
+    listener.loop = &runner.frameLoop();
+
+    runner.run(3);
+    const std::vector<std::string> frame { "update", "input", "render" };
+    ASSERT_EQ(listener.events.size(), 3 * frame.size());
+    for (size_t i = 0; i < listener.events.size(); i++)
+    {
+        EXPECT_EQ(listener.events[i], frame[i % frame.size()]) << "event " << i;
+    }
+}
+
+TEST(HeadlessRunner, SimulatedClockAdvancesOneIntervalPerFrame)
+{
+    RecordingListener listener;
+    HeadlessRunner    runner(listener, createBackend(simulatedOptions()));
+    listener.loop = &runner.frameLoop();
+
+    runner.run(60);
+    ASSERT_EQ(listener.elapsedSeconds.size(), 60U);
+    for (const double seconds : listener.elapsedSeconds)
+    {
+        EXPECT_NEAR(seconds, 1.0 / 60.0, 1e-6);
+    }
+    EXPECT_NEAR(runner.frameLoop().timer().totalSeconds(), 1.0, 1e-4);
+}
+
+TEST(HeadlessRunner, SimulatedRunsAreDeterministic)
+{
+    auto options = simulatedOptions();
+    options.gpuFrameTime = 0.025;
+    options.cpuFrameTime = 0.004;
+
+    std::vector<FrameLatencyStatistics> results;
+    std::vector<std::vector<double>>    updates;
+    for (int run = 0; run < 2; run++)
+    {
+        RecordingListener listener;
+        HeadlessRunner    runner(listener, createBackend(options));
+        listener.loop = &runner.frameLoop();
+        runner.run(200);
+        results.push_back(runner.frameLoop().statistics());
+        updates.push_back(listener.elapsedSeconds);
+    }
+
+    EXPECT_EQ(results[0].frames, results[1].frames);
+    EXPECT_EQ(results[0].skippedFrames, results[1].skippedFrames);
+    EXPECT_DOUBLE_EQ(results[0].cpuWait.total, results[1].cpuWait.total);
+    EXPECT_DOUBLE_EQ(results[0].inputToSubmit.total, results[1].inputToSubmit.total);
+    EXPECT_EQ(updates[0], updates[1]);
+}
+
+TEST(HeadlessRunner, FixedPacingHoldsTheCadence)
+{
+    constexpr double interval = 0.005;
+    RecordingListener listener;
+    HeadlessRunner    runner(listener,
+        createBackend({ .pacing = NullBackend::Pacing::Fixed, .frameInterval = interval }));
+    listener.loop = &runner.frameLoop();
+
+    // The first frame starts at once, every later one waits for its deadline
+    const auto statistics = runner.run(20);
+    EXPECT_EQ(statistics.frames, 20U);
+    EXPECT_GE(statistics.wallSeconds, 19 * interval * 0.95);
+    EXPECT_GE(statistics.meanFrameSeconds, interval * 0.9);
+}
+
+TEST(HeadlessRunner, UnlockedPacingRunsAsFastAsPossible)
+{
+    RecordingListener listener;
+    HeadlessRunner    runner(listener, createBackend({ .pacing = NullBackend::Pacing::Unlocked }));
+    listener.loop = &runner.frameLoop();
+
+    // 1000 frames at a 60 Hz cadence would take 16 seconds
+    const auto statistics = runner.run(1'000);
+    EXPECT_EQ(statistics.frames, 1'000U);
+    EXPECT_EQ(statistics.skippedFrames, 0U);
+    EXPECT_LT(statistics.wallSeconds, 1.0);
+    EXPECT_EQ(runner.backend().completedFrames(), 1'000U);
+}
+
+TEST(HeadlessRunner, RunForStopsAfterTheDuration)
+{
+    RecordingListener listener;
+    HeadlessRunner    runner(listener,
+        createBackend({ .pacing = NullBackend::Pacing::Fixed, .frameInterval = 0.002 }));
+    listener.loop = &runner.frameLoop();
+
+    const auto statistics = runner.runFor(0.05);
+    EXPECT_GE(statistics.wallSeconds, 0.05);
+    EXPECT_GT(statistics.frames, 0U);
+    EXPECT_EQ(listener.events.size(), 3 * statistics.frames);
+}
+
+TEST(NullBackend, RejectsZeroBuffers)
+{
+    EXPECT_THROW(NullBackend({ .bufferCount = 0 }), std::invalid_argument);
+}
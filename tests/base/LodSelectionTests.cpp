@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "LodSelection.hpp"
+
+namespace
+{
+    /// Levels with the given object space errors, full detail first.
+    std::vector<Assets::CookedLod> lodsWithErrors(const std::vector<float>& errors)
+    {
+        std::vector<Assets::CookedLod> lods(errors.size());
+        for (size_t lod = 0; lod < errors.size(); lod++)
+        {
+            lods[lod].error = errors[lod];
+        }
+        return lods;
+    }
+
+    /// 500 pixels per unit at distance 1: a 90 degree field of view over 1000 rows.
+    Assets::LodSelector selector(const float thresholdPixels = 1.0F)
+    {
+        return { { 0.0F, 0.0F, 0.0F }, 1.0F, 1'000.0F, thresholdPixels };
+    }
+
+    /// An instance whose near side is distance units in front of the camera.
+    Assets::LodInstance instanceAt(const float distance, const float scale = 1.0F)
+    {
+        return { .center = { 0.0F, 0.0F, distance + 1.0F }, .radius = 1.0F, .scale = scale };
+    }
+} // namespace
+
+TEST(LodSelection, ProjectsErrorsByDistance)
+{
+    const auto lodSelector = selector();
+
+    // 0.2 units at distance 100 cover 0.2 * 500 / 100 pixels
+    EXPECT_FLOAT_EQ(lodSelector.projectedError(0.2F, instanceAt(100.0F)), 1.0F);
+    EXPECT_FLOAT_EQ(lodSelector.projectedError(0.2F, instanceAt(50.0F)), 2.0F);
+    EXPECT_FLOAT_EQ(lodSelector.projectedError(0.2F, instanceAt(100.0F, 2.0F)), 2.0F);
+    EXPECT_FLOAT_EQ(lodSelector.projectedError(0.0F, instanceAt(100.0F)), 0.0F);
+
+    // Off axis only the distance counts
+    const Assets::LodInstance side {
+        .center = { 101.0F, 0.0F, 0.0F }, .radius = 1.0F, .scale = 1.0F
+    };
+    EXPECT_FLOAT_EQ(lodSelector.projectedError(0.2F, side), 1.0F);
+
+    // The threshold does not change what an error covers on screen
+    EXPECT_FLOAT_EQ(selector(4.0F).projectedError(0.2F, instanceAt(100.0F)), 1.0F);
+}
+
+TEST(LodSelection, SelectsTheCoarsestLodUnderTheThreshold)
+{
+    const auto lods = lodsWithErrors({ 0.0F, 0.1F, 0.2F, 0.4F });
+    const auto lodSelector = selector();
+
+    // 0.2 units are allowed at distance 100, 0.1 at 50 and 0.4 at 200
+    EXPECT_EQ(lodSelector.select(lods, instanceAt(100.0F)), 2U);
+    EXPECT_EQ(lodSelector.select(lods, instanceAt(50.0F)), 1U);
+    EXPECT_EQ(lodSelector.select(lods, instanceAt(200.0F)), 3U);
+    EXPECT_EQ(lodSelector.select(lods, instanceAt(10'000.0F)), 3U);
+    EXPECT_EQ(lodSelector.select(lods, instanceAt(10.0F)), 0U);
+
+    // Scaling an instance up scales its errors with it
+    EXPECT_EQ(lodSelector.select(lods, instanceAt(100.0F, 2.0F)), 1U);
+
+    // A looser threshold allows more
+    EXPECT_EQ(selector(2.0F).select(lods, instanceAt(100.0F)), 3U);
+
+    // Whatever is selected stays within a pixel, the next level would not
+    for (const float distance : { 20.0F, 73.0F, 140.0F })
+    {
+        const auto     instance = instanceAt(distance);
+        const uint32_t selected = lodSelector.select(lods, instance);
+        EXPECT_LE(lodSelector.projectedError(lods[selected].error, instance), 1.0F);
+        EXPECT_GT(lodSelector.projectedError(lods[selected + 1].error, instance), 1.0F);
+    }
+}
+
+TEST(LodSelection, KeepsFullDetailInsideTheBounds)
+{
+    const auto                lods = lodsWithErrors({ 0.0F, 1.0e-6F, 0.5F });
+    const auto                lodSelector = selector();
+    const Assets::LodInstance around {
+        .center = { 0.0F, 0.0F, 0.5F }, .radius = 1.0F, .scale = 1.0F
+    };
+
+    EXPECT_EQ(lodSelector.select(lods, around), 0U);
+    EXPECT_TRUE(std::isinf(lodSelector.projectedError(1.0e-6F, around)));
+    EXPECT_EQ(lodSelector.select(lods, instanceAt(0.0F)), 0U);
+    EXPECT_EQ(lodSelector.select(lods, instanceAt(100.0F, 0.0F)), 0U);
+
+    // A single level is all there is
+    EXPECT_EQ(lodSelector.select(lodsWithErrors({ 0.0F }), instanceAt(1'000.0F)), 0U);
+}
+
+TEST(LodSelection, SelectsForManyInstances)
+{
+    const auto lods = lodsWithErrors({ 0.0F, 0.01F, 0.04F, 0.16F, 0.64F });
+    const auto lodSelector = selector();
+
+    std::vector<Assets::LodInstance> instances;
+    for (uint32_t i = 0; i < 1'000; i++)
+    {
+        instances.push_back(instanceAt(static_cast<float>(i), 1.0F + static_cast<float>(i % 3)));
+    }
+    std::vector<uint32_t> selected(instances.size(), ~0U);
+    lodSelector.select(lods, instances, selected);
+
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        ASSERT_EQ(selected[i], lodSelector.select(lods, instances[i]));
+        if (i >= 3)
+        {
+            EXPECT_GE(selected[i], selected[i - 3]);
+        }
+    }
+    EXPECT_EQ(selected.front(), 0U);
+    EXPECT_EQ(selected.back(), 4U);
+}
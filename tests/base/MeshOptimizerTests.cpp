@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "MeshOptimizer.hpp"
+#include "TestMeshes.hpp"
+
+namespace
+{
+    using Float3 = std::array<float, 3>;
+    using Triangle = std::array<Float3, 3>;
+
+    /// Triangles by corner positions, each rotated to start at its smallest corner so
+    /// the winding is kept, sorted. Equal for index buffers drawing the same surface.
+    std::vector<Triangle> triangles(const Assets::Primitive& primitive)
+    {
+        const auto position = [&primitive](const uint32_t index) {
+            return primitive.vertices.empty() ? primitive.streams.positions[index]
+                                              : primitive.vertices[index].position;
+        };
+        std::vector<Triangle> result;
+        for (size_t i = 0; i + 2 < primitive.indices.size(); i += 3)
+        {
+            Triangle triangle { position(primitive.indices[i]),
+                position(primitive.indices[i + 1]), position(primitive.indices[i + 2]) };
+            std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+            result.push_back(triangle);
+        }
+        std::ranges::sort(result);
+        return result;
+    }
+
+    /// Shuffles the triangles of an index buffer, keeping each triangle's corners.
+    void shuffleTriangles(std::vector<uint32_t>& indices, const uint32_t seed)
+    {
+        std::vector<std::array<uint32_t, 3>> shuffled;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            shuffled.push_back({ indices[i], indices[i + 1], indices[i + 2] });
+        }
+        std::ranges::shuffle(shuffled, std::mt19937(seed));
+        indices.clear();
+        for (const auto& triangle : shuffled)
+        {
+            indices.insert(indices.end(), triangle.begin(), triangle.end());
+        }
+    }
+
+    /// Gives every corner a vertex of its own, as unindexed imports do.
+    Assets::Primitive unweld(const Assets::Primitive& primitive)
+    {
+        Assets::Primitive result;
+        for (const uint32_t index : primitive.indices)
+        {
+            result.indices.push_back(static_cast<uint32_t>(result.streams.positions.size()));
+            result.streams.positions.push_back(primitive.streams.positions[index]);
+            result.streams.normals.push_back(primitive.streams.normals[index]);
+            result.streams.texCoords.push_back(primitive.streams.texCoords[index]);
+        }
+        return result;
+    }
+} // namespace
+
+TEST(MeshOptimizer, AnalyzesAFifoCache)
+{
+    const std::vector<uint32_t> pair { 0, 1, 2, 2, 1, 3 };
+    const auto                  statistics = Assets::analyzeVertexCache(pair, 4);
+    EXPECT_EQ(statistics.transforms, 4U);
+    EXPECT_FLOAT_EQ(statistics.acmr, 2.0F);
+    EXPECT_FLOAT_EQ(statistics.atvr, 1.0F);
+
+    // With three entries the fourth vertex evicts the first, which is missed again
+    const std::vector<uint32_t> revisit { 0, 1, 2, 1, 2, 3, 3, 2, 0 };
+    EXPECT_EQ(Assets::analyzeVertexCache(revisit, 4, 3).transforms, 5U);
+    EXPECT_EQ(Assets::analyzeVertexCache(revisit, 4, 4).transforms, 4U);
+
+    // Hits do not refresh a FIFO entry: 3 evicts 0 although it was just used
+    const std::vector<uint32_t> fan { 0, 1, 2, 0, 2, 3, 0, 3, 4 };
+    EXPECT_EQ(Assets::analyzeVertexCache(fan, 5, 3).transforms, 6U);
+
+    const auto empty = Assets::analyzeVertexCache({}, 0);
+    EXPECT_EQ(empty.transforms, 0U);
+    EXPECT_EQ(empty.acmr, 0.0F);
+    EXPECT_EQ(empty.atvr, 0.0F);
+}
+
+TEST(MeshOptimizer, WeldsIdenticalVertices)
+{
+    const Assets::Primitive grid = Tests::createGrid(6);
+    Assets::Primitive       split = unweld(grid);
+    ASSERT_EQ(split.vertexCount(), grid.indices.size());
+
+    EXPECT_EQ(Assets::weldVertices(split), grid.indices.size() - grid.vertexCount());
+    EXPECT_EQ(split.vertexCount(), grid.vertexCount());
+    EXPECT_EQ(triangles(split), triangles(grid));
+    EXPECT_EQ(Assets::weldVertices(split), 0U);
+}
+
+TEST(MeshOptimizer, KeepsVerticesThatDifferInAnyAttribute)
+{
+    const Assets::Primitive grid = Tests::createGrid(2);
+    Assets::Primitive       split = unweld(grid);
+
+    // A texture seam: same position, different coordinates
+    const uint32_t seam = split.indices[2];
+    split.streams.texCoords[seam][0] += 0.5F;
+    const size_t removed = Assets::weldVertices(split);
+    EXPECT_EQ(removed, grid.indices.size() - grid.vertexCount() - 1);
+    EXPECT_EQ(split.vertexCount(), grid.vertexCount() + 1);
+}
+
+TEST(MeshOptimizer, WeldsInterleavedVertices)
+{
+    const Assets::Primitive grid = Tests::createGrid(3);
+    Assets::Primitive       interleaved;
+    for (const uint32_t index : grid.indices)
+    {
+        interleaved.indices.push_back(static_cast<uint32_t>(interleaved.vertices.size()));
+        interleaved.vertices.push_back({ .position = grid.streams.positions[index],
+            .normal = grid.streams.normals[index],
+            .texCoord = grid.streams.texCoords[index],
+            .tangent = grid.streams.tangents[index],
+            .color = grid.streams.colors[index] });
+    }
+
+    Assets::weldVertices(interleaved);
+    EXPECT_EQ(interleaved.vertices.size(), grid.vertexCount());
+    EXPECT_EQ(triangles(interleaved), triangles(grid));
+}
+
+TEST(MeshOptimizer, VertexCacheOptimizationApproachesTheIdeal)
+{
+    Assets::Primitive sphere = Tests::createSphere(64, 96);
+    shuffleTriangles(sphere.indices, 7);
+    const auto expected = triangles(sphere);
+    const auto before = Assets::analyzeVertexCache(sphere.indices, sphere.vertexCount());
+
+    Assets::optimizeVertexCache(sphere.indices, sphere.vertexCount());
+    const auto after = Assets::analyzeVertexCache(sphere.indices, sphere.vertexCount());
+
+    EXPECT_EQ(triangles(sphere), expected);
+    EXPECT_GT(before.acmr, 2.5F);
+    EXPECT_LT(after.acmr, 0.8F);
+    EXPECT_LT(after.atvr, 1.6F);
+}
+
+TEST(MeshOptimizer, OverdrawOrderingStaysWithinTheCacheThreshold)
+{
+    Assets::Primitive sphere = Tests::createSphere(48, 64);
+    shuffleTriangles(sphere.indices, 11);
+    Assets::optimizeVertexCache(sphere.indices, sphere.vertexCount());
+    const auto expected = triangles(sphere);
+    const auto cached = Assets::analyzeVertexCache(sphere.indices, sphere.vertexCount());
+
+    Assets::optimizeOverdraw(sphere.indices, sphere.streams.positions, 1.05F);
+    const auto sorted = Assets::analyzeVertexCache(sphere.indices, sphere.vertexCount());
+
+    EXPECT_EQ(triangles(sphere), expected);
+    EXPECT_LE(sorted.acmr, cached.acmr * 1.05F + 1e-4F);
+}
+
+TEST(MeshOptimizer, VertexFetchFollowsFirstUse)
+{
+    Assets::Primitive grid = Tests::createGrid(5);
+    std::ranges::reverse(grid.indices);
+    // An extra vertex no triangle uses
+    grid.streams.positions.push_back({ 9.0F, 9.0F, 9.0F });
+    grid.streams.normals.push_back({ 0.0F, 1.0F, 0.0F });
+    grid.streams.texCoords.push_back({});
+    grid.streams.tangents.push_back({});
+    grid.streams.colors.push_back({});
+    const auto expected = triangles(grid);
+
+    EXPECT_EQ(Assets::optimizeVertexFetch(grid), 1U);
+    EXPECT_EQ(grid.vertexCount(), 36U);
+    EXPECT_EQ(grid.streams.normals.size(), 36U);
+    EXPECT_EQ(grid.streams.colors.size(), 36U);
+    EXPECT_EQ(triangles(grid), expected);
+
+    uint32_t next = 0;
+    for (const uint32_t index : grid.indices)
+    {
+        ASSERT_LE(index, next);
+        next = std::max(next, index + 1);
+    }
+}
+
+TEST(MeshOptimizer, OptimizesImportedMeshes)
+{
+    const Assets::Primitive sphere = Tests::createSphere(32, 48);
+    Assets::Primitive       imported = unweld(sphere);
+    shuffleTriangles(imported.indices, 3);
+
+    Assets::optimizeMesh(imported);
+    const auto statistics = Assets::analyzeVertexCache(imported.indices, imported.vertexCount());
+
+    EXPECT_EQ(imported.vertexCount(), sphere.vertexCount());
+    EXPECT_EQ(triangles(imported), triangles(sphere));
+    EXPECT_LT(statistics.acmr, 0.85F);
+    EXPECT_EQ(imported.indices.front(), 0U);
+}
@@ -0,0 +1,307 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+
+#include <gtest/gtest.h>
+
+#include "MeshSimplifier.hpp"
+#include "TestMeshes.hpp"
+
+namespace
+{
+    using Float3 = std::array<float, 3>;
+
+    Float3 subtract(const Float3& a, const Float3& b)
+    {
+        return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+    }
+
+    double dot(const Float3& a, const Float3& b)
+    {
+        return static_cast<double>(a[0]) * b[0] + static_cast<double>(a[1]) * b[1]
+            + static_cast<double>(a[2]) * b[2];
+    }
+
+    Float3 cross(const Float3& a, const Float3& b)
+    {
+        return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+            a[0] * b[1] - a[1] * b[0] };
+    }
+
+    /// Distance from p to the closest point of triangle abc, after Ericson's
+    /// Real-Time Collision Detection 5.1.5.
+    double pointTriangleDistance(const Float3& p, const Float3& a, const Float3& b, const Float3& c)
+    {
+        const Float3 ab = subtract(b, a);
+        const Float3 ac = subtract(c, a);
+        const Float3 ap = subtract(p, a);
+        const auto   distanceTo = [&p](const Float3& q) {
+            const Float3 d = subtract(p, q);
+            return std::sqrt(dot(d, d));
+        };
+        const auto along = [](const Float3& from, const Float3& edge, const double t) {
+            return Float3 { static_cast<float>(from[0] + t * edge[0]),
+                static_cast<float>(from[1] + t * edge[1]),
+                static_cast<float>(from[2] + t * edge[2]) };
+        };
+
+        const double d1 = dot(ab, ap);
+        const double d2 = dot(ac, ap);
+        if (d1 <= 0.0 && d2 <= 0.0)
+        {
+            return distanceTo(a);
+        }
+        const Float3 bp = subtract(p, b);
+        const double d3 = dot(ab, bp);
+        const double d4 = dot(ac, bp);
+        if (d3 >= 0.0 && d4 <= d3)
+        {
+            return distanceTo(b);
+        }
+        const double vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+        {
+            return distanceTo(along(a, ab, d1 / (d1 - d3)));
+        }
+        const Float3 cp = subtract(p, c);
+        const double d5 = dot(ab, cp);
+        const double d6 = dot(ac, cp);
+        if (d6 >= 0.0 && d5 <= d6)
+        {
+            return distanceTo(c);
+        }
+        const double vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+        {
+            return distanceTo(along(a, ac, d2 / (d2 - d6)));
+        }
+        const double va = d3 * d6 - d5 * d4;
+        if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+        {
+            return distanceTo(along(b, subtract(c, b), (d4 - d3) / ((d4 - d3) + (d5 - d6))));
+        }
+        const double denominator = 1.0 / (va + vb + vc);
+        const double v = vb * denominator;
+        const double w = vc * denominator;
+        return distanceTo(along(along(a, ab, v), ac, w));
+    }
+
+    /// Largest distance from an original vertex to the simplified surface, one side of
+    /// the Hausdorff distance.
+    double deviation(const Assets::Primitive& original, const std::vector<uint32_t>& simplified)
+    {
+        const auto& positions = original.streams.positions;
+        double      largest = 0.0;
+        for (const auto& p : positions)
+        {
+            double closest = std::numeric_limits<double>::max();
+            for (size_t i = 0; i + 2 < simplified.size(); i += 3)
+            {
+                closest = std::min(closest,
+                    pointTriangleDistance(p, positions[simplified[i]],
+                        positions[simplified[i + 1]], positions[simplified[i + 2]]));
+            }
+            largest = std::max(largest, closest);
+        }
+        return largest;
+    }
+
+    /// Position error alone unless texture coordinates are weighted.
+    Assets::SimplifyOptions simplifyOptions(
+        const float targetError, const bool lockBorder = true, const float texCoordWeight = 0.0F)
+    {
+        return { .targetError = targetError,
+            .lockBorder = lockBorder,
+            .normalWeight = 0.0F,
+            .texCoordWeight = texCoordWeight };
+    }
+
+    std::set<uint32_t> usedVertices(const std::vector<uint32_t>& indices)
+    {
+        return { indices.begin(), indices.end() };
+    }
+
+    /// Vertices on the outline of a grid over [0, 1] in xz.
+    std::set<uint32_t> borderVertices(const Assets::Primitive& grid)
+    {
+        std::set<uint32_t> result;
+        for (uint32_t v = 0; v < grid.vertexCount(); v++)
+        {
+            const auto& p = grid.streams.positions[v];
+            if (p[0] == 0.0F || p[0] == 1.0F || p[2] == 0.0F || p[2] == 1.0F)
+            {
+                result.insert(v);
+            }
+        }
+        return result;
+    }
+} // namespace
+
+TEST(MeshSimplifier, CollapsesAFlatGridWithoutError)
+{
+    const Assets::Primitive grid = Tests::createGrid(16);
+    const auto result
+        = Assets::simplifyMesh(grid.indices, grid.streams, 0, simplifyOptions(1.0e-3F));
+
+    // The 64 locked outline vertices stay and next to nothing of the 225 inside.
+    // A polygon of 64 corners takes 62 triangles, every vertex inside two more
+    const auto used = usedVertices(result.indices);
+    const auto border = borderVertices(grid);
+    EXPECT_TRUE(std::ranges::includes(used, border));
+    EXPECT_LE(used.size(), border.size() + 4);
+    EXPECT_EQ(result.indices.size(), (62 + 2 * (used.size() - border.size())) * 3);
+    EXPECT_LT(result.error, 1.0e-3F * 0.5F);
+
+    // Still covering the unit square, all facing up
+    double      area = 0.0;
+    const auto& positions = grid.streams.positions;
+    for (size_t i = 0; i < result.indices.size(); i += 3)
+    {
+        const auto&  a = positions[result.indices[i]];
+        const Float3 normal = cross(subtract(positions[result.indices[i + 1]], a),
+            subtract(positions[result.indices[i + 2]], a));
+        EXPECT_GE(normal[1], 0.0F);
+        area += 0.5 * normal[1];
+    }
+    EXPECT_NEAR(area, 1.0, 1.0e-5);
+}
+
+TEST(MeshSimplifier, StopsAtTheTargetCount)
+{
+    const Assets::Primitive sphere = Tests::createSphere(32, 48);
+    const size_t            target = sphere.indices.size() / 4 / 3 * 3;
+    const auto              result
+        = Assets::simplifyMesh(sphere.indices, sphere.streams, target, { .targetError = 1.0F,
+            .lockBorder = true,
+            .normalWeight = 0.5F,
+            .texCoordWeight = 0.5F });
+
+    EXPECT_LE(result.indices.size(), target);
+    EXPECT_GT(result.indices.size(), target * 9 / 10);
+    EXPECT_GT(result.error, 0.0F);
+    for (const uint32_t index : result.indices)
+    {
+        ASSERT_LT(index, sphere.vertexCount());
+    }
+
+    // Fewer indices than asked for returns the input
+    const auto unchanged
+        = Assets::simplifyMesh(sphere.indices, sphere.streams, sphere.indices.size());
+    EXPECT_EQ(unchanged.indices, sphere.indices);
+    EXPECT_EQ(unchanged.error, 0.0F);
+}
+
+TEST(MeshSimplifier, StaysWithinTheTargetError)
+{
+    const Assets::Primitive sphere = Tests::createSphere(24, 32);
+    size_t                  previousCount = sphere.indices.size();
+    for (const float targetError : { 1.0e-3F, 5.0e-3F, 2.0e-2F, 5.0e-2F })
+    {
+        SCOPED_TRACE(targetError);
+        const auto result = Assets::simplifyMesh(sphere.indices, sphere.streams, 0,
+            simplifyOptions(targetError));
+        EXPECT_LE(result.error, targetError);
+
+        // A looser bound collapses further
+        EXPECT_LE(result.indices.size(), previousCount);
+        previousCount = result.indices.size();
+
+        // The error is relative to the extent of 2. Being a mean over the planes a
+        // vertex gathered rather than a maximum, it bounds the distance of the removed
+        // surface to the simplified one to within a small factor
+        const double measured = deviation(sphere, result.indices);
+        EXPECT_LE(measured, 3.0 * result.error * 2.0);
+    }
+    EXPECT_LT(previousCount, sphere.indices.size() / 4);
+}
+
+TEST(MeshSimplifier, AttributeErrorLimitsCollapses)
+{
+    // Texture coordinates curving across a flat grid cost nothing geometrically, but
+    // collapsing them does once weighted
+    Assets::Primitive grid = Tests::createGrid(16);
+    for (auto& texCoord : grid.streams.texCoords)
+    {
+        texCoord = { texCoord[0] * texCoord[0], texCoord[1] * texCoord[1] };
+    }
+    const auto geometric
+        = Assets::simplifyMesh(grid.indices, grid.streams, 0, simplifyOptions(1.0e-3F));
+    const auto textured
+        = Assets::simplifyMesh(grid.indices, grid.streams, 0, simplifyOptions(1.0e-3F, true, 1.0F));
+
+    EXPECT_GT(textured.indices.size(), geometric.indices.size() * 2);
+    EXPECT_LE(textured.error, 1.0e-3F);
+}
+
+TEST(MeshSimplifier, LockedBordersKeepTheirVertices)
+{
+    const Assets::Primitive wave = Tests::createGrid(24, 0.05F);
+    const auto              border = borderVertices(wave);
+    const auto              locked
+        = Assets::simplifyMesh(wave.indices, wave.streams, 0, simplifyOptions(5.0e-2F));
+    const auto              lockedVertices = usedVertices(locked.indices);
+    EXPECT_TRUE(std::ranges::includes(lockedVertices, border));
+    EXPECT_LT(locked.indices.size(), wave.indices.size() / 4);
+
+    // Unlocked, the straight outline collapses along itself
+    const auto unlocked
+        = Assets::simplifyMesh(wave.indices, wave.streams, 0, simplifyOptions(5.0e-2F, false));
+    const auto unlockedVertices = usedVertices(unlocked.indices);
+    const auto kept = std::ranges::count_if(
+        border, [&unlockedVertices](const uint32_t v) { return unlockedVertices.contains(v); });
+    EXPECT_LT(static_cast<size_t>(kept), border.size() / 2);
+    EXPECT_LE(unlocked.error, 5.0e-2F);
+}
+
+TEST(MeshSimplifier, LodChainsGrowCoarserWithinTheBudget)
+{
+    const Assets::Primitive       sphere = Tests::createSphere(32, 48);
+    const Assets::LodChainOptions options { .maxLods = 5,
+        .ratio = 0.5F,
+        .maxError = 0.1F,
+        .minTriangles = 32,
+        .simplify = {} };
+    const auto chain = Assets::generateLodChain(sphere.indices, sphere.streams, options);
+
+    ASSERT_GE(chain.size(), 3U);
+    ASSERT_LE(chain.size(), options.maxLods);
+    EXPECT_EQ(chain[0].indices, sphere.indices);
+    EXPECT_EQ(chain[0].error, 0.0F);
+    for (size_t lod = 1; lod < chain.size(); lod++)
+    {
+        SCOPED_TRACE(lod);
+        const size_t previous = chain[lod - 1].indices.size();
+        EXPECT_LE(chain[lod].indices.size(), previous * 3 / 4);
+        EXPECT_GE(chain[lod].error, chain[lod - 1].error);
+        EXPECT_LE(chain[lod].error, options.maxError);
+        EXPECT_GE(chain[lod].indices.size() / 3, options.minTriangles);
+        EXPECT_LE(deviation(sphere, chain[lod].indices), 3.0 * chain[lod].error * 2.0);
+    }
+}
+
+TEST(MeshSimplifier, LodChainsEndWhenTheBudgetIsSpent)
+{
+    const Assets::Primitive sphere = Tests::createSphere(32, 48);
+    const auto              chainLength = [&sphere](const Assets::LodChainOptions& options) {
+        return Assets::generateLodChain(sphere.indices, sphere.streams, options).size();
+    };
+
+    Assets::LodChainOptions exact;
+    exact.maxError = 1.0e-6F;
+    EXPECT_EQ(chainLength(exact), 1U);
+
+    Assets::LodChainOptions single;
+    single.maxLods = 1;
+    EXPECT_EQ(chainLength(single), 1U);
+
+    // A floor above half the triangles stops after the full detail level
+    Assets::LodChainOptions floor;
+    floor.minTriangles = sphere.indices.size() / 3;
+    EXPECT_EQ(chainLength(floor), 1U);
+}
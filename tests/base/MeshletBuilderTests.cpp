@@ -0,0 +1,265 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "MeshOptimizer.hpp"
+#include "MeshletBuilder.hpp"
+#include "TestMeshes.hpp"
+
+namespace
+{
+    using Float3 = std::array<float, 3>;
+    using Triangle = std::array<uint32_t, 3>;
+
+    Float3 subtract(const Float3& a, const Float3& b)
+    {
+        return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+    }
+
+    float dot(const Float3& a, const Float3& b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    Float3 cross(const Float3& a, const Float3& b)
+    {
+        return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+    }
+
+    Triangle rotated(Triangle triangle)
+    {
+        std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+        return triangle;
+    }
+
+    /// Primitive vertex indices of each triangle of a meshlet.
+    std::vector<Triangle> triangles(const Assets::MeshletData& data, const Assets::Meshlet& meshlet)
+    {
+        std::vector<Triangle> result;
+        for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+        {
+            Triangle corners {};
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                const size_t local = data.triangles[meshlet.triangleOffset + triangle * 3 + corner];
+                corners[corner] = data.vertices[meshlet.vertexOffset + local];
+            }
+            result.push_back(corners);
+        }
+        return result;
+    }
+
+    Assets::Primitive optimizedSphere(const uint32_t rings, const uint32_t segments)
+    {
+        Assets::Primitive sphere = Tests::createSphere(rings, segments);
+        Assets::optimizeVertexCache(sphere.indices, sphere.vertexCount());
+        return sphere;
+    }
+
+    /// Row-vector transform onto Metal clip space of a camera at z = -distance looking
+    /// down +z with a square field of view.
+    Assets::Matrix4 perspective(const float distance, const float fieldOfView)
+    {
+        const float scale = 1.0F / std::tan(fieldOfView / 2.0F);
+        const float nearZ = 0.1F;
+        const float farZ = 100.0F;
+        const float range = farZ / (farZ - nearZ);
+        return { scale, 0.0F, 0.0F, 0.0F, 0.0F, scale, 0.0F, 0.0F, 0.0F, 0.0F, range, 1.0F, 0.0F,
+            0.0F, (distance - nearZ) * range, distance };
+    }
+} // namespace
+
+TEST(MeshletBuilder, RespectsTheLimits)
+{
+    const Assets::Primitive sphere = optimizedSphere(48, 64);
+    for (const auto& options : { Assets::MeshletBuildOptions {},
+             Assets::MeshletBuildOptions { .maxVertices = 32, .maxTriangles = 40 },
+             Assets::MeshletBuildOptions { .maxVertices = 255, .maxTriangles = 512 } })
+    {
+        const auto data = Assets::buildMeshlets(sphere.indices, sphere.streams.positions, options);
+        ASSERT_FALSE(data.meshlets.empty());
+        for (const auto& meshlet : data.meshlets)
+        {
+            EXPECT_GT(meshlet.triangleCount, 0U);
+            EXPECT_LE(meshlet.vertexCount, options.maxVertices);
+            EXPECT_LE(meshlet.triangleCount, options.maxTriangles);
+            EXPECT_LE(meshlet.vertexOffset + meshlet.vertexCount, data.vertices.size());
+            EXPECT_LE(meshlet.triangleOffset + meshlet.triangleCount * 3, data.triangles.size());
+            for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++)
+            {
+                EXPECT_LT(data.triangles[meshlet.triangleOffset + i], meshlet.vertexCount);
+            }
+        }
+    }
+}
+
+TEST(MeshletBuilder, CoversEveryTriangleOnce)
+{
+    const Assets::Primitive sphere = optimizedSphere(24, 40);
+    const auto              data = Assets::buildMeshlets(sphere.indices, sphere.streams.positions);
+
+    std::vector<Triangle> expected;
+    for (size_t i = 0; i < sphere.indices.size(); i += 3)
+    {
+        expected.push_back(
+            rotated({ sphere.indices[i], sphere.indices[i + 1], sphere.indices[i + 2] }));
+    }
+    std::vector<Triangle> actual;
+    for (const auto& meshlet : data.meshlets)
+    {
+        for (const auto& triangle : triangles(data, meshlet))
+        {
+            actual.push_back(rotated(triangle));
+        }
+    }
+    std::ranges::sort(expected);
+    std::ranges::sort(actual);
+    EXPECT_EQ(actual, expected);
+}
+
+TEST(MeshletBuilder, FillsMeshletsOfACacheOptimizedMesh)
+{
+    // 48 x 64 quads: 6016 triangles, at least 49 meshlets of 124
+    const Assets::Primitive sphere = optimizedSphere(48, 64);
+    const auto              data = Assets::buildMeshlets(sphere.indices, sphere.streams.positions);
+    const size_t            triangleCount = sphere.indices.size() / 3;
+    EXPECT_LE(data.meshlets.size(), triangleCount / Assets::g_meshletMaxTriangles * 3 / 2);
+
+    // Locality: on average a vertex is shared by fewer than two meshlets
+    EXPECT_LT(data.vertices.size(), 2 * sphere.vertexCount());
+}
+
+TEST(MeshletBuilder, BoundsEncloseTheMeshlet)
+{
+    const Assets::Primitive sphere = optimizedSphere(32, 48);
+    const auto&             positions = sphere.streams.positions;
+    const auto              data = Assets::buildMeshlets(sphere.indices, positions);
+    for (const auto& meshlet : data.meshlets)
+    {
+        EXPECT_GT(meshlet.radius, 0.0F);
+        for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+        {
+            const Float3 offset =
+                subtract(positions[data.vertices[meshlet.vertexOffset + i]], meshlet.center);
+            EXPECT_LE(std::sqrt(dot(offset, offset)), meshlet.radius * 1.0001F);
+        }
+        EXPECT_NEAR(dot(meshlet.coneAxis, meshlet.coneAxis), 1.0F, 1e-4F);
+        EXPECT_LE(meshlet.coneCutoff, 1.0F);
+    }
+}
+
+TEST(MeshletBuilder, ConeRejectsOnlyBackFacingMeshlets)
+{
+    const Assets::Primitive sphere = optimizedSphere(32, 48);
+    const auto&             positions = sphere.streams.positions;
+    const auto              data = Assets::buildMeshlets(sphere.indices, positions);
+
+    // No frustum planes reject anything; cameras all around the sphere
+    const Assets::Frustum everywhere {};
+    size_t                rejected = 0;
+    for (const Float3& camera : { Float3 { 0.0F, 0.0F, -3.0F }, Float3 { 2.0F, 1.5F, 0.5F },
+             Float3 { 0.0F, -1.2F, 0.0F }, Float3 { 10.0F, 0.0F, 0.0F } })
+    {
+        for (const auto& meshlet : data.meshlets)
+        {
+            Assets::MeshletCullStatistics statistics;
+            if (Assets::isMeshletVisible(meshlet, everywhere, camera, statistics))
+            {
+                continue;
+            }
+            EXPECT_EQ(statistics.coneRejected, 1U);
+            rejected++;
+            for (const auto& triangle : triangles(data, meshlet))
+            {
+                const Float3& a = positions[triangle[0]];
+                const Float3  normal = cross(
+                    subtract(positions[triangle[1]], a), subtract(positions[triangle[2]], a));
+                EXPECT_GE(dot(normal, subtract(a, camera)), 0.0F);
+            }
+        }
+    }
+    // Each camera sees less than half of the sphere; the cones catch much of the rest
+    EXPECT_GT(rejected, data.meshlets.size());
+}
+
+TEST(MeshletBuilder, ExtractsFrustumPlanes)
+{
+    // The identity maps the box [-1, 1] x [-1, 1] x [0, 1] onto clip space
+    const Assets::Matrix4 identity { 1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F, 0.0F, 0.0F, 0.0F,
+        1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F };
+    const Assets::Frustum frustum = Assets::extractFrustum(identity);
+    const std::array<std::array<float, 4>, 6> expected { { { 1.0F, 0.0F, 0.0F, 1.0F },
+        { -1.0F, 0.0F, 0.0F, 1.0F }, { 0.0F, 1.0F, 0.0F, 1.0F }, { 0.0F, -1.0F, 0.0F, 1.0F },
+        { 0.0F, 0.0F, 1.0F, 0.0F }, { 0.0F, 0.0F, -1.0F, 1.0F } } };
+    for (size_t plane = 0; plane < 6; plane++)
+    {
+        for (size_t i = 0; i < 4; i++)
+        {
+            EXPECT_FLOAT_EQ(frustum.planes[plane][i], expected[plane][i]) << plane;
+        }
+    }
+
+    // A 90 degree perspective: the side planes are normalized 45 degree planes
+    const Assets::Frustum camera = Assets::extractFrustum(perspective(5.0F, 1.5707964F));
+    EXPECT_NEAR(camera.planes[0][0], std::sqrt(0.5F), 1e-5F);
+    EXPECT_NEAR(camera.planes[0][2], std::sqrt(0.5F), 1e-5F);
+    EXPECT_NEAR(camera.planes[0][3], 5.0F * std::sqrt(0.5F), 1e-4F);
+}
+
+TEST(MeshletBuilder, FrustumRejectsSpheresOutside)
+{
+    const Assets::Frustum frustum = Assets::extractFrustum(perspective(5.0F, 1.0F));
+    const auto            meshlet = [](const Float3& center, const float radius) {
+        return Assets::Meshlet { .vertexOffset = 0,
+            .triangleOffset = 0,
+            .vertexCount = 0,
+            .triangleCount = 0,
+            .center = center,
+            .radius = radius,
+            .coneAxis = {},
+            .coneCutoff = 1.0F };
+    };
+    const std::vector<Assets::Meshlet> meshlets {
+        meshlet({ 0.0F, 0.0F, 0.0F }, 1.0F),    // In front of the camera
+        meshlet({ 0.0F, 0.0F, -8.0F }, 1.0F),   // Behind it
+        meshlet({ 20.0F, 0.0F, 0.0F }, 1.0F),   // Right of the view
+        meshlet({ 0.0F, 0.0F, 200.0F }, 1.0F),  // Past the far plane
+        meshlet({ 0.0F, 0.0F, -5.0F }, 0.5F),   // Around the camera
+        meshlet({ 0.0F, 3.2F, 0.0F }, 0.5F),    // Straddling the top plane
+    };
+
+    std::vector<uint32_t>         visible;
+    Assets::MeshletCullStatistics statistics;
+    Assets::cullMeshlets(meshlets, frustum, { 0.0F, 0.0F, -5.0F }, visible, statistics);
+    EXPECT_EQ(visible, (std::vector<uint32_t> { 0, 4, 5 }));
+    EXPECT_EQ(statistics.tested, 6U);
+    EXPECT_EQ(statistics.frustumRejected, 3U);
+    EXPECT_EQ(statistics.coneRejected, 0U);
+    EXPECT_EQ(statistics.visible(), 3U);
+}
+
+TEST(MeshletBuilder, CullsAFlatGridSeenFromBehind)
+{
+    Assets::Primitive grid = Tests::createGrid(32);
+    Assets::optimizeVertexCache(grid.indices, grid.vertexCount());
+    const auto            data = Assets::buildMeshlets(grid.indices, grid.streams.positions);
+    const Assets::Frustum everywhere {};
+
+    // The grid faces +y; from below every meshlet is back facing, from above none is
+    std::vector<uint32_t>         visible;
+    Assets::MeshletCullStatistics below;
+    Assets::cullMeshlets(data.meshlets, everywhere, { 0.5F, -2.0F, 0.5F }, visible, below);
+    EXPECT_TRUE(visible.empty());
+    EXPECT_EQ(below.coneRejected, data.meshlets.size());
+
+    Assets::MeshletCullStatistics above;
+    Assets::cullMeshlets(data.meshlets, everywhere, { 0.5F, 2.0F, 0.5F }, visible, above);
+    EXPECT_EQ(visible.size(), data.meshlets.size());
+    EXPECT_EQ(above.coneRejected, 0U);
+}
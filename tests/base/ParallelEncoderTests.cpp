@@ -0,0 +1,355 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ParallelEncoder.hpp"
+#include "RecordingEncoder.hpp"
+#include "ThreadPool.hpp"
+
+namespace
+{
+    using CommandBufferHandle = std::shared_ptr<RecordingCommandBuffer>;
+    using AllocatorHandle = std::shared_ptr<RecordingAllocator>;
+    using Encoder = ParallelEncoder<CommandBufferHandle, AllocatorHandle>;
+
+    /// Creates recording buffers and allocators, keeping every allocator to inspect.
+    struct RecordingBackend
+    {
+        Encoder::Backend backend()
+        {
+            return { .createAllocator =
+                         [this] {
+                             allocators.push_back(std::make_shared<RecordingAllocator>());
+                             return allocators.back();
+                         },
+                .resetAllocator =
+                    [this](AllocatorHandle& allocator) {
+                        allocator->reset();
+                        resets++;
+                    },
+                .createCommandBuffer = [] { return std::make_shared<RecordingCommandBuffer>(); },
+                .beginCommandBuffer =
+                    [](CommandBufferHandle& commandBuffer, AllocatorHandle& allocator) {
+                        commandBuffer->begin(*allocator);
+                    },
+                .endCommandBuffer =
+                    [](CommandBufferHandle& commandBuffer) { commandBuffer->end(); } };
+        }
+
+        std::vector<AllocatorHandle> allocators;
+        size_t                       resets = 0;
+    };
+
+    /// Checks that the partitions cover [0, itemCount) in order, each with items.
+    void expectCovers(const std::vector<EncodePartition>& partitions, const size_t itemCount)
+    {
+        size_t next = 0;
+        for (size_t i = 0; i < partitions.size(); i++)
+        {
+            EXPECT_EQ(partitions[i].index, i);
+            EXPECT_EQ(partitions[i].count, partitions.size());
+            EXPECT_EQ(partitions[i].begin, next) << "partition " << i;
+            EXPECT_LT(partitions[i].begin, partitions[i].end) << "partition " << i;
+            next = partitions[i].end;
+        }
+        EXPECT_EQ(next, itemCount);
+        if (!partitions.empty())
+        {
+            EXPECT_TRUE(partitions.front().isFirst());
+            EXPECT_TRUE(partitions.back().isLast());
+        }
+    }
+
+    uint64_t partitionCost(const std::span<const uint32_t> costs, const EncodePartition& partition)
+    {
+        uint64_t cost = 0;
+        for (size_t i = partition.begin; i < partition.end; i++)
+        {
+            cost += costs[i];
+        }
+        return cost;
+    }
+} // namespace
+
+TEST(ParallelEncoder, PartitionItemsCoversAndBalances)
+{
+    for (const size_t itemCount : { 1, 7, 64, 1'000, 1'001 })
+    {
+        for (const uint32_t maxPartitions : { 1U, 3U, 8U })
+        {
+            for (const size_t minItems : { 1, 10, 200 })
+            {
+                const auto partitions = partitionItems(itemCount, maxPartitions, minItems);
+                expectCovers(partitions, itemCount);
+                ASSERT_FALSE(partitions.empty());
+                EXPECT_LE(partitions.size(), maxPartitions);
+
+                size_t smallest = itemCount;
+                size_t largest = 0;
+                for (const auto& partition : partitions)
+                {
+                    smallest = std::min(smallest, partition.end - partition.begin);
+                    largest = std::max(largest, partition.end - partition.begin);
+                }
+                EXPECT_LE(largest - smallest, 1U);
+                if (itemCount >= minItems)
+                {
+                    EXPECT_GE(smallest, minItems)
+                        << itemCount << " items, " << maxPartitions << " partitions";
+                }
+            }
+        }
+    }
+}
+
+TEST(ParallelEncoder, PartitionItemsEdgeCases)
+{
+    EXPECT_TRUE(partitionItems(0, 4).empty());
+
+    // Fewer items than partitions gives one item each
+    const auto few = partitionItems(3, 8);
+    expectCovers(few, 3);
+    EXPECT_EQ(few.size(), 3U);
+
+    // Fewer items than the minimum still makes one partition
+    const auto small = partitionItems(5, 8, 100);
+    expectCovers(small, 5);
+    EXPECT_EQ(small.size(), 1U);
+
+    // Zero limits behave like one
+    expectCovers(partitionItems(10, 0), 10);
+    EXPECT_EQ(partitionItems(10, 0).size(), 1U);
+    EXPECT_EQ(partitionItems(10, 4, 0).size(), 4U);
+}
+
+TEST(ParallelEncoder, PartitionByCostCoversAndBalances)
+{
+    std::mt19937                            random(9);
+    std::uniform_int_distribution<uint32_t> costDistribution(1, 100);
+    std::vector<uint32_t>                   costs(1'000);
+    std::ranges::generate(costs, [&] { return costDistribution(random); });
+    uint64_t totalCost = 0;
+    uint32_t maxItemCost = 0;
+    for (const uint32_t cost : costs)
+    {
+        totalCost += cost;
+        maxItemCost = std::max(maxItemCost, cost);
+    }
+
+    for (const uint32_t maxPartitions : { 1U, 2U, 5U, 16U })
+    {
+        const auto partitions = partitionByCost(costs, maxPartitions);
+        expectCovers(partitions, costs.size());
+        EXPECT_EQ(partitions.size(), maxPartitions);
+
+        // Every partition is within one item of an even share
+        const uint64_t share = totalCost / partitions.size();
+        for (const auto& partition : partitions)
+        {
+            const uint64_t cost = partitionCost(costs, partition);
+            EXPECT_LE(cost, share + maxItemCost) << "partition " << partition.index;
+            EXPECT_GE(cost + maxItemCost, share) << "partition " << partition.index;
+        }
+    }
+}
+
+TEST(ParallelEncoder, PartitionByCostHonoursTheMinimumCost)
+{
+    const std::vector<uint32_t> costs(100, 1);
+    const auto                  partitions = partitionByCost(costs, 8, 30);
+    expectCovers(partitions, costs.size());
+    EXPECT_EQ(partitions.size(), 3U);
+    for (const auto& partition : partitions)
+    {
+        EXPECT_GE(partitionCost(costs, partition), 30U) << "partition " << partition.index;
+    }
+
+    // A total below the minimum makes one partition
+    EXPECT_EQ(partitionByCost(costs, 8, 1'000).size(), 1U);
+}
+
+TEST(ParallelEncoder, PartitionByCostEdgeCases)
+{
+    EXPECT_TRUE(partitionByCost({}, 4).empty());
+
+    // Fewer items than partitions gives one item each, even with one costly item
+    const std::vector<uint32_t> few { 1'000, 1, 1 };
+    const auto                  fewPartitions = partitionByCost(few, 8);
+    expectCovers(fewPartitions, few.size());
+    EXPECT_EQ(fewPartitions.size(), 3U);
+
+    // Items that cost nothing are kept together
+    const std::vector<uint32_t> zeroCosts(10, 0);
+    expectCovers(partitionByCost(zeroCosts, 4), zeroCosts.size());
+    EXPECT_EQ(partitionByCost(zeroCosts, 4).size(), 1U);
+
+    // A costly first item does not leave later partitions empty
+    const std::vector<uint32_t> frontLoaded { 1'000, 1, 1, 1, 1 };
+    expectCovers(partitionByCost(frontLoaded, 4), frontLoaded.size());
+    EXPECT_EQ(partitionByCost(frontLoaded, 4).size(), 4U);
+}
+
+TEST(ParallelEncoder, CommandBuffersFollowEncodeOrder)
+{
+    ThreadPool       pool(4);
+    RecordingBackend recording;
+    Encoder          encoder(recording.backend(), 2, pool);
+
+    // Each partition tags its buffer with its call and partition
+    encoder.beginFrame(0);
+    for (uint32_t call = 0; call < 3; call++)
+    {
+        const auto partitions = partitionItems(100, call + 2);
+        encoder.encode(partitions,
+            [call](CommandBufferHandle& commandBuffer, const EncodePartition& partition) {
+                commandBuffer->setPipeline(call * 100 + partition.index);
+            });
+    }
+
+    const auto commandBuffers = encoder.commandBuffers();
+    ASSERT_EQ(commandBuffers.size(), 2U + 3U + 4U);
+    std::vector<uint32_t> tags;
+    for (const auto& commandBuffer : commandBuffers)
+    {
+        ASSERT_EQ(commandBuffer->commands().size(), 1U);
+        tags.push_back(commandBuffer->commands()[0].arguments[0]);
+    }
+    EXPECT_EQ(tags, (std::vector<uint32_t> { 0, 1, 100, 101, 102, 200, 201, 202, 203 }));
+
+    // The next frame reuses the buffers from the start
+    encoder.beginFrame(1);
+    EXPECT_TRUE(encoder.commandBuffers().empty());
+    encoder.encode(partitionItems(10, 2),
+        [](CommandBufferHandle& commandBuffer, const EncodePartition& partition) {
+            commandBuffer->setPipeline(partition.index);
+        });
+    ASSERT_EQ(encoder.commandBuffers().size(), 2U);
+    EXPECT_EQ(encoder.commandBuffers()[0], commandBuffers[0]);
+}
+
+TEST(ParallelEncoder, AllocatorsResetOnlyWhenTheirSlotComesAround)
+{
+    ThreadPool       pool(4);
+    RecordingBackend recording;
+    Encoder          encoder(recording.backend(), 2, pool);
+    const auto       partitions = partitionItems(100, 3);
+    const auto       drawEach = [](CommandBufferHandle& commandBuffer,
+                              const EncodePartition& partition) {
+        for (size_t i = partition.begin; i < partition.end; i++)
+        {
+            commandBuffer->draw(0, static_cast<uint32_t>(i), 1);
+        }
+    };
+
+    encoder.beginFrame(0);
+    encoder.encode(partitions, drawEach);
+    ASSERT_EQ(recording.allocators.size(), 3U);
+    const std::vector<AllocatorHandle> slot0 = recording.allocators;
+
+    // Frame 1 uses its own allocators and leaves frame 0's commands alone, as the
+    // GPU may still be reading them
+    encoder.beginFrame(1);
+    encoder.encode(partitions, drawEach);
+    EXPECT_EQ(recording.resets, 0U);
+    EXPECT_EQ(encoder.allocatorCount(), 6U);
+    size_t slot0Commands = 0;
+    for (const auto& allocator : slot0)
+    {
+        slot0Commands += allocator->commandCount();
+    }
+    EXPECT_EQ(slot0Commands, 100U);
+
+    // Coming back to slot 0 resets exactly its allocators and reuses them
+    encoder.beginFrame(0);
+    EXPECT_EQ(recording.resets, 3U);
+    for (const auto& allocator : slot0)
+    {
+        EXPECT_EQ(allocator->commandCount(), 0U);
+    }
+    for (size_t i = 3; i < 6; i++)
+    {
+        EXPECT_GT(recording.allocators[i]->commandCount(), 0U) << "allocator " << i;
+    }
+    encoder.encode(partitions, drawEach);
+    EXPECT_EQ(encoder.allocatorCount(), 6U);
+
+    // Only the allocators a frame used are reset
+    encoder.beginFrame(1);
+    encoder.encode(partitionItems(100, 1), drawEach);
+    encoder.beginFrame(1);
+    EXPECT_EQ(recording.resets, 3U + 3U + 1U);
+}
+
+TEST(ParallelEncoder, OutOfRangeFrameSlotThrows)
+{
+    RecordingBackend recording;
+    Encoder          encoder(recording.backend(), 3);
+    EXPECT_NO_THROW(encoder.beginFrame(2));
+    EXPECT_THROW(encoder.beginFrame(3), std::runtime_error);
+    EXPECT_THROW(encoder.beginFrame(100), std::runtime_error);
+}
+
+TEST(ParallelEncoder, EncodedBatchesMatchASingleBuffer)
+{
+    Render::RenderQueue queue;
+    for (uint32_t i = 0; i < 2'000; i++)
+    {
+        const Render::DrawState state { .pipeline = i % 3, .material = i % 5, .mesh = i % 7 };
+        queue.submit(Render::makeSortKey(state, 0.5F), i);
+    }
+    const auto batches = queue.build();
+
+    RecordingAllocator     singleAllocator;
+    RecordingCommandBuffer single;
+    single.begin(singleAllocator);
+    encodeBatches(single, batches);
+    single.end();
+
+    ThreadPool       pool(4);
+    RecordingBackend recording;
+    Encoder          encoder(recording.backend(), 1, pool);
+    encoder.beginFrame(0);
+    encoder.encode(partitionItems(batches.size(), 4),
+        [&](CommandBufferHandle& commandBuffer, const EncodePartition& partition) {
+            encodeBatches(*commandBuffer,
+                batches.subspan(partition.begin, partition.end - partition.begin));
+        });
+
+    // The partitions draw the same batches in the same order
+    std::vector<RecordedCommand> draws;
+    for (const auto& commandBuffer : encoder.commandBuffers())
+    {
+        for (const auto& command : commandBuffer->commands())
+        {
+            if (command.type == RecordedCommand::Type::Draw)
+            {
+                draws.push_back(command);
+            }
+        }
+    }
+    std::vector<RecordedCommand> expected;
+    for (const auto& command : single.commands())
+    {
+        if (command.type == RecordedCommand::Type::Draw)
+        {
+            expected.push_back(command);
+        }
+    }
+    ASSERT_EQ(draws.size(), expected.size());
+    for (size_t i = 0; i < draws.size(); i++)
+    {
+        EXPECT_EQ(draws[i].arguments, expected[i].arguments) << "draw " << i;
+    }
+}
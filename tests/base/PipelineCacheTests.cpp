@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "PipelineCache.hpp"
+#include "TemporaryDirectory.hpp"
+
+namespace
+{
+    std::span<const std::byte> asBytes(std::string_view text)
+    {
+        return std::as_bytes(std::span(text.data(), text.size()));
+    }
+
+    /// The instancing example's pipeline.
+    PipelineDescription instancingPipeline()
+    {
+        PipelineDescription description;
+        description.vertexFunction = "vertexFunction";
+        description.fragmentFunction = "fragmentFunction";
+        description.vertexAttributes = {
+            { .index = 0, .format = 31, .offset = 0, .bufferIndex = 0 },
+            { .index = 1, .format = 31, .offset = 16, .bufferIndex = 0 },
+        };
+        description.vertexLayouts = { { .bufferIndex = 0, .stride = 32 } };
+        description.colorAttachments = { { .pixelFormat = 81 } };
+        description.rasterSampleCount = 4;
+        return description;
+    }
+} // namespace
+
+TEST(PipelineKey, MatchesMurmurHash3)
+{
+    EXPECT_EQ(hashBytes({}), (PipelineKey { 0, 0 }));
+    EXPECT_EQ(hashBytes(asBytes("hello")).toString(), "cbd8a7b341bd9b025b1e906a48ae1d19");
+    EXPECT_NE(hashBytes(asBytes("hello"), 1), hashBytes(asBytes("hello")));
+}
+
+TEST(PipelineKey, IsStableAcrossRuns)
+{
+    // Persisted manifests rely on this; a change here invalidates every cache
+    EXPECT_EQ(instancingPipeline().key().toString(), "76475bc8b0450b27fa6e1a21e2a37ea5");
+    EXPECT_EQ(instancingPipeline().key(),
+        hashBytes(std::span<const std::byte>(instancingPipeline().serialize())));
+}
+
+TEST(PipelineKey, EquivalentDescriptionsShareAKey)
+{
+    const PipelineDescription reference = instancingPipeline();
+
+    auto reordered = reference;
+    std::swap(reordered.vertexAttributes[0], reordered.vertexAttributes[1]);
+    EXPECT_EQ(reordered.key(), reference.key());
+
+    auto unusedLayout = reference;
+    unusedLayout.vertexLayouts.push_back({ .bufferIndex = 5, .stride = 64 });
+    EXPECT_EQ(unusedLayout.key(), reference.key());
+
+    auto unusedAttachment = reference;
+    unusedAttachment.colorAttachments.push_back({});
+    EXPECT_EQ(unusedAttachment.key(), reference.key());
+
+    auto ignoredBlend = reference;
+    ignoredBlend.colorAttachments[0].sourceRGBBlendFactor = 4;
+    EXPECT_EQ(ignoredBlend.key(), reference.key());
+}
+
+TEST(PipelineKey, DifferentPipelinesHaveDifferentKeys)
+{
+    const PipelineDescription reference = instancingPipeline();
+
+    auto samples = reference;
+    samples.rasterSampleCount = 1;
+    auto blending = reference;
+    blending.colorAttachments[0].blendingEnabled = true;
+    auto function = reference;
+    function.fragmentFunction = "fragmentFunction2";
+    auto stride = reference;
+    stride.vertexLayouts[0].stride = 48;
+
+    for (const auto& other : { samples, blending, function, stride })
+    {
+        EXPECT_NE(other.key(), reference.key());
+    }
+}
+
+TEST(PipelineDescription, SerializationRoundTrips)
+{
+    auto description = instancingPipeline();
+    description.colorAttachments[0].blendingEnabled = true;
+    description.colorAttachments[0].sourceRGBBlendFactor = 4;
+
+    const auto bytes = description.serialize();
+    const auto parsed = PipelineDescription::deserialize(bytes);
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->serialize(), bytes);
+    EXPECT_EQ(parsed->key(), description.key());
+    EXPECT_EQ(parsed->vertexFunction, "vertexFunction");
+    EXPECT_EQ(parsed->rasterSampleCount, 4U);
+
+    for (size_t size = 0; size < bytes.size(); size++)
+    {
+        EXPECT_FALSE(PipelineDescription::deserialize(std::span(bytes).first(size)).has_value());
+    }
+}
+
+TEST(PipelineCache, ConcurrentRequestsCreateOnce)
+{
+    PipelineCache<int>       cache;
+    std::atomic<int>         factoryCalls = 0;
+    const PipelineKey        key = instancingPipeline().key();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++)
+    {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 1000; j++)
+            {
+                EXPECT_EQ(cache.getOrCreate(key, [&] {
+                    factoryCalls++;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    return 42;
+                }),
+                    42);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(factoryCalls, 1);
+    EXPECT_EQ(cache.size(), 1U);
+    EXPECT_EQ(cache.statistics().misses, 1U);
+    EXPECT_EQ(cache.statistics().hits, 7999U);
+    ASSERT_NE(cache.find(key), nullptr);
+    EXPECT_EQ(*cache.find(key), 42);
+}
+
+TEST(PipelineCache, FailedCreationIsRetried)
+{
+    PipelineCache<int> cache;
+    const PipelineKey  key { 1, 2 };
+    EXPECT_THROW(static_cast<void>(cache.getOrCreate(
+                     key, []() -> int { throw std::runtime_error("compile failed"); })),
+        std::runtime_error);
+    EXPECT_EQ(cache.find(key), nullptr);
+    EXPECT_EQ(cache.getOrCreate(key, [] { return 7; }), 7);
+    EXPECT_EQ(*cache.find(key), 7);
+}
+
+TEST(PipelineCacheManifest, RoundTripsThroughDisk)
+{
+    TemporaryDirectory directory;
+    const auto         path = directory.path() / "pipelines.manifest";
+
+    auto blended = instancingPipeline();
+    blended.colorAttachments[0].blendingEnabled = true;
+
+    PipelineCacheManifest manifest("device-os-1");
+    EXPECT_TRUE(manifest.add(instancingPipeline()));
+    EXPECT_FALSE(manifest.add(instancingPipeline()));
+    EXPECT_TRUE(manifest.add(blended));
+    manifest.save(path);
+
+    PipelineCacheManifest loaded("device-os-1");
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.size(), 2U);
+    EXPECT_TRUE(loaded.contains(instancingPipeline().key()));
+    EXPECT_TRUE(loaded.contains(blended.key()));
+    EXPECT_EQ(loaded.descriptions()[1].serialize(), blended.serialize());
+
+    PipelineCacheManifest otherDevice("device-os-2");
+    EXPECT_FALSE(otherDevice.load(path));
+    EXPECT_EQ(otherDevice.size(), 0U);
+}
+
+TEST(PipelineCacheManifest, RejectsMissingAndCorruptFiles)
+{
+    TemporaryDirectory directory;
+    const auto         path = directory.path() / "pipelines.manifest";
+
+    PipelineCacheManifest manifest;
+    EXPECT_FALSE(manifest.load(path));
+
+    manifest.add(instancingPipeline());
+    manifest.save(path);
+    {
+        std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekp(12);
+        stream.put('\x7F');
+    }
+
+    PipelineCacheManifest corrupt;
+    EXPECT_FALSE(corrupt.load(path));
+    EXPECT_EQ(corrupt.size(), 0U);
+}
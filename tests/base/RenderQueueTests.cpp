@@ -0,0 +1,259 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "RenderQueue.hpp"
+#include "ThreadPool.hpp"
+
+namespace
+{
+    void expectState(const Render::DrawState& actual, const Render::DrawState& expected)
+    {
+        EXPECT_EQ(actual.pass, expected.pass);
+        EXPECT_EQ(actual.pipeline, expected.pipeline);
+        EXPECT_EQ(actual.material, expected.material);
+        EXPECT_EQ(actual.mesh, expected.mesh);
+    }
+
+    /// Random keys with few distinct values in the high bits, so equal keys are
+    /// common and stability matters.
+    std::vector<uint64_t> randomKeys(const size_t count, const uint32_t seed)
+    {
+        std::mt19937_64                         random(seed);
+        std::uniform_int_distribution<uint64_t> high(0, 7);
+        std::uniform_int_distribution<uint64_t> low(0, 0xFFFF);
+        std::vector<uint64_t>                   keys(count);
+        for (auto& key : keys)
+        {
+            key = high(random) << 56 | (random() & 0x0000'00FF'0000'0000) | low(random);
+        }
+        return keys;
+    }
+
+    void expectMatchesStableSort(const std::vector<uint64_t>& input, ThreadPool* threadPool)
+    {
+        std::vector<uint64_t> keys = input;
+        std::vector<uint32_t> values(keys.size());
+        std::iota(values.begin(), values.end(), 0U);
+        std::vector<uint64_t> scratchKeys(keys.size());
+        std::vector<uint32_t> scratchValues(keys.size());
+        Render::radixSort(keys, values, scratchKeys, scratchValues, threadPool);
+
+        std::vector<std::pair<uint64_t, uint32_t>> expected;
+        for (size_t i = 0; i < input.size(); i++)
+        {
+            expected.emplace_back(input[i], static_cast<uint32_t>(i));
+        }
+        std::ranges::stable_sort(expected, {}, &std::pair<uint64_t, uint32_t>::first);
+
+        ASSERT_EQ(keys.size(), expected.size());
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            ASSERT_EQ(keys[i], expected[i].first) << "item " << i;
+            ASSERT_EQ(values[i], expected[i].second) << "item " << i;
+        }
+    }
+} // namespace
+
+TEST(RenderQueue, SortKeyRoundTrips)
+{
+    const Render::DrawState states[] = {
+        { .pass = 0, .pipeline = 0, .material = 0, .mesh = 0 },
+        { .pass = 3, .pipeline = 17, .material = 1'234, .mesh = 42 },
+        { .pass = Render::g_maxPasses - 1,
+            .pipeline = Render::g_maxPipelines - 1,
+            .material = Render::g_maxMaterials - 1,
+            .mesh = Render::g_maxMeshes - 1 },
+        { .pass = 0, .pipeline = Render::g_maxPipelines - 1, .material = 0, .mesh = 0 },
+        { .pass = 0, .pipeline = 0, .material = Render::g_maxMaterials - 1, .mesh = 0 },
+    };
+    for (const auto& state : states)
+    {
+        for (const bool blended : { false, true })
+        {
+            // Saturated fields and depths do not bleed into their neighbours
+            for (const float depth : { 0.0F, 0.5F, 1.0F })
+            {
+                const Render::SortKey key = Render::makeSortKey(state, depth, blended);
+                expectState(Render::decodeSortKey(key), state);
+                const Render::SortKey other = Render::makeSortKey(state, 0.25F, blended);
+                EXPECT_EQ(Render::stateBits(key), Render::stateBits(other));
+            }
+        }
+    }
+}
+
+TEST(RenderQueue, OutOfRangeFieldsThrow)
+{
+    EXPECT_THROW(static_cast<void>(Render::makeSortKey({ .pass = Render::g_maxPasses }, 0.0F)),
+        std::runtime_error);
+    EXPECT_THROW(
+        static_cast<void>(Render::makeSortKey({ .pipeline = Render::g_maxPipelines }, 0.0F)),
+        std::runtime_error);
+    EXPECT_THROW(
+        static_cast<void>(Render::makeSortKey({ .material = Render::g_maxMaterials }, 0.0F)),
+        std::runtime_error);
+    EXPECT_THROW(static_cast<void>(Render::makeSortKey({ .mesh = Render::g_maxMeshes }, 0.0F)),
+        std::runtime_error);
+}
+
+TEST(RenderQueue, DepthIsClampedAndOrdered)
+{
+    const Render::DrawState state { .pass = 1, .pipeline = 2, .material = 3, .mesh = 4 };
+    EXPECT_EQ(Render::makeSortKey(state, -5.0F), Render::makeSortKey(state, 0.0F));
+    EXPECT_EQ(Render::makeSortKey(state, 5.0F), Render::makeSortKey(state, 1.0F));
+    EXPECT_EQ(Render::makeSortKey(state, 2.0F, true), Render::makeSortKey(state, 1.0F, true));
+
+    // Opaque draws go front to back, blended ones back to front
+    EXPECT_LT(Render::makeSortKey(state, 0.1F), Render::makeSortKey(state, 0.9F));
+    EXPECT_GT(Render::makeSortKey(state, 0.1F, true), Render::makeSortKey(state, 0.9F, true));
+
+    // Opaque state outranks depth, blended depth outranks state
+    const Render::DrawState later { .pass = 1, .pipeline = 3, .material = 0, .mesh = 0 };
+    EXPECT_LT(Render::makeSortKey(state, 1.0F), Render::makeSortKey(later, 0.0F));
+    EXPECT_LT(Render::makeSortKey(later, 0.9F, true), Render::makeSortKey(state, 0.1F, true));
+
+    // Blended draws follow the opaque draws of their pass and precede the next pass
+    const Render::DrawState nextPass { .pass = 2 };
+    EXPECT_LT(Render::makeSortKey(later, 1.0F), Render::makeSortKey(state, 0.0F, true));
+    EXPECT_LT(Render::makeSortKey(state, 0.0F, true), Render::makeSortKey(nextPass, 0.0F));
+}
+
+TEST(RenderQueue, RadixSortMatchesStableSort)
+{
+    expectMatchesStableSort(randomKeys(10'000, 1), nullptr);
+    expectMatchesStableSort(randomKeys(1, 2), nullptr);
+    expectMatchesStableSort({}, nullptr);
+    expectMatchesStableSort(std::vector<uint64_t>(1'000, 0xABCD), nullptr);
+
+    std::mt19937_64       random(3);
+    std::vector<uint64_t> fullRange(5'000);
+    std::ranges::generate(fullRange, random);
+    expectMatchesStableSort(fullRange, nullptr);
+}
+
+TEST(RenderQueue, ParallelRadixSortMatchesStableSort)
+{
+    ThreadPool pool(4);
+    expectMatchesStableSort(randomKeys(200'000, 4), &pool);
+    expectMatchesStableSort(randomKeys(1'000, 5), &pool);
+}
+
+TEST(RenderQueue, RadixSortRejectsMismatchedSpans)
+{
+    std::vector<uint64_t> keys(4);
+    std::vector<uint32_t> values(3);
+    std::vector<uint64_t> scratchKeys(4);
+    std::vector<uint32_t> scratchValues(4);
+    EXPECT_THROW(Render::radixSort(keys, values, scratchKeys, scratchValues), std::runtime_error);
+}
+
+TEST(RenderQueue, BatchesMergeEqualStateAndSplitOnChange)
+{
+    const Render::DrawState first { .pipeline = 1, .material = 1, .mesh = 1 };
+    const Render::DrawState otherMaterial { .pipeline = 1, .material = 2, .mesh = 1 };
+    const Render::DrawState otherPipeline { .pipeline = 2, .material = 1, .mesh = 1 };
+
+    Render::RenderQueue queue;
+    queue.submit(Render::makeSortKey(otherPipeline, 0.5F), 100);
+    queue.submit(Render::makeSortKey(first, 0.3F), 10);
+    queue.submit(Render::makeSortKey(otherMaterial, 0.1F), 20);
+    queue.submit(Render::makeSortKey(first, 0.1F), 11);
+    queue.submit(Render::makeSortKey(otherPipeline, 0.2F), 101);
+    queue.submit(Render::makeSortKey(first, 0.9F), 12);
+
+    const auto batches = queue.build();
+    ASSERT_EQ(batches.size(), 3U);
+
+    // Draws differing only in depth merge, front to back
+    expectState(Render::decodeSortKey(batches[0].key), first);
+    EXPECT_EQ(batches[0].firstInstance, 0U);
+    EXPECT_EQ(batches[0].instanceCount, 3U);
+    expectState(Render::decodeSortKey(batches[1].key), otherMaterial);
+    EXPECT_EQ(batches[1].firstInstance, 3U);
+    EXPECT_EQ(batches[1].instanceCount, 1U);
+    expectState(Render::decodeSortKey(batches[2].key), otherPipeline);
+    EXPECT_EQ(batches[2].firstInstance, 4U);
+    EXPECT_EQ(batches[2].instanceCount, 2U);
+
+    const std::vector<uint32_t> instances(queue.instances().begin(), queue.instances().end());
+    EXPECT_EQ(instances, (std::vector<uint32_t> { 11, 10, 12, 20, 101, 100 }));
+}
+
+TEST(RenderQueue, ParallelBuildMatchesSerialBuild)
+{
+    std::mt19937                            random(6);
+    std::uniform_int_distribution<uint32_t> state(0, 3);
+    std::uniform_real_distribution<float>   depth(0.0F, 1.0F);
+
+    Render::RenderQueue serial;
+    Render::RenderQueue parallel;
+    for (uint32_t i = 0; i < 100'000; i++)
+    {
+        const Render::SortKey key = Render::makeSortKey(
+            { .pipeline = state(random), .material = state(random), .mesh = state(random) },
+            depth(random), i % 7 == 0);
+        serial.submit(key, i);
+        parallel.submit(key, i);
+    }
+
+    ThreadPool pool(4);
+    const auto expected = serial.build();
+    const auto actual = parallel.build(&pool);
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); i++)
+    {
+        EXPECT_EQ(actual[i].key, expected[i].key) << "batch " << i;
+        EXPECT_EQ(actual[i].firstInstance, expected[i].firstInstance) << "batch " << i;
+        EXPECT_EQ(actual[i].instanceCount, expected[i].instanceCount) << "batch " << i;
+    }
+    EXPECT_TRUE(std::ranges::equal(serial.instances(), parallel.instances()));
+
+    // Batches cover every draw once, and every draw of a batch shares its state
+    uint32_t next = 0;
+    for (const auto& batch : actual)
+    {
+        EXPECT_EQ(batch.firstInstance, next);
+        for (uint32_t i = batch.firstInstance; i < batch.firstInstance + batch.instanceCount; i++)
+        {
+            ASSERT_EQ(Render::stateBits(parallel.keys()[i]), Render::stateBits(batch.key));
+        }
+        next += batch.instanceCount;
+    }
+    EXPECT_EQ(next, 100'000U);
+}
+
+TEST(RenderQueue, ClearDropsThePreviousFrame)
+{
+    Render::RenderQueue queue;
+    queue.submit(Render::makeSortKey({ .mesh = 1 }, 0.0F), 1);
+    static_cast<void>(queue.build());
+    queue.clear();
+    EXPECT_EQ(queue.drawCount(), 0U);
+    EXPECT_TRUE(queue.batches().empty());
+    EXPECT_TRUE(queue.build().empty());
+
+    // append hands out spans to fill in place
+    std::span<Render::SortKey> keys;
+    std::span<uint32_t>        instances;
+    queue.append(2, keys, instances);
+    keys[0] = Render::makeSortKey({ .mesh = 2 }, 0.0F);
+    keys[1] = Render::makeSortKey({ .mesh = 1 }, 0.0F);
+    instances[0] = 7;
+    instances[1] = 8;
+    EXPECT_EQ(queue.build().size(), 2U);
+    EXPECT_EQ(queue.instances()[0], 8U);
+}
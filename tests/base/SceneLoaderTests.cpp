@@ -0,0 +1,431 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "GlbWriter.hpp"
+#include "SceneLoader.hpp"
+#include "TemporaryDirectory.hpp"
+#include "ThreadPool.hpp"
+
+using Gltf::ComponentType;
+
+namespace
+{
+    using Float2 = std::array<float, 2>;
+    using Float3 = std::array<float, 3>;
+    using Float4 = std::array<float, 4>;
+
+    Json::Value floats(const std::span<const float> values)
+    {
+        Json::Value array = Json::Value::Array {};
+        for (const float value : values)
+        {
+            array.push(static_cast<double>(value));
+        }
+        return array;
+    }
+
+    /// Flat grid of size x size quads in the xz plane, offset along x by offset.
+    struct Grid
+    {
+        std::vector<Float3>   positions;
+        std::vector<Float3>   normals;
+        std::vector<Float2>   texCoords;
+        std::vector<uint32_t> indices;
+
+        Grid(const uint32_t size, const float offset)
+        {
+            for (uint32_t z = 0; z <= size; z++)
+            {
+                for (uint32_t x = 0; x <= size; x++)
+                {
+                    const float u = static_cast<float>(x) / static_cast<float>(size);
+                    const float v = static_cast<float>(z) / static_cast<float>(size);
+                    positions.push_back({ offset + u, 0.0F, v });
+                    normals.push_back({ 0.0F, 1.0F, 0.0F });
+                    texCoords.push_back({ u, v });
+                }
+            }
+            for (uint32_t z = 0; z < size; z++)
+            {
+                for (uint32_t x = 0; x < size; x++)
+                {
+                    const uint32_t corner = z * (size + 1) + x;
+                    indices.insert(indices.end(), { corner, corner + size + 1, corner + 1 });
+                    indices.insert(indices.end(),
+                        { corner + 1, corner + size + 1, corner + size + 2 });
+                }
+            }
+        }
+    };
+
+    /// Adds the grid as a mesh with one indexed primitive and returns the mesh index.
+    int64_t addGrid(Gltf::GlbWriter& writer, const Grid& grid, const int64_t material = -1)
+    {
+        Json::Value attributes = Json::Value::Object {};
+        attributes.set("POSITION",
+            writer.addAccessor(std::span(grid.positions), ComponentType::Float, "VEC3"));
+        attributes.set("NORMAL",
+            writer.addAccessor(std::span(grid.normals), ComponentType::Float, "VEC3"));
+        attributes.set("TEXCOORD_0",
+            writer.addAccessor(std::span(grid.texCoords), ComponentType::Float, "VEC2"));
+
+        Json::Value primitive = Json::Value::Object {};
+        primitive.set("attributes", std::move(attributes));
+        primitive.set("indices",
+            writer.addAccessor(std::span(grid.indices), ComponentType::UnsignedInt, "SCALAR"));
+        if (material >= 0)
+        {
+            primitive.set("material", material);
+        }
+
+        Json::Value mesh = Json::Value::Object {};
+        mesh.set("name", "Grid");
+        mesh.set("primitives", Json::Value::Array { std::move(primitive) });
+        return writer.add("meshes", std::move(mesh));
+    }
+
+    Assets::Scene load(const Gltf::GlbWriter& writer,
+        const Assets::VertexFormat format = Assets::VertexFormat::Interleaved)
+    {
+        const std::vector<std::byte> glb = writer.build();
+        return Assets::SceneLoader({ .vertexFormat = format }).load(glb, ".");
+    }
+} // namespace
+
+TEST(SceneLoader, DecodesInterleavedVertices)
+{
+    const Grid      grid(2, 1.0F);
+    Gltf::GlbWriter writer;
+    addGrid(writer, grid);
+
+    const Assets::Scene scene = load(writer);
+    ASSERT_EQ(scene.meshes.size(), 1U);
+    EXPECT_EQ(scene.meshes[0].name, "Grid");
+    ASSERT_EQ(scene.meshes[0].primitives.size(), 1U);
+
+    const Assets::Primitive& primitive = scene.meshes[0].primitives[0];
+    EXPECT_EQ(primitive.vertexCount(), grid.positions.size());
+    EXPECT_EQ(primitive.indices, grid.indices);
+    EXPECT_EQ(primitive.material, -1);
+    EXPECT_TRUE(primitive.streams.positions.empty());
+    for (size_t i = 0; i < grid.positions.size(); i++)
+    {
+        EXPECT_EQ(primitive.vertices[i].position, grid.positions[i]);
+        EXPECT_EQ(primitive.vertices[i].normal, grid.normals[i]);
+        EXPECT_EQ(primitive.vertices[i].texCoord, grid.texCoords[i]);
+        // Attributes the file lacks keep their defaults
+        EXPECT_EQ(primitive.vertices[i].color, (Float4 { 1.0F, 1.0F, 1.0F, 1.0F }));
+    }
+    EXPECT_EQ(primitive.boundsMin, (Float3 { 1.0F, 0.0F, 0.0F }));
+    EXPECT_EQ(primitive.boundsMax, (Float3 { 2.0F, 0.0F, 1.0F }));
+}
+
+TEST(SceneLoader, DecodesStreamsWithSkinAttributes)
+{
+    const std::vector<Float3> positions { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 } };
+    const std::vector<Float3> colors { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+    const std::vector<std::array<uint8_t, 4>> joints { { 0, 1, 0, 0 }, { 1, 0, 0, 0 },
+        { 2, 1, 0, 0 } };
+    const std::vector<Float4> weights { { 0.5F, 0.5F, 0, 0 }, { 1, 0, 0, 0 },
+        { 0.25F, 0.75F, 0, 0 } };
+
+    Gltf::GlbWriter writer;
+    Json::Value     attributes = Json::Value::Object {};
+    attributes.set("POSITION",
+        writer.addAccessor(std::span(positions), ComponentType::Float, "VEC3"));
+    attributes.set("COLOR_0", writer.addAccessor(std::span(colors), ComponentType::Float, "VEC3"));
+    attributes.set("JOINTS_0",
+        writer.addAccessor(std::span(joints), ComponentType::UnsignedByte, "VEC4"));
+    attributes.set("WEIGHTS_0",
+        writer.addAccessor(std::span(weights), ComponentType::Float, "VEC4"));
+    Json::Value primitive = Json::Value::Object {};
+    primitive.set("attributes", std::move(attributes));
+    Json::Value mesh = Json::Value::Object {};
+    mesh.set("primitives", Json::Value::Array { std::move(primitive) });
+    writer.add("meshes", std::move(mesh));
+
+    const Assets::Scene      scene = load(writer, Assets::VertexFormat::Streams);
+    const Assets::Primitive& decoded = scene.meshes[0].primitives[0];
+    EXPECT_TRUE(decoded.vertices.empty());
+    EXPECT_EQ(decoded.streams.positions, positions);
+    EXPECT_TRUE(decoded.streams.normals.empty());
+    // Non-indexed primitives get sequential indices
+    EXPECT_EQ(decoded.indices, (std::vector<uint32_t> { 0, 1, 2 }));
+
+    // RGB colors are widened with an opaque alpha
+    ASSERT_EQ(decoded.streams.colors.size(), 3U);
+    EXPECT_EQ(decoded.streams.colors[2], (Float4 { 0, 0, 1, 1 }));
+    ASSERT_EQ(decoded.streams.joints.size(), 3U);
+    EXPECT_EQ(decoded.streams.joints[2], (std::array<uint16_t, 4> { 2, 1, 0, 0 }));
+    EXPECT_EQ(decoded.streams.weights, weights);
+}
+
+TEST(SceneLoader, ConvertsStripsAndFansToLists)
+{
+    const std::vector<Float3> positions { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 },
+        { 0, 2, 0 } };
+    const std::vector<uint16_t> indices { 0, 1, 2, 3, 4 };
+
+    Gltf::GlbWriter writer;
+    const int64_t   position
+        = writer.addAccessor(std::span(positions), ComponentType::Float, "VEC3");
+    const int64_t index
+        = writer.addAccessor(std::span(indices), ComponentType::UnsignedShort, "SCALAR");
+    Json::Value primitives = Json::Value::Array {};
+    for (const int64_t mode : { 5, 6, 0 })
+    {
+        Json::Value attributes = Json::Value::Object {};
+        attributes.set("POSITION", position);
+        Json::Value primitive = Json::Value::Object {};
+        primitive.set("attributes", std::move(attributes));
+        primitive.set("indices", index);
+        primitive.set("mode", mode);
+        primitives.push(std::move(primitive));
+    }
+    Json::Value mesh = Json::Value::Object {};
+    mesh.set("primitives", std::move(primitives));
+    writer.add("meshes", std::move(mesh));
+
+    const Assets::Scene scene = load(writer);
+    // The points primitive is skipped
+    ASSERT_EQ(scene.meshes[0].primitives.size(), 2U);
+    EXPECT_EQ(scene.meshes[0].primitives[0].indices,
+        (std::vector<uint32_t> { 0, 1, 2, 2, 1, 3, 2, 3, 4 }));
+    EXPECT_EQ(scene.meshes[0].primitives[1].indices,
+        (std::vector<uint32_t> { 0, 1, 2, 0, 2, 3, 0, 3, 4 }));
+}
+
+TEST(SceneLoader, LoadsNodeHierarchy)
+{
+    Gltf::GlbWriter writer;
+    const int64_t   mesh = addGrid(writer, Grid(1, 0.0F));
+
+    Json::Value root = Json::Value::Object {};
+    root.set("name", "Root");
+    root.set("children", Json::Value::Array { int64_t { 1 }, int64_t { 2 } });
+    root.set("translation", floats(std::array { 1.0F, 2.0F, 3.0F }));
+    writer.add("nodes", std::move(root));
+
+    Json::Value child = Json::Value::Object {};
+    child.set("name", "Child");
+    child.set("mesh", mesh);
+    child.set("scale", floats(std::array { 2.0F, 2.0F, 2.0F }));
+    writer.add("nodes", std::move(child));
+
+    // Column-major translation by (4, 5, 6), which is row-major with row vectors
+    Json::Value matrix = Json::Value::Object {};
+    matrix.set("name", "Matrix");
+    matrix.set("matrix", floats(std::array { 1.0F, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F, 0.0F, 0.0F, 0.0F,
+                             0.0F, 1.0F, 0.0F, 4.0F, 5.0F, 6.0F, 1.0F }));
+    writer.add("nodes", std::move(matrix));
+
+    Json::Value scene = Json::Value::Object {};
+    scene.set("nodes", Json::Value::Array { int64_t { 0 } });
+    writer.add("scenes", std::move(scene));
+    writer.set("scene", int64_t { 0 });
+
+    const Assets::Scene loaded = load(writer);
+    ASSERT_EQ(loaded.nodes.size(), 3U);
+    EXPECT_EQ(loaded.rootNodes, (std::vector<int32_t> { 0 }));
+
+    const Assets::Node& parent = loaded.nodes[0];
+    EXPECT_EQ(parent.name, "Root");
+    EXPECT_EQ(parent.parent, -1);
+    EXPECT_EQ(parent.children, (std::vector<int32_t> { 1, 2 }));
+    EXPECT_EQ(parent.mesh, -1);
+    EXPECT_EQ(parent.translation, (Float3 { 1.0F, 2.0F, 3.0F }));
+    EXPECT_EQ(parent.localTransform[12], 1.0F);
+    EXPECT_EQ(parent.localTransform[14], 3.0F);
+
+    EXPECT_EQ(loaded.nodes[1].parent, 0);
+    EXPECT_EQ(loaded.nodes[1].mesh, mesh);
+    EXPECT_EQ(loaded.nodes[1].localTransform[0], 2.0F);
+    EXPECT_EQ(loaded.nodes[1].localTransform[15], 1.0F);
+
+    // Matrix nodes keep the identity TRS
+    const Assets::Node& matrixNode = loaded.nodes[2];
+    EXPECT_EQ(matrixNode.translation, (Float3 {}));
+    EXPECT_EQ(matrixNode.localTransform[12], 4.0F);
+    EXPECT_EQ(matrixNode.localTransform[13], 5.0F);
+    EXPECT_EQ(matrixNode.localTransform[14], 6.0F);
+}
+
+TEST(SceneLoader, LoadsMaterialsAndEmbeddedImages)
+{
+    Gltf::GlbWriter writer;
+
+    const std::array<std::byte, 4> png { std::byte { 0x89 }, std::byte { 'P' }, std::byte { 'N' },
+        std::byte { 'G' } };
+    Json::Value image = Json::Value::Object {};
+    image.set("name", "Albedo");
+    image.set("bufferView", writer.addBufferView(png));
+    image.set("mimeType", "image/png");
+    const int64_t imageIndex = writer.add("images", std::move(image));
+
+    Json::Value texture = Json::Value::Object {};
+    texture.set("source", imageIndex);
+    const int64_t textureIndex = writer.add("textures", std::move(texture));
+
+    Json::Value textureInfo = Json::Value::Object {};
+    textureInfo.set("index", textureIndex);
+    Json::Value pbr = Json::Value::Object {};
+    pbr.set("baseColorFactor", floats(std::array { 0.5F, 0.25F, 1.0F, 0.75F }));
+    pbr.set("baseColorTexture", std::move(textureInfo));
+    pbr.set("metallicFactor", 0.0);
+    pbr.set("roughnessFactor", 0.5);
+    Json::Value material = Json::Value::Object {};
+    material.set("name", "Painted");
+    material.set("pbrMetallicRoughness", std::move(pbr));
+    material.set("alphaMode", "MASK");
+    material.set("alphaCutoff", 0.25);
+    material.set("doubleSided", true);
+    const int64_t materialIndex = writer.add("materials", std::move(material));
+
+    addGrid(writer, Grid(1, 0.0F), materialIndex);
+
+    const Assets::Scene scene = load(writer);
+    ASSERT_EQ(scene.images.size(), 1U);
+    EXPECT_EQ(scene.images[0].name, "Albedo");
+    EXPECT_EQ(scene.images[0].mimeType, "image/png");
+    EXPECT_TRUE(scene.images[0].path.empty());
+    EXPECT_EQ(scene.images[0].data, std::vector<std::byte>(png.begin(), png.end()));
+
+    ASSERT_EQ(scene.materials.size(), 1U);
+    const Assets::Material& loaded = scene.materials[0];
+    EXPECT_EQ(loaded.name, "Painted");
+    EXPECT_EQ(loaded.baseColorFactor, (Float4 { 0.5F, 0.25F, 1.0F, 0.75F }));
+    EXPECT_EQ(loaded.metallicFactor, 0.0F);
+    EXPECT_EQ(loaded.roughnessFactor, 0.5F);
+    EXPECT_EQ(loaded.alphaMode, Assets::AlphaMode::Mask);
+    EXPECT_EQ(loaded.alphaCutoff, 0.25F);
+    EXPECT_TRUE(loaded.doubleSided);
+    EXPECT_EQ(loaded.baseColorTexture, 0);
+    EXPECT_EQ(loaded.normalTexture, -1);
+    EXPECT_EQ(scene.meshes[0].primitives[0].material, 0);
+}
+
+TEST(SceneLoader, LoadsSkinsAndAnimations)
+{
+    Gltf::GlbWriter writer;
+    for (int i = 0; i < 2; i++)
+    {
+        Json::Value joint = Json::Value::Object {};
+        if (i == 0)
+        {
+            joint.set("children", Json::Value::Array { int64_t { 1 } });
+        }
+        writer.add("nodes", std::move(joint));
+    }
+
+    std::vector<std::array<float, 16>> inverseBind(2, std::array<float, 16> {});
+    for (auto& matrix : inverseBind)
+    {
+        matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0F;
+    }
+    inverseBind[1][13] = -1.0F;
+    Json::Value skin = Json::Value::Object {};
+    skin.set("joints", Json::Value::Array { int64_t { 0 }, int64_t { 1 } });
+    skin.set("skeleton", int64_t { 0 });
+    skin.set("inverseBindMatrices",
+        writer.addAccessor(std::span(inverseBind), ComponentType::Float, "MAT4"));
+    writer.add("skins", std::move(skin));
+
+    const std::vector<float>  times { 0.0F, 0.5F, 2.0F };
+    const std::vector<Float4> rotations { { 0, 0, 0, 1 }, { 0, 0.7071068F, 0, 0.7071068F },
+        { 0, 1, 0, 0 } };
+    Json::Value sampler = Json::Value::Object {};
+    sampler.set("input", writer.addAccessor(std::span(times), ComponentType::Float, "SCALAR"));
+    sampler.set("output", writer.addAccessor(std::span(rotations), ComponentType::Float, "VEC4"));
+    sampler.set("interpolation", "STEP");
+    Json::Value target = Json::Value::Object {};
+    target.set("node", int64_t { 1 });
+    target.set("path", "rotation");
+    Json::Value channel = Json::Value::Object {};
+    channel.set("sampler", int64_t { 0 });
+    channel.set("target", std::move(target));
+    Json::Value animation = Json::Value::Object {};
+    animation.set("name", "Turn");
+    animation.set("samplers", Json::Value::Array { std::move(sampler) });
+    animation.set("channels", Json::Value::Array { std::move(channel) });
+    writer.add("animations", std::move(animation));
+
+    const Assets::Scene scene = load(writer);
+    ASSERT_EQ(scene.skins.size(), 1U);
+    EXPECT_EQ(scene.skins[0].joints, (std::vector<int32_t> { 0, 1 }));
+    EXPECT_EQ(scene.skins[0].skeleton, 0);
+    EXPECT_EQ(scene.skins[0].inverseBindMatrices, inverseBind);
+
+    ASSERT_EQ(scene.animations.size(), 1U);
+    const Assets::Animation& loaded = scene.animations[0];
+    EXPECT_EQ(loaded.name, "Turn");
+    EXPECT_EQ(loaded.duration, 2.0F);
+    ASSERT_EQ(loaded.channels.size(), 1U);
+    EXPECT_EQ(loaded.channels[0].node, 1);
+    EXPECT_EQ(loaded.channels[0].path, Assets::AnimationPath::Rotation);
+    EXPECT_EQ(loaded.channels[0].interpolation, Assets::AnimationInterpolation::Step);
+    EXPECT_EQ(loaded.channels[0].times, times);
+    ASSERT_EQ(loaded.channels[0].values.size(), 12U);
+    EXPECT_EQ(loaded.channels[0].values[5], 0.7071068F);
+
+    // Without a scene every parentless node is a root
+    EXPECT_EQ(scene.rootNodes, (std::vector<int32_t> { 0 }));
+}
+
+TEST(SceneLoader, ParallelDecodingMatchesSerial)
+{
+    TemporaryDirectory directory;
+    Gltf::GlbWriter    writer;
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        addGrid(writer, Grid(4 + i % 5, static_cast<float>(i)));
+    }
+    const auto path = directory.path() / "grids.glb";
+    writer.write(path);
+
+    ThreadPool          serialPool(1);
+    ThreadPool          parallelPool(4);
+    const Assets::Scene serial = Assets::SceneLoader({ .threadPool = &serialPool }).load(path);
+    const Assets::Scene parallel = Assets::SceneLoader({ .threadPool = &parallelPool }).load(path);
+
+    ASSERT_EQ(serial.meshes.size(), 32U);
+    ASSERT_EQ(parallel.meshes.size(), 32U);
+    for (size_t i = 0; i < serial.meshes.size(); i++)
+    {
+        const auto& expected = serial.meshes[i].primitives[0];
+        const auto& actual = parallel.meshes[i].primitives[0];
+        EXPECT_EQ(actual.indices, expected.indices);
+        ASSERT_EQ(actual.vertices.size(), expected.vertices.size());
+        for (size_t v = 0; v < expected.vertices.size(); v++)
+        {
+            EXPECT_EQ(actual.vertices[v].position, expected.vertices[v].position);
+        }
+        EXPECT_EQ(actual.boundsMin[0], static_cast<float>(i));
+    }
+}
+
+TEST(SceneLoader, RejectsInvalidFiles)
+{
+    const Assets::SceneLoader loader;
+    const std::string         text = "not a glTF file";
+    EXPECT_THROW(static_cast<void>(loader.load(std::as_bytes(std::span(text)), ".")),
+        std::runtime_error);
+
+    // An index past the end of the vertices fails validation
+    Gltf::GlbWriter writer;
+    Grid            grid(1, 0.0F);
+    grid.indices.back() = 100;
+    addGrid(writer, grid);
+    EXPECT_THROW(static_cast<void>(load(writer)), std::runtime_error);
+
+    EXPECT_THROW(static_cast<void>(loader.load("missing.glb")), std::runtime_error);
+}
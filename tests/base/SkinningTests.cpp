@@ -0,0 +1,333 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "Animation.hpp"
+#include "Skinning.hpp"
+#include "TestCharacters.hpp"
+#include "ThreadPool.hpp"
+
+namespace
+{
+    using Float3 = std::array<float, 3>;
+    using Animation::SkinningMethod;
+
+    constexpr std::array g_methods { SkinningMethod::LinearBlend, SkinningMethod::DualQuaternion };
+
+    /// Influences of a mesh, vertex by vertex, as glTF stores them.
+    struct Geometry
+    {
+        std::vector<Float3>   positions;
+        std::vector<Float3>   normals;
+        std::vector<uint16_t> joints;
+        std::vector<float>    weights;
+
+        void add(const Float3& position, const Float3& normal,
+            const std::array<uint16_t, 4>& vertexJoints, const std::array<float, 4>& vertexWeights)
+        {
+            positions.push_back(position);
+            normals.push_back(normal);
+            joints.insert(joints.end(), vertexJoints.begin(), vertexJoints.end());
+            weights.insert(weights.end(), vertexWeights.begin(), vertexWeights.end());
+        }
+
+        [[nodiscard]] Animation::SkinnedMesh mesh() const
+        {
+            return { positions, normals, joints, weights, 4 };
+        }
+    };
+
+    /// Rings of vertices around the joints of Tests::createCharacter, each blending
+    /// its joint with the parent by a different weight; every third ring follows
+    /// its joint alone.
+    Geometry characterGeometry(const Assets::Scene& character)
+    {
+        Geometry geometry;
+        for (size_t joint = 1; joint < character.nodes.size(); joint++)
+        {
+            const auto&  inverseBind = character.skins[0].inverseBindMatrices[joint];
+            const Float3 bind { -inverseBind[12], -inverseBind[13], -inverseBind[14] };
+            const auto   parent = static_cast<uint16_t>(character.nodes[joint].parent);
+            const float  weight
+                = joint % 3 == 0 ? 1.0F : 0.5F + 0.1F * static_cast<float>(joint % 5);
+            for (int i = 0; i < 6; i++)
+            {
+                const float  angle = std::numbers::pi_v<float> * static_cast<float>(i) / 3.0F;
+                const Float3 normal { 0.0F, std::cos(angle), std::sin(angle) };
+                geometry.add({ bind[0], bind[1] + 0.02F * normal[1], 0.02F * normal[2] }, normal,
+                    { static_cast<uint16_t>(joint), parent, 0, 0 },
+                    { weight, 1.0F - weight, 0.0F, 0.0F });
+            }
+        }
+        return geometry;
+    }
+
+    /// Skinning matrices of the character posed at a time.
+    std::vector<Assets::Matrix4> posedSkinning(const Assets::Scene& character, const float time)
+    {
+        const auto skeleton = Animation::buildSkeleton(character, 0);
+        const auto clip = Animation::Clip::compress(character.animations.front(), skeleton);
+
+        Animation::ClipSampler sampler;
+        Animation::Pose        pose;
+        sampler.sample(clip, time, pose);
+        std::vector<Assets::Matrix4> model(skeleton.jointCount());
+        std::vector<Assets::Matrix4> skinning(skeleton.skinJoints.size());
+        Animation::computeModelTransforms(skeleton, pose, model);
+        Animation::computeSkinningMatrices(skeleton, model, skinning);
+        return skinning;
+    }
+
+    /// Rotation by angle about an axis through the origin, as a row vector matrix.
+    Assets::Matrix4 rotation(const Float3& axis, const float angle)
+    {
+        const float c = std::cos(angle);
+        const float s = std::sin(angle);
+        const float t = 1.0F - c;
+        const auto& [x, y, z] = axis;
+        return { t * x * x + c, t * x * y + s * z, t * x * z - s * y, 0.0F, t * x * y - s * z,
+            t * y * y + c, t * y * z + s * x, 0.0F, t * x * z + s * y, t * y * z - s * x,
+            t * z * z + c, 0.0F, 0.0F, 0.0F, 0.0F, 1.0F };
+    }
+
+    Float3 transformPoint(const Assets::Matrix4& m, const Float3& p)
+    {
+        return { p[0] * m[0] + p[1] * m[4] + p[2] * m[8] + m[12],
+            p[0] * m[1] + p[1] * m[5] + p[2] * m[9] + m[13],
+            p[0] * m[2] + p[1] * m[6] + p[2] * m[10] + m[14] };
+    }
+
+    float distance(const Float3& a, const Float3& b)
+    {
+        return std::hypot(a[0] - b[0], a[1] - b[1], a[2] - b[2]);
+    }
+
+    struct Skinned
+    {
+        std::vector<Float3> positions;
+        std::vector<Float3> normals;
+    };
+
+    Skinned skin(const Animation::SkinnedMesh& mesh, const SkinningMethod method,
+        const std::vector<Assets::Matrix4>& skinning)
+    {
+        Skinned result { std::vector<Float3>(mesh.vertexCount()),
+            std::vector<Float3>(mesh.vertexCount()) };
+        Animation::skinVertices(
+            mesh, method, skinning, result.positions, result.normals, 0, mesh.vertexCount());
+        return result;
+    }
+} // namespace
+
+TEST(Skinning, StoresInfluencesInfluenceByInfluence)
+{
+    Geometry geometry;
+    geometry.add({ 1.0F, 0.0F, 0.0F }, { 0.0F, 1.0F, 0.0F }, { 2, 5, 0, 0 },
+        { 3.0F, 1.0F, 0.0F, 0.0F });
+    geometry.add({ 2.0F, 0.0F, 0.0F }, { 0.0F, 1.0F, 0.0F }, { 1, 0, 0, 0 },
+        { 0.0F, 0.0F, 0.0F, 0.0F });
+    const auto mesh = geometry.mesh();
+
+    EXPECT_EQ(mesh.vertexCount(), 2U);
+    EXPECT_EQ(mesh.influencesPerVertex(), 4U);
+    EXPECT_EQ(mesh.jointCount(), 6U);
+    EXPECT_TRUE(mesh.hasNormals());
+    EXPECT_EQ(mesh.position(0)[1], 2.0F);
+    EXPECT_EQ(mesh.joints(0)[0], 2U);
+    EXPECT_EQ(mesh.joints(1)[0], 5U);
+    EXPECT_EQ(mesh.joints(0)[1], 1U);
+
+    // Normalized, and a vertex without weights follows its first joint
+    EXPECT_FLOAT_EQ(mesh.weights(0)[0], 0.75F);
+    EXPECT_FLOAT_EQ(mesh.weights(1)[0], 0.25F);
+    EXPECT_EQ(mesh.weights(0)[1], 1.0F);
+    EXPECT_EQ(mesh.weights(1)[1], 0.0F);
+}
+
+TEST(Skinning, RejectsInconsistentInfluences)
+{
+    const std::vector<Float3>   positions(2);
+    const std::vector<uint16_t> joints(8);
+    const std::vector<float>    weights(8);
+    EXPECT_THROW(Animation::SkinnedMesh(positions, {}, joints, weights, 2), std::runtime_error);
+    EXPECT_THROW(Animation::SkinnedMesh(positions, {}, joints, weights, 8), std::runtime_error);
+    EXPECT_THROW(Animation::SkinnedMesh(positions, std::vector<Float3>(1), joints, weights, 4),
+        std::runtime_error);
+    EXPECT_NO_THROW(Animation::SkinnedMesh(positions, {}, joints, weights, 4));
+
+    Assets::VertexStreams streams;
+    streams.positions = positions;
+    EXPECT_THROW(Animation::SkinnedMesh { streams }, std::runtime_error);
+}
+
+TEST(Skinning, IdentityLeavesTheBindPose)
+{
+    const auto                         character = Tests::createCharacter(4, 5);
+    const auto                         geometry = characterGeometry(character);
+    const auto                         mesh = geometry.mesh();
+    const std::vector<Assets::Matrix4> identity(mesh.jointCount(), Tests::translationMatrix({}));
+
+    for (const auto method : g_methods)
+    {
+        const Skinned skinned = skin(mesh, method, identity);
+        for (size_t vertex = 0; vertex < mesh.vertexCount(); vertex++)
+        {
+            ASSERT_LT(distance(skinned.positions[vertex], geometry.positions[vertex]), 1.0e-6F);
+            ASSERT_LT(distance(skinned.normals[vertex], geometry.normals[vertex]), 1.0e-6F);
+        }
+    }
+}
+
+TEST(Skinning, MethodsAgreeOnRigidVertices)
+{
+    // Without the pulsing limb tips, as dual quaternions drop scale
+    auto  character = Tests::createCharacter(4, 5);
+    auto& channels = character.animations.front().channels;
+    std::erase_if(channels, [](const Assets::AnimationChannel& channel) {
+        return channel.path == Assets::AnimationPath::Scale;
+    });
+    const auto geometry = characterGeometry(character);
+    const auto mesh = geometry.mesh();
+    const auto skinning = posedSkinning(character, 0.3F);
+
+    const Skinned linear = skin(mesh, SkinningMethod::LinearBlend, skinning);
+    const Skinned dual = skin(mesh, SkinningMethod::DualQuaternion, skinning);
+    float         rigidDifference = 0.0F;
+    float         blendedDifference = 0.0F;
+    for (size_t vertex = 0; vertex < mesh.vertexCount(); vertex++)
+    {
+        const float difference = distance(linear.positions[vertex], dual.positions[vertex]);
+        if (mesh.weights(0)[vertex] == 1.0F)
+        {
+            // Exactly the joint's transform either way
+            const auto expected
+                = transformPoint(skinning[mesh.joints(0)[vertex]], geometry.positions[vertex]);
+            EXPECT_LT(distance(linear.positions[vertex], expected), 1.0e-6F);
+            rigidDifference = std::max(rigidDifference, difference);
+            EXPECT_LT(distance(linear.normals[vertex], dual.normals[vertex]), 1.0e-5F);
+        }
+        else
+        {
+            blendedDifference = std::max(blendedDifference, difference);
+        }
+        EXPECT_NEAR(std::hypot(dual.normals[vertex][0], dual.normals[vertex][1],
+                        dual.normals[vertex][2]),
+            1.0F, 1.0e-5F);
+    }
+    EXPECT_LT(rigidDifference, 1.0e-5F);
+
+    // Blends of small bends differ by a fraction of the ring radius
+    EXPECT_GT(blendedDifference, 0.0F);
+    EXPECT_LT(blendedDifference, 0.002F);
+}
+
+TEST(Skinning, DualQuaternionsKeepVolumeUnderTwist)
+{
+    // Two joints along x, the second twisted half a turn about the bone
+    Geometry geometry;
+    geometry.add({ 0.5F, 0.1F, 0.0F }, { 0.0F, 1.0F, 0.0F }, { 0, 1, 0, 0 },
+        { 0.5F, 0.5F, 0.0F, 0.0F });
+    const auto                         mesh = geometry.mesh();
+    const std::vector<Assets::Matrix4> skinning { Tests::translationMatrix({}),
+        rotation({ 1.0F, 0.0F, 0.0F }, std::numbers::pi_v<float>) };
+
+    // Linear blending collapses the vertex onto the bone, the candy wrapper
+    const Skinned linear = skin(mesh, SkinningMethod::LinearBlend, skinning);
+    EXPECT_LT(std::hypot(linear.positions[0][1], linear.positions[0][2]), 1.0e-5F);
+
+    // Dual quaternions turn it a quarter instead, keeping its distance
+    const Skinned dual = skin(mesh, SkinningMethod::DualQuaternion, skinning);
+    EXPECT_NEAR(dual.positions[0][0], 0.5F, 1.0e-5F);
+    EXPECT_NEAR(std::hypot(dual.positions[0][1], dual.positions[0][2]), 0.1F, 1.0e-5F);
+    EXPECT_NEAR(std::abs(dual.positions[0][2]), 0.1F, 1.0e-5F);
+}
+
+TEST(Skinning, DualQuaternionsIgnoreScale)
+{
+    Geometry geometry;
+    geometry.add({ 1.0F, 2.0F, 3.0F }, { 0.0F, 0.0F, 1.0F }, { 0, 0, 0, 0 },
+        { 1.0F, 0.0F, 0.0F, 0.0F });
+    const auto      mesh = geometry.mesh();
+    Assets::Matrix4 scaled = Tests::translationMatrix({ 1.0F, 0.0F, 0.0F });
+    scaled[0] = scaled[5] = scaled[10] = 2.0F;
+
+    const Skinned linear = skin(mesh, SkinningMethod::LinearBlend, { scaled });
+    const Skinned dual = skin(mesh, SkinningMethod::DualQuaternion, { scaled });
+    EXPECT_LT(distance(linear.positions[0], { 3.0F, 4.0F, 6.0F }), 1.0e-6F);
+    EXPECT_LT(distance(dual.positions[0], { 2.0F, 2.0F, 3.0F }), 1.0e-6F);
+    EXPECT_LT(distance(linear.normals[0], { 0.0F, 0.0F, 1.0F }), 1.0e-6F);
+}
+
+TEST(Skinning, EightInfluencesMatchFour)
+{
+    const auto character = Tests::createCharacter(3, 4);
+    const auto geometry = characterGeometry(character);
+    const auto skinning = posedSkinning(character, 0.7F);
+
+    // Every influence split over two slots of half the weight
+    std::vector<uint16_t> joints;
+    std::vector<float>    weights;
+    for (size_t i = 0; i < geometry.joints.size(); i++)
+    {
+        joints.insert(joints.end(), { geometry.joints[i], geometry.joints[i] });
+        weights.insert(weights.end(), { geometry.weights[i] * 0.5F, geometry.weights[i] * 0.5F });
+    }
+    const Animation::SkinnedMesh eight(geometry.positions, geometry.normals, joints, weights, 8);
+    ASSERT_EQ(eight.influencesPerVertex(), 8U);
+
+    for (const auto method : g_methods)
+    {
+        const Skinned expected = skin(geometry.mesh(), method, skinning);
+        const Skinned actual = skin(eight, method, skinning);
+        for (size_t vertex = 0; vertex < eight.vertexCount(); vertex++)
+        {
+            ASSERT_LT(distance(actual.positions[vertex], expected.positions[vertex]), 1.0e-5F);
+            ASSERT_LT(distance(actual.normals[vertex], expected.normals[vertex]), 1.0e-5F);
+        }
+    }
+}
+
+TEST(Skinning, ParallelSkinningMatchesOneThread)
+{
+    // Enough vertices for several chunks, in a buffer with room on either side
+    const auto character = Tests::createCharacter(6, 8);
+    Geometry   geometry;
+    const auto rings = characterGeometry(character);
+    while (geometry.positions.size() < 20'000)
+    {
+        for (size_t vertex = 0; vertex < rings.positions.size(); vertex++)
+        {
+            geometry.add(rings.positions[vertex], rings.normals[vertex],
+                { rings.joints[vertex * 4], rings.joints[vertex * 4 + 1], 0, 0 },
+                { rings.weights[vertex * 4], rings.weights[vertex * 4 + 1], 0.0F, 0.0F });
+        }
+    }
+    const auto mesh = geometry.mesh();
+    const auto skinning = posedSkinning(character, 0.45F);
+
+    ThreadPool threadPool(4);
+    for (const auto method : g_methods)
+    {
+        const Skinned       expected = skin(mesh, method, skinning);
+        std::vector<Float3> positions(mesh.vertexCount());
+        std::vector<Float3> normals(mesh.vertexCount());
+        Animation::skinVertices(mesh, method, skinning, positions, normals, threadPool);
+        EXPECT_EQ(positions, expected.positions);
+        EXPECT_EQ(normals, expected.normals);
+
+        // A range writes only its own vertices, and normals may be skipped
+        std::vector<Float3> range(mesh.vertexCount(), { -1.0F, -1.0F, -1.0F });
+        Animation::skinVertices(mesh, method, skinning, range, {}, 100, 50);
+        EXPECT_EQ(range[99], (Float3 { -1.0F, -1.0F, -1.0F }));
+        EXPECT_EQ(range[100], expected.positions[100]);
+        EXPECT_EQ(range[149], expected.positions[149]);
+        EXPECT_EQ(range[150], (Float3 { -1.0F, -1.0F, -1.0F }));
+    }
+}
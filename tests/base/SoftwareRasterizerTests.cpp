@@ -0,0 +1,251 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SoftwareRasterizer.hpp"
+#include "ThreadPool.hpp"
+
+namespace
+{
+    constexpr Raster::Matrix4 g_identity { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+    constexpr std::array<float, 4> g_red { 1.0F, 0.0F, 0.0F, 1.0F };
+    constexpr std::array<float, 4> g_green { 0.0F, 1.0F, 0.0F, 1.0F };
+    constexpr std::array<float, 4> g_black { 0.0F, 0.0F, 0.0F, 1.0F };
+
+    /// Counter-clockwise quad covering the viewport at a depth.
+    std::vector<Raster::Vertex> quad(float depth, const std::array<float, 4>& color)
+    {
+        return {
+            { { -1.0F, -1.0F, depth, 1.0F }, color, { 0.0F, 1.0F } },
+            { { 1.0F, -1.0F, depth, 1.0F }, color, { 1.0F, 1.0F } },
+            { { 1.0F, 1.0F, depth, 1.0F }, color, { 1.0F, 0.0F } },
+            { { -1.0F, 1.0F, depth, 1.0F }, color, { 0.0F, 0.0F } },
+        };
+    }
+
+    constexpr std::array<uint16_t, 6> g_quadIndices { 0, 1, 2, 0, 2, 3 };
+
+    std::array<uint8_t, 4> pixel(const Raster::Image& image, uint32_t x, uint32_t y)
+    {
+        const size_t offset = (static_cast<size_t>(y) * image.width + x) * 4;
+        return { image.pixels[offset], image.pixels[offset + 1], image.pixels[offset + 2],
+            image.pixels[offset + 3] };
+    }
+
+    Raster::DrawCommand drawQuad(const std::vector<Raster::Vertex>& vertices)
+    {
+        Raster::DrawCommand command;
+        command.vertices = vertices;
+        command.indices16 = g_quadIndices;
+        command.instanceTransforms = { &g_identity, 1 };
+        return command;
+    }
+
+    /// Random overlapping triangles with depth testing and blending, for comparing
+    /// renders across thread counts.
+    Raster::Image renderScene(uint32_t threadCount)
+    {
+        std::mt19937                          random(3);
+        std::uniform_real_distribution<float> position(-1.2F, 1.2F);
+        std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+
+        std::vector<Raster::Vertex> vertices;
+        for (size_t i = 0; i < 3000; i++)
+        {
+            vertices.push_back({ { position(random), position(random), unit(random), 1.0F },
+                { unit(random), unit(random), unit(random), unit(random) }, {} });
+        }
+        std::vector<uint32_t> indices(vertices.size());
+        for (uint32_t i = 0; i < indices.size(); i++)
+        {
+            indices[i] = i;
+        }
+
+        ThreadPool         threadPool(threadCount);
+        Raster::Rasterizer rasterizer(threadPool);
+        rasterizer.resize(300, 200);
+        rasterizer.clear(g_black);
+
+        Raster::DrawCommand opaque;
+        opaque.vertices = vertices;
+        opaque.indices32 = std::span(indices).first(1500);
+        opaque.instanceTransforms = { &g_identity, 1 };
+        rasterizer.draw(opaque);
+
+        Raster::DrawCommand blended = opaque;
+        blended.indices32 = std::span(indices).subspan(1500);
+        blended.blendEnabled = true;
+        blended.depthWriteEnabled = false;
+        rasterizer.draw(blended);
+
+        Raster::Image image;
+        rasterizer.resolve(image);
+        return image;
+    }
+} // namespace
+
+TEST(SoftwareRasterizer, ClearFillsEveryPixel)
+{
+    ThreadPool         threadPool(1);
+    Raster::Rasterizer rasterizer(threadPool);
+    rasterizer.resize(70, 70);
+    rasterizer.clear(g_red);
+
+    Raster::Image image;
+    rasterizer.resolve(image);
+    ASSERT_EQ(image.pixels.size(), 70U * 70U * 4U);
+    for (uint32_t y = 0; y < image.height; y++)
+    {
+        for (uint32_t x = 0; x < image.width; x++)
+        {
+            ASSERT_EQ(pixel(image, x, y), (std::array<uint8_t, 4> { 255, 0, 0, 255 }));
+        }
+    }
+}
+
+TEST(SoftwareRasterizer, DepthTestKeepsNearestSurface)
+{
+    ThreadPool         threadPool(2);
+    Raster::Rasterizer rasterizer(threadPool);
+    rasterizer.resize(130, 90);
+
+    const auto near = quad(0.25F, g_red);
+    const auto far = quad(0.75F, g_green);
+    for (const bool nearFirst : { true, false })
+    {
+        rasterizer.clear(g_black);
+        rasterizer.draw(drawQuad(nearFirst ? near : far));
+        rasterizer.draw(drawQuad(nearFirst ? far : near));
+
+        Raster::Image image;
+        rasterizer.resolve(image);
+        EXPECT_EQ(pixel(image, 0, 0), (std::array<uint8_t, 4> { 255, 0, 0, 255 }));
+        EXPECT_EQ(pixel(image, 64, 45), (std::array<uint8_t, 4> { 255, 0, 0, 255 }));
+        EXPECT_EQ(pixel(image, 129, 89), (std::array<uint8_t, 4> { 255, 0, 0, 255 }));
+    }
+}
+
+TEST(SoftwareRasterizer, BackFacesAreCulled)
+{
+    ThreadPool         threadPool(1);
+    Raster::Rasterizer rasterizer(threadPool);
+    rasterizer.resize(16, 16);
+
+    const auto                        vertices = quad(0.5F, g_red);
+    constexpr std::array<uint16_t, 6> clockwise { 0, 2, 1, 0, 3, 2 };
+    auto                              command = drawQuad(vertices);
+    command.indices16 = clockwise;
+    command.cullMode = Raster::CullMode::Back;
+
+    rasterizer.clear(g_black);
+    rasterizer.draw(command);
+    Raster::Image image;
+    rasterizer.resolve(image);
+    EXPECT_EQ(pixel(image, 8, 8), (std::array<uint8_t, 4> { 0, 0, 0, 255 }));
+    EXPECT_EQ(rasterizer.statistics().trianglesRasterized, 0U);
+
+    command.cullMode = Raster::CullMode::Front;
+    rasterizer.clear(g_black);
+    rasterizer.draw(command);
+    rasterizer.resolve(image);
+    EXPECT_EQ(pixel(image, 8, 8), (std::array<uint8_t, 4> { 255, 0, 0, 255 }));
+    EXPECT_EQ(rasterizer.statistics().trianglesRasterized, 2U);
+}
+
+TEST(SoftwareRasterizer, EdgesResolvePartialCoverage)
+{
+    ThreadPool         threadPool(1);
+    Raster::Rasterizer rasterizer(threadPool);
+    rasterizer.resize(32, 32);
+
+    // Lower right half of the viewport, split along the anti-diagonal
+    const std::vector<Raster::Vertex> vertices {
+        { { -1.0F, -1.0F, 0.5F, 1.0F }, g_red, {} },
+        { { 1.0F, -1.0F, 0.5F, 1.0F }, g_red, {} },
+        { { 1.0F, 1.0F, 0.5F, 1.0F }, g_red, {} },
+    };
+    constexpr std::array<uint16_t, 3> indices { 0, 1, 2 };
+    Raster::DrawCommand               command;
+    command.vertices = vertices;
+    command.indices16 = indices;
+    command.instanceTransforms = { &g_identity, 1 };
+
+    rasterizer.clear(g_black);
+    rasterizer.draw(command);
+    Raster::Image image;
+    rasterizer.resolve(image);
+
+    EXPECT_EQ(pixel(image, 31, 31)[0], 255);
+    EXPECT_EQ(pixel(image, 0, 0)[0], 0);
+    size_t partial = 0;
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        const uint8_t red = pixel(image, i, 31 - i)[0];
+        partial += red > 0 && red < 255 ? 1 : 0;
+    }
+    EXPECT_GT(partial, 16U);
+}
+
+TEST(SoftwareRasterizer, SamplesTexturesBilinearly)
+{
+    // Black and white texels in sRGB; the midpoint is half intensity in linear space
+    constexpr std::array<uint8_t, 8> texels { 0, 0, 0, 255, 255, 255, 255, 255 };
+    const Raster::Texture            texture(texels, 2, 1, true);
+    EXPECT_FLOAT_EQ(texture.sample(0.25F, 0.5F)[0], 0.0F);
+    EXPECT_FLOAT_EQ(texture.sample(0.75F, 0.5F)[0], 1.0F);
+    EXPECT_NEAR(texture.sample(0.5F, 0.5F)[0], 0.5F, 1e-6F);
+    EXPECT_FLOAT_EQ(texture.sample(-4.0F, 0.5F)[0], 0.0F);
+
+    ThreadPool         threadPool(1);
+    Raster::Rasterizer rasterizer(threadPool);
+    rasterizer.resize(64, 8);
+
+    const auto                   vertices = quad(0.5F, g_red);
+    const Raster::Texture* const bound[] { &texture };
+    auto                         command = drawQuad(vertices);
+    command.textures = bound;
+
+    rasterizer.clear(g_black);
+    rasterizer.draw(command);
+    Raster::Image image;
+    rasterizer.resolve(image);
+    EXPECT_EQ(pixel(image, 0, 4)[1], 0);
+    EXPECT_EQ(pixel(image, 63, 4)[1], 255);
+    EXPECT_LT(pixel(image, 31, 4)[1], pixel(image, 40, 4)[1]);
+}
+
+TEST(SoftwareRasterizer, ResultDoesNotDependOnThreadCount)
+{
+    const auto reference = renderScene(1);
+    for (const uint32_t threadCount : { 2U, 4U })
+    {
+        const auto difference = Raster::compareImages(reference, renderScene(threadCount));
+        EXPECT_EQ(difference.differingPixels, 0U) << threadCount << " threads";
+    }
+}
+
+TEST(SoftwareRasterizer, CompareImagesReportsDifferences)
+{
+    Raster::Image a { 2, 1, { 0, 0, 0, 255, 10, 10, 10, 255 } };
+    Raster::Image b = a;
+    b.pixels[4] = 14;
+
+    const auto difference = Raster::compareImages(a, b);
+    EXPECT_EQ(difference.maxChannelError, 4U);
+    EXPECT_EQ(difference.differingPixels, 1U);
+    EXPECT_DOUBLE_EQ(difference.rootMeanSquareError, std::sqrt(16.0 / 8.0));
+
+    b.width = 1;
+    EXPECT_THROW(static_cast<void>(Raster::compareImages(a, b)), std::invalid_argument);
+}
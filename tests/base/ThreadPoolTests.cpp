@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ThreadPool.hpp"
+
+TEST(ThreadPool, RunsEveryItemOnce)
+{
+    ThreadPool                    pool(4);
+    std::vector<std::atomic<int>> visits(10'001);
+    pool.parallelFor(visits.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            visits[i]++;
+        }
+    });
+    for (size_t i = 0; i < visits.size(); i++)
+    {
+        ASSERT_EQ(visits[i].load(), 1) << "item " << i;
+    }
+}
+
+TEST(ThreadPool, NestedLoopsComplete)
+{
+    ThreadPool          pool(4);
+    std::atomic<size_t> total = 0;
+    pool.parallelFor(16, 1, [&](size_t, size_t) {
+        pool.parallelFor(1'000, 10, [&](size_t begin, size_t end) { total += end - begin; });
+    });
+    EXPECT_EQ(total.load(), 16'000U);
+}
+
+TEST(ThreadPool, WorkerExceptionIsRethrownOnTheCaller)
+{
+    ThreadPool        pool(4);
+    const auto        caller = std::this_thread::get_id();
+    std::atomic<bool> thrown = false;
+    const auto        throwOnWorker = [&](size_t, size_t) {
+        // Give the helpers time to pick up chunks
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        if (std::this_thread::get_id() != caller && !thrown.exchange(true))
+        {
+            throw std::runtime_error("worker");
+        }
+    };
+    EXPECT_THROW(pool.parallelFor(1'000, 1, throwOnWorker), std::runtime_error);
+    EXPECT_TRUE(thrown.load());
+}
+
+TEST(ThreadPool, CallerExceptionWaitsForRunningChunks)
+{
+    ThreadPool          pool(4);
+    const auto          caller = std::this_thread::get_id();
+    std::atomic<int>    running = 0;
+    std::atomic<size_t> started = 0;
+    try
+    {
+        pool.parallelFor(1'000, 1, [&](size_t, size_t) {
+            running++;
+            started++;
+            if (std::this_thread::get_id() == caller)
+            {
+                running--;
+                throw std::runtime_error("caller");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            running--;
+        });
+        FAIL() << "expected an exception";
+    }
+    catch (const std::runtime_error& e)
+    {
+        EXPECT_STREQ(e.what(), "caller");
+    }
+
+    // Every chunk had returned before the exception reached the caller, and the
+    // remaining chunks were never started
+    EXPECT_EQ(running.load(), 0);
+    EXPECT_LT(started.load(), 1'000U);
+}
+
+TEST(ThreadPool, ThrowingEveryChunkRethrowsOnce)
+{
+    ThreadPool pool(4);
+    const auto throwEverywhere = [](size_t, size_t) { throw std::out_of_range("every chunk"); };
+    EXPECT_THROW(pool.parallelFor(64, 1, throwEverywhere), std::out_of_range);
+}
+
+TEST(ThreadPool, RemainsUsableAfterAnException)
+{
+    ThreadPool pool(4);
+    const auto throwOnce = [](size_t begin, size_t) {
+        if (begin == 50)
+        {
+            throw std::runtime_error("chunk 50");
+        }
+    };
+    EXPECT_THROW(pool.parallelFor(100, 1, throwOnce), std::runtime_error);
+
+    std::atomic<size_t> total = 0;
+    pool.parallelFor(1'000, 10, [&](size_t begin, size_t end) { total += end - begin; });
+    EXPECT_EQ(total.load(), 1'000U);
+}
+
+TEST(ThreadPool, SingleThreadedPoolPropagatesExceptions)
+{
+    ThreadPool pool(1);
+    size_t     calls = 0;
+    const auto countAndThrow = [&](size_t, size_t) {
+        calls++;
+        throw std::runtime_error("first");
+    };
+    EXPECT_THROW(pool.parallelFor(10, 1, countAndThrow), std::runtime_error);
+    EXPECT_EQ(calls, 1U);
+}
@@ -0,0 +1,344 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Animation.hpp"
+#include "ThreadPool.hpp"
+#include "TransformHierarchy.hpp"
+
+namespace
+{
+    using NodeId = TransformHierarchy::NodeId;
+
+    /// The local matrix of a transform, scaled, rotated and then translated, with
+    /// row vectors.
+    Assets::Matrix4 localMatrix(const Animation::Transform& local)
+    {
+        const auto [x, y, z, w] = local.rotation;
+        const auto& s = local.scale;
+        return { s[0] * (1.0F - 2.0F * (y * y + z * z)), s[0] * 2.0F * (x * y + z * w),
+            s[0] * 2.0F * (x * z - y * w), 0.0F, s[1] * 2.0F * (x * y - z * w),
+            s[1] * (1.0F - 2.0F * (x * x + z * z)), s[1] * 2.0F * (y * z + x * w), 0.0F,
+            s[2] * 2.0F * (x * z + y * w), s[2] * 2.0F * (y * z - x * w),
+            s[2] * (1.0F - 2.0F * (x * x + y * y)), 0.0F, local.translation[0],
+            local.translation[1], local.translation[2], 1.0F };
+    }
+
+    Assets::Matrix4 multiply(const Assets::Matrix4& a, const Assets::Matrix4& b)
+    {
+        Assets::Matrix4 result {};
+        for (size_t row = 0; row < 4; row++)
+        {
+            for (size_t column = 0; column < 4; column++)
+            {
+                for (size_t k = 0; k < 4; k++)
+                {
+                    result[row * 4 + column] += a[row * 4 + k] * b[k * 4 + column];
+                }
+            }
+        }
+        return result;
+    }
+
+    /// The world matrix recomputed from the root down, ignoring every cached result.
+    Assets::Matrix4 referenceWorld(const TransformHierarchy& hierarchy, const NodeId node)
+    {
+        const Assets::Matrix4 local = localMatrix(hierarchy.local(node));
+        const NodeId          parent = hierarchy.parent(node);
+        return parent == TransformHierarchy::s_invalidNode
+            ? local
+            : multiply(local, referenceWorld(hierarchy, parent));
+    }
+
+    size_t depth(const TransformHierarchy& hierarchy, NodeId node)
+    {
+        size_t result = 0;
+        while ((node = hierarchy.parent(node)) != TransformHierarchy::s_invalidNode)
+        {
+            result++;
+        }
+        return result;
+    }
+
+    bool isDescendant(const TransformHierarchy& hierarchy, NodeId node, const NodeId ancestor)
+    {
+        for (; node != TransformHierarchy::s_invalidNode; node = hierarchy.parent(node))
+        {
+            if (node == ancestor)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Animation::Transform randomTransform(std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> unit(-1.0F, 1.0F);
+        std::uniform_real_distribution<float> scale(0.5F, 1.5F);
+
+        Animation::Transform transform;
+        transform.translation = { unit(random), unit(random), unit(random) };
+        float length = 0.0F;
+        for (float& value : transform.rotation)
+        {
+            value = unit(random);
+            length += value * value;
+        }
+        for (float& value : transform.rotation)
+        {
+            value /= std::sqrt(length);
+        }
+        transform.scale = { scale(random), scale(random), scale(random) };
+        return transform;
+    }
+
+    /// A random forest in which each node picks an earlier node, or none, as parent.
+    std::vector<NodeId> createForest(
+        TransformHierarchy& hierarchy, std::mt19937& random, const size_t count)
+    {
+        std::vector<NodeId> nodes;
+        for (size_t i = 0; i < count; i++)
+        {
+            NodeId parent = TransformHierarchy::s_invalidNode;
+            if (i >= 4)
+            {
+                parent = nodes[std::uniform_int_distribution<size_t>(0, i - 1)(random)];
+            }
+            nodes.push_back(hierarchy.create(parent, randomTransform(random)));
+        }
+        return nodes;
+    }
+
+    void expectMatchesReference(
+        const TransformHierarchy& hierarchy, const std::vector<NodeId>& nodes)
+    {
+        for (const NodeId node : nodes)
+        {
+            if (!hierarchy.isAlive(node))
+            {
+                continue;
+            }
+            const Assets::Matrix4 expected = referenceWorld(hierarchy, node);
+            const Assets::Matrix4& actual = hierarchy.world(node);
+            for (size_t i = 0; i < expected.size(); i++)
+            {
+                ASSERT_NEAR(actual[i], expected[i], 1e-3F) << "node " << node << " element " << i;
+            }
+            EXPECT_EQ(&actual, &hierarchy.worldMatrices()[hierarchy.slot(node)]);
+        }
+    }
+
+    /// Slots are breadth first: depths never decrease and every parent precedes its
+    /// children.
+    void expectBreadthFirst(
+        const TransformHierarchy& hierarchy, const std::vector<NodeId>& nodes)
+    {
+        std::vector<size_t> depthBySlot(hierarchy.worldMatrices().size(), 0);
+        for (const NodeId node : nodes)
+        {
+            if (!hierarchy.isAlive(node))
+            {
+                continue;
+            }
+            const uint32_t slot = hierarchy.slot(node);
+            ASSERT_LT(slot, depthBySlot.size());
+            depthBySlot[slot] = depth(hierarchy, node);
+            const NodeId parent = hierarchy.parent(node);
+            if (parent != TransformHierarchy::s_invalidNode)
+            {
+                EXPECT_LT(hierarchy.slot(parent), slot) << "node " << node;
+            }
+        }
+        EXPECT_TRUE(std::ranges::is_sorted(depthBySlot));
+    }
+} // namespace
+
+TEST(TransformHierarchy, FirstUpdateComputesEveryNode)
+{
+    std::mt19937        random(7);
+    TransformHierarchy  hierarchy;
+    std::vector<NodeId> nodes = createForest(hierarchy, random, 500);
+
+    EXPECT_EQ(hierarchy.update(), 500U);
+    EXPECT_EQ(hierarchy.nodeCount(), 500U);
+    expectMatchesReference(hierarchy, nodes);
+    expectBreadthFirst(hierarchy, nodes);
+
+    // Nothing changed, so nothing is recomputed
+    EXPECT_EQ(hierarchy.update(), 0U);
+    EXPECT_TRUE(hierarchy.updatedSlots().empty());
+}
+
+TEST(TransformHierarchy, DirtySubtreeMatchesAFullRecompute)
+{
+    std::mt19937        random(11);
+    TransformHierarchy  hierarchy;
+    std::vector<NodeId> nodes = createForest(hierarchy, random, 1'000);
+    hierarchy.update();
+
+    for (int round = 0; round < 20; round++)
+    {
+        const NodeId dirty = nodes[std::uniform_int_distribution<size_t>(0, 999)(random)];
+        hierarchy.setLocal(dirty, randomTransform(random));
+
+        // Only the node and its descendants are recomputed
+        const size_t subtree = static_cast<size_t>(std::ranges::count_if(
+            nodes, [&](const NodeId node) { return isDescendant(hierarchy, node, dirty); }));
+        ASSERT_EQ(hierarchy.update(), subtree) << "round " << round;
+        const auto updated = hierarchy.updatedSlots();
+        EXPECT_TRUE(std::ranges::is_sorted(updated));
+        for (const NodeId node : nodes)
+        {
+            const bool expected = isDescendant(hierarchy, node, dirty);
+            EXPECT_EQ(std::ranges::binary_search(updated, hierarchy.slot(node)), expected)
+                << "node " << node;
+        }
+        expectMatchesReference(hierarchy, nodes);
+    }
+}
+
+TEST(TransformHierarchy, OverlappingDirtyNodesAreComputedOnce)
+{
+    TransformHierarchy hierarchy;
+    const NodeId       root = hierarchy.create();
+    const NodeId       child = hierarchy.create(root);
+    const NodeId       grandchild = hierarchy.create(child);
+    hierarchy.create();
+    hierarchy.update();
+
+    hierarchy.setLocal(root, { .translation = { 1.0F, 0.0F, 0.0F } });
+    hierarchy.setLocal(grandchild, { .translation = { 0.0F, 2.0F, 0.0F } });
+    EXPECT_EQ(hierarchy.update(), 3U);
+    EXPECT_FLOAT_EQ(hierarchy.world(grandchild)[12], 1.0F);
+    EXPECT_FLOAT_EQ(hierarchy.world(grandchild)[13], 2.0F);
+}
+
+TEST(TransformHierarchy, ReparentingResortsByDepth)
+{
+    std::mt19937        random(13);
+    TransformHierarchy  hierarchy;
+    std::vector<NodeId> nodes = createForest(hierarchy, random, 600);
+    hierarchy.update();
+
+    for (int round = 0; round < 20; round++)
+    {
+        // Move a node under another one that is not in its subtree, or make it a root,
+        // which changes the depth of its whole subtree
+        const NodeId node = nodes[std::uniform_int_distribution<size_t>(0, 599)(random)];
+        NodeId       parent = TransformHierarchy::s_invalidNode;
+        if (round % 4 != 0)
+        {
+            do
+            {
+                parent = nodes[std::uniform_int_distribution<size_t>(0, 599)(random)];
+            } while (isDescendant(hierarchy, parent, node));
+        }
+        hierarchy.setParent(node, parent);
+        EXPECT_EQ(hierarchy.parent(node), parent);
+
+        const size_t subtree = static_cast<size_t>(std::ranges::count_if(
+            nodes, [&](const NodeId other) { return isDescendant(hierarchy, other, node); }));
+        ASSERT_EQ(hierarchy.update(), subtree) << "round " << round;
+        expectBreadthFirst(hierarchy, nodes);
+        expectMatchesReference(hierarchy, nodes);
+    }
+}
+
+TEST(TransformHierarchy, DestroyRemovesTheSubtree)
+{
+    std::mt19937        random(17);
+    TransformHierarchy  hierarchy;
+    std::vector<NodeId> nodes = createForest(hierarchy, random, 300);
+    hierarchy.update();
+
+    const NodeId        destroyed = nodes[5];
+    std::vector<NodeId> subtree;
+    for (const NodeId node : nodes)
+    {
+        if (isDescendant(hierarchy, node, destroyed))
+        {
+            subtree.push_back(node);
+        }
+    }
+    hierarchy.destroy(destroyed);
+    EXPECT_FALSE(hierarchy.isAlive(destroyed));
+    hierarchy.update();
+
+    for (const NodeId node : subtree)
+    {
+        EXPECT_FALSE(hierarchy.isAlive(node)) << "node " << node;
+    }
+    EXPECT_EQ(hierarchy.nodeCount(), 300U - subtree.size());
+    EXPECT_EQ(hierarchy.worldMatrices().size(), 300U - subtree.size());
+
+    // Nodes created afterwards reuse the ids and fit into the order
+    std::vector<NodeId> live;
+    std::ranges::copy_if(nodes, std::back_inserter(live),
+        [&](const NodeId node) { return hierarchy.isAlive(node); });
+    for (size_t i = 0; i < subtree.size(); i++)
+    {
+        const NodeId node = hierarchy.create(live[i], randomTransform(random));
+        EXPECT_NE(std::ranges::find(subtree, node), subtree.end()) << "node " << node;
+    }
+    hierarchy.update();
+    EXPECT_EQ(hierarchy.nodeCount(), 300U);
+    expectBreadthFirst(hierarchy, nodes);
+    expectMatchesReference(hierarchy, nodes);
+}
+
+TEST(TransformHierarchy, ThreadPoolUpdateMatchesSerialUpdate)
+{
+    std::mt19937        random(19);
+    TransformHierarchy  serial;
+    std::vector<NodeId> nodes = createForest(serial, random, 5'000);
+
+    random.seed(19);
+    TransformHierarchy parallel;
+    createForest(parallel, random, 5'000);
+
+    ThreadPool pool(4);
+    EXPECT_EQ(serial.update(), parallel.update(pool));
+    for (size_t i = 0; i < 5'000; i += 7)
+    {
+        const auto transform = randomTransform(random);
+        serial.setLocal(nodes[i], transform);
+        parallel.setLocal(nodes[i], transform);
+    }
+    serial.setParent(nodes[10], TransformHierarchy::s_invalidNode);
+    parallel.setParent(nodes[10], TransformHierarchy::s_invalidNode);
+
+    EXPECT_EQ(serial.update(), parallel.update(pool));
+    EXPECT_TRUE(std::ranges::equal(serial.updatedSlots(), parallel.updatedSlots()));
+    EXPECT_TRUE(std::ranges::equal(serial.worldMatrices(), parallel.worldMatrices()));
+    expectMatchesReference(parallel, nodes);
+}
+
+TEST(TransformHierarchy, RejectsInvalidStructure)
+{
+    TransformHierarchy hierarchy;
+    const NodeId       root = hierarchy.create();
+    const NodeId       child = hierarchy.create(root);
+    const NodeId       grandchild = hierarchy.create(child);
+
+    EXPECT_THROW(hierarchy.create(42), std::runtime_error);
+    EXPECT_THROW(hierarchy.setParent(root, root), std::runtime_error);
+    EXPECT_THROW(hierarchy.setParent(root, grandchild), std::runtime_error);
+    EXPECT_THROW(hierarchy.setParent(42, root), std::runtime_error);
+
+    hierarchy.destroy(grandchild);
+    EXPECT_THROW(hierarchy.destroy(grandchild), std::runtime_error);
+    EXPECT_THROW(hierarchy.setLocal(grandchild, {}), std::runtime_error);
+}
@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "SimulationThread.hpp"
+#include "TripleBuffer.hpp"
+
+namespace
+{
+    /// Every field holds the sequence number, so a torn read shows as a mismatch.
+    struct Payload
+    {
+        std::array<uint64_t, 32> values {};
+    };
+
+    struct Counter
+    {
+        uint64_t steps = 0;
+        double   seconds = 0.0;
+    };
+} // namespace
+
+TEST(TripleBuffer, StartsWithTheInitialValue)
+{
+    TripleBuffer<int> mailbox(7);
+    EXPECT_EQ(mailbox.readBuffer(), 7);
+    EXPECT_FALSE(mailbox.update());
+    EXPECT_EQ(mailbox.readBuffer(), 7);
+}
+
+TEST(TripleBuffer, UpdateTakesTheLatestPublishedValue)
+{
+    TripleBuffer<int> mailbox;
+    for (const int value : { 1, 2, 3 })
+    {
+        mailbox.writeBuffer() = value;
+        mailbox.publish();
+    }
+    EXPECT_TRUE(mailbox.update());
+    EXPECT_EQ(mailbox.readBuffer(), 3);
+    EXPECT_FALSE(mailbox.update());
+    EXPECT_EQ(mailbox.readBuffer(), 3);
+
+    mailbox.writeBuffer() = 4;
+    mailbox.publish();
+    EXPECT_TRUE(mailbox.update());
+    EXPECT_EQ(mailbox.readBuffer(), 4);
+}
+
+TEST(TripleBuffer, ReadBufferIsNeverWrittenWhileHeld)
+{
+    TripleBuffer<int> mailbox;
+    mailbox.writeBuffer() = 1;
+    mailbox.publish();
+    ASSERT_TRUE(mailbox.update());
+    const int* held = &mailbox.readBuffer();
+
+    // The producer cycles through the other two slots only
+    for (int value = 2; value < 10; value++)
+    {
+        EXPECT_NE(&mailbox.writeBuffer(), held);
+        mailbox.writeBuffer() = value;
+        mailbox.publish();
+        EXPECT_EQ(*held, 1);
+    }
+}
+
+TEST(TripleBuffer, SnapshotsStayConsistentUnderContention)
+{
+    constexpr uint64_t    publishCount = 200'000;
+    TripleBuffer<Payload> mailbox;
+    std::atomic<bool>     done = false;
+
+    std::thread producer([&] {
+        for (uint64_t sequence = 1; sequence <= publishCount; sequence++)
+        {
+            mailbox.writeBuffer().values.fill(sequence);
+            mailbox.publish();
+        }
+        done = true;
+    });
+
+    uint64_t last = 0;
+    uint64_t taken = 0;
+    bool     consistent = true;
+    bool     ordered = true;
+    for (;;)
+    {
+        // Everything published before done was set is visible once it reads true
+        const bool finished = done;
+        if (!mailbox.update())
+        {
+            if (finished)
+            {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        const Payload& payload = mailbox.readBuffer();
+        for (const uint64_t value : payload.values)
+        {
+            consistent &= value == payload.values.front();
+        }
+        ordered &= payload.values.front() > last;
+        last = payload.values.front();
+        taken++;
+    }
+    producer.join();
+
+    EXPECT_TRUE(consistent);
+    EXPECT_TRUE(ordered);
+    EXPECT_GT(taken, 0U);
+    EXPECT_EQ(mailbox.readBuffer().values.front(), publishCount);
+}
+
+TEST(SimulationThread, PublishesConsecutiveSteps)
+{
+    SimulationThread<Counter> simulation(Counter {}, 0.001,
+        [](const GameTimer& timer, Counter& state) {
+            state.steps++;
+            state.seconds += timer.elapsedSeconds();
+        });
+    EXPECT_EQ(simulation.latestSnapshot().stepNumber, 0U);
+
+    simulation.start();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (simulation.latestSnapshot().stepNumber < 20
+        && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    simulation.stop();
+    EXPECT_FALSE(simulation.isRunning());
+
+    const auto& snapshot = simulation.latestSnapshot();
+    ASSERT_GE(snapshot.stepNumber, 20U);
+    EXPECT_EQ(snapshot.current.steps, snapshot.stepNumber);
+    EXPECT_EQ(snapshot.previous.steps + 1, snapshot.current.steps);
+    EXPECT_NEAR(snapshot.current.seconds, 0.001 * static_cast<double>(snapshot.stepNumber), 1e-9);
+
+    // The state is kept across a restart
+    const uint64_t stopped = snapshot.stepNumber;
+    simulation.start();
+    while (simulation.latestSnapshot().stepNumber <= stopped
+        && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    simulation.stop();
+    EXPECT_EQ(simulation.latestSnapshot().current.steps, simulation.latestSnapshot().stepNumber);
+    EXPECT_GT(simulation.latestSnapshot().stepNumber, stopped);
+}
+
+TEST(SimulationThread, InterpolationFactorIsClamped)
+{
+    SimulationThread<Counter> simulation(Counter {}, 0.01, [](const GameTimer&, Counter&) {});
+    const auto&               snapshot = simulation.latestSnapshot();
+    const auto                stepTicks = static_cast<uint64_t>(
+        0.01 * static_cast<double>(SDL_GetPerformanceFrequency()));
+
+    EXPECT_DOUBLE_EQ(simulation.interpolationFactor(snapshot, snapshot.time - 1), 0.0);
+    EXPECT_NEAR(simulation.interpolationFactor(snapshot, snapshot.time + stepTicks / 2), 0.5, 1e-6);
+    EXPECT_DOUBLE_EQ(simulation.interpolationFactor(snapshot, snapshot.time + stepTicks * 3), 1.0);
+}
@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "UploadRing.hpp"
+
+namespace
+{
+    struct Range
+    {
+        uint64_t frameNumber = 0;
+        uint64_t begin = 0;
+        uint64_t end = 0;
+    };
+
+    bool overlaps(const Range& a, const Range& b)
+    {
+        return a.begin < b.end && b.begin < a.end;
+    }
+} // namespace
+
+TEST(UploadRing, RejectsEmptyBuffers)
+{
+    std::byte memory[16];
+    EXPECT_THROW(UploadRing(nullptr, 16), std::invalid_argument);
+    EXPECT_THROW(UploadRing(memory, 0), std::invalid_argument);
+}
+
+TEST(UploadRing, AllocationsAreAligned)
+{
+    std::vector<std::byte> memory(4096);
+    UploadRing             ring(memory.data(), memory.size());
+    ring.beginFrame(1);
+
+    const auto a = ring.allocate(10);
+    const auto b = ring.allocate(10);
+    const auto c = ring.allocate(3, 16);
+    ASSERT_TRUE(a && b && c);
+    EXPECT_EQ(a.offset, 0U);
+    EXPECT_EQ(b.offset, 256U);
+    EXPECT_EQ(c.offset, 272U);
+    EXPECT_EQ(b.data, memory.data() + 256);
+    EXPECT_EQ(ring.statistics().bytesInFlight, 275U);
+}
+
+TEST(UploadRing, WrapsAndChargesThePaddingToTheFrame)
+{
+    std::vector<std::byte> memory(1024);
+    UploadRing             ring(memory.data(), memory.size());
+
+    ring.beginFrame(1);
+    ASSERT_TRUE(ring.allocate(512));
+    ring.beginFrame(2);
+    ASSERT_TRUE(ring.allocate(256, 256));
+    ring.retireFrames(2); // Frame 1 is done, frame 2 holds [512, 768)
+
+    ring.beginFrame(3);
+    const auto wrapped = ring.allocate(512);
+    ASSERT_TRUE(wrapped);
+    EXPECT_EQ(wrapped.offset, 0U);
+    EXPECT_EQ(ring.statistics().wraps, 1U);
+    // The 256 unused bytes at the end belong to frame 3 until it retires
+    EXPECT_EQ(ring.statistics().bytesInFlight, 256U + 256U + 512U);
+
+    ring.retireFrames(3);
+    EXPECT_EQ(ring.statistics().bytesInFlight, 768U);
+    ring.beginFrame(4);
+    ring.retireFrames(4);
+    EXPECT_EQ(ring.statistics().bytesInFlight, 0U);
+}
+
+TEST(UploadRing, FailsWhenFullAndRecoversOnceFramesRetire)
+{
+    std::vector<std::byte> memory(1024);
+    UploadRing             ring(memory.data(), memory.size());
+
+    for (uint64_t frame = 1; frame <= 4; frame++)
+    {
+        ring.beginFrame(frame);
+        ASSERT_TRUE(ring.allocate(256));
+    }
+    EXPECT_FALSE(ring.allocate(1));
+    EXPECT_FALSE(ring.allocate(2048));
+    EXPECT_EQ(ring.statistics().failures, 2U);
+
+    ring.retireFrames(2);
+    ring.beginFrame(5);
+    const auto allocation = ring.allocate(256);
+    ASSERT_TRUE(allocation);
+    EXPECT_EQ(allocation.offset, 0U);
+    EXPECT_FALSE(ring.allocate(256));
+
+    // With everything retired the whole buffer is available in one piece
+    ring.beginFrame(6);
+    ring.retireFrames(6);
+    ring.beginFrame(7);
+    EXPECT_TRUE(ring.allocate(1024));
+}
+
+TEST(UploadRing, RetriedFrameKeepsItsAllocations)
+{
+    std::vector<std::byte> memory(1024);
+    UploadRing             ring(memory.data(), memory.size());
+
+    ring.beginFrame(1);
+    ASSERT_TRUE(ring.allocate(256));
+    ring.beginFrame(1);
+    ASSERT_TRUE(ring.allocate(256));
+    ring.beginFrame(2);
+    ring.retireFrames(1);
+    EXPECT_EQ(ring.statistics().bytesInFlight, 512U);
+    ring.retireFrames(2);
+    EXPECT_EQ(ring.statistics().bytesInFlight, 0U);
+}
+
+TEST(UploadRing, LiveAllocationsNeverOverlapWithSimulatedFences)
+{
+    std::vector<std::byte> memory(64 * 1024);
+    UploadRing             ring(memory.data(), memory.size());
+
+    std::mt19937                            random(17);
+    std::uniform_int_distribution<uint64_t> size(1, 3000);
+    std::uniform_int_distribution<uint32_t> alignmentShift(0, 8);
+    std::uniform_int_distribution<uint32_t> gpuLag(1, 3);
+
+    std::deque<Range> live;
+    uint64_t          completedFrames = 0;
+    uint64_t          failures = 0;
+    for (uint64_t frameNumber = 1; frameNumber < 2000; frameNumber++)
+    {
+        // The GPU runs one to three frames behind
+        const uint64_t lag = std::min<uint64_t>(frameNumber, gpuLag(random));
+        completedFrames = std::max(completedFrames, frameNumber - lag);
+        ring.retireFrames(completedFrames);
+        while (!live.empty() && live.front().frameNumber < completedFrames)
+        {
+            live.pop_front();
+        }
+
+        ring.beginFrame(frameNumber);
+        for (size_t i = 0; i < 8; i++)
+        {
+            const uint64_t alignment = uint64_t { 1 } << alignmentShift(random);
+            const auto     allocation = ring.allocate(size(random), alignment);
+            if (!allocation)
+            {
+                failures++;
+                continue;
+            }
+            ASSERT_EQ(allocation.offset % alignment, 0U);
+            ASSERT_LE(allocation.offset + allocation.size, ring.capacity());
+
+            const Range range { frameNumber, allocation.offset,
+                allocation.offset + allocation.size };
+            for (const Range& other : live)
+            {
+                ASSERT_FALSE(overlaps(range, other))
+                    << "frame " << frameNumber << " overlaps frame " << other.frameNumber;
+            }
+            live.push_back(range);
+        }
+    }
+    EXPECT_EQ(failures, ring.statistics().failures);
+    EXPECT_GT(ring.statistics().wraps, 0U);
+    EXPECT_LE(ring.statistics().peakBytesInFlight, ring.capacity());
+}
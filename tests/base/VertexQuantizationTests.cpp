@@ -0,0 +1,268 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numbers>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "VertexQuantization.hpp"
+
+namespace
+{
+    using Float3 = std::array<float, 3>;
+
+    template <typename T>
+    std::vector<T> elements(const Assets::EncodedStream& stream)
+    {
+        std::vector<T> result(stream.bytes.size() / sizeof(T));
+        std::memcpy(result.data(), stream.bytes.data(), result.size() * sizeof(T));
+        return result;
+    }
+
+    /// Unit vectors spread over the whole sphere, poles and axes included.
+    std::vector<Float3> directions()
+    {
+        std::vector<Float3> result { { 1.0F, 0.0F, 0.0F }, { -1.0F, 0.0F, 0.0F },
+            { 0.0F, 1.0F, 0.0F }, { 0.0F, -1.0F, 0.0F }, { 0.0F, 0.0F, 1.0F },
+            { 0.0F, 0.0F, -1.0F } };
+        std::mt19937                          random(5);
+        std::uniform_real_distribution<float> uniform(-1.0F, 1.0F);
+        while (result.size() < 20'000)
+        {
+            const Float3 v { uniform(random), uniform(random), uniform(random) };
+            const float  length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            if (length > 0.1F && length <= 1.0F)
+            {
+                result.push_back({ v[0] / length, v[1] / length, v[2] / length });
+            }
+        }
+        return result;
+    }
+
+    /// Angle between two directions, from the cross product so it stays accurate for
+    /// nearly parallel ones.
+    float angle(const Float3& a, const Float3& b)
+    {
+        const std::array<double, 3> u { a[0], a[1], a[2] };
+        const std::array<double, 3> v { b[0], b[1], b[2] };
+        const double                cross = std::hypot(u[1] * v[2] - u[2] * v[1],
+            u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]);
+        return static_cast<float>(std::atan2(cross, u[0] * v[0] + u[1] * v[1] + u[2] * v[2]));
+    }
+} // namespace
+
+TEST(VertexQuantization, HalfRoundTripsRepresentableValues)
+{
+    for (const float value : { 0.0F, 1.0F, -2.0F, 0.5F, 0.333251953125F, 65504.0F, -65504.0F,
+             6.103515625e-05F, 5.9604644775390625e-08F })
+    {
+        EXPECT_EQ(Assets::decodeHalf(Assets::encodeHalf(value)), value) << value;
+    }
+    EXPECT_EQ(Assets::encodeHalf(1.0F), 0x3C00);
+    EXPECT_EQ(Assets::encodeHalf(-0.0F), 0x8000);
+    EXPECT_EQ(Assets::encodeHalf(5.9604644775390625e-08F), 0x0001);
+    EXPECT_EQ(Assets::decodeHalf(Assets::encodeHalf(std::numeric_limits<float>::infinity())),
+        std::numeric_limits<float>::infinity());
+    EXPECT_TRUE(std::isnan(
+        Assets::decodeHalf(Assets::encodeHalf(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+TEST(VertexQuantization, HalfRoundsToNearestEven)
+{
+    // Halfway between 1 and the next half rounds down to the even mantissa, halfway
+    // above that rounds up to it
+    EXPECT_EQ(Assets::encodeHalf(1.0F + 0x1p-11F), 0x3C00);
+    EXPECT_EQ(Assets::encodeHalf(1.0F + 3 * 0x1p-11F), 0x3C02);
+    EXPECT_EQ(Assets::encodeHalf(1.0F + 0x1p-11F + 0x1p-20F), 0x3C01);
+
+    EXPECT_EQ(Assets::encodeHalf(65519.0F), 0x7BFF);
+    EXPECT_EQ(Assets::encodeHalf(65520.0F), 0x7C00);
+    EXPECT_EQ(Assets::encodeHalf(1e10F), 0x7C00);
+    EXPECT_EQ(Assets::encodeHalf(1e-10F), 0x0000);
+}
+
+TEST(VertexQuantization, HalfErrorStaysWithinHalfAStep)
+{
+    // Halfs have 11 significant bits, so any value rounds within 2^-11 of itself
+    for (int i = -40'000; i <= 40'000; i++)
+    {
+        const float value = static_cast<float>(i) / 10'000.0F;
+        const float error = std::abs(Assets::decodeHalf(Assets::encodeHalf(value)) - value);
+        EXPECT_LE(error, std::max(std::abs(value) * 0x1p-11F, 0x1p-25F)) << value;
+    }
+}
+
+TEST(VertexQuantization, NormalizedIntegersClampAndRound)
+{
+    EXPECT_EQ(Assets::quantizeUnorm16(0.0F), 0);
+    EXPECT_EQ(Assets::quantizeUnorm16(1.0F), 65535);
+    EXPECT_EQ(Assets::quantizeUnorm16(1.5F), 65535);
+    EXPECT_EQ(Assets::quantizeUnorm16(-0.5F), 0);
+    EXPECT_EQ(Assets::quantizeUnorm16(0.5F), 32768);
+    EXPECT_EQ(Assets::quantizeUnorm8(0.5F), 128);
+    EXPECT_EQ(Assets::quantizeUnorm8(2.0F), 255);
+    EXPECT_EQ(Assets::quantizeSnorm16(-1.0F), -32767);
+    EXPECT_EQ(Assets::quantizeSnorm16(-2.0F), -32767);
+    EXPECT_EQ(Assets::quantizeSnorm16(1.0F), 32767);
+    EXPECT_EQ(Assets::quantizeSnorm8(-1.0F), -127);
+    EXPECT_EQ(Assets::quantizeSnorm8(0.0F), 0);
+}
+
+TEST(VertexQuantization, OctahedralMappingIsExactBeforeQuantization)
+{
+    for (const auto& direction : directions())
+    {
+        const auto encoded = Assets::encodeOctahedral(direction);
+        EXPECT_LE(std::abs(encoded[0]), 1.0F);
+        EXPECT_LE(std::abs(encoded[1]), 1.0F);
+        EXPECT_LT(angle(Assets::decodeOctahedral(encoded), direction), 1e-6F);
+    }
+}
+
+TEST(VertexQuantization, NormalErrorIsBounded)
+{
+    // 2x16 bit octahedral coordinates are within a few thousandths of a degree
+    const auto normals = directions();
+    const auto stream = Assets::quantizeNormals(normals);
+    EXPECT_EQ(stream.format, Assets::VertexStreamFormat::Short2Normalized);
+    const auto encoded = elements<std::array<int16_t, 2>>(stream);
+    ASSERT_EQ(encoded.size(), normals.size());
+
+    float maxError = 0.0F;
+    for (size_t i = 0; i < normals.size(); i++)
+    {
+        const auto decoded = Assets::decodeOctahedral({ encoded[i][0] / 32767.0F,
+            encoded[i][1] / 32767.0F });
+        maxError = std::max(maxError, angle(decoded, normals[i]));
+    }
+    EXPECT_LT(maxError, 1e-4F);
+}
+
+TEST(VertexQuantization, TangentErrorIsBounded)
+{
+    // 2x8 bit octahedral coordinates are within about a degree, and keep the sign
+    std::vector<std::array<float, 4>> tangents;
+    for (const auto& direction : directions())
+    {
+        tangents.push_back({ direction[0], direction[1], direction[2],
+            tangents.size() % 2 == 0 ? 1.0F : -1.0F });
+    }
+    const auto stream = Assets::quantizeTangents(tangents);
+    EXPECT_EQ(stream.format, Assets::VertexStreamFormat::Char4Normalized);
+    const auto encoded = elements<std::array<int8_t, 4>>(stream);
+    ASSERT_EQ(encoded.size(), tangents.size());
+
+    float maxError = 0.0F;
+    for (size_t i = 0; i < tangents.size(); i++)
+    {
+        const auto decoded = Assets::decodeOctahedral({ encoded[i][0] / 127.0F,
+            encoded[i][1] / 127.0F });
+        maxError = std::max(maxError, angle(decoded, { tangents[i][0], tangents[i][1],
+                                                          tangents[i][2] }));
+        EXPECT_EQ(encoded[i][3] < 0, tangents[i][3] < 0.0F);
+    }
+    EXPECT_LT(maxError, 1.5F * std::numbers::pi_v<float> / 180.0F);
+}
+
+TEST(VertexQuantization, PositionErrorIsHalfAStepOfTheBounds)
+{
+    const Float3                          boundsMin { -3.0F, 10.0F, 0.0F };
+    const Float3                          boundsMax { 5.0F, 10.5F, 0.0F };
+    std::mt19937                          random(9);
+    std::uniform_real_distribution<float> uniform(0.0F, 1.0F);
+    std::vector<Float3>                   positions { boundsMin, boundsMax };
+    for (size_t i = 0; i < 10'000; i++)
+    {
+        positions.push_back({ -3.0F + 8.0F * uniform(random), 10.0F + 0.5F * uniform(random),
+            0.0F });
+    }
+
+    const auto stream = Assets::quantizePositions(positions, boundsMin, boundsMax);
+    EXPECT_EQ(stream.format, Assets::VertexStreamFormat::UShort4Normalized);
+    const auto encoded = elements<std::array<uint16_t, 4>>(stream);
+    ASSERT_EQ(encoded.size(), positions.size());
+    EXPECT_EQ(encoded[0], (std::array<uint16_t, 4> { 0, 0, 0, 0xFFFF }));
+    EXPECT_EQ(encoded[1], (std::array<uint16_t, 4> { 0xFFFF, 0xFFFF, 0, 0xFFFF }));
+
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        const auto decoded = Assets::dequantizePosition(encoded[i], boundsMin, boundsMax);
+        for (size_t axis = 0; axis < 3; axis++)
+        {
+            // Half a step, plus float rounding of values around 10
+            const float step = (boundsMax[axis] - boundsMin[axis]) / 65535.0F;
+            EXPECT_LE(std::abs(decoded[axis] - positions[i][axis]), 0.5F * step + 2e-6F);
+        }
+    }
+}
+
+TEST(VertexQuantization, TexCoordAndColorErrorsAreBounded)
+{
+    std::vector<std::array<float, 2>> texCoords;
+    std::vector<std::array<float, 4>> colors;
+    for (int i = 0; i <= 1'000; i++)
+    {
+        const float t = static_cast<float>(i) / 1'000.0F;
+        texCoords.push_back({ t, 2.0F * t - 0.5F });
+        colors.push_back({ t, 1.0F - t, t * t, 1.0F });
+    }
+
+    const auto halfs = elements<std::array<uint16_t, 2>>(Assets::quantizeTexCoords(texCoords));
+    const auto bytes = elements<std::array<uint8_t, 4>>(Assets::quantizeColors(colors));
+    ASSERT_EQ(halfs.size(), texCoords.size());
+    ASSERT_EQ(bytes.size(), colors.size());
+    for (size_t i = 0; i < texCoords.size(); i++)
+    {
+        for (size_t c = 0; c < 2; c++)
+        {
+            // Coordinates below 2 are within 2^-11 of the value
+            EXPECT_LE(std::abs(Assets::decodeHalf(halfs[i][c]) - texCoords[i][c]), 0x1p-11F);
+        }
+        for (size_t c = 0; c < 4; c++)
+        {
+            EXPECT_LE(std::abs(static_cast<float>(bytes[i][c]) / 255.0F - colors[i][c]),
+                0.5F / 255.0F + 1e-6F);
+        }
+    }
+}
+
+TEST(VertexQuantization, CompactFormatsAreSmaller)
+{
+    using Assets::VertexStreamFormat;
+    using Assets::vertexStreamStride;
+    EXPECT_EQ(vertexStreamStride(VertexStreamFormat::None), 0U);
+    EXPECT_EQ(vertexStreamStride(VertexStreamFormat::Float3), 12U);
+    EXPECT_EQ(vertexStreamStride(VertexStreamFormat::UShort4Normalized), 8U);
+    EXPECT_EQ(vertexStreamStride(VertexStreamFormat::Short2Normalized), 4U);
+    EXPECT_EQ(vertexStreamStride(VertexStreamFormat::Char4Normalized), 4U);
+    EXPECT_EQ(vertexStreamStride(VertexStreamFormat::Half2), 4U);
+    EXPECT_EQ(vertexStreamStride(VertexStreamFormat::UChar4Normalized), 4U);
+
+    // Position, normal, texture coordinate, tangent and color: 64 bytes as floats
+    const uint32_t full = vertexStreamStride(VertexStreamFormat::Float3) * 2
+        + vertexStreamStride(VertexStreamFormat::Float2)
+        + vertexStreamStride(VertexStreamFormat::Float4) * 2;
+    const uint32_t compact = vertexStreamStride(VertexStreamFormat::UShort4Normalized)
+        + vertexStreamStride(VertexStreamFormat::Short2Normalized)
+        + vertexStreamStride(VertexStreamFormat::Half2)
+        + vertexStreamStride(VertexStreamFormat::Char4Normalized)
+        + vertexStreamStride(VertexStreamFormat::UChar4Normalized);
+    EXPECT_EQ(full, 64U);
+    EXPECT_EQ(compact, 24U);
+
+    for (const auto format : { VertexStreamFormat::Float2, VertexStreamFormat::Float3,
+             VertexStreamFormat::Float4, VertexStreamFormat::UShort4Normalized,
+             VertexStreamFormat::Short2Normalized, VertexStreamFormat::Char4Normalized,
+             VertexStreamFormat::Half2, VertexStreamFormat::UChar4Normalized })
+    {
+        EXPECT_NE(Assets::metalVertexFormat(format), 0U);
+    }
+    EXPECT_EQ(Assets::metalVertexFormat(VertexStreamFormat::None), 0U);
+}
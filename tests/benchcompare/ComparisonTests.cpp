@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Comparison.hpp"
+#include "Statistics.hpp"
+
+namespace
+{
+    /// Benchmark times around mean with multiplicative noise and occasional
+    /// outliers, as scheduling hiccups produce.
+    std::vector<double> noisySamples(std::mt19937& random, double mean, size_t count)
+    {
+        std::normal_distribution<double>      noise(1.0, 0.03);
+        std::uniform_real_distribution<double> outlier(0.0, 1.0);
+        std::vector<double>                    samples;
+        for (size_t i = 0; i < count; i++)
+        {
+            const double spike = outlier(random) < 0.1 ? 1.5 : 1.0;
+            samples.push_back(mean * noise(random) * spike);
+        }
+        return samples;
+    }
+
+    BenchCompare::Verdict compareOne(
+        const std::vector<double>& baseline, const std::vector<double>& contender)
+    {
+        const BenchCompare::SampleSet baselineSet { { "Bench", baseline } };
+        const BenchCompare::SampleSet contenderSet { { "Bench", contender } };
+        return BenchCompare::compare(baselineSet, contenderSet, {}, {}).front().verdict;
+    }
+} // namespace
+
+TEST(Statistics, ExactPValueOfSeparatedSamples)
+{
+    const std::vector<double> low { 100, 101, 102, 103, 104 };
+    const std::vector<double> high { 200, 201, 202, 203, 204 };
+    const auto                result = Statistics::mannWhitneyU(low, high);
+    ASSERT_TRUE(result.valid);
+    EXPECT_TRUE(result.exact);
+    EXPECT_DOUBLE_EQ(result.u, 0.0);
+    EXPECT_NEAR(result.pValue, 2.0 / 252.0, 1e-12);
+    EXPECT_NEAR(Statistics::minimumPValue(5, 5), 2.0 / 252.0, 1e-12);
+}
+
+TEST(Statistics, ExactPValueMatchesEnumeration)
+{
+    // U = 2 for 3 vs 3: the orderings with U <= 2 are 1 + 1 + 2 of 20
+    const std::vector<double> a { 1, 2, 5 };
+    const std::vector<double> b { 3, 4, 6 };
+    const auto                result = Statistics::mannWhitneyU(a, b);
+    ASSERT_TRUE(result.exact);
+    EXPECT_DOUBLE_EQ(result.u, 2.0);
+    EXPECT_NEAR(result.pValue, 2.0 * 4.0 / 20.0, 1e-12);
+}
+
+TEST(Statistics, TiesUseTheNormalApproximation)
+{
+    const std::vector<double> a { 1, 1, 2, 3, 4 };
+    const std::vector<double> b { 1, 5, 6, 7, 8 };
+    const auto                result = Statistics::mannWhitneyU(a, b);
+    ASSERT_TRUE(result.valid);
+    EXPECT_FALSE(result.exact);
+    EXPECT_GT(result.pValue, 0.0);
+    EXPECT_LT(result.pValue, 1.0);
+}
+
+TEST(BenchCompare, DoubledRuntimeWithThreeSamplesIsUndecided)
+{
+    // No ordering of 3 vs 3 samples reaches p < 0.05, so this must not pass
+    const auto verdict = compareOne({ 100, 101, 102 }, { 200, 201, 202 });
+    EXPECT_EQ(verdict, BenchCompare::Verdict::Undecided);
+    EXPECT_TRUE(BenchCompare::failsGate(verdict));
+}
+
+TEST(BenchCompare, HalvedRuntimeWithOneSampleDoesNotFail)
+{
+    // A single-repetition run that got faster cannot be confirmed, but must not fail
+    const auto verdict = compareOne({ 100 }, { 50 });
+    EXPECT_EQ(verdict, BenchCompare::Verdict::Noisy);
+    EXPECT_FALSE(BenchCompare::failsGate(verdict));
+    EXPECT_TRUE(BenchCompare::failsGate(compareOne({ 100 }, { 200 })));
+}
+
+TEST(BenchCompare, DoubledRuntimeWithFiveSamplesRegresses)
+{
+    const auto verdict = compareOne({ 100, 101, 102, 99, 103 }, { 200, 201, 202, 199, 203 });
+    EXPECT_EQ(verdict, BenchCompare::Verdict::Regressed);
+    EXPECT_TRUE(BenchCompare::failsGate(verdict));
+}
+
+TEST(BenchCompare, MinSamplesBelowReachableSignificanceIsUndecided)
+{
+    // Even when allowed, 3 vs 3 cannot reach alpha
+    BenchCompare::CompareOptions options;
+    options.minSamples = 2;
+    BenchCompare::Comparison comparison;
+    comparison.baseline = { 100, 101, 102 };
+    comparison.contender = { 200, 201, 202 };
+    comparison.change = 1.0;
+    comparison.threshold = 0.05;
+    comparison.test = Statistics::mannWhitneyU(comparison.baseline, comparison.contender);
+    EXPECT_EQ(BenchCompare::judge(comparison, options), BenchCompare::Verdict::Undecided);
+}
+
+TEST(BenchCompare, NoisyDataWithoutShiftRarelyFails)
+{
+    std::mt19937 random(7);
+    size_t       failures = 0;
+    for (size_t run = 0; run < 200; run++)
+    {
+        const auto verdict
+            = compareOne(noisySamples(random, 1000.0, 10), noisySamples(random, 1000.0, 10));
+        failures += BenchCompare::failsGate(verdict) ? 1 : 0;
+    }
+    // Significance at 0.05 and a 5% threshold together keep false alarms rare
+    EXPECT_LE(failures, 4U);
+}
+
+TEST(BenchCompare, ShiftedNoisyDataRegresses)
+{
+    std::mt19937 random(11);
+    size_t       detected = 0;
+    for (size_t run = 0; run < 100; run++)
+    {
+        const auto verdict
+            = compareOne(noisySamples(random, 1000.0, 10), noisySamples(random, 1200.0, 10));
+        detected += verdict == BenchCompare::Verdict::Regressed ? 1 : 0;
+    }
+    // Outliers hide the shift now and then; most runs must still catch it
+    EXPECT_GE(detected, 85U);
+}
+
+TEST(BenchCompare, ShiftedNoisyDataImproves)
+{
+    std::mt19937 random(13);
+    const auto   verdict
+        = compareOne(noisySamples(random, 1000.0, 12), noisySamples(random, 700.0, 12));
+    EXPECT_EQ(verdict, BenchCompare::Verdict::Improved);
+    EXPECT_FALSE(BenchCompare::failsGate(verdict));
+}
+
+TEST(BenchCompare, ChangeWithinThresholdIsUnchanged)
+{
+    const auto verdict = compareOne({ 100, 101, 102, 99, 103 }, { 102, 103, 104, 101, 105 });
+    EXPECT_EQ(verdict, BenchCompare::Verdict::Unchanged);
+}
+
+TEST(BenchCompare, PerBenchmarkThresholds)
+{
+    const std::vector<BenchCompare::ThresholdRule> rules {
+        { std::regex("Arena/.*"), 0.5 },
+        { std::regex(".*"), 0.01 },
+    };
+    EXPECT_DOUBLE_EQ(BenchCompare::thresholdFor("Arena/Reset", rules, 0.05), 0.5);
+    EXPECT_DOUBLE_EQ(BenchCompare::thresholdFor("Ring/Allocate", rules, 0.05), 0.01);
+    EXPECT_DOUBLE_EQ(BenchCompare::thresholdFor("Ring/Allocate", {}, 0.05), 0.05);
+
+    // A 20% slowdown passes under the lenient rule
+    const BenchCompare::SampleSet baseline { { "Arena/Reset", { 100, 101, 102, 99, 103 } } };
+    const BenchCompare::SampleSet contender { { "Arena/Reset", { 120, 121, 122, 119, 123 } } };
+    const auto comparisons = BenchCompare::compare(baseline, contender, rules, {});
+    EXPECT_EQ(comparisons.front().verdict, BenchCompare::Verdict::Unchanged);
+}
+
+TEST(BenchCompare, AddedAndRemovedBenchmarksDoNotFail)
+{
+    const BenchCompare::SampleSet baseline { { "Old", { 1, 2, 3 } } };
+    const BenchCompare::SampleSet contender { { "New", { 1, 2, 3 } } };
+    const auto comparisons = BenchCompare::compare(baseline, contender, {}, {});
+    ASSERT_EQ(comparisons.size(), 2U);
+    EXPECT_EQ(comparisons[0].verdict, BenchCompare::Verdict::Removed);
+    EXPECT_EQ(comparisons[1].verdict, BenchCompare::Verdict::Added);
+    EXPECT_FALSE(BenchCompare::failsGate(comparisons[0].verdict));
+    EXPECT_FALSE(BenchCompare::failsGate(comparisons[1].verdict));
+}
+
+TEST(BenchCompare, LoadsGoogleBenchmarkRepetitions)
+{
+    const auto document = Json::parse(R"({ "benchmarks": [
+        { "name": "A/repeats:2", "run_name": "A", "run_type": "iteration",
+          "real_time": 1.5, "cpu_time": 1.0, "time_unit": "us" },
+        { "name": "A/repeats:2", "run_name": "A", "run_type": "iteration",
+          "real_time": 2.5, "cpu_time": 2.0, "time_unit": "us" },
+        { "name": "A_mean", "run_name": "A", "run_type": "aggregate",
+          "real_time": 2.0, "cpu_time": 1.5, "time_unit": "us" },
+        { "name": "B", "samples": [ 1, 2, 3 ], "unit": "ms" }
+    ] })");
+
+    const auto realTime = BenchCompare::loadSamples(document, "real_time");
+    ASSERT_EQ(realTime.size(), 2U);
+    EXPECT_EQ(realTime.at("A"), (std::vector<double> { 1500.0, 2500.0 }));
+    EXPECT_EQ(realTime.at("B"), (std::vector<double> { 1.0e6, 2.0e6, 3.0e6 }));
+
+    const auto cpuTime = BenchCompare::loadSamples(document, "cpu_time");
+    EXPECT_EQ(cpuTime.at("A"), (std::vector<double> { 1000.0, 2000.0 }));
+}
+
+TEST(BenchCompare, UnknownTimeUnitThrows)
+{
+    const auto document
+        = Json::parse(R"({ "benchmarks": [ { "name": "A", "samples": [ 1 ], "unit": "ps" } ] })");
+    EXPECT_THROW(static_cast<void>(BenchCompare::loadSamples(document, "real_time")),
+        std::runtime_error);
+}
@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+/// @brief Empty directory named after the running test, removed with its contents
+/// when the object goes out of scope.
+class TemporaryDirectory
+{
+public:
+    TemporaryDirectory()
+    {
+        const auto* test = testing::UnitTest::GetInstance()->current_test_info();
+        m_path = std::filesystem::temp_directory_path()
+            / std::format("{}.{}", test->test_suite_name(), test->name());
+        std::filesystem::remove_all(m_path);
+        std::filesystem::create_directories(m_path);
+    }
+
+    ~TemporaryDirectory()
+    {
+        std::error_code ignored;
+        std::filesystem::remove_all(m_path, ignored);
+    }
+
+    TemporaryDirectory(const TemporaryDirectory&) = delete;
+    TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+
+    [[nodiscard]] const std::filesystem::path& path() const
+    {
+        return m_path;
+    }
+
+    /// @brief Writes contents to a file relative to the directory, creating parent
+    /// directories, and returns its path.
+    std::filesystem::path write(
+        const std::filesystem::path& relativePath, const std::string_view contents) const
+    {
+        const auto path = m_path / relativePath;
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        if (!stream)
+        {
+            throw std::runtime_error(std::format("Failed to write {}", path.string()));
+        }
+        return path;
+    }
+
+private:
+    std::filesystem::path m_path;
+};
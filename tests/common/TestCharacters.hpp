@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+#include "SceneLoader.hpp"
+
+namespace Tests
+{
+    inline Assets::Matrix4 translationMatrix(const std::array<float, 3>& offset)
+    {
+        Assets::Matrix4 matrix {};
+        matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0F;
+        std::copy(offset.begin(), offset.end(), matrix.begin() + 12);
+        return matrix;
+    }
+
+    /// @brief Skinned character: a root with limbCount straight limbs of limbJoints
+    /// joints each, all in skin 0, and a one second clip sampled keyCount times.
+    ///
+    /// The root bobs, every limb joint swings about an axis of its own, and the tip
+    /// of each limb pulses in scale. Bones are 0.1 units long.
+    inline Assets::Scene createCharacter(
+        const uint32_t limbCount, const uint32_t limbJoints, const uint32_t keyCount = 31)
+    {
+        constexpr float boneLength = 0.1F;
+        const float     pi = std::numbers::pi_v<float>;
+
+        Assets::Scene     scene;
+        Assets::Skin      skin;
+        Assets::Animation animation { .name = "swing", .channels = {}, .duration = 1.0F };
+        const auto        keyTime = [keyCount](const uint32_t key) {
+            return static_cast<float>(key) / static_cast<float>(keyCount - 1);
+        };
+        const auto addJoint = [&](const int32_t parent, const std::array<float, 3>& offset,
+                                  const std::array<float, 3>& bindPosition) {
+            const auto   index = static_cast<int32_t>(scene.nodes.size());
+            Assets::Node node;
+            node.parent = parent;
+            node.translation = offset;
+            node.localTransform = translationMatrix(offset);
+            if (parent >= 0)
+            {
+                scene.nodes[parent].children.push_back(index);
+            }
+            scene.nodes.push_back(std::move(node));
+            skin.joints.push_back(index);
+            skin.inverseBindMatrices.push_back(
+                translationMatrix({ -bindPosition[0], -bindPosition[1], -bindPosition[2] }));
+            return index;
+        };
+
+        addJoint(-1, {}, {});
+        scene.rootNodes.push_back(0);
+        Assets::AnimationChannel bob;
+        bob.node = 0;
+        bob.path = Assets::AnimationPath::Translation;
+        for (uint32_t key = 0; key < keyCount; key++)
+        {
+            const float time = keyTime(key);
+            bob.times.push_back(time);
+            bob.values.insert(
+                bob.values.end(), { 0.2F * time, 0.05F * std::sin(2.0F * pi * time), 0.0F });
+        }
+        animation.channels.push_back(std::move(bob));
+
+        for (uint32_t limb = 0; limb < limbCount; limb++)
+        {
+            const float angle
+                = 2.0F * pi * static_cast<float>(limb) / static_cast<float>(limbCount);
+            const std::array<float, 3> direction { std::cos(angle), std::sin(angle), 0.0F };
+            int32_t                    parent = 0;
+            for (uint32_t segment = 0; segment < limbJoints; segment++)
+            {
+                const float reach = boneLength * static_cast<float>(segment + 1);
+                parent = addJoint(parent,
+                    { direction[0] * boneLength, direction[1] * boneLength, 0.0F },
+                    { direction[0] * reach, direction[1] * reach, 0.0F });
+
+                // Swing about a tilted axis, each joint a little behind its parent
+                const float                tilt = 0.3F * static_cast<float>(limb % 3);
+                const std::array<float, 3> axis { 0.0F, std::sin(tilt), std::cos(tilt) };
+                const float phase = static_cast<float>(segment) * 0.4F + static_cast<float>(limb);
+                Assets::AnimationChannel swing;
+                swing.node = parent;
+                swing.path = Assets::AnimationPath::Rotation;
+                for (uint32_t key = 0; key < keyCount; key++)
+                {
+                    const float time = keyTime(key);
+                    const float half = 0.2F * std::sin(2.0F * pi * time + phase);
+                    swing.times.push_back(time);
+                    swing.values.insert(swing.values.end(), { axis[0] * std::sin(half),
+                        axis[1] * std::sin(half), axis[2] * std::sin(half), std::cos(half) });
+                }
+                animation.channels.push_back(std::move(swing));
+            }
+
+            Assets::AnimationChannel pulse;
+            pulse.node = parent;
+            pulse.path = Assets::AnimationPath::Scale;
+            for (uint32_t key = 0; key < keyCount; key++)
+            {
+                const float time = keyTime(key);
+                const float scale = 1.0F + 0.25F * std::sin(2.0F * pi * time);
+                pulse.times.push_back(time);
+                pulse.values.insert(pulse.values.end(), { scale, scale, scale });
+            }
+            animation.channels.push_back(std::move(pulse));
+        }
+
+        scene.skins.push_back(std::move(skin));
+        scene.animations.push_back(std::move(animation));
+        return scene;
+    }
+} // namespace Tests
@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+#include "SceneLoader.hpp"
+
+namespace Tests
+{
+    /// @brief Grid of size x size quads over [0, 1] in the xz plane, displaced along y
+    /// by a sine wave of the given amplitude, as streams with every float attribute.
+    inline Assets::Primitive createGrid(const uint32_t size, const float amplitude = 0.0F)
+    {
+        Assets::Primitive      primitive;
+        Assets::VertexStreams& streams = primitive.streams;
+        const float            frequency = 2.0F * std::numbers::pi_v<float>;
+        for (uint32_t z = 0; z <= size; z++)
+        {
+            for (uint32_t x = 0; x <= size; x++)
+            {
+                const float u = static_cast<float>(x) / static_cast<float>(size);
+                const float v = static_cast<float>(z) / static_cast<float>(size);
+                const float slope = amplitude * frequency * std::cos(frequency * u);
+                const float length = std::sqrt(slope * slope + 1.0F);
+                streams.positions.push_back({ u, amplitude * std::sin(frequency * u), v });
+                streams.normals.push_back({ -slope / length, 1.0F / length, 0.0F });
+                streams.texCoords.push_back({ u, v });
+                streams.tangents.push_back({ 1.0F / length, slope / length, 0.0F, 1.0F });
+                streams.colors.push_back({ u, v, 1.0F - u, 1.0F });
+            }
+        }
+        for (uint32_t z = 0; z < size; z++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const uint32_t corner = z * (size + 1) + x;
+                const uint32_t below = corner + size + 1;
+                primitive.indices.insert(primitive.indices.end(),
+                    { corner, below, corner + 1, corner + 1, below, below + 1 });
+            }
+        }
+        primitive.boundsMin = { 0.0F, -amplitude, 0.0F };
+        primitive.boundsMax = { 1.0F, amplitude, 1.0F };
+        return primitive;
+    }
+
+    /// @brief Closed unit sphere of rings x segments quads, as streams with positions,
+    /// normals and texture coordinates. Seam and pole vertices are shared, so the
+    /// surface has no borders.
+    inline Assets::Primitive createSphere(const uint32_t rings, const uint32_t segments)
+    {
+        Assets::Primitive      primitive;
+        Assets::VertexStreams& streams = primitive.streams;
+        const auto             add = [&streams](const float theta, const float phi) {
+            const std::array<float, 3> direction { std::sin(theta) * std::cos(phi),
+                std::cos(theta), std::sin(theta) * std::sin(phi) };
+            streams.positions.push_back(direction);
+            streams.normals.push_back(direction);
+            streams.texCoords.push_back({ phi / (2.0F * std::numbers::pi_v<float>),
+                theta / std::numbers::pi_v<float> });
+        };
+
+        // North pole, rings - 1 rows of segments vertices, south pole
+        add(0.0F, 0.0F);
+        for (uint32_t ring = 1; ring < rings; ring++)
+        {
+            for (uint32_t segment = 0; segment < segments; segment++)
+            {
+                add(std::numbers::pi_v<float> * static_cast<float>(ring)
+                        / static_cast<float>(rings),
+                    2.0F * std::numbers::pi_v<float> * static_cast<float>(segment)
+                        / static_cast<float>(segments));
+            }
+        }
+        add(std::numbers::pi_v<float>, 0.0F);
+
+        const uint32_t south = static_cast<uint32_t>(streams.positions.size()) - 1;
+        const auto     vertex = [segments](const uint32_t ring, const uint32_t segment) {
+            return 1 + (ring - 1) * segments + segment % segments;
+        };
+        auto& indices = primitive.indices;
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            indices.insert(indices.end(), { 0, vertex(1, segment + 1), vertex(1, segment) });
+            indices.insert(indices.end(),
+                { south, vertex(rings - 1, segment), vertex(rings - 1, segment + 1) });
+        }
+        for (uint32_t ring = 1; ring + 1 < rings; ring++)
+        {
+            for (uint32_t segment = 0; segment < segments; segment++)
+            {
+                const uint32_t a = vertex(ring, segment);
+                const uint32_t b = vertex(ring, segment + 1);
+                const uint32_t c = vertex(ring + 1, segment);
+                const uint32_t d = vertex(ring + 1, segment + 1);
+                indices.insert(indices.end(), { a, b, c, b, d, c });
+            }
+        }
+        primitive.boundsMin = { -1.0F, -1.0F, -1.0F };
+        primitive.boundsMax = { 1.0F, 1.0F, 1.0F };
+        return primitive;
+    }
+} // namespace Tests
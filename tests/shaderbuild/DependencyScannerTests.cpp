@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "DependencyScanner.hpp"
+#include "TemporaryDirectory.hpp"
+
+TEST(DependencyScanner, StripsCommentsButNotStrings)
+{
+    const auto stripped
+        = ShaderBuild::stripComments("a // line\nb /* block\nspans */ c \"// kept\"");
+    EXPECT_EQ(stripped.find("line"), std::string::npos);
+    EXPECT_EQ(stripped.find("spans"), std::string::npos);
+    EXPECT_NE(stripped.find("\"// kept\""), std::string::npos);
+    EXPECT_EQ(std::ranges::count(stripped, '\n'), 2);
+}
+
+TEST(DependencyScanner, ParsesIncludeDirectives)
+{
+    const auto includes = ShaderBuild::parseIncludes("#include \"a.h\"\n"
+                                                     "  #  include <metal_stdlib>\n"
+                                                     "// #include \"commented.h\"\n"
+                                                     "/* #include \"block.h\" */\n"
+                                                     "#if 0\n#include \"disabled.h\"\n#endif\n");
+    ASSERT_EQ(includes.size(), 3U);
+    EXPECT_EQ(includes[0].name, "a.h");
+    EXPECT_TRUE(includes[0].quoted);
+    EXPECT_EQ(includes[1].name, "metal_stdlib");
+    EXPECT_FALSE(includes[1].quoted);
+    EXPECT_EQ(includes[2].name, "disabled.h");
+}
+
+TEST(DependencyScanner, FindsTransitiveIncludes)
+{
+    TemporaryDirectory directory;
+    const auto source = directory.write("shaders/main.metal",
+        "#include <metal_stdlib>\n#include \"local.h\"\n#include <Shared.h>\n");
+    directory.write("shaders/local.h", "#include \"sub/deep.h\"\n");
+    directory.write("shaders/sub/deep.h", "#include \"../local.h\"\n"); // A cycle
+    directory.write("include/Shared.h", "#pragma once\n");
+
+    ShaderBuild::DependencyScanner scanner({ directory.path() / "include" });
+    const auto                     dependencies = scanner.dependencies(source);
+
+    std::vector<std::string> names;
+    for (const auto& dependency : dependencies)
+    {
+        names.push_back(dependency.lexically_relative(directory.path()).generic_string());
+    }
+    EXPECT_EQ(names,
+        (std::vector<std::string> { "include/Shared.h", "shaders/local.h", "shaders/sub/deep.h" }));
+}
+
+TEST(DependencyScanner, LocalIncludesShadowIncludeDirectories)
+{
+    TemporaryDirectory directory;
+    const auto source = directory.write("shaders/main.metal", "#include \"Shared.h\"\n");
+    directory.write("shaders/Shared.h", "\n");
+    directory.write("include/Shared.h", "\n");
+
+    ShaderBuild::DependencyScanner scanner({ directory.path() / "include" });
+    const auto                     dependencies = scanner.dependencies(source);
+    ASSERT_EQ(dependencies.size(), 1U);
+    EXPECT_EQ(dependencies.front().parent_path().filename(), "shaders");
+}
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "BuildCache.hpp"
+#include "IncrementalBuild.hpp"
+#include "TemporaryDirectory.hpp"
+
+namespace
+{
+    /// Builds a.metal and b.metal, which share common.h, with a stub compiler that
+    /// writes the defines and the source into the object and a linker that
+    /// concatenates the objects.
+    class IncrementalBuildTest : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            m_a = m_directory.write("shaders/a.metal", "#include \"common.h\"\nA\n");
+            m_b = m_directory.write("shaders/b.metal", "#include <metal_stdlib>\nB\n");
+            m_directory.write("shaders/common.h", "#include \"nested/types.h\"\ncommon\n");
+            m_directory.write("shaders/nested/types.h", "types\n");
+
+            m_options.outputPath = m_directory.path() / "default.metallib";
+            m_options.cacheDirectory = m_directory.path() / "cache";
+            m_options.compileCommand = "{ echo {defines}; cat {input}; } > {output}";
+            m_options.linkCommand = "cat {inputs} > {output}";
+            m_options.jobs = 2;
+        }
+
+        ShaderBuild::BuildResult build(std::vector<ShaderBuild::Define> aDefines = {})
+        {
+            ShaderBuild::DependencyScanner scanner({});
+            auto                           a = ShaderBuild::defaultUnit(m_a);
+            a.defines = std::move(aDefines);
+            return ShaderBuild::build(m_options, { a, ShaderBuild::defaultUnit(m_b) }, scanner);
+        }
+
+        [[nodiscard]] std::string library() const
+        {
+            return ShaderBuild::readFile(m_options.outputPath);
+        }
+
+        TemporaryDirectory        m_directory;
+        ShaderBuild::BuildOptions m_options;
+        std::filesystem::path     m_a;
+        std::filesystem::path     m_b;
+    };
+} // namespace
+
+TEST_F(IncrementalBuildTest, FirstBuildCompilesAndLinksEverything)
+{
+    const auto result = build();
+    EXPECT_EQ(result.units.size(), 2U);
+    EXPECT_EQ(result.compiled, 2U);
+    EXPECT_TRUE(result.linked);
+    EXPECT_EQ(library(), "\n#include \"common.h\"\nA\n\n#include <metal_stdlib>\nB\n");
+
+    ASSERT_EQ(result.units[0].dependencies.size(), 2U);
+    EXPECT_EQ(result.units[0].dependencies[0].filename(), "common.h");
+    EXPECT_EQ(result.units[0].dependencies[1].filename(), "types.h");
+    EXPECT_TRUE(result.units[1].dependencies.empty());
+}
+
+TEST_F(IncrementalBuildTest, UnchangedInputsDoNothing)
+{
+    static_cast<void>(build());
+    const auto modified = std::filesystem::last_write_time(m_options.outputPath);
+
+    const auto result = build();
+    EXPECT_EQ(result.compiled, 0U);
+    EXPECT_FALSE(result.linked);
+    EXPECT_TRUE(result.units[0].cached && result.units[1].cached);
+    EXPECT_EQ(std::filesystem::last_write_time(m_options.outputPath), modified);
+}
+
+TEST_F(IncrementalBuildTest, IncludeChangeRecompilesOnlyDependents)
+{
+    static_cast<void>(build());
+    m_directory.write("shaders/nested/types.h", "types changed\n");
+
+    const auto result = build();
+    EXPECT_EQ(result.compiled, 1U);
+    EXPECT_FALSE(result.units[0].cached);
+    EXPECT_TRUE(result.units[1].cached);
+    EXPECT_TRUE(result.linked);
+}
+
+TEST_F(IncrementalBuildTest, RevertedSourceReusesCachedObject)
+{
+    static_cast<void>(build());
+    m_directory.write("shaders/b.metal", "B2\n");
+    EXPECT_EQ(build().compiled, 1U);
+    EXPECT_EQ(library(), "\n#include \"common.h\"\nA\n\nB2\n");
+
+    m_directory.write("shaders/b.metal", "#include <metal_stdlib>\nB\n");
+    const auto result = build();
+    EXPECT_EQ(result.compiled, 0U);
+    EXPECT_TRUE(result.linked);
+    EXPECT_EQ(library(), "\n#include \"common.h\"\nA\n\n#include <metal_stdlib>\nB\n");
+}
+
+TEST_F(IncrementalBuildTest, DefinesAndCommandsArePartOfTheKey)
+{
+    static_cast<void>(build());
+
+    auto result = build({ { "ALPHA_BLEND", "1" } });
+    EXPECT_EQ(result.compiled, 1U);
+    EXPECT_TRUE(library().starts_with("-DALPHA_BLEND=1\n"));
+
+    m_options.compileCommand = "{ echo v2 {defines}; cat {input}; } > {output}";
+    result = build({ { "ALPHA_BLEND", "1" } });
+    EXPECT_EQ(result.compiled, 2U);
+}
+
+TEST_F(IncrementalBuildTest, MissingLibraryIsRelinkedWithoutCompiling)
+{
+    static_cast<void>(build());
+    std::filesystem::remove(m_options.outputPath);
+
+    const auto result = build();
+    EXPECT_EQ(result.compiled, 0U);
+    EXPECT_TRUE(result.linked);
+    EXPECT_TRUE(std::filesystem::exists(m_options.outputPath));
+}
+
+TEST_F(IncrementalBuildTest, FailedCompileKeepsTheLibrary)
+{
+    static_cast<void>(build());
+    const std::string previous = library();
+
+    m_directory.write("shaders/a.metal", "#include \"common.h\"\nA2\n");
+    m_options.compileCommand = "grep -q A2 {input} && exit 1; cat {input} > {output}";
+    EXPECT_THROW(static_cast<void>(build()), std::runtime_error);
+    EXPECT_EQ(library(), previous);
+
+    // No partial object is left behind to be mistaken for a cached one
+    for (const auto& file : std::filesystem::directory_iterator(m_options.cacheDirectory))
+    {
+        EXPECT_NE(file.path().extension(), ".tmp");
+    }
+}
+
+TEST(IncrementalBuild, ShellQuoteEscapesSingleQuotes)
+{
+    EXPECT_EQ(ShaderBuild::shellQuote("plain"), "'plain'");
+    EXPECT_EQ(ShaderBuild::shellQuote("it's"), "'it'\\''s'");
+}
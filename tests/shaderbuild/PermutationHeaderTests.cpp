@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "BuildCache.hpp"
+#include "Json.hpp"
+#include "PermutationHeader.hpp"
+#include "ShaderManifest.hpp"
+#include "ShaderPermutations.hpp"
+#include "TemporaryDirectory.hpp"
+
+namespace
+{
+    namespace Textures = ShaderPermutations::Textures;
+    namespace Instancing = ShaderPermutations::Instancing;
+
+    /// The repository's manifest, which ShaderPermutations.hpp was generated from.
+    std::vector<ShaderBuild::ShaderEntry> repositoryManifest()
+    {
+        const std::filesystem::path path = SHADER_MANIFEST;
+        return ShaderBuild::parseManifest(
+            Json::parse(ShaderBuild::readFile(path)), path.parent_path());
+    }
+
+    const ShaderBuild::ShaderEntry& findEntry(
+        const std::vector<ShaderBuild::ShaderEntry>& entries, const std::string& name)
+    {
+        const auto it = std::ranges::find(entries, name, &ShaderBuild::ShaderEntry::name);
+        EXPECT_NE(it, entries.end()) << name;
+        return *it;
+    }
+
+    // Default features select the variant Xcode builds, the first of every axis
+    static_assert(Textures::permutationKey({}) == 0);
+    static_assert(Instancing::permutationKey({}) == 0);
+} // namespace
+
+TEST(PermutationHeader, KeysNumberVariantsInExpansionOrder)
+{
+    const auto  entries = repositoryManifest();
+    const auto& textures = findEntry(entries, "Textures");
+    ASSERT_EQ(textures.permutationCount(), Textures::g_permutationCount);
+
+    for (uint32_t key = 0; key < Textures::g_permutationCount; key++)
+    {
+        const auto values = textures.permutationValues(key);
+        ASSERT_EQ(values.size(), 2U);
+        EXPECT_EQ(Textures::permutationKey({ .ALPHA_BLEND = values[0], .MSAA = values[1] }), key);
+        EXPECT_EQ(Textures::g_permutationSuffixes[key], textures.permutationSuffix(key));
+    }
+
+    const auto& instancing = findEntry(entries, "Instancing");
+    ASSERT_EQ(instancing.permutationCount(), Instancing::g_permutationCount);
+    for (uint32_t key = 0; key < Instancing::g_permutationCount; key++)
+    {
+        EXPECT_EQ(Instancing::g_permutationSuffixes[key], instancing.permutationSuffix(key));
+    }
+}
+
+TEST(PermutationHeader, UncompiledFeaturesHaveNoKey)
+{
+    EXPECT_EQ(Textures::permutationKey({ .MSAA = 2 }), Textures::g_permutationCount);
+    EXPECT_EQ(Textures::permutationKey({ .ALPHA_BLEND = 2 }), Textures::g_permutationCount);
+    EXPECT_EQ(Instancing::permutationKey({ .INSTANCE_ENCODING = -1 }),
+        Instancing::g_permutationCount);
+}
+
+TEST(PermutationHeader, FunctionNamesCarryTheSuffix)
+{
+    const uint32_t key = Textures::permutationKey({ .ALPHA_BLEND = 0, .MSAA = 4 });
+    EXPECT_EQ(Textures::functionName("texture_fragment", key),
+        "texture_fragment_ALPHA_BLEND_0_MSAA_4");
+    EXPECT_THROW(static_cast<void>(Textures::functionName("texture_fragment",
+                     Textures::g_permutationCount)),
+        std::out_of_range);
+}
+
+TEST(PermutationHeader, GeneratesConstantsAndKeys)
+{
+    TemporaryDirectory directory;
+    directory.write("a.metal", "\n");
+    const auto entries = ShaderBuild::parseManifest(
+        Json::parse(R"({ "shaders": [ { "source": "a.metal", "name": "A",
+            "defines": { "COUNT": 3, "MODE": "fast" },
+            "permutations": { "SAMPLES": [ 4, 1 ], "BLEND": [ false, true ] } } ] })"),
+        directory.path());
+    const std::string header = ShaderBuild::generatePermutationHeader(entries, "test.json");
+
+    EXPECT_NE(header.find("// Generated by shaderbuild from test.json."), std::string::npos);
+    EXPECT_NE(header.find("namespace A"), std::string::npos);
+    EXPECT_NE(header.find("inline constexpr int64_t COUNT = 3;"), std::string::npos);
+    EXPECT_NE(header.find("inline constexpr std::string_view MODE = \"fast\";"),
+        std::string::npos);
+    EXPECT_NE(header.find("int64_t BLEND = 0;"), std::string::npos);
+    EXPECT_NE(header.find("int64_t SAMPLES = 4;"), std::string::npos);
+    EXPECT_NE(header.find("g_permutationCount = 4;"), std::string::npos);
+    EXPECT_LT(header.find("\"_BLEND_0_SAMPLES_4\""), header.find("\"_BLEND_0_SAMPLES_1\""));
+    EXPECT_LT(header.find("\"_BLEND_0_SAMPLES_1\""), header.find("\"_BLEND_1_SAMPLES_4\""));
+}
+
+TEST(PermutationHeader, EntriesWithoutPermutationsOnlyGetConstants)
+{
+    TemporaryDirectory directory;
+    directory.write("a.metal", "\n");
+    const auto entries = ShaderBuild::parseManifest(
+        Json::parse(R"({ "shaders": [ { "source": "a.metal", "name": "Plain",
+            "defines": { "COUNT": 3 } } ] })"),
+        directory.path());
+    const std::string header = ShaderBuild::generatePermutationHeader(entries, "test.json");
+
+    EXPECT_NE(header.find("namespace Plain"), std::string::npos);
+    EXPECT_EQ(header.find("permutationKey"), std::string::npos);
+}
@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Json.hpp"
+#include "ShaderLayout.hpp"
+#include "ShaderManifest.hpp"
+#include "ShaderReflection.hpp"
+#include "TemporaryDirectory.hpp"
+
+namespace
+{
+    ShaderBuild::StructLayout parseOne(
+        const std::string& source, const ShaderBuild::Constants& constants = {})
+    {
+        auto layouts = ShaderBuild::parseStructLayouts(source, constants);
+        EXPECT_EQ(layouts.size(), 1U);
+        return layouts.empty() ? ShaderBuild::StructLayout {} : layouts.front();
+    }
+
+    void expectMember(const ShaderBuild::StructLayout& layout, const std::string& name,
+        const size_t offset, const size_t size)
+    {
+        const auto* member = layout.find(name);
+        ASSERT_NE(member, nullptr) << name;
+        EXPECT_EQ(member->offset, offset) << name;
+        EXPECT_EQ(member->size, size) << name;
+    }
+} // namespace
+
+TEST(ShaderLayout, AlignsVectorsAndPadsThreeComponentOnes)
+{
+    const auto layout = parseOne(R"(
+        struct Vertex {
+            float4 position [[position]];
+            float3 normal;
+            half2 uv;
+            packed_float3 tangent;
+            uchar4 color;
+        };)");
+    EXPECT_TRUE(layout.error.empty()) << layout.error;
+    expectMember(layout, "position", 0, 16);
+    expectMember(layout, "normal", 16, 16);
+    expectMember(layout, "uv", 32, 4);
+    expectMember(layout, "tangent", 36, 12);
+    expectMember(layout, "color", 48, 4);
+    EXPECT_EQ(layout.alignment, 16U);
+    EXPECT_EQ(layout.size, 64U);
+}
+
+TEST(ShaderLayout, MatricesAreColumnsOfVectors)
+{
+    const auto layout = parseOne(R"(
+        struct Uniforms {
+            float scale;
+            float3x3 normalMatrix;
+            half2x2 rotation;
+            float4x4 transform;
+        };)");
+    expectMember(layout, "normalMatrix", 16, 48);
+    expectMember(layout, "rotation", 64, 8);
+    expectMember(layout, "transform", 80, 64);
+    EXPECT_EQ(layout.size, 144U);
+}
+
+TEST(ShaderLayout, ArgumentBufferArraysUseConstants)
+{
+    const auto layout = parseOne(R"(
+        #define UNUSED 1
+        typedef struct
+        {
+            array<texture2d<half>, TEXTURE_COUNT> textures;
+            sampler samplers[2];
+            device float4x4* transforms;
+            constant uint& count;
+        } ArgumentBuffer;)",
+        { { "TEXTURE_COUNT", 5 } });
+    EXPECT_EQ(layout.name, "ArgumentBuffer");
+    expectMember(layout, "textures", 0, 40);
+    expectMember(layout, "samplers", 40, 16);
+    expectMember(layout, "transforms", 56, 8);
+    expectMember(layout, "count", 64, 8);
+    EXPECT_EQ(layout.size, 72U);
+    EXPECT_EQ(layout.find("textures")->type, "array<texture2d<half>, 5>");
+}
+
+TEST(ShaderLayout, StructsFromIncludesAndEarlierDeclarationsNest)
+{
+    const auto included = ShaderBuild::parseStructLayouts("struct Light { float3 color; };", {});
+    const auto layouts = ShaderBuild::parseStructLayouts(R"(
+        struct Pair { char a; short b; };
+        struct Scene {
+            Pair pair;
+            struct Light lights[2][3];
+            uint count;
+        };)",
+        {}, included);
+    ASSERT_EQ(layouts.size(), 2U); // Only the structs the source declares
+    const auto& scene = layouts[1];
+    EXPECT_TRUE(scene.error.empty()) << scene.error;
+    expectMember(scene, "pair", 0, 4);
+    expectMember(scene, "lights", 16, 96);
+    expectMember(scene, "count", 112, 4);
+    EXPECT_EQ(scene.size, 128U);
+}
+
+TEST(ShaderLayout, UnknownTypesOnlyFailTheirStruct)
+{
+    const auto layouts = ShaderBuild::parseStructLayouts(R"(
+        struct Bad { mystery_t value; };
+        struct UsesBad { Bad bad; };
+        struct Good { int a, b; };
+        struct Sized { float values[COUNT]; };)",
+        {});
+    ASSERT_EQ(layouts.size(), 4U);
+    EXPECT_NE(layouts[0].error.find("unknown type mystery_t"), std::string::npos);
+    EXPECT_EQ(layouts[0].size, 0U);
+    EXPECT_NE(layouts[1].error.find("unresolved type Bad"), std::string::npos);
+    EXPECT_TRUE(layouts[2].error.empty());
+    EXPECT_EQ(layouts[2].size, 8U);
+    EXPECT_NE(layouts[3].error.find("unknown array size COUNT"), std::string::npos);
+}
+
+TEST(ShaderLayout, FunctionsAndForwardDeclarationsAreSkipped)
+{
+    const auto layouts = ShaderBuild::parseStructLayouts(R"(
+        struct Forward;
+        struct WithMethod {
+            float4 value;
+            float length() const { return metal::length(value); }
+            static constexpr int count = 4;
+        };
+        vertex float4 main(const device struct WithMethod* input [[buffer(0)]]);)",
+        {});
+    ASSERT_EQ(layouts.size(), 1U);
+    EXPECT_EQ(layouts[0].members.size(), 1U);
+    EXPECT_EQ(layouts[0].size, 16U);
+}
+
+TEST(ShaderReflection, GeneratesChecksForBoundStructs)
+{
+    TemporaryDirectory directory;
+    directory.write("shaders/common.h", "struct Shared { float2 uv; };\n");
+    directory.write("shaders/example/shader.metal",
+        "#include \"../common.h\"\nstruct Vertex { float4 position; Shared shared; };\n");
+    const auto entries = ShaderBuild::parseManifest(
+        Json::parse(R"({ "shaders": [ { "source": "example/shader.metal", "name": "Example",
+            "layouts": { "Vertex": { "host": "HostVertex",
+                                     "members": { "shared": "texCoord" } } } } ] })"),
+        directory.path() / "shaders");
+
+    ShaderBuild::DependencyScanner        scanner({});
+    std::vector<ShaderBuild::EntryLayouts> layouts { ShaderBuild::reflectLayouts(
+        entries[0], scanner) };
+    ASSERT_EQ(layouts[0].structs.size(), 2U);
+    EXPECT_EQ(layouts[0].structs[1].size, 32U);
+
+    const std::string header = ShaderBuild::generateLayoutHeader(layouts, "shaders.json");
+    EXPECT_NE(header.find("#define SHADER_LAYOUT_CHECKS_Example() \\"), std::string::npos);
+    EXPECT_NE(header.find("static_assert(sizeof(HostVertex) == 32"), std::string::npos);
+    EXPECT_NE(header.find("static_assert(offsetof(HostVertex, texCoord) == 16"),
+        std::string::npos);
+    EXPECT_NE(header.find("static_assert(sizeof(HostVertex::texCoord) == 8"), std::string::npos);
+
+    const auto manifest = ShaderBuild::layoutManifest(layouts, directory.path() / "shaders");
+    const auto serialized = Json::serialize(manifest);
+    EXPECT_NE(serialized.find("example/shader.metal"), std::string::npos);
+    EXPECT_NE(serialized.find("\"Shared\""), std::string::npos);
+}
+
+TEST(ShaderReflection, BindingsToMissingOrUnknownStructsFail)
+{
+    TemporaryDirectory directory;
+    directory.write("a/shader.metal", "struct Bad { mystery_t value; };\n");
+    for (const std::string binding : { "Missing", "Bad" })
+    {
+        const auto entries = ShaderBuild::parseManifest(
+            Json::parse(std::format(R"({{ "shaders": [ {{ "source": "a/shader.metal",
+                "layouts": {{ "{}": {{}} }} }} ] }})",
+                binding)),
+            directory.path());
+        ShaderBuild::DependencyScanner        scanner({});
+        std::vector<ShaderBuild::EntryLayouts> layouts { ShaderBuild::reflectLayouts(
+            entries[0], scanner) };
+        EXPECT_THROW(static_cast<void>(ShaderBuild::generateLayoutHeader(layouts, "test.json")),
+            std::runtime_error)
+            << binding;
+    }
+}
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Json.hpp"
+#include "ShaderManifest.hpp"
+#include "TemporaryDirectory.hpp"
+
+namespace
+{
+    class ShaderManifestTest : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            m_directory.write("textures/shader.metal", "\n");
+            m_directory.write("instancing/shader.metal", "\n");
+        }
+
+        std::vector<ShaderBuild::ShaderEntry> parse(const std::string& json) const
+        {
+            return ShaderBuild::parseManifest(Json::parse(json), m_directory.path());
+        }
+
+        TemporaryDirectory m_directory;
+    };
+} // namespace
+
+TEST_F(ShaderManifestTest, ExpandsPermutationsInNameOrder)
+{
+    const auto entries = parse(R"({ "shaders": [ { "source": "textures/shader.metal",
+        "name": "Textures", "defines": { "MAX_LIGHTS": 4 },
+        "permutations": { "TEXTURE_COUNT": [ 1, 5 ], "ALPHA_BLEND": [ false, true ] } } ] })");
+    ASSERT_EQ(entries.size(), 1U);
+    EXPECT_EQ(entries[0].permutationCount(), 4U);
+    EXPECT_EQ(entries[0].permutations[0].name, "ALPHA_BLEND");
+
+    const auto units = ShaderBuild::expandManifest(entries);
+    ASSERT_EQ(units.size(), 4U);
+    EXPECT_EQ(units[0].name, "textures_shader_ALPHA_BLEND_0_TEXTURE_COUNT_1");
+    EXPECT_EQ(units[1].name, "textures_shader_ALPHA_BLEND_0_TEXTURE_COUNT_5");
+    EXPECT_EQ(units[3].name, "textures_shader_ALPHA_BLEND_1_TEXTURE_COUNT_5");
+    EXPECT_EQ(units[2].defines,
+        (std::vector<ShaderBuild::Define> { { "MAX_LIGHTS", "4" }, { "ALPHA_BLEND", "1" },
+            { "TEXTURE_COUNT", "1" },
+            { "PERMUTATION_SUFFIX", "_ALPHA_BLEND_1_TEXTURE_COUNT_1" } }));
+}
+
+TEST_F(ShaderManifestTest, SourcesOutsideTheManifestGetDefaultUnits)
+{
+    const auto entries = parse(R"({ "shaders": [ { "source": "textures/shader.metal",
+        "permutations": { "ALPHA_BLEND": [ 0, 1 ] } } ] })");
+    const std::vector<std::filesystem::path> sources { m_directory.path()
+            / "instancing/shader.metal",
+        m_directory.path() / "textures/shader.metal" };
+
+    const auto units = ShaderBuild::collectUnits(sources, ShaderBuild::expandManifest(entries));
+    ASSERT_EQ(units.size(), 3U);
+    EXPECT_EQ(units[0].name, "instancing_shader");
+    EXPECT_TRUE(units[0].defines.empty());
+    EXPECT_EQ(units[1].name, "textures_shader_ALPHA_BLEND_0");
+}
+
+TEST_F(ShaderManifestTest, RejectsInvalidManifests)
+{
+    const std::vector<std::string> invalid {
+        R"({ "shaders": [ { "source": "missing.metal" } ] })",
+        R"({ "shaders": [ { "source": "textures/shader.metal", "name": "1st" } ] })",
+        R"({ "shaders": [ { "source": "textures/shader.metal", "defines": { "A-B": 1 } } ] })",
+        R"({ "shaders": [ { "source": "textures/shader.metal",
+            "permutations": { "COUNT": [ 1.5 ] } } ] })",
+        R"({ "shaders": [ { "source": "textures/shader.metal",
+            "permutations": { "COUNT": [ 1, 1 ] } } ] })",
+        R"({ "shaders": [ { "source": "textures/shader.metal",
+            "permutations": { "COUNT": [] } } ] })",
+        R"({ "shaders": [ { "source": "textures/shader.metal", "defines": { "COUNT": 1 },
+            "permutations": { "COUNT": [ 1, 2 ] } } ] })",
+        R"({ "shaders": [ { "source": "textures/shader.metal", "name": "A" },
+                          { "source": "instancing/shader.metal", "name": "A" } ] })",
+    };
+    for (const auto& json : invalid)
+    {
+        EXPECT_THROW(static_cast<void>(parse(json)), std::runtime_error) << json;
+    }
+}
+
+TEST_F(ShaderManifestTest, DuplicateUnitNamesAreRejected)
+{
+    const std::vector<ShaderBuild::CompileUnit> units {
+        { "a/shader.metal", "same", {} },
+        { "b/shader.metal", "same", {} },
+    };
+    EXPECT_THROW(static_cast<void>(ShaderBuild::collectUnits({}, units)), std::runtime_error);
+}
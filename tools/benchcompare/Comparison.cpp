@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Comparison.hpp"
+
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+namespace BenchCompare
+{
+    namespace
+    {
+        double unitToNanoseconds(std::string_view unit)
+        {
+            if (unit == "ns")
+            {
+                return 1.0;
+            }
+            if (unit == "us")
+            {
+                return 1.0e3;
+            }
+            if (unit == "ms")
+            {
+                return 1.0e6;
+            }
+            if (unit == "s")
+            {
+                return 1.0e9;
+            }
+            throw std::runtime_error(std::format("Unknown time unit '{}'", unit));
+        }
+    } // namespace
+
+    SampleSet loadSamples(const Json::Value& document, const std::string& metric)
+    {
+        SampleSet samples;
+        for (const auto& entry : document["benchmarks"].asArray())
+        {
+            if (const auto* runType = entry.find("run_type");
+                runType != nullptr && runType->asString() == "aggregate")
+            {
+                continue;
+            }
+            if (const auto* errorOccurred = entry.find("error_occurred");
+                errorOccurred != nullptr && errorOccurred->asBool())
+            {
+                continue;
+            }
+
+            const auto* runName = entry.find("run_name");
+            const auto& name = runName != nullptr ? runName->asString() : entry["name"].asString();
+
+            double scale = 1.0;
+            if (const auto* unit = entry.find("time_unit"))
+            {
+                scale = unitToNanoseconds(unit->asString());
+            }
+            else if (const auto* plainUnit = entry.find("unit"))
+            {
+                scale = unitToNanoseconds(plainUnit->asString());
+            }
+
+            auto& values = samples[name];
+            if (const auto* raw = entry.find("samples"))
+            {
+                for (const auto& sample : raw->asArray())
+                {
+                    values.push_back(sample.asNumber() * scale);
+                }
+            }
+            else
+            {
+                values.push_back(entry[metric].asNumber() * scale);
+            }
+        }
+        return samples;
+    }
+
+    double thresholdFor(
+        const std::string& name, const std::vector<ThresholdRule>& rules, double fallback)
+    {
+        for (const auto& rule : rules)
+        {
+            if (std::regex_match(name, rule.pattern))
+            {
+                return rule.threshold;
+            }
+        }
+        return fallback;
+    }
+
+    Verdict judge(const Comparison& comparison, const CompareOptions& options)
+    {
+        const bool slower = comparison.change > comparison.threshold;
+        const bool faster = comparison.change < -comparison.threshold;
+        if (!slower && !faster)
+        {
+            return Verdict::Unchanged;
+        }
+
+        // A test that cannot reach alpha with these sample sizes decides nothing. Only
+        // a slowdown it cannot rule out holds the gate; an unconfirmed speedup is noise.
+        const size_t baselineSize = comparison.baseline.size();
+        const size_t contenderSize = comparison.contender.size();
+        const bool   enoughSamples = baselineSize >= options.minSamples
+            && contenderSize >= options.minSamples
+            && Statistics::minimumPValue(baselineSize, contenderSize) < options.alpha;
+        if (!enoughSamples)
+        {
+            return slower ? Verdict::Undecided : Verdict::Noisy;
+        }
+        if (!comparison.test.valid || comparison.test.pValue >= options.alpha)
+        {
+            return Verdict::Noisy;
+        }
+        return slower ? Verdict::Regressed : Verdict::Improved;
+    }
+
+    std::vector<Comparison> compare(const SampleSet& baseline,
+        const SampleSet&                             contender,
+        const std::vector<ThresholdRule>&            rules,
+        const CompareOptions&                        options)
+    {
+        std::vector<Comparison> comparisons;
+        for (const auto& [name, samples] : baseline)
+        {
+            Comparison comparison;
+            comparison.name = name;
+            comparison.baseline = samples;
+            comparison.threshold = thresholdFor(name, rules, options.threshold);
+            comparison.baselineMedian = Statistics::median(samples);
+
+            const auto found = contender.find(name);
+            if (found == contender.end())
+            {
+                comparison.verdict = Verdict::Removed;
+                comparisons.push_back(std::move(comparison));
+                continue;
+            }
+
+            comparison.contender = found->second;
+            comparison.contenderMedian = Statistics::median(comparison.contender);
+            comparison.change = comparison.baselineMedian > 0.0
+                ? comparison.contenderMedian / comparison.baselineMedian - 1.0
+                : 0.0;
+            comparison.test = Statistics::mannWhitneyU(comparison.baseline, comparison.contender);
+            comparison.verdict = judge(comparison, options);
+            comparisons.push_back(std::move(comparison));
+        }
+
+        for (const auto& [name, samples] : contender)
+        {
+            if (!baseline.contains(name))
+            {
+                Comparison comparison;
+                comparison.name = name;
+                comparison.contender = samples;
+                comparison.contenderMedian = Statistics::median(samples);
+                comparison.threshold = thresholdFor(name, rules, options.threshold);
+                comparison.verdict = Verdict::Added;
+                comparisons.push_back(std::move(comparison));
+            }
+        }
+        return comparisons;
+    }
+
+    bool failsGate(const Verdict verdict)
+    {
+        return verdict == Verdict::Regressed || verdict == Verdict::Undecided;
+    }
+
+    std::string_view verdictName(const Verdict verdict)
+    {
+        switch (verdict)
+        {
+        case Verdict::Unchanged:
+            return "ok";
+        case Verdict::Improved:
+            return "IMPROVED";
+        case Verdict::Regressed:
+            return "REGRESSED";
+        case Verdict::Noisy:
+            return "noisy";
+        case Verdict::Undecided:
+            return "UNDECIDED";
+        case Verdict::Added:
+            return "added";
+        case Verdict::Removed:
+            return "removed";
+        }
+        return "";
+    }
+} // namespace BenchCompare
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Json.hpp"
+#include "Statistics.hpp"
+
+namespace BenchCompare
+{
+    enum class Verdict
+    {
+        Unchanged,
+        Improved,
+        Regressed,
+        Noisy,
+        Undecided, ///< Slower beyond the threshold, but too few samples for the test to decide.
+        Added,
+        Removed,
+    };
+
+    struct CompareOptions
+    {
+        double alpha = 0.05;
+        double threshold = 0.05; ///< Allowed slowdown where no rule matches.
+        size_t minSamples = 5;   ///< Repetitions per side the U test needs.
+    };
+
+    struct ThresholdRule
+    {
+        std::regex pattern;
+        double     threshold;
+    };
+
+    struct Comparison
+    {
+        std::string                   name;
+        std::vector<double>           baseline;
+        std::vector<double>           contender;
+        double                        baselineMedian = 0.0;
+        double                        contenderMedian = 0.0;
+        double                        change = 0.0;
+        double                        threshold = 0.0;
+        Statistics::MannWhitneyResult test {};
+        Verdict                       verdict = Verdict::Unchanged;
+    };
+
+    /// @brief Samples in nanoseconds by benchmark name.
+    using SampleSet = std::map<std::string, std::vector<double>>;
+
+    /// @brief Reads Google Benchmark JSON output (optionally with repetitions) as well
+    /// as a plain form where each entry carries its raw "samples" array.
+    /// @param [in] metric real_time or cpu_time, for Google Benchmark entries.
+    /// @throws std::runtime_error on a malformed document or unknown time unit.
+    [[nodiscard]] SampleSet loadSamples(const Json::Value& document, const std::string& metric);
+
+    /// @brief The threshold of the first rule matching name, so specific patterns can
+    /// precede broad ones, or fallback.
+    [[nodiscard]] double thresholdFor(
+        const std::string& name, const std::vector<ThresholdRule>& rules, double fallback);
+
+    /// @brief Decides a comparison of two sample sets of one benchmark.
+    ///
+    /// A change beyond the threshold is significant when the U test rejects at
+    /// alpha. When either side has fewer than minSamples values, or so few that
+    /// no outcome could reach alpha, a slowdown is Undecided rather than a pass and
+    /// a speedup is Noisy.
+    [[nodiscard]] Verdict judge(const Comparison& comparison, const CompareOptions& options);
+
+    [[nodiscard]] std::vector<Comparison> compare(const SampleSet& baseline,
+        const SampleSet&                                           contender,
+        const std::vector<ThresholdRule>&                          rules,
+        const CompareOptions&                                      options);
+
+    /// @brief Whether the verdict fails the gate: regressions, and slowdowns too few
+    /// samples could not decide.
+    [[nodiscard]] bool failsGate(Verdict verdict);
+
+    [[nodiscard]] std::string_view verdictName(Verdict verdict);
+} // namespace BenchCompare
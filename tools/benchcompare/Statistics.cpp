@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+namespace Statistics
+{
+    namespace
+    {
+        /// Two-sided p-value of u from the exact null distribution of U, built by
+        /// counting the orderings of n1 and n2 untied values that give each U.
+        double exactPValue(const double u, const size_t n1, const size_t n2)
+        {
+            // counts[i][k] holds the orderings of i values of the first sample and
+            // j of the second with U = k, for the j of the current pass
+            const size_t                     maxU = n1 * n2;
+            std::vector<std::vector<double>> counts(n1 + 1, std::vector<double>(maxU + 1));
+            for (size_t i = 0; i <= n1; i++)
+            {
+                counts[i][0] = 1.0;
+            }
+            for (size_t j = 1; j <= n2; j++)
+            {
+                // The largest value comes from the second sample, adding nothing to
+                // U, or from the first, which it then exceeds j values of
+                for (size_t i = 1; i <= n1; i++)
+                {
+                    for (size_t k = maxU + 1; k-- > j;)
+                    {
+                        counts[i][k] += counts[i - 1][k - j];
+                    }
+                }
+            }
+
+            const std::vector<double>& distribution = counts[n1];
+            double                     total = 0.0;
+            double                     atMost = 0.0;
+            double                     atLeast = 0.0;
+            for (size_t k = 0; k <= maxU; k++)
+            {
+                total += distribution[k];
+                atMost += static_cast<double>(k) <= u ? distribution[k] : 0.0;
+                atLeast += static_cast<double>(k) >= u ? distribution[k] : 0.0;
+            }
+            return std::min(1.0, 2.0 * std::min(atMost, atLeast) / total);
+        }
+    } // namespace
+
+    double median(std::span<const double> samples)
+    {
+        if (samples.empty())
+        {
+            return 0.0;
+        }
+
+        std::vector<double> sorted(samples.begin(), samples.end());
+        const size_t        middle = sorted.size() / 2;
+        std::ranges::nth_element(sorted, sorted.begin() + static_cast<ptrdiff_t>(middle));
+        const double upper = sorted[middle];
+        if (sorted.size() % 2 != 0)
+        {
+            return upper;
+        }
+
+        const double lower = *std::max_element(sorted.begin(), sorted.begin() + middle);
+        return (lower + upper) * 0.5;
+    }
+
+    double medianAbsoluteDeviation(std::span<const double> samples)
+    {
+        // Consistency constant for normally distributed data
+        constexpr double scale = 1.4826;
+
+        const double        center = median(samples);
+        std::vector<double> deviations;
+        deviations.reserve(samples.size());
+        for (const double sample : samples)
+        {
+            deviations.push_back(std::abs(sample - center));
+        }
+        return median(deviations) * scale;
+    }
+
+    MannWhitneyResult mannWhitneyU(std::span<const double> a, std::span<const double> b)
+    {
+        MannWhitneyResult result {};
+        if (a.size() < 2 || b.size() < 2)
+        {
+            return result;
+        }
+
+        struct Ranked
+        {
+            double value;
+            bool   first;
+        };
+
+        std::vector<Ranked> pooled;
+        pooled.reserve(a.size() + b.size());
+        for (const double value : a)
+        {
+            pooled.push_back({ value, true });
+        }
+        for (const double value : b)
+        {
+            pooled.push_back({ value, false });
+        }
+        std::ranges::sort(pooled, {}, &Ranked::value);
+
+        // Assign mid-ranks to tied groups and accumulate the tie correction term.
+        const auto n = static_cast<double>(pooled.size());
+        double     rankSumA = 0.0;
+        double     tieTerm = 0.0;
+        for (size_t i = 0; i < pooled.size();)
+        {
+            size_t j = i + 1;
+            while (j < pooled.size() && pooled[j].value == pooled[i].value)
+            {
+                j++;
+            }
+
+            const double rank = (static_cast<double>(i + 1) + static_cast<double>(j)) * 0.5;
+            for (size_t k = i; k < j; k++)
+            {
+                if (pooled[k].first)
+                {
+                    rankSumA += rank;
+                }
+            }
+
+            const auto tied = static_cast<double>(j - i);
+            tieTerm += tied * tied * tied - tied;
+            i = j;
+        }
+
+        const auto n1 = static_cast<double>(a.size());
+        const auto n2 = static_cast<double>(b.size());
+        result.u = rankSumA - n1 * (n1 + 1.0) * 0.5;
+
+        const double mean = n1 * n2 * 0.5;
+        const double variance = n1 * n2 / 12.0 * ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+        if (variance <= 0.0)
+        {
+            return result;
+        }
+
+        const double difference = result.u - mean;
+        const double corrected = std::max(std::abs(difference) - 0.5, 0.0);
+        result.z = std::copysign(corrected / std::sqrt(variance), difference);
+        result.pValue = std::erfc(std::abs(result.z) / std::numbers::sqrt2);
+        result.valid = true;
+
+        if (tieTerm == 0.0 && a.size() <= g_exactSampleLimit && b.size() <= g_exactSampleLimit)
+        {
+            result.pValue = exactPValue(result.u, a.size(), b.size());
+            result.exact = true;
+        }
+        return result;
+    }
+
+    double minimumPValue(const size_t sizeA, const size_t sizeB)
+    {
+        // One of the binomial(n1 + n2, n1) equally likely orderings lies at each end
+        double orderings = 1.0;
+        for (size_t i = 1; i <= std::min(sizeA, sizeB); i++)
+        {
+            orderings = orderings * static_cast<double>(sizeA + sizeB - i + 1)
+                / static_cast<double>(i);
+        }
+        return std::min(1.0, 2.0 / orderings);
+    }
+} // namespace Statistics
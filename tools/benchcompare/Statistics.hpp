@@ -0,0 +1,48 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+namespace Statistics
+{
+    struct MannWhitneyResult
+    {
+        double u = 0.0;      ///< U statistic of the first sample.
+        double z = 0.0;      ///< Normal approximation of U (tie and continuity corrected).
+        double pValue = 1.0; ///< Two-sided p-value.
+        bool   exact = false; ///< pValue comes from the exact distribution of U.
+        bool   valid = false;
+    };
+
+    /// @brief Samples per side up to which mannWhitneyU computes exact p-values.
+    inline constexpr size_t g_exactSampleLimit = 30;
+
+    /// @brief Computes the sample median.
+    /// @param [in] samples The samples (need not be sorted).
+    /// @return The median, or 0 for an empty sample.
+    [[nodiscard]] double median(std::span<const double> samples);
+
+    /// @brief Computes the median absolute deviation scaled to estimate a standard deviation.
+    [[nodiscard]] double medianAbsoluteDeviation(std::span<const double> samples);
+
+    /// @brief Two-sided Mann-Whitney U test.
+    ///
+    /// Without ties and with at most g_exactSampleLimit values per sample the
+    /// p-value is exact; otherwise it uses the normal approximation.
+    /// @note The result is flagged invalid when either sample has fewer than
+    /// two values or all values are tied, since no significance can be derived.
+    /// @param [in] a Samples of the first distribution.
+    /// @param [in] b Samples of the second distribution.
+    [[nodiscard]] MannWhitneyResult mannWhitneyU(
+        std::span<const double> a, std::span<const double> b);
+
+    /// @brief Smallest two-sided p-value the exact U test can produce for samples of
+    /// these sizes, reached when they do not overlap at all. A test at a level
+    /// at or below it can never be significant.
+    [[nodiscard]] double minimumPValue(size_t sizeA, size_t sizeB);
+} // namespace Statistics
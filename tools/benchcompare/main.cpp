@@ -0,0 +1,293 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <print>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Comparison.hpp"
+#include "Json.hpp"
+
+namespace
+{
+    struct Options
+    {
+        std::string baselinePath;
+        std::string contenderPath;
+        std::string thresholdsPath;
+        std::string reportPath;
+        std::string metric = "real_time";
+
+        BenchCompare::CompareOptions compare;
+    };
+
+    /// A malformed command line, as opposed to a failure reading or comparing results.
+    struct UsageError : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    constexpr std::string_view g_usage
+        = R"(usage: benchcompare [options] <baseline.json> <contender.json>
+
+Compares two benchmark result files and fails when a benchmark regresses
+beyond its threshold with statistical significance (Mann-Whitney U), or
+slows beyond it with too few repetitions for the test to decide.
+
+options:
+  --metric <real_time|cpu_time>  Time field to compare (default real_time)
+  --alpha <p>                    Significance level (default 0.05)
+  --threshold <fraction>         Default allowed slowdown (default 0.05)
+  --thresholds <file.json>       Per-benchmark thresholds, see below
+  --min-samples <n>              Repetitions for the U test (default 5)
+  --report <file.json>           Also write the comparison as JSON
+
+Threshold files map benchmark name patterns (ECMAScript regex) to limits:
+  { "default": 0.05, "benchmarks": { "BM_Arena.*": 0.02 } })";
+
+    void printUsage(std::FILE* stream)
+    {
+        std::println(stream, "{}", g_usage);
+    }
+
+    double parseNumberArgument(std::string_view option, const char* value)
+    {
+        char*        end = nullptr;
+        const double result = std::strtod(value, &end);
+        if (end == value || *end != '\0' || result < 0.0)
+        {
+            throw UsageError(std::format("Invalid value '{}' for {}", value, option));
+        }
+        return result;
+    }
+
+    Options parseOptions(int argc, char** argv)
+    {
+        Options                  options;
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view argument = argv[i];
+            const auto             next = [&]() -> const char* {
+                if (i + 1 >= argc)
+                {
+                    throw UsageError(std::format("Missing value for {}", argument));
+                }
+                return argv[++i];
+            };
+
+            if (argument == "--help" || argument == "-h")
+            {
+                printUsage(stdout);
+                std::exit(EXIT_SUCCESS);
+            }
+            else if (argument == "--metric")
+            {
+                options.metric = next();
+                if (options.metric != "real_time" && options.metric != "cpu_time")
+                {
+                    throw UsageError(std::format("Unknown metric '{}'", options.metric));
+                }
+            }
+            else if (argument == "--alpha")
+            {
+                options.compare.alpha = parseNumberArgument(argument, next());
+            }
+            else if (argument == "--threshold")
+            {
+                options.compare.threshold = parseNumberArgument(argument, next());
+            }
+            else if (argument == "--thresholds")
+            {
+                options.thresholdsPath = next();
+            }
+            else if (argument == "--min-samples")
+            {
+                const auto minSamples = parseNumberArgument(argument, next());
+                options.compare.minSamples = std::max<size_t>(2, static_cast<size_t>(minSamples));
+            }
+            else if (argument == "--report")
+            {
+                options.reportPath = next();
+            }
+            else if (argument.starts_with("--"))
+            {
+                throw UsageError(std::format("Unknown option {}", argument));
+            }
+            else
+            {
+                positional.emplace_back(argument);
+            }
+        }
+
+        if (positional.size() != 2)
+        {
+            throw UsageError("Expected exactly two benchmark result files");
+        }
+        options.baselinePath = positional[0];
+        options.contenderPath = positional[1];
+        return options;
+    }
+
+    std::vector<BenchCompare::ThresholdRule> loadThresholds(Options& options)
+    {
+        std::vector<BenchCompare::ThresholdRule> rules;
+        if (options.thresholdsPath.empty())
+        {
+            return rules;
+        }
+
+        const Json::Value document = Json::parseFile(options.thresholdsPath);
+        if (const auto* fallback = document.find("default"))
+        {
+            options.compare.threshold = fallback->asNumber();
+        }
+        if (const auto* benchmarks = document.find("benchmarks"))
+        {
+            for (const auto& [pattern, threshold] : benchmarks->asObject())
+            {
+                rules.push_back({ std::regex(pattern), threshold.asNumber() });
+            }
+        }
+        return rules;
+    }
+
+    std::string formatTime(double nanoseconds)
+    {
+        if (nanoseconds >= 1.0e9)
+        {
+            return std::format("{:.3f} s", nanoseconds / 1.0e9);
+        }
+        if (nanoseconds >= 1.0e6)
+        {
+            return std::format("{:.3f} ms", nanoseconds / 1.0e6);
+        }
+        if (nanoseconds >= 1.0e3)
+        {
+            return std::format("{:.3f} us", nanoseconds / 1.0e3);
+        }
+        return std::format("{:.1f} ns", nanoseconds);
+    }
+
+    void printReport(const std::vector<BenchCompare::Comparison>& comparisons)
+    {
+        size_t nameWidth = 9;
+        for (const auto& comparison : comparisons)
+        {
+            nameWidth = std::max(nameWidth, comparison.name.size());
+        }
+
+        std::println("{:<{}}  {:>12}  {:>12}  {:>9}  {:>7}  {:>7}  {:>5}  {}", "Benchmark",
+            nameWidth, "Baseline", "Contender", "Change", "Limit", "p", "n", "Verdict");
+        std::println("{}", std::string(nameWidth + 80, '-'));
+        for (const auto& comparison : comparisons)
+        {
+            const bool paired = comparison.verdict != BenchCompare::Verdict::Added
+                && comparison.verdict != BenchCompare::Verdict::Removed;
+            std::println("{:<{}}  {:>12}  {:>12}  {:>9}  {:>7}  {:>7}  {:>5}  {}", comparison.name,
+                nameWidth,
+                comparison.baseline.empty() ? "-" : formatTime(comparison.baselineMedian),
+                comparison.contender.empty() ? "-" : formatTime(comparison.contenderMedian),
+                paired ? std::format("{:+.2f}%", comparison.change * 100.0) : "-",
+                std::format("{:.1f}%", comparison.threshold * 100.0),
+                comparison.test.valid ? std::format("{:.4f}", comparison.test.pValue) : "-",
+                std::format("{}/{}", comparison.baseline.size(), comparison.contender.size()),
+                BenchCompare::verdictName(comparison.verdict));
+        }
+    }
+
+    void writeReport(const std::string&              path,
+        const std::vector<BenchCompare::Comparison>& comparisons,
+        bool                                         passed)
+    {
+        Json::Value report;
+        report.set("passed", passed);
+        Json::Value& entries = report.set("benchmarks", Json::Value::Array {});
+        for (const auto& comparison : comparisons)
+        {
+            Json::Value entry;
+            entry.set("name", comparison.name);
+            entry.set("verdict", std::string(BenchCompare::verdictName(comparison.verdict)));
+            entry.set("baseline_median_ns", comparison.baselineMedian);
+            entry.set("contender_median_ns", comparison.contenderMedian);
+            entry.set("change", comparison.change);
+            entry.set("threshold", comparison.threshold);
+            entry.set("p_value", comparison.test.valid ? Json::Value(comparison.test.pValue)
+                                                       : Json::Value(nullptr));
+            entry.set("u", comparison.test.u);
+            entries.push(std::move(entry));
+        }
+
+        std::ofstream stream(path);
+        if (!stream)
+        {
+            throw std::runtime_error(std::format("Failed to open {} for write", path));
+        }
+        stream << Json::serialize(report) << '\n';
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        Options    options = parseOptions(argc, argv);
+        const auto rules = loadThresholds(options);
+        const auto baseline
+            = BenchCompare::loadSamples(Json::parseFile(options.baselinePath), options.metric);
+        const auto contender
+            = BenchCompare::loadSamples(Json::parseFile(options.contenderPath), options.metric);
+
+        const auto comparisons
+            = BenchCompare::compare(baseline, contender, rules, options.compare);
+        printReport(comparisons);
+
+        const auto failures = std::ranges::count_if(comparisons,
+            [](const BenchCompare::Comparison& c) { return BenchCompare::failsGate(c.verdict); });
+        const auto undecided = std::ranges::count(comparisons, BenchCompare::Verdict::Undecided,
+            [](const BenchCompare::Comparison& c) { return c.verdict; });
+        const bool passed = failures == 0;
+        if (!options.reportPath.empty())
+        {
+            writeReport(options.reportPath, comparisons, passed);
+        }
+
+        std::println("");
+        if (passed)
+        {
+            std::println("PASS: {} benchmarks compared, no significant regressions",
+                comparisons.size());
+            return EXIT_SUCCESS;
+        }
+        std::println("FAIL: {} of {} benchmarks regressed or were undecided", failures,
+            comparisons.size());
+        if (undecided > 0)
+        {
+            std::println("{} slowed beyond their threshold with too few repetitions to decide; "
+                         "rerun with at least {} per side",
+                undecided, options.compare.minSamples);
+        }
+        return EXIT_FAILURE;
+    }
+    catch (const UsageError& e)
+    {
+        std::println(stderr, "Error: {}", e.what());
+        printUsage(stderr);
+        return 2;
+    }
+    catch (const std::exception& e)
+    {
+        std::println(stderr, "Error: {}", e.what());
+        return 2;
+    }
+}
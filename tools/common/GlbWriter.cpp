@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "GlbWriter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace Gltf
+{
+    namespace
+    {
+        constexpr uint32_t g_magic = 0x46546C67;       // "glTF"
+        constexpr uint32_t g_version = 2;
+        constexpr uint32_t g_jsonChunk = 0x4E4F534A;   // "JSON"
+        constexpr uint32_t g_binaryChunk = 0x004E4942; // "BIN\0"
+
+        size_t componentCount(const std::string_view type)
+        {
+            if (type == "SCALAR")
+            {
+                return 1;
+            }
+            if (type == "VEC2" || type == "VEC3" || type == "VEC4")
+            {
+                return static_cast<size_t>(type.back() - '0');
+            }
+            if (type == "MAT4")
+            {
+                return 16;
+            }
+            throw std::runtime_error(std::format("Unsupported accessor type {}", type));
+        }
+
+        size_t componentSize(const ComponentType componentType)
+        {
+            switch (componentType)
+            {
+            case ComponentType::UnsignedByte:
+                return 1;
+            case ComponentType::UnsignedShort:
+                return 2;
+            default:
+                return 4;
+            }
+        }
+
+        void appendWord(std::vector<std::byte>& out, const uint32_t value)
+        {
+            const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+            out.insert(out.end(), bytes, bytes + sizeof(value));
+        }
+
+        void appendChunk(std::vector<std::byte>& out, const uint32_t type,
+            std::span<const std::byte> data, const std::byte padding)
+        {
+            const size_t padded = (data.size() + 3) / 4 * 4;
+            appendWord(out, static_cast<uint32_t>(padded));
+            appendWord(out, type);
+            out.insert(out.end(), data.begin(), data.end());
+            out.insert(out.end(), padded - data.size(), padding);
+        }
+    } // namespace
+
+    int64_t GlbWriter::addAccessor(const std::span<const std::byte> data,
+        const ComponentType                                         componentType,
+        const std::string_view                                      type,
+        const size_t                                                count)
+    {
+        const size_t components = componentCount(type);
+        if (data.size() != count * components * componentSize(componentType))
+        {
+            throw std::runtime_error(std::format(
+                "{} bytes do not hold {} {} elements", data.size(), count, type));
+        }
+
+        Json::Value accessor = Json::Value::Object {};
+        accessor.set("bufferView", addBufferView(data));
+        accessor.set("componentType", static_cast<int64_t>(componentType));
+        accessor.set("count", static_cast<int64_t>(count));
+        accessor.set("type", std::string(type));
+
+        if (componentType == ComponentType::Float && count > 0)
+        {
+            std::vector<float> minimum(components, std::numeric_limits<float>::max());
+            std::vector<float> maximum(components, std::numeric_limits<float>::lowest());
+            for (size_t i = 0; i < count * components; i++)
+            {
+                float value = 0.0F;
+                std::memcpy(&value, data.data() + i * sizeof(float), sizeof(float));
+                minimum[i % components] = std::min(minimum[i % components], value);
+                maximum[i % components] = std::max(maximum[i % components], value);
+            }
+
+            Json::Value min = Json::Value::Array {};
+            Json::Value max = Json::Value::Array {};
+            for (size_t component = 0; component < components; component++)
+            {
+                min.push(static_cast<double>(minimum[component]));
+                max.push(static_cast<double>(maximum[component]));
+            }
+            accessor.set("min", std::move(min));
+            accessor.set("max", std::move(max));
+        }
+        return add("accessors", std::move(accessor));
+    }
+
+    int64_t GlbWriter::addBufferView(const std::span<const std::byte> data)
+    {
+        m_buffer.resize((m_buffer.size() + 3) / 4 * 4);
+
+        Json::Value view = Json::Value::Object {};
+        view.set("buffer", int64_t { 0 });
+        view.set("byteOffset", static_cast<int64_t>(m_buffer.size()));
+        view.set("byteLength", static_cast<int64_t>(data.size()));
+        m_buffer.insert(m_buffer.end(), data.begin(), data.end());
+        return add("bufferViews", std::move(view));
+    }
+
+    int64_t GlbWriter::add(const std::string& array, Json::Value value)
+    {
+        auto& values = m_arrays[array];
+        values.push_back(std::move(value));
+        return static_cast<int64_t>(values.size() - 1);
+    }
+
+    void GlbWriter::set(const std::string& key, Json::Value value)
+    {
+        m_members[key] = std::move(value);
+    }
+
+    std::vector<std::byte> GlbWriter::build() const
+    {
+        Json::Value asset = Json::Value::Object {};
+        asset.set("version", "2.0");
+        asset.set("generator", "GlbWriter");
+
+        Json::Value document = Json::Value::Object {};
+        document.set("asset", std::move(asset));
+        for (const auto& [key, value] : m_members)
+        {
+            document.set(key, value);
+        }
+        for (const auto& [key, values] : m_arrays)
+        {
+            document.set(key, values);
+        }
+        if (!m_buffer.empty())
+        {
+            Json::Value buffer = Json::Value::Object {};
+            buffer.set("byteLength", static_cast<int64_t>(m_buffer.size()));
+            document.set("buffers", Json::Value::Array { std::move(buffer) });
+        }
+
+        const std::string json = Json::serialize(document, 0);
+        const auto        jsonBytes = std::as_bytes(std::span(json));
+
+        std::vector<std::byte> glb;
+        appendWord(glb, g_magic);
+        appendWord(glb, g_version);
+        appendWord(glb, 0); // Length, patched below
+        appendChunk(glb, g_jsonChunk, jsonBytes, std::byte { ' ' });
+        if (!m_buffer.empty())
+        {
+            appendChunk(glb, g_binaryChunk, m_buffer, std::byte { 0 });
+        }
+
+        const auto length = static_cast<uint32_t>(glb.size());
+        std::memcpy(glb.data() + 8, &length, sizeof(length));
+        return glb;
+    }
+
+    void GlbWriter::write(const std::filesystem::path& path) const
+    {
+        const std::vector<std::byte> glb = build();
+        std::ofstream                stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(glb.data()),
+            static_cast<std::streamsize>(glb.size()));
+        if (!stream)
+        {
+            throw std::runtime_error(std::format("Failed to write {}", path.string()));
+        }
+    }
+} // namespace Gltf
@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Json.hpp"
+
+namespace Gltf
+{
+    enum class ComponentType : int64_t
+    {
+        UnsignedByte = 5121,
+        UnsignedShort = 5123,
+        UnsignedInt = 5125,
+        Float = 5126,
+    };
+
+    /// @brief Assembles binary glTF 2.0 (.glb) files: a JSON document and a single
+    /// binary buffer holding every accessor's data.
+    ///
+    /// Used to generate scenes for tests and benchmarks:
+    /// @code
+    /// Gltf::GlbWriter writer;
+    /// Json::Value attributes = Json::Value::Object {};
+    /// attributes.set("POSITION",
+    ///     writer.addAccessor(std::span(positions), Gltf::ComponentType::Float, "VEC3"));
+    /// writer.add("meshes", ...);
+    /// const std::vector<std::byte> glb = writer.build();
+    /// @endcode
+    class GlbWriter
+    {
+    public:
+        /// @brief Appends data to the binary buffer, 4 byte aligned, in a buffer view of
+        /// its own and adds an accessor reading it. Float accessors get min and max.
+        /// @param [in] type Accessor type: SCALAR, VEC2, VEC3, VEC4 or MAT4.
+        /// @param [in] count Number of elements in data.
+        /// @return Index of the accessor.
+        int64_t addAccessor(std::span<const std::byte> data,
+            ComponentType                              componentType,
+            std::string_view                           type,
+            size_t                                     count);
+
+        /// @brief Adds an accessor over tightly packed elements, e.g. std::array<float, 3>
+        /// for VEC3 floats.
+        template <typename TElement, size_t TExtent>
+        int64_t addAccessor(const std::span<TElement, TExtent> elements,
+            const ComponentType                                componentType,
+            const std::string_view                             type)
+        {
+            return addAccessor(std::as_bytes(elements), componentType, type, elements.size());
+        }
+
+        /// @brief Appends data to the binary buffer in a buffer view, e.g. for an image.
+        /// @return Index of the buffer view.
+        int64_t addBufferView(std::span<const std::byte> data);
+
+        /// @brief Appends a value to a top level array such as meshes or nodes.
+        /// @return Index of the value in the array.
+        int64_t add(const std::string& array, Json::Value value);
+
+        /// @brief Sets a top level member, such as the default scene.
+        void set(const std::string& key, Json::Value value);
+
+        /// @brief Returns the .glb file contents.
+        [[nodiscard]] std::vector<std::byte> build() const;
+
+        /// @throws std::runtime_error if the file cannot be written.
+        void write(const std::filesystem::path& path) const;
+
+    private:
+        std::map<std::string, Json::Value::Array> m_arrays;
+        std::map<std::string, Json::Value>        m_members;
+        std::vector<std::byte>                    m_buffer;
+    };
+} // namespace Gltf
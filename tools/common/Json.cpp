@@ -0,0 +1,646 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Json.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace Json
+{
+    namespace
+    {
+        class Parser
+        {
+        public:
+            explicit Parser(std::string_view text)
+                : m_text(text)
+            {
+            }
+
+            Value parseDocument()
+            {
+                Value value = parseValue(0);
+                skipWhitespace();
+                if (m_position != m_text.size())
+                {
+                    fail("Unexpected trailing characters");
+                }
+                return value;
+            }
+
+        private:
+            static constexpr int s_maxDepth = 256;
+
+            [[noreturn]] void fail(std::string_view message) const
+            {
+                size_t line = 1;
+                size_t column = 1;
+                for (size_t i = 0; i < m_position && i < m_text.size(); i++)
+                {
+                    if (m_text[i] == '\n')
+                    {
+                        line++;
+                        column = 1;
+                    }
+                    else
+                    {
+                        column++;
+                    }
+                }
+                throw std::runtime_error(
+                    std::format("JSON parse error at {}:{}: {}", line, column, message));
+            }
+
+            void skipWhitespace()
+            {
+                while (m_position < m_text.size())
+                {
+                    const char c = m_text[m_position];
+                    if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+                    {
+                        break;
+                    }
+                    m_position++;
+                }
+            }
+
+            char peek() const
+            {
+                return m_position < m_text.size() ? m_text[m_position] : '\0';
+            }
+
+            void expect(char c)
+            {
+                if (peek() != c)
+                {
+                    fail(std::format("Expected '{}'", c));
+                }
+                m_position++;
+            }
+
+            bool consumeLiteral(std::string_view literal)
+            {
+                if (m_text.substr(m_position, literal.size()) == literal)
+                {
+                    m_position += literal.size();
+                    return true;
+                }
+                return false;
+            }
+
+            Value parseValue(int depth)
+            {
+                if (depth > s_maxDepth)
+                {
+                    fail("Maximum nesting depth exceeded");
+                }
+
+                skipWhitespace();
+                switch (peek())
+                {
+                case '{':
+                    return parseObject(depth);
+                case '[':
+                    return parseArray(depth);
+                case '"':
+                    return Value(parseString());
+                case 't':
+                    if (consumeLiteral("true"))
+                    {
+                        return Value(true);
+                    }
+                    break;
+                case 'f':
+                    if (consumeLiteral("false"))
+                    {
+                        return Value(false);
+                    }
+                    break;
+                case 'n':
+                    if (consumeLiteral("null"))
+                    {
+                        return Value(nullptr);
+                    }
+                    break;
+                default:
+                    return parseNumber();
+                }
+                fail("Invalid literal");
+            }
+
+            Value parseObject(int depth)
+            {
+                expect('{');
+                Value::Object object;
+                skipWhitespace();
+                if (peek() == '}')
+                {
+                    m_position++;
+                    return Value(std::move(object));
+                }
+
+                while (true)
+                {
+                    skipWhitespace();
+                    std::string key = parseString();
+                    skipWhitespace();
+                    expect(':');
+                    object.emplace_back(std::move(key), parseValue(depth + 1));
+                    skipWhitespace();
+                    if (peek() == ',')
+                    {
+                        m_position++;
+                        continue;
+                    }
+                    expect('}');
+                    return Value(std::move(object));
+                }
+            }
+
+            Value parseArray(int depth)
+            {
+                expect('[');
+                Value::Array array;
+                skipWhitespace();
+                if (peek() == ']')
+                {
+                    m_position++;
+                    return Value(std::move(array));
+                }
+
+                while (true)
+                {
+                    array.push_back(parseValue(depth + 1));
+                    skipWhitespace();
+                    if (peek() == ',')
+                    {
+                        m_position++;
+                        continue;
+                    }
+                    expect(']');
+                    return Value(std::move(array));
+                }
+            }
+
+            uint32_t parseHex4()
+            {
+                if (m_position + 4 > m_text.size())
+                {
+                    fail("Truncated unicode escape");
+                }
+                uint32_t   code = 0;
+                const auto first = m_text.data() + m_position;
+                const auto [end, error] = std::from_chars(first, first + 4, code, 16);
+                if (error != std::errc() || end != first + 4)
+                {
+                    fail("Invalid unicode escape");
+                }
+                m_position += 4;
+                return code;
+            }
+
+            static void appendUtf8(std::string& out, uint32_t code)
+            {
+                if (code < 0x80)
+                {
+                    out.push_back(static_cast<char>(code));
+                }
+                else if (code < 0x800)
+                {
+                    out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else if (code < 0x10000)
+                {
+                    out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else
+                {
+                    out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+            }
+
+            std::string parseString()
+            {
+                expect('"');
+                std::string result;
+                while (true)
+                {
+                    if (m_position >= m_text.size())
+                    {
+                        fail("Unterminated string");
+                    }
+
+                    const char c = m_text[m_position++];
+                    if (c == '"')
+                    {
+                        return result;
+                    }
+                    if (c != '\\')
+                    {
+                        result.push_back(c);
+                        continue;
+                    }
+
+                    const char escape = peek();
+                    m_position++;
+                    switch (escape)
+                    {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        result.push_back(escape);
+                        break;
+                    case 'b':
+                        result.push_back('\b');
+                        break;
+                    case 'f':
+                        result.push_back('\f');
+                        break;
+                    case 'n':
+                        result.push_back('\n');
+                        break;
+                    case 'r':
+                        result.push_back('\r');
+                        break;
+                    case 't':
+                        result.push_back('\t');
+                        break;
+                    case 'u':
+                    {
+                        uint32_t code = parseHex4();
+                        if (code >= 0xD800 && code < 0xDC00 && consumeLiteral("\\u"))
+                        {
+                            const uint32_t low = parseHex4();
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(result, code);
+                        break;
+                    }
+                    default:
+                        fail("Invalid escape sequence");
+                    }
+                }
+            }
+
+            Value parseNumber()
+            {
+                const size_t start = m_position;
+                while (m_position < m_text.size())
+                {
+                    const char c = m_text[m_position];
+                    if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e'
+                        || c == 'E')
+                    {
+                        m_position++;
+                        continue;
+                    }
+                    break;
+                }
+
+                double     number = 0.0;
+                const auto first = m_text.data() + start;
+                const auto last = m_text.data() + m_position;
+                const auto [end, error] = std::from_chars(first, last, number);
+                if (start == m_position || error != std::errc() || end != last)
+                {
+                    m_position = start;
+                    fail("Invalid number");
+                }
+                return Value(number);
+            }
+
+            std::string_view m_text;
+            size_t           m_position = 0;
+        };
+
+        void writeString(std::string& out, const std::string& value)
+        {
+            out.push_back('"');
+            for (const char c : value)
+            {
+                switch (c)
+                {
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                case '\n':
+                    out += "\\n";
+                    break;
+                case '\r':
+                    out += "\\r";
+                    break;
+                case '\t':
+                    out += "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        out += std::format("\\u{:04x}", static_cast<unsigned>(c));
+                    }
+                    else
+                    {
+                        out.push_back(c);
+                    }
+                }
+            }
+            out.push_back('"');
+        }
+
+        void writeValue(std::string& out, const Value& value, int indent, int depth)
+        {
+            const auto newline = [&](int level) {
+                if (indent > 0)
+                {
+                    out.push_back('\n');
+                    out.append(static_cast<size_t>(indent * level), ' ');
+                }
+            };
+
+            if (value.isNull())
+            {
+                out += "null";
+            }
+            else if (value.isBool())
+            {
+                out += value.asBool() ? "true" : "false";
+            }
+            else if (value.isNumber())
+            {
+                const double number = value.asNumber();
+                if (std::isfinite(number) && number == std::trunc(number)
+                    && std::abs(number) < 9.0e15)
+                {
+                    out += std::format("{}", static_cast<int64_t>(number));
+                }
+                else if (std::isfinite(number))
+                {
+                    out += std::format("{}", number);
+                }
+                else
+                {
+                    out += "null";
+                }
+            }
+            else if (value.isString())
+            {
+                writeString(out, value.asString());
+            }
+            else if (value.isArray())
+            {
+                const auto& array = value.asArray();
+                out.push_back('[');
+                for (size_t i = 0; i < array.size(); i++)
+                {
+                    newline(depth + 1);
+                    writeValue(out, array[i], indent, depth + 1);
+                    if (i + 1 < array.size())
+                    {
+                        out.push_back(',');
+                    }
+                }
+                if (!array.empty())
+                {
+                    newline(depth);
+                }
+                out.push_back(']');
+            }
+            else
+            {
+                const auto& object = value.asObject();
+                out.push_back('{');
+                for (size_t i = 0; i < object.size(); i++)
+                {
+                    newline(depth + 1);
+                    writeString(out, object[i].first);
+                    out += indent > 0 ? ": " : ":";
+                    writeValue(out, object[i].second, indent, depth + 1);
+                    if (i + 1 < object.size())
+                    {
+                        out.push_back(',');
+                    }
+                }
+                if (!object.empty())
+                {
+                    newline(depth);
+                }
+                out.push_back('}');
+            }
+        }
+
+        template <typename T>
+        const T& get(const auto& data, std::string_view typeName)
+        {
+            if (const T* value = std::get_if<T>(&data))
+            {
+                return *value;
+            }
+            throw std::runtime_error(std::format("JSON value is not a {}", typeName));
+        }
+    } // namespace
+
+    Value::Value(std::nullptr_t)
+        : m_data(nullptr)
+    {
+    }
+
+    Value::Value(bool value)
+        : m_data(value)
+    {
+    }
+
+    Value::Value(double value)
+        : m_data(value)
+    {
+    }
+
+    Value::Value(int64_t value)
+        : m_data(static_cast<double>(value))
+    {
+    }
+
+    Value::Value(std::string value)
+        : m_data(std::move(value))
+    {
+    }
+
+    Value::Value(const char* value)
+        : m_data(std::string(value))
+    {
+    }
+
+    Value::Value(Array value)
+        : m_data(std::move(value))
+    {
+    }
+
+    Value::Value(Object value)
+        : m_data(std::move(value))
+    {
+    }
+
+    bool Value::isNull() const
+    {
+        return std::holds_alternative<std::nullptr_t>(m_data);
+    }
+
+    bool Value::isBool() const
+    {
+        return std::holds_alternative<bool>(m_data);
+    }
+
+    bool Value::isNumber() const
+    {
+        return std::holds_alternative<double>(m_data);
+    }
+
+    bool Value::isString() const
+    {
+        return std::holds_alternative<std::string>(m_data);
+    }
+
+    bool Value::isArray() const
+    {
+        return std::holds_alternative<Array>(m_data);
+    }
+
+    bool Value::isObject() const
+    {
+        return std::holds_alternative<Object>(m_data);
+    }
+
+    bool Value::asBool() const
+    {
+        return get<bool>(m_data, "bool");
+    }
+
+    double Value::asNumber() const
+    {
+        return get<double>(m_data, "number");
+    }
+
+    const std::string& Value::asString() const
+    {
+        return get<std::string>(m_data, "string");
+    }
+
+    const Value::Array& Value::asArray() const
+    {
+        return get<Array>(m_data, "array");
+    }
+
+    const Value::Object& Value::asObject() const
+    {
+        return get<Object>(m_data, "object");
+    }
+
+    Value::Array& Value::asArray()
+    {
+        return const_cast<Array&>(std::as_const(*this).asArray());
+    }
+
+    Value::Object& Value::asObject()
+    {
+        return const_cast<Object&>(std::as_const(*this).asObject());
+    }
+
+    const Value* Value::find(std::string_view key) const
+    {
+        const auto* object = std::get_if<Object>(&m_data);
+        if (object == nullptr)
+        {
+            return nullptr;
+        }
+        for (const auto& [name, value] : *object)
+        {
+            if (name == key)
+            {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    const Value& Value::operator[](std::string_view key) const
+    {
+        if (const Value* value = find(key))
+        {
+            return *value;
+        }
+        throw std::runtime_error(std::format("JSON object has no member '{}'", key));
+    }
+
+    Value& Value::set(std::string_view key, Value value)
+    {
+        if (isNull())
+        {
+            m_data = Object {};
+        }
+        auto& object = asObject();
+        for (auto& [name, existing] : object)
+        {
+            if (name == key)
+            {
+                existing = std::move(value);
+                return existing;
+            }
+        }
+        return object.emplace_back(std::string(key), std::move(value)).second;
+    }
+
+    Value& Value::push(Value value)
+    {
+        if (isNull())
+        {
+            m_data = Array {};
+        }
+        return asArray().emplace_back(std::move(value));
+    }
+
+    Value parse(std::string_view text)
+    {
+        return Parser(text).parseDocument();
+    }
+
+    Value parseFile(const std::filesystem::path& path)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream)
+        {
+            throw std::runtime_error(std::format("Failed to open {} for read", path.string()));
+        }
+
+        std::ostringstream contents;
+        contents << stream.rdbuf();
+        try
+        {
+            return parse(contents.str());
+        }
+        catch (const std::runtime_error& error)
+        {
+            throw std::runtime_error(std::format("{}: {}", path.string(), error.what()));
+        }
+    }
+
+    std::string serialize(const Value& value, int indent)
+    {
+        std::string out;
+        writeValue(out, value, indent, 0);
+        return out;
+    }
+} // namespace Json
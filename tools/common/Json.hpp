@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace Json
+{
+    /// @brief Minimal JSON document value used by the command line tools.
+    class Value
+    {
+    public:
+        using Array = std::vector<Value>;
+        using Object = std::vector<std::pair<std::string, Value>>;
+
+        Value() = default;
+
+        Value(std::nullptr_t);
+
+        Value(bool value);
+
+        Value(double value);
+
+        Value(int64_t value);
+
+        Value(std::string value);
+
+        Value(const char* value);
+
+        Value(Array value);
+
+        Value(Object value);
+
+        [[nodiscard]] bool isNull() const;
+
+        [[nodiscard]] bool isBool() const;
+
+        [[nodiscard]] bool isNumber() const;
+
+        [[nodiscard]] bool isString() const;
+
+        [[nodiscard]] bool isArray() const;
+
+        [[nodiscard]] bool isObject() const;
+
+        /// @brief Accessors throw std::runtime_error when the value holds another type.
+        [[nodiscard]] bool asBool() const;
+
+        [[nodiscard]] double asNumber() const;
+
+        [[nodiscard]] const std::string& asString() const;
+
+        [[nodiscard]] const Array& asArray() const;
+
+        [[nodiscard]] const Object& asObject() const;
+
+        [[nodiscard]] Array& asArray();
+
+        [[nodiscard]] Object& asObject();
+
+        /// @brief Looks up an object member.
+        /// @param [in] key The member name.
+        /// @return Pointer to the member value, or nullptr if absent or not an object.
+        [[nodiscard]] const Value* find(std::string_view key) const;
+
+        /// @brief Looks up an object member, throwing if it is absent.
+        [[nodiscard]] const Value& operator[](std::string_view key) const;
+
+        /// @brief Inserts or replaces an object member.
+        Value& set(std::string_view key, Value value);
+
+        /// @brief Appends an element to an array.
+        Value& push(Value value);
+
+    private:
+        std::variant<std::nullptr_t, bool, double, std::string, Array, Object> m_data = nullptr;
+    };
+
+    /// @brief Parses a JSON document.
+    /// @param [in] text The document text.
+    /// @return The root value.
+    /// @throws std::runtime_error with line/column information on malformed input.
+    [[nodiscard]] Value parse(std::string_view text);
+
+    /// @brief Reads and parses a JSON document from disk.
+    [[nodiscard]] Value parseFile(const std::filesystem::path& path);
+
+    /// @brief Serializes a value to JSON text.
+    /// @param [in] value The value to serialize.
+    /// @param [in] indent Spaces per nesting level, or 0 for compact output.
+    [[nodiscard]] std::string serialize(const Value& value, int indent = 2);
+} // namespace Json
@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "Animation.hpp"
+#include "Benchmarks.hpp"
+#include "FrameArena.hpp"
+#include "Scenes.hpp"
+#include "ThreadPool.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t   g_characterCount = 1'024;
+        constexpr size_t   g_characterGrain = 16;
+        constexpr uint32_t g_limbCount = 7; ///< With g_limbJoints and the root, 64 joints.
+        constexpr uint32_t g_limbJoints = 9;
+        constexpr float    g_frameTime = 1.0F / 60.0F;
+
+        /// A crowd playing one clip, each character at a time of its own.
+        struct Crowd
+        {
+            Animation::Skeleton                 skeleton;
+            Animation::Clip                     clip;
+            std::vector<Animation::ClipSampler> samplers;
+            std::vector<Animation::Pose>        poses;
+            std::vector<Assets::Matrix4>        model;
+            FrameArena                          arena;
+            float                               time = 0.0F;
+
+            [[nodiscard]] float characterTime(const size_t character) const
+            {
+                return std::fmod(time + static_cast<float>(character) * 0.37F, clip.duration());
+            }
+        };
+
+        std::shared_ptr<Crowd> createCrowd()
+        {
+            auto character = createCharacter(g_limbCount, g_limbJoints);
+            auto crowd = std::make_shared<Crowd>();
+            crowd->skeleton = Animation::buildSkeleton(character, 0);
+            crowd->clip = Animation::Clip::compress(character.animations.front(), crowd->skeleton);
+            crowd->samplers.resize(g_characterCount);
+            crowd->poses.resize(g_characterCount);
+            crowd->model.resize(g_characterCount * crowd->skeleton.jointCount());
+            return crowd;
+        }
+
+        /// Reports joints per second as items, and joints per millisecond.
+        void reportJoints(State& state, const Crowd& crowd, const double seconds)
+        {
+            const size_t joints = g_characterCount * crowd.skeleton.jointCount();
+            state.setItems(joints);
+            state.setCounter("jointsPerMs", static_cast<double>(joints) / (seconds * 1'000.0));
+        }
+
+        /// Samples every character's pose with the batched sampler, spread over the
+        /// pool's threads.
+        Body sampleBody(const uint32_t threadCount)
+        {
+            auto crowd = createCrowd();
+            auto threadPool = std::make_shared<ThreadPool>(threadCount);
+            return [crowd, threadPool](State& state) {
+                const auto start = std::chrono::steady_clock::now();
+                threadPool->parallelFor(g_characterCount, g_characterGrain,
+                    [&crowd = *crowd](const size_t begin, const size_t end) {
+                        for (size_t character = begin; character < end; character++)
+                        {
+                            crowd.samplers[character].sample(
+                                crowd.clip, crowd.characterTime(character), crowd.poses[character]);
+                        }
+                    });
+                const std::chrono::duration<double> seconds
+                    = std::chrono::steady_clock::now() - start;
+                crowd->time += g_frameTime;
+                reportJoints(state, *crowd, seconds.count());
+            };
+        }
+
+        /// The baseline: one joint at a time through the scalar reference sampler.
+        Body sampleReferenceBody()
+        {
+            auto crowd = createCrowd();
+            return [crowd](State& state) {
+                const auto start = std::chrono::steady_clock::now();
+                for (size_t character = 0; character < g_characterCount; character++)
+                {
+                    const float      time = crowd->characterTime(character);
+                    Animation::Pose& pose = crowd->poses[character];
+                    pose.resize(crowd->clip.jointCount());
+                    for (size_t joint = 0; joint < crowd->clip.jointCount(); joint++)
+                    {
+                        pose.setJoint(joint, crowd->clip.sampleJoint(joint, time));
+                    }
+                }
+                const std::chrono::duration<double> seconds
+                    = std::chrono::steady_clock::now() - start;
+                crowd->time += g_frameTime;
+                reportJoints(state, *crowd, seconds.count());
+            };
+        }
+
+        /// Propagates sampled poses to model space and writes every character's
+        /// skinning matrices into a frame arena, as a frame would.
+        Body hierarchyBody()
+        {
+            auto crowd = createCrowd();
+            for (size_t character = 0; character < g_characterCount; character++)
+            {
+                crowd->samplers[character].sample(
+                    crowd->clip, crowd->characterTime(character), crowd->poses[character]);
+            }
+            return [crowd](State& state) {
+                const size_t jointCount = crowd->skeleton.jointCount();
+                const auto   start = std::chrono::steady_clock::now();
+                crowd->arena.reset();
+                for (size_t character = 0; character < g_characterCount; character++)
+                {
+                    const auto model = std::span(crowd->model).subspan(
+                        character * jointCount, jointCount);
+                    Animation::computeModelTransforms(
+                        crowd->skeleton, crowd->poses[character], model);
+                    (void)Animation::computeSkinningMatrices(crowd->skeleton, model, crowd->arena);
+                }
+                const std::chrono::duration<double> seconds
+                    = std::chrono::steady_clock::now() - start;
+                reportJoints(state, *crowd, seconds.count());
+            };
+        }
+    } // namespace
+
+    void registerAnimationBenchmarks(Suite& suite)
+    {
+        suite.add("Animation/Sample/Reference", [] { return sampleReferenceBody(); });
+        for (const uint32_t threads : { 1U, 2U, 4U, 8U })
+        {
+            suite.add(std::format("Animation/Sample/threads:{}", threads),
+                [threads] { return sampleBody(threads); });
+        }
+        suite.add("Animation/Hierarchy", [] { return hierarchyBody(); });
+    }
+} // namespace Bench
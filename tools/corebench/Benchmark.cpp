@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <format>
+#include <print>
+#include <stdexcept>
+
+namespace Bench
+{
+    namespace
+    {
+        /// Iterations of one repetition are capped so very fast bodies still finish.
+        constexpr uint64_t g_maxIterations = 1'000'000'000;
+
+        std::string formatTime(const double nanoseconds)
+        {
+            if (nanoseconds >= 1.0e9)
+            {
+                return std::format("{:.3f} s", nanoseconds / 1.0e9);
+            }
+            if (nanoseconds >= 1.0e6)
+            {
+                return std::format("{:.3f} ms", nanoseconds / 1.0e6);
+            }
+            if (nanoseconds >= 1.0e3)
+            {
+                return std::format("{:.3f} us", nanoseconds / 1.0e3);
+            }
+            return std::format("{:.1f} ns", nanoseconds);
+        }
+
+        std::string formatRate(const double perSecond)
+        {
+            if (perSecond >= 1.0e9)
+            {
+                return std::format("{:.2f} G/s", perSecond / 1.0e9);
+            }
+            if (perSecond >= 1.0e6)
+            {
+                return std::format("{:.2f} M/s", perSecond / 1.0e6);
+            }
+            if (perSecond >= 1.0e3)
+            {
+                return std::format("{:.2f} k/s", perSecond / 1.0e3);
+            }
+            return std::format("{:.2f} /s", perSecond);
+        }
+
+        double median(std::vector<double> values)
+        {
+            std::ranges::sort(values);
+            const size_t middle = values.size() / 2;
+            return values.size() % 2 == 1 ? values[middle]
+                                           : (values[middle - 1] + values[middle]) * 0.5;
+        }
+    } // namespace
+
+    void State::pauseTiming()
+    {
+        m_elapsed += Clock::now() - m_start;
+    }
+
+    void State::resumeTiming()
+    {
+        m_start = Clock::now();
+    }
+
+    void State::setItems(const uint64_t items)
+    {
+        m_items += items;
+    }
+
+    void State::setCounter(const std::string_view name, const double value)
+    {
+        m_counters[std::string(name)] = value;
+    }
+
+    void Suite::add(std::string name, Setup setup)
+    {
+        if (std::ranges::any_of(m_entries, [&](const Entry& entry) { return entry.name == name; }))
+        {
+            throw std::runtime_error(std::format("Benchmark {} is registered twice", name));
+        }
+        m_entries.push_back({ .name = std::move(name), .setup = std::move(setup) });
+    }
+
+    std::vector<std::string> Suite::names() const
+    {
+        std::vector<std::string> result;
+        for (const auto& entry : m_entries)
+        {
+            result.push_back(entry.name);
+        }
+        return result;
+    }
+
+    Json::Value Suite::run(const RunOptions& options) const
+    {
+        size_t nameWidth = 9;
+        for (const auto& entry : m_entries)
+        {
+            nameWidth = std::max(nameWidth, entry.name.size());
+        }
+        std::println("{:<{}}  {:>12}  {:>12}  {:>10}  {}", "Benchmark", nameWidth, "Time",
+            "Items", "Iterations", "Counters");
+        std::println("{}", std::string(nameWidth + 60, '-'));
+
+        Json::Value  document;
+        Json::Value& entries = document.set("benchmarks", Json::Value::Array {});
+        for (const auto& entry : m_entries)
+        {
+            if (!std::regex_search(entry.name, options.filter))
+            {
+                continue;
+            }
+
+            const Body body = entry.setup();
+            State      state;
+            const auto runIterations = [&](const uint64_t iterations) {
+                state.m_elapsed = {};
+                state.m_items = 0;
+                for (uint64_t i = 0; i < iterations; i++)
+                {
+                    state.m_start = State::Clock::now();
+                    body(state);
+                    state.pauseTiming();
+                }
+                return std::chrono::duration<double, std::nano>(state.m_elapsed).count();
+            };
+
+            // The first iteration warms caches and sizes the repetitions
+            const double   warmup = std::max(runIterations(1), 1.0);
+            const uint64_t iterations = std::clamp<uint64_t>(
+                static_cast<uint64_t>(options.minSeconds * 1.0e9 / warmup), 1, g_maxIterations);
+
+            std::vector<double> samples;
+            double              totalNanoseconds = 0.0;
+            uint64_t            totalItems = 0;
+            for (uint32_t repetition = 0; repetition < options.repetitions; repetition++)
+            {
+                const double nanoseconds = runIterations(iterations);
+                samples.push_back(nanoseconds / static_cast<double>(iterations));
+                totalNanoseconds += nanoseconds;
+                totalItems += state.m_items;
+            }
+
+            const double time = median(samples);
+            const double itemsPerSecond = totalNanoseconds > 0.0
+                ? static_cast<double>(totalItems) * 1.0e9 / totalNanoseconds
+                : 0.0;
+            std::string counters;
+            for (const auto& [name, value] : state.m_counters)
+            {
+                counters += std::format("{}={:.4g} ", name, value);
+            }
+            std::println("{:<{}}  {:>12}  {:>12}  {:>10}  {}", entry.name, nameWidth,
+                formatTime(time), totalItems > 0 ? formatRate(itemsPerSecond) : "-", iterations,
+                counters);
+
+            Json::Value result;
+            result.set("name", entry.name);
+            result.set("run_name", entry.name);
+            result.set("run_type", "iteration");
+            result.set("repetitions", static_cast<int64_t>(options.repetitions));
+            result.set("iterations", static_cast<int64_t>(iterations));
+            result.set("real_time", time);
+            result.set("cpu_time", time);
+            result.set("time_unit", "ns");
+            Json::Value& sampleArray = result.set("samples", Json::Value::Array {});
+            for (const double sample : samples)
+            {
+                sampleArray.push(sample);
+            }
+            if (totalItems > 0)
+            {
+                result.set("items_per_second", itemsPerSecond);
+            }
+            for (const auto& [name, value] : state.m_counters)
+            {
+                result.set(name, value);
+            }
+            entries.push(std::move(result));
+        }
+        return document;
+    }
+} // namespace Bench
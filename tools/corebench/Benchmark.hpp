@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Json.hpp"
+
+namespace Bench
+{
+    /// @brief Timing of one iteration, passed to the benchmark body.
+    class State
+    {
+    public:
+        /// @brief Excludes the work until resumeTiming() from the measurement, e.g.
+        /// preparing the input of the next iteration.
+        void pauseTiming();
+
+        void resumeTiming();
+
+        /// @brief Items the iteration processed, reported per second.
+        void setItems(uint64_t items);
+
+        /// @brief Reports a value along with the benchmark; the last iteration wins.
+        void setCounter(std::string_view name, double value);
+
+    private:
+        friend class Suite;
+
+        using Clock = std::chrono::steady_clock;
+
+        Clock::time_point             m_start;
+        Clock::duration               m_elapsed {};
+        uint64_t                      m_items = 0;
+        std::map<std::string, double> m_counters;
+    };
+
+    /// @brief Runs one iteration of a benchmark.
+    using Body = std::function<void(State&)>;
+
+    /// @brief Prepares the input of a benchmark outside of the measurement and
+    /// returns its body. The input lives as long as the body.
+    using Setup = std::function<Body()>;
+
+    struct RunOptions
+    {
+        std::regex filter { ".*" };
+        uint32_t   repetitions = 5;
+        double     minSeconds = 0.1; ///< Per repetition.
+    };
+
+    /// @brief Registered benchmarks and their results, written in the JSON format
+    /// benchcompare reads.
+    class Suite
+    {
+    public:
+        /// @throws std::runtime_error if the name is already registered.
+        void add(std::string name, Setup setup);
+
+        [[nodiscard]] std::vector<std::string> names() const;
+
+        /// @brief Runs the benchmarks whose name matches the filter, printing a line
+        /// for each.
+        /// @return The results as a JSON document with a "benchmarks" array.
+        [[nodiscard]] Json::Value run(const RunOptions& options) const;
+
+    private:
+        struct Entry
+        {
+            std::string name;
+            Setup       setup;
+        };
+
+        std::vector<Entry> m_entries;
+    };
+} // namespace Bench
@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Benchmark.hpp"
+
+namespace Bench
+{
+    /// @brief Sampling a crowd of 64 joint characters' poses at several thread counts
+    /// and against the scalar reference, and building their skinning matrices.
+    void registerAnimationBenchmarks(Suite& suite);
+
+    /// @brief Loading a cooked mesh file against the same meshes as glTF, with the
+    /// files in and, where the platform can evict them, out of the OS cache.
+    void registerCookedMeshBenchmarks(Suite& suite);
+
+    /// @brief ECS iteration against an array of structs, structural change churn,
+    /// parallel scaling and a scheduled set of systems.
+    void registerEcsBenchmarks(Suite& suite);
+
+    /// @brief A frame's transient containers allocated from a frame arena against
+    /// the heap, with the heap allocations each makes.
+    void registerFrameArenaBenchmarks(Suite& suite);
+
+    /// @brief Compiling frame graphs of hundreds of passes, with and without
+    /// declaring them.
+    void registerFrameGraphBenchmarks(Suite& suite);
+
+    /// @brief Simplifying a large sphere and building its LOD chain, and selecting LODs
+    /// for a million instances by screen space error.
+    void registerLodBenchmarks(Suite& suite);
+
+    /// @brief Snapshot mailbox publish and consume cost on one thread, and latency
+    /// from a producer thread to the consumer.
+    void registerMailboxBenchmarks(Suite& suite);
+
+    /// @brief Building meshlets of a quarter million triangle sphere, and culling them
+    /// against the frustum and their normal cones from two cameras.
+    void registerMeshletBenchmarks(Suite& suite);
+
+    /// @brief Welding, vertex cache, overdraw and vertex fetch optimization of a large
+    /// shuffled grid, with the ACMR and ATVR of the result.
+    void registerMeshOptimizerBenchmarks(Suite& suite);
+
+    /// @brief Encoding a million draws' batches into one command buffer per thread,
+    /// at several thread counts.
+    void registerParallelEncodeBenchmarks(Suite& suite);
+
+    /// @brief Shader variant keys from runtime feature values, with and without
+    /// naming the variant's functions.
+    void registerPermutationBenchmarks(Suite& suite);
+
+    /// @brief Pipeline key computation and cache lookups from several threads at
+    /// once.
+    void registerPipelineCacheBenchmarks(Suite& suite);
+
+    /// @brief Software rasterizer triangle throughput, binning through resolve, at
+    /// several thread counts.
+    void registerRasterBenchmarks(Suite& suite);
+
+    /// @brief Sorting and batching a million draws against a comparison sort.
+    void registerRenderQueueBenchmarks(Suite& suite);
+
+    /// @brief Loading a generated glTF scene of hundreds of meshes from memory, at
+    /// several thread counts.
+    void registerSceneLoaderBenchmarks(Suite& suite);
+
+    /// @brief Scanning the includes of a tree of shaders, an incremental shader build
+    /// with nothing to do and reflecting the layouts of a thousand structs.
+    void registerShaderBuildBenchmarks(Suite& suite);
+
+    /// @brief Linear blend and dual quaternion skinning of a million vertices with 4
+    /// and 8 influences, at several thread counts.
+    void registerSkinningBenchmarks(Suite& suite);
+
+    /// @brief Transform hierarchy updates over a million nodes at several dirty
+    /// ratios.
+    void registerTransformBenchmarks(Suite& suite);
+
+    /// @brief Millions of small fenced upload ring allocations, with and without
+    /// writing them.
+    void registerUploadRingBenchmarks(Suite& suite);
+
+    /// @brief Quantizing a million vertices into the compact stream formats, with the
+    /// bytes per vertex before and after.
+    void registerVertexQuantizationBenchmarks(Suite& suite);
+} // namespace Bench
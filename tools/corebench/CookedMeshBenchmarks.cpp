@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "CookedMesh.hpp"
+#include "SceneLoader.hpp"
+#include "Scenes.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t   g_meshCount = 256;
+        constexpr uint32_t g_gridSize = 64;
+
+        /// The same grids as a .glb scene and a cooked mesh file, in a temporary
+        /// directory removed with the object.
+        struct SceneFiles
+        {
+            explicit SceneFiles(const std::string_view name)
+                : root(std::filesystem::temp_directory_path() / std::format("corebench-{}", name))
+            {
+                std::filesystem::remove_all(root);
+                std::filesystem::create_directories(root);
+
+                const auto    glb = createGridScene(g_meshCount, g_gridSize);
+                std::ofstream stream(root / "grids.glb", std::ios::binary);
+                stream.write(reinterpret_cast<const char*>(glb.data()),
+                    static_cast<std::streamsize>(glb.size()));
+                stream.close();
+
+                Assets::writeCookedMeshes(
+                    root / "grids.cmsh", createGridMeshes(g_meshCount, g_gridSize));
+            }
+
+            ~SceneFiles()
+            {
+                std::error_code ignored;
+                std::filesystem::remove_all(root, ignored);
+            }
+
+            std::filesystem::path root;
+        };
+
+        /// Drops the file's pages from the OS cache, so the next load reads the disk.
+        /// Only platforms with posix_fadvise can; elsewhere the cold runs stay warm.
+        void evict(const std::filesystem::path& path)
+        {
+#if defined(POSIX_FADV_DONTNEED)
+            const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (descriptor >= 0)
+            {
+                ::posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+                ::close(descriptor);
+            }
+#else
+            (void)path;
+#endif
+        }
+
+        /// Loads the glTF scene into vertex streams, ready to upload.
+        Body gltfBody(const bool cold)
+        {
+            auto files = std::make_shared<SceneFiles>(cold ? "gltf-cold" : "gltf-warm");
+            return [files, cold](State& state) {
+                const auto path = files->root / "grids.glb";
+                if (cold)
+                {
+                    state.pauseTiming();
+                    evict(path);
+                    state.resumeTiming();
+                }
+
+                const Assets::Scene scene =
+                    Assets::SceneLoader({ .vertexFormat = Assets::VertexFormat::Streams,
+                                            .threadPool = nullptr })
+                        .load(path);
+                state.setItems(scene.meshes.size());
+                state.setCounter(
+                    "megabytes", static_cast<double>(std::filesystem::file_size(path)) / 1e6);
+            };
+        }
+
+        /// Maps the cooked file and copies every stream and full detail index buffer
+        /// into a staging buffer, as uploading them would.
+        Body cookedBody(const bool cold)
+        {
+            auto files = std::make_shared<SceneFiles>(cold ? "cooked-cold" : "cooked-warm");
+            auto staging = std::make_shared<std::vector<std::byte>>();
+            return [files, staging, cold](State& state) {
+                const auto path = files->root / "grids.cmsh";
+                if (cold)
+                {
+                    state.pauseTiming();
+                    evict(path);
+                    state.resumeTiming();
+                }
+
+                const Assets::CookedMeshFile file(path);
+                staging->resize(file.bytes().size());
+                size_t     offset = 0;
+                const auto stage = [&](const std::span<const std::byte> bytes) {
+                    std::memcpy(staging->data() + offset, bytes.data(), bytes.size());
+                    offset += bytes.size();
+                };
+                for (size_t mesh = 0; mesh < file.meshCount(); mesh++)
+                {
+                    for (const auto& primitive : file.primitives(mesh))
+                    {
+                        for (size_t attribute = 0; attribute < Assets::g_vertexAttributeCount;
+                             attribute++)
+                        {
+                            stage(file.stream(
+                                primitive, static_cast<Assets::VertexAttribute>(attribute)));
+                        }
+                        stage(file.indices(primitive, file.lods(primitive).front()));
+                    }
+                }
+                state.setItems(file.meshCount());
+                state.setCounter("megabytes", static_cast<double>(file.bytes().size()) / 1e6);
+            };
+        }
+    } // namespace
+
+    void registerCookedMeshBenchmarks(Suite& suite)
+    {
+        for (const bool cold : { true, false })
+        {
+            const char* cache = cold ? "cold" : "warm";
+            suite.add(
+                std::format("CookedMesh/Load/{}", cache), [cold] { return cookedBody(cold); });
+            suite.add(
+                std::format("CookedMesh/Gltf/{}", cache), [cold] { return gltfBody(cold); });
+        }
+    }
+} // namespace Bench
@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "Ecs.hpp"
+#include "EcsScheduler.hpp"
+#include "ThreadPool.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t g_entityCount = 1'000'000;
+        constexpr size_t g_churnCount = 100'000;
+        constexpr float  g_deltaTime = 1.0F / 60.0F;
+
+        struct Position
+        {
+            float x = 0.0F;
+            float y = 0.0F;
+            float z = 0.0F;
+        };
+
+        struct Velocity
+        {
+            float x = 0.0F;
+            float y = 0.0F;
+            float z = 0.0F;
+        };
+
+        struct Health
+        {
+            float value = 100.0F;
+        };
+
+        /// State the iteration does not touch, like the rest of a scene object.
+        struct Payload
+        {
+            std::array<float, 16> matrix {};
+            std::array<char, 32>  name {};
+        };
+
+        template <size_t TIndex>
+        struct Tag
+        {
+            uint32_t value = TIndex;
+        };
+
+        /// The ad hoc layout: every object in one struct, in one array.
+        struct Object
+        {
+            Position position;
+            Velocity velocity;
+            Health   health;
+            Payload  payload;
+        };
+
+        Velocity velocity(const size_t index)
+        {
+            const auto angle = static_cast<float>(index) * 0.001F;
+            return { std::cos(angle), std::sin(angle), 0.5F };
+        }
+
+        void integrate(Position& position, const Velocity& velocity)
+        {
+            position.x += velocity.x * g_deltaTime;
+            position.y += velocity.y * g_deltaTime;
+            position.z += velocity.z * g_deltaTime;
+        }
+
+        std::shared_ptr<Ecs::World> createWorld(const size_t count)
+        {
+            auto world = std::make_shared<Ecs::World>();
+            for (size_t i = 0; i < count; i++)
+            {
+                static_cast<void>(world->create(Position {}, velocity(i), Health {}, Payload {}));
+            }
+            return world;
+        }
+
+        /// Spreads the entities over 16 archetypes by adding one of 16 tags.
+        template <size_t... TIndices>
+        void fragment(Ecs::World& world, std::index_sequence<TIndices...>)
+        {
+            std::vector<Ecs::Entity> entities;
+            world.forEachChunk<const Position>(
+                [&](const std::span<const Ecs::Entity> chunk, const Position*) {
+                    entities.insert(entities.end(), chunk.begin(), chunk.end());
+                });
+            for (size_t i = 0; i < entities.size(); i++)
+            {
+                static_cast<void>(((i % sizeof...(TIndices) == TIndices
+                                       ? (world.add(entities[i], Tag<TIndices> {}), true)
+                                       : false)
+                    || ...));
+            }
+        }
+
+        Body iterateBody(const bool fragmented)
+        {
+            auto world = createWorld(g_entityCount);
+            if (fragmented)
+            {
+                fragment(*world, std::make_index_sequence<16>());
+            }
+            return [world](State& state) {
+                world->forEach<Position, const Velocity>(integrate);
+                state.setItems(g_entityCount);
+                state.setCounter("archetypes", static_cast<double>(world->archetypeCount()));
+            };
+        }
+
+        Body iterateArrayOfStructsBody()
+        {
+            auto objects = std::make_shared<std::vector<Object>>(g_entityCount);
+            for (size_t i = 0; i < g_entityCount; i++)
+            {
+                (*objects)[i].velocity = velocity(i);
+            }
+            return [objects](State& state) {
+                for (Object& object : *objects)
+                {
+                    integrate(object.position, object.velocity);
+                }
+                state.setItems(g_entityCount);
+            };
+        }
+
+        /// Per entity work heavy enough for threads to matter.
+        Body parallelIterateBody(const uint32_t threadCount)
+        {
+            auto world = createWorld(g_entityCount);
+            auto threadPool = std::make_shared<ThreadPool>(threadCount);
+            return [world, threadPool](State& state) {
+                world->parallelForEach<Position, const Velocity, Health>(*threadPool,
+                    [](Position& position, const Velocity& velocity, Health& health) {
+                        integrate(position, velocity);
+                        const float distance = std::sqrt(position.x * position.x
+                            + position.y * position.y + position.z * position.z);
+                        health.value = 100.0F * std::exp(-distance) + std::sin(distance);
+                    });
+                state.setItems(g_entityCount);
+            };
+        }
+
+        Body addRemoveBody(const bool deferred)
+        {
+            auto world = createWorld(g_churnCount);
+            auto entities = std::make_shared<std::vector<Ecs::Entity>>();
+            world->forEachChunk<>([&](const std::span<const Ecs::Entity> chunk) {
+                entities->insert(entities->end(), chunk.begin(), chunk.end());
+            });
+            return [world, entities, deferred](State& state) {
+                if (deferred)
+                {
+                    Ecs::CommandBuffer commands;
+                    for (const Ecs::Entity entity : *entities)
+                    {
+                        commands.add(entity, Tag<0> {});
+                    }
+                    static_cast<void>(world->apply(commands));
+                    for (const Ecs::Entity entity : *entities)
+                    {
+                        commands.remove<Tag<0>>(entity);
+                    }
+                    static_cast<void>(world->apply(commands));
+                }
+                else
+                {
+                    for (const Ecs::Entity entity : *entities)
+                    {
+                        world->add(entity, Tag<0> {});
+                    }
+                    for (const Ecs::Entity entity : *entities)
+                    {
+                        world->remove<Tag<0>>(entity);
+                    }
+                }
+                state.setItems(2 * g_churnCount);
+            };
+        }
+
+        Body createDestroyBody()
+        {
+            auto world = std::make_shared<Ecs::World>();
+            return [world](State& state) {
+                std::vector<Ecs::Entity> entities;
+                entities.reserve(g_churnCount);
+                for (size_t i = 0; i < g_churnCount; i++)
+                {
+                    entities.push_back(world->create(Position {}, velocity(i), Health {}));
+                }
+                for (const Ecs::Entity entity : entities)
+                {
+                    world->destroy(entity);
+                }
+                state.setItems(2 * g_churnCount);
+            };
+        }
+
+        /// Four systems in two stages: movement and regeneration do not conflict,
+        /// damage and the transform copy each read what one of them writes.
+        Body schedulerBody()
+        {
+            struct Context
+            {
+                std::shared_ptr<Ecs::World> world = createWorld(g_entityCount);
+                ThreadPool                  threadPool;
+                Ecs::Scheduler              scheduler;
+            };
+
+            auto context = std::make_shared<Context>();
+            context->scheduler.add("move", Ecs::Access {}.write<Position>().read<Velocity>(),
+                [](const Ecs::SystemContext& system) {
+                    system.parallelForEach<Position, const Velocity>(integrate);
+                });
+            context->scheduler.add("regenerate", Ecs::Access {}.write<Health>(),
+                [](const Ecs::SystemContext& system) {
+                    system.parallelForEach<Health>([](Health& health) {
+                        health.value = std::min(health.value + 0.1F, 100.0F);
+                    });
+                });
+            context->scheduler.add("damage", Ecs::Access {}.read<Position>().write<Health>(),
+                [](const Ecs::SystemContext& system) {
+                    system.parallelForEach<const Position, Health>(
+                        [](const Position& position, Health& health) {
+                            health.value -= position.z > 1000.0F ? 1.0F : 0.0F;
+                        });
+                });
+            context->scheduler.add("transform", Ecs::Access {}.read<Position>().write<Payload>(),
+                [](const Ecs::SystemContext& system) {
+                    system.parallelForEach<const Position, Payload>(
+                        [](const Position& position, Payload& payload) {
+                            payload.matrix[12] = position.x;
+                            payload.matrix[13] = position.y;
+                            payload.matrix[14] = position.z;
+                        });
+                });
+
+            return [context](State& state) {
+                context->scheduler.run(*context->world, context->threadPool);
+                state.setItems(g_entityCount);
+                state.setCounter("stages", static_cast<double>(context->scheduler.stageCount()));
+            };
+        }
+    } // namespace
+
+    void registerEcsBenchmarks(Suite& suite)
+    {
+        suite.add("Ecs/Iterate", [] { return iterateBody(false); });
+        suite.add("Ecs/IterateFragmented", [] { return iterateBody(true); });
+        suite.add("Ecs/IterateArrayOfStructs", [] { return iterateArrayOfStructsBody(); });
+        for (const uint32_t threads : { 1U, 2U, 4U, 8U })
+        {
+            suite.add(std::format("Ecs/ParallelIterate/threads:{}", threads),
+                [threads] { return parallelIterateBody(threads); });
+        }
+        suite.add("Ecs/AddRemove", [] { return addRemoveBody(false); });
+        suite.add("Ecs/AddRemoveDeferred", [] { return addRemoveBody(true); });
+        suite.add("Ecs/CreateDestroy", [] { return createDestroyBody(); });
+        suite.add("Ecs/Scheduler", [] { return schedulerBody(); });
+    }
+} // namespace Bench
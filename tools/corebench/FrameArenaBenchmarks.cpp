@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "FrameArena.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t g_containersPerFrame = 10'000;
+
+        /// Passes allocations on to the heap and counts them.
+        class CountingResource final : public std::pmr::memory_resource
+        {
+        public:
+            [[nodiscard]] size_t allocations() const
+            {
+                return m_allocations;
+            }
+
+            void reset()
+            {
+                m_allocations = 0;
+            }
+
+        private:
+            void* do_allocate(const size_t bytes, const size_t alignment) override
+            {
+                m_allocations++;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* pointer, const size_t bytes, const size_t alignment) override
+            {
+                std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+            }
+
+            [[nodiscard]] bool do_is_equal(
+                const std::pmr::memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+
+            size_t m_allocations = 0;
+        };
+
+        /// The transient containers of a frame: small scratch lists of a few to a
+        /// few hundred elements, as culling and sorting build them.
+        size_t buildFrame(std::pmr::memory_resource& resource)
+        {
+            std::pmr::vector<std::pmr::vector<float>> lists(&resource);
+            lists.reserve(g_containersPerFrame);
+            size_t elements = 0;
+            for (size_t i = 0; i < g_containersPerFrame; i++)
+            {
+                auto& list = lists.emplace_back();
+                for (size_t j = 0; j < 4 + (i * 37) % 200; j++)
+                {
+                    list.push_back(static_cast<float>(j));
+                }
+                elements += list.size();
+            }
+            return elements;
+        }
+
+        Body arenaBody()
+        {
+            auto arena = std::make_shared<FrameArena>();
+            return [arena](State& state) {
+                const uint64_t blocks = arena->statistics().blockAllocations;
+                arena->reset();
+                const size_t elements = buildFrame(*arena);
+                state.setItems(g_containersPerFrame);
+                state.setCounter("elements", static_cast<double>(elements));
+                state.setCounter(
+                    "arenaAllocations", static_cast<double>(arena->statistics().allocationCount));
+                state.setCounter("heapAllocations",
+                    static_cast<double>(arena->statistics().blockAllocations - blocks));
+            };
+        }
+
+        /// The baseline: the same containers allocating from the heap.
+        Body heapBody()
+        {
+            auto resource = std::make_shared<CountingResource>();
+            return [resource](State& state) {
+                resource->reset();
+                const size_t elements = buildFrame(*resource);
+                state.setItems(g_containersPerFrame);
+                state.setCounter("elements", static_cast<double>(elements));
+                state.setCounter("heapAllocations", static_cast<double>(resource->allocations()));
+            };
+        }
+    } // namespace
+
+    void registerFrameArenaBenchmarks(Suite& suite)
+    {
+        suite.add("FrameArena/Arena", [] { return arenaBody(); });
+        suite.add("FrameArena/Heap", [] { return heapBody(); });
+    }
+} // namespace Bench
@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "FrameGraph.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr uint32_t g_width = 1920;
+        constexpr uint32_t g_height = 1080;
+
+        Render::MemoryRequirements queryMemory(const Render::TextureDesc& desc)
+        {
+            const uint64_t size = uint64_t { desc.width } * desc.height * desc.sampleCount * 4;
+            return { .size = (size + 0xFFFF) & ~uint64_t { 0xFFFF }, .alignment = 0x10000 };
+        }
+
+        /// A deferred frame of passCount passes: four shadow cascades, a G-buffer and
+        /// lighting pass per view, then a chain of post-processing passes at
+        /// alternating resolutions. Every eighth post pass writes a debug view
+        /// nothing reads, which compile() culls.
+        void declareFrame(Render::FrameGraph& graph, const uint32_t passCount)
+        {
+            using Render::ResourceAccess;
+
+            graph.clear();
+            const auto drawable = graph.importTexture("Drawable",
+                { .width = g_width, .height = g_height }, ResourceAccess::None,
+                ResourceAccess::Present);
+
+            std::vector<Render::ResourceHandle> cascades;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                cascades.push_back(graph.createTexture(
+                    std::format("Cascade{}", i), { .width = 2048, .height = 2048 }));
+                graph.addPass(std::format("Shadow{}", i))
+                    .write(cascades.back(), ResourceAccess::DepthStencil);
+            }
+
+            const Render::TextureDesc fullScreen { .width = g_width, .height = g_height };
+            const auto                depth = graph.createTexture("Depth", fullScreen);
+            const auto                albedo = graph.createTexture("Albedo", fullScreen);
+            const auto                normal = graph.createTexture("Normal", fullScreen);
+            graph.addPass("GBuffer")
+                .write(depth, ResourceAccess::DepthStencil)
+                .write(albedo)
+                .write(normal);
+
+            auto       lit = graph.createTexture("Lit", fullScreen);
+            auto&&     lighting = graph.addPass("Lighting").read(depth).read(albedo).read(normal);
+            for (const auto cascade : cascades)
+            {
+                lighting.read(cascade);
+            }
+            lighting.write(lit, ResourceAccess::ShaderWrite);
+
+            for (uint32_t i = 6; i + 1 < passCount; i++)
+            {
+                const uint32_t scale = i % 3 == 0 ? 2 : 1;
+                const auto     output = graph.createTexture(std::format("Post{}", i),
+                        { .width = g_width / scale, .height = g_height / scale });
+                auto&&         pass = graph.addPass(std::format("Post{}", i)).read(lit);
+                if (i % 8 == 0)
+                {
+                    pass.read(depth);
+                }
+                pass.write(output, ResourceAccess::ShaderWrite);
+
+                // Debug views are declared but never consumed
+                if (i % 8 == 7)
+                {
+                    const auto debug = graph.createTexture(std::format("Debug{}", i), fullScreen);
+                    graph.addPass(std::format("DebugView{}", i)).read(output).write(debug);
+                    i++;
+                }
+                lit = output;
+            }
+            graph.addPass("Present").read(lit).write(drawable);
+        }
+
+        /// Checks what the repo has no unit tests for: no two textures alive at the
+        /// same time share memory, and culling removed exactly the debug views.
+        void checkCompiled(const Render::FrameGraph& graph, const uint32_t passCount)
+        {
+            for (uint32_t a = 0; a < graph.resourceCount(); a++)
+            {
+                for (uint32_t b = a + 1; b < graph.resourceCount(); b++)
+                {
+                    const uint64_t offsetA = graph.heapOffset({ a });
+                    const uint64_t offsetB = graph.heapOffset({ b });
+                    if (offsetA == Render::g_invalidOffset || offsetB == Render::g_invalidOffset)
+                    {
+                        continue;
+                    }
+                    const auto     lifetimeA = graph.lifetime({ a });
+                    const auto     lifetimeB = graph.lifetime({ b });
+                    const uint64_t sizeA = queryMemory(graph.textureDesc({ a })).size;
+                    const uint64_t sizeB = queryMemory(graph.textureDesc({ b })).size;
+                    if (lifetimeA.first <= lifetimeB.last && lifetimeB.first <= lifetimeA.last
+                        && offsetA < offsetB + sizeB && offsetB < offsetA + sizeA)
+                    {
+                        throw std::runtime_error(std::format("Frame graph placed '{}' and '{}' "
+                                                             "in the same memory",
+                            graph.resourceName({ a }), graph.resourceName({ b })));
+                    }
+                }
+            }
+
+            for (uint32_t pass = 0; pass < graph.passCount(); pass++)
+            {
+                if (graph.isCulled(pass) != graph.passName(pass).starts_with("DebugView"))
+                {
+                    throw std::runtime_error(std::format(
+                        "Frame graph of {} passes culled '{}' wrongly", passCount,
+                        graph.passName(pass)));
+                }
+            }
+        }
+
+        void setCounters(State& state, const Render::FrameGraph& graph)
+        {
+            const Render::FrameGraphStatistics& statistics = graph.statistics();
+            state.setItems(statistics.passes);
+            state.setCounter("culled", static_cast<double>(statistics.culledPasses));
+            state.setCounter("barriers",
+                static_cast<double>(statistics.transitionBarriers + statistics.aliasingBarriers));
+            state.setCounter("heapSaved",
+                1.0
+                    - static_cast<double>(statistics.heapBytes)
+                        / static_cast<double>(statistics.transientBytes));
+        }
+
+        /// Compiling alone, for a frame whose shape did not change.
+        Body compileBody(const uint32_t passCount)
+        {
+            auto graph = std::make_shared<Render::FrameGraph>();
+            declareFrame(*graph, passCount);
+            graph->compile(queryMemory);
+            checkCompiled(*graph, passCount);
+            return [graph](State& state) {
+                graph->compile(queryMemory);
+                setCounters(state, *graph);
+            };
+        }
+
+        /// Declaring and compiling, as when the graph is rebuilt every frame.
+        Body declareAndCompileBody(const uint32_t passCount)
+        {
+            auto graph = std::make_shared<Render::FrameGraph>();
+            return [graph, passCount](State& state) {
+                declareFrame(*graph, passCount);
+                graph->compile(queryMemory);
+                setCounters(state, *graph);
+            };
+        }
+    } // namespace
+
+    void registerFrameGraphBenchmarks(Suite& suite)
+    {
+        for (const uint32_t passes : { 128U, 512U })
+        {
+            suite.add(std::format("FrameGraph/Compile/passes:{}", passes),
+                [passes] { return compileBody(passes); });
+            suite.add(std::format("FrameGraph/DeclareAndCompile/passes:{}", passes),
+                [passes] { return declareAndCompileBody(passes); });
+        }
+    }
+} // namespace Bench
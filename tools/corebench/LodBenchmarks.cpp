@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "LodSelection.hpp"
+#include "MeshSimplifier.hpp"
+#include "Scenes.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr uint32_t g_rings = 256;       ///< With g_segments, 196096 triangles.
+        constexpr uint32_t g_segments = 384;
+        constexpr size_t   g_instanceCount = 1'000'000;
+        constexpr float    g_viewportHeight = 1'080.0F;
+        constexpr float    g_projectionScale = 1.7320508F; ///< 60 degree field of view.
+
+        /// Reports input triangles per second and the error of the last run.
+        Body simplifyBody()
+        {
+            auto sphere = std::make_shared<Assets::Primitive>(createSphere(g_rings, g_segments));
+            return [sphere](State& state) {
+                const auto result = Assets::simplifyMesh(
+                    sphere->indices, sphere->streams, sphere->indices.size() / 4);
+                state.setItems(sphere->indices.size() / 3);
+                state.setCounter("keptTriangles", static_cast<double>(result.indices.size() / 3));
+                state.setCounter("error", result.error);
+            };
+        }
+
+        /// Reports input triangles per second and the levels of the last chain.
+        Body chainBody()
+        {
+            auto sphere = std::make_shared<Assets::Primitive>(createSphere(g_rings, g_segments));
+            return [sphere](State& state) {
+                const auto chain = Assets::generateLodChain(sphere->indices, sphere->streams);
+                state.setItems(sphere->indices.size() / 3);
+                state.setCounter("lods", static_cast<double>(chain.size()));
+                state.setCounter("lastError", chain.back().error);
+            };
+        }
+
+        struct Selection
+        {
+            std::vector<Assets::CookedLod>   lods;
+            std::vector<Assets::LodInstance> instances;
+            std::vector<uint32_t>            selected;
+        };
+
+        /// Selects LODs of the sphere's chain for a frame of instances scattered close
+        /// enough around the camera that every level gets picked, reporting instances
+        /// per second and the mean level.
+        Body selectBody()
+        {
+            auto       selection = std::make_shared<Selection>();
+            const auto sphere = createSphere(g_rings / 4, g_segments / 4);
+            for (const auto& level : Assets::generateLodChain(sphere.indices, sphere.streams))
+            {
+                // Relative to the extent of 2
+                Assets::CookedLod lod;
+                lod.indexCount = static_cast<uint32_t>(level.indices.size());
+                lod.error = level.error * 2.0F;
+                selection->lods.push_back(lod);
+            }
+
+            std::mt19937                          random(42);
+            std::uniform_real_distribution<float> position(-16.0F, 16.0F);
+            std::uniform_real_distribution<float> scale(0.5F, 4.0F);
+            selection->instances.resize(g_instanceCount);
+            for (auto& instance : selection->instances)
+            {
+                instance.scale = scale(random);
+                instance.center = { position(random), position(random), position(random) };
+                instance.radius = instance.scale;
+            }
+            selection->selected.resize(g_instanceCount);
+
+            return [selection](State& state) {
+                const Assets::LodSelector selector(
+                    { 0.0F, 0.0F, 0.0F }, g_projectionScale, g_viewportHeight);
+                selector.select(selection->lods, selection->instances, selection->selected);
+
+                state.pauseTiming();
+                const auto& selected = selection->selected;
+                state.setItems(selected.size());
+                state.setCounter("meanLod",
+                    static_cast<double>(std::accumulate(selected.begin(), selected.end(), 0ULL))
+                        / static_cast<double>(selected.size()));
+                state.resumeTiming();
+            };
+        }
+    } // namespace
+
+    void registerLodBenchmarks(Suite& suite)
+    {
+        suite.add("Lod/Simplify", [] { return simplifyBody(); });
+        suite.add("Lod/Chain", [] { return chainBody(); });
+        suite.add("Lod/Select/instances:1M", [] { return selectBody(); });
+    }
+} // namespace Bench
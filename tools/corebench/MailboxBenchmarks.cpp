@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "Benchmarks.hpp"
+#include "TripleBuffer.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t g_roundTrips = 100'000;
+        constexpr size_t g_latencySamples = 10'000;
+
+        using Clock = std::chrono::steady_clock;
+
+        /// About the size of a snapshot of a few hundred bytes of simulation state.
+        struct Snapshot
+        {
+            std::array<float, 64> values {};
+            int64_t               publishTime = 0;
+        };
+
+        /// Publishes snapshots stamped with the current time as fast as it can on its
+        /// own thread, until destroyed.
+        struct Producer
+        {
+            TripleBuffer<Snapshot> mailbox;
+            std::atomic<bool>      running = true;
+            std::thread            thread;
+
+            Producer()
+            {
+                thread = std::thread([this] {
+                    while (running.load(std::memory_order_relaxed))
+                    {
+                        Snapshot& snapshot = mailbox.writeBuffer();
+                        snapshot.values.fill(1.0F);
+                        snapshot.publishTime = Clock::now().time_since_epoch().count();
+                        mailbox.publish();
+                        std::this_thread::yield();
+                    }
+                });
+            }
+
+            ~Producer()
+            {
+                running = false;
+                thread.join();
+            }
+        };
+
+        /// Publish and consume on one thread: the cost of the mailbox itself.
+        Body roundTripBody()
+        {
+            auto mailbox = std::make_shared<TripleBuffer<Snapshot>>();
+            return [mailbox](State& state) {
+                float sum = 0.0F;
+                for (size_t i = 0; i < g_roundTrips; i++)
+                {
+                    mailbox->writeBuffer().values[i % 64] = static_cast<float>(i);
+                    mailbox->publish();
+                    mailbox->update();
+                    sum += mailbox->readBuffer().values[i % 64];
+                }
+                state.setItems(g_roundTrips);
+                state.setCounter("checksum", sum);
+            };
+        }
+
+        /// Time from publish on the producer thread until the consumer takes the
+        /// snapshot, as the render thread would.
+        Body latencyBody()
+        {
+            auto producer = std::make_shared<Producer>();
+            return [producer](State& state) {
+                int64_t total = 0;
+                size_t  taken = 0;
+                while (taken < g_latencySamples)
+                {
+                    if (!producer->mailbox.update())
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    const int64_t now = Clock::now().time_since_epoch().count();
+                    total += now - producer->mailbox.readBuffer().publishTime;
+                    taken++;
+                }
+                const auto period = static_cast<double>(Clock::period::num)
+                    / static_cast<double>(Clock::period::den);
+                state.setItems(g_latencySamples);
+                state.setCounter("latencyNs",
+                    static_cast<double>(total) * period * 1e9 / static_cast<double>(taken));
+            };
+        }
+    } // namespace
+
+    void registerMailboxBenchmarks(Suite& suite)
+    {
+        suite.add("Mailbox/RoundTrip", [] { return roundTripBody(); });
+        suite.add("Mailbox/Latency", [] { return latencyBody(); });
+    }
+} // namespace Bench
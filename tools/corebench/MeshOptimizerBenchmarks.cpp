@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "MeshOptimizer.hpp"
+#include "Scenes.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr uint32_t g_gridSize = 384; ///< 294912 triangles.
+
+        /// The grid as an importer without an optimizer hands it over: triangles in
+        /// random order and, if unwelded, a vertex for every corner.
+        Assets::Primitive importedGrid(const bool unwelded)
+        {
+            Assets::Primitive grid = std::move(createGridMeshes(1, g_gridSize)[0].primitives[0]);
+
+            std::vector<std::array<uint32_t, 3>> triangles;
+            for (size_t i = 0; i + 2 < grid.indices.size(); i += 3)
+            {
+                triangles.push_back({ grid.indices[i], grid.indices[i + 1], grid.indices[i + 2] });
+            }
+            std::ranges::shuffle(triangles, std::mt19937(42));
+            grid.indices.clear();
+            for (const auto& triangle : triangles)
+            {
+                grid.indices.insert(grid.indices.end(), triangle.begin(), triangle.end());
+            }
+            if (!unwelded)
+            {
+                return grid;
+            }
+
+            Assets::Primitive split;
+            for (const uint32_t index : grid.indices)
+            {
+                split.indices.push_back(static_cast<uint32_t>(split.streams.positions.size()));
+                split.streams.positions.push_back(grid.streams.positions[index]);
+                split.streams.normals.push_back(grid.streams.normals[index]);
+                split.streams.texCoords.push_back(grid.streams.texCoords[index]);
+            }
+            return split;
+        }
+
+        void reportCache(State& state, const Assets::Primitive& primitive)
+        {
+            const auto statistics =
+                Assets::analyzeVertexCache(primitive.indices, primitive.vertexCount());
+            state.setItems(primitive.indices.size() / 3);
+            state.setCounter("acmr", statistics.acmr);
+            state.setCounter("atvr", statistics.atvr);
+        }
+
+        /// Runs stage on a fresh copy of the input each iteration and reports triangles
+        /// per second and the resulting cache efficiency.
+        template <typename TStage>
+        Body stageBody(const bool unwelded, const bool cacheOptimized, TStage stage)
+        {
+            auto input = std::make_shared<Assets::Primitive>(importedGrid(unwelded));
+            if (cacheOptimized)
+            {
+                Assets::optimizeVertexCache(input->indices, input->vertexCount());
+            }
+            auto primitive = std::make_shared<Assets::Primitive>();
+            return [input, primitive, stage](State& state) {
+                state.pauseTiming();
+                *primitive = *input;
+                state.resumeTiming();
+
+                stage(*primitive);
+
+                state.pauseTiming();
+                reportCache(state, *primitive);
+                state.resumeTiming();
+            };
+        }
+    } // namespace
+
+    void registerMeshOptimizerBenchmarks(Suite& suite)
+    {
+        suite.add("MeshOptimizer/Weld", [] {
+            return stageBody(true, false, [](Assets::Primitive& primitive) {
+                Assets::weldVertices(primitive);
+            });
+        });
+        suite.add("MeshOptimizer/VertexCache", [] {
+            return stageBody(false, false, [](Assets::Primitive& primitive) {
+                Assets::optimizeVertexCache(primitive.indices, primitive.vertexCount());
+            });
+        });
+        suite.add("MeshOptimizer/Overdraw", [] {
+            return stageBody(false, true, [](Assets::Primitive& primitive) {
+                Assets::optimizeOverdraw(primitive.indices, primitive.streams.positions);
+            });
+        });
+        suite.add("MeshOptimizer/VertexFetch", [] {
+            return stageBody(false, true, [](Assets::Primitive& primitive) {
+                Assets::optimizeVertexFetch(primitive);
+            });
+        });
+        suite.add("MeshOptimizer/Full", [] {
+            return stageBody(true, false, [](Assets::Primitive& primitive) {
+                Assets::optimizeMesh(primitive);
+            });
+        });
+    }
+} // namespace Bench
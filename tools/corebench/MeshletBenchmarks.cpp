@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshletBuilder.hpp"
+#include "Scenes.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr uint32_t g_rings = 256;
+        constexpr uint32_t g_segments = 512; ///< 261632 triangles.
+
+        std::shared_ptr<Assets::Primitive> createMesh()
+        {
+            auto sphere = std::make_shared<Assets::Primitive>(createSphere(g_rings, g_segments));
+            Assets::optimizeVertexCache(sphere->indices, sphere->vertexCount());
+            return sphere;
+        }
+
+        /// Reports triangles per second and how full the meshlets are.
+        Body buildBody()
+        {
+            auto sphere = createMesh();
+            return [sphere](State& state) {
+                const auto data = Assets::buildMeshlets(sphere->indices, sphere->streams.positions);
+
+                const double meshlets = static_cast<double>(data.meshlets.size());
+                state.setItems(sphere->indices.size() / 3);
+                state.setCounter("meshlets", meshlets);
+                state.setCounter(
+                    "verticesPerMeshlet", static_cast<double>(data.vertices.size()) / meshlets);
+                state.setCounter("trianglesPerMeshlet",
+                    static_cast<double>(sphere->indices.size() / 3) / meshlets);
+            };
+        }
+
+        /// Row-vector transform onto Metal clip space of a camera at z = -distance
+        /// looking down +z.
+        Assets::Matrix4 perspective(const float distance, const float fieldOfView)
+        {
+            const float scale = 1.0F / std::tan(fieldOfView / 2.0F);
+            const float nearZ = 0.01F;
+            const float farZ = 100.0F;
+            const float range = farZ / (farZ - nearZ);
+            return { scale, 0.0F, 0.0F, 0.0F, 0.0F, scale, 0.0F, 0.0F, 0.0F, 0.0F, range, 1.0F,
+                0.0F, 0.0F, (distance - nearZ) * range, distance };
+        }
+
+        /// Culls the sphere's meshlets from a camera distance away from its center,
+        /// reporting meshlets per second and the share each test rejects.
+        Body cullBody(const float distance, const float fieldOfView)
+        {
+            auto sphere = createMesh();
+            auto data = std::make_shared<Assets::MeshletData>(
+                Assets::buildMeshlets(sphere->indices, sphere->streams.positions));
+            auto visible = std::make_shared<std::vector<uint32_t>>();
+            const Assets::Frustum frustum =
+                Assets::extractFrustum(perspective(distance, fieldOfView));
+            return [data, visible, frustum, distance](State& state) {
+                Assets::MeshletCullStatistics statistics;
+                visible->clear();
+                Assets::cullMeshlets(
+                    data->meshlets, frustum, { 0.0F, 0.0F, -distance }, *visible, statistics);
+
+                const double tested = static_cast<double>(statistics.tested);
+                state.setItems(statistics.tested);
+                state.setCounter("visible%", 100.0 * static_cast<double>(visible->size()) / tested);
+                state.setCounter(
+                    "frustum%", 100.0 * static_cast<double>(statistics.frustumRejected) / tested);
+                state.setCounter(
+                    "cone%", 100.0 * static_cast<double>(statistics.coneRejected) / tested);
+            };
+        }
+    } // namespace
+
+    void registerMeshletBenchmarks(Suite& suite)
+    {
+        suite.add("Meshlet/Build", [] { return buildBody(); });
+        // The whole sphere in view, then close up with most of it outside the frustum
+        suite.add("Meshlet/Cull/far", [] { return cullBody(4.0F, 1.0F); });
+        suite.add("Meshlet/Cull/near", [] { return cullBody(1.5F, 0.5F); });
+    }
+} // namespace Bench
@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <format>
+#include <memory>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "ParallelEncoder.hpp"
+#include "RecordingEncoder.hpp"
+#include "RenderQueue.hpp"
+#include "ThreadPool.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t g_drawCount = 1'000'000;
+
+        using Encoder
+            = ParallelEncoder<RecordingCommandBuffer, std::unique_ptr<RecordingAllocator>>;
+
+        /// A built frame of unique draws, one batch each, in sorted order over 16
+        /// pipelines, 256 materials and 64 meshes.
+        std::shared_ptr<std::vector<Render::Batch>> createBatches()
+        {
+            auto batches = std::make_shared<std::vector<Render::Batch>>();
+            batches->reserve(g_drawCount);
+            for (uint32_t i = 0; i < g_drawCount; i++)
+            {
+                const Render::DrawState state { .pass = 1,
+                    .pipeline = static_cast<uint32_t>(i / (g_drawCount / 16)),
+                    .material = (i / 64) % 256,
+                    .mesh = i % 64 };
+                batches->push_back({ .key = Render::makeSortKey(state, 0.5F),
+                    .firstInstance = i,
+                    .instanceCount = 1 });
+            }
+            return batches;
+        }
+
+        Encoder::Backend createBackend()
+        {
+            return {
+                .createAllocator = [] { return std::make_unique<RecordingAllocator>(); },
+                .resetAllocator = [](std::unique_ptr<RecordingAllocator>& allocator) {
+                    allocator->reset();
+                },
+                .createCommandBuffer = [] { return RecordingCommandBuffer {}; },
+                .beginCommandBuffer =
+                    [](RecordingCommandBuffer&            commandBuffer,
+                        std::unique_ptr<RecordingAllocator>& allocator) {
+                        commandBuffer.begin(*allocator);
+                    },
+                .endCommandBuffer = [](RecordingCommandBuffer& commandBuffer) {
+                    commandBuffer.end();
+                },
+            };
+        }
+
+        Body parallelEncodeBody(const uint32_t threadCount)
+        {
+            auto batches = createBatches();
+            auto threadPool = std::make_shared<ThreadPool>(threadCount);
+            auto encoder = std::make_shared<Encoder>(createBackend(), 3, *threadPool);
+            auto frame = std::make_shared<uint32_t>(0);
+            return [batches, threadPool, encoder, frame](State& state) {
+                encoder->beginFrame((*frame)++ % 3);
+                const auto partitions = partitionItems(batches->size(), threadPool->threadCount());
+                encoder->encode(partitions,
+                    [&](RecordingCommandBuffer& commandBuffer, const EncodePartition& partition) {
+                        encodeBatches(commandBuffer,
+                            std::span<const Render::Batch>(*batches).subspan(
+                                partition.begin, partition.end - partition.begin));
+                    });
+
+                size_t commands = 0;
+                for (const RecordingCommandBuffer& commandBuffer : encoder->commandBuffers())
+                {
+                    commands += commandBuffer.commands().size();
+                }
+                state.setItems(g_drawCount);
+                state.setCounter(
+                    "commandBuffers", static_cast<double>(encoder->commandBuffers().size()));
+                state.setCounter("commands", static_cast<double>(commands));
+            };
+        }
+
+        /// The baseline: every batch encoded into one buffer on the calling thread.
+        Body serialEncodeBody()
+        {
+            auto batches = createBatches();
+            auto allocator = std::make_shared<RecordingAllocator>();
+            return [batches, allocator](State& state) {
+                allocator->reset();
+                RecordingCommandBuffer commandBuffer;
+                commandBuffer.begin(*allocator);
+                encodeBatches(commandBuffer, *batches);
+                commandBuffer.end();
+                state.setItems(g_drawCount);
+                state.setCounter("commands", static_cast<double>(allocator->commandCount()));
+            };
+        }
+    } // namespace
+
+    void registerParallelEncodeBenchmarks(Suite& suite)
+    {
+        suite.add("ParallelEncode/Serial", [] { return serialEncodeBody(); });
+        for (const uint32_t threads : { 1U, 2U, 4U, 8U })
+        {
+            suite.add(std::format("ParallelEncode/threads:{}", threads),
+                [threads] { return parallelEncodeBody(threads); });
+        }
+    }
+} // namespace Bench
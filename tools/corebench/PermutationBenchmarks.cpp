@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "ShaderPermutations.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        namespace Textures = ShaderPermutations::Textures;
+
+        constexpr size_t g_lookupCount = 1'000'000;
+
+        /// Feature values as a renderer sees them per material, some of them with no
+        /// compiled variant.
+        std::vector<Textures::Features> createFeatures()
+        {
+            std::mt19937                    random(11);
+            std::uniform_int_distribution<> blend(0, 1);
+            std::uniform_int_distribution<> samples(0, 3);
+            std::vector<Textures::Features> features(g_lookupCount);
+            for (auto& feature : features)
+            {
+                feature.ALPHA_BLEND = blend(random);
+                feature.MSAA = int64_t { 1 } << samples(random);
+            }
+            return features;
+        }
+
+        Body keyBody()
+        {
+            auto features = std::make_shared<std::vector<Textures::Features>>(createFeatures());
+            return [features](State& state) {
+                size_t missing = 0;
+                for (const Textures::Features& feature : *features)
+                {
+                    missing += Textures::permutationKey(feature) == Textures::g_permutationCount;
+                }
+                state.setItems(features->size());
+                state.setCounter("missing", static_cast<double>(missing));
+            };
+        }
+
+        /// Key and the variant's function names, what a pipeline request needs.
+        Body functionNameBody()
+        {
+            auto features = std::make_shared<std::vector<Textures::Features>>(createFeatures());
+            return [features](State& state) {
+                size_t length = 0;
+                for (const Textures::Features& feature : *features)
+                {
+                    const uint32_t key = Textures::permutationKey(feature);
+                    if (key != Textures::g_permutationCount)
+                    {
+                        length += Textures::functionName("texture_vertex", key).size();
+                        length += Textures::functionName("texture_fragment", key).size();
+                    }
+                }
+                state.setItems(features->size());
+                state.setCounter("characters", static_cast<double>(length));
+            };
+        }
+    } // namespace
+
+    void registerPermutationBenchmarks(Suite& suite)
+    {
+        suite.add("Permutation/Key", [] { return keyBody(); });
+        suite.add("Permutation/FunctionName", [] { return functionNameBody(); });
+    }
+} // namespace Bench
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <format>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "PipelineCache.hpp"
+#include "ThreadPool.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t g_keyCount = 10'000;
+        constexpr size_t g_pipelineCount = 64;
+        constexpr size_t g_lookupCount = 1'000'000;
+
+        /// Variations of a textured, instanced pipeline over formats, sample counts and
+        /// blending, as a material system would request them.
+        std::vector<PipelineDescription> createDescriptions(const size_t count)
+        {
+            std::vector<PipelineDescription> descriptions;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                PipelineDescription description;
+                description.vertexFunction = std::format("vertex{}", i % 8);
+                description.fragmentFunction = std::format("fragment{}", i % 16);
+                description.vertexAttributes = {
+                    { .index = 0, .format = 30, .offset = 0, .bufferIndex = 0 },
+                    { .index = 1, .format = 31, .offset = 12, .bufferIndex = 0 },
+                    { .index = 2, .format = 29, .offset = 28, .bufferIndex = 0 },
+                };
+                description.vertexLayouts = { { .bufferIndex = 0, .stride = 36 } };
+                description.colorAttachments = { { .pixelFormat = 80 + i % 3,
+                    .blendingEnabled = i % 4 == 0,
+                    .sourceRGBBlendFactor = 4,
+                    .destinationRGBBlendFactor = 5 } };
+                description.rasterSampleCount = i % 2 == 0 ? 4 : 1;
+                descriptions.push_back(std::move(description));
+            }
+            return descriptions;
+        }
+
+        Body keyBody()
+        {
+            auto descriptions = std::make_shared<std::vector<PipelineDescription>>(
+                createDescriptions(g_keyCount));
+            return [descriptions](State& state) {
+                uint64_t combined = 0;
+                for (const PipelineDescription& description : *descriptions)
+                {
+                    combined ^= description.key().low;
+                }
+                state.setItems(g_keyCount);
+                state.setCounter("checksum", static_cast<double>(combined & 0xFFFF));
+            };
+        }
+
+        /// Every thread looks up the same few pipelines, as draws do once warm.
+        Body lookupBody(const uint32_t threadCount)
+        {
+            const auto descriptions = createDescriptions(g_pipelineCount);
+            auto       keys = std::make_shared<std::vector<PipelineKey>>();
+            auto       cache = std::make_shared<PipelineCache<uint64_t>>();
+            for (const PipelineDescription& description : descriptions)
+            {
+                const PipelineKey key = description.key();
+                keys->push_back(key);
+                static_cast<void>(cache->getOrCreate(key, [&] { return key.low; }));
+            }
+
+            auto threadPool = std::make_shared<ThreadPool>(threadCount);
+            return [keys, cache, threadPool](State& state) {
+                const size_t perThread = g_lookupCount / threadPool->threadCount();
+                threadPool->parallelFor(threadPool->threadCount(), 1, [&](size_t begin, size_t) {
+                    for (size_t i = 0; i < perThread; i++)
+                    {
+                        const PipelineKey& key = (*keys)[(i + begin * 7) % keys->size()];
+                        static_cast<void>(cache->getOrCreate(key, [&] { return key.low; }));
+                    }
+                });
+                state.setItems(perThread * threadPool->threadCount());
+            };
+        }
+    } // namespace
+
+    void registerPipelineCacheBenchmarks(Suite& suite)
+    {
+        suite.add("PipelineCache/Key", [] { return keyBody(); });
+        for (const uint32_t threads : { 1U, 2U, 4U, 8U })
+        {
+            suite.add(std::format("PipelineCache/Lookup/threads:{}", threads),
+                [threads] { return lookupBody(threads); });
+        }
+    }
+} // namespace Bench
@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <format>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "SoftwareRasterizer.hpp"
+#include "ThreadPool.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr uint32_t g_width = 1280;
+        constexpr uint32_t g_height = 720;
+        constexpr size_t   g_triangleCount = 100'000;
+
+        /// Small overlapping triangles of a few dozen pixels each, like a dense
+        /// mesh, spread over the whole target.
+        struct Scene
+        {
+            std::vector<Raster::Vertex> vertices;
+            std::vector<uint32_t>       indices;
+            Raster::Matrix4 transform { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+            Scene()
+            {
+                std::mt19937                          random(5);
+                std::uniform_real_distribution<float> center(-1.0F, 1.0F);
+                std::uniform_real_distribution<float> offset(-0.015F, 0.015F);
+                std::uniform_real_distribution<float> unit(0.0F, 1.0F);
+                for (uint32_t i = 0; i < g_triangleCount; i++)
+                {
+                    const float x = center(random);
+                    const float y = center(random);
+                    const float z = unit(random);
+                    for (uint32_t corner = 0; corner < 3; corner++)
+                    {
+                        vertices.push_back(
+                            { { x + offset(random), y + offset(random), z, 1.0F },
+                                { unit(random), unit(random), unit(random), 1.0F }, {} });
+                        indices.push_back(i * 3 + corner);
+                    }
+                }
+            }
+        };
+
+        Body rasterizeBody(const uint32_t threadCount)
+        {
+            auto scene = std::make_shared<Scene>();
+            auto threadPool = std::make_shared<ThreadPool>(threadCount);
+            auto rasterizer = std::make_shared<Raster::Rasterizer>(*threadPool);
+            auto image = std::make_shared<Raster::Image>();
+            rasterizer->resize(g_width, g_height);
+            return [scene, threadPool, rasterizer, image](State& state) {
+                Raster::DrawCommand command;
+                command.vertices = scene->vertices;
+                command.indices32 = scene->indices;
+                command.instanceTransforms = { &scene->transform, 1 };
+
+                rasterizer->clear({ 0.0F, 0.0F, 0.0F, 1.0F });
+                rasterizer->draw(command);
+                rasterizer->resolve(*image);
+
+                const auto& statistics = rasterizer->statistics();
+                state.setItems(g_triangleCount);
+                state.setCounter("fragments", static_cast<double>(statistics.fragmentsShaded));
+            };
+        }
+    } // namespace
+
+    void registerRasterBenchmarks(Suite& suite)
+    {
+        for (const uint32_t threads : { 1U, 2U, 4U, 8U })
+        {
+            suite.add(std::format("Raster/Triangles/threads:{}", threads),
+                [threads] { return rasterizeBody(threads); });
+        }
+    }
+} // namespace Bench
@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "RenderQueue.hpp"
+#include "ThreadPool.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t g_drawCount = 1'000'000;
+
+        /// A frame's draws in submission order: a shadow pass and an opaque pass
+        /// over the same objects, and a few blended ones, over 16 pipelines, 256
+        /// materials and 64 meshes.
+        struct Frame
+        {
+            std::vector<Render::SortKey> keys;
+            std::vector<uint32_t>        instances;
+
+            Frame()
+            {
+                std::mt19937                          random(11);
+                std::uniform_real_distribution<float> depth(0.0F, 1.0F);
+                for (uint32_t i = 0; i < g_drawCount; i++)
+                {
+                    const uint32_t  object = i / 2;
+                    const bool      shadow = i % 2 == 0;
+                    const bool      blended = !shadow && object % 20 == 0;
+                    Render::DrawState state { .pass = shadow ? 0U : (blended ? 2U : 1U),
+                        .pipeline = shadow ? 0U : object % 16,
+                        .material = shadow ? 0U : (object * 7) % 256,
+                        .mesh = (object * 13) % 64 };
+                    keys.push_back(Render::makeSortKey(state, depth(random), blended));
+                    instances.push_back(object);
+                }
+            }
+        };
+
+        Body buildBody(std::shared_ptr<ThreadPool> threadPool)
+        {
+            auto frame = std::make_shared<Frame>();
+            auto queue = std::make_shared<Render::RenderQueue>();
+            return [frame, queue, threadPool](State& state) {
+                state.pauseTiming();
+                queue->clear();
+                queue->submit(frame->keys, frame->instances);
+                state.resumeTiming();
+
+                const auto batches = queue->build(threadPool.get());
+                state.setItems(g_drawCount);
+                state.setCounter("batches", static_cast<double>(batches.size()));
+                state.setCounter("drawsPerBatch",
+                    static_cast<double>(g_drawCount) / static_cast<double>(batches.size()));
+            };
+        }
+
+        Body submitBody()
+        {
+            auto frame = std::make_shared<Frame>();
+            auto queue = std::make_shared<Render::RenderQueue>();
+            queue->reserve(g_drawCount);
+            return [frame, queue](State& state) {
+                queue->clear();
+                for (size_t i = 0; i < g_drawCount; i++)
+                {
+                    queue->submit(frame->keys[i], frame->instances[i]);
+                }
+                state.setItems(g_drawCount);
+            };
+        }
+
+        /// The baseline build() replaces: a comparison sort of key and instance pairs.
+        Body stdSortBody()
+        {
+            auto frame = std::make_shared<Frame>();
+            auto draws = std::make_shared<std::vector<std::pair<Render::SortKey, uint32_t>>>();
+            return [frame, draws](State& state) {
+                state.pauseTiming();
+                draws->clear();
+                for (size_t i = 0; i < g_drawCount; i++)
+                {
+                    draws->emplace_back(frame->keys[i], frame->instances[i]);
+                }
+                state.resumeTiming();
+
+                std::ranges::stable_sort(*draws, {}, &std::pair<Render::SortKey, uint32_t>::first);
+                state.setItems(g_drawCount);
+            };
+        }
+    } // namespace
+
+    void registerRenderQueueBenchmarks(Suite& suite)
+    {
+        suite.add("RenderQueue/Submit", [] { return submitBody(); });
+        suite.add("RenderQueue/Build", [] { return buildBody(nullptr); });
+        suite.add("RenderQueue/BuildParallel",
+            [] { return buildBody(std::make_shared<ThreadPool>()); });
+        suite.add("RenderQueue/StdStableSort", [] { return stdSortBody(); });
+    }
+} // namespace Bench
@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <format>
+#include <memory>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "SceneLoader.hpp"
+#include "Scenes.hpp"
+#include "ThreadPool.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t   g_meshCount = 256;
+        constexpr uint32_t g_gridSize = 64;
+
+        /// Parses and decodes a scene from memory, reporting meshes per second as
+        /// items and the file bytes loaded per second.
+        Body loadBody(const uint32_t threadCount, const Assets::VertexFormat format)
+        {
+            auto glb = std::make_shared<std::vector<std::byte>>(
+                createGridScene(g_meshCount, g_gridSize));
+            auto threadPool = std::make_shared<ThreadPool>(threadCount);
+            return [glb, threadPool, format](State& state) {
+                const Assets::SceneLoader loader(
+                    { .vertexFormat = format, .threadPool = threadPool.get() });
+
+                const auto          start = std::chrono::steady_clock::now();
+                const Assets::Scene scene = loader.load(*glb, ".");
+                const std::chrono::duration<double> seconds
+                    = std::chrono::steady_clock::now() - start;
+
+                state.setItems(scene.meshes.size());
+                state.setCounter("MB/s", static_cast<double>(glb->size()) / 1e6 / seconds.count());
+            };
+        }
+    } // namespace
+
+    void registerSceneLoaderBenchmarks(Suite& suite)
+    {
+        for (const uint32_t threads : { 1U, 2U, 4U, 8U })
+        {
+            suite.add(std::format("SceneLoader/Interleaved/threads:{}", threads),
+                [threads] { return loadBody(threads, Assets::VertexFormat::Interleaved); });
+        }
+        suite.add("SceneLoader/Streams/threads:4",
+            [] { return loadBody(4, Assets::VertexFormat::Streams); });
+    }
+} // namespace Bench
@@ -0,0 +1,218 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Scenes.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <numbers>
+#include <span>
+
+#include "GlbWriter.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        Assets::Matrix4 translation(const std::array<float, 3>& offset)
+        {
+            Assets::Matrix4 matrix {};
+            matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0F;
+            std::copy(offset.begin(), offset.end(), matrix.begin() + 12);
+            return matrix;
+        }
+    } // namespace
+
+    std::vector<Assets::Mesh> createGridMeshes(const size_t meshCount, const uint32_t gridSize)
+    {
+        std::vector<Assets::Mesh> meshes(meshCount);
+        for (size_t mesh = 0; mesh < meshCount; mesh++)
+        {
+            Assets::Primitive      primitive;
+            Assets::VertexStreams& streams = primitive.streams;
+            const float            phase = static_cast<float>(mesh);
+            for (uint32_t z = 0; z <= gridSize; z++)
+            {
+                for (uint32_t x = 0; x <= gridSize; x++)
+                {
+                    const float u = static_cast<float>(x) / static_cast<float>(gridSize);
+                    const float v = static_cast<float>(z) / static_cast<float>(gridSize);
+                    const float height = 0.1F * std::sin(phase + 8.0F * u) * std::cos(8.0F * v);
+                    streams.positions.push_back({ u, height, v });
+                    streams.normals.push_back({ 0.0F, 1.0F, 0.0F });
+                    streams.texCoords.push_back({ u, v });
+                }
+            }
+            for (uint32_t z = 0; z < gridSize; z++)
+            {
+                for (uint32_t x = 0; x < gridSize; x++)
+                {
+                    const uint32_t corner = z * (gridSize + 1) + x;
+                    const uint32_t below = corner + gridSize + 1;
+                    primitive.indices.insert(primitive.indices.end(),
+                        { corner, below, corner + 1, corner + 1, below, below + 1 });
+                }
+            }
+            primitive.boundsMin = { 0.0F, -0.1F, 0.0F };
+            primitive.boundsMax = { 1.0F, 0.1F, 1.0F };
+
+            meshes[mesh].name = std::format("Grid{}", mesh);
+            meshes[mesh].primitives.push_back(std::move(primitive));
+        }
+        return meshes;
+    }
+
+    Assets::Primitive createSphere(const uint32_t rings, const uint32_t segments)
+    {
+        Assets::Primitive      primitive;
+        Assets::VertexStreams& streams = primitive.streams;
+        const float            pi = std::numbers::pi_v<float>;
+
+        // North pole, rings - 1 rows of segments vertices, south pole
+        streams.positions.push_back({ 0.0F, 1.0F, 0.0F });
+        for (uint32_t ring = 1; ring < rings; ring++)
+        {
+            const float theta = pi * static_cast<float>(ring) / static_cast<float>(rings);
+            for (uint32_t segment = 0; segment < segments; segment++)
+            {
+                const float phi =
+                    2.0F * pi * static_cast<float>(segment) / static_cast<float>(segments);
+                streams.positions.push_back({ std::sin(theta) * std::cos(phi), std::cos(theta),
+                    std::sin(theta) * std::sin(phi) });
+            }
+        }
+        streams.positions.push_back({ 0.0F, -1.0F, 0.0F });
+        streams.normals = streams.positions;
+
+        const auto south = static_cast<uint32_t>(streams.positions.size()) - 1;
+        const auto vertex = [segments](const uint32_t ring, const uint32_t segment) {
+            return 1 + (ring - 1) * segments + segment % segments;
+        };
+        auto& indices = primitive.indices;
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            indices.insert(indices.end(), { 0, vertex(1, segment + 1), vertex(1, segment) });
+            indices.insert(indices.end(),
+                { south, vertex(rings - 1, segment), vertex(rings - 1, segment + 1) });
+        }
+        for (uint32_t ring = 1; ring + 1 < rings; ring++)
+        {
+            for (uint32_t segment = 0; segment < segments; segment++)
+            {
+                const uint32_t a = vertex(ring, segment);
+                const uint32_t b = vertex(ring, segment + 1);
+                const uint32_t c = vertex(ring + 1, segment);
+                const uint32_t d = vertex(ring + 1, segment + 1);
+                indices.insert(indices.end(), { a, b, c, b, d, c });
+            }
+        }
+        primitive.boundsMin = { -1.0F, -1.0F, -1.0F };
+        primitive.boundsMax = { 1.0F, 1.0F, 1.0F };
+        return primitive;
+    }
+
+    Assets::Scene createCharacter(const uint32_t limbCount, const uint32_t limbJoints)
+    {
+        constexpr uint32_t keyCount = 31;
+        constexpr float    boneLength = 0.1F;
+        const float        pi = std::numbers::pi_v<float>;
+
+        Assets::Scene     scene;
+        Assets::Skin      skin;
+        Assets::Animation animation { .name = "swing", .channels = {}, .duration = 1.0F };
+        const auto        addJoint = [&](const int32_t parent, const std::array<float, 3>& offset,
+                                  const std::array<float, 3>& bindPosition) {
+            const auto   index = static_cast<int32_t>(scene.nodes.size());
+            Assets::Node node;
+            node.parent = parent;
+            node.translation = offset;
+            node.localTransform = translation(offset);
+            if (parent >= 0)
+            {
+                scene.nodes[parent].children.push_back(index);
+            }
+            scene.nodes.push_back(std::move(node));
+            skin.joints.push_back(index);
+            skin.inverseBindMatrices.push_back(
+                translation({ -bindPosition[0], -bindPosition[1], -bindPosition[2] }));
+            return index;
+        };
+
+        addJoint(-1, {}, {});
+        scene.rootNodes.push_back(0);
+        for (uint32_t limb = 0; limb < limbCount; limb++)
+        {
+            const float angle
+                = 2.0F * pi * static_cast<float>(limb) / static_cast<float>(limbCount);
+            const std::array<float, 3> direction { std::cos(angle), std::sin(angle), 0.0F };
+            int32_t                    parent = 0;
+            for (uint32_t segment = 0; segment < limbJoints; segment++)
+            {
+                const float reach = boneLength * static_cast<float>(segment + 1);
+                parent = addJoint(parent,
+                    { direction[0] * boneLength, direction[1] * boneLength, 0.0F },
+                    { direction[0] * reach, direction[1] * reach, 0.0F });
+
+                // Swing about the view axis, each joint a little behind its parent
+                Assets::AnimationChannel swing;
+                swing.node = parent;
+                swing.path = Assets::AnimationPath::Rotation;
+                const float phase = static_cast<float>(segment) * 0.4F + static_cast<float>(limb);
+                for (uint32_t key = 0; key < keyCount; key++)
+                {
+                    const float time = static_cast<float>(key) / (keyCount - 1);
+                    const float half = 0.2F * std::sin(2.0F * pi * time + phase);
+                    swing.times.push_back(time);
+                    swing.values.insert(
+                        swing.values.end(), { 0.0F, 0.0F, std::sin(half), std::cos(half) });
+                }
+                animation.channels.push_back(std::move(swing));
+            }
+        }
+
+        scene.skins.push_back(std::move(skin));
+        scene.animations.push_back(std::move(animation));
+        return scene;
+    }
+
+    std::vector<std::byte> createGridScene(const size_t meshCount, const uint32_t gridSize)
+    {
+        using Gltf::ComponentType;
+
+        Gltf::GlbWriter writer;
+        const auto      meshes = createGridMeshes(meshCount, gridSize);
+        for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+        {
+            const Assets::Primitive&     primitive = meshes[mesh].primitives.front();
+            const Assets::VertexStreams& streams = primitive.streams;
+
+            Json::Value attributes = Json::Value::Object {};
+            attributes.set("POSITION",
+                writer.addAccessor(std::span(streams.positions), ComponentType::Float, "VEC3"));
+            attributes.set("NORMAL",
+                writer.addAccessor(std::span(streams.normals), ComponentType::Float, "VEC3"));
+            attributes.set("TEXCOORD_0",
+                writer.addAccessor(std::span(streams.texCoords), ComponentType::Float, "VEC2"));
+
+            Json::Value value = Json::Value::Object {};
+            value.set("attributes", std::move(attributes));
+            value.set("indices", writer.addAccessor(std::span(primitive.indices),
+                                     ComponentType::UnsignedInt, "SCALAR"));
+
+            Json::Value gltfMesh = Json::Value::Object {};
+            gltfMesh.set("name", meshes[mesh].name);
+            gltfMesh.set("primitives", Json::Value::Array { std::move(value) });
+            const int64_t index = writer.add("meshes", std::move(gltfMesh));
+
+            Json::Value node = Json::Value::Object {};
+            node.set("mesh", index);
+            node.set("translation", Json::Value::Array { static_cast<double>(mesh % 32), 0.0,
+                                        static_cast<double>(mesh / 32) });
+            writer.add("nodes", std::move(node));
+        }
+        return writer.build();
+    }
+} // namespace Bench
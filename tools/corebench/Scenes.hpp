@@ -0,0 +1,31 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SceneLoader.hpp"
+
+namespace Bench
+{
+    /// @brief Generates meshCount wavy grids of gridSize x gridSize quads, each a mesh
+    /// with one primitive holding position, normal and texture coordinate streams.
+    [[nodiscard]] std::vector<Assets::Mesh> createGridMeshes(size_t meshCount, uint32_t gridSize);
+
+    /// @brief Generates a closed unit sphere of rings x segments quads with positions and
+    /// normals, wound counterclockwise seen from outside.
+    [[nodiscard]] Assets::Primitive createSphere(uint32_t rings, uint32_t segments);
+
+    /// @brief Generates a skinned character: a root with limbCount limbs of limbJoints
+    /// joints in skin 0, and a one second clip in which every joint swings.
+    [[nodiscard]] Assets::Scene createCharacter(uint32_t limbCount, uint32_t limbJoints);
+
+    /// @brief Generates a .glb scene of the createGridMeshes() grids, each under a node of
+    /// its own.
+    [[nodiscard]] std::vector<std::byte> createGridScene(size_t meshCount, uint32_t gridSize);
+} // namespace Bench
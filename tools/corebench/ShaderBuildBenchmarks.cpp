@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "DependencyScanner.hpp"
+#include "IncrementalBuild.hpp"
+#include "ShaderLayout.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t g_sourceCount = 64;
+        constexpr size_t g_headerCount = 32;
+        constexpr size_t g_structCount = 1'000;
+
+        /// Shader sources that each include a few of a pool of headers, which include
+        /// each other, written to a temporary directory removed with the object.
+        struct ShaderTree
+        {
+            explicit ShaderTree(const std::string_view name)
+                : root(std::filesystem::temp_directory_path() / std::format("corebench-{}", name))
+            {
+                std::filesystem::remove_all(root);
+                std::filesystem::create_directories(root / "include");
+                for (size_t i = 0; i < g_headerCount; i++)
+                {
+                    std::ofstream header(root / "include" / std::format("Header{}.h", i));
+                    header << "#pragma once\n#include <metal_stdlib>\n";
+                    if (i > 0)
+                    {
+                        header << std::format("#include \"Header{}.h\"\n", i / 2);
+                    }
+                    header << "// Declarations\nstruct Type" << i << " { float4 value; };\n";
+                }
+                for (size_t i = 0; i < g_sourceCount; i++)
+                {
+                    const auto    path = root / std::format("shader{}.metal", i);
+                    std::ofstream source(path);
+                    source << std::format("#include \"include/Header{}.h\"\n", i % g_headerCount)
+                           << std::format("#include \"include/Header{}.h\"\n",
+                                  (i * 7) % g_headerCount)
+                           << "/* The body */\nvertex float4 main() { return 0; }\n";
+                    sources.push_back(path);
+                }
+            }
+
+            ~ShaderTree()
+            {
+                std::error_code ignored;
+                std::filesystem::remove_all(root, ignored);
+            }
+
+            std::filesystem::path              root;
+            std::vector<std::filesystem::path> sources;
+        };
+
+        /// A fresh scanner each run, so every header is read and parsed again.
+        Body scanBody()
+        {
+            auto tree = std::make_shared<ShaderTree>("scan");
+            return [tree](State& state) {
+                ShaderBuild::DependencyScanner scanner({ tree->root / "include" });
+                size_t                         dependencies = 0;
+                for (const auto& source : tree->sources)
+                {
+                    dependencies += scanner.dependencies(source).size();
+                }
+                state.setItems(tree->sources.size());
+                state.setCounter("dependencies", static_cast<double>(dependencies));
+            };
+        }
+
+        /// Rebuilding with nothing changed: scanning, hashing every input and
+        /// checking the cached objects, without running a command.
+        Body upToDateBody()
+        {
+            auto tree = std::make_shared<ShaderTree>("uptodate");
+            auto options = std::make_shared<ShaderBuild::BuildOptions>();
+            options->outputPath = tree->root / "default.metallib";
+            options->cacheDirectory = tree->root / "cache";
+            options->compileCommand = "cat {input} > {output}";
+            options->linkCommand = "cat {inputs} > {output}";
+
+            auto units = std::make_shared<std::vector<ShaderBuild::CompileUnit>>();
+            for (const auto& source : tree->sources)
+            {
+                units->push_back(ShaderBuild::defaultUnit(source));
+            }
+            ShaderBuild::DependencyScanner warmup({ tree->root / "include" });
+            static_cast<void>(ShaderBuild::build(*options, *units, warmup));
+
+            return [tree, options, units](State& state) {
+                ShaderBuild::DependencyScanner scanner({ tree->root / "include" });
+                const auto result = ShaderBuild::build(*options, *units, scanner);
+                state.setItems(units->size());
+                state.setCounter("compiled", static_cast<double>(result.compiled));
+            };
+        }
+        /// Structs of vectors, matrices, argument buffer members and earlier structs,
+        /// with functions and comments in between, as reflected for the layout checks.
+        Body layoutBody()
+        {
+            auto source = std::make_shared<std::string>();
+            for (size_t i = 0; i < g_structCount; i++)
+            {
+                *source += std::format("// Struct {}\n"
+                                       "struct Struct{} {{\n"
+                                       "    float4 position [[position]];\n"
+                                       "    packed_float3 normal;\n"
+                                       "    half2 uv[2];\n"
+                                       "    float4x4 transform;\n"
+                                       "    array<texture2d<half>, COUNT> textures;\n"
+                                       "    device uint* indices;\n",
+                    i, i);
+                if (i > 0)
+                {
+                    *source += std::format("    Struct{} previous;\n", i - 1);
+                }
+                *source += "};\n\nfloat4 function(float4 value) { return value * 2; }\n";
+            }
+
+            const ShaderBuild::Constants constants { { "COUNT", 4 } };
+            return [source, constants](State& state) {
+                const auto layouts = ShaderBuild::parseStructLayouts(*source, constants);
+                state.setItems(layouts.size());
+                state.setCounter("kilobytes", static_cast<double>(source->size()) / 1024.0);
+            };
+        }
+    } // namespace
+
+    void registerShaderBuildBenchmarks(Suite& suite)
+    {
+        suite.add("ShaderBuild/Scan", [] { return scanBody(); });
+        suite.add("ShaderBuild/UpToDate", [] { return upToDateBody(); });
+        suite.add("ShaderBuild/Layouts", [] { return layoutBody(); });
+    }
+} // namespace Bench
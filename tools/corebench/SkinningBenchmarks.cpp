@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <format>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Animation.hpp"
+#include "Benchmarks.hpp"
+#include "Scenes.hpp"
+#include "Skinning.hpp"
+#include "ThreadPool.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t   g_vertexCount = 1 << 20;
+        constexpr uint32_t g_limbCount = 7; ///< With g_limbJoints and the root, 64 joints.
+        constexpr uint32_t g_limbJoints = 9;
+
+        struct Skinning
+        {
+            Animation::SkinnedMesh            mesh;
+            std::vector<Assets::Matrix4>      matrices;
+            std::vector<std::array<float, 3>> positions; ///< Stand-ins for upload buffers.
+            std::vector<std::array<float, 3>> normals;
+        };
+
+        /// A million vertices on a unit sphere, each weighted to influences random
+        /// joints of a posed character.
+        std::shared_ptr<Skinning> createSkinning(const uint32_t influences)
+        {
+            const auto character = createCharacter(g_limbCount, g_limbJoints);
+            const auto skeleton = Animation::buildSkeleton(character, 0);
+            const auto clip = Animation::Clip::compress(character.animations.front(), skeleton);
+
+            Animation::ClipSampler sampler;
+            Animation::Pose        pose;
+            sampler.sample(clip, 0.4F, pose);
+            std::vector<Assets::Matrix4> model(skeleton.jointCount());
+            std::vector<Assets::Matrix4> matrices(skeleton.skinJoints.size());
+            Animation::computeModelTransforms(skeleton, pose, model);
+            Animation::computeSkinningMatrices(skeleton, model, matrices);
+
+            // Positions double as normals, which on a unit sphere they are
+            std::mt19937                            random(42);
+            std::normal_distribution<float>         direction;
+            std::uniform_int_distribution<uint16_t> joint(
+                0, static_cast<uint16_t>(matrices.size() - 1));
+            std::uniform_real_distribution<float>   weight(0.0F, 1.0F);
+            std::vector<std::array<float, 3>>       positions(g_vertexCount);
+            std::vector<uint16_t>                   joints(g_vertexCount * influences);
+            std::vector<float>                      weights(g_vertexCount * influences);
+            for (size_t vertex = 0; vertex < g_vertexCount; vertex++)
+            {
+                auto&       position = positions[vertex];
+                position = { direction(random), direction(random), direction(random) };
+                const float length = std::sqrt(position[0] * position[0]
+                    + position[1] * position[1] + position[2] * position[2]);
+                for (float& value : position)
+                {
+                    value /= length;
+                }
+                for (uint32_t influence = 0; influence < influences; influence++)
+                {
+                    joints[vertex * influences + influence] = joint(random);
+                    weights[vertex * influences + influence] = weight(random);
+                }
+            }
+
+            return std::make_shared<Skinning>(
+                Animation::SkinnedMesh(positions, positions, joints, weights, influences),
+                std::move(matrices), std::vector<std::array<float, 3>>(g_vertexCount),
+                std::vector<std::array<float, 3>>(g_vertexCount));
+        }
+
+        /// Skins every vertex across the pool's threads, reporting vertices per second.
+        Body skinBody(const Animation::SkinningMethod method, const uint32_t influences,
+            const uint32_t threadCount)
+        {
+            auto skinning = createSkinning(influences);
+            auto threadPool = std::make_shared<ThreadPool>(threadCount);
+            return [skinning, threadPool, method](State& state) {
+                Animation::skinVertices(skinning->mesh, method, skinning->matrices,
+                    skinning->positions, skinning->normals, *threadPool);
+                state.setItems(g_vertexCount);
+            };
+        }
+    } // namespace
+
+    void registerSkinningBenchmarks(Suite& suite)
+    {
+        const std::pair<std::string, Animation::SkinningMethod> methods[] = {
+            { "LinearBlend", Animation::SkinningMethod::LinearBlend },
+            { "DualQuaternion", Animation::SkinningMethod::DualQuaternion },
+        };
+        for (const auto& [name, method] : methods)
+        {
+            for (const uint32_t influences : { 4U, 8U })
+            {
+                for (const uint32_t threads : { 1U, 2U, 4U, 8U })
+                {
+                    suite.add(std::format("Skinning/{}/influences:{}/threads:{}", name, influences,
+                                  threads),
+                        [method, influences, threads] {
+                            return skinBody(method, influences, threads);
+                        });
+                }
+            }
+        }
+    }
+} // namespace Bench
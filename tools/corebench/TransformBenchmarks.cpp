@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "ThreadPool.hpp"
+#include "TransformHierarchy.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t g_nodeCount = 1'000'000;
+        constexpr size_t g_rootCount = 1024;
+        constexpr size_t g_fanout = 4;
+
+        Animation::Transform randomTransform(std::mt19937& random)
+        {
+            std::uniform_real_distribution<float> distribution(-1.0F, 1.0F);
+            const float                           angle = distribution(random);
+            return { .translation = { distribution(random), distribution(random),
+                         distribution(random) },
+                .rotation = { 0.0F, std::sin(angle), 0.0F, std::cos(angle) } };
+        }
+
+        /// A forest of 4-ary trees, six levels deep, whose siblings are created
+        /// together like the children of a loaded scene node.
+        struct Forest
+        {
+            TransformHierarchy                      hierarchy;
+            std::vector<TransformHierarchy::NodeId> shuffled;
+            std::vector<Animation::Transform>       transforms;
+            size_t                                  next = 0;
+
+            Forest()
+            {
+                std::mt19937                            random(7);
+                std::vector<TransformHierarchy::NodeId> nodes;
+                nodes.reserve(g_nodeCount);
+                for (size_t i = 0; i < g_nodeCount; i++)
+                {
+                    const auto parent = i < g_rootCount
+                        ? TransformHierarchy::s_invalidNode
+                        : nodes[(i - g_rootCount) / g_fanout];
+                    nodes.push_back(hierarchy.create(parent, randomTransform(random)));
+                }
+                hierarchy.update();
+
+                shuffled = nodes;
+                std::ranges::shuffle(shuffled, random);
+                for (size_t i = 0; i < 4096; i++)
+                {
+                    transforms.push_back(randomTransform(random));
+                }
+            }
+
+            /// Changes the local transforms of count nodes, a different set each call.
+            void dirty(const size_t count)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    hierarchy.setLocal(shuffled[(next + i) % shuffled.size()],
+                        transforms[(next + i) % transforms.size()]);
+                }
+                next = (next + count) % shuffled.size();
+            }
+        };
+
+        Body updateBody(const double dirtyRatio, std::shared_ptr<ThreadPool> threadPool)
+        {
+            auto forest = std::make_shared<Forest>();
+            return [forest, threadPool, dirtyRatio](State& state) {
+                const auto count = static_cast<size_t>(dirtyRatio * g_nodeCount);
+                state.pauseTiming();
+                forest->dirty(count);
+                state.resumeTiming();
+
+                const size_t updated = threadPool != nullptr ? forest->hierarchy.update(*threadPool)
+                                                             : forest->hierarchy.update();
+                state.setItems(updated);
+                state.setCounter("recomputed", static_cast<double>(updated) / g_nodeCount);
+            };
+        }
+
+        /// What updateUniforms() style code does: compose every node one by one, each
+        /// from its parent, with no dirty tracking.
+        Body scalarBody()
+        {
+            struct Scalar
+            {
+                std::vector<int32_t>              parents;
+                std::vector<Animation::Transform> locals;
+                std::vector<Assets::Matrix4>      world;
+            };
+
+            auto         scalar = std::make_shared<Scalar>();
+            std::mt19937 random(7);
+            for (size_t i = 0; i < g_nodeCount; i++)
+            {
+                scalar->parents.push_back(
+                    i < g_rootCount ? -1 : static_cast<int32_t>((i - g_rootCount) / g_fanout));
+                scalar->locals.push_back(randomTransform(random));
+            }
+            scalar->world.resize(g_nodeCount);
+
+            return [scalar](State& state) {
+                for (size_t i = 0; i < g_nodeCount; i++)
+                {
+                    const auto& [x, y, z, w] = scalar->locals[i].rotation;
+                    const auto& s = scalar->locals[i].scale;
+                    const auto& t = scalar->locals[i].translation;
+                    const Assets::Matrix4 local { s[0] * (1.0F - 2.0F * (y * y + z * z)),
+                        s[0] * 2.0F * (x * y + z * w), s[0] * 2.0F * (x * z - y * w), 0.0F,
+                        s[1] * 2.0F * (x * y - z * w), s[1] * (1.0F - 2.0F * (x * x + z * z)),
+                        s[1] * 2.0F * (y * z + x * w), 0.0F, s[2] * 2.0F * (x * z + y * w),
+                        s[2] * 2.0F * (y * z - x * w), s[2] * (1.0F - 2.0F * (x * x + y * y)),
+                        0.0F, t[0], t[1], t[2], 1.0F };
+                    if (scalar->parents[i] < 0)
+                    {
+                        scalar->world[i] = local;
+                        continue;
+                    }
+
+                    const Assets::Matrix4& parent = scalar->world[scalar->parents[i]];
+                    Assets::Matrix4        result {};
+                    for (size_t row = 0; row < 4; row++)
+                    {
+                        for (size_t k = 0; k < 4; k++)
+                        {
+                            for (size_t column = 0; column < 4; column++)
+                            {
+                                result[row * 4 + column]
+                                    += local[row * 4 + k] * parent[k * 4 + column];
+                            }
+                        }
+                    }
+                    scalar->world[i] = result;
+                }
+                state.setItems(g_nodeCount);
+            };
+        }
+    } // namespace
+
+    void registerTransformBenchmarks(Suite& suite)
+    {
+        for (const double ratio : { 0.0, 0.01, 0.1, 1.0 })
+        {
+            suite.add(std::format("TransformHierarchy/Update/dirty:{}%", ratio * 100.0),
+                [ratio] { return updateBody(ratio, nullptr); });
+        }
+        for (const double ratio : { 0.01, 1.0 })
+        {
+            suite.add(std::format("TransformHierarchy/UpdateParallel/dirty:{}%", ratio * 100.0),
+                [ratio] { return updateBody(ratio, std::make_shared<ThreadPool>()); });
+        }
+        suite.add("TransformHierarchy/ScalarFullRecompute", [] { return scalarBody(); });
+    }
+} // namespace Bench
@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "UploadRing.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr size_t   g_allocationCount = 1'000'000;
+        constexpr size_t   g_allocationsPerFrame = 10'000;
+        constexpr uint64_t g_framesInFlight = 3;
+
+        /// A million per-draw uniform blocks over a hundred frames, with the GPU
+        /// retiring frames framesInFlight behind.
+        struct Ring
+        {
+            std::vector<std::byte> memory;
+            UploadRing             ring;
+            uint64_t               frameNumber = 0;
+
+            explicit Ring(const uint64_t capacity)
+                : memory(capacity)
+                , ring(memory.data(), capacity)
+            {
+            }
+        };
+
+        Body allocateBody(const uint64_t size, const uint64_t alignment, const bool write)
+        {
+            const uint64_t alignedSize = (size + alignment - 1) & ~(alignment - 1);
+            const uint64_t perFrame = g_allocationsPerFrame * alignedSize;
+            auto           ring = std::make_shared<Ring>(perFrame * (g_framesInFlight + 1));
+            return [ring, size, alignment, write](State& state) {
+                uint64_t failures = ring->ring.statistics().failures;
+                for (size_t i = 0; i < g_allocationCount; i++)
+                {
+                    if (i % g_allocationsPerFrame == 0)
+                    {
+                        ring->frameNumber++;
+                        if (ring->frameNumber > g_framesInFlight)
+                        {
+                            ring->ring.retireFrames(ring->frameNumber - g_framesInFlight);
+                        }
+                        ring->ring.beginFrame(ring->frameNumber);
+                    }
+
+                    const auto allocation = ring->ring.allocate(size, alignment);
+                    if (write && allocation)
+                    {
+                        std::memset(allocation.data, static_cast<int>(i), size);
+                    }
+                }
+                state.setItems(g_allocationCount);
+                state.setCounter("failures",
+                    static_cast<double>(ring->ring.statistics().failures - failures));
+            };
+        }
+    } // namespace
+
+    void registerUploadRingBenchmarks(Suite& suite)
+    {
+        suite.add("UploadRing/Allocate/64", [] { return allocateBody(64, 16, false); });
+        suite.add("UploadRing/Allocate/256", [] { return allocateBody(256, 256, false); });
+        suite.add("UploadRing/AllocateAndWrite/64", [] { return allocateBody(64, 16, true); });
+    }
+} // namespace Bench
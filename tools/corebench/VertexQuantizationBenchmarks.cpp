@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "Scenes.hpp"
+#include "VertexQuantization.hpp"
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr uint32_t g_gridSize = 1'023; ///< 1048576 vertices.
+
+        struct Vertices
+        {
+            Assets::VertexStreams streams;
+            std::array<float, 3>  boundsMin {};
+            std::array<float, 3>  boundsMax {};
+        };
+
+        /// Encodes some attributes and returns the encoded and float sizes in bytes.
+        using Encoder = std::function<std::pair<size_t, size_t>(const Vertices&)>;
+
+        std::shared_ptr<Vertices> createVertices()
+        {
+            auto              vertices = std::make_shared<Vertices>();
+            Assets::Primitive grid = std::move(createGridMeshes(1, g_gridSize)[0].primitives[0]);
+            vertices->streams = std::move(grid.streams);
+            vertices->boundsMin = grid.boundsMin;
+            vertices->boundsMax = grid.boundsMax;
+            for (const auto& texCoord : vertices->streams.texCoords)
+            {
+                vertices->streams.tangents.push_back({ 1.0F, 0.0F, 0.0F, 1.0F });
+                vertices->streams.colors.push_back({ texCoord[0], texCoord[1], 0.5F, 1.0F });
+            }
+            return vertices;
+        }
+
+        /// Reports vertices per second and the bytes each vertex takes encoded and
+        /// as floats.
+        Body encodeBody(const Encoder& encoder)
+        {
+            auto vertices = createVertices();
+            return [vertices, encoder](State& state) {
+                const auto [encoded, full] = encoder(*vertices);
+                const auto count = static_cast<double>(vertices->streams.positions.size());
+                state.setItems(vertices->streams.positions.size());
+                state.setCounter("bytesPerVertex", static_cast<double>(encoded) / count);
+                state.setCounter("floatBytesPerVertex", static_cast<double>(full) / count);
+            };
+        }
+
+        template <typename TElement>
+        size_t sizeOf(const std::vector<TElement>& values)
+        {
+            return values.size() * sizeof(TElement);
+        }
+
+        std::pair<size_t, size_t> encodePositions(const Vertices& vertices)
+        {
+            return { Assets::quantizePositions(
+                         vertices.streams.positions, vertices.boundsMin, vertices.boundsMax)
+                         .bytes.size(),
+                sizeOf(vertices.streams.positions) };
+        }
+
+        std::pair<size_t, size_t> encodeNormals(const Vertices& vertices)
+        {
+            return { Assets::quantizeNormals(vertices.streams.normals).bytes.size(),
+                sizeOf(vertices.streams.normals) };
+        }
+
+        std::pair<size_t, size_t> encodeTexCoords(const Vertices& vertices)
+        {
+            return { Assets::quantizeTexCoords(vertices.streams.texCoords).bytes.size(),
+                sizeOf(vertices.streams.texCoords) };
+        }
+
+        std::pair<size_t, size_t> encodeTangents(const Vertices& vertices)
+        {
+            return { Assets::quantizeTangents(vertices.streams.tangents).bytes.size(),
+                sizeOf(vertices.streams.tangents) };
+        }
+
+        std::pair<size_t, size_t> encodeColors(const Vertices& vertices)
+        {
+            return { Assets::quantizeColors(vertices.streams.colors).bytes.size(),
+                sizeOf(vertices.streams.colors) };
+        }
+
+        std::pair<size_t, size_t> encodeAll(const Vertices& vertices)
+        {
+            std::pair<size_t, size_t> total;
+            for (const auto& encode :
+                { encodePositions, encodeNormals, encodeTexCoords, encodeTangents, encodeColors })
+            {
+                const auto [encoded, full] = encode(vertices);
+                total.first += encoded;
+                total.second += full;
+            }
+            return total;
+        }
+    } // namespace
+
+    void registerVertexQuantizationBenchmarks(Suite& suite)
+    {
+        const std::pair<std::string, Encoder> encoders[] = {
+            { "Positions", encodePositions },
+            { "Normals", encodeNormals },
+            { "TexCoords", encodeTexCoords },
+            { "Tangents", encodeTangents },
+            { "Colors", encodeColors },
+            { "All", encodeAll },
+        };
+        for (const auto& [name, encoder] : encoders)
+        {
+            suite.add("VertexQuantization/" + name, [encoder] { return encodeBody(encoder); });
+        }
+    }
+} // namespace Bench
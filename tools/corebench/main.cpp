@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <print>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "Benchmarks.hpp"
+#include "Json.hpp"
+
+namespace
+{
+    struct Options
+    {
+        Bench::RunOptions run;
+        std::string       outputPath;
+        bool              list = false;
+    };
+
+    void printUsage()
+    {
+        std::println("usage: corebench [options]");
+        std::println("");
+        std::println("Benchmarks the platform independent engine systems and writes the");
+        std::println("results in the JSON format benchcompare reads.");
+        std::println("");
+        std::println("options:");
+        std::println("  --filter <regex>     Run the benchmarks whose name matches (default all)");
+        std::println("  --repetitions <n>    Samples per benchmark (default 5)");
+        std::println("  --min-time <ms>      Minimum time per sample (default 100)");
+        std::println("  --output <file>      Also write the results as JSON");
+        std::println("  --list               Print the benchmark names and exit");
+    }
+
+    double parseNumberArgument(std::string_view option, const char* value)
+    {
+        char*        end = nullptr;
+        const double result = std::strtod(value, &end);
+        if (end == value || *end != '\0' || result < 0.0)
+        {
+            throw std::runtime_error(std::format("Invalid value '{}' for {}", value, option));
+        }
+        return result;
+    }
+
+    Options parseOptions(int argc, char** argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view argument = argv[i];
+            const auto             next = [&]() -> const char* {
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(std::format("Missing value for {}", argument));
+                }
+                return argv[++i];
+            };
+
+            if (argument == "--help" || argument == "-h")
+            {
+                printUsage();
+                std::exit(EXIT_SUCCESS);
+            }
+            else if (argument == "--filter")
+            {
+                options.run.filter = std::regex(next());
+            }
+            else if (argument == "--repetitions")
+            {
+                const auto repetitions = parseNumberArgument(argument, next());
+                options.run.repetitions = std::max<uint32_t>(1, static_cast<uint32_t>(repetitions));
+            }
+            else if (argument == "--min-time")
+            {
+                options.run.minSeconds = parseNumberArgument(argument, next()) / 1000.0;
+            }
+            else if (argument == "--output")
+            {
+                options.outputPath = next();
+            }
+            else if (argument == "--list")
+            {
+                options.list = true;
+            }
+            else
+            {
+                throw std::runtime_error(std::format("Unknown option {}", argument));
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const Options options = parseOptions(argc, argv);
+
+        Bench::Suite suite;
+        Bench::registerTransformBenchmarks(suite);
+        Bench::registerEcsBenchmarks(suite);
+        Bench::registerRenderQueueBenchmarks(suite);
+        Bench::registerParallelEncodeBenchmarks(suite);
+        Bench::registerFrameGraphBenchmarks(suite);
+        Bench::registerRasterBenchmarks(suite);
+        Bench::registerMailboxBenchmarks(suite);
+        Bench::registerFrameArenaBenchmarks(suite);
+        Bench::registerUploadRingBenchmarks(suite);
+        Bench::registerPipelineCacheBenchmarks(suite);
+        Bench::registerShaderBuildBenchmarks(suite);
+        Bench::registerPermutationBenchmarks(suite);
+        Bench::registerSceneLoaderBenchmarks(suite);
+        Bench::registerCookedMeshBenchmarks(suite);
+        Bench::registerMeshOptimizerBenchmarks(suite);
+        Bench::registerVertexQuantizationBenchmarks(suite);
+        Bench::registerMeshletBenchmarks(suite);
+        Bench::registerLodBenchmarks(suite);
+        Bench::registerAnimationBenchmarks(suite);
+        Bench::registerSkinningBenchmarks(suite);
+
+        if (options.list)
+        {
+            for (const auto& name : suite.names())
+            {
+                std::println("{}", name);
+            }
+            return EXIT_SUCCESS;
+        }
+
+        const Json::Value results = suite.run(options.run);
+        if (!options.outputPath.empty())
+        {
+            std::ofstream stream(options.outputPath);
+            if (!stream)
+            {
+                throw std::runtime_error(
+                    std::format("Failed to open {} for write", options.outputPath));
+            }
+            stream << Json::serialize(results) << '\n';
+        }
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::println("Error: {}", e.what());
+        printUsage();
+        return 2;
+    }
+}
@@ -0,0 +1,462 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <print>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CookedMesh.hpp"
+#include "LodSelection.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshletBuilder.hpp"
+#include "SceneLoader.hpp"
+#include "ThreadPool.hpp"
+
+namespace
+{
+    struct Options
+    {
+        std::filesystem::path inputPath;
+        std::filesystem::path outputPath;
+        bool                  optimize = true;
+        bool                  quantize = false;
+        bool                  meshlets = false;
+        bool                  lods = false;
+        bool                  verbose = false;
+    };
+
+    struct CacheTotals
+    {
+        size_t transforms = 0;
+        size_t triangles = 0;
+        size_t vertices = 0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    void printUsage()
+    {
+        std::println("usage: meshcook [options] <scene.gltf|scene.glb>");
+        std::println("");
+        std::println("Cooks the meshes of a glTF scene into a binary file that is memory mapped");
+        std::println("at runtime and uploaded without per-vertex processing.");
+        std::println("");
+        std::println("options:");
+        std::println("  --output <file>  Cooked file to write (default: input with .cmesh)");
+        std::println("  --no-optimize    Keep the vertex and index order of the source");
+        std::println("  --quantize       Store vertices in compact normalized formats");
+        std::println("  --meshlets       Split primitives into meshlets with culling bounds");
+        std::println("  --lods           Add simplified levels of detail to every primitive");
+        std::println("  --verbose        Print per-mesh statistics and load times");
+    }
+
+    Options parseOptions(int argc, char** argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view argument = argv[i];
+            const auto             next = [&]() -> const char* {
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(std::format("Missing value for {}", argument));
+                }
+                return argv[++i];
+            };
+
+            if (argument == "--help" || argument == "-h")
+            {
+                printUsage();
+                std::exit(EXIT_SUCCESS);
+            }
+            else if (argument == "--output")
+            {
+                options.outputPath = next();
+            }
+            else if (argument == "--no-optimize")
+            {
+                options.optimize = false;
+            }
+            else if (argument == "--quantize")
+            {
+                options.quantize = true;
+            }
+            else if (argument == "--meshlets")
+            {
+                options.meshlets = true;
+            }
+            else if (argument == "--lods")
+            {
+                options.lods = true;
+            }
+            else if (argument == "--verbose")
+            {
+                options.verbose = true;
+            }
+            else if (argument.starts_with("--"))
+            {
+                throw std::runtime_error(std::format("Unknown option {}", argument));
+            }
+            else if (options.inputPath.empty())
+            {
+                options.inputPath = argument;
+            }
+            else
+            {
+                throw std::runtime_error("Expected exactly one input scene");
+            }
+        }
+
+        if (options.inputPath.empty())
+        {
+            throw std::runtime_error("Expected exactly one input scene");
+        }
+        if (options.outputPath.empty())
+        {
+            options.outputPath = options.inputPath;
+            options.outputPath.replace_extension(".cmesh");
+        }
+        return options;
+    }
+
+    double millisecondsSince(const Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    CacheTotals analyzeMeshes(const std::span<const Assets::Mesh> meshes)
+    {
+        CacheTotals totals;
+        for (const auto& mesh : meshes)
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                const auto statistics =
+                    Assets::analyzeVertexCache(primitive.indices, primitive.vertexCount());
+                totals.transforms += statistics.transforms;
+                totals.triangles += primitive.indices.size() / 3;
+                totals.vertices += primitive.vertexCount();
+            }
+        }
+        return totals;
+    }
+
+    void printCacheTotals(const std::string_view label, const CacheTotals& totals)
+    {
+        std::println("{}: {} vertices, ACMR {:.3f}, ATVR {:.3f}", label, totals.vertices,
+            static_cast<double>(totals.transforms) / std::max<size_t>(totals.triangles, 1),
+            static_cast<double>(totals.transforms) / std::max<size_t>(totals.vertices, 1));
+    }
+
+    /// Optimizes every primitive in parallel; primitives are independent.
+    void optimizeMeshes(std::vector<Assets::Mesh>& meshes)
+    {
+        std::vector<Assets::Primitive*> primitives;
+        for (auto& mesh : meshes)
+        {
+            for (auto& primitive : mesh.primitives)
+            {
+                primitives.push_back(&primitive);
+            }
+        }
+        ThreadPool::shared().parallelFor(primitives.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                Assets::optimizeMesh(*primitives[i]);
+            }
+        });
+    }
+
+    /// Bytes per vertex the primitive's attributes take as 32 bit floats.
+    uint32_t floatVertexSize(const Assets::CookedPrimitive& primitive)
+    {
+        using Assets::VertexAttribute;
+        using Assets::VertexStreamFormat;
+        constexpr std::array<VertexStreamFormat, Assets::g_vertexAttributeCount> formats = {
+            VertexStreamFormat::Float3, VertexStreamFormat::Float3, VertexStreamFormat::Float2,
+            VertexStreamFormat::Float4, VertexStreamFormat::Float4
+        };
+
+        uint32_t size = 0;
+        for (size_t attribute = 0; attribute < formats.size(); attribute++)
+        {
+            if (primitive.streams[attribute].format != VertexStreamFormat::None)
+            {
+                size += Assets::vertexStreamStride(formats[attribute]);
+            }
+        }
+        return size;
+    }
+
+    /// Builds the meshlets of every primitive on one thread, for build throughput.
+    void benchmarkMeshlets(const std::span<const Assets::Mesh> meshes)
+    {
+        size_t triangles = 0;
+        size_t meshletCount = 0;
+        double time = 0.0;
+        for (const auto& mesh : meshes)
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                const auto start = Clock::now();
+                const auto data =
+                    Assets::buildMeshlets(primitive.indices, primitive.streams.positions);
+                time += millisecondsSince(start);
+                triangles += primitive.indices.size() / 3;
+                meshletCount += data.meshlets.size();
+            }
+        }
+        std::println("Built {} meshlets from {} triangles in {:.2f} ms ({:.1f} Mtri/s)",
+            meshletCount, triangles, time, triangles / std::max(time, 1.0e-3) / 1.0e3);
+    }
+
+    /// Simplifies every primitive to a quarter on one thread, for throughput.
+    void benchmarkSimplification(const std::span<const Assets::Mesh> meshes)
+    {
+        size_t triangles = 0;
+        size_t simplified = 0;
+        double time = 0.0;
+        for (const auto& mesh : meshes)
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                const auto start = Clock::now();
+                const auto result = Assets::simplifyMesh(
+                    primitive.indices, primitive.streams, primitive.indices.size() / 4);
+                time += millisecondsSince(start);
+                triangles += primitive.indices.size() / 3;
+                simplified += result.indices.size() / 3;
+            }
+        }
+        std::println("Simplified {} triangles to {} in {:.2f} ms ({:.2f} Mtri/s)", triangles,
+            simplified, time, triangles / std::max(time, 1.0e-3) / 1.0e3);
+    }
+
+    void printLodStatistics(const Assets::CookedMeshFile& file)
+    {
+        // Triangles and largest error per level, over all primitives
+        std::vector<size_t> triangles;
+        std::vector<float>  errors;
+        for (size_t mesh = 0; mesh < file.meshCount(); mesh++)
+        {
+            for (const auto& primitive : file.primitives(mesh))
+            {
+                const auto lods = file.lods(primitive);
+                triangles.resize(std::max(triangles.size(), lods.size()));
+                errors.resize(triangles.size());
+                for (size_t level = 0; level < lods.size(); level++)
+                {
+                    triangles[level] += lods[level].indexCount / 3;
+                    errors[level] = std::max(errors[level], lods[level].error);
+                }
+            }
+        }
+        for (size_t level = 0; level < triangles.size(); level++)
+        {
+            std::println("  LOD {} {:>9} triangles  error {:.5f}", level, triangles[level],
+                errors[level]);
+        }
+    }
+
+    /// Selects LODs for a million instances of the first primitive spread along the
+    /// view direction, as a renderer would every frame.
+    void benchmarkLodSelection(const Assets::CookedMeshFile& file)
+    {
+        constexpr size_t instanceCount = 1'000'000;
+        if (file.meshCount() == 0 || file.primitives(0).empty())
+        {
+            return;
+        }
+        const Assets::CookedPrimitive& primitive = file.primitives(0).front();
+        const auto                     lods = file.lods(primitive);
+        float                          radius = 0.0F;
+        for (size_t axis = 0; axis < 3; axis++)
+        {
+            const float extent = primitive.boundsMax[axis] - primitive.boundsMin[axis];
+            radius += extent * extent * 0.25F;
+        }
+        radius = std::sqrt(radius);
+
+        // 60 degree field of view at 1080p, instances up to 1000 radii away
+        const Assets::LodSelector        selector({ 0.0F, 0.0F, 0.0F }, 1.732F, 1080.0F);
+        std::vector<Assets::LodInstance> instances(instanceCount);
+        std::mt19937                     random(42);
+        std::uniform_real_distribution   spread(-1.0F, 1.0F);
+        std::uniform_real_distribution   depth(2.0F, 1000.0F);
+        for (auto& instance : instances)
+        {
+            const float distance = depth(random) * radius;
+            instance.center = { spread(random) * distance, spread(random) * distance, distance };
+            instance.radius = radius;
+        }
+
+        std::vector<uint32_t> selected(instanceCount);
+        const auto            start = Clock::now();
+        selector.select(lods, instances, selected);
+        const double time = millisecondsSince(start);
+
+        std::vector<size_t> histogram(lods.size());
+        for (const uint32_t lod : selected)
+        {
+            histogram[lod]++;
+        }
+        std::println("Selected LODs for {} instances in {:.2f} ms ({:.1f} ns/instance)",
+            instanceCount, time, time * 1.0e6 / instanceCount);
+        for (size_t level = 0; level < histogram.size(); level++)
+        {
+            std::println("  LOD {} {:>9} instances", level, histogram[level]);
+        }
+    }
+
+    void printMeshletStatistics(const Assets::CookedMeshFile& file)
+    {
+        size_t meshlets = 0;
+        size_t vertices = 0;
+        size_t triangles = 0;
+        size_t cones = 0;
+        for (size_t mesh = 0; mesh < file.meshCount(); mesh++)
+        {
+            for (const auto& primitive : file.primitives(mesh))
+            {
+                for (const auto& lod : file.lods(primitive))
+                {
+                    for (const auto& meshlet : file.meshlets(lod))
+                    {
+                        meshlets++;
+                        vertices += meshlet.vertexCount;
+                        triangles += meshlet.triangleCount;
+                        cones += meshlet.coneCutoff < 1.0F ? 1 : 0;
+                    }
+                }
+            }
+        }
+
+        const auto average = [meshlets](const size_t total) {
+            return static_cast<double>(total) / std::max<size_t>(meshlets, 1);
+        };
+        std::println("Meshlets: {}, {:.1f}/{} vertices, {:.1f}/{} triangles, {:.1f}% with a "
+                     "normal cone",
+            meshlets, average(vertices), Assets::g_meshletMaxVertices, average(triangles),
+            Assets::g_meshletMaxTriangles, average(cones) * 100.0);
+    }
+
+    void printStatistics(const Assets::CookedMeshFile& file)
+    {
+        size_t vertexBytes = 0;
+        size_t floatVertexBytes = 0;
+        size_t totalVertices = 0;
+        for (size_t mesh = 0; mesh < file.meshCount(); mesh++)
+        {
+            size_t vertices = 0;
+            size_t triangles = 0;
+            for (const auto& primitive : file.primitives(mesh))
+            {
+                vertices += primitive.vertexCount;
+                triangles += file.lods(primitive).front().indexCount / 3;
+                for (const auto& stream : primitive.streams)
+                {
+                    vertexBytes += stream.size;
+                }
+                floatVertexBytes += size_t { floatVertexSize(primitive) } * primitive.vertexCount;
+            }
+            totalVertices += vertices;
+            std::println("  {:<32} {:>3} primitives {:>9} vertices {:>9} triangles",
+                file.meshName(mesh), file.primitives(mesh).size(), vertices, triangles);
+        }
+
+        const auto perVertex = [totalVertices](const size_t bytes) {
+            return static_cast<double>(bytes) / std::max<size_t>(totalVertices, 1);
+        };
+        std::println("Vertex data: {:.1f} bytes/vertex ({:.1f} as floats, {} bytes saved)",
+            perVertex(vertexBytes), perVertex(floatVertexBytes), floatVertexBytes - vertexBytes);
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const Options options = parseOptions(argc, argv);
+
+        // Interleaving would only be undone again by the cooker
+        const Assets::SceneLoader loader({ .vertexFormat = Assets::VertexFormat::Streams });
+        const auto                loadStart = Clock::now();
+        Assets::Scene             scene = loader.load(options.inputPath);
+        const double              loadTime = millisecondsSince(loadStart);
+
+        if (options.optimize)
+        {
+            const CacheTotals before = analyzeMeshes(scene.meshes);
+            const auto        optimizeStart = Clock::now();
+            optimizeMeshes(scene.meshes);
+            const double optimizeTime = millisecondsSince(optimizeStart);
+            if (options.verbose)
+            {
+                printCacheTotals("Source", before);
+                printCacheTotals("Optimized", analyzeMeshes(scene.meshes));
+                std::println("Optimized {} triangles in {:.2f} ms ({:.1f} Mtri/s)",
+                    before.triangles, optimizeTime,
+                    before.triangles / std::max(optimizeTime, 1.0e-3) / 1.0e3);
+            }
+        }
+
+        if (options.meshlets && options.verbose)
+        {
+            benchmarkMeshlets(scene.meshes);
+        }
+        if (options.lods && options.verbose)
+        {
+            benchmarkSimplification(scene.meshes);
+        }
+
+        const auto cookStart = Clock::now();
+        Assets::writeCookedMeshes(options.outputPath, scene.meshes,
+            { .quantize = options.quantize,
+                .buildMeshlets = options.meshlets,
+                .generateLods = options.lods,
+                .lods = {} });
+        const double cookTime = millisecondsSince(cookStart);
+
+        const auto                   openStart = Clock::now();
+        const Assets::CookedMeshFile cooked(options.outputPath);
+        const double                 openTime = millisecondsSince(openStart);
+
+        std::println("Cooked {} meshes into {} ({} bytes)", cooked.meshCount(),
+            options.outputPath.string(), cooked.bytes().size());
+        if (options.verbose)
+        {
+            printStatistics(cooked);
+            if (options.meshlets)
+            {
+                printMeshletStatistics(cooked);
+            }
+            if (options.lods)
+            {
+                printLodStatistics(cooked);
+                benchmarkLodSelection(cooked);
+            }
+            std::println("glTF load {:.2f} ms, cook {:.2f} ms, cooked open {:.2f} ms", loadTime,
+                cookTime, openTime);
+        }
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::println("Error: {}", e.what());
+        printUsage();
+        return 2;
+    }
+}
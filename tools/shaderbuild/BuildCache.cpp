@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "BuildCache.hpp"
+
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "Json.hpp"
+
+namespace ShaderBuild
+{
+    namespace
+    {
+        constexpr uint64_t g_fnvPrime = 0x100000001B3ULL;
+        constexpr int64_t  g_stateVersion = 1;
+    } // namespace
+
+    std::string readFile(const std::filesystem::path& path)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream)
+        {
+            throw std::runtime_error(std::format("Failed to open {}", path.string()));
+        }
+        std::ostringstream contents;
+        contents << stream.rdbuf();
+        return std::move(contents).str();
+    }
+
+    bool writeFileIfChanged(const std::filesystem::path& path, const std::string_view contents)
+    {
+        std::error_code error;
+        if (std::filesystem::file_size(path, error) == contents.size() && !error
+            && readFile(path) == contents)
+        {
+            return false;
+        }
+
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        if (!stream)
+        {
+            throw std::runtime_error(std::format("Failed to write {}", path.string()));
+        }
+        return true;
+    }
+
+    ContentHash& ContentHash::add(const std::string_view value)
+    {
+        for (const char c : value)
+        {
+            m_value = (m_value ^ static_cast<uint8_t>(c)) * g_fnvPrime;
+        }
+        m_value = (m_value ^ 0xFF) * g_fnvPrime;
+        return *this;
+    }
+
+    ContentHash& ContentHash::add(const uint64_t value)
+    {
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            m_value = (m_value ^ ((value >> shift) & 0xFF)) * g_fnvPrime;
+        }
+        return *this;
+    }
+
+    uint64_t ContentHash::value() const
+    {
+        return m_value;
+    }
+
+    std::string ContentHash::toString() const
+    {
+        return std::format("{:016x}", m_value);
+    }
+
+    uint64_t FileHashCache::hash(const std::filesystem::path& path)
+    {
+        if (const auto it = m_hashes.find(path); it != m_hashes.end())
+        {
+            return it->second;
+        }
+        const uint64_t value = ContentHash().add(readFile(path)).value();
+        m_hashes.emplace(path, value);
+        return value;
+    }
+
+    BuildState BuildState::load(const std::filesystem::path& path)
+    {
+        BuildState state;
+        try
+        {
+            const Json::Value document = Json::parseFile(path);
+            if (document["version"].asNumber() == static_cast<double>(g_stateVersion))
+            {
+                state.linkHash = document["link"].asString();
+            }
+        }
+        catch (const std::exception&)
+        {
+            // A missing or damaged state file only forces a relink
+        }
+        return state;
+    }
+
+    void BuildState::save(const std::filesystem::path& path) const
+    {
+        Json::Value document = Json::Value::Object {};
+        document.set("version", g_stateVersion);
+        document.set("link", linkHash);
+
+        std::ofstream stream(path, std::ios::trunc);
+        stream << Json::serialize(document) << '\n';
+        if (!stream)
+        {
+            throw std::runtime_error(std::format("Failed to write {}", path.string()));
+        }
+    }
+} // namespace ShaderBuild
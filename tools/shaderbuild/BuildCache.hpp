@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace ShaderBuild
+{
+    /// @brief Reads a whole file, throwing std::runtime_error on failure.
+    [[nodiscard]] std::string readFile(const std::filesystem::path& path);
+
+    /// @brief Writes contents to path unless the file already holds them, so that
+    /// dependents of an unchanged generated file are not rebuilt.
+    /// @return True if the file was written.
+    bool writeFileIfChanged(const std::filesystem::path& path, std::string_view contents);
+
+    /// @brief Incremental 64-bit FNV-1a hash.
+    class ContentHash
+    {
+    public:
+        /// @brief Hashes the bytes of value, followed by a separator so that
+        /// consecutive fields cannot run into each other.
+        ContentHash& add(std::string_view value);
+
+        ContentHash& add(uint64_t value);
+
+        [[nodiscard]] uint64_t value() const;
+
+        /// @brief Formats the hash as 16 lowercase hex digits.
+        [[nodiscard]] std::string toString() const;
+
+    private:
+        uint64_t m_value = 0xCBF29CE484222325ULL;
+    };
+
+    /// @brief Memoized content hashes of files.
+    class FileHashCache
+    {
+    public:
+        /// @brief Returns the hash of the file contents, reading it on first use.
+        [[nodiscard]] uint64_t hash(const std::filesystem::path& path);
+
+    private:
+        std::map<std::filesystem::path, uint64_t> m_hashes;
+    };
+
+    /// @brief Persistent state of the last successful build.
+    struct BuildState
+    {
+        std::string linkHash; ///< Hash of the linker command and its inputs.
+
+        /// @brief Loads the state, returning an empty state if the file is missing or
+        /// unreadable.
+        [[nodiscard]] static BuildState load(const std::filesystem::path& path);
+
+        void save(const std::filesystem::path& path) const;
+    };
+} // namespace ShaderBuild
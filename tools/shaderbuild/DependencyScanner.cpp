@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "DependencyScanner.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <utility>
+
+#include "BuildCache.hpp"
+
+namespace ShaderBuild
+{
+    namespace
+    {
+        std::string_view trimLeft(std::string_view text)
+        {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            {
+                text.remove_prefix(1);
+            }
+            return text;
+        }
+    } // namespace
+
+    std::string stripComments(const std::string_view text)
+    {
+        std::string result;
+        result.reserve(text.size());
+
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            const char current = text[i];
+            const char next = i + 1 < text.size() ? text[i + 1] : '\0';
+            if (current == '/' && next == '/')
+            {
+                while (i < text.size() && text[i] != '\n')
+                {
+                    i++;
+                }
+                result.push_back('\n');
+            }
+            else if (current == '/' && next == '*')
+            {
+                for (i += 2; i < text.size() && !(text[i - 1] == '*' && text[i] == '/'); i++)
+                {
+                    result.push_back(text[i] == '\n' ? '\n' : ' ');
+                }
+                result.push_back(' ');
+            }
+            else if (current == '"')
+            {
+                // Copy the literal verbatim so "//" inside it is not a comment
+                result.push_back(current);
+                for (i++; i < text.size() && text[i] != '"' && text[i] != '\n'; i++)
+                {
+                    if (text[i] == '\\' && i + 1 < text.size())
+                    {
+                        result.push_back(text[i++]);
+                    }
+                    result.push_back(text[i]);
+                }
+                if (i < text.size())
+                {
+                    result.push_back(text[i]);
+                }
+            }
+            else
+            {
+                result.push_back(current);
+            }
+        }
+        return result;
+    }
+
+    std::vector<IncludeDirective> parseIncludes(const std::string_view text)
+    {
+        const std::string             source = stripComments(text);
+        std::vector<IncludeDirective> includes;
+
+        std::string_view remaining = source;
+        while (!remaining.empty())
+        {
+            const size_t     end = remaining.find('\n');
+            std::string_view line = trimLeft(remaining.substr(0, end));
+            remaining.remove_prefix(end == std::string_view::npos ? remaining.size() : end + 1);
+
+            if (!line.starts_with('#'))
+            {
+                continue;
+            }
+            line = trimLeft(line.substr(1));
+            if (!line.starts_with("include"))
+            {
+                continue;
+            }
+            line = trimLeft(line.substr(7));
+            if (line.empty() || (line.front() != '"' && line.front() != '<'))
+            {
+                continue;
+            }
+
+            const char   terminator = line.front() == '"' ? '"' : '>';
+            const size_t close = line.find(terminator, 1);
+            if (close == std::string_view::npos)
+            {
+                continue;
+            }
+            includes.push_back({ std::string(line.substr(1, close - 1)), terminator == '"' });
+        }
+        return includes;
+    }
+
+    DependencyScanner::DependencyScanner(std::vector<std::filesystem::path> includeDirectories)
+        : m_includeDirectories(std::move(includeDirectories))
+    {
+    }
+
+    std::vector<std::filesystem::path> DependencyScanner::dependencies(
+        const std::filesystem::path& source)
+    {
+        const auto                         root = std::filesystem::weakly_canonical(source);
+        std::set<std::filesystem::path>    visited { root };
+        std::vector<std::filesystem::path> pending { root };
+
+        // Iterative traversal; the visited set also guards against include cycles
+        while (!pending.empty())
+        {
+            const auto file = std::move(pending.back());
+            pending.pop_back();
+            for (const auto& include : directIncludes(file))
+            {
+                if (visited.insert(include).second)
+                {
+                    pending.push_back(include);
+                }
+            }
+        }
+
+        visited.erase(root);
+        return { visited.begin(), visited.end() };
+    }
+
+    const std::vector<std::filesystem::path>& DependencyScanner::directIncludes(
+        const std::filesystem::path& file)
+    {
+        if (const auto it = m_directIncludes.find(file); it != m_directIncludes.end())
+        {
+            return it->second;
+        }
+
+        std::vector<std::filesystem::path> includes;
+        for (const auto& include : parseIncludes(readFile(file)))
+        {
+            if (auto resolved = resolve(file, include))
+            {
+                includes.push_back(std::move(*resolved));
+            }
+        }
+        return m_directIncludes.emplace(file, std::move(includes)).first->second;
+    }
+
+    std::optional<std::filesystem::path> DependencyScanner::resolve(
+        const std::filesystem::path& includingFile, const IncludeDirective& include) const
+    {
+        std::vector<std::filesystem::path> candidates;
+        if (include.quoted)
+        {
+            candidates.push_back(includingFile.parent_path() / include.name);
+        }
+        for (const auto& directory : m_includeDirectories)
+        {
+            candidates.push_back(directory / include.name);
+        }
+
+        for (const auto& candidate : candidates)
+        {
+            if (std::filesystem::is_regular_file(candidate))
+            {
+                return std::filesystem::weakly_canonical(candidate);
+            }
+        }
+        return std::nullopt;
+    }
+} // namespace ShaderBuild
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ShaderBuild
+{
+    struct IncludeDirective
+    {
+        std::string name;
+        bool        quoted = false; ///< "name" rather than <name>.
+    };
+
+    /// @brief Replaces comments with whitespace, keeping newlines and string literals.
+    [[nodiscard]] std::string stripComments(std::string_view text);
+
+    /// @brief Extracts the #include directives of a source file.
+    /// @note Directives inside comments are ignored. Conditional compilation is not
+    /// evaluated, so includes in disabled #if blocks are reported too, which can only
+    /// cause extra rebuilds, never missed ones.
+    [[nodiscard]] std::vector<IncludeDirective> parseIncludes(std::string_view text);
+
+    /// @brief Finds the files a shader source includes, transitively.
+    class DependencyScanner
+    {
+    public:
+        /// @param [in] includeDirectories Directories searched for includes, in order.
+        explicit DependencyScanner(std::vector<std::filesystem::path> includeDirectories);
+
+        /// @brief Returns the sorted transitive includes of source, excluding source.
+        ///
+        /// Quoted includes are looked up next to the including file first, then in the
+        /// include directories. Includes that resolve to no file, such as
+        /// <metal_stdlib>, are treated as system headers and skipped. Results are
+        /// cached, so shared headers are only read once per scanner.
+        [[nodiscard]] std::vector<std::filesystem::path> dependencies(
+            const std::filesystem::path& source);
+
+    private:
+        const std::vector<std::filesystem::path>& directIncludes(
+            const std::filesystem::path& file);
+
+        [[nodiscard]] std::optional<std::filesystem::path> resolve(
+            const std::filesystem::path& includingFile, const IncludeDirective& include) const;
+
+        std::vector<std::filesystem::path>                                  m_includeDirectories;
+        std::map<std::filesystem::path, std::vector<std::filesystem::path>> m_directIncludes;
+    };
+} // namespace ShaderBuild
@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "IncrementalBuild.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <mutex>
+#include <print>
+#include <stdexcept>
+
+#include "BuildCache.hpp"
+
+namespace ShaderBuild
+{
+    namespace
+    {
+        std::string replaceAll(std::string text, const std::string_view from, const std::string& to)
+        {
+            for (size_t position = text.find(from); position != std::string::npos;
+                position = text.find(from, position + to.size()))
+            {
+                text.replace(position, from.size(), to);
+            }
+            return text;
+        }
+
+        void runCommand(const std::string& command, const bool verbose)
+        {
+            if (verbose)
+            {
+                std::println("{}", command);
+            }
+            if (const int status = std::system(command.c_str()); status != 0)
+            {
+                throw std::runtime_error(std::format("Command failed ({}): {}", status, command));
+            }
+        }
+
+        std::string formatDefines(const std::vector<Define>& defines)
+        {
+            std::string result;
+            for (const auto& [name, value] : defines)
+            {
+                result += std::format("{}{}", result.empty() ? "" : " ",
+                    shellQuote(std::format("-D{}={}", name, value)));
+            }
+            return result;
+        }
+
+        /// Compiles the units that are not cached on options.jobs threads; the first
+        /// failure is rethrown after all workers finished.
+        void compileUnits(std::vector<UnitBuild*>& pending, const BuildOptions& options)
+        {
+            std::atomic<size_t> next = 0;
+            std::mutex          errorMutex;
+            std::exception_ptr  error;
+
+            const auto worker = [&] {
+                for (size_t index = next++; index < pending.size(); index = next++)
+                {
+                    const UnitBuild& build = *pending[index];
+                    auto             temporary = build.object;
+                    temporary += ".tmp";
+                    try
+                    {
+                        const auto& unit = build.unit;
+                        std::string command = options.compileCommand;
+                        command = replaceAll(command, "{input}", shellQuote(unit.source.string()));
+                        command = replaceAll(command, "{output}", shellQuote(temporary.string()));
+                        command = replaceAll(command, "{defines}", formatDefines(unit.defines));
+                        runCommand(command, options.verbose);
+                        std::filesystem::rename(temporary, build.object);
+                    }
+                    catch (...)
+                    {
+                        std::error_code ignored;
+                        std::filesystem::remove(temporary, ignored);
+
+                        const std::scoped_lock lock(errorMutex);
+                        if (!error)
+                        {
+                            error = std::current_exception();
+                        }
+                        next = pending.size();
+                    }
+                }
+            };
+
+            {
+                std::vector<std::jthread> workers;
+                for (size_t i = 1; i < std::min<size_t>(options.jobs, pending.size()); i++)
+                {
+                    workers.emplace_back(worker);
+                }
+                worker();
+            }
+
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    } // namespace
+
+    std::string shellQuote(const std::string_view word)
+    {
+        std::string quoted = "'";
+        for (const char c : word)
+        {
+            quoted += c == '\'' ? std::string_view("'\\''") : std::string_view(&c, 1);
+        }
+        return quoted + "'";
+    }
+
+    BuildResult build(
+        const BuildOptions& options, std::vector<CompileUnit> units, DependencyScanner& scanner)
+    {
+        std::filesystem::create_directories(options.cacheDirectory);
+
+        FileHashCache           hashes;
+        BuildResult             result;
+        std::vector<UnitBuild*> pending;
+        for (auto& unit : units)
+        {
+            UnitBuild build;
+            build.unit = std::move(unit);
+            build.dependencies = scanner.dependencies(build.unit.source);
+
+            ContentHash key;
+            key.add(options.compileCommand);
+            for (const auto& [name, value] : build.unit.defines)
+            {
+                key.add(name).add(value);
+            }
+            key.add(hashes.hash(build.unit.source));
+            for (const auto& dependency : build.dependencies)
+            {
+                key.add(dependency.string()).add(hashes.hash(dependency));
+            }
+
+            build.object = options.cacheDirectory
+                / std::format("{}-{}.air", build.unit.name, key.toString());
+            build.cached = std::filesystem::exists(build.object);
+            result.units.push_back(std::move(build));
+        }
+        for (auto& build : result.units)
+        {
+            if (!build.cached)
+            {
+                pending.push_back(&build);
+            }
+        }
+
+        compileUnits(pending, options);
+        result.compiled = pending.size();
+
+        // The link key only depends on the objects, whose names already encode their
+        // content
+        ContentHash linkKey;
+        linkKey.add(options.linkCommand);
+        std::string inputs;
+        for (const auto& build : result.units)
+        {
+            linkKey.add(build.object.filename().string());
+            inputs += (inputs.empty() ? "" : " ") + shellQuote(build.object.string());
+        }
+
+        const auto statePath = options.cacheDirectory / "state.json";
+        auto       state = BuildState::load(statePath);
+        result.linked = state.linkHash != linkKey.toString()
+            || !std::filesystem::exists(options.outputPath);
+        if (result.linked)
+        {
+            auto temporary = options.outputPath;
+            temporary += ".tmp";
+
+            std::string command = replaceAll(options.linkCommand, "{inputs}", inputs);
+            command = replaceAll(command, "{output}", shellQuote(temporary.string()));
+            runCommand(command, options.verbose);
+            std::filesystem::rename(temporary, options.outputPath);
+
+            state.linkHash = linkKey.toString();
+            state.save(statePath);
+        }
+        return result;
+    }
+} // namespace ShaderBuild
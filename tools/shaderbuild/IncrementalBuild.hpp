@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "DependencyScanner.hpp"
+#include "ShaderManifest.hpp"
+
+namespace ShaderBuild
+{
+    struct BuildOptions
+    {
+        std::filesystem::path outputPath;
+        std::filesystem::path cacheDirectory;
+        std::string           compileCommand; ///< With {input}, {output} and {defines}.
+        std::string           linkCommand;    ///< With {inputs} and {output}.
+        unsigned              jobs = std::max(1u, std::thread::hardware_concurrency());
+        bool                  verbose = false;
+    };
+
+    struct UnitBuild
+    {
+        CompileUnit                        unit;
+        std::vector<std::filesystem::path> dependencies;
+        std::filesystem::path              object;
+        bool                               cached = false;
+    };
+
+    struct BuildResult
+    {
+        std::vector<UnitBuild> units;
+        size_t                 compiled = 0;
+        bool                   linked = false;
+    };
+
+    /// @brief Quotes a word for the POSIX shell.
+    [[nodiscard]] std::string shellQuote(std::string_view word);
+
+    /// @brief Compiles the units whose inputs changed and relinks the library if any
+    /// object changed.
+    ///
+    /// Each unit is keyed by a hash of its source, defines, compile command and
+    /// transitive includes, and its object is stored in the cache directory under
+    /// that key, so switching back to earlier sources reuses their objects. Commands
+    /// run through the shell with paths substituted single quoted.
+    /// @throws std::runtime_error if a command fails; the library is left untouched.
+    [[nodiscard]] BuildResult build(
+        const BuildOptions& options, std::vector<CompileUnit> units, DependencyScanner& scanner);
+} // namespace ShaderBuild
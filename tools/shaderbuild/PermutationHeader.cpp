@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "PermutationHeader.hpp"
+
+#include <charconv>
+#include <format>
+#include <iterator>
+
+namespace ShaderBuild
+{
+    namespace
+    {
+        class HeaderWriter
+        {
+        public:
+            template <typename... Args>
+            void line(const int indent, std::format_string<Args...> format, Args&&... args)
+            {
+                m_text.append(static_cast<size_t>(indent) * 4, ' ');
+                std::format_to(std::back_inserter(m_text), format, std::forward<Args>(args)...);
+                m_text.push_back('\n');
+            }
+
+            void blank()
+            {
+                m_text.push_back('\n');
+            }
+
+            [[nodiscard]] std::string take()
+            {
+                return std::move(m_text);
+            }
+
+        private:
+            std::string m_text;
+        };
+
+        bool isInteger(const std::string_view text)
+        {
+            const char* last = text.data() + text.size();
+            int64_t     value = 0;
+            const auto [end, error] = std::from_chars(text.data(), last, value);
+            return !text.empty() && error == std::errc() && end == last;
+        }
+
+        std::string quote(const std::string_view text)
+        {
+            std::string quoted = "\"";
+            for (const char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    quoted.push_back('\\');
+                }
+                quoted.push_back(c);
+            }
+            return quoted + "\"";
+        }
+
+        void writeConstants(HeaderWriter& writer, const ShaderEntry& entry)
+        {
+            for (const auto& [name, value] : entry.defines)
+            {
+                if (isInteger(value))
+                {
+                    writer.line(2, "inline constexpr int64_t {} = {};", name, value);
+                }
+                else
+                {
+                    writer.line(
+                        2, "inline constexpr std::string_view {} = {};", name, quote(value));
+                }
+            }
+        }
+
+        void writePermutations(HeaderWriter& writer, const ShaderEntry& entry)
+        {
+            const size_t count = entry.permutationCount();
+
+            writer.line(2, "/// @brief Permutation define values, defaulting to the first variant");
+            writer.line(2, "struct Features");
+            writer.line(2, "{{");
+            for (const auto& axis : entry.permutations)
+            {
+                writer.line(3, "int64_t {} = {};", axis.name, axis.values.front());
+            }
+            writer.line(2, "}};");
+            writer.blank();
+
+            writer.line(2, "inline constexpr uint32_t g_permutationCount = {};", count);
+            writer.blank();
+
+            writer.line(2, "/// @brief PERMUTATION_SUFFIX of every variant, indexed by key.");
+            writer.line(2,
+                "inline constexpr std::array<std::string_view, g_permutationCount> "
+                "g_permutationSuffixes {{");
+            for (size_t permutation = 0; permutation < count; permutation++)
+            {
+                writer.line(3, "{},", quote(entry.permutationSuffix(permutation)));
+            }
+            writer.line(2, "}};");
+            writer.blank();
+
+            // Mixed radix key with the last axis varying fastest, matching the order
+            // the variants are expanded in
+            writer.line(2, "/// @brief Key of the variant compiled with features, or");
+            writer.line(2, "/// g_permutationCount if that combination is not compiled.");
+            writer.line(2,
+                "[[nodiscard]] constexpr uint32_t permutationKey(const Features& features)");
+            writer.line(2, "{{");
+            writer.line(3, "uint32_t key = 0;");
+            for (const auto& axis : entry.permutations)
+            {
+                writer.line(3, "switch (features.{})", axis.name);
+                writer.line(3, "{{");
+                for (size_t index = 0; index < axis.values.size(); index++)
+                {
+                    writer.line(3, "case {}:", axis.values[index]);
+                    writer.line(4, "key = key * {} + {};", axis.values.size(), index);
+                    writer.line(4, "break;");
+                }
+                writer.line(3, "default:");
+                writer.line(4, "return g_permutationCount;");
+                writer.line(3, "}}");
+            }
+            writer.line(3, "return key;");
+            writer.line(2, "}}");
+            writer.blank();
+
+            writer.line(2, "/// @brief Name of function in the variant with the given key.");
+            writer.line(2,
+                "[[nodiscard]] inline std::string functionName(std::string_view function, "
+                "uint32_t key)");
+            writer.line(2, "{{");
+            writer.line(3, "return std::string(function).append(g_permutationSuffixes.at(key));");
+            writer.line(2, "}}");
+        }
+    } // namespace
+
+    std::string generatePermutationHeader(
+        const std::span<const ShaderEntry> entries, const std::string& manifestName)
+    {
+        HeaderWriter writer;
+        writer.line(0, "{}", std::string(80, '/'));
+        writer.line(0, "// Generated by shaderbuild from {}. Do not edit.", manifestName);
+        writer.line(0, "{}", std::string(80, '/'));
+        writer.blank();
+        writer.line(0, "#pragma once");
+        writer.blank();
+        writer.line(0, "#include <array>");
+        writer.line(0, "#include <cstdint>");
+        writer.line(0, "#include <string>");
+        writer.line(0, "#include <string_view>");
+        writer.blank();
+        writer.line(0, "namespace ShaderPermutations");
+        writer.line(0, "{{");
+        for (const auto& entry : entries)
+        {
+            if (&entry != entries.data())
+            {
+                writer.blank();
+            }
+            writer.line(1, "namespace {}", entry.name);
+            writer.line(1, "{{");
+            writeConstants(writer, entry);
+            if (!entry.permutations.empty())
+            {
+                if (!entry.defines.empty())
+                {
+                    writer.blank();
+                }
+                writePermutations(writer, entry);
+            }
+            writer.line(1, "}} // namespace {}", entry.name);
+        }
+        writer.line(0, "}} // namespace ShaderPermutations");
+        return writer.take();
+    }
+} // namespace ShaderBuild
@@ -0,0 +1,30 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <span>
+#include <string>
+
+#include "ShaderManifest.hpp"
+
+namespace ShaderBuild
+{
+    /// @brief Generates the C++ header sharing the manifest with the host.
+    ///
+    /// Every entry becomes a namespace in ShaderPermutations holding its fixed defines
+    /// as constants. Entries with permutations also get a Features struct with one
+    /// member per permutation define, a constexpr permutationKey() mapping feature
+    /// values to the variant's index, and the PERMUTATION_SUFFIX of every variant, so
+    /// the host names the function of the variant it needs:
+    /// @code
+    /// constexpr auto key = ShaderPermutations::Textures::permutationKey({ .ALPHA_BLEND = 1 });
+    /// const auto name = ShaderPermutations::Textures::functionName("texture_fragment", key);
+    /// @endcode
+    /// @param [in] entries Parsed manifest entries.
+    /// @param [in] manifestName Manifest file name, mentioned in the header comment.
+    [[nodiscard]] std::string generatePermutationHeader(
+        std::span<const ShaderEntry> entries, const std::string& manifestName);
+} // namespace ShaderBuild
@@ -0,0 +1,531 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderLayout.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <format>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+
+#include "DependencyScanner.hpp"
+
+namespace ShaderBuild
+{
+    namespace
+    {
+        struct TypeInfo
+        {
+            std::string name;
+            size_t      size = 0;
+            size_t      alignment = 1;
+        };
+
+        struct ScalarType
+        {
+            std::string_view name;
+            size_t           size;
+        };
+
+        constexpr std::array g_scalarTypes = {
+            ScalarType { "bool", 1 },
+            ScalarType { "char", 1 },
+            ScalarType { "uchar", 1 },
+            ScalarType { "int8_t", 1 },
+            ScalarType { "uint8_t", 1 },
+            ScalarType { "short", 2 },
+            ScalarType { "ushort", 2 },
+            ScalarType { "half", 2 },
+            ScalarType { "bfloat", 2 },
+            ScalarType { "int16_t", 2 },
+            ScalarType { "uint16_t", 2 },
+            ScalarType { "int", 4 },
+            ScalarType { "uint", 4 },
+            ScalarType { "float", 4 },
+            ScalarType { "int32_t", 4 },
+            ScalarType { "uint32_t", 4 },
+            ScalarType { "long", 8 },
+            ScalarType { "ulong", 8 },
+            ScalarType { "int64_t", 8 },
+            ScalarType { "uint64_t", 8 },
+            ScalarType { "size_t", 8 },
+        };
+
+        /// Argument buffer members of these types are encoded as MTL::ResourceID.
+        constexpr std::array<std::string_view, 7> g_resourcePrefixes = {
+            "texture",
+            "depth",
+            "sampler",
+            "acceleration_structure",
+            "indirect_command_buffer",
+            "visible_function_table",
+            "intersection_function_table",
+        };
+
+        constexpr std::array<std::string_view, 8> g_qualifiers = {
+            "const",
+            "volatile",
+            "device",
+            "constant",
+            "thread",
+            "threadgroup",
+            "threadgroup_imageblock",
+            "ray_data",
+        };
+
+        constexpr size_t g_resourceIdSize = 8;
+        constexpr size_t g_pointerSize = 8;
+
+        size_t alignUp(const size_t value, const size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        bool isIdentifier(const std::string_view token)
+        {
+            return !token.empty()
+                && (std::isalpha(static_cast<unsigned char>(token.front())) != 0
+                    || token.front() == '_');
+        }
+
+        std::optional<size_t> scalarSize(const std::string_view name)
+        {
+            const auto it = std::ranges::find(g_scalarTypes, name, &ScalarType::name);
+            return it == g_scalarTypes.end() ? std::nullopt : std::optional(it->size);
+        }
+
+        /// Scalars, vectors (float3 is padded to 16 bytes), packed vectors and matrices,
+        /// whose columns are vectors.
+        std::optional<TypeInfo> builtinType(const std::string_view name)
+        {
+            if (const auto size = scalarSize(name))
+            {
+                return TypeInfo { std::string(name), *size, *size };
+            }
+
+            const bool       packed = name.starts_with("packed_");
+            std::string_view text = packed ? name.substr(7) : name;
+            const size_t     digits = text.find_first_of("1234");
+            if (digits == std::string_view::npos)
+            {
+                return std::nullopt;
+            }
+            const auto scalar = scalarSize(text.substr(0, digits));
+            text.remove_prefix(digits);
+
+            const auto vector = [&](const size_t count) -> TypeInfo {
+                if (packed)
+                {
+                    return { std::string(name), count * *scalar, *scalar };
+                }
+                const size_t size = (count == 3 ? 4 : count) * *scalar;
+                return { std::string(name), size, size };
+            };
+
+            if (scalar && text.size() == 1 && text[0] >= '2' && text[0] <= '4')
+            {
+                return vector(static_cast<size_t>(text[0] - '0'));
+            }
+            if (scalar && !packed && text.size() == 3 && text[1] == 'x' && text[0] >= '2'
+                && text[0] <= '4' && text[2] >= '2' && text[2] <= '4')
+            {
+                const TypeInfo column = vector(static_cast<size_t>(text[2] - '0'));
+                const size_t   columns = static_cast<size_t>(text[0] - '0');
+                return TypeInfo { std::string(name), columns * column.size, column.alignment };
+            }
+            return std::nullopt;
+        }
+
+        bool isResource(const std::string_view name)
+        {
+            return std::ranges::any_of(g_resourcePrefixes,
+                [&](const std::string_view prefix) { return name.starts_with(prefix); });
+        }
+
+        /// Splits comment free source into identifiers, numbers and punctuation,
+        /// dropping preprocessor lines, string literals and [[attributes]].
+        std::vector<std::string> tokenize(const std::string_view source)
+        {
+            const std::string        text = stripComments(source);
+            std::vector<std::string> tokens;
+            bool                     lineStart = true;
+            for (size_t i = 0; i < text.size(); i++)
+            {
+                const char c = text[i];
+                if (c == '\n')
+                {
+                    lineStart = true;
+                }
+                else if (std::isspace(static_cast<unsigned char>(c)) != 0)
+                {
+                    continue;
+                }
+                else if (c == '#' && lineStart)
+                {
+                    // Skip the directive including its continuation lines
+                    while (i < text.size() && (text[i] != '\n' || text[i - 1] == '\\'))
+                    {
+                        i++;
+                    }
+                }
+                else if (c == '[' && i + 1 < text.size() && text[i + 1] == '[')
+                {
+                    const size_t end = text.find("]]", i + 2);
+                    i = end == std::string::npos ? text.size() : end + 1;
+                    lineStart = false;
+                }
+                else if (c == '"')
+                {
+                    for (i++; i < text.size() && text[i] != '"'; i++)
+                    {
+                        i += text[i] == '\\' ? 1 : 0;
+                    }
+                    lineStart = false;
+                }
+                else if (std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_')
+                {
+                    const size_t start = i;
+                    while (i + 1 < text.size()
+                        && (std::isalnum(static_cast<unsigned char>(text[i + 1])) != 0
+                            || text[i + 1] == '_' || text[i + 1] == '.'))
+                    {
+                        i++;
+                    }
+                    tokens.emplace_back(text.substr(start, i - start + 1));
+                    lineStart = false;
+                }
+                else
+                {
+                    tokens.emplace_back(1, c);
+                    lineStart = false;
+                }
+            }
+            return tokens;
+        }
+
+        /// Index of the token closing the bracket at open, or tokens.size().
+        size_t matchingClose(const std::span<const std::string> tokens, const size_t open)
+        {
+            const std::string& opening = tokens[open];
+            const std::string  closing = opening == "{" ? "}" : opening == "<" ? ">" : "]";
+            int                depth = 0;
+            for (size_t i = open; i < tokens.size(); i++)
+            {
+                depth += tokens[i] == opening ? 1 : tokens[i] == closing ? -1 : 0;
+                if (depth == 0)
+                {
+                    return i;
+                }
+            }
+            return tokens.size();
+        }
+
+        /// Parses the type and declarators of one member declaration.
+        class DeclarationParser
+        {
+        public:
+            DeclarationParser(const std::span<const std::string> tokens,
+                const Constants& constants, const std::vector<StructLayout>& structs)
+                : m_tokens(tokens)
+                , m_constants(constants)
+                , m_structs(structs)
+            {
+            }
+
+            std::vector<MemberLayout> parse()
+            {
+                const TypeInfo            type = parseType();
+                std::vector<MemberLayout> members;
+                while (true)
+                {
+                    members.push_back(parseDeclarator(type));
+                    if (atEnd())
+                    {
+                        return members;
+                    }
+                    expect(",");
+                }
+            }
+
+        private:
+            [[nodiscard]] bool atEnd() const
+            {
+                return m_position >= m_tokens.size();
+            }
+
+            [[nodiscard]] const std::string& peek() const
+            {
+                static const std::string empty;
+                return atEnd() ? empty : m_tokens[m_position];
+            }
+
+            const std::string& take()
+            {
+                if (atEnd())
+                {
+                    throw std::runtime_error("unexpected end of declaration");
+                }
+                return m_tokens[m_position++];
+            }
+
+            void expect(const std::string_view token)
+            {
+                if (take() != token)
+                {
+                    throw std::runtime_error(std::format("expected '{}'", token));
+                }
+            }
+
+            void skipQualifiers()
+            {
+                while (!atEnd() && std::ranges::find(g_qualifiers, peek()) != g_qualifiers.end())
+                {
+                    m_position++;
+                }
+            }
+
+            TypeInfo parseType()
+            {
+                skipQualifiers();
+                std::string name = take();
+                if ((name == "metal" || name == "std") && peek() == ":")
+                {
+                    expect(":");
+                    expect(":");
+                    name = take();
+                }
+                if (name == "struct")
+                {
+                    name = take();
+                }
+
+                TypeInfo type;
+                if (peek() == "<" && name == "array")
+                {
+                    expect("<");
+                    const TypeInfo element = parseType();
+                    expect(",");
+                    const size_t count = parseCount();
+                    expect(">");
+                    type = { std::format("array<{}, {}>", element.name, count),
+                        element.size * count, element.alignment };
+                }
+                else if (peek() == "<")
+                {
+                    const size_t close = matchingClose(m_tokens, m_position);
+                    for (; m_position <= close && !atEnd(); m_position++)
+                    {
+                        name += m_tokens[m_position] == "," ? ", " : m_tokens[m_position];
+                    }
+                    type = resolve(name);
+                }
+                else
+                {
+                    type = resolve(name);
+                }
+
+                skipQualifiers();
+                return type;
+            }
+
+            TypeInfo resolve(const std::string& name) const
+            {
+                if (auto builtin = builtinType(name))
+                {
+                    return *builtin;
+                }
+                if (isResource(name))
+                {
+                    return { name, g_resourceIdSize, g_resourceIdSize };
+                }
+                const auto it = std::ranges::find(m_structs, name, &StructLayout::name);
+                if (it != m_structs.end())
+                {
+                    if (!it->error.empty())
+                    {
+                        throw std::runtime_error(std::format("member of unresolved type {}", name));
+                    }
+                    return { name, it->size, it->alignment };
+                }
+                throw std::runtime_error(std::format("unknown type {}", name));
+            }
+
+            size_t parseCount()
+            {
+                const std::string& token = take();
+                int64_t            count = 0;
+                if (const auto it = m_constants.find(token); it != m_constants.end())
+                {
+                    count = it->second;
+                }
+                else
+                {
+                    const char* last = token.data() + token.size();
+                    const auto [end, error] = std::from_chars(token.data(), last, count);
+                    if (error != std::errc() || (end != last && std::string_view(end) != "u"
+                            && std::string_view(end) != "U"))
+                    {
+                        throw std::runtime_error(std::format("unknown array size {}", token));
+                    }
+                }
+                if (count <= 0)
+                {
+                    throw std::runtime_error(std::format("invalid array size {}", token));
+                }
+                return static_cast<size_t>(count);
+            }
+
+            MemberLayout parseDeclarator(TypeInfo type)
+            {
+                while (peek() == "*" || peek() == "&")
+                {
+                    m_position++;
+                    skipQualifiers();
+                    type = { type.name + "*", g_pointerSize, g_pointerSize };
+                }
+
+                const std::string name = take();
+                if (!isIdentifier(name))
+                {
+                    throw std::runtime_error(std::format("unexpected '{}'", name));
+                }
+
+                std::vector<size_t> extents;
+                while (peek() == "[")
+                {
+                    expect("[");
+                    extents.push_back(parseCount());
+                    expect("]");
+                }
+                // int a[2][3] is an array of 2 arrays of 3
+                for (const size_t extent : std::views::reverse(extents))
+                {
+                    type = { std::format("{}[{}]", type.name, extent), type.size * extent,
+                        type.alignment };
+                }
+                return { name, type.name, 0, type.size, type.alignment };
+            }
+
+            std::span<const std::string>     m_tokens;
+            const Constants&                 m_constants;
+            const std::vector<StructLayout>& m_structs;
+            size_t                           m_position = 0;
+        };
+
+        bool isMemberDeclaration(const std::span<const std::string> tokens)
+        {
+            constexpr std::array<std::string_view, 7> nonMembers
+                = { "static", "constexpr", "using", "typedef", "friend", "template", "enum" };
+            return !tokens.empty() && std::ranges::find(nonMembers, tokens[0]) == nonMembers.end()
+                && std::ranges::find(tokens, "(") == tokens.end();
+        }
+
+        StructLayout layoutStruct(std::string name, const std::span<const std::string> body,
+            const Constants& constants, const std::vector<StructLayout>& structs)
+        {
+            StructLayout layout;
+            layout.name = std::move(name);
+
+            size_t start = 0;
+            while (start < body.size() && layout.error.empty())
+            {
+                // Find the end of the declaration, skipping brackets
+                size_t end = start;
+                while (end < body.size() && body[end] != ";")
+                {
+                    end = body[end] == "{" || body[end] == "[" ? matchingClose(body, end) : end;
+                    end++;
+                }
+
+                const auto declaration = body.subspan(start, std::min(end, body.size()) - start);
+                start = end + 1;
+                if (!isMemberDeclaration(declaration))
+                {
+                    continue;
+                }
+                if (std::ranges::find(declaration, "{") != declaration.end())
+                {
+                    layout.error = "nested type declarations are not supported";
+                    break;
+                }
+
+                try
+                {
+                    for (auto& member : DeclarationParser(declaration, constants, structs).parse())
+                    {
+                        member.offset = alignUp(layout.size, member.alignment);
+                        layout.size = member.offset + member.size;
+                        layout.alignment = std::max(layout.alignment, member.alignment);
+                        layout.members.push_back(std::move(member));
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    layout.error = e.what();
+                }
+            }
+
+            layout.size = alignUp(layout.size, layout.alignment);
+            if (!layout.error.empty())
+            {
+                layout.members.clear();
+                layout.size = 0;
+            }
+            return layout;
+        }
+    } // namespace
+
+    const MemberLayout* StructLayout::find(const std::string_view member) const
+    {
+        const auto it = std::ranges::find(members, member, &MemberLayout::name);
+        return it == members.end() ? nullptr : &*it;
+    }
+
+    std::vector<StructLayout> parseStructLayouts(const std::string_view source,
+        const Constants& constants, const std::span<const StructLayout> known)
+    {
+        const std::vector<std::string> tokens = tokenize(source);
+        std::vector<StructLayout>      structs(known.begin(), known.end());
+
+        for (size_t i = 0; i < tokens.size(); i++)
+        {
+            if (tokens[i] != "struct")
+            {
+                continue;
+            }
+
+            const bool  isTypedef = i > 0 && tokens[i - 1] == "typedef";
+            size_t      open = i + 1;
+            std::string name;
+            if (open < tokens.size() && isIdentifier(tokens[open]))
+            {
+                name = tokens[open++];
+            }
+            if (open >= tokens.size() || tokens[open] != "{")
+            {
+                continue; // Forward declaration or elaborated type specifier
+            }
+
+            const size_t close = matchingClose(tokens, open);
+            if (isTypedef && close + 1 < tokens.size() && isIdentifier(tokens[close + 1]))
+            {
+                name = tokens[close + 1];
+            }
+            if (!name.empty())
+            {
+                const auto body = std::span(tokens).subspan(open + 1, close - open - 1);
+                structs.push_back(layoutStruct(std::move(name), body, constants, structs));
+            }
+            i = close;
+        }
+
+        structs.erase(structs.begin(), structs.begin() + static_cast<ptrdiff_t>(known.size()));
+        return structs;
+    }
+} // namespace ShaderBuild
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ShaderBuild
+{
+    /// @brief Integer values of identifiers, such as defines used as array sizes.
+    using Constants = std::map<std::string, int64_t, std::less<>>;
+
+    struct MemberLayout
+    {
+        std::string name;
+        std::string type;
+        size_t      offset = 0;
+        size_t      size = 0;
+        size_t      alignment = 0;
+    };
+
+    /// @brief Memory layout of a Metal struct as seen by the GPU.
+    struct StructLayout
+    {
+        std::string               name;
+        size_t                    size = 0;
+        size_t                    alignment = 1;
+        std::vector<MemberLayout> members;
+        std::string               error; ///< Why the layout is unknown; empty if resolved.
+
+        [[nodiscard]] const MemberLayout* find(std::string_view member) const;
+    };
+
+    /// @brief Computes the layouts of the structs declared in Metal source.
+    ///
+    /// Understands both "struct Name { ... };" and "typedef struct { ... } Name;" with
+    /// members of scalar, vector, packed vector and matrix types, array<T, N> and C
+    /// arrays, pointers and references (8 bytes), resources such as texture2d<T> and
+    /// sampler as they appear in argument buffers (an 8 byte resource ID), and structs
+    /// declared earlier. Attributes are ignored. Layouts follow the Metal Shading
+    /// Language rules: members are aligned to their type's alignment, and the struct
+    /// size is rounded up to its largest member alignment.
+    ///
+    /// Structs whose layout cannot be determined, for example because of an unknown
+    /// member type, are returned with error set rather than failing the whole source.
+    /// @param [in] source Metal source text; preprocessor lines are skipped.
+    /// @param [in] constants Values of identifiers used as array sizes, usually defines.
+    /// @param [in] known Layouts of structs declared in included files.
+    [[nodiscard]] std::vector<StructLayout> parseStructLayouts(std::string_view source,
+        const Constants& constants, std::span<const StructLayout> known = {});
+} // namespace ShaderBuild
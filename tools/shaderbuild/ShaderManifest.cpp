@@ -0,0 +1,315 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderManifest.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <format>
+#include <ranges>
+#include <set>
+#include <stdexcept>
+
+namespace ShaderBuild
+{
+    namespace
+    {
+        bool isIdentifier(const std::string_view name)
+        {
+            return !name.empty() && std::isdigit(static_cast<unsigned char>(name.front())) == 0
+                && std::ranges::all_of(name, [](const char c) {
+                       return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_';
+                   });
+        }
+
+        /// Maps characters that are not valid in identifiers or file names to '_'.
+        std::string sanitize(const std::string_view text)
+        {
+            std::string result(text);
+            std::ranges::replace_if(
+                result,
+                [](const char c) { return std::isalnum(static_cast<unsigned char>(c)) == 0; },
+                '_');
+            return result;
+        }
+
+        std::string valueToString(const Json::Value& value, const std::string_view context)
+        {
+            if (value.isString())
+            {
+                return value.asString();
+            }
+            if (value.isNumber())
+            {
+                return std::format("{}", value.asNumber());
+            }
+            if (value.isBool())
+            {
+                return value.asBool() ? "1" : "0";
+            }
+            throw std::runtime_error(
+                std::format("{}: define values must be strings, numbers or booleans", context));
+        }
+
+        std::vector<Define> parseDefines(const Json::Value& defines, const std::string& context)
+        {
+            std::vector<Define> result;
+            for (const auto& [name, value] : defines.asObject())
+            {
+                if (!isIdentifier(name))
+                {
+                    throw std::runtime_error(
+                        std::format("{}: '{}' is not a valid define name", context, name));
+                }
+                result.emplace_back(name, valueToString(value, context));
+            }
+            return result;
+        }
+
+        PermutationAxis parseAxis(
+            const std::string& name, const Json::Value& values, const std::string& context)
+        {
+            if (!isIdentifier(name))
+            {
+                throw std::runtime_error(
+                    std::format("{}: '{}' is not a valid define name", context, name));
+            }
+
+            PermutationAxis axis { name, {} };
+            for (const auto& value : values.asArray())
+            {
+                if (value.isBool())
+                {
+                    axis.values.push_back(value.asBool() ? 1 : 0);
+                }
+                else if (value.isNumber() && std::trunc(value.asNumber()) == value.asNumber())
+                {
+                    axis.values.push_back(static_cast<int64_t>(value.asNumber()));
+                }
+                else
+                {
+                    throw std::runtime_error(std::format(
+                        "{}: values of permutation '{}' must be integers or booleans", context,
+                        name));
+                }
+                if (std::ranges::count(axis.values, axis.values.back()) > 1)
+                {
+                    throw std::runtime_error(std::format(
+                        "{}: permutation '{}' lists a value twice", context, name));
+                }
+            }
+            if (axis.values.empty())
+            {
+                throw std::runtime_error(
+                    std::format("{}: permutation '{}' has no values", context, name));
+            }
+            return axis;
+        }
+
+        LayoutBinding parseLayoutBinding(
+            const std::string& name, const Json::Value& binding, const std::string& context)
+        {
+            LayoutBinding layout { name, name, {} };
+            if (const auto* host = binding.find("host"))
+            {
+                layout.hostStruct = host->asString();
+            }
+            if (const auto* members = binding.find("members"))
+            {
+                for (const auto& [shaderMember, hostMember] : members->asObject())
+                {
+                    layout.memberNames.emplace_back(shaderMember, hostMember.asString());
+                }
+            }
+
+            const auto identifiers = layout.memberNames
+                | std::views::transform([](const Define& names) { return names.second; });
+            if (!isIdentifier(layout.shaderStruct) || !isIdentifier(layout.hostStruct)
+                || !std::ranges::all_of(identifiers, isIdentifier))
+            {
+                throw std::runtime_error(
+                    std::format("{}: layout of '{}' names an invalid identifier", context, name));
+            }
+            return layout;
+        }
+    } // namespace
+
+    std::string LayoutBinding::hostMember(const std::string& shaderMember) const
+    {
+        const auto it = std::ranges::find(memberNames, shaderMember, &Define::first);
+        return it == memberNames.end() ? shaderMember : it->second;
+    }
+
+    size_t ShaderEntry::permutationCount() const
+    {
+        size_t count = 1;
+        for (const auto& axis : permutations)
+        {
+            count *= axis.values.size();
+        }
+        return count;
+    }
+
+    std::vector<int64_t> ShaderEntry::permutationValues(size_t permutation) const
+    {
+        // Mixed radix decomposition, last axis varying fastest
+        std::vector<int64_t> values(permutations.size());
+        for (size_t axis = permutations.size(); axis > 0; axis--)
+        {
+            const auto& axisValues = permutations[axis - 1].values;
+            values[axis - 1] = axisValues[permutation % axisValues.size()];
+            permutation /= axisValues.size();
+        }
+        return values;
+    }
+
+    std::string ShaderEntry::permutationSuffix(const size_t permutation) const
+    {
+        const auto  values = permutationValues(permutation);
+        std::string suffix;
+        for (size_t axis = 0; axis < permutations.size(); axis++)
+        {
+            suffix += std::format("_{}_{}", permutations[axis].name, values[axis]);
+        }
+        return sanitize(suffix);
+    }
+
+    CompileUnit defaultUnit(const std::filesystem::path& source)
+    {
+        const std::string directory = source.parent_path().filename().string();
+        const std::string stem = source.stem().string();
+        return { source, sanitize(directory.empty() ? stem : directory + "_" + stem), {} };
+    }
+
+    std::vector<ShaderEntry> parseManifest(
+        const Json::Value& manifest, const std::filesystem::path& baseDirectory)
+    {
+        std::vector<ShaderEntry> entries;
+        std::set<std::string>    names;
+        for (const auto& value : manifest["shaders"].asArray())
+        {
+            const std::string context = value["source"].asString();
+
+            ShaderEntry entry;
+            entry.source = baseDirectory / context;
+            if (!std::filesystem::is_regular_file(entry.source))
+            {
+                throw std::runtime_error(std::format("{}: source file not found", context));
+            }
+
+            entry.name = defaultUnit(entry.source).name;
+            if (const auto* name = value.find("name"))
+            {
+                entry.name = name->asString();
+                if (!isIdentifier(entry.name))
+                {
+                    throw std::runtime_error(
+                        std::format("{}: '{}' is not a valid name", context, entry.name));
+                }
+            }
+            if (!names.insert(entry.name).second)
+            {
+                throw std::runtime_error(
+                    std::format("{}: name '{}' is used twice", context, entry.name));
+            }
+
+            if (const auto* defines = value.find("defines"))
+            {
+                entry.defines = parseDefines(*defines, context);
+            }
+
+            if (const auto* permutations = value.find("permutations"))
+            {
+                for (const auto& [name, values] : permutations->asObject())
+                {
+                    entry.permutations.push_back(parseAxis(name, values, context));
+                    if (std::ranges::find(entry.defines, name, &Define::first)
+                        != entry.defines.end())
+                    {
+                        throw std::runtime_error(std::format(
+                            "{}: '{}' is both a define and a permutation", context, name));
+                    }
+                }
+                // Name order keeps variant numbering independent of the JSON member order
+                std::ranges::sort(entry.permutations, {}, &PermutationAxis::name);
+            }
+
+            if (const auto* layouts = value.find("layouts"))
+            {
+                for (const auto& [name, binding] : layouts->asObject())
+                {
+                    entry.layouts.push_back(parseLayoutBinding(name, binding, context));
+                }
+            }
+            entries.push_back(std::move(entry));
+        }
+        return entries;
+    }
+
+    std::vector<CompileUnit> expandManifest(const std::span<const ShaderEntry> entries)
+    {
+        std::vector<CompileUnit> units;
+        for (const auto& entry : entries)
+        {
+            const CompileUnit base { entry.source, defaultUnit(entry.source).name,
+                entry.defines };
+            if (entry.permutations.empty())
+            {
+                units.push_back(base);
+                continue;
+            }
+
+            for (size_t permutation = 0; permutation < entry.permutationCount(); permutation++)
+            {
+                const std::string suffix = entry.permutationSuffix(permutation);
+                const auto        values = entry.permutationValues(permutation);
+
+                CompileUnit unit = base;
+                unit.name += suffix;
+                for (size_t axis = 0; axis < values.size(); axis++)
+                {
+                    unit.defines.emplace_back(
+                        entry.permutations[axis].name, std::to_string(values[axis]));
+                }
+                unit.defines.emplace_back("PERMUTATION_SUFFIX", suffix);
+                units.push_back(std::move(unit));
+            }
+        }
+        return units;
+    }
+
+    std::vector<CompileUnit> collectUnits(
+        const std::span<const std::filesystem::path> sources,
+        std::vector<CompileUnit>                     manifestUnits)
+    {
+        std::set<std::filesystem::path> manifestSources;
+        for (const auto& unit : manifestUnits)
+        {
+            manifestSources.insert(std::filesystem::weakly_canonical(unit.source));
+        }
+
+        std::vector<CompileUnit> units;
+        for (const auto& source : sources)
+        {
+            if (!manifestSources.contains(std::filesystem::weakly_canonical(source)))
+            {
+                units.push_back(defaultUnit(source));
+            }
+        }
+        std::ranges::move(manifestUnits, std::back_inserter(units));
+
+        std::set<std::string> names;
+        for (const auto& unit : units)
+        {
+            if (!names.insert(unit.name).second)
+            {
+                throw std::runtime_error(std::format(
+                    "Duplicate shader unit name '{}' ({})", unit.name, unit.source.string()));
+            }
+        }
+        return units;
+    }
+} // namespace ShaderBuild
@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Json.hpp"
+
+namespace ShaderBuild
+{
+    using Define = std::pair<std::string, std::string>;
+
+    /// @brief One compiler invocation: a source compiled with a set of defines.
+    struct CompileUnit
+    {
+        std::filesystem::path source;
+        std::string           name; ///< Unique among the units, usable as a file name.
+        std::vector<Define>   defines;
+    };
+
+    /// @brief A define with the values it is compiled with, one variant per value.
+    struct PermutationAxis
+    {
+        std::string          name;
+        std::vector<int64_t> values;
+    };
+
+    /// @brief A host struct mirroring a shader struct, whose layout must match.
+    struct LayoutBinding
+    {
+        std::string         shaderStruct;
+        std::string         hostStruct;
+        std::vector<Define> memberNames; ///< Host names of shader members named differently.
+
+        /// @brief Host name of a shader struct member.
+        [[nodiscard]] std::string hostMember(const std::string& shaderMember) const;
+    };
+
+    /// @brief A manifest entry: a source with its fixed defines, permutations and the
+    /// host structs mirroring its structs.
+    struct ShaderEntry
+    {
+        std::filesystem::path        source;
+        std::string                  name; ///< Namespace of the entry in generated headers.
+        std::vector<Define>          defines;
+        std::vector<PermutationAxis> permutations;
+        std::vector<LayoutBinding>   layouts;
+
+        /// @brief Number of variants, the product of the permutation value counts.
+        [[nodiscard]] size_t permutationCount() const;
+
+        /// @brief Values of the permutation defines of a variant, with variants numbered
+        /// in expansion order.
+        [[nodiscard]] std::vector<int64_t> permutationValues(size_t permutation) const;
+
+        /// @brief Name suffix of a variant (e.g. _ALPHA_BLEND_1_TEXTURE_COUNT_5); empty
+        /// without permutations.
+        [[nodiscard]] std::string permutationSuffix(size_t permutation) const;
+    };
+
+    /// @brief Unit for a source without defines, named "<directory>_<stem>".
+    [[nodiscard]] CompileUnit defaultUnit(const std::filesystem::path& source);
+
+    /// @brief Parses and validates a shader manifest.
+    ///
+    /// The manifest lists sources with optional fixed defines, permutations and
+    /// layout bindings:
+    /// @code
+    /// { "shaders": [ { "source": "textures/shader.metal",
+    ///                  "name": "Textures",
+    ///                  "defines": { "MAX_LIGHTS": 4 },
+    ///                  "permutations": { "ALPHA_BLEND": [ false, true ],
+    ///                                    "TEXTURE_COUNT": [ 1, 5 ] },
+    ///                  "layouts": { "VertexIn": { "host": "Vertex",
+    ///                                             "members": { "uv": "texCoord" } },
+    ///                               "InstanceData": {} } } ] }
+    /// @endcode
+    /// A layout binding names the host struct mirroring a shader struct, which
+    /// defaults to the same name, and renames members whose names differ.
+    /// Define values may be strings, numbers or booleans; permutation values must be
+    /// integers or booleans so the host can select variants by value. The name
+    /// defaults to the source's unit name.
+    /// @param [in] manifest Parsed manifest document.
+    /// @param [in] baseDirectory Directory relative source paths are resolved against.
+    /// @throws std::runtime_error if the manifest is malformed.
+    [[nodiscard]] std::vector<ShaderEntry> parseManifest(
+        const Json::Value& manifest, const std::filesystem::path& baseDirectory);
+
+    /// @brief Expands manifest entries into compile units.
+    ///
+    /// Every combination of permutation values becomes a unit. Permutations are
+    /// ordered by name, the first varying slowest. Permuted units also get
+    /// PERMUTATION_SUFFIX defined to their name suffix, for shaders to give each
+    /// variant's functions a unique name by token pasting.
+    [[nodiscard]] std::vector<CompileUnit> expandManifest(std::span<const ShaderEntry> entries);
+
+    /// @brief Creates the units for sources, replacing each source the manifest lists
+    /// by its expansion.
+    /// @throws std::runtime_error on duplicate unit names.
+    [[nodiscard]] std::vector<CompileUnit> collectUnits(
+        std::span<const std::filesystem::path> sources, std::vector<CompileUnit> manifestUnits);
+} // namespace ShaderBuild
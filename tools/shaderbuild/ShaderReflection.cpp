@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderReflection.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <stdexcept>
+
+#include "BuildCache.hpp"
+
+namespace ShaderBuild
+{
+    namespace
+    {
+        constexpr int64_t g_layoutManifestVersion = 1;
+
+        Json::Value toJson(const size_t value)
+        {
+            return static_cast<int64_t>(value);
+        }
+
+        Constants integerDefines(const ShaderEntry& entry)
+        {
+            Constants constants;
+            for (const auto& [name, value] : entry.defines)
+            {
+                int64_t     integer = 0;
+                const char* last = value.data() + value.size();
+                const auto [end, error] = std::from_chars(value.data(), last, integer);
+                if (error == std::errc() && end == last)
+                {
+                    constants.emplace(name, integer);
+                }
+            }
+            return constants;
+        }
+
+        const StructLayout& findStruct(const EntryLayouts& layouts, const std::string& name)
+        {
+            const auto& structs = layouts.structs;
+            const auto  it = std::ranges::find(structs, name, &StructLayout::name);
+            if (it == structs.end())
+            {
+                throw std::runtime_error(std::format("{}: no struct {} to check the layout of",
+                    layouts.entry->name, name));
+            }
+            if (!it->error.empty())
+            {
+                throw std::runtime_error(std::format("{}: layout of struct {} is unknown: {}",
+                    layouts.entry->name, name, it->error));
+            }
+            return *it;
+        }
+    } // namespace
+
+    EntryLayouts reflectLayouts(const ShaderEntry& entry, DependencyScanner& scanner)
+    {
+        const Constants constants = integerDefines(entry);
+        EntryLayouts    layouts { &entry, {} };
+        for (const auto& file : scanner.dependencies(entry.source))
+        {
+            std::ranges::move(parseStructLayouts(readFile(file), constants, layouts.structs),
+                std::back_inserter(layouts.structs));
+        }
+        std::ranges::move(parseStructLayouts(readFile(entry.source), constants, layouts.structs),
+            std::back_inserter(layouts.structs));
+        return layouts;
+    }
+
+    Json::Value layoutManifest(
+        const std::span<const EntryLayouts> layouts, const std::filesystem::path& baseDirectory)
+    {
+        Json::Value shaders = Json::Value::Array {};
+        for (const auto& entryLayouts : layouts)
+        {
+            Json::Value structs = Json::Value::Array {};
+            for (const auto& layout : entryLayouts.structs)
+            {
+                if (!layout.error.empty())
+                {
+                    continue;
+                }
+
+                Json::Value members = Json::Value::Array {};
+                for (const auto& member : layout.members)
+                {
+                    Json::Value value = Json::Value::Object {};
+                    value.set("name", member.name);
+                    value.set("type", member.type);
+                    value.set("offset", toJson(member.offset));
+                    value.set("size", toJson(member.size));
+                    value.set("alignment", toJson(member.alignment));
+                    members.push(std::move(value));
+                }
+
+                Json::Value value = Json::Value::Object {};
+                value.set("name", layout.name);
+                value.set("size", toJson(layout.size));
+                value.set("alignment", toJson(layout.alignment));
+                value.set("members", std::move(members));
+                structs.push(std::move(value));
+            }
+
+            const auto& entry = *entryLayouts.entry;
+            Json::Value value = Json::Value::Object {};
+            value.set("name", entry.name);
+            value.set("source", entry.source.lexically_relative(baseDirectory).generic_string());
+            value.set("structs", std::move(structs));
+            shaders.push(std::move(value));
+        }
+
+        Json::Value document = Json::Value::Object {};
+        document.set("version", g_layoutManifestVersion);
+        document.set("shaders", std::move(shaders));
+        return document;
+    }
+
+    std::string generateLayoutHeader(
+        const std::span<const EntryLayouts> layouts, const std::string& manifestName)
+    {
+        std::string header;
+        const auto  line = [&header](const std::string_view text) {
+            header.append(text).push_back('\n');
+        };
+
+        line(std::string(80, '/'));
+        line(std::format("// Generated by shaderbuild from {}. Do not edit.", manifestName));
+        line(std::string(80, '/'));
+        line("");
+        line("#pragma once");
+        line("");
+        line("#include <cstddef>");
+        line("");
+        line("// Expands to static_asserts checking that the host structs of a manifest entry");
+        line("// match the layout of the shader structs they mirror.");
+        line("#define SHADER_LAYOUT_CHECKS(entry) SHADER_LAYOUT_CHECKS_##entry()");
+
+        for (const auto& entryLayouts : layouts)
+        {
+            const auto&              entry = *entryLayouts.entry;
+            const std::string        source = entry.source.parent_path().filename().string()
+                + "/" + entry.source.filename().string();
+            std::vector<std::string> checks;
+            for (const auto& binding : entry.layouts)
+            {
+                const auto&        layout = findStruct(entryLayouts, binding.shaderStruct);
+                const std::string& host = binding.hostStruct;
+                const std::string  shader = std::format("{}::{}", entry.name, layout.name);
+
+                checks.push_back(std::format(
+                    "static_assert(sizeof({}) == {}, \"{} must be {} bytes to match {}\")", host,
+                    layout.size, host, layout.size, shader));
+                for (const auto& member : layout.members)
+                {
+                    const std::string name = binding.hostMember(member.name);
+                    const std::string qualified = std::format("{}::{}", host, name);
+                    const std::string target = std::format("{}::{}", shader, member.name);
+                    checks.push_back(std::format("static_assert(offsetof({}, {}) == {}, "
+                                                 "\"{} must be at offset {} to match {}\")",
+                        host, name, member.offset, qualified, member.offset, target));
+                    checks.push_back(std::format(
+                        "static_assert(sizeof({}) == {}, \"{} must be {} bytes to match {}\")",
+                        qualified, member.size, qualified, member.size, target));
+                }
+            }
+            if (checks.empty())
+            {
+                checks.emplace_back("static_assert(true)");
+            }
+
+            line("");
+            line(std::format("// {} ({})", entry.name, source));
+            line(std::format("#define SHADER_LAYOUT_CHECKS_{}() \\", entry.name));
+            for (size_t i = 0; i < checks.size(); i++)
+            {
+                line(std::format("    {}{}", checks[i], i + 1 < checks.size() ? "; \\" : ""));
+            }
+        }
+        return header;
+    }
+} // namespace ShaderBuild
@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include "DependencyScanner.hpp"
+#include "Json.hpp"
+#include "ShaderLayout.hpp"
+#include "ShaderManifest.hpp"
+
+namespace ShaderBuild
+{
+    /// @brief Struct layouts of one manifest entry.
+    struct EntryLayouts
+    {
+        const ShaderEntry*        entry = nullptr;
+        std::vector<StructLayout> structs; ///< Includes first, then the source.
+    };
+
+    /// @brief Computes the layouts of the structs an entry's source and its includes
+    /// declare, with the entry's integer defines available as array sizes.
+    [[nodiscard]] EntryLayouts reflectLayouts(const ShaderEntry& entry, DependencyScanner& scanner);
+
+    /// @brief Builds the layout manifest document listing every resolved struct:
+    /// @code
+    /// { "version": 1, "shaders": [ { "name": "Textures", "source": "textures/shader.metal",
+    ///   "structs": [ { "name": "VertexIn", "size": 32, "alignment": 16, "members": [
+    ///     { "name": "uv", "type": "float2", "offset": 16, "size": 8, "alignment": 8 } ] } ] } ] }
+    /// @endcode
+    [[nodiscard]] Json::Value layoutManifest(
+        std::span<const EntryLayouts> layouts, const std::filesystem::path& baseDirectory);
+
+    /// @brief Generates the C++ header checking host structs against the layout
+    /// bindings of the manifest.
+    ///
+    /// For every entry the header defines SHADER_LAYOUT_CHECKS_<name>(), expanding to
+    /// static_asserts on the size of each bound host struct and the offset and size of
+    /// each of its members. Examples expand it after declaring their structs:
+    /// @code
+    /// SHADER_LAYOUT_CHECKS(Textures);
+    /// @endcode
+    /// @throws std::runtime_error if a binding names a shader struct or member that
+    /// does not exist or whose layout could not be determined.
+    [[nodiscard]] std::string generateLayoutHeader(
+        std::span<const EntryLayouts> layouts, const std::string& manifestName);
+} // namespace ShaderBuild
@@ -0,0 +1,307 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2024. Matt Guerrette
+// SPDX-License-Identifier: MIT
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <print>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BuildCache.hpp"
+#include "DependencyScanner.hpp"
+#include "IncrementalBuild.hpp"
+#include "Json.hpp"
+#include "PermutationHeader.hpp"
+#include "ShaderManifest.hpp"
+#include "ShaderReflection.hpp"
+
+namespace
+{
+    struct Options
+    {
+        ShaderBuild::BuildOptions          build;
+        std::filesystem::path              manifestPath;
+        std::filesystem::path              depfilePath;
+        std::filesystem::path              headerPath;
+        std::filesystem::path              layoutHeaderPath;
+        std::filesystem::path              layoutManifestPath;
+        std::vector<std::filesystem::path> includeDirectories;
+        std::vector<std::filesystem::path> sources;
+    };
+
+    void printUsage()
+    {
+        std::println("usage: shaderbuild [options] --output <library> --cache-dir <dir>");
+        std::println("                   --compile <command> --link <command> [sources...]");
+        std::println("       shaderbuild --manifest <file.json> [--header <file>]");
+        std::println("                   [--layout-header <file>] [--layout-manifest <file>]");
+        std::println("");
+        std::println("Incrementally compiles shader sources and links them into one library.");
+        std::println("Each compile unit is keyed by a hash of its source, defines, compile");
+        std::println("command and transitive includes; only units whose key changed are");
+        std::println("recompiled, and the library is only relinked when an object changed.");
+        std::println("");
+        std::println("options:");
+        std::println("  --output <file>          Library to produce");
+        std::println("  --cache-dir <dir>        Directory for intermediate objects and state");
+        std::println("  --compile <command>      Compile command with {{input}}, {{output}} and");
+        std::println("                           {{defines}} placeholders");
+        std::println("  --link <command>         Link command with {{inputs}} and {{output}}");
+        std::println("  --include-dir <dir>      Include search directory (repeatable)");
+        std::println("  --manifest <file.json>   Defines and permutations per source");
+        std::println("  --depfile <file>         Write a Makefile style dependency file");
+        std::println("  --header <file>          Generate the C++ header of manifest constants");
+        std::println("                           and permutation keys; without --compile and");
+        std::println("                           --link only headers are generated");
+        std::println("  --layout-header <file>   Generate static_asserts checking host structs");
+        std::println("                           against the manifest's layout bindings");
+        std::println("  --layout-manifest <file> Write the layouts of all shader structs as JSON");
+        std::println("  --jobs <n>               Parallel compiles (default: hardware threads)");
+        std::println("  --verbose                Print every command that is run");
+        std::println("");
+        std::println("Commands run through the shell; paths are substituted single quoted.");
+    }
+
+    Options parseOptions(int argc, char** argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view argument = argv[i];
+            const auto             next = [&]() -> const char* {
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(std::format("Missing value for {}", argument));
+                }
+                return argv[++i];
+            };
+
+            if (argument == "--help" || argument == "-h")
+            {
+                printUsage();
+                std::exit(EXIT_SUCCESS);
+            }
+            else if (argument == "--output")
+            {
+                options.build.outputPath = next();
+            }
+            else if (argument == "--cache-dir")
+            {
+                options.build.cacheDirectory = next();
+            }
+            else if (argument == "--compile")
+            {
+                options.build.compileCommand = next();
+            }
+            else if (argument == "--link")
+            {
+                options.build.linkCommand = next();
+            }
+            else if (argument == "--include-dir")
+            {
+                options.includeDirectories.emplace_back(next());
+            }
+            else if (argument == "--manifest")
+            {
+                options.manifestPath = next();
+            }
+            else if (argument == "--depfile")
+            {
+                options.depfilePath = next();
+            }
+            else if (argument == "--header")
+            {
+                options.headerPath = next();
+            }
+            else if (argument == "--layout-header")
+            {
+                options.layoutHeaderPath = next();
+            }
+            else if (argument == "--layout-manifest")
+            {
+                options.layoutManifestPath = next();
+            }
+            else if (argument == "--jobs")
+            {
+                const int jobs = std::atoi(next());
+                if (jobs <= 0)
+                {
+                    throw std::runtime_error("--jobs expects a positive number");
+                }
+                options.build.jobs = static_cast<unsigned>(jobs);
+            }
+            else if (argument == "--verbose")
+            {
+                options.build.verbose = true;
+            }
+            else if (argument.starts_with("--"))
+            {
+                throw std::runtime_error(std::format("Unknown option {}", argument));
+            }
+            else
+            {
+                options.sources.emplace_back(argument);
+            }
+        }
+
+        const bool generates = !options.headerPath.empty() || !options.layoutHeaderPath.empty()
+            || !options.layoutManifestPath.empty();
+        if (generates && options.manifestPath.empty())
+        {
+            throw std::runtime_error("Generating headers requires --manifest");
+        }
+        if (generates && options.build.compileCommand.empty()
+            && options.build.linkCommand.empty())
+        {
+            return options;
+        }
+        if (options.build.outputPath.empty() || options.build.cacheDirectory.empty())
+        {
+            throw std::runtime_error("--output and --cache-dir are required");
+        }
+        if (options.build.compileCommand.empty() || options.build.linkCommand.empty())
+        {
+            throw std::runtime_error("--compile and --link are required");
+        }
+        if (options.sources.empty() && options.manifestPath.empty())
+        {
+            throw std::runtime_error("No shader sources given");
+        }
+        return options;
+    }
+
+    /// Escapes a path for a Makefile style depfile.
+    std::string escapeDepfilePath(const std::string_view path)
+    {
+        std::string escaped;
+        for (const char c : path)
+        {
+            if (c == ' ' || c == '#')
+            {
+                escaped += '\\';
+            }
+            else if (c == '$')
+            {
+                escaped += '$';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    void writeGenerated(const std::filesystem::path& path, const std::string& contents)
+    {
+        if (path.has_parent_path())
+        {
+            std::filesystem::create_directories(path.parent_path());
+        }
+        ShaderBuild::writeFileIfChanged(path, contents);
+    }
+
+    void generateHeaders(const Options& options,
+        const std::vector<ShaderBuild::ShaderEntry>& entries,
+        ShaderBuild::DependencyScanner&              scanner)
+    {
+        const std::string manifestName = options.manifestPath.filename().string();
+        if (!options.headerPath.empty())
+        {
+            writeGenerated(
+                options.headerPath, ShaderBuild::generatePermutationHeader(entries, manifestName));
+        }
+        if (options.layoutHeaderPath.empty() && options.layoutManifestPath.empty())
+        {
+            return;
+        }
+
+        std::vector<ShaderBuild::EntryLayouts> layouts;
+        for (const auto& entry : entries)
+        {
+            layouts.push_back(ShaderBuild::reflectLayouts(entry, scanner));
+        }
+        if (!options.layoutHeaderPath.empty())
+        {
+            writeGenerated(options.layoutHeaderPath,
+                ShaderBuild::generateLayoutHeader(layouts, manifestName));
+        }
+        if (!options.layoutManifestPath.empty())
+        {
+            const auto manifest
+                = ShaderBuild::layoutManifest(layouts, options.manifestPath.parent_path());
+            writeGenerated(options.layoutManifestPath, Json::serialize(manifest) + "\n");
+        }
+    }
+
+    void writeDepfile(const Options& options, const std::vector<ShaderBuild::UnitBuild>& builds)
+    {
+        std::set<std::filesystem::path> inputs;
+        if (!options.manifestPath.empty())
+        {
+            inputs.insert(std::filesystem::absolute(options.manifestPath));
+        }
+        for (const auto& build : builds)
+        {
+            inputs.insert(std::filesystem::absolute(build.unit.source));
+            inputs.insert(build.dependencies.begin(), build.dependencies.end());
+        }
+
+        std::string contents = escapeDepfilePath(options.build.outputPath.string()) + ":";
+        for (const auto& input : inputs)
+        {
+            contents += " \\\n  " + escapeDepfilePath(input.string());
+        }
+
+        std::ofstream stream(options.depfilePath, std::ios::trunc);
+        stream << contents << '\n';
+        if (!stream)
+        {
+            throw std::runtime_error(
+                std::format("Failed to write {}", options.depfilePath.string()));
+        }
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const Options options = parseOptions(argc, argv);
+
+        std::vector<ShaderBuild::ShaderEntry> entries;
+        if (!options.manifestPath.empty())
+        {
+            entries = ShaderBuild::parseManifest(
+                Json::parseFile(options.manifestPath), options.manifestPath.parent_path());
+        }
+        ShaderBuild::DependencyScanner scanner(options.includeDirectories);
+        generateHeaders(options, entries, scanner);
+        if (options.build.compileCommand.empty())
+        {
+            return EXIT_SUCCESS;
+        }
+
+        auto units
+            = ShaderBuild::collectUnits(options.sources, ShaderBuild::expandManifest(entries));
+        const auto result = ShaderBuild::build(options.build, std::move(units), scanner);
+
+        if (!options.depfilePath.empty())
+        {
+            writeDepfile(options, result.units);
+        }
+
+        std::println("shaderbuild: {} units, {} compiled, {} cached, library {}",
+            result.units.size(), result.compiled, result.units.size() - result.compiled,
+            result.linked ? "linked" : "up to date");
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::println("Error: {}", e.what());
+        printUsage();
+        return 2;
+    }
+}